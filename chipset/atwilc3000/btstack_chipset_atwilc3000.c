@@ -109,6 +109,8 @@ static int             fw_flowcontrol;
 // flow control active
 static int             atwilc3000_flowcontrol;
 
+static uint32_t        upload_start_ms;
+
 static void atwilc3000_set_baudrate_command(uint32_t baudrate, uint8_t *hci_cmd_buffer){
     hci_cmd_buffer[0] = 0x53;
     hci_cmd_buffer[1] = 0xfc;
@@ -188,6 +190,8 @@ static void atwilc3000_write_memory(void){
     // done?
     if (fw_offset >= fw_size){
         log_info("Firmware upload complete!!!");
+        log_info("atwilc3000: firmware upload: %u bytes in %u ms", (unsigned int) fw_size,
+                 (unsigned int) (btstack_run_loop_get_time_ms() - upload_start_ms));
         atwilc3000_vendor_specific_reset();
         return;
     }
@@ -287,6 +291,7 @@ void btstack_chipset_atwilc3000_download_firmware(const btstack_uart_block_t * u
     }
 
     download_count = 0;
+    upload_start_ms = btstack_run_loop_get_time_ms();
     atwilc3000_start();
 }
 
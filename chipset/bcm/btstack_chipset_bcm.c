@@ -293,6 +293,7 @@ static btstack_chipset_t btstack_chipset_bcm = {
     chipset_next_command,
     chipset_set_baudrate_command,
     chipset_set_bd_addr_command,
+    4, // init_script_pipeline_depth
 };
 
 // MARK: public API
@@ -49,6 +49,7 @@
 #include "bluetooth.h"
 #include "btstack_debug.h"
 #include "btstack_chipset.h"
+#include "btstack_run_loop.h"
 
 static void bcm_send_hci_baudrate(void);
 static void bcm_send_next_init_script_command(void);
@@ -66,6 +67,8 @@ static const uint8_t hci_reset_cmd[] = { 0x03, 0x0c, 0x00 };
 // static const uint8_t hci_update_baud_rate[] = { 0x01, 0x18, 0xfc, 0x06, 0x00, 0x00,0x00, 0x00, 0x00, 0x00 };
 static void (*download_complete)(int result);
 static int baudrate;
+static uint32_t upload_start_ms;
+static uint16_t upload_num_commands;
 
 static void bcm_send_prepared_command(void){
     uart_driver->receive_block(&response_buffer[0], hci_command_complete_len);
@@ -112,10 +115,13 @@ static void bcm_send_next_init_script_command(void){
     int res = chipset->next_command(&command_buffer[1]);
     switch (res){
         case BTSTACK_CHIPSET_VALID_COMMAND:
+            upload_num_commands++;
             bcm_send_prepared_command();
             break;
         case BTSTACK_CHIPSET_DONE:
             log_info("bcm: init script done");
+            log_info("bcm: init script upload: %u commands in %u ms", upload_num_commands,
+                     (unsigned int) (btstack_run_loop_get_time_ms() - upload_start_ms));
             // disable init script for main startup
             btstack_chipset_bcm_enable_init_script(0);
             // reset baudreate to default
@@ -140,6 +146,8 @@ void btstack_chipset_bcm_download_firmware(const btstack_uart_block_t * the_uart
     chipset     = btstack_chipset_bcm_instance();
     baudrate    = baudrate_upload; 
     download_complete = done;
+    upload_start_ms = btstack_run_loop_get_time_ms();
+    upload_num_commands = 0;
     btstack_chipset_bcm_enable_init_script(1);
 
     int res = uart_driver->open();
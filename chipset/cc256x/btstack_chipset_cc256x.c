@@ -395,6 +395,7 @@ static const btstack_chipset_t btstack_chipset_cc256x = {
     chipset_next_command,
     chipset_set_baudrate_command,
     chipset_set_bd_addr_command,
+    4, // init_script_pipeline_depth
 };
 
 const btstack_chipset_t * btstack_chipset_cc256x_instance(void){
@@ -134,6 +134,7 @@ static FILE *   fw_file;
 static uint32_t fw_offset;
 
 static void (*done)(int result);
+static uint32_t upload_start_ms;
 
 // functions
 
@@ -373,6 +374,8 @@ static void state_machine(uint8_t * packet){
 
             printf("Firmware upload complete\n");
             log_info("Vendor Event 0x06 - firmware complete");
+            log_info("intel: firmware upload: %u bytes in %u ms", (unsigned int) fw_offset,
+                     (unsigned int) (btstack_run_loop_get_time_ms() - upload_start_ms));
 
             // Reset Params - constants from Windows Intel driver
             state++;
@@ -472,6 +475,7 @@ void btstack_chipset_intel_download_firmware(const hci_transport_t * hci_transpo
     transport->open();
 
     // get started
+    upload_start_ms = btstack_run_loop_get_time_ms();
     state = 0;
     state_machine(NULL);
 }
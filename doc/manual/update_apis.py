@@ -15,6 +15,7 @@ apis = [
     ["src/btstack_linked_list.h","BTstack Linked List","btList"],
     ["src/btstack_memory.h","BTstack Memory Management","btMemory"],
     ["src/btstack_run_loop.h", "Run Loop", "runLoop"],
+    ["src/btstack_stats.h", "BTstack Statistics and Tracing", "btStats"],
     ["src/btstack_tlv.h", "Tag Value Length Persistent Storage (TLV)", "tlv"],
     ["src/btstack_util.h", "Common Utils", "btUtil"],
     ["src/gap.h", "GAP", "gap"],
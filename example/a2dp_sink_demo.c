@@ -97,13 +97,12 @@
 static btstack_sbc_decoder_state_t state;
 static btstack_sbc_mode_t mode = SBC_MODE_STANDARD;
 
-// ring buffer for SBC Frames
-// below 30: add samples, 30-40: fine, above 40: drop samples
-#define OPTIMAL_FRAMES_MIN 30
-#define OPTIMAL_FRAMES_MAX 40
-#define ADDITIONAL_FRAMES  20
-static uint8_t sbc_frame_storage[(OPTIMAL_FRAMES_MAX + ADDITIONAL_FRAMES) * MAX_SBC_FRAME_SIZE];
-static btstack_ring_buffer_t sbc_frame_ring_buffer;
+// jitter buffer for SBC media packets, target latency adapts to jitter of the stream
+#define NUM_MEDIA_PACKETS         16
+#define MAX_MEDIA_PAYLOAD_SIZE  1024
+static btstack_jitter_buffer_slot_t jitter_buffer_slots[NUM_MEDIA_PACKETS];
+static uint8_t jitter_buffer_storage[NUM_MEDIA_PACKETS * MAX_MEDIA_PAYLOAD_SIZE];
+static btstack_jitter_buffer_t jitter_buffer;
 static unsigned int sbc_frame_size;
 
 // rest buffer for not fully used sbc frames, with additional frames for resampling
@@ -335,11 +334,17 @@ static void playback_handler(int16_t * buffer, uint16_t num_audio_frames){
     // then start decoding sbc frames using request_* globals
     request_buffer = buffer;
     request_frames = num_audio_frames;
-    while (request_frames && btstack_ring_buffer_bytes_available(&sbc_frame_ring_buffer) >= sbc_frame_size){
+    while (request_frames){
         // decode frame
-        uint8_t sbc_frame[MAX_SBC_FRAME_SIZE];
-        btstack_ring_buffer_read(&sbc_frame_ring_buffer, sbc_frame, sbc_frame_size, &bytes_read);
-        btstack_sbc_decoder_process_data(&state, 0, sbc_frame, sbc_frame_size);
+        uint16_t frame_len;
+        const uint8_t * sbc_frame = btstack_jitter_buffer_get_frame(&jitter_buffer, &frame_len);
+        if (sbc_frame == NULL) break;
+        btstack_sbc_decoder_process_data(&state, 0, (uint8_t *) sbc_frame, frame_len);
+    }
+
+    // underrun: play silence until jitter buffer is filled again
+    if (request_frames){
+        memset(request_buffer, 0, request_frames * BYTES_PER_FRAME);
     }
 
 #ifdef STORE_TO_WAV_FILE
@@ -395,7 +400,8 @@ static int media_processing_init(avdtp_media_codec_configuration_sbc_t configura
    sbc_file = fopen(sbc_filename, "wb"); 
 #endif
 
-    btstack_ring_buffer_init(&sbc_frame_ring_buffer, sbc_frame_storage, sizeof(sbc_frame_storage));
+    btstack_jitter_buffer_init(&jitter_buffer, jitter_buffer_slots, jitter_buffer_storage, NUM_MEDIA_PACKETS, MAX_MEDIA_PAYLOAD_SIZE,
+                               configuration.sampling_frequency);
     btstack_ring_buffer_init(&decoded_audio_ring_buffer, decoded_audio_storage, sizeof(decoded_audio_storage));
     btstack_resample_init(&resample_instance, configuration.num_channels);
 
@@ -448,6 +454,13 @@ static void media_processing_close(void){
     fclose(sbc_file);
 #endif     
 
+    const btstack_jitter_buffer_statistics_t * statistics = btstack_jitter_buffer_get_statistics(&jitter_buffer);
+    printf("Jitter Buffer: %u packets, %u lost, %u late, %u duplicate, %u dropped, %u underruns\n",
+           statistics->packets_received, statistics->packets_lost, statistics->packets_late,
+           statistics->packets_duplicate, statistics->packets_dropped_overflow, statistics->underruns);
+    printf("Jitter Buffer: latency max %u ms, target %u ms, jitter %u us, drift %d ppm\n",
+           statistics->latency_max_ms, statistics->target_latency_ms, statistics->jitter_us, statistics->drift_ppm);
+
     // stop audio playback
     const btstack_audio_sink_t * audio = btstack_audio_sink_get_instance();
     if (audio){
@@ -460,8 +473,9 @@ static void media_processing_close(void){
  *
  * @text Here the audio data, are received through the handle_l2cap_media_data_packet callback.
  * Currently, only the SBC media codec is supported. Hence, the media data consists of the media packet header and the SBC packet.
- * The SBC frame will be stored in a ring buffer for later processing (instead of decoding it to PCM right away which would require a much larger buffer).
- * If the audio stream wasn't started already and there are enough SBC frames in the ring buffer, start playback.
+ * The SBC frames will be stored in a jitter buffer for later processing (instead of decoding it to PCM right away which would require a much larger buffer).
+ * The jitter buffer reorders the media packets by sequence number and provides the resampling factor that compensates the clock drift to the phone.
+ * If the audio stream wasn't started already and the jitter buffer has reached its target latency, start playback.
  */ 
 
 static int read_media_data_header(uint8_t * packet, int size, int * offset, avdtp_media_packet_header_t * media_header);
@@ -488,34 +502,23 @@ static void handle_l2cap_media_data_packet(uint8_t seid, uint8_t *packet, uint16
         return;
     }
 
+    if (sbc_header.num_frames == 0) return;
+
     // store sbc frame size for buffer management
     sbc_frame_size = (size-pos)/ sbc_header.num_frames;
-        
-    int status = btstack_ring_buffer_write(&sbc_frame_ring_buffer, packet+pos, size-pos);
-    if (status){
-        printf("Error storing samples in SBC ring buffer!!!\n");
-    }
-
-    // decide on audio sync drift based on number of sbc frames in queue
-    int sbc_frames_in_buffer = btstack_ring_buffer_bytes_available(&sbc_frame_ring_buffer) / sbc_frame_size;
-    uint32_t resampling_factor;
-
-    // nomimal factor (fixed-point 2^16) and compensation offset
-    uint32_t nomimal_factor = 0x10000;
-    uint32_t compensation   = 0x00100;
 
-    if (sbc_frames_in_buffer < OPTIMAL_FRAMES_MIN){
-    	resampling_factor = nomimal_factor - compensation;    // stretch samples
-    } else if (sbc_frames_in_buffer <= OPTIMAL_FRAMES_MAX){
-    	resampling_factor = nomimal_factor;                   // nothing to do
-    } else {
-    	resampling_factor = nomimal_factor + compensation;    // compress samples
+    int status = btstack_jitter_buffer_add_packet(&jitter_buffer, media_header.sequence_number, media_header.timestamp,
+                                                  btstack_run_loop_get_time_ms(), packet+pos, size-pos, sbc_header.num_frames,
+                                                  sbc_header.num_frames * sbc_configuration.frames_per_buffer);
+    if (status){
+        printf("Error storing samples in jitter buffer!!!\n");
     }
 
-    btstack_resample_set_factor(&resample_instance, resampling_factor);
+    // compensate clock drift and keep latency close to target
+    btstack_resample_set_factor(&resample_instance, btstack_jitter_buffer_get_resampling_factor(&jitter_buffer));
 
     // start stream if enough frames buffered
-    if (!audio_stream_started && sbc_frames_in_buffer >= OPTIMAL_FRAMES_MIN){
+    if (!audio_stream_started && btstack_jitter_buffer_is_playing(&jitter_buffer)){
         audio_stream_started = 1;
         // setup audio playback
         if (audio){
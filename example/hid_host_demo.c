@@ -59,6 +59,13 @@
 static uint8_t            hid_descriptor[MAX_ATTRIBUTE_VALUE_SIZE];
 static uint16_t           hid_descriptor_len;
 
+// HID Descriptor compiled into report layout
+#define MAX_HID_REPORTS 8
+#define MAX_HID_FIELDS  32
+static btstack_hid_report_layout_t hid_report_layout;
+static btstack_hid_report_t        hid_reports[MAX_HID_REPORTS];
+static btstack_hid_field_t         hid_fields[MAX_HID_FIELDS];
+
 static uint16_t           hid_control_psm;
 static uint16_t           hid_interrupt_psm;
 
@@ -244,6 +251,10 @@ static void handle_sdp_client_query_result(uint8_t packet_type, uint16_t channel
                                     memcpy(hid_descriptor, descriptor, hid_descriptor_len);
                                     printf("HID Descriptor:\n");
                                     printf_hexdump(hid_descriptor, hid_descriptor_len);
+                                    btstack_hid_report_layout_init(&hid_report_layout, hid_reports, MAX_HID_REPORTS, hid_fields, MAX_HID_FIELDS);
+                                    if (btstack_hid_report_layout_compile(&hid_report_layout, hid_descriptor_len, hid_descriptor) != ERROR_CODE_SUCCESS){
+                                        printf("HID Descriptor too complex\n");
+                                    }
                                 }
                             }                        
                             break;
@@ -286,7 +297,7 @@ static void handle_sdp_client_query_result(uint8_t packet_type, uint16_t channel
 /*
  * @section HID Report Handler
  * 
- * @text Use BTstack's compact HID Parser to process incoming HID Report
+ * @text Use BTstack's HID Report Layout compiled from the HID Descriptor to process incoming HID Report
  * Iterate over all fields and process fields with usage page = 0x07 / Keyboard
  * Check if SHIFT is down and process first character (don't handle multiple key presses)
  * 
@@ -299,17 +310,17 @@ static void hid_host_handle_interrupt_report(const uint8_t * report, uint16_t re
     if (*report != 0xa1) return; 
     report++;
     report_len--;
-    btstack_hid_parser_t parser;
-    btstack_hid_parser_init(&parser, hid_descriptor, hid_descriptor_len, HID_REPORT_TYPE_INPUT, report, report_len);
+    btstack_hid_report_iterator_t iterator;
+    btstack_hid_report_iterator_init(&iterator, &hid_report_layout, HID_REPORT_TYPE_INPUT, report, report_len);
     int shift = 0;
     uint8_t new_keys[NUM_KEYS];
     memset(new_keys, 0, sizeof(new_keys));
     int     new_keys_count = 0;
-    while (btstack_hid_parser_has_more(&parser)){
+    while (btstack_hid_report_iterator_has_more(&iterator)){
         uint16_t usage_page;
         uint16_t usage;
         int32_t  value;
-        btstack_hid_parser_get_field(&parser, &usage_page, &usage, &value);
+        btstack_hid_report_iterator_get_field(&iterator, &usage_page, &usage, &value);
         if (usage_page != 0x07) continue;   
         switch (usage){
             case 0xe1:
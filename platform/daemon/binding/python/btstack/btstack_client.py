@@ -43,6 +43,15 @@ class BTstackClient(btstack.command_builder.CommandBuilder):
         print("[+] Register packet handler")
         self.packet_handler = callback
 
+    def subscribe(self, event_codes=(), con_handles=(), channels=()):
+        # once subscribed, the daemon only forwards matching events
+        for event_code in event_codes:
+            self.btstack_subscribe_event(event_code)
+        for con_handle in con_handles:
+            self.btstack_subscribe_con_handle(con_handle)
+        for channel in channels:
+            self.btstack_subscribe_channel(channel)
+
     def send_hci_command(self, command):
         packet_type = 1
         channel = 0
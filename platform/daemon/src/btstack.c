@@ -114,6 +114,12 @@ int bt_open(void){
     return 0;
 }
 
+// use shared memory rings instead of unix socket
+int bt_enable_shared_memory(uint32_t ring_size){
+    if (daemon_tcp_address) return -1;
+    return socket_connection_enable_shared_memory(btstack_connection, ring_size);
+}
+
 // stop using BTstack library
 int bt_close(void){
     return socket_connection_close_tcp(btstack_connection);
@@ -83,6 +83,11 @@ int bt_open(void);
 // stop using BTstack library
 int bt_close(void);
 
+// optional: after bt_open with unix socket, exchange packets via shared memory rings instead of the socket (Linux only)
+//           ring_size: bytes per direction, power of two, 0 for default
+// @returns 0 if shared memory is used
+int bt_enable_shared_memory(uint32_t ring_size);
+
 // send hci cmd packet
 int bt_send_cmd(const hci_cmd_t *cmd, ...);
 
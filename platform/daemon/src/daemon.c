@@ -129,6 +129,10 @@ const btstack_link_key_db_t * btstack_link_key_db_fs_instance(void);
 
 #define DAEMON_NO_ACTIVE_CLIENT_TIMEOUT 10000
 
+// Prometheus text of btstack_stats, sent in DAEMON_EVENT_STATS chunks
+#define DAEMON_STATS_BUFFER_SIZE 4096
+#define DAEMON_STATS_CHUNK_SIZE  200
+
 #define ATT_MAX_LONG_ATTRIBUTE_SIZE 512
 
 
@@ -162,6 +166,12 @@ typedef struct {
     
     // discoverable
     uint8_t        discoverable;
+
+    // event subscriptions - all packets are forwarded until first subscription
+    uint8_t               subscriptions_active;
+    uint8_t               subscribed_event_codes[32];
+    btstack_linked_list_t subscribed_con_handles;
+    btstack_linked_list_t subscribed_channels;
     
 } client_state_t;
 
@@ -203,6 +213,7 @@ static client_state_t * client_for_connection(connection_t *connection);
 static void hci_emit_system_bluetooth_enabled(uint8_t enabled);
 static void stack_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t * packet, uint16_t size);
 static void btstack_server_configure_stack(void);
+static void daemon_client_clear_subscriptions(client_state_t * client);
 
 // MARK: globals
 
@@ -293,6 +304,26 @@ static void remove_and_free_uint32_from_list(btstack_linked_list_t *list, uint32
     } 
 }
 
+static int uint32_list_contains(btstack_linked_list_t *list, uint32_t value){
+    btstack_linked_list_iterator_t it;    
+    btstack_linked_list_iterator_init(&it, list);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        btstack_linked_list_uint32_t * item = (btstack_linked_list_uint32_t*) btstack_linked_list_iterator_next(&it);
+        if ( item->value == value) return 1;
+    } 
+    return 0;
+}
+
+static void free_uint32_list(btstack_linked_list_t *list){
+    btstack_linked_list_iterator_t it;    
+    btstack_linked_list_iterator_init(&it, list);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        btstack_linked_list_uint32_t * item = (btstack_linked_list_uint32_t*) btstack_linked_list_iterator_next(&it);
+        btstack_linked_list_remove(list, (btstack_linked_item_t *) item);
+        free(item);
+    } 
+}
+
 static void daemon_add_client_rfcomm_service(connection_t * connection, uint16_t service_channel){
     client_state_t * client_state = client_for_connection(connection);
     if (!client_state) return;
@@ -654,6 +685,150 @@ static void daemon_gatt_client_close_connection(connection_t * connection){
 }
 #endif
 
+// MARK: event subscriptions
+
+static void daemon_client_clear_subscriptions(client_state_t * client){
+    client->subscriptions_active = 0;
+    memset(client->subscribed_event_codes, 0, sizeof(client->subscribed_event_codes));
+    free_uint32_list(&client->subscribed_con_handles);
+    free_uint32_list(&client->subscribed_channels);
+}
+
+static void daemon_client_subscribe_event(client_state_t * client, uint8_t event_code, int subscribe){
+    client->subscriptions_active = 1;
+    if (subscribe){
+        client->subscribed_event_codes[event_code >> 3] |=  (1 << (event_code & 7));
+    } else {
+        client->subscribed_event_codes[event_code >> 3] &= ~(1 << (event_code & 7));
+    }
+}
+
+static void daemon_client_subscribe_value(client_state_t * client, btstack_linked_list_t * list, uint16_t value, int subscribe){
+    client->subscriptions_active = 1;
+    if (subscribe){
+        add_uint32_to_list(list, value);
+    } else {
+        remove_and_free_uint32_from_list(list, value);
+    }
+}
+
+static int daemon_event_get_con_handle(const uint8_t * packet, hci_con_handle_t * con_handle){
+    switch (hci_event_packet_get_type(packet)){
+        case HCI_EVENT_CONNECTION_COMPLETE:
+        case HCI_EVENT_DISCONNECTION_COMPLETE:
+        case HCI_EVENT_AUTHENTICATION_COMPLETE:
+        case HCI_EVENT_ENCRYPTION_CHANGE:
+        case HCI_EVENT_CHANGE_CONNECTION_LINK_KEY_COMPLETE:
+        case HCI_EVENT_READ_REMOTE_SUPPORTED_FEATURES_COMPLETE:
+        case HCI_EVENT_READ_REMOTE_VERSION_INFORMATION_COMPLETE:
+        case HCI_EVENT_MODE_CHANGE:
+        case HCI_EVENT_READ_CLOCK_OFFSET_COMPLETE:
+        case HCI_EVENT_CONNECTION_PACKET_TYPE_CHANGED:
+        case HCI_EVENT_SYNCHRONOUS_CONNECTION_COMPLETE:
+        case HCI_EVENT_ENCRYPTION_KEY_REFRESH_COMPLETE:
+            // status(8), con_handle(16)
+            *con_handle = little_endian_read_16(packet, 3) & 0x0fff;
+            return 1;
+        case HCI_EVENT_MAX_SLOTS_CHANGED:
+            *con_handle = hci_event_max_slots_changed_get_handle(packet);
+            return 1;
+        case HCI_EVENT_LE_META:
+            switch (hci_event_le_meta_get_subevent_code(packet)){
+                case HCI_SUBEVENT_LE_CONNECTION_COMPLETE:
+                    *con_handle = hci_subevent_le_connection_complete_get_connection_handle(packet);
+                    return 1;
+                case HCI_SUBEVENT_LE_ENHANCED_CONNECTION_COMPLETE:
+                    *con_handle = hci_subevent_le_enhanced_connection_complete_get_connection_handle(packet);
+                    return 1;
+                case HCI_SUBEVENT_LE_CONNECTION_UPDATE_COMPLETE:
+                    *con_handle = hci_subevent_le_connection_update_complete_get_connection_handle(packet);
+                    return 1;
+                case HCI_SUBEVENT_LE_READ_REMOTE_USED_FEATURES_COMPLETE:
+                    *con_handle = hci_subevent_le_read_remote_used_features_complete_get_connection_handle(packet);
+                    return 1;
+                case HCI_SUBEVENT_LE_LONG_TERM_KEY_REQUEST:
+                    *con_handle = hci_subevent_le_long_term_key_request_get_connection_handle(packet);
+                    return 1;
+                case HCI_SUBEVENT_LE_REMOTE_CONNECTION_PARAMETER_REQUEST:
+                    *con_handle = hci_subevent_le_remote_connection_parameter_request_get_connection_handle(packet);
+                    return 1;
+                case HCI_SUBEVENT_LE_DATA_LENGTH_CHANGE:
+                    *con_handle = hci_subevent_le_data_length_change_get_connection_handle(packet);
+                    return 1;
+                default:
+                    return 0;
+            }
+        case L2CAP_EVENT_CHANNEL_OPENED:
+            *con_handle = l2cap_event_channel_opened_get_handle(packet);
+            return 1;
+        case L2CAP_EVENT_INCOMING_CONNECTION:
+            *con_handle = l2cap_event_incoming_connection_get_handle(packet);
+            return 1;
+        case L2CAP_EVENT_CONNECTION_PARAMETER_UPDATE_REQUEST:
+            *con_handle = l2cap_event_connection_parameter_update_request_get_handle(packet);
+            return 1;
+        case L2CAP_EVENT_CONNECTION_PARAMETER_UPDATE_RESPONSE:
+            *con_handle = l2cap_event_connection_parameter_update_response_get_handle(packet);
+            return 1;
+        case RFCOMM_EVENT_CHANNEL_OPENED:
+            *con_handle = rfcomm_event_channel_opened_get_con_handle(packet);
+            return 1;
+        default:
+            break;
+    }
+    // GATT Client and SM events: event(8), len(8), con_handle(16)
+    uint8_t event_code = hci_event_packet_get_type(packet);
+    if (((event_code >= GATT_EVENT_QUERY_COMPLETE) && (event_code <= GATT_EVENT_EATT_CONNECTED)) ||
+        ((event_code >= SM_EVENT_JUST_WORKS_REQUEST) && (event_code <= SM_EVENT_PAIRING_COMPLETE))){
+        *con_handle = little_endian_read_16(packet, 2);
+        return 1;
+    }
+    return 0;
+}
+
+static int daemon_event_get_channel(const uint8_t * packet, uint16_t * channel){
+    switch (hci_event_packet_get_type(packet)){
+        case L2CAP_EVENT_CHANNEL_OPENED:
+            *channel = l2cap_event_channel_opened_get_local_cid(packet);
+            return 1;
+        case L2CAP_EVENT_CHANNEL_CLOSED:
+            *channel = l2cap_event_channel_closed_get_local_cid(packet);
+            return 1;
+        case L2CAP_EVENT_INCOMING_CONNECTION:
+            *channel = l2cap_event_incoming_connection_get_local_cid(packet);
+            return 1;
+        case L2CAP_EVENT_CAN_SEND_NOW:
+            *channel = l2cap_event_can_send_now_get_local_cid(packet);
+            return 1;
+        case DAEMON_EVENT_L2CAP_CREDITS:
+            *channel = little_endian_read_16(packet, 2);
+            return 1;
+        case RFCOMM_EVENT_CHANNEL_OPENED:
+            *channel = rfcomm_event_channel_opened_get_rfcomm_cid(packet);
+            return 1;
+        case RFCOMM_EVENT_CHANNEL_CLOSED:
+            *channel = rfcomm_event_channel_closed_get_rfcomm_cid(packet);
+            return 1;
+        case RFCOMM_EVENT_INCOMING_CONNECTION:
+            *channel = rfcomm_event_incoming_connection_get_rfcomm_cid(packet);
+            return 1;
+        case RFCOMM_EVENT_REMOTE_LINE_STATUS:
+            *channel = rfcomm_event_remote_line_status_get_rfcomm_cid(packet);
+            return 1;
+        case RFCOMM_EVENT_REMOTE_MODEM_STATUS:
+            *channel = rfcomm_event_remote_modem_status_get_rfcomm_cid(packet);
+            return 1;
+        case RFCOMM_EVENT_CAN_SEND_NOW:
+            *channel = rfcomm_event_can_send_now_get_rfcomm_cid(packet);
+            return 1;
+        case DAEMON_EVENT_RFCOMM_CREDITS:
+            *channel = little_endian_read_16(packet, 2);
+            return 1;
+        default:
+            return 0;
+    }
+}
+
 static void daemon_disconnect_client(connection_t * connection){
     log_info("Daemon disconnect client %p\n",connection);
 
@@ -669,6 +844,8 @@ static void daemon_disconnect_client(connection_t * connection){
     daemon_gatt_client_close_connection(connection);
 #endif
 
+    daemon_client_clear_subscriptions(client);
+
     btstack_linked_list_remove(&clients, (btstack_linked_item_t *) client);
     free(client); 
 }
@@ -790,6 +967,26 @@ static void send_gatt_query_complete(connection_t * connection, hci_con_handle_t
     socket_connection_send_packet(connection, HCI_EVENT_PACKET, 0, event, sizeof(event));
 }
 
+#ifdef ENABLE_BTSTACK_STATS
+static void send_btstack_stats(connection_t * connection){
+    static char stats_text[DAEMON_STATS_BUFFER_SIZE];
+    uint32_t stats_len = btstack_stats_export_prometheus(stats_text, sizeof(stats_text));
+    uint32_t pos = 0;
+    do {
+        // @format 1JV
+        uint8_t event[4 + DAEMON_STATS_CHUNK_SIZE];
+        uint8_t chunk_len = (uint8_t) btstack_min(stats_len - pos, DAEMON_STATS_CHUNK_SIZE);
+        event[0] = DAEMON_EVENT_STATS;
+        event[1] = 2 + chunk_len;
+        event[2] = ((pos + chunk_len) < stats_len) ? 1 : 0;
+        event[3] = chunk_len;
+        (void)memcpy(&event[4], &stats_text[pos], chunk_len);
+        pos += chunk_len;
+        socket_connection_send_packet(connection, HCI_EVENT_PACKET, 0, event, 4 + chunk_len);
+    } while (pos < stats_len);
+}
+#endif
+
 static void send_gatt_mtu_event(connection_t * connection, hci_con_handle_t con_handle, uint16_t mtu){
     uint8_t event[6];
     int pos = 0;
@@ -950,6 +1147,41 @@ static int btstack_command_handler(connection_t *connection, uint8_t *packet, ui
         case BTSTACK_GET_SYSTEM_BLUETOOTH_ENABLED:
             hci_emit_system_bluetooth_enabled(0);
             break;
+#endif
+        case BTSTACK_SUBSCRIBE_EVENT:
+        case BTSTACK_UNSUBSCRIBE_EVENT:
+            log_info("BTSTACK_%sSUBSCRIBE_EVENT 0x%02x", READ_CMD_OCF(packet) == BTSTACK_SUBSCRIBE_EVENT ? "" : "UN", packet[3]);
+            client = client_for_connection(connection);
+            if (!client) break;
+            daemon_client_subscribe_event(client, packet[3], READ_CMD_OCF(packet) == BTSTACK_SUBSCRIBE_EVENT);
+            break;
+        case BTSTACK_SUBSCRIBE_CON_HANDLE:
+        case BTSTACK_UNSUBSCRIBE_CON_HANDLE:
+            log_info("BTSTACK_%sSUBSCRIBE_CON_HANDLE 0x%04x", READ_CMD_OCF(packet) == BTSTACK_SUBSCRIBE_CON_HANDLE ? "" : "UN", little_endian_read_16(packet, 3));
+            client = client_for_connection(connection);
+            if (!client) break;
+            daemon_client_subscribe_value(client, &client->subscribed_con_handles, little_endian_read_16(packet, 3) & 0x0fff,
+                                          READ_CMD_OCF(packet) == BTSTACK_SUBSCRIBE_CON_HANDLE);
+            break;
+        case BTSTACK_SUBSCRIBE_CHANNEL:
+        case BTSTACK_UNSUBSCRIBE_CHANNEL:
+            log_info("BTSTACK_%sSUBSCRIBE_CHANNEL 0x%04x", READ_CMD_OCF(packet) == BTSTACK_SUBSCRIBE_CHANNEL ? "" : "UN", little_endian_read_16(packet, 3));
+            client = client_for_connection(connection);
+            if (!client) break;
+            daemon_client_subscribe_value(client, &client->subscribed_channels, little_endian_read_16(packet, 3),
+                                          READ_CMD_OCF(packet) == BTSTACK_SUBSCRIBE_CHANNEL);
+            break;
+        case BTSTACK_CLEAR_SUBSCRIPTIONS:
+            log_info("BTSTACK_CLEAR_SUBSCRIPTIONS");
+            client = client_for_connection(connection);
+            if (!client) break;
+            daemon_client_clear_subscriptions(client);
+            break;
+#ifdef ENABLE_BTSTACK_STATS
+        case BTSTACK_GET_STATS:
+            log_info("BTSTACK_GET_STATS");
+            send_btstack_stats(connection);
+            break;
 #endif
         case BTSTACK_SET_DISCOVERABLE:
             log_info("BTSTACK_SET_DISCOVERABLE discoverable %u)", packet[3]);
@@ -1482,8 +1714,46 @@ static void daemon_retry_parked(void){
 static void daemon_emit_packet(void * connection, uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
     if (connection) {
         socket_connection_send_packet(connection, packet_type, channel, packet, size);
-    } else {
-        socket_connection_send_packet_all(packet_type, channel, packet, size);
+        return;
+    }
+
+    // get connection handle and channel once, clients without subscriptions receive all packets
+    uint8_t  event_code = 0;
+    int      has_con_handle = 0;
+    int      has_channel = 0;
+    hci_con_handle_t con_handle = HCI_CON_HANDLE_INVALID;
+    uint16_t event_channel = 0;
+    switch (packet_type){
+        case HCI_EVENT_PACKET:
+            event_code = hci_event_packet_get_type(packet);
+            has_con_handle = daemon_event_get_con_handle(packet, &con_handle);
+            has_channel = daemon_event_get_channel(packet, &event_channel);
+            break;
+        case HCI_ACL_DATA_PACKET:
+        case HCI_SCO_DATA_PACKET:
+            con_handle = little_endian_read_16(packet, 0) & 0x0fff;
+            has_con_handle = 1;
+            break;
+        default:
+            break;
+    }
+
+    btstack_linked_list_iterator_t it;
+    btstack_linked_list_iterator_init(&it, &clients);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        client_state_t * client = (client_state_t *) btstack_linked_list_iterator_next(&it);
+        if (client->subscriptions_active){
+            int match = 0;
+            if ((packet_type == HCI_EVENT_PACKET) && (client->subscribed_event_codes[event_code >> 3] & (1 << (event_code & 7)))){
+                match = 1;
+            } else if (has_con_handle && uint32_list_contains(&client->subscribed_con_handles, con_handle)){
+                match = 1;
+            } else if (has_channel && uint32_list_contains(&client->subscribed_channels, event_channel)){
+                match = 1;
+            }
+            if (!match) continue;
+        }
+        socket_connection_send_packet(client->connection, packet_type, channel, packet, size);
     }
 }
 
@@ -1821,9 +2091,11 @@ static int clients_require_discoverable(void){
 
 static void usage(const char * name) {
     printf("%s, BTstack background daemon\n", name);
-    printf("usage: %s [--help] [--tcp]\n", name);
-    printf("    --help   display this usage\n");
-    printf("    --tcp    use TCP server on port %u\n", BTSTACK_PORT);
+    printf("usage: %s [--help] [--tcp] [--client-queue-size bytes] [--client-overflow policy]\n", name);
+    printf("    --help                      display this usage\n");
+    printf("    --tcp                       use TCP server on port %u\n", BTSTACK_PORT);
+    printf("    --client-queue-size bytes   size of output queue per client, default %u\n", SOCKET_CONNECTION_OUTPUT_QUEUE_SIZE);
+    printf("    --client-overflow policy    if client queue is full: drop, disconnect (default), or backpressure\n");
     printf("Without the --tcp option, BTstack Server is listening on unix domain socket %s\n\n", BTSTACK_UNIX);
 }
 
@@ -2132,9 +2404,13 @@ int btstack_server_run_tcp(void){
 int main (int argc,  char * const * argv){
     
     int tcp_flag = 0;
+    uint32_t client_queue_size = SOCKET_CONNECTION_OUTPUT_QUEUE_SIZE;
+    socket_connection_overflow_policy_t client_overflow_policy = SOCKET_CONNECTION_OVERFLOW_DISCONNECT;
     struct option long_options[] = {
         { "tcp", no_argument, &tcp_flag, 1 },
         { "help", no_argument, 0, 0 },
+        { "client-queue-size", required_argument, 0, 0 },
+        { "client-overflow", required_argument, 0, 0 },
         { 0,0,0,0 } // This is a filler for -1
     };
     
@@ -2159,9 +2435,26 @@ int main (int argc,  char * const * argv){
                     usage(argv[0]);
                     return 0;
                     break;
+                case 2:
+                    client_queue_size = (uint32_t) strtoul(optarg, NULL, 0);
+                    break;
+                case 3:
+                    if (strcmp(optarg, "drop") == 0){
+                        client_overflow_policy = SOCKET_CONNECTION_OVERFLOW_DROP;
+                    } else if (strcmp(optarg, "disconnect") == 0){
+                        client_overflow_policy = SOCKET_CONNECTION_OVERFLOW_DISCONNECT;
+                    } else if (strcmp(optarg, "backpressure") == 0){
+                        client_overflow_policy = SOCKET_CONNECTION_OVERFLOW_BACKPRESSURE;
+                    } else {
+                        usage(argv[0]);
+                        return 1;
+                    }
+                    break;
             }
         }
     }
+
+    socket_connection_set_output_queue(client_queue_size, client_overflow_policy);
     
 #ifndef HAVE_UNIX_SOCKETS
     // TCP is default if there are no unix sockets
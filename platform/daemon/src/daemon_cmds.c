@@ -97,6 +97,59 @@ const hci_cmd_t btstack_set_bluetooth_enabled = {
     DAEMON_OPCODE_BTSTACK_SET_BLUETOOTH_ENABLED, "1"
 };
 
+/**
+ * @param event_code
+ */
+const hci_cmd_t btstack_subscribe_event_cmd = {
+    DAEMON_OPCODE_BTSTACK_SUBSCRIBE_EVENT, "1"
+};
+
+/**
+ * @param event_code
+ */
+const hci_cmd_t btstack_unsubscribe_event_cmd = {
+    DAEMON_OPCODE_BTSTACK_UNSUBSCRIBE_EVENT, "1"
+};
+
+/**
+ * @param con_handle
+ */
+const hci_cmd_t btstack_subscribe_con_handle_cmd = {
+    DAEMON_OPCODE_BTSTACK_SUBSCRIBE_CON_HANDLE, "H"
+};
+
+/**
+ * @param con_handle
+ */
+const hci_cmd_t btstack_unsubscribe_con_handle_cmd = {
+    DAEMON_OPCODE_BTSTACK_UNSUBSCRIBE_CON_HANDLE, "H"
+};
+
+/**
+ * @param local_cid (L2CAP or RFCOMM)
+ */
+const hci_cmd_t btstack_subscribe_channel_cmd = {
+    DAEMON_OPCODE_BTSTACK_SUBSCRIBE_CHANNEL, "2"
+};
+
+/**
+ * @param local_cid (L2CAP or RFCOMM)
+ */
+const hci_cmd_t btstack_unsubscribe_channel_cmd = {
+    DAEMON_OPCODE_BTSTACK_UNSUBSCRIBE_CHANNEL, "2"
+};
+
+const hci_cmd_t btstack_clear_subscriptions_cmd = {
+    DAEMON_OPCODE_BTSTACK_CLEAR_SUBSCRIPTIONS, ""
+};
+
+/**
+ * @brief requires ENABLE_BTSTACK_STATS in daemon, result in DAEMON_EVENT_STATS events
+ */
+const hci_cmd_t btstack_get_stats_cmd = {
+    DAEMON_OPCODE_BTSTACK_GET_STATS, ""
+};
+
 /**
  * @param bd_addr (48)
  * @param psm (16)
@@ -63,6 +63,14 @@ typedef enum {
     DAEMON_OPCODE_BTSTACK_SET_SYSTEM_BLUETOOTH_ENABLED = DAEMON_OPCODE(BTSTACK_SET_SYSTEM_BLUETOOTH_ENABLED),
     DAEMON_OPCODE_BTSTACK_SET_DISCOVERABLE = DAEMON_OPCODE(BTSTACK_SET_DISCOVERABLE),
     DAEMON_OPCODE_BTSTACK_SET_BLUETOOTH_ENABLED = DAEMON_OPCODE(BTSTACK_SET_BLUETOOTH_ENABLED),
+    DAEMON_OPCODE_BTSTACK_SUBSCRIBE_EVENT = DAEMON_OPCODE(BTSTACK_SUBSCRIBE_EVENT),
+    DAEMON_OPCODE_BTSTACK_UNSUBSCRIBE_EVENT = DAEMON_OPCODE(BTSTACK_UNSUBSCRIBE_EVENT),
+    DAEMON_OPCODE_BTSTACK_SUBSCRIBE_CON_HANDLE = DAEMON_OPCODE(BTSTACK_SUBSCRIBE_CON_HANDLE),
+    DAEMON_OPCODE_BTSTACK_UNSUBSCRIBE_CON_HANDLE = DAEMON_OPCODE(BTSTACK_UNSUBSCRIBE_CON_HANDLE),
+    DAEMON_OPCODE_BTSTACK_SUBSCRIBE_CHANNEL = DAEMON_OPCODE(BTSTACK_SUBSCRIBE_CHANNEL),
+    DAEMON_OPCODE_BTSTACK_UNSUBSCRIBE_CHANNEL = DAEMON_OPCODE(BTSTACK_UNSUBSCRIBE_CHANNEL),
+    DAEMON_OPCODE_BTSTACK_CLEAR_SUBSCRIPTIONS = DAEMON_OPCODE(BTSTACK_CLEAR_SUBSCRIPTIONS),
+    DAEMON_OPCODE_BTSTACK_GET_STATS = DAEMON_OPCODE(BTSTACK_GET_STATS),
     DAEMON_OPCODE_L2CAP_CREATE_CHANNEL = DAEMON_OPCODE(L2CAP_CREATE_CHANNEL),
     DAEMON_OPCODE_L2CAP_CREATE_CHANNEL_MTU = DAEMON_OPCODE(L2CAP_CREATE_CHANNEL_MTU),
     DAEMON_OPCODE_L2CAP_DISCONNECT = DAEMON_OPCODE(L2CAP_DISCONNECT),
@@ -126,6 +134,16 @@ extern const hci_cmd_t btstack_set_system_bluetooth_enabled;
 extern const hci_cmd_t btstack_set_discoverable;
 extern const hci_cmd_t btstack_set_bluetooth_enabled;    // only used by btstack config
 
+// event subscriptions: once a client subscribed to anything, it only receives matching events
+extern const hci_cmd_t btstack_subscribe_event_cmd;
+extern const hci_cmd_t btstack_unsubscribe_event_cmd;
+extern const hci_cmd_t btstack_subscribe_con_handle_cmd;
+extern const hci_cmd_t btstack_unsubscribe_con_handle_cmd;
+extern const hci_cmd_t btstack_subscribe_channel_cmd;
+extern const hci_cmd_t btstack_unsubscribe_channel_cmd;
+extern const hci_cmd_t btstack_clear_subscriptions_cmd;
+extern const hci_cmd_t btstack_get_stats_cmd;
+
 extern const hci_cmd_t l2cap_accept_connection_cmd;
 extern const hci_cmd_t l2cap_create_channel_cmd;
 extern const hci_cmd_t l2cap_create_channel_mtu_cmd;
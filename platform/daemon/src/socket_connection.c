@@ -37,6 +37,11 @@
 
 #define BTSTACK_FILE__ "socket_connection.c"
 
+// memfd_create
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+
 /*
  *  SocketServer.c
  *  
@@ -70,6 +75,7 @@
 #include <arpa/inet.h>
 #include <netdb.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <sys/un.h>
 #endif
  
@@ -98,10 +104,24 @@ struct sockaddr_un {
 #include "../port/ios/3rdparty/launch.h"
 #endif
 
+// shared memory transport requires memfd, eventfd and passing of file descriptors over unix domain sockets
+#if defined(__linux__) && defined(HAVE_UNIX_SOCKETS)
+#define SOCKET_CONNECTION_SHARED_MEMORY
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#endif
+
 #define MAX_PENDING_CONNECTIONS 10
 
 /** prototypes */
 static void socket_connection_hci_process(btstack_data_source_t *ds, btstack_data_source_callback_type_t callback_type);
+static bool socket_connection_received_bytes(connection_t * conn, uint16_t bytes_read);
+#ifndef _WIN32
+static bool socket_connection_flush(connection_t * conn);
+#endif
+#ifdef SOCKET_CONNECTION_SHARED_MEMORY
+static void socket_connection_shm_process(btstack_data_source_t *ds, btstack_data_source_callback_type_t callback_type);
+#endif
 static int socket_connection_dummy_handler(connection_t *connection, uint16_t packet_type, uint16_t channel, uint8_t *data, uint16_t length);
 
 /** globals */
@@ -124,6 +144,56 @@ typedef struct linked_connection {
     connection_t * connection;
 } linked_connection_t;
 
+#ifdef SOCKET_CONNECTION_SHARED_MEMORY
+
+// packet types used to negotiate the shared memory transport, not forwarded to the packet handler
+#define SOCKET_CONNECTION_SHM_SETUP_PACKET          0xf0
+#define SOCKET_CONNECTION_SHM_SETUP_COMPLETE_PACKET 0xf1
+
+#define SOCKET_CONNECTION_SHM_MAGIC   0x52534242    // 'BBSR'
+#define SOCKET_CONNECTION_SHM_VERSION 1
+
+// memfd, doorbell client -> daemon, doorbell daemon -> client
+#define SOCKET_CONNECTION_SHM_NUM_FDS 3
+
+typedef enum {
+    SOCKET_CONNECTION_SHM_IDLE = 0,
+    SOCKET_CONNECTION_SHM_W4_SETUP_COMPLETE,
+    SOCKET_CONNECTION_SHM_W4_SOCKET_FLUSH,
+    SOCKET_CONNECTION_SHM_ACTIVE,
+    SOCKET_CONNECTION_SHM_FAILED,
+} socket_connection_shm_state_t;
+
+/**
+ * single-producer single-consumer byte ring, head and tail are free-running.
+ * consumer_waiting and producer_waiting request a doorbell when data or space becomes available
+ */
+typedef struct {
+    uint32_t head;
+    uint8_t  padding_head[60];
+    uint32_t tail;
+    uint8_t  padding_tail[60];
+    uint32_t consumer_waiting;
+    uint32_t producer_waiting;
+    uint8_t  padding_flags[56];
+} socket_connection_shm_ring_t;
+
+/** shared memory layout: header, data of ring 0 (client -> daemon), data of ring 1 (daemon -> client) */
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t ring_size;
+    uint8_t  padding[52];
+    socket_connection_shm_ring_t rings[2];
+} socket_connection_shm_header_t;
+
+typedef struct {
+    btstack_data_source_t ds;
+    connection_t * connection;
+} socket_connection_doorbell_t;
+
+#endif
+
 struct connection {
     btstack_data_source_t ds;                // used for run loop
     linked_connection_t linked_connection;   // used for connection list
@@ -132,6 +202,37 @@ struct connection {
     uint16_t bytes_read;
     uint16_t bytes_to_read;
     uint8_t  buffer[6+HCI_ACL_BUFFER_SIZE]; // packet_header(6) + max packet: 3-DH5 = header(6) + payload (1021)
+
+    // output ring for non-blocking sockets, NULL for blocking sockets
+    uint8_t * output_buffer;
+    uint32_t  output_buffer_size;
+    uint32_t  output_read_pos;
+    uint32_t  output_bytes_queued;
+    uint32_t  output_packets_dropped;
+    // set when connection gets closed because of overflow
+    uint8_t   output_closed;
+    // set while client does not accept data with SOCKET_CONNECTION_OVERFLOW_BACKPRESSURE
+    uint8_t   input_paused;
+
+#ifdef SOCKET_CONNECTION_SHARED_MEMORY
+    // file descriptors received with current packet
+    int       received_fds[SOCKET_CONNECTION_SHM_NUM_FDS];
+    uint8_t   num_received_fds;
+
+    // shared memory transport
+    socket_connection_shm_state_t  shm_state;
+    socket_connection_shm_header_t * shm_header;
+    uint32_t  shm_size;
+    uint32_t  shm_ring_size;
+    socket_connection_shm_ring_t * shm_rx_ring;
+    uint8_t * shm_rx_data;
+    socket_connection_shm_ring_t * shm_tx_ring;
+    uint8_t * shm_tx_data;
+    int       shm_peer_doorbell_fd;
+    socket_connection_doorbell_t shm_doorbell;
+    // queued bytes up to and including setup complete that are sent over the socket
+    uint32_t  shm_socket_bytes_pending;
+#endif
 };
 
 /** list of socket connections */
@@ -143,6 +244,9 @@ static btstack_linked_list_t parked = NULL;
 static int tcp_socket_fd;
 #endif
 
+static uint32_t socket_connection_output_queue_size = SOCKET_CONNECTION_OUTPUT_QUEUE_SIZE;
+static socket_connection_overflow_policy_t socket_connection_overflow_policy = SOCKET_CONNECTION_OVERFLOW_DISCONNECT;
+
 /** client packet handler */
 
 static int (*socket_connection_packet_callback)(connection_t *connection, uint16_t packet_type, uint16_t channel, uint8_t *data, uint16_t length) = socket_connection_dummy_handler;
@@ -156,6 +260,256 @@ static int socket_connection_dummy_handler(connection_t *connection, uint16_t pa
     return 0;
 }
 
+#ifdef SOCKET_CONNECTION_SHARED_MEMORY
+
+// MARK: shared memory transport
+
+static void socket_connection_shm_close_received_fds(connection_t * conn){
+    uint8_t i;
+    for (i = 0; i < conn->num_received_fds; i++){
+        close(conn->received_fds[i]);
+    }
+    conn->num_received_fds = 0;
+}
+
+static void socket_connection_shm_ring_doorbell(int fd){
+    uint64_t value = 1;
+    ssize_t res = write(fd, &value, sizeof(value));
+    UNUSED(res);
+}
+
+static void socket_connection_shm_clear_doorbell(int fd){
+    uint64_t value;
+    ssize_t res = read(fd, &value, sizeof(value));
+    UNUSED(res);
+}
+
+static uint32_t socket_connection_shm_ring_write(connection_t * conn, const uint8_t * data, uint32_t len){
+    socket_connection_shm_ring_t * ring = conn->shm_tx_ring;
+    uint32_t head = ring->head;
+    uint32_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+    uint32_t bytes_free = conn->shm_ring_size - (head - tail);
+    uint32_t bytes_to_write = btstack_min(len, bytes_free);
+    uint32_t pos = head & (conn->shm_ring_size - 1);
+    uint32_t bytes_first = btstack_min(bytes_to_write, conn->shm_ring_size - pos);
+    memcpy(&conn->shm_tx_data[pos], data, bytes_first);
+    memcpy(conn->shm_tx_data, &data[bytes_first], bytes_to_write - bytes_first);
+    __atomic_store_n(&ring->head, head + bytes_to_write, __ATOMIC_RELEASE);
+    return bytes_to_write;
+}
+
+static uint32_t socket_connection_shm_ring_read(connection_t * conn, uint8_t * data, uint32_t len){
+    socket_connection_shm_ring_t * ring = conn->shm_rx_ring;
+    uint32_t tail = ring->tail;
+    uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    uint32_t bytes_to_read = btstack_min(len, head - tail);
+    uint32_t pos = tail & (conn->shm_ring_size - 1);
+    uint32_t bytes_first = btstack_min(bytes_to_read, conn->shm_ring_size - pos);
+    memcpy(data, &conn->shm_rx_data[pos], bytes_first);
+    memcpy(&data[bytes_first], conn->shm_rx_data, bytes_to_read - bytes_first);
+    __atomic_store_n(&ring->tail, tail + bytes_to_read, __ATOMIC_RELEASE);
+    return bytes_to_read;
+}
+
+// wake up peer if it waits for data, only the first producer after the peer went to sleep rings the doorbell
+static void socket_connection_shm_notify_consumer(connection_t * conn){
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_exchange_n(&conn->shm_tx_ring->consumer_waiting, 0, __ATOMIC_SEQ_CST)){
+        socket_connection_shm_ring_doorbell(conn->shm_peer_doorbell_fd);
+    }
+}
+
+static void socket_connection_shm_notify_producer(connection_t * conn){
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_exchange_n(&conn->shm_rx_ring->producer_waiting, 0, __ATOMIC_SEQ_CST)){
+        socket_connection_shm_ring_doorbell(conn->shm_peer_doorbell_fd);
+    }
+}
+
+// request doorbell when space becomes available in tx ring
+static void socket_connection_shm_request_space_notification(connection_t * conn){
+    __atomic_store_n(&conn->shm_tx_ring->producer_waiting, 1, __ATOMIC_SEQ_CST);
+    // space might have become available before flag was set
+    uint32_t tail = __atomic_load_n(&conn->shm_tx_ring->tail, __ATOMIC_SEQ_CST);
+    if ((conn->shm_tx_ring->head - tail) < conn->shm_ring_size){
+        socket_connection_shm_ring_doorbell(conn->shm_doorbell.ds.source.fd);
+    }
+}
+
+static ssize_t socket_connection_shm_writev(connection_t * conn, const struct iovec * iov, int iovcnt){
+    uint32_t bytes_written = 0;
+    int i;
+    for (i = 0; i < iovcnt; i++){
+        uint32_t len = (uint32_t) iov[i].iov_len;
+        uint32_t res = socket_connection_shm_ring_write(conn, (const uint8_t *) iov[i].iov_base, len);
+        bytes_written += res;
+        if (res < len) break;
+    }
+    if (bytes_written == 0){
+        errno = EAGAIN;
+        return -1;
+    }
+    socket_connection_shm_notify_consumer(conn);
+    return (ssize_t) bytes_written;
+}
+
+static void socket_connection_shm_start_doorbell(connection_t * conn, int doorbell_fd){
+    conn->shm_doorbell.connection = conn;
+    btstack_run_loop_set_data_source_fd(&conn->shm_doorbell.ds, doorbell_fd);
+    btstack_run_loop_set_data_source_handler(&conn->shm_doorbell.ds, &socket_connection_shm_process);
+    btstack_run_loop_enable_data_source_callbacks(&conn->shm_doorbell.ds, DATA_SOURCE_CALLBACK_READ);
+    btstack_run_loop_add_data_source(&conn->shm_doorbell.ds);
+}
+
+static void socket_connection_shm_free(connection_t * conn){
+    socket_connection_shm_close_received_fds(conn);
+    if (conn->shm_doorbell.connection != NULL){
+        btstack_run_loop_remove_data_source(&conn->shm_doorbell.ds);
+        close(conn->shm_doorbell.ds.source.fd);
+        close(conn->shm_peer_doorbell_fd);
+        conn->shm_doorbell.connection = NULL;
+    }
+    if (conn->shm_header != NULL){
+        munmap(conn->shm_header, conn->shm_size);
+        conn->shm_header = NULL;
+    }
+}
+
+static void socket_connection_shm_map_rings(connection_t * conn, bool is_client){
+    uint8_t * data = ((uint8_t *) conn->shm_header) + sizeof(socket_connection_shm_header_t);
+    uint8_t rx_index = is_client ? 1 : 0;
+    uint8_t tx_index = 1 - rx_index;
+    conn->shm_rx_ring = &conn->shm_header->rings[rx_index];
+    conn->shm_rx_data = &data[rx_index * conn->shm_ring_size];
+    conn->shm_tx_ring = &conn->shm_header->rings[tx_index];
+    conn->shm_tx_data = &data[tx_index * conn->shm_ring_size];
+}
+
+// switch to rings, socket is only used to detect closed connection afterwards
+static void socket_connection_shm_activate(connection_t * conn){
+    conn->shm_state = SOCKET_CONNECTION_SHM_ACTIVE;
+    btstack_run_loop_disable_data_source_callbacks(&conn->ds, DATA_SOURCE_CALLBACK_WRITE);
+    btstack_run_loop_enable_data_source_callbacks(&conn->ds, DATA_SOURCE_CALLBACK_READ);
+    // peer might have sent data already, send queued data
+    socket_connection_shm_ring_doorbell(conn->shm_doorbell.ds.source.fd);
+}
+
+// daemon: map shared memory provided by client
+static uint8_t socket_connection_shm_handle_setup(connection_t * conn, const uint8_t * packet, uint16_t size){
+    if (conn->shm_state != SOCKET_CONNECTION_SHM_IDLE) return ERROR_CODE_COMMAND_DISALLOWED;
+    if (conn->output_buffer == NULL) return ERROR_CODE_COMMAND_DISALLOWED;
+    if (size < 4) return ERROR_CODE_INVALID_HCI_COMMAND_PARAMETERS;
+    if (conn->num_received_fds != SOCKET_CONNECTION_SHM_NUM_FDS) return ERROR_CODE_INVALID_HCI_COMMAND_PARAMETERS;
+    // switch only if all data has been sent over socket, setup complete is the last packet over the socket
+    socket_connection_flush(conn);
+    if (conn->output_bytes_queued > 0) return ERROR_CODE_CONTROLLER_BUSY;
+
+    uint32_t ring_size = little_endian_read_32(packet, 0);
+    if ((ring_size < sizeof(conn->buffer)) || ((ring_size & (ring_size - 1)) != 0)) return ERROR_CODE_INVALID_HCI_COMMAND_PARAMETERS;
+    uint32_t shm_size = sizeof(socket_connection_shm_header_t) + 2 * ring_size;
+
+    int memfd = conn->received_fds[0];
+    // client must not be able to shrink memfd after mmap, access beyond its end would raise SIGBUS
+    int seals = fcntl(memfd, F_GET_SEALS);
+    if ((seals < 0) || ((seals & (F_SEAL_SHRINK | F_SEAL_GROW)) != (F_SEAL_SHRINK | F_SEAL_GROW))) return ERROR_CODE_INVALID_HCI_COMMAND_PARAMETERS;
+    struct stat st;
+    if ((fstat(memfd, &st) < 0) || (st.st_size < (off_t) shm_size)) return ERROR_CODE_INVALID_HCI_COMMAND_PARAMETERS;
+    void * shm = mmap(NULL, shm_size, PROT_READ | PROT_WRITE, MAP_SHARED, memfd, 0);
+    if (shm == MAP_FAILED) return ERROR_CODE_MEMORY_CAPACITY_EXCEEDED;
+    socket_connection_shm_header_t * header = (socket_connection_shm_header_t *) shm;
+    if ((header->magic != SOCKET_CONNECTION_SHM_MAGIC) || (header->version != SOCKET_CONNECTION_SHM_VERSION) || (header->ring_size != ring_size)){
+        munmap(shm, shm_size);
+        return ERROR_CODE_INVALID_HCI_COMMAND_PARAMETERS;
+    }
+
+    conn->shm_header = header;
+    conn->shm_size = shm_size;
+    conn->shm_ring_size = ring_size;
+    socket_connection_shm_map_rings(conn, false);
+
+    // memfd not needed after mmap
+    close(memfd);
+    conn->shm_peer_doorbell_fd = conn->received_fds[2];
+    socket_connection_shm_start_doorbell(conn, conn->received_fds[1]);
+    conn->num_received_fds = 0;
+    return ERROR_CODE_SUCCESS;
+}
+
+/**
+ * handle shared memory setup packets
+ * @returns true if packet was consumed
+ */
+static bool socket_connection_shm_handle_packet(connection_t * conn, uint16_t packet_type, uint8_t * packet, uint16_t size){
+    uint8_t status;
+    switch (packet_type){
+        case SOCKET_CONNECTION_SHM_SETUP_PACKET:
+            status = socket_connection_shm_handle_setup(conn, packet, size);
+            socket_connection_shm_close_received_fds(conn);
+            log_info("socket_connection %p: shared memory setup, status 0x%02x", conn, status);
+            socket_connection_send_packet(conn, SOCKET_CONNECTION_SHM_SETUP_COMPLETE_PACKET, 0, &status, 1);
+            if (status == ERROR_CODE_SUCCESS){
+                // setup complete is the last packet sent over the socket
+                conn->shm_socket_bytes_pending = conn->output_bytes_queued;
+                if (conn->shm_socket_bytes_pending == 0){
+                    socket_connection_shm_activate(conn);
+                } else {
+                    conn->shm_state = SOCKET_CONNECTION_SHM_W4_SOCKET_FLUSH;
+                }
+            }
+            return true;
+        case SOCKET_CONNECTION_SHM_SETUP_COMPLETE_PACKET:
+            if (conn->shm_state != SOCKET_CONNECTION_SHM_W4_SETUP_COMPLETE) return true;
+            if ((size >= 1) && (packet[0] == ERROR_CODE_SUCCESS)){
+                socket_connection_shm_activate(conn);
+            } else {
+                log_info("socket_connection %p: shared memory rejected, status 0x%02x", conn, size ? packet[0] : 0);
+                conn->shm_state = SOCKET_CONNECTION_SHM_FAILED;
+                socket_connection_shm_free(conn);
+            }
+            return true;
+        default:
+            // drop file descriptors sent with other packets
+            socket_connection_shm_close_received_fds(conn);
+            return false;
+    }
+}
+
+static ssize_t socket_connection_read(connection_t * conn, int fd, uint8_t * buffer, uint16_t len){
+    // receive file descriptors for shared memory setup
+    union {
+        struct cmsghdr header;
+        uint8_t buffer[CMSG_SPACE(SOCKET_CONNECTION_SHM_NUM_FDS * sizeof(int))];
+    } control;
+    struct iovec iov;
+    iov.iov_base = buffer;
+    iov.iov_len = len;
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buffer;
+    msg.msg_controllen = sizeof(control.buffer);
+    ssize_t res = recvmsg(fd, &msg, MSG_CMSG_CLOEXEC);
+    if (res <= 0) return res;
+    struct cmsghdr * cmsg;
+    for (cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL; cmsg = CMSG_NXTHDR(&msg, cmsg)){
+        if ((cmsg->cmsg_level != SOL_SOCKET) || (cmsg->cmsg_type != SCM_RIGHTS)) continue;
+        uint16_t num_fds = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+        uint16_t i;
+        for (i = 0; i < num_fds; i++){
+            int fd;
+            memcpy(&fd, CMSG_DATA(cmsg) + i * sizeof(int), sizeof(int));
+            if (conn->num_received_fds < SOCKET_CONNECTION_SHM_NUM_FDS){
+                conn->received_fds[conn->num_received_fds++] = fd;
+            } else {
+                close(fd);
+            }
+        }
+    }
+    return res;
+}
+#endif
+
 static void socket_connection_free_connection(connection_t *conn){
     // remove from run_loop 
     btstack_run_loop_remove_data_source(&conn->ds);
@@ -169,7 +523,15 @@ static void socket_connection_free_connection(connection_t *conn){
     }
 #endif
 
+#ifdef SOCKET_CONNECTION_SHARED_MEMORY
+    socket_connection_shm_free(conn);
+#endif
+
     // destroy
+    if (conn->output_buffer){
+        log_info("socket_connection_free_connection %p, %u packets dropped", conn, (unsigned int) conn->output_packets_dropped);
+        free(conn->output_buffer);
+    }
     free(conn);
 }
 
@@ -180,6 +542,35 @@ static void socket_connection_init_statemachine(connection_t *connection){
     connection->bytes_to_read = sizeof(packet_header_t);
 }
 
+#ifndef _WIN32
+static void socket_connection_free_output_queue(connection_t * conn){
+    free(conn->output_buffer);
+    conn->output_buffer = NULL;
+    conn->output_buffer_size = 0;
+    conn->output_bytes_queued = 0;
+    conn->output_read_pos = 0;
+}
+
+static bool socket_connection_alloc_output_queue(connection_t * conn){
+    // queue has to hold at least one packet
+    uint32_t size = btstack_max(socket_connection_output_queue_size, sizeof(conn->buffer));
+    conn->output_buffer = malloc(size);
+    if (conn->output_buffer == NULL) return false;
+    conn->output_buffer_size = size;
+    return true;
+}
+
+// accepted connections use non-blocking sockets with output queue
+static void socket_connection_enable_output_queue(connection_t * conn){
+    if (!socket_connection_alloc_output_queue(conn)){
+        log_error("socket_connection: no memory for output queue, using blocking writes");
+        return;
+    }
+    int flags = fcntl(conn->socket_fd, F_GETFL, 0);
+    fcntl(conn->socket_fd, F_SETFL, flags | O_NONBLOCK);
+}
+#endif
+
 static connection_t * socket_connection_register_new_connection(int fd){
     // create connection objec 
     connection_t * conn = malloc( sizeof(connection_t));
@@ -244,6 +635,13 @@ void socket_connection_hci_process(btstack_data_source_t *socket_ds, btstack_dat
 
     log_debug("socket_connection_hci_process, callback %x", callback_type);
 
+#ifndef _WIN32
+    if (callback_type == DATA_SOURCE_CALLBACK_WRITE){
+        socket_connection_flush(conn);
+        return;
+    }
+#endif
+
     // get socket_fd
     int socket_fd = conn->socket_fd;
 
@@ -262,6 +660,8 @@ void socket_connection_hci_process(btstack_data_source_t *socket_ds, btstack_dat
 #ifdef _WIN32
     int flags = 0;
     int bytes_read = recv(socket_fd, (char*) &conn->buffer[conn->bytes_read], conn->bytes_to_read, flags);
+#elif defined(SOCKET_CONNECTION_SHARED_MEMORY)
+    int bytes_read = (int) socket_connection_read(conn, socket_fd, &conn->buffer[conn->bytes_read], conn->bytes_to_read);
 #else
     int bytes_read = read(socket_fd, &conn->buffer[conn->bytes_read], conn->bytes_to_read);
 #endif
@@ -276,9 +676,17 @@ void socket_connection_hci_process(btstack_data_source_t *socket_ds, btstack_dat
         
         return;
     }
+    socket_connection_received_bytes(conn, (uint16_t) bytes_read);
+}
+
+/**
+ * process received bytes in conn->buffer
+ * @returns true if connection was parked
+ */
+static bool socket_connection_received_bytes(connection_t * conn, uint16_t bytes_read){
     conn->bytes_read += bytes_read;
     conn->bytes_to_read -= bytes_read;
-    if (conn->bytes_to_read > 0) return;
+    if (conn->bytes_to_read > 0) return false;
     
     int dispatch = 0;
     switch (conn->state){
@@ -297,6 +705,13 @@ void socket_connection_hci_process(btstack_data_source_t *socket_ds, btstack_dat
     }
     
     if (dispatch){
+#ifdef SOCKET_CONNECTION_SHARED_MEMORY
+        if (socket_connection_shm_handle_packet(conn, little_endian_read_16( conn->buffer, 0),
+                                                &conn->buffer[sizeof(packet_header_t)], little_endian_read_16( conn->buffer, 4))){
+            socket_connection_init_statemachine(conn);
+            return false;
+        }
+#endif
         // dispatch packet !!! connection, type, channel, data, size
         int dispatch_err = (*socket_connection_packet_callback)(conn, little_endian_read_16( conn->buffer, 0), little_endian_read_16( conn->buffer, 2),
                                                             &conn->buffer[sizeof(packet_header_t)], little_endian_read_16( conn->buffer, 4));
@@ -307,11 +722,51 @@ void socket_connection_hci_process(btstack_data_source_t *socket_ds, btstack_dat
         // "park" if dispatch failed
         if (dispatch_err) {
             log_info("socket_connection_hci_process dispatch failed -> park connection");
-            btstack_run_loop_remove_data_source(socket_ds);
-            btstack_linked_list_add_tail(&parked, (btstack_linked_item_t *) socket_ds);
+            btstack_run_loop_remove_data_source(&conn->ds);
+#ifdef SOCKET_CONNECTION_SHARED_MEMORY
+            if (conn->shm_doorbell.connection != NULL){
+                btstack_run_loop_remove_data_source(&conn->shm_doorbell.ds);
+            }
+#endif
+            btstack_linked_list_add_tail(&parked, (btstack_linked_item_t *) &conn->ds);
+            return true;
+        }
+    }
+    return false;
+}
+
+#ifdef SOCKET_CONNECTION_SHARED_MEMORY
+static void socket_connection_shm_process(btstack_data_source_t *ds, btstack_data_source_callback_type_t callback_type){
+    UNUSED(callback_type);
+    connection_t * conn = ((socket_connection_doorbell_t *) ds)->connection;
+    socket_connection_shm_clear_doorbell(ds->source.fd);
+    if (conn->shm_state != SOCKET_CONNECTION_SHM_ACTIVE) return;
+
+    // send queued data
+    if (conn->output_bytes_queued > 0){
+        socket_connection_flush(conn);
+    }
+
+    // doorbell is rung again when input is resumed
+    if (conn->input_paused) return;
+
+    // receive until ring is empty, connection was parked or input was paused
+    while (true){
+        uint32_t bytes_read = socket_connection_shm_ring_read(conn, &conn->buffer[conn->bytes_read], conn->bytes_to_read);
+        if (bytes_read == 0){
+            // request doorbell and check again to not miss data written in between
+            __atomic_store_n(&conn->shm_rx_ring->consumer_waiting, 1, __ATOMIC_SEQ_CST);
+            uint32_t head = __atomic_load_n(&conn->shm_rx_ring->head, __ATOMIC_SEQ_CST);
+            if (head == conn->shm_rx_ring->tail) break;
+            __atomic_store_n(&conn->shm_rx_ring->consumer_waiting, 0, __ATOMIC_SEQ_CST);
+            continue;
         }
+        socket_connection_shm_notify_producer(conn);
+        if (socket_connection_received_bytes(conn, (uint16_t) bytes_read)) break;
+        if (conn->input_paused) break;
     }
 }
+#endif
 
 /**
  * try to dispatch packet for all "parked" connections. 
@@ -323,7 +778,14 @@ void socket_connection_retry_parked(void){
     btstack_linked_item_t *it = (btstack_linked_item_t *) &parked;
     while (it->next) {
         connection_t * conn = (connection_t *) it->next;
-        
+
+#ifndef _WIN32
+        // parked connections don't get write callbacks
+        if (conn->output_bytes_queued > 0){
+            socket_connection_flush(conn);
+        }
+#endif
+
         // dispatch packet !!! connection, type, channel, data, size
         uint16_t packet_type = little_endian_read_16( conn->buffer, 0);
         uint16_t channel     = little_endian_read_16( conn->buffer, 2);
@@ -335,6 +797,13 @@ void socket_connection_retry_parked(void){
             log_info("socket_connection_hci_process dispatch succeeded -> un-park connection %p", conn);
             it->next = it->next->next;
             btstack_run_loop_add_data_source( (btstack_data_source_t *) conn);
+#ifdef SOCKET_CONNECTION_SHARED_MEMORY
+            if (conn->shm_doorbell.connection != NULL){
+                btstack_run_loop_add_data_source(&conn->shm_doorbell.ds);
+                // process remaining data in ring from run loop
+                socket_connection_shm_ring_doorbell(conn->shm_doorbell.ds.source.fd);
+            }
+#endif
         } else {
             it = it->next;
         }
@@ -376,6 +845,13 @@ static void socket_connection_accept(btstack_data_source_t *socket_ds, btstack_d
     log_info("socket_connection_accept new connection %u", fd);
     
     connection_t * connection = socket_connection_register_new_connection(fd);
+    if (connection == NULL) {
+        close(fd);
+        return;
+    }
+#ifndef _WIN32
+    socket_connection_enable_output_queue(connection);
+#endif
     socket_connection_emit_connection_opened(connection);
 }
 
@@ -555,6 +1031,233 @@ void socket_connection_register_packet_callback( int (*packet_callback)(connecti
     socket_connection_packet_callback = packet_callback;
 }
 
+/**
+ * configure output queue for accepted connections
+ */
+void socket_connection_set_output_queue(uint32_t queue_size, socket_connection_overflow_policy_t overflow_policy){
+    socket_connection_output_queue_size = queue_size;
+    socket_connection_overflow_policy = overflow_policy;
+}
+
+#ifndef _WIN32
+
+// write all data, returns false if socket is broken
+static bool socket_connection_writev_blocking(int fd, struct iovec * iov, int iovcnt){
+    while (iovcnt > 0){
+        ssize_t res = writev(fd, iov, iovcnt);
+        if (res < 0){
+            if (errno == EINTR) continue;
+            return false;
+        }
+        // skip written data
+        while ((iovcnt > 0) && ((size_t) res >= iov->iov_len)){
+            res -= iov->iov_len;
+            iov++;
+            iovcnt--;
+        }
+        if (iovcnt > 0){
+            iov->iov_base = ((uint8_t *) iov->iov_base) + res;
+            iov->iov_len -= res;
+        }
+    }
+    return true;
+}
+
+// write without blocking, returns -1 with errno EAGAIN if no data could be written
+static ssize_t socket_connection_writev_nonblocking(connection_t * conn, const struct iovec * iov, int iovcnt){
+#ifdef SOCKET_CONNECTION_SHARED_MEMORY
+    if (conn->shm_state == SOCKET_CONNECTION_SHM_ACTIVE){
+        return socket_connection_shm_writev(conn, iov, iovcnt);
+    }
+#endif
+    return writev(conn->socket_fd, iov, iovcnt);
+}
+
+// get notified when data can be written again
+static void socket_connection_set_write_notification(connection_t * conn, bool enabled){
+#ifdef SOCKET_CONNECTION_SHARED_MEMORY
+    if (conn->shm_state == SOCKET_CONNECTION_SHM_ACTIVE){
+        if (enabled){
+            socket_connection_shm_request_space_notification(conn);
+        } else {
+            __atomic_store_n(&conn->shm_tx_ring->producer_waiting, 0, __ATOMIC_SEQ_CST);
+        }
+        return;
+    }
+#endif
+    if (enabled){
+        btstack_run_loop_enable_data_source_callbacks(&conn->ds, DATA_SOURCE_CALLBACK_WRITE);
+    } else {
+        btstack_run_loop_disable_data_source_callbacks(&conn->ds, DATA_SOURCE_CALLBACK_WRITE);
+    }
+}
+
+// stop reading from client while it does not accept data
+static void socket_connection_set_input_paused(connection_t * conn, bool paused){
+    if (conn->input_paused == (paused ? 1 : 0)) return;
+    log_info("socket_connection %p: %s input, %u bytes queued", conn, paused ? "pause" : "resume", (unsigned int) conn->output_bytes_queued);
+    conn->input_paused = paused ? 1 : 0;
+#ifdef SOCKET_CONNECTION_SHARED_MEMORY
+    if (conn->shm_state == SOCKET_CONNECTION_SHM_ACTIVE){
+        // socket is only used to detect closed connection
+        if (!paused){
+            // process data received in the meantime from run loop
+            socket_connection_shm_ring_doorbell(conn->shm_doorbell.ds.source.fd);
+        }
+        return;
+    }
+#endif
+    if (paused){
+        btstack_run_loop_disable_data_source_callbacks(&conn->ds, DATA_SOURCE_CALLBACK_READ);
+    } else {
+        btstack_run_loop_enable_data_source_callbacks(&conn->ds, DATA_SOURCE_CALLBACK_READ);
+    }
+}
+
+static void socket_connection_output_enqueue(connection_t * conn, const uint8_t * data, uint32_t len){
+    uint32_t write_pos = (conn->output_read_pos + conn->output_bytes_queued) % conn->output_buffer_size;
+    uint32_t bytes_till_end = conn->output_buffer_size - write_pos;
+    uint32_t bytes_first = btstack_min(len, bytes_till_end);
+    memcpy(&conn->output_buffer[write_pos], data, bytes_first);
+    memcpy(conn->output_buffer, &data[bytes_first], len - bytes_first);
+    conn->output_bytes_queued += len;
+}
+
+static void socket_connection_output_close(connection_t * conn){
+    // drop queued data and let read path detect the closed socket
+    conn->output_closed = 1;
+    conn->output_bytes_queued = 0;
+    conn->output_read_pos = 0;
+    socket_connection_set_write_notification(conn, false);
+    socket_connection_set_input_paused(conn, false);
+    shutdown(conn->socket_fd, SHUT_RDWR);
+}
+
+/**
+ * send queued data without blocking, returns false if socket is broken
+ */
+static bool socket_connection_flush(connection_t * conn){
+    while (conn->output_bytes_queued > 0){
+        uint32_t bytes_to_send = conn->output_bytes_queued;
+#ifdef SOCKET_CONNECTION_SHARED_MEMORY
+        // send data up to shared memory setup complete over socket
+        if (conn->shm_state == SOCKET_CONNECTION_SHM_W4_SOCKET_FLUSH){
+            bytes_to_send = conn->shm_socket_bytes_pending;
+        }
+#endif
+        struct iovec iov[2];
+        int iovcnt = 1;
+        uint32_t bytes_till_end = conn->output_buffer_size - conn->output_read_pos;
+        iov[0].iov_base = &conn->output_buffer[conn->output_read_pos];
+        iov[0].iov_len  = btstack_min(bytes_to_send, bytes_till_end);
+        if (bytes_to_send > bytes_till_end){
+            iov[1].iov_base = conn->output_buffer;
+            iov[1].iov_len  = bytes_to_send - bytes_till_end;
+            iovcnt = 2;
+        }
+        ssize_t res = socket_connection_writev_nonblocking(conn, iov, iovcnt);
+        if (res < 0){
+            if (errno == EINTR) continue;
+            if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) break;
+            log_info("socket_connection_flush %p: write error %s", conn, strerror(errno));
+            socket_connection_output_close(conn);
+            return false;
+        }
+        conn->output_read_pos = (conn->output_read_pos + (uint32_t) res) % conn->output_buffer_size;
+        conn->output_bytes_queued -= (uint32_t) res;
+#ifdef SOCKET_CONNECTION_SHARED_MEMORY
+        if (conn->shm_state == SOCKET_CONNECTION_SHM_W4_SOCKET_FLUSH){
+            conn->shm_socket_bytes_pending -= (uint32_t) res;
+            if (conn->shm_socket_bytes_pending == 0){
+                socket_connection_shm_activate(conn);
+            }
+        }
+#endif
+    }
+    if (conn->output_bytes_queued == 0){
+        conn->output_read_pos = 0;
+        socket_connection_set_write_notification(conn, false);
+    } else {
+        socket_connection_set_write_notification(conn, true);
+    }
+    // resume reading from client when most of the queue has been sent
+    if (conn->input_paused && (conn->output_bytes_queued <= (conn->output_buffer_size / 4))){
+        socket_connection_set_input_paused(conn, false);
+    }
+    return true;
+}
+
+/**
+ * apply overflow policy, returns true if packet can be queued
+ */
+static bool socket_connection_handle_overflow(connection_t * conn, uint32_t len){
+    switch (socket_connection_overflow_policy){
+        case SOCKET_CONNECTION_OVERFLOW_DISCONNECT:
+            log_error("socket_connection %p: output queue full -> disconnect", conn);
+            socket_connection_output_close(conn);
+            return false;
+        case SOCKET_CONNECTION_OVERFLOW_BACKPRESSURE:
+            // input is paused, client still did not accept data, e.g. for events not requested by the client
+        case SOCKET_CONNECTION_OVERFLOW_DROP:
+        default:
+            if (conn->output_packets_dropped == 0){
+                log_error("socket_connection %p: output queue full -> drop packets", conn);
+            }
+            conn->output_packets_dropped++;
+            return false;
+    }
+}
+
+static void socket_connection_send_packet_queued(connection_t *conn, uint8_t * header, uint8_t *packet, uint16_t size){
+    if (conn->output_closed) return;
+
+    uint32_t packet_len = sizeof(packet_header_t) + size;
+
+    // send pending data first
+    if (conn->output_bytes_queued > 0){
+        if (!socket_connection_flush(conn)) return;
+    }
+
+    uint32_t bytes_written = 0;
+    if (conn->output_bytes_queued == 0){
+        struct iovec iov[2];
+        iov[0].iov_base = header;
+        iov[0].iov_len  = sizeof(packet_header_t);
+        iov[1].iov_base = packet;
+        iov[1].iov_len  = size;
+        ssize_t res;
+        do {
+            res = socket_connection_writev_nonblocking(conn, iov, 2);
+        } while ((res < 0) && (errno == EINTR));
+        if (res < 0){
+            // broken socket is detected by read
+            if ((errno != EAGAIN) && (errno != EWOULDBLOCK)) return;
+            res = 0;
+        }
+        bytes_written = (uint32_t) res;
+        if (bytes_written == packet_len) return;
+    } else if ((conn->output_buffer_size - conn->output_bytes_queued) < packet_len){
+        if (!socket_connection_handle_overflow(conn, packet_len)) return;
+    }
+
+    // queue remaining part of packet, queue has room for a full packet if it was empty
+    if (bytes_written < sizeof(packet_header_t)){
+        socket_connection_output_enqueue(conn, &header[bytes_written], sizeof(packet_header_t) - bytes_written);
+        socket_connection_output_enqueue(conn, packet, size);
+    } else {
+        uint32_t packet_offset = bytes_written - sizeof(packet_header_t);
+        socket_connection_output_enqueue(conn, &packet[packet_offset], size - packet_offset);
+    }
+    socket_connection_set_write_notification(conn, true);
+
+    // stop reading commands from client if it does not keep up with the responses
+    if ((socket_connection_overflow_policy == SOCKET_CONNECTION_OVERFLOW_BACKPRESSURE) && (conn->output_bytes_queued > (conn->output_buffer_size / 2))){
+        socket_connection_set_input_paused(conn, true);
+    }
+}
+
+#endif
+
 /**
  * send HCI packet to single connection
  */
@@ -563,17 +1266,25 @@ void socket_connection_send_packet(connection_t *conn, uint16_t type, uint16_t c
     little_endian_store_16(header, 0, type);
     little_endian_store_16(header, 2, channel);
     little_endian_store_16(header, 4, size);
+#ifdef _WIN32
     // avoid -Wunused-result
     int res;
-#ifdef _WIN32
     int flags = 0;
     res = send(conn->socket_fd, (const char *) header, 6, flags);
     res = send(conn->socket_fd, (const char *) packet, size, flags);
+    UNUSED(res);
 #else
-    res = write(conn->socket_fd, header, 6);
-    res = write(conn->socket_fd, packet, size);
+    if (conn->output_buffer != NULL){
+        socket_connection_send_packet_queued(conn, header, packet, size);
+        return;
+    }
+    struct iovec iov[2];
+    iov[0].iov_base = header;
+    iov[0].iov_len  = sizeof(packet_header_t);
+    iov[1].iov_base = packet;
+    iov[1].iov_len  = size;
+    socket_connection_writev_blocking(conn->socket_fd, iov, 2);
 #endif
-    UNUSED(res);
 }
 
 /**
@@ -726,6 +1437,117 @@ int socket_connection_close_unix(connection_t * connection){
 
 #endif /* HAVE_UNIX_SOCKETS */
 
+#ifdef SOCKET_CONNECTION_SHARED_MEMORY
+/**
+ * setup shared memory transport to BTdaemon
+ */
+int socket_connection_enable_shared_memory(connection_t * connection, uint32_t ring_size){
+    if (connection == NULL) return -1;
+    if (connection->shm_state != SOCKET_CONNECTION_SHM_IDLE) return -1;
+    if (ring_size == 0){
+        ring_size = SOCKET_CONNECTION_SHARED_MEMORY_RING_SIZE;
+    }
+    if ((ring_size < sizeof(connection->buffer)) || ((ring_size & (ring_size - 1)) != 0)) return -1;
+
+    // packets that don't fit into the ring are queued until BTdaemon consumed data
+    if (connection->output_buffer != NULL) return -1;
+    if (!socket_connection_alloc_output_queue(connection)) return -1;
+
+    // create shared memory with fixed size and doorbells
+    uint32_t shm_size = sizeof(socket_connection_shm_header_t) + 2 * ring_size;
+    int memfd = memfd_create("btstack", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    int doorbell_daemon = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    int doorbell_client = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    void * shm = MAP_FAILED;
+    if ((memfd >= 0) && (doorbell_daemon >= 0) && (doorbell_client >= 0) && (ftruncate(memfd, shm_size) == 0)
+    && (fcntl(memfd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) == 0)){
+        shm = mmap(NULL, shm_size, PROT_READ | PROT_WRITE, MAP_SHARED, memfd, 0);
+    }
+    if (shm == MAP_FAILED){
+        socket_connection_free_output_queue(connection);
+        if (memfd >= 0) close(memfd);
+        if (doorbell_daemon >= 0) close(doorbell_daemon);
+        if (doorbell_client >= 0) close(doorbell_client);
+        return -1;
+    }
+
+    socket_connection_shm_header_t * header = (socket_connection_shm_header_t *) shm;
+    memset(header, 0, sizeof(socket_connection_shm_header_t));
+    header->magic = SOCKET_CONNECTION_SHM_MAGIC;
+    header->version = SOCKET_CONNECTION_SHM_VERSION;
+    header->ring_size = ring_size;
+    header->rings[0].consumer_waiting = 1;
+    header->rings[1].consumer_waiting = 1;
+
+    connection->shm_header = header;
+    connection->shm_size = shm_size;
+    connection->shm_ring_size = ring_size;
+    connection->shm_peer_doorbell_fd = doorbell_daemon;
+    socket_connection_shm_map_rings(connection, true);
+    socket_connection_shm_start_doorbell(connection, doorbell_client);
+
+    // send setup packet with memfd and doorbells
+    uint8_t packet[sizeof(packet_header_t) + 4];
+    little_endian_store_16(packet, 0, SOCKET_CONNECTION_SHM_SETUP_PACKET);
+    little_endian_store_16(packet, 2, 0);
+    little_endian_store_16(packet, 4, 4);
+    little_endian_store_32(packet, 6, ring_size);
+    int fds[SOCKET_CONNECTION_SHM_NUM_FDS] = { memfd, doorbell_daemon, doorbell_client };
+    union {
+        struct cmsghdr header;
+        uint8_t buffer[CMSG_SPACE(sizeof(fds))];
+    } control;
+    memset(&control, 0, sizeof(control));
+    struct iovec iov;
+    iov.iov_base = packet;
+    iov.iov_len = sizeof(packet);
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buffer;
+    msg.msg_controllen = sizeof(control.buffer);
+    struct cmsghdr * cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(fds));
+    memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+    ssize_t res = sendmsg(connection->socket_fd, &msg, 0);
+    close(memfd);
+    if (res != (ssize_t) sizeof(packet)){
+        socket_connection_shm_free(connection);
+        socket_connection_free_output_queue(connection);
+        return -1;
+    }
+
+    // process packets until setup complete, BTdaemon does not use the socket afterwards
+    connection->shm_state = SOCKET_CONNECTION_SHM_W4_SETUP_COMPLETE;
+    while (connection->shm_state == SOCKET_CONNECTION_SHM_W4_SETUP_COMPLETE){
+        ssize_t bytes_read = read(connection->socket_fd, &connection->buffer[connection->bytes_read], connection->bytes_to_read);
+        if (bytes_read < 0 && errno == EINTR) continue;
+        if (bytes_read <= 0) {
+            // closed socket is detected by run loop
+            connection->shm_state = SOCKET_CONNECTION_SHM_FAILED;
+            socket_connection_shm_free(connection);
+            break;
+        }
+        socket_connection_received_bytes(connection, (uint16_t) bytes_read);
+    }
+    log_info("socket_connection_enable_shared_memory: %s", connection->shm_state == SOCKET_CONNECTION_SHM_ACTIVE ? "active" : "failed");
+    if (connection->shm_state != SOCKET_CONNECTION_SHM_ACTIVE){
+        socket_connection_free_output_queue(connection);
+        return -1;
+    }
+    return 0;
+}
+#else
+int socket_connection_enable_shared_memory(connection_t * connection, uint32_t ring_size){
+    UNUSED(connection);
+    UNUSED(ring_size);
+    return -1;
+}
+#endif
+
 /**
  * Init socket connection module
  */
@@ -53,9 +53,26 @@
 extern "C" {
 #endif
 
+// default size of output queue for accepted connections
+#ifndef SOCKET_CONNECTION_OUTPUT_QUEUE_SIZE
+#define SOCKET_CONNECTION_OUTPUT_QUEUE_SIZE 65536
+#endif
+
+// default size of each ring for shared memory transport, power of two
+#ifndef SOCKET_CONNECTION_SHARED_MEMORY_RING_SIZE
+#define SOCKET_CONNECTION_SHARED_MEMORY_RING_SIZE 65536
+#endif
+
 /** opaque connection type */
 typedef struct connection connection_t;
 
+/** handling of packets for a client when its output queue is full */
+typedef enum {
+    SOCKET_CONNECTION_OVERFLOW_DROP = 0,        // drop packet
+    SOCKET_CONNECTION_OVERFLOW_DISCONNECT,      // close connection to client
+    SOCKET_CONNECTION_OVERFLOW_BACKPRESSURE,    // stop reading from client while queue is more than half full, drop packet
+} socket_connection_overflow_policy_t;
+
 /**
  * Init socket connection module
  */
@@ -101,12 +118,30 @@ connection_t * socket_connection_open_unix(void);
  */
 int socket_connection_close_unix(connection_t *connection);
 
+/**
+ * switch unix connection to BTdaemon to shared memory rings with eventfd doorbells, Linux only.
+ * Packets received before the BTdaemon confirmed the setup are dispatched to the packet callback.
+ * The memfd is sealed against resizing. Packets that don't fit into the ring are queued and
+ * sent when the BTdaemon consumed data, using the output queue size and overflow policy.
+ * @param connection
+ * @param ring_size in bytes for each direction, power of two, 0 for default
+ * @return 0 if shared memory transport is active
+ */
+int socket_connection_enable_shared_memory(connection_t *connection, uint32_t ring_size);
+
 /**
  * set packet handler for all auto-accepted connections 
  * -- packet_callback @return: 0 == OK/NO ERROR
  */
 void socket_connection_register_packet_callback( int (*packet_callback)(connection_t *connection, uint16_t packet_type, uint16_t channel, uint8_t *data, uint16_t length) );
 
+/**
+ * configure output queue for connections accepted afterwards. Sockets of accepted connections are non-blocking,
+ * data that cannot be sent right away is queued and sent when the socket becomes writable.
+ * Default: SOCKET_CONNECTION_OUTPUT_QUEUE_SIZE, SOCKET_CONNECTION_OVERFLOW_DISCONNECT
+ */
+void socket_connection_set_output_queue(uint32_t queue_size, socket_connection_overflow_policy_t overflow_policy);
+
 /**
  * send HCI packet to single connection
  */
@@ -58,6 +58,7 @@
 #include "btstack_run_loop.h"
 #include "btstack_run_loop_embedded.h"
 #include "btstack_linked_list.h"
+#include "btstack_stats.h"
 #include "btstack_util.h"
 #include "hal_tick.h"
 #include "hal_cpu.h"
@@ -91,6 +92,9 @@ static volatile uint32_t system_ticks;
 
 static int trigger_event_received = 0;
 
+// callbacks queued from ISRs or other contexts, protected by disabling IRQs
+static btstack_linked_list_t callbacks;
+
 /**
  * Add data_source to run_loop
  */
@@ -179,6 +183,8 @@ static void btstack_run_loop_embedded_disable_data_source_callbacks(btstack_data
 void btstack_run_loop_embedded_execute_once(void) {
     btstack_data_source_t *ds;
 
+    BTSTACK_STATS_INCREMENT(RUN_LOOP_ITERATIONS);
+
     // process data sources
     btstack_data_source_t *next;
     for (ds = (btstack_data_source_t *) data_sources; ds != NULL ; ds = next){
@@ -187,6 +193,18 @@ void btstack_run_loop_embedded_execute_once(void) {
             ds->process(ds, DATA_SOURCE_CALLBACK_POLL);
         }
     }
+
+    // process callbacks queued until now as one batch
+    hal_cpu_disable_irqs();
+    btstack_linked_item_t * batch = callbacks;
+    callbacks = NULL;
+    hal_cpu_enable_irqs();
+    while (batch != NULL){
+        btstack_context_callback_registration_t * callback_registration = (btstack_context_callback_registration_t *) batch;
+        // get next before calling callback, as registration can be queued again by the callback
+        batch = batch->next;
+        (*callback_registration->callback)(callback_registration->context);
+    }
     
 #ifdef TIMER_SUPPORT
 
@@ -204,6 +222,11 @@ void btstack_run_loop_embedded_execute_once(void) {
         if (delta > 0) break;
 
         btstack_run_loop_embedded_remove_timer(ts);
+#ifdef HAVE_EMBEDDED_TICK
+        BTSTACK_STATS_TIMER_PROCESSED((uint32_t) -delta * hal_tick_get_tick_period_in_ms());
+#else
+        BTSTACK_STATS_TIMER_PROCESSED((uint32_t) -delta);
+#endif
         ts->process(ts);
     }
 #endif
@@ -260,8 +283,16 @@ void btstack_run_loop_embedded_trigger(void){
     trigger_event_received = 1;
 }
 
+static void btstack_run_loop_embedded_execute_on_main_thread(btstack_context_callback_registration_t * callback_registration){
+    hal_cpu_disable_irqs();
+    btstack_linked_list_add_tail(&callbacks, (btstack_linked_item_t *) callback_registration);
+    trigger_event_received = 1;
+    hal_cpu_enable_irqs();
+}
+
 static void btstack_run_loop_embedded_init(void){
     data_sources = NULL;
+    callbacks = NULL;
 
 #ifdef TIMER_SUPPORT
     timers = NULL;
@@ -290,6 +321,7 @@ static const btstack_run_loop_t btstack_run_loop_embedded = {
     &btstack_run_loop_embedded_execute,
     &btstack_run_loop_embedded_dump_timer,
     &btstack_run_loop_embedded_get_time_ms,
+    &btstack_run_loop_embedded_execute_on_main_thread,
 };
 
 const btstack_run_loop_t * btstack_run_loop_embedded_get_instance(void){
@@ -51,6 +51,7 @@
 
 #include "btstack_linked_list.h"
 #include "btstack_debug.h"
+#include "btstack_stats.h"
 #include "btstack_util.h"
 #include "hal_time_ms.h"
 
@@ -181,6 +182,18 @@ void btstack_run_loop_freertos_execute_code_on_main_thread(void (*fn)(void *arg)
     btstack_run_loop_freertos_trigger();
 }
 
+static void btstack_run_loop_freertos_execute_on_main_thread(btstack_context_callback_registration_t * callback_registration){
+    // always queue, callback is executed with other pending callbacks in next run loop iteration
+    function_call_t message;
+    message.fn  = callback_registration->callback;
+    message.arg = callback_registration->context;
+    BaseType_t res = xQueueSendToBack(btstack_run_loop_queue, &message, 0);
+    if (res != pdTRUE){
+        log_error("Failed to post fn %p", message.fn);
+    }
+    btstack_run_loop_freertos_trigger();
+}
+
 #if defined(HAVE_FREERTOS_TASK_NOTIFICATIONS) || (INCLUDE_xEventGroupSetBitFromISR == 1)
 void btstack_run_loop_freertos_trigger_from_isr(void){
     BaseType_t xHigherPriorityTaskWoken;
@@ -222,6 +235,8 @@ static void btstack_run_loop_freertos_execute(void) {
 
     while (true) {
 
+        BTSTACK_STATS_INCREMENT(RUN_LOOP_ITERATIONS);
+
         // process data sources
         btstack_data_source_t *ds;
         btstack_data_source_t *next;
@@ -257,6 +272,7 @@ static void btstack_run_loop_freertos_execute(void) {
             // remove timer before processing it to allow handler to re-register with run loop
             btstack_run_loop_freertos_remove_timer(ts);
             log_debug("RL: first timer %p", ts->process);
+            BTSTACK_STATS_TIMER_PROCESSED((uint32_t) -delta_ms);
             ts->process(ts);
         }
 
@@ -325,6 +341,7 @@ static const btstack_run_loop_t btstack_run_loop_freertos = {
     &btstack_run_loop_freertos_execute,
     &btstack_run_loop_freertos_dump_timer,
     &btstack_run_loop_freertos_get_time_ms,
+    &btstack_run_loop_freertos_execute_on_main_thread,
 };
 
 const btstack_run_loop_t * btstack_run_loop_freertos_get_instance(void){
@@ -58,6 +58,9 @@
 #include <string.h>
 #include <unistd.h>   /* UNIX standard function definitions */
 #include <sys/types.h>
+#ifndef _WIN32
+#include <poll.h>
+#endif
 
 #include <libusb.h>
 
@@ -79,10 +82,28 @@
 #define HAVE_USB_VENDOR_ID_AND_PRODUCT_ID
 #endif
 
-#define ACL_IN_BUFFER_COUNT    3
-#define EVENT_IN_BUFFER_COUNT  3
+// number of queued IN transfers for ACL and Events, can be set in btstack_config.h
+#ifdef HCI_TRANSPORT_USB_ACL_IN_BUFFER_COUNT
+#define ACL_IN_BUFFER_COUNT    HCI_TRANSPORT_USB_ACL_IN_BUFFER_COUNT
+#else
+#define ACL_IN_BUFFER_COUNT    6
+#endif
+#ifdef HCI_TRANSPORT_USB_EVENT_IN_BUFFER_COUNT
+#define EVENT_IN_BUFFER_COUNT  HCI_TRANSPORT_USB_EVENT_IN_BUFFER_COUNT
+#else
+#define EVENT_IN_BUFFER_COUNT  4
+#endif
 #define SCO_IN_BUFFER_COUNT   10
 
+// number of outstanding ACL OUT transfers. HCI flow control limits outstanding ACL packets
+// to the number of ACL buffers in the Controller, so more transfers than that are not used
+#ifdef HCI_TRANSPORT_USB_ACL_OUT_BUFFER_COUNT
+#define ACL_OUT_BUFFER_COUNT   HCI_TRANSPORT_USB_ACL_OUT_BUFFER_COUNT
+#else
+#define ACL_OUT_BUFFER_COUNT   4
+#endif
+
+// only used if libusb does not provide pollfds, e.g. on Windows
 #define ASYNC_POLLING_INTERVAL_MS 1
 
 //
@@ -161,7 +182,9 @@ static struct libusb_device_descriptor desc;
 static libusb_device_handle * handle;
 
 static struct libusb_transfer *command_out_transfer;
-static struct libusb_transfer *acl_out_transfer;
+static struct libusb_transfer *acl_out_transfers[ACL_OUT_BUFFER_COUNT];
+static int      acl_out_transfers_in_flight[ACL_OUT_BUFFER_COUNT];
+static int      acl_out_transfers_active;
 static struct libusb_transfer *event_in_transfer[EVENT_IN_BUFFER_COUNT];
 static struct libusb_transfer *acl_in_transfer[ACL_IN_BUFFER_COUNT];
 
@@ -204,6 +227,9 @@ static uint8_t hci_cmd_buffer[3 + 256 + LIBUSB_CONTROL_SETUP_SIZE];
 static uint8_t hci_event_in_buffer[EVENT_IN_BUFFER_COUNT][HCI_ACL_BUFFER_SIZE]; // bigger than largest packet
 static uint8_t hci_acl_in_buffer[ACL_IN_BUFFER_COUNT][HCI_INCOMING_PRE_BUFFER_SIZE + HCI_ACL_BUFFER_SIZE]; 
 
+// outgoing ACL packets are copied, so HCI can provide the next packet while transfers are in flight
+static uint8_t hci_acl_out_buffer[ACL_OUT_BUFFER_COUNT][HCI_ACL_BUFFER_SIZE];
+
 // For (ab)use as a linked list of received packets
 static struct libusb_transfer *handle_packet;
 
@@ -213,7 +239,10 @@ static btstack_data_source_t * pollfd_data_sources;
 static btstack_timer_source_t usb_timer;
 static int usb_timer_active;
 
-static int usb_acl_out_active = 0;
+// HCI_EVENT_TRANSPORT_PACKET_SENT for ACL is emitted from the run loop, as HCI might send the next fragment in its handler
+static btstack_timer_source_t acl_out_sent_timer;
+static int acl_out_sent_timer_active;
+
 static int usb_command_active = 0;
 
 // endpoint addresses
@@ -231,6 +260,10 @@ static uint8_t usb_path[USB_MAX_PATH_LEN];
 static int usb_transport_open;
 
 
+static int acl_out_have_space(void){
+    return acl_out_transfers_active < ACL_OUT_BUFFER_COUNT;
+}
+
 #ifdef ENABLE_SCO_OVER_HCI
 static void sco_ring_init(void){
     sco_ring_write = 0;
@@ -303,6 +336,14 @@ LIBUSB_CALL static void async_callback(struct libusb_transfer *transfer){
 #endif
 
     if (libusb_state != LIB_USB_TRANSFERS_ALLOCATED) {
+        for (c=0;c<ACL_OUT_BUFFER_COUNT;c++){
+            if (transfer == acl_out_transfers[c]){
+                acl_out_transfers_in_flight[c] = 0;
+                libusb_free_transfer(transfer);
+                acl_out_transfers[c] = 0;
+                return;
+            }
+        }
         for (c=0;c<EVENT_IN_BUFFER_COUNT;c++){
             if (transfer == event_in_transfer[c]){
                 libusb_free_transfer(transfer);
@@ -457,8 +498,15 @@ static void handle_completed_transfer(struct libusb_transfer *transfer){
         signal_done = 1;
     } else if (transfer->endpoint == acl_out_addr){
         // log_info("acl out done, size %u", transfer->actual_length);
-        usb_acl_out_active = 0;
-        signal_done = 1;
+        int c;
+        for (c = 0; c < ACL_OUT_BUFFER_COUNT; c++){
+            if (transfer == acl_out_transfers[c]){
+                acl_out_transfers_in_flight[c] = 0;
+            }
+        }
+        // HCI_EVENT_TRANSPORT_PACKET_SENT was not emitted on submit if all transfers were in flight
+        signal_done = acl_out_transfers_active == ACL_OUT_BUFFER_COUNT;
+        acl_out_transfers_active--;
 #ifdef ENABLE_SCO_OVER_HCI
     } else if (transfer->endpoint == sco_in_addr) {
         // log_info("handle_completed_transfer for SCO IN! num packets %u", transfer->NUM_ISO_PACKETS);
@@ -550,6 +598,15 @@ static void usb_process_ds(btstack_data_source_t *ds, btstack_data_source_callba
     // log_info("end usb_process_ds");
 }
 
+static void usb_acl_out_sent_handler(btstack_timer_source_t *timer){
+    UNUSED(timer);
+    acl_out_sent_timer_active = 0;
+    if (libusb_state != LIB_USB_TRANSFERS_ALLOCATED) return;
+    // notify upper stack that provided buffer can be used again
+    uint8_t event[] = { HCI_EVENT_TRANSPORT_PACKET_SENT, 0};
+    packet_handler(HCI_EVENT_PACKET, &event[0], sizeof(event));
+}
+
 static void usb_process_ts(btstack_timer_source_t *timer) {
 
     UNUSED(timer);
@@ -1076,8 +1133,17 @@ static int usb_open(void){
         }
     }
 
+    for (c = 0 ; c < ACL_OUT_BUFFER_COUNT ; c++) {
+        acl_out_transfers[c] = libusb_alloc_transfer(0); // 0 isochronous transfers ACL out
+        if (!acl_out_transfers[c]) {
+            usb_close();
+            return LIBUSB_ERROR_NO_MEM;
+        }
+        acl_out_transfers_in_flight[c] = 0;
+    }
+    acl_out_transfers_active = 0;
+
     command_out_transfer = libusb_alloc_transfer(0);
-    acl_out_transfer     = libusb_alloc_transfer(0);
 
     // TODO check for error
 
@@ -1108,18 +1174,17 @@ static int usb_open(void){
  
      }
 
- #if 0
-    // Check for pollfds functionality
-    doing_pollfds = libusb_pollfds_handle_timeouts(NULL);
-#else
-    // NOTE: using pollfds doesn't work on Linux, so it is disable until further investigation
-    doing_pollfds = 0;
-#endif
+    // Check for pollfds functionality. On Linux, completed transfers are signalled by POLLOUT on the usbfs file descriptor,
+    // and libusb timeouts are handled via timerfd, so no polling is needed
+    const struct libusb_pollfd ** pollfd = NULL;
+    if (libusb_pollfds_handle_timeouts(NULL)){
+        pollfd = libusb_get_pollfds(NULL);
+    }
+    doing_pollfds = pollfd != NULL;
 
     if (doing_pollfds) {
         log_info("Async using pollfds:");
 
-        const struct libusb_pollfd ** pollfd = libusb_get_pollfds(NULL);
         for (num_pollfds = 0 ; pollfd[num_pollfds] ; num_pollfds++);
         pollfd_data_sources = (btstack_data_source_t *)malloc(sizeof(btstack_data_source_t) * num_pollfds);
         if (!pollfd_data_sources){
@@ -1132,11 +1197,16 @@ static int usb_open(void){
             btstack_data_source_t *ds = &pollfd_data_sources[r];
             btstack_run_loop_set_data_source_fd(ds, pollfd[r]->fd);
             btstack_run_loop_set_data_source_handler(ds, &usb_process_ds);
-            btstack_run_loop_enable_data_source_callbacks(ds, DATA_SOURCE_CALLBACK_READ);
+            if (pollfd[r]->events & POLLIN){
+                btstack_run_loop_enable_data_source_callbacks(ds, DATA_SOURCE_CALLBACK_READ);
+            }
+            if (pollfd[r]->events & POLLOUT){
+                btstack_run_loop_enable_data_source_callbacks(ds, DATA_SOURCE_CALLBACK_WRITE);
+            }
             btstack_run_loop_add_data_source(ds);
             log_info("%u: %p fd: %u, events %x", r, pollfd[r], pollfd[r]->fd, pollfd[r]->events);
         }
-        free(pollfd);
+        libusb_free_pollfds(pollfd);
     } else {
         log_info("Async using timers:");
 
@@ -1171,6 +1241,11 @@ static int usb_close(void){
                 usb_timer_active = 0;
             }
 
+            if (acl_out_sent_timer_active){
+                btstack_run_loop_remove_timer(&acl_out_sent_timer);
+                acl_out_sent_timer_active = 0;
+            }
+
             if (doing_pollfds){
                 int r;
                 for (r = 0 ; r < num_pollfds ; r++) {
@@ -1198,6 +1273,16 @@ static int usb_close(void){
                     libusb_cancel_transfer(acl_in_transfer[c]);
                 }
             }
+            for (c = 0 ; c < ACL_OUT_BUFFER_COUNT ; c++) {
+                if (!acl_out_transfers[c]) continue;
+                if (acl_out_transfers_in_flight[c]) {
+                    log_info("cancel acl_out_transfers[%u] = %p", c, acl_out_transfers[c]);
+                    libusb_cancel_transfer(acl_out_transfers[c]);
+                } else {
+                    libusb_free_transfer(acl_out_transfers[c]);
+                    acl_out_transfers[c] = 0;
+                }
+            }
 #ifdef ENABLE_SCO_OVER_HCI
             for (c = 0 ; c < SCO_IN_BUFFER_COUNT ; c++) {
                 if (sco_in_transfer[c]){
@@ -1249,6 +1334,16 @@ static int usb_close(void){
                     }
                 }
 
+                if (!completed) continue;
+
+                for (c=0;c<ACL_OUT_BUFFER_COUNT;c++){
+                    if (acl_out_transfers[c]) {
+                        log_info("acl_out_transfers[%u] still active (%p)", c, acl_out_transfers[c]);
+                        completed = 0;
+                        break;
+                    }
+                }
+
 #ifdef ENABLE_SCO_OVER_HCI
                 if (!completed) continue;
 
@@ -1330,23 +1425,46 @@ static int usb_send_acl_packet(uint8_t *packet, int size){
     if (libusb_state != LIB_USB_TRANSFERS_ALLOCATED) return -1;
 
     // log_info("usb_send_acl_packet enter, size %u", size);
-    
-    // prepare transfer
-    int completed = 0;
-    libusb_fill_bulk_transfer(acl_out_transfer, handle, acl_out_addr, packet, size,
-        async_callback, &completed, 0);
-    acl_out_transfer->type = LIBUSB_TRANSFER_TYPE_BULK;
 
-    // update stata before submitting transfer
-    usb_acl_out_active = 1;
+    // get free transfer
+    int transfer_index;
+    for (transfer_index = 0; transfer_index < ACL_OUT_BUFFER_COUNT; transfer_index++){
+        if (acl_out_transfers_in_flight[transfer_index] == 0) break;
+    }
+    if ((transfer_index == ACL_OUT_BUFFER_COUNT) || (size > HCI_ACL_BUFFER_SIZE)){
+        log_error("usb_send_acl_packet: no free transfer or packet too large, size %u", size);
+        return -1;
+    }
+
+    // store packet in transfer buffer
+    uint8_t * data = hci_acl_out_buffer[transfer_index];
+    memcpy(data, packet, size);
 
-    r = libusb_submit_transfer(acl_out_transfer);
+    // prepare transfer
+    struct libusb_transfer * acl_transfer = acl_out_transfers[transfer_index];
+    libusb_fill_bulk_transfer(acl_transfer, handle, acl_out_addr, data, size,
+        async_callback, NULL, 0);
+    acl_transfer->type = LIBUSB_TRANSFER_TYPE_BULK;
+
+    r = libusb_submit_transfer(acl_transfer);
     if (r < 0) {
-        usb_acl_out_active = 0;
         log_error("Error submitting acl transfer, %d", r);
         return -1;
     }
 
+    // mark transfer as in flight
+    acl_out_transfers_in_flight[transfer_index] = 1;
+    acl_out_transfers_active++;
+
+    // if there's another free transfer, notify upper stack from run loop that provided buffer can be used again.
+    // emitting it here would let HCI re-enter send_packet for the next fragment. otherwise, it's sent on completion
+    if (acl_out_have_space()){
+        btstack_run_loop_set_timer_handler(&acl_out_sent_timer, &usb_acl_out_sent_handler);
+        btstack_run_loop_set_timer(&acl_out_sent_timer, 0);
+        btstack_run_loop_add_timer(&acl_out_sent_timer);
+        acl_out_sent_timer_active = 1;
+    }
+
     return 0;
 }
 
@@ -1355,7 +1473,7 @@ static int usb_can_send_packet_now(uint8_t packet_type){
         case HCI_COMMAND_DATA_PACKET:
             return !usb_command_active;
         case HCI_ACL_DATA_PACKET:
-            return !usb_acl_out_active;
+            return acl_out_have_space();
 #ifdef ENABLE_SCO_OVER_HCI
         case HCI_SCO_DATA_PACKET:
             if (!sco_enabled) return 0;
@@ -0,0 +1,350 @@
+/*
+ * Copyright (C) 2019 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+#define BTSTACK_FILE__ "hci_transport_linux.c"
+
+/*
+ *  hci_transport_linux.c
+ *
+ *  HCI Transport API implementation for Linux HCI User Channel
+ *
+ *  The Controller is accessed via a raw Bluetooth socket bound to HCI_CHANNEL_USER, which gives
+ *  exclusive access to the Controller while the Linux driver still handles the USB/UART details.
+ *  Requires CAP_NET_ADMIN and the HCI device to be down, e.g. 'sudo hciconfig hci0 down'.
+ *
+ *  Each packet is transferred as a single message with H4 packet type indicator. Packets are
+ *  written with writev and read with recvmmsg directly into the HCI packet buffers, up to
+ *  RX_BATCH_SIZE packets per run loop wakeup.
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <errno.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "btstack_config.h"
+
+#include "btstack_debug.h"
+#include "btstack_run_loop.h"
+#include "hci.h"
+#include "hci_transport.h"
+
+// avoid dependency on BlueZ headers
+#ifndef AF_BLUETOOTH
+#define AF_BLUETOOTH 31
+#endif
+#define LINUX_BTPROTO_HCI       1
+#define LINUX_HCI_CHANNEL_USER  1
+
+typedef struct {
+    sa_family_t    hci_family;
+    unsigned short hci_dev;
+    unsigned short hci_channel;
+} linux_sockaddr_hci_t;
+
+// max number of packets read per run loop wakeup, can be set in btstack_config.h
+#ifdef HCI_TRANSPORT_LINUX_RX_BATCH_SIZE
+#define RX_BATCH_SIZE HCI_TRANSPORT_LINUX_RX_BATCH_SIZE
+#else
+#define RX_BATCH_SIZE 4
+#endif
+
+// max number of HCI User Channel instances, e.g. one per Controller with ENABLE_HCI_MULTIPLE_CONTROLLERS
+#ifdef HCI_TRANSPORT_LINUX_MAX_INSTANCES
+#define MAX_INSTANCES HCI_TRANSPORT_LINUX_MAX_INSTANCES
+#else
+#define MAX_INSTANCES 4
+#endif
+// plain number, used to generate the per-instance transport functions
+#if (MAX_INSTANCES < 1) || (MAX_INSTANCES > 4)
+#error "HCI_TRANSPORT_LINUX_MAX_INSTANCES needs to be 1..4"
+#endif
+
+typedef struct {
+    hci_transport_t transport;
+    void (*packet_handler)(uint8_t packet_type, uint8_t *packet, uint16_t size);
+    uint16_t hci_index;
+    int      provided_socket;
+    btstack_data_source_t data_source;
+
+    // incoming packets: H4 packet type + pre-buffer + packet for each message
+    uint8_t        rx_packet_types[RX_BATCH_SIZE];
+    uint8_t        rx_buffers[RX_BATCH_SIZE][HCI_INCOMING_PRE_BUFFER_SIZE + HCI_INCOMING_PACKET_BUFFER_SIZE];
+    struct iovec   rx_iovecs[RX_BATCH_SIZE][2];
+    struct mmsghdr rx_messages[RX_BATCH_SIZE];
+} hci_transport_linux_t;
+
+static void dummy_handler(uint8_t packet_type, uint8_t *packet, uint16_t size);
+
+// instance 0 is returned by hci_transport_linux_instance
+static hci_transport_linux_t * hci_transport_linux_instances[MAX_INSTANCES];
+
+static hci_transport_linux_t * hci_transport_linux_get_instance(uint8_t index);
+
+void hci_transport_linux_set_hci_index(uint16_t hci_index){
+    hci_transport_linux_t * instance = hci_transport_linux_get_instance(0);
+    if (instance == NULL) return;
+    instance->hci_index = hci_index;
+}
+
+void hci_transport_linux_set_socket(int socket_fd){
+    hci_transport_linux_t * instance = hci_transport_linux_get_instance(0);
+    if (instance == NULL) return;
+    instance->provided_socket = socket_fd;
+}
+
+static void hci_transport_linux_setup_rx_messages(hci_transport_linux_t * instance){
+    int i;
+    memset(instance->rx_messages, 0, sizeof(instance->rx_messages));
+    for (i = 0; i < RX_BATCH_SIZE; i++){
+        instance->rx_iovecs[i][0].iov_base = &instance->rx_packet_types[i];
+        instance->rx_iovecs[i][0].iov_len  = 1;
+        instance->rx_iovecs[i][1].iov_base = &instance->rx_buffers[i][HCI_INCOMING_PRE_BUFFER_SIZE];
+        instance->rx_iovecs[i][1].iov_len  = HCI_INCOMING_PACKET_BUFFER_SIZE;
+        instance->rx_messages[i].msg_hdr.msg_iov    = instance->rx_iovecs[i];
+        instance->rx_messages[i].msg_hdr.msg_iovlen = 2;
+    }
+}
+
+static void hci_transport_linux_stop_receiving(hci_transport_linux_t * instance){
+    btstack_run_loop_disable_data_source_callbacks(&instance->data_source, DATA_SOURCE_CALLBACK_READ);
+}
+
+static hci_transport_linux_t * hci_transport_linux_instance_for_data_source(btstack_data_source_t * ds){
+    uint8_t i;
+    for (i = 0; i < MAX_INSTANCES; i++){
+        hci_transport_linux_t * instance = hci_transport_linux_instances[i];
+        if ((instance != NULL) && (&instance->data_source == ds)) return instance;
+    }
+    return NULL;
+}
+
+static void hci_transport_linux_process(btstack_data_source_t *ds, btstack_data_source_callback_type_t callback_type){
+    UNUSED(callback_type);
+
+    hci_transport_linux_t * instance = hci_transport_linux_instance_for_data_source(ds);
+    if (instance == NULL) return;
+
+    int num_messages = recvmmsg(ds->source.fd, instance->rx_messages, RX_BATCH_SIZE, MSG_DONTWAIT, NULL);
+    if (num_messages < 0){
+        if ((errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR)) return;
+        log_error("hci_transport_linux: read failed, %s", strerror(errno));
+        hci_transport_linux_stop_receiving(instance);
+        return;
+    }
+
+    int i;
+    for (i = 0; i < num_messages; i++){
+        uint32_t message_len = instance->rx_messages[i].msg_len;
+        if (message_len == 0){
+            log_error("hci_transport_linux: socket closed by peer");
+            hci_transport_linux_stop_receiving(instance);
+            return;
+        }
+        if (instance->rx_messages[i].msg_hdr.msg_flags & MSG_TRUNC){
+            log_error("hci_transport_linux: packet type %u truncated, drop", instance->rx_packet_types[i]);
+            continue;
+        }
+        (*instance->packet_handler)(instance->rx_packet_types[i], &instance->rx_buffers[i][HCI_INCOMING_PRE_BUFFER_SIZE], message_len - 1u);
+        // transport might have been closed by packet handler
+        if (instance->data_source.source.fd < 0) return;
+    }
+}
+
+static int hci_transport_linux_open(hci_transport_linux_t * instance){
+    int fd = instance->provided_socket;
+    if (fd < 0){
+        fd = socket(AF_BLUETOOTH, SOCK_RAW | SOCK_CLOEXEC, LINUX_BTPROTO_HCI);
+        if (fd < 0){
+            log_error("hci_transport_linux: cannot create Bluetooth socket, %s", strerror(errno));
+            return -1;
+        }
+        linux_sockaddr_hci_t addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.hci_family  = AF_BLUETOOTH;
+        addr.hci_dev     = instance->hci_index;
+        addr.hci_channel = LINUX_HCI_CHANNEL_USER;
+        if (bind(fd, (struct sockaddr *) &addr, sizeof(addr)) < 0){
+            log_error("hci_transport_linux: cannot bind to hci%u user channel, %s. HCI device needs to be down and CAP_NET_ADMIN is required",
+                instance->hci_index, strerror(errno));
+            close(fd);
+            return -1;
+        }
+        log_info("hci_transport_linux: using hci%u", instance->hci_index);
+    }
+    instance->provided_socket = -1;
+
+    hci_transport_linux_setup_rx_messages(instance);
+
+    btstack_run_loop_set_data_source_fd(&instance->data_source, fd);
+    btstack_run_loop_set_data_source_handler(&instance->data_source, &hci_transport_linux_process);
+    btstack_run_loop_enable_data_source_callbacks(&instance->data_source, DATA_SOURCE_CALLBACK_READ);
+    btstack_run_loop_add_data_source(&instance->data_source);
+    return 0;
+}
+
+static int hci_transport_linux_close(hci_transport_linux_t * instance){
+    int fd = instance->data_source.source.fd;
+    if (fd < 0) return 0;
+    btstack_run_loop_remove_data_source(&instance->data_source);
+    btstack_run_loop_set_data_source_fd(&instance->data_source, -1);
+    close(fd);
+    return 0;
+}
+
+static int hci_transport_linux_send_packet(hci_transport_linux_t * instance, uint8_t packet_type, uint8_t * packet, int size){
+    int fd = instance->data_source.source.fd;
+    if (fd < 0) return -1;
+    struct iovec iov[2];
+    iov[0].iov_base = &packet_type;
+    iov[0].iov_len  = 1;
+    iov[1].iov_base = packet;
+    iov[1].iov_len  = size;
+    while (1){
+        ssize_t res = writev(fd, iov, 2);
+        if (res >= 0) return 0;
+        if (errno == EINTR) continue;
+        log_error("hci_transport_linux: write failed, %s", strerror(errno));
+        return -1;
+    }
+}
+
+static void dummy_handler(uint8_t packet_type, uint8_t *packet, uint16_t size){
+    UNUSED(packet_type);
+    UNUSED(packet);
+    UNUSED(size);
+}
+
+// hci_transport_t functions don't have a context, generate one set per instance
+#define HCI_TRANSPORT_LINUX_FOR_EACH_INSTANCE_1(X) X(0)
+#define HCI_TRANSPORT_LINUX_FOR_EACH_INSTANCE_2(X) HCI_TRANSPORT_LINUX_FOR_EACH_INSTANCE_1(X) X(1)
+#define HCI_TRANSPORT_LINUX_FOR_EACH_INSTANCE_3(X) HCI_TRANSPORT_LINUX_FOR_EACH_INSTANCE_2(X) X(2)
+#define HCI_TRANSPORT_LINUX_FOR_EACH_INSTANCE_4(X) HCI_TRANSPORT_LINUX_FOR_EACH_INSTANCE_3(X) X(3)
+#define HCI_TRANSPORT_LINUX_FOR_EACH_INSTANCE_EXPAND(num, X) HCI_TRANSPORT_LINUX_FOR_EACH_INSTANCE_ ## num(X)
+#define HCI_TRANSPORT_LINUX_FOR_EACH_INSTANCE(num, X) HCI_TRANSPORT_LINUX_FOR_EACH_INSTANCE_EXPAND(num, X)
+
+#define HCI_TRANSPORT_LINUX_INSTANCE_FUNCTIONS(index) \
+static int hci_transport_linux_ ## index ## _open(void){ \
+    return hci_transport_linux_open(hci_transport_linux_instances[index]); \
+} \
+static int hci_transport_linux_ ## index ## _close(void){ \
+    return hci_transport_linux_close(hci_transport_linux_instances[index]); \
+} \
+static int hci_transport_linux_ ## index ## _send_packet(uint8_t packet_type, uint8_t * packet, int size){ \
+    return hci_transport_linux_send_packet(hci_transport_linux_instances[index], packet_type, packet, size); \
+} \
+static void hci_transport_linux_ ## index ## _register_packet_handler(void (*handler)(uint8_t packet_type, uint8_t *packet, uint16_t size)){ \
+    hci_transport_linux_instances[index]->packet_handler = handler; \
+}
+#define HCI_TRANSPORT_LINUX_INSTANCE_CASE(index) \
+    case index: \
+        transport->open                    = &hci_transport_linux_ ## index ## _open; \
+        transport->close                   = &hci_transport_linux_ ## index ## _close; \
+        transport->send_packet             = &hci_transport_linux_ ## index ## _send_packet; \
+        transport->register_packet_handler = &hci_transport_linux_ ## index ## _register_packet_handler; \
+        break;
+
+HCI_TRANSPORT_LINUX_FOR_EACH_INSTANCE(MAX_INSTANCES, HCI_TRANSPORT_LINUX_INSTANCE_FUNCTIONS)
+
+static hci_transport_linux_t * hci_transport_linux_get_instance(uint8_t index){
+    hci_transport_linux_t * instance = hci_transport_linux_instances[index];
+    if (instance != NULL) return instance;
+
+    instance = (hci_transport_linux_t *) malloc(sizeof(hci_transport_linux_t));
+    if (instance == NULL) return NULL;
+    memset(instance, 0, sizeof(hci_transport_linux_t));
+    instance->packet_handler  = &dummy_handler;
+    instance->provided_socket = -1;
+    btstack_run_loop_set_data_source_fd(&instance->data_source, -1);
+
+    hci_transport_t * transport = &instance->transport;
+    transport->name = "LINUX_USER_CHANNEL";
+    // writev either sends complete packet or fails: synchronous transport without can_send_packet_now
+    switch (index){
+        HCI_TRANSPORT_LINUX_FOR_EACH_INSTANCE(MAX_INSTANCES, HCI_TRANSPORT_LINUX_INSTANCE_CASE)
+        default:
+            btstack_assert(false);
+            break;
+    }
+    hci_transport_linux_instances[index] = instance;
+    return instance;
+}
+
+// get linux instance configured by hci_transport_linux_set_hci_index and hci_transport_linux_set_socket
+const hci_transport_t * hci_transport_linux_instance(void) {
+    hci_transport_linux_t * instance = hci_transport_linux_get_instance(0);
+    if (instance == NULL) return NULL;
+    return &instance->transport;
+}
+
+static hci_transport_linux_t * hci_transport_linux_instance_for_index(uint16_t hci_index){
+    uint8_t i;
+    // existing instance
+    for (i = 0; i < MAX_INSTANCES; i++){
+        hci_transport_linux_t * instance = hci_transport_linux_instances[i];
+        if ((instance != NULL) && (instance->hci_index == hci_index)) return instance;
+    }
+    // instance 0 is reserved for hci_transport_linux_instance
+    for (i = 1; i < MAX_INSTANCES; i++){
+        if (hci_transport_linux_instances[i] != NULL) continue;
+        hci_transport_linux_t * instance = hci_transport_linux_get_instance(i);
+        if (instance == NULL) return NULL;
+        instance->hci_index = hci_index;
+        return instance;
+    }
+    log_error("hci_transport_linux: no free instance for hci%u, see HCI_TRANSPORT_LINUX_MAX_INSTANCES", hci_index);
+    return NULL;
+}
+
+const hci_transport_t * hci_transport_linux_instance_for_hci_index(uint16_t hci_index){
+    hci_transport_linux_t * instance = hci_transport_linux_instance_for_index(hci_index);
+    if (instance == NULL) return NULL;
+    return &instance->transport;
+}
+
+void hci_transport_linux_set_socket_for_hci_index(uint16_t hci_index, int socket_fd){
+    hci_transport_linux_t * instance = hci_transport_linux_instance_for_index(hci_index);
+    if (instance == NULL) return;
+    instance->provided_socket = socket_fd;
+}
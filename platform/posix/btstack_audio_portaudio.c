@@ -43,13 +43,14 @@
 #include "btstack_debug.h"
 #include "btstack_audio.h"
 #include "btstack_run_loop.h"
+#include "btstack_ring_buffer_spsc.h"
 
 #ifdef HAVE_PORTAUDIO
 
 #define PA_SAMPLE_TYPE               paInt16
 #define NUM_FRAMES_PER_PA_BUFFER       512
-#define NUM_OUTPUT_BUFFERS               3
-#define NUM_INPUT_BUFFERS                2
+#define NUM_OUTPUT_BUFFERS               4
+#define NUM_INPUT_BUFFERS                4
 #define DRIVER_POLL_INTERVAL_MS          5
 
 #include <portaudio.h>
@@ -78,20 +79,13 @@ static PaStream * stream_sink;
 static void (*playback_callback)(int16_t * buffer, uint16_t num_samples);
 static void (*recording_callback)(const int16_t * buffer, uint16_t num_samples);
 
-// output buffer
-static int16_t               output_buffer_a[NUM_FRAMES_PER_PA_BUFFER * 2];   // stereo
-static int16_t               output_buffer_b[NUM_FRAMES_PER_PA_BUFFER * 2];   // stereo
-static int16_t               output_buffer_c[NUM_FRAMES_PER_PA_BUFFER * 2];   // stereo
-static int16_t             * output_buffers[NUM_OUTPUT_BUFFERS] = { output_buffer_a, output_buffer_b, output_buffer_c};
-static int                   output_buffer_to_play;
-static int                   output_buffer_to_fill;
+// output buffer: filled by run loop, played by portaudio thread
+static int16_t                    output_storage[NUM_OUTPUT_BUFFERS * NUM_FRAMES_PER_PA_BUFFER * 2];   // stereo
+static btstack_ring_buffer_spsc_t output_ring_buffer;
 
-// input buffer
-static int16_t               input_buffer_a[NUM_FRAMES_PER_PA_BUFFER * 2];   // stereo
-static int16_t               input_buffer_b[NUM_FRAMES_PER_PA_BUFFER * 2];   // stereo
-static int16_t             * input_buffers[NUM_INPUT_BUFFERS] = { input_buffer_a, input_buffer_b};
-static int                   input_buffer_to_record;
-static int                   input_buffer_to_fill;
+// input buffer: filled by portaudio thread, processed by run loop
+static int16_t                    input_storage[NUM_INPUT_BUFFERS * NUM_FRAMES_PER_PA_BUFFER * 2];     // stereo
+static btstack_ring_buffer_spsc_t input_ring_buffer;
 
 
 // timer to fill output ring buffer
@@ -113,10 +107,19 @@ static int portaudio_callback_sink( const void *                     inputBuffer
     (void) samples_per_buffer;
     (void) inputBuffer;
 
+    uint32_t bytes_per_buffer = NUM_FRAMES_PER_PA_BUFFER * num_bytes_per_sample_sink;
+    uint32_t span_len;
+    const int16_t * from_buffer = (const int16_t *) btstack_ring_buffer_spsc_read_acquire(&output_ring_buffer, &span_len);
+    int16_t * to_buffer = (int16_t *) outputBuffer;
+
+    // underrun, play silence
+    if (span_len < bytes_per_buffer){
+        memset(outputBuffer, 0, bytes_per_buffer);
+        return 0;
+    }
+
     // simplified volume control
     uint16_t index;
-    int16_t * from_buffer = output_buffers[output_buffer_to_play];
-    int16_t * to_buffer = (int16_t *) outputBuffer;
 
 #if 0
     // up to 8 right shifts
@@ -134,7 +137,7 @@ static int portaudio_callback_sink( const void *                     inputBuffer
 #endif
 
     // next
-    output_buffer_to_play = (output_buffer_to_play + 1 ) % NUM_OUTPUT_BUFFERS;
+    btstack_ring_buffer_spsc_read_commit(&output_ring_buffer, bytes_per_buffer);
 
     return 0;
 }
@@ -154,23 +157,30 @@ static int portaudio_callback_source( const void *                     inputBuff
     (void) samples_per_buffer;
     (void) outputBuffer;
 
-    // store in one of our buffers
-    memcpy(input_buffers[input_buffer_to_fill], inputBuffer, NUM_FRAMES_PER_PA_BUFFER * num_bytes_per_sample_source);
+    // store in input ring buffer, drop if run loop didn't keep up
+    uint32_t bytes_per_buffer = NUM_FRAMES_PER_PA_BUFFER * num_bytes_per_sample_source;
+    uint32_t span_len;
+    uint8_t * to_buffer = btstack_ring_buffer_spsc_write_acquire(&input_ring_buffer, &span_len);
+    if (span_len < bytes_per_buffer) return 0;
+    memcpy(to_buffer, inputBuffer, bytes_per_buffer);
 
     // next
-    input_buffer_to_fill = (input_buffer_to_fill + 1 ) % NUM_INPUT_BUFFERS;
+    btstack_ring_buffer_spsc_write_commit(&input_ring_buffer, bytes_per_buffer);
 
     return 0;
 }
 
 static void driver_timer_handler_sink(btstack_timer_source_t * ts){
 
-    // playback buffer ready to fill
-    if (output_buffer_to_play != output_buffer_to_fill){
-        (*playback_callback)(output_buffers[output_buffer_to_fill], NUM_FRAMES_PER_PA_BUFFER);
+    // playback buffer ready to fill, storage is a multiple of the buffer size, so span is never split
+    uint32_t bytes_per_buffer = NUM_FRAMES_PER_PA_BUFFER * num_bytes_per_sample_sink;
+    uint32_t span_len;
+    int16_t * buffer = (int16_t *) btstack_ring_buffer_spsc_write_acquire(&output_ring_buffer, &span_len);
+    if (span_len >= bytes_per_buffer){
+        (*playback_callback)(buffer, NUM_FRAMES_PER_PA_BUFFER);
 
         // next
-        output_buffer_to_fill = (output_buffer_to_fill + 1 ) % NUM_OUTPUT_BUFFERS;
+        btstack_ring_buffer_spsc_write_commit(&output_ring_buffer, bytes_per_buffer);
     }
 
     // re-set timer
@@ -181,12 +191,15 @@ static void driver_timer_handler_sink(btstack_timer_source_t * ts){
 static void driver_timer_handler_source(btstack_timer_source_t * ts){
 
     // recording buffer ready to process
-    if (input_buffer_to_record != input_buffer_to_fill){
+    uint32_t bytes_per_buffer = NUM_FRAMES_PER_PA_BUFFER * num_bytes_per_sample_source;
+    uint32_t span_len;
+    const int16_t * buffer = (const int16_t *) btstack_ring_buffer_spsc_read_acquire(&input_ring_buffer, &span_len);
+    if (span_len >= bytes_per_buffer){
 
-        (*recording_callback)(input_buffers[input_buffer_to_record], NUM_FRAMES_PER_PA_BUFFER);
+        (*recording_callback)(buffer, NUM_FRAMES_PER_PA_BUFFER);
 
         // next
-        input_buffer_to_record = (input_buffer_to_record + 1 ) % NUM_INPUT_BUFFERS;
+        btstack_ring_buffer_spsc_read_commit(&input_ring_buffer, bytes_per_buffer);
     }    
 
     // re-set timer
@@ -336,10 +349,15 @@ static void btstack_audio_portaudio_sink_start_stream(void){
     if (!playback_callback) return;
 
     // fill buffer once
-    (*playback_callback)(output_buffer_a, NUM_FRAMES_PER_PA_BUFFER);
-    (*playback_callback)(output_buffer_b, NUM_FRAMES_PER_PA_BUFFER);
-    output_buffer_to_play = 0;
-    output_buffer_to_fill = 2;
+    uint32_t bytes_per_buffer = NUM_FRAMES_PER_PA_BUFFER * num_bytes_per_sample_sink;
+    btstack_ring_buffer_spsc_init(&output_ring_buffer, (uint8_t *) output_storage, NUM_OUTPUT_BUFFERS * bytes_per_buffer);
+    int i;
+    for (i = 0; i < 2; i++){
+        uint32_t span_len;
+        int16_t * buffer = (int16_t *) btstack_ring_buffer_spsc_write_acquire(&output_ring_buffer, &span_len);
+        (*playback_callback)(buffer, NUM_FRAMES_PER_PA_BUFFER);
+        btstack_ring_buffer_spsc_write_commit(&output_ring_buffer, bytes_per_buffer);
+    }
 
     /* -- start stream -- */
     PaError err = Pa_StartStream(stream_sink);
@@ -360,6 +378,8 @@ static void btstack_audio_portaudio_source_start_stream(void){
 
     if (!recording_callback) return;
 
+    btstack_ring_buffer_spsc_init(&input_ring_buffer, (uint8_t *) input_storage, NUM_INPUT_BUFFERS * NUM_FRAMES_PER_PA_BUFFER * num_bytes_per_sample_source);
+
     /* -- start stream -- */
     PaError err = Pa_StartStream(stream_source);
     if (err != paNoError){
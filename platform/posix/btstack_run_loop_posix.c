@@ -52,20 +52,37 @@
 #include "btstack_util.h"
 #include "btstack_linked_list.h"
 #include "btstack_debug.h"
+#include "btstack_stats.h"
 
+#include <fcntl.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <sys/select.h>
 #include <sys/time.h>
 #include <time.h>
 #include <unistd.h>
 
+#ifdef __linux__
+#include <sys/eventfd.h>
+#endif
+
 static void btstack_run_loop_posix_dump_timer(void);
 
 // the run loop
 static btstack_linked_list_t data_sources;
 static int data_sources_modified;
 static btstack_linked_list_t timers;
+static bool run_loop_exit_requested;
+
+// callbacks queued by other threads: lock-free LIFO, reversed into submission order by run loop thread
+static btstack_linked_item_t * callbacks_pending;
+// time of first callback since last batch
+static uint64_t callbacks_wakeup_us;
+// eventfd or pipe to wake up run loop, callbacks_fds[0] for reading, callbacks_fds[1] for writing
+static int callbacks_fds[2];
+static btstack_data_source_t callbacks_data_source;
+static btstack_run_loop_posix_callback_stats_t callbacks_stats;
 
 // start time. tv_usec/tv_nsec = 0
 #ifdef _POSIX_MONOTONIC_CLOCK
@@ -191,6 +208,151 @@ static uint32_t btstack_run_loop_posix_get_time_ms(void){
     return time_ms;
 }
 
+/**
+ * @brief Queries monotonic time in us for latency measurement
+ */
+static uint64_t btstack_run_loop_posix_get_time_us(void){
+#ifdef _POSIX_MONOTONIC_CLOCK
+    struct timespec now_ts;
+    clock_gettime(CLOCK_MONOTONIC, &now_ts);
+    return ((uint64_t) now_ts.tv_sec * 1000000) + ((uint64_t) now_ts.tv_nsec / 1000);
+#else
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return ((uint64_t) tv.tv_sec * 1000000) + (uint64_t) tv.tv_usec;
+#endif
+}
+
+#ifdef ENABLE_BTSTACK_STATS_TRACE
+// time source for btstack_stats trace
+static uint32_t btstack_run_loop_posix_get_time_us_32(void){
+    return (uint32_t) btstack_run_loop_posix_get_time_us();
+}
+#endif
+
+static void btstack_run_loop_posix_callbacks_update_stats(uint16_t batch_size, uint64_t wakeup_us){
+    callbacks_stats.num_batches++;
+    callbacks_stats.num_callbacks += batch_size;
+    callbacks_stats.max_batch_size = (uint16_t) btstack_max(callbacks_stats.max_batch_size, batch_size);
+    // wakeup time not stored yet by producer
+    if (wakeup_us == 0) return;
+    uint64_t latency_us = btstack_run_loop_posix_get_time_us() - wakeup_us;
+    if (latency_us > 0xffffffffu){
+        latency_us = 0xffffffffu;
+    }
+    callbacks_stats.max_latency_us = btstack_max(callbacks_stats.max_latency_us, (uint32_t) latency_us);
+    uint16_t bucket = 0;
+    uint64_t bucket_limit_us = BTSTACK_RUN_LOOP_POSIX_LATENCY_BUCKET_0_US;
+    while ((bucket < (BTSTACK_RUN_LOOP_POSIX_LATENCY_BUCKETS - 1)) && (latency_us >= bucket_limit_us)){
+        bucket++;
+        bucket_limit_us <<= 1;
+    }
+    callbacks_stats.latency_histogram[bucket]++;
+}
+
+static void btstack_run_loop_posix_process_callbacks(btstack_data_source_t * ds, btstack_data_source_callback_type_t callback_type){
+    UNUSED(callback_type);
+
+    // consume wakeup: eventfd returns and resets counter, pipe is drained
+    uint8_t buffer[16];
+    while (read(ds->source.fd, buffer, sizeof(buffer)) > 0){}
+
+    // take all queued callbacks at once
+    btstack_linked_item_t * lifo = __atomic_exchange_n(&callbacks_pending, NULL, __ATOMIC_ACQUIRE);
+    if (lifo == NULL) return;
+    uint64_t wakeup_us = __atomic_exchange_n(&callbacks_wakeup_us, 0, __ATOMIC_RELAXED);
+
+    // reverse into submission order
+    btstack_linked_item_t * fifo = NULL;
+    uint16_t batch_size = 0;
+    while (lifo != NULL){
+        btstack_linked_item_t * next = lifo->next;
+        lifo->next = fifo;
+        fifo = lifo;
+        lifo = next;
+        batch_size++;
+    }
+    btstack_run_loop_posix_callbacks_update_stats(batch_size, wakeup_us);
+
+    while (fifo != NULL){
+        btstack_context_callback_registration_t * callback_registration = (btstack_context_callback_registration_t *) fifo;
+        // get next before calling callback, as registration can be queued again by the callback
+        fifo = fifo->next;
+        (*callback_registration->callback)(callback_registration->context);
+    }
+}
+
+static void btstack_run_loop_posix_execute_on_main_thread(btstack_context_callback_registration_t * callback_registration){
+    btstack_linked_item_t * item = (btstack_linked_item_t *) callback_registration;
+    uint64_t now_us = btstack_run_loop_posix_get_time_us();
+
+    // push onto LIFO
+    btstack_linked_item_t * head = __atomic_load_n(&callbacks_pending, __ATOMIC_RELAXED);
+    do {
+        item->next = head;
+    } while (!__atomic_compare_exchange_n(&callbacks_pending, &head, item, true, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+
+    // only first callback of a batch has to wake up the run loop
+    if (head != NULL) return;
+    __atomic_store_n(&callbacks_wakeup_us, now_us, __ATOMIC_RELAXED);
+#ifdef __linux__
+    uint64_t value = 1;
+#else
+    uint8_t value = 1;
+#endif
+    // write only fails if wakeup is already pending
+    ssize_t res = write(callbacks_fds[1], &value, sizeof(value));
+    UNUSED(res);
+}
+
+static void btstack_run_loop_posix_callbacks_init(void){
+    callbacks_pending = NULL;
+    callbacks_wakeup_us = 0;
+    memset(&callbacks_stats, 0, sizeof(callbacks_stats));
+#ifdef __linux__
+    callbacks_fds[0] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    callbacks_fds[1] = callbacks_fds[0];
+    if (callbacks_fds[0] < 0){
+        log_error("eventfd failed");
+        return;
+    }
+#else
+    if (pipe(callbacks_fds) != 0){
+        log_error("pipe failed");
+        callbacks_fds[0] = -1;
+        callbacks_fds[1] = -1;
+        return;
+    }
+    fcntl(callbacks_fds[0], F_SETFL, O_NONBLOCK);
+    fcntl(callbacks_fds[1], F_SETFL, O_NONBLOCK);
+#endif
+    btstack_run_loop_set_data_source_fd(&callbacks_data_source, callbacks_fds[0]);
+    btstack_run_loop_set_data_source_handler(&callbacks_data_source, &btstack_run_loop_posix_process_callbacks);
+    btstack_run_loop_posix_enable_data_source_callbacks(&callbacks_data_source, DATA_SOURCE_CALLBACK_READ);
+    btstack_run_loop_posix_add_data_source(&callbacks_data_source);
+}
+
+const btstack_run_loop_posix_callback_stats_t * btstack_run_loop_posix_get_callback_stats(void){
+    return &callbacks_stats;
+}
+
+void btstack_run_loop_posix_dump_callback_stats(void){
+    log_info("callbacks %u in %u batches, max batch %u, max latency %u us",
+             (unsigned int) callbacks_stats.num_callbacks, (unsigned int) callbacks_stats.num_batches,
+             callbacks_stats.max_batch_size, (unsigned int) callbacks_stats.max_latency_us);
+    uint16_t i;
+    uint32_t bucket_limit_us = BTSTACK_RUN_LOOP_POSIX_LATENCY_BUCKET_0_US;
+    for (i = 0; i < (BTSTACK_RUN_LOOP_POSIX_LATENCY_BUCKETS - 1); i++){
+        log_info("latency < %6u us: %u", (unsigned int) bucket_limit_us, (unsigned int) callbacks_stats.latency_histogram[i]);
+        bucket_limit_us <<= 1;
+    }
+    log_info("latency >= %5u us: %u", (unsigned int) (bucket_limit_us >> 1), (unsigned int) callbacks_stats.latency_histogram[i]);
+}
+
+void btstack_run_loop_posix_trigger_exit(void){
+    run_loop_exit_requested = true;
+}
+
 /**
  * Execute run_loop
  */
@@ -210,7 +372,11 @@ static void btstack_run_loop_posix_execute(void) {
     log_info("POSIX run loop using ettimeofday fallback.");
 #endif
 
+    run_loop_exit_requested = false;
+
     while (true) {
+        BTSTACK_STATS_INCREMENT(RUN_LOOP_ITERATIONS);
+
         // collect FDs
         FD_ZERO(&descriptors_read);
         FD_ZERO(&descriptors_write);
@@ -282,8 +448,12 @@ static void btstack_run_loop_posix_execute(void) {
             
             // remove timer before processing it to allow handler to re-register with run loop
             btstack_run_loop_posix_remove_timer(ts);
+            BTSTACK_STATS_TIMER_PROCESSED((uint32_t) -delta);
             ts->process(ts);
         }
+
+        // exit triggered by btstack_run_loop_posix_trigger_exit (from data source, timer, callback)
+        if (run_loop_exit_requested) break;
     }
 }
 
@@ -304,6 +474,10 @@ static void btstack_run_loop_posix_init(void){
     // just assume that we started at tv_usec == 0
     gettimeofday(&init_tv, NULL);
     init_tv.tv_usec = 0;
+#endif
+    btstack_run_loop_posix_callbacks_init();
+#ifdef ENABLE_BTSTACK_STATS_TRACE
+    btstack_stats_set_time_source(&btstack_run_loop_posix_get_time_us_32);
 #endif
 }
 
@@ -320,6 +494,7 @@ static const btstack_run_loop_t btstack_run_loop_posix = {
     &btstack_run_loop_posix_execute,
     &btstack_run_loop_posix_dump_timer,
     &btstack_run_loop_posix_get_time_ms,
+    &btstack_run_loop_posix_execute_on_main_thread,
 };
 
 /**
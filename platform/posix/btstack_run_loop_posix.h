@@ -49,11 +49,44 @@
 extern "C" {
 #endif
 	
+// number of buckets in latency histogram
+#define BTSTACK_RUN_LOOP_POSIX_LATENCY_BUCKETS 12
+// upper limit of first bucket, limit doubles for each following bucket
+#define BTSTACK_RUN_LOOP_POSIX_LATENCY_BUCKET_0_US 16
+
+/**
+ * Statistics for callbacks queued with btstack_run_loop_execute_on_main_thread
+ * Latency is measured from queuing the first callback of a batch until the batch is processed
+ */
+typedef struct {
+    uint32_t num_callbacks;
+    uint32_t num_batches;
+    uint16_t max_batch_size;
+    uint32_t max_latency_us;
+    // bucket n counts latencies below (BTSTACK_RUN_LOOP_POSIX_LATENCY_BUCKET_0_US << n) us, last bucket all others
+    uint32_t latency_histogram[BTSTACK_RUN_LOOP_POSIX_LATENCY_BUCKETS];
+} btstack_run_loop_posix_callback_stats_t;
+
 /**
  * Provide btstack_run_loop_posix instance
  */
 const btstack_run_loop_t * btstack_run_loop_posix_get_instance(void);
 
+/**
+ * @brief Get statistics for callbacks executed on main thread. Only valid on run loop thread
+ */
+const btstack_run_loop_posix_callback_stats_t * btstack_run_loop_posix_get_callback_stats(void);
+
+/**
+ * @brief Log statistics for callbacks executed on main thread via log_info
+ */
+void btstack_run_loop_posix_dump_callback_stats(void);
+
+/**
+ * @brief Triggers exit of run loop from BTstack main thread, causes call to btstack_run_loop_execute to return
+ */
+void btstack_run_loop_posix_trigger_exit(void);
+
 /* API_END */
 
 #if defined __cplusplus
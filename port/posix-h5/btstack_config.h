@@ -26,10 +26,12 @@
 #define ENABLE_LOG_INFO 
 #define ENABLE_SCO_OVER_HCI
 #define ENABLE_SDP_DES_DUMP
+#define ENABLE_H5_CRC_SLICE_BY_8
 
 // BTstack configuration. buffers, sizes, ...
 #define HCI_INCOMING_PRE_BUFFER_SIZE 14 // sizeof benep heade, avoid memcpy
 #define HCI_ACL_PAYLOAD_SIZE (1691 + 4)
+#define HCI_TRANSPORT_H5_SLIDING_WINDOW_SIZE 4
 
 #define NVM_NUM_LINK_KEYS              16
 #define NVM_NUM_DEVICE_DB_ENTRIES      16
@@ -757,10 +757,12 @@ static uint16_t handle_read_blob_request(att_connection_t * att_connection, uint
 
 //
 // MARK: ATT_READ_MULTIPLE_REQUEST 0x0e
+// MARK: ATT_READ_MULTIPLE_VARIABLE_REQUEST 0x20
 //
-static uint16_t handle_read_multiple_request2(att_connection_t * att_connection, uint8_t * response_buffer, uint16_t response_buffer_size, uint16_t num_handles, uint8_t * handles){
-    log_info("ATT_READ_MULTIPLE_REQUEST: num handles %u", num_handles);
-    uint8_t request_type = ATT_READ_MULTIPLE_REQUEST;
+static uint16_t handle_read_multiple_request2(att_connection_t * att_connection, uint8_t * response_buffer, uint16_t response_buffer_size, uint16_t num_handles, uint8_t * handles, bool store_length){
+    log_info("ATT_READ_MULTIPLE_%sREQUEST: num handles %u", store_length ? "VARIABLE_" : "", num_handles);
+    uint8_t request_type  = store_length ? ATT_READ_MULTIPLE_VARIABLE_REQUEST  : ATT_READ_MULTIPLE_REQUEST;
+    uint8_t response_type = store_length ? ATT_READ_MULTIPLE_VARIABLE_RESPONSE : ATT_READ_MULTIPLE_RESPONSE;
     
     uint16_t offset   = 1;
 
@@ -805,7 +807,12 @@ static uint16_t handle_read_multiple_request2(att_connection_t * att_connection,
         if (read_request_pending) continue;
 #endif
 
-        // store
+        // store length and value, value of last tuple gets truncated
+        if (store_length){
+            if ((offset + 2u) > response_buffer_size) continue;
+            little_endian_store_16(response_buffer, offset, it.value_len);
+            offset += 2u;
+        }
         uint16_t bytes_copied = att_copy_value(&it, 0, response_buffer + offset, response_buffer_size - offset, att_connection->con_handle);
         offset += bytes_copied;
     }
@@ -814,7 +821,7 @@ static uint16_t handle_read_multiple_request2(att_connection_t * att_connection,
         return setup_error(response_buffer, request_type, handle, error_code);
     }
     
-    response_buffer[0] = ATT_READ_MULTIPLE_RESPONSE;
+    response_buffer[0] = response_type;
     return offset;
 }
 static uint16_t handle_read_multiple_request(att_connection_t * att_connection, uint8_t * request_buffer,  uint16_t request_len,
@@ -825,7 +832,18 @@ static uint16_t handle_read_multiple_request(att_connection_t * att_connection,
                                                                                         ATT_READ_MULTIPLE_REQUEST);
 
     int num_handles = (request_len - 1u) >> 1u;
-    return handle_read_multiple_request2(att_connection, response_buffer, response_buffer_size, num_handles, &request_buffer[1]);
+    return handle_read_multiple_request2(att_connection, response_buffer, response_buffer_size, num_handles, &request_buffer[1], false);
+}
+
+static uint16_t handle_read_multiple_variable_request(att_connection_t * att_connection, uint8_t * request_buffer,  uint16_t request_len,
+                                      uint8_t * response_buffer, uint16_t response_buffer_size){
+
+    // 1 byte opcode + two or more attribute handles (2 bytes each)
+    if ( (request_len < 5u) || ((request_len & 1u) == 0u) ) return setup_error_invalid_pdu(response_buffer,
+                                                                                        ATT_READ_MULTIPLE_VARIABLE_REQUEST);
+
+    int num_handles = (request_len - 1u) >> 1u;
+    return handle_read_multiple_request2(att_connection, response_buffer, response_buffer_size, num_handles, &request_buffer[1], true);
 }
 
 //
@@ -1147,6 +1165,29 @@ uint16_t att_prepare_handle_value_notification(att_connection_t * att_connection
     return prepare_handle_value(att_connection, handle, value, value_len, response_buffer);
 }
 
+// MARK: ATT_MULTIPLE_HANDLE_VALUE_NOTIFICATION 0x23
+uint16_t att_prepare_handle_value_multiple_notification(att_connection_t * att_connection,
+                                                        uint8_t num_attributes,
+                                                        const uint16_t * attribute_handles,
+                                                        const uint8_t ** values_data,
+                                                        const uint16_t * values_len,
+                                                        uint8_t * response_buffer){
+
+    response_buffer[0] = ATT_MULTIPLE_HANDLE_VALUE_NOTIFICATION;
+    uint16_t offset = 1;
+    uint8_t i;
+    for (i = 0; i < num_attributes; i++){
+        uint16_t value_len = values_len[i];
+        // tuples cannot be truncated
+        if ((offset + 4u + value_len) > att_connection->mtu) break;
+        little_endian_store_16(response_buffer, offset, attribute_handles[i]);
+        little_endian_store_16(response_buffer, offset + 2u, value_len);
+        (void)memcpy(&response_buffer[offset + 4u], values_data[i], value_len);
+        offset += 4u + value_len;
+    }
+    return offset;
+}
+
 // MARK: ATT_HANDLE_VALUE_INDICATION 0x1d
 uint16_t att_prepare_handle_value_indication(att_connection_t * att_connection,
                                              uint16_t handle,
@@ -1188,6 +1229,9 @@ uint16_t att_handle_request(att_connection_t * att_connection,
         case ATT_READ_MULTIPLE_REQUEST:  
             response_len = handle_read_multiple_request(att_connection, request_buffer, request_len, response_buffer, response_buffer_size);
             break;
+        case ATT_READ_MULTIPLE_VARIABLE_REQUEST:
+            response_len = handle_read_multiple_variable_request(att_connection, request_buffer, request_len, response_buffer, response_buffer_size);
+            break;
         case ATT_READ_BY_GROUP_TYPE_REQUEST:  
             response_len = handle_read_by_group_type_request(att_connection, request_buffer, request_len, response_buffer, response_buffer_size);
             break;
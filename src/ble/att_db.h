@@ -83,6 +83,10 @@ extern "C" {
 #define ATT_HANDLE_VALUE_INDICATION     0x1d
 #define ATT_HANDLE_VALUE_CONFIRMATION   0x1e
 
+#define ATT_READ_MULTIPLE_VARIABLE_REQUEST  0x20
+#define ATT_READ_MULTIPLE_VARIABLE_RESPONSE 0x21
+#define ATT_MULTIPLE_HANDLE_VALUE_NOTIFICATION 0x23
+
 
 #define ATT_WRITE_COMMAND                0x52
 #define ATT_SIGNED_WRITE_COMMAND         0xD2
@@ -206,6 +210,23 @@ uint16_t att_prepare_handle_value_notification(att_connection_t * att_connection
                                                uint16_t value_len, 
                                                uint8_t * response_buffer);
 
+/*
+ * @brief setup multiple handle value notification in response buffer for a list of handles and values
+ * @note only complete { handle, length, value } tuples that fit into the MTU are added
+ * @param att_connection
+ * @param num_attributes
+ * @param attribute_handles
+ * @param values_data
+ * @param values_len
+ * @param response_buffer for notification
+ */
+uint16_t att_prepare_handle_value_multiple_notification(att_connection_t * att_connection,
+                                                        uint8_t num_attributes,
+                                                        const uint16_t * attribute_handles,
+                                                        const uint8_t ** values_data,
+                                                        const uint16_t * values_len,
+                                                        uint8_t * response_buffer);
+
 /*
  * @brief setup value indication in response buffer for a given handle and value
  * @param att_connection
@@ -103,6 +103,9 @@ static btstack_context_callback_registration_t att_client_waiting_for_can_send_r
 static att_read_callback_t                    att_server_client_read_callback;
 static att_write_callback_t                   att_server_client_write_callback;
 
+// value handle of GATT Client Supported Features characteristic, if declared as DYNAMIC in ATT DB
+static uint16_t                               att_server_client_supported_features_handle;
+
 // round robin
 static hci_con_handle_t att_server_last_can_send_now = HCI_CON_HANDLE_INVALID;
 
@@ -125,6 +128,65 @@ static att_server_t * att_server_for_l2cap_cid(uint16_t l2cap_cid){
 }
 #endif
 
+#ifdef ENABLE_GATT_OVER_EATT
+// EATT bearer accepted by the ATT Server
+typedef struct {
+    btstack_linked_item_t item;
+    uint16_t              l2cap_cid;
+    att_server_t          att_server;
+    uint8_t               receive_buffer[ATT_REQUEST_BUFFER_SIZE];
+    uint8_t               send_buffer[ATT_REQUEST_BUFFER_SIZE];
+} att_server_eatt_bearer_t;
+
+static btstack_linked_list_t att_server_eatt_bearer_pool;
+static btstack_linked_list_t att_server_eatt_bearer_active;
+
+// bearers passed to l2cap_ecbm_accept_channels, L2CAP_EVENT_ECBM_CHANNEL_OPENED might be emitted before it returns
+static att_server_eatt_bearer_t * att_server_eatt_accept_bearers[L2CAP_ECBM_MAX_CID_ARRAY_SIZE];
+static uint16_t                   att_server_eatt_accept_cids[L2CAP_ECBM_MAX_CID_ARRAY_SIZE];
+static uint8_t                    att_server_eatt_accept_num;
+
+static att_server_eatt_bearer_t * att_server_eatt_bearer_for_l2cap_cid(uint16_t l2cap_cid){
+    btstack_linked_list_iterator_t it;
+    btstack_linked_list_iterator_init(&it, &att_server_eatt_bearer_active);
+    while(btstack_linked_list_iterator_has_next(&it)){
+        att_server_eatt_bearer_t * eatt_bearer = (att_server_eatt_bearer_t *) btstack_linked_list_iterator_next(&it);
+        if (eatt_bearer->l2cap_cid == l2cap_cid) return eatt_bearer;
+    }
+    uint8_t i;
+    for (i = 0; i < att_server_eatt_accept_num; i++){
+        if (att_server_eatt_accept_cids[i] != l2cap_cid) continue;
+        att_server_eatt_accept_bearers[i]->l2cap_cid = l2cap_cid;
+        return att_server_eatt_accept_bearers[i];
+    }
+    return NULL;
+}
+
+// @return open EATT bearer for connection that is idle and can send now or NULL
+static att_server_eatt_bearer_t * att_server_eatt_bearer_for_con_handle(hci_con_handle_t con_handle){
+    btstack_linked_list_iterator_t it;
+    btstack_linked_list_iterator_init(&it, &att_server_eatt_bearer_active);
+    while(btstack_linked_list_iterator_has_next(&it)){
+        att_server_eatt_bearer_t * eatt_bearer = (att_server_eatt_bearer_t *) btstack_linked_list_iterator_next(&it);
+        if (eatt_bearer->att_server.connection.con_handle != con_handle) continue;
+        if (eatt_bearer->att_server.state != ATT_SERVER_IDLE) continue;
+        if (!l2cap_le_can_send_now(eatt_bearer->l2cap_cid)) continue;
+        return eatt_bearer;
+    }
+    return NULL;
+}
+
+static att_server_eatt_bearer_t * att_server_eatt_bearer_for_att_server(att_server_t * att_server){
+    btstack_linked_list_iterator_t it;
+    btstack_linked_list_iterator_init(&it, &att_server_eatt_bearer_active);
+    while(btstack_linked_list_iterator_has_next(&it)){
+        att_server_eatt_bearer_t * eatt_bearer = (att_server_eatt_bearer_t *) btstack_linked_list_iterator_next(&it);
+        if (&eatt_bearer->att_server == att_server) return eatt_bearer;
+    }
+    return NULL;
+}
+#endif
+
 #ifdef ENABLE_LE_SIGNED_WRITE
 static att_server_t * att_server_for_state(att_server_state_t state){
     btstack_linked_list_iterator_t it;
@@ -139,6 +201,13 @@ static att_server_t * att_server_for_state(att_server_state_t state){
 #endif
 
 static void att_server_request_can_send_now(att_server_t * att_server){
+#ifdef ENABLE_GATT_OVER_EATT
+    att_server_eatt_bearer_t * eatt_bearer = att_server_eatt_bearer_for_att_server(att_server);
+    if (eatt_bearer != NULL){
+        l2cap_le_request_can_send_now_event(eatt_bearer->l2cap_cid);
+        return;
+    }
+#endif
 #ifdef ENABLE_GATT_OVER_CLASSIC
     if (att_server->l2cap_cid != 0){
         l2cap_request_can_send_now_event(att_server->l2cap_cid);
@@ -149,6 +218,12 @@ static void att_server_request_can_send_now(att_server_t * att_server){
 }
 
 static int att_server_can_send_packet(att_server_t * att_server){
+#ifdef ENABLE_GATT_OVER_EATT
+    att_server_eatt_bearer_t * eatt_bearer = att_server_eatt_bearer_for_att_server(att_server);
+    if (eatt_bearer != NULL){
+        return l2cap_le_can_send_now(eatt_bearer->l2cap_cid);
+    }
+#endif
 #ifdef ENABLE_GATT_OVER_CLASSIC
     if (att_server->l2cap_cid != 0){
         return l2cap_can_send_packet_now(att_server->l2cap_cid);
@@ -284,6 +359,7 @@ static void att_event_packet_handler (uint8_t packet_type, uint16_t channel, uin
                     att_server->l2cap_cid = l2cap_event_channel_opened_get_local_cid(packet);
                     // reset connection properties
                     att_server->state = ATT_SERVER_IDLE;
+                    att_server->client_supported_features = 0;
                     att_server->connection.mtu = l2cap_event_channel_opened_get_remote_mtu(packet);
                     att_server->connection.max_mtu = l2cap_max_mtu();
                     if (att_server->connection.max_mtu > ATT_REQUEST_BUFFER_SIZE){
@@ -338,6 +414,7 @@ static void att_event_packet_handler (uint8_t packet_type, uint16_t channel, uin
                             att_server->ir_le_device_db_index = sm_le_device_index(con_handle);
                             att_server->ir_lookup_active = 0;
                             att_server->pairing_active = 0;
+                            att_server->client_supported_features = 0;
                             // notify all - old
                             att_emit_event_to_all(packet, size);
                             // notify all - new
@@ -506,13 +583,34 @@ static void att_signed_write_handle_cmac_result(uint8_t hash[8]){
 }
 #endif
 
+static uint8_t * att_server_reserve_response_buffer(att_server_t * att_server){
+#ifdef ENABLE_GATT_OVER_EATT
+    att_server_eatt_bearer_t * eatt_bearer = att_server_eatt_bearer_for_att_server(att_server);
+    if (eatt_bearer != NULL){
+        return eatt_bearer->send_buffer;
+    }
+#else
+    UNUSED(att_server);
+#endif
+    l2cap_reserve_packet_buffer();
+    return l2cap_get_outgoing_buffer();
+}
+
+static void att_server_release_response_buffer(att_server_t * att_server){
+#ifdef ENABLE_GATT_OVER_EATT
+    if (att_server_eatt_bearer_for_att_server(att_server) != NULL) return;
+#else
+    UNUSED(att_server);
+#endif
+    l2cap_release_packet_buffer();
+}
+
 // pre: att_server->state == ATT_SERVER_REQUEST_RECEIVED_AND_VALIDATED
 // pre: can send now
 // returns: 1 if packet was sent
 static int att_server_process_validated_request(att_server_t * att_server){
 
-    l2cap_reserve_packet_buffer();
-    uint8_t * att_response_buffer = l2cap_get_outgoing_buffer();
+    uint8_t * att_response_buffer = att_server_reserve_response_buffer(att_server);
     uint16_t  att_response_size   = att_handle_request(&att_server->connection, att_server->request_buffer, att_server->request_size, att_response_buffer);
 
 #ifdef ENABLE_ATT_DELAYED_RESPONSE
@@ -526,7 +624,7 @@ static int att_server_process_validated_request(att_server_t * att_server){
         }
 
         // free reserved buffer
-        l2cap_release_packet_buffer();
+        att_server_release_response_buffer(att_server);
         return 0;
     }
 #endif
@@ -539,11 +637,11 @@ static int att_server_process_validated_request(att_server_t * att_server){
 
         switch (gap_authorization_state(att_server->connection.con_handle)){
             case AUTHORIZATION_UNKNOWN:
-                l2cap_release_packet_buffer();
+                att_server_release_response_buffer(att_server);
                 sm_request_pairing(att_server->connection.con_handle);
                 return 0;
             case AUTHORIZATION_PENDING:
-                l2cap_release_packet_buffer();
+                att_server_release_response_buffer(att_server);
                 return 0;
             default:
                 break;
@@ -552,10 +650,17 @@ static int att_server_process_validated_request(att_server_t * att_server){
 
     att_server->state = ATT_SERVER_IDLE;
     if (att_response_size == 0u) {
-        l2cap_release_packet_buffer();
+        att_server_release_response_buffer(att_server);
         return 0;
     }
 
+#ifdef ENABLE_GATT_OVER_EATT
+    att_server_eatt_bearer_t * eatt_bearer = att_server_eatt_bearer_for_att_server(att_server);
+    if (eatt_bearer != NULL){
+        l2cap_le_send_data(eatt_bearer->l2cap_cid, att_response_buffer, att_response_size);
+        return 1;
+    }
+#endif
 #ifdef ENABLE_GATT_OVER_CLASSIC
     if (att_server->l2cap_cid != 0){
         l2cap_send_prepared(att_server->l2cap_cid, att_response_size);
@@ -576,6 +681,20 @@ static int att_server_process_validated_request(att_server_t * att_server){
 int att_server_response_ready(hci_con_handle_t con_handle){
     att_server_t * att_server = att_server_for_handle(con_handle);
     if (!att_server)                                        return ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER;
+#ifdef ENABLE_GATT_OVER_EATT
+    // pending response might belong to an EATT bearer
+    if (att_server->state != ATT_SERVER_RESPONSE_PENDING){
+        btstack_linked_list_iterator_t it;
+        btstack_linked_list_iterator_init(&it, &att_server_eatt_bearer_active);
+        while(btstack_linked_list_iterator_has_next(&it)){
+            att_server_eatt_bearer_t * eatt_bearer = (att_server_eatt_bearer_t *) btstack_linked_list_iterator_next(&it);
+            if (eatt_bearer->att_server.connection.con_handle != con_handle) continue;
+            if (eatt_bearer->att_server.state != ATT_SERVER_RESPONSE_PENDING) continue;
+            att_server = &eatt_bearer->att_server;
+            break;
+        }
+    }
+#endif
     if (att_server->state != ATT_SERVER_RESPONSE_PENDING)   return ERROR_CODE_COMMAND_DISALLOWED;
 
     att_server->state = ATT_SERVER_REQUEST_RECEIVED_AND_VALIDATED;
@@ -837,6 +956,136 @@ static void att_packet_handler(uint8_t packet_type, uint16_t handle, uint8_t *pa
     }
 }
 
+#ifdef ENABLE_GATT_OVER_EATT
+static void att_server_eatt_bearer_release(att_server_eatt_bearer_t * eatt_bearer){
+    att_clear_transaction_queue(&eatt_bearer->att_server.connection);
+    btstack_linked_list_remove(&att_server_eatt_bearer_active, (btstack_linked_item_t *) eatt_bearer);
+    btstack_linked_list_add(&att_server_eatt_bearer_pool, (btstack_linked_item_t *) eatt_bearer);
+}
+
+static void att_server_eatt_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
+    att_server_eatt_bearer_t * eatt_bearer;
+    att_server_t * att_server;
+    hci_con_handle_t con_handle;
+    uint16_t l2cap_cid;
+    uint8_t num_channels;
+    uint8_t * receive_buffers[L2CAP_ECBM_MAX_CID_ARRAY_SIZE];
+    uint8_t i;
+
+    switch (packet_type){
+        case L2CAP_DATA_PACKET:
+            eatt_bearer = att_server_eatt_bearer_for_l2cap_cid(channel);
+            if (eatt_bearer == NULL) break;
+            if (size < 1u) break;
+            att_server_handle_att_pdu(&eatt_bearer->att_server, packet, size);
+            break;
+
+        case HCI_EVENT_PACKET:
+            switch (hci_event_packet_get_type(packet)){
+                case L2CAP_EVENT_ECBM_INCOMING_CONNECTION:
+                    l2cap_cid = l2cap_event_ecbm_incoming_connection_get_local_cid(packet);
+                    num_channels = l2cap_event_ecbm_incoming_connection_get_num_channels(packet);
+                    att_server_eatt_accept_num = 0;
+                    while (att_server_eatt_accept_num < num_channels){
+                        eatt_bearer = (att_server_eatt_bearer_t *) btstack_linked_list_pop(&att_server_eatt_bearer_pool);
+                        if (eatt_bearer == NULL) break;
+                        memset(eatt_bearer, 0, sizeof(att_server_eatt_bearer_t));
+                        btstack_linked_list_add(&att_server_eatt_bearer_active, (btstack_linked_item_t *) eatt_bearer);
+                        att_server_eatt_accept_bearers[att_server_eatt_accept_num] = eatt_bearer;
+                        receive_buffers[att_server_eatt_accept_num] = eatt_bearer->receive_buffer;
+                        att_server_eatt_accept_num++;
+                    }
+                    if (att_server_eatt_accept_num == 0u){
+                        log_info("EATT: no free bearer, decline cid 0x%04x", l2cap_cid);
+                        // 0x0004 All connections refused – insufficient resources available
+                        l2cap_ecbm_decline_channels(l2cap_cid, 0x0004);
+                        break;
+                    }
+                    log_info("EATT: accept %u of %u bearers", att_server_eatt_accept_num, num_channels);
+                    l2cap_ecbm_accept_channels(l2cap_cid, att_server_eatt_accept_num, L2CAP_LE_AUTOMATIC_CREDITS,
+                                               ATT_REQUEST_BUFFER_SIZE, receive_buffers, att_server_eatt_accept_cids);
+                    for (i = 0; i < att_server_eatt_accept_num; i++){
+                        att_server_eatt_accept_bearers[i]->l2cap_cid = att_server_eatt_accept_cids[i];
+                    }
+                    att_server_eatt_accept_num = 0;
+                    break;
+
+                case L2CAP_EVENT_ECBM_CHANNEL_OPENED:
+                    eatt_bearer = att_server_eatt_bearer_for_l2cap_cid(l2cap_event_ecbm_channel_opened_get_local_cid(packet));
+                    if (eatt_bearer == NULL) break;
+                    if (l2cap_event_ecbm_channel_opened_get_status(packet) != ERROR_CODE_SUCCESS){
+                        att_server_eatt_bearer_release(eatt_bearer);
+                        break;
+                    }
+                    // inherit peer info and security properties from unenhanced bearer
+                    con_handle = l2cap_event_ecbm_channel_opened_get_handle(packet);
+                    att_server = att_server_for_handle(con_handle);
+                    if (att_server == NULL){
+                        l2cap_le_disconnect(eatt_bearer->l2cap_cid);
+                        break;
+                    }
+                    eatt_bearer->att_server.peer_addr_type = att_server->peer_addr_type;
+                    (void)memcpy(eatt_bearer->att_server.peer_address, att_server->peer_address, 6);
+                    eatt_bearer->att_server.ir_le_device_db_index = att_server->ir_le_device_db_index;
+                    eatt_bearer->att_server.connection = att_server->connection;
+                    eatt_bearer->att_server.state = ATT_SERVER_IDLE;
+                    // EATT MTU is given by L2CAP channel, there's no MTU exchange
+                    eatt_bearer->att_server.connection.max_mtu = ATT_REQUEST_BUFFER_SIZE;
+                    eatt_bearer->att_server.connection.mtu = btstack_min(l2cap_event_ecbm_channel_opened_get_remote_mtu(packet), ATT_REQUEST_BUFFER_SIZE);
+                    log_info("EATT: bearer cid 0x%04x opened, mtu %u", eatt_bearer->l2cap_cid, eatt_bearer->att_server.connection.mtu);
+                    break;
+
+                case L2CAP_EVENT_ECBM_RECONFIGURED:
+                    eatt_bearer = att_server_eatt_bearer_for_l2cap_cid(l2cap_event_ecbm_reconfigured_get_local_cid(packet));
+                    if (eatt_bearer == NULL) break;
+                    eatt_bearer->att_server.connection.mtu = btstack_min(l2cap_event_ecbm_reconfigured_get_remote_mtu(packet), ATT_REQUEST_BUFFER_SIZE);
+                    log_info("EATT: bearer cid 0x%04x reconfigured, mtu %u", eatt_bearer->l2cap_cid, eatt_bearer->att_server.connection.mtu);
+                    break;
+
+                case L2CAP_EVENT_LE_CAN_SEND_NOW:
+                    eatt_bearer = att_server_eatt_bearer_for_l2cap_cid(l2cap_event_le_can_send_now_get_local_cid(packet));
+                    if (eatt_bearer == NULL) break;
+                    if (eatt_bearer->att_server.state != ATT_SERVER_REQUEST_RECEIVED_AND_VALIDATED) break;
+                    att_server_process_validated_request(&eatt_bearer->att_server);
+                    break;
+
+                case L2CAP_EVENT_LE_CHANNEL_CLOSED:
+                    eatt_bearer = att_server_eatt_bearer_for_l2cap_cid(l2cap_event_le_channel_closed_get_local_cid(packet));
+                    if (eatt_bearer == NULL) break;
+                    log_info("EATT: bearer cid 0x%04x closed", eatt_bearer->l2cap_cid);
+                    att_server_eatt_bearer_release(eatt_bearer);
+                    break;
+
+                default:
+                    break;
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+uint8_t att_server_eatt_init(uint8_t num_eatt_bearers, uint8_t * storage_buffer, uint16_t storage_size){
+    uint32_t size_needed = num_eatt_bearers * sizeof(att_server_eatt_bearer_t);
+    if (size_needed > storage_size){
+        return ERROR_CODE_MEMORY_CAPACITY_EXCEEDED;
+    }
+
+    att_server_eatt_bearer_pool   = NULL;
+    att_server_eatt_bearer_active = NULL;
+
+    memset(storage_buffer, 0, size_needed);
+    uint8_t i;
+    att_server_eatt_bearer_t * eatt_bearers = (att_server_eatt_bearer_t *) storage_buffer;
+    for (i = 0; i < num_eatt_bearers; i++){
+        btstack_linked_list_add(&att_server_eatt_bearer_pool, (btstack_linked_item_t *) &eatt_bearers[i]);
+    }
+
+    return l2cap_ecbm_register_service(&att_server_eatt_packet_handler, PSM_EATT, LEVEL_2);
+}
+#endif
+
 // ---------------------
 // persistent CCC writes
 static uint32_t att_server_persistent_ccc_tag_for_index(uint8_t index){
@@ -1053,11 +1302,31 @@ static uint8_t att_validate_prepared_write(hci_con_handle_t con_handle){
 }
 
 static uint16_t att_server_read_callback(hci_con_handle_t con_handle, uint16_t attribute_handle, uint16_t offset, uint8_t * buffer, uint16_t buffer_size){
+    // Client Supported Features are handled by ATT Server
+    if ((attribute_handle != 0u) && (attribute_handle == att_server_client_supported_features_handle)){
+        att_server_t * att_server = att_server_for_handle(con_handle);
+        if (!att_server) return 0;
+        return att_read_callback_handle_byte(att_server->client_supported_features, offset, buffer, buffer_size);
+    }
+
     att_read_callback_t callback = att_server_read_callback_for_handle(attribute_handle);
     if (!callback) return 0;
     return (*callback)(con_handle, attribute_handle, offset, buffer, buffer_size);
 }
 
+static int att_server_client_supported_features_write(hci_con_handle_t con_handle, uint16_t offset, const uint8_t * buffer, uint16_t buffer_size){
+    att_server_t * att_server = att_server_for_handle(con_handle);
+    if (!att_server) return 0;
+    if (offset != 0u) return ATT_ERROR_INVALID_OFFSET;
+    if (buffer_size == 0u) return ATT_ERROR_INVALID_ATTRIBUTE_VALUE_LENGTH;
+    // client shall not clear any bits it has set
+    uint8_t features = buffer[0] & (GATT_CLIENT_SUPPORTED_FEATURES_ROBUST_CACHING | GATT_CLIENT_SUPPORTED_FEATURES_ENHANCED_ATT_BEARER | GATT_CLIENT_SUPPORTED_FEATURES_MULTIPLE_HANDLE_VALUE_NOTIFICATIONS);
+    if ((att_server->client_supported_features & ~features) != 0u) return ATT_ERROR_VALUE_NOT_ALLOWED;
+    log_info("Client Supported Features 0x%02x for handle 0x%04x", features, con_handle);
+    att_server->client_supported_features = features;
+    return 0;
+}
+
 static int att_server_write_callback(hci_con_handle_t con_handle, uint16_t attribute_handle, uint16_t transaction_mode, uint16_t offset, uint8_t *buffer, uint16_t buffer_size){
     switch (transaction_mode){
         case ATT_TRANSACTION_MODE_VALIDATE:
@@ -1070,6 +1339,11 @@ static int att_server_write_callback(hci_con_handle_t con_handle, uint16_t attri
             break;
     }
 
+    // Client Supported Features are handled by ATT Server
+    if ((attribute_handle != 0u) && (attribute_handle == att_server_client_supported_features_handle)){
+        return att_server_client_supported_features_write(con_handle, offset, buffer, buffer_size);
+    }
+
     // track CCC writes
     if (att_is_persistent_ccc(attribute_handle) && (offset == 0u) && (buffer_size == 2u)){
         att_server_persistent_ccc_write(con_handle, attribute_handle, little_endian_read_16(buffer, 0));
@@ -1118,6 +1392,8 @@ void att_server_init(uint8_t const * db, att_read_callback_t read_callback, att_
     att_set_db(db);
     att_set_read_callback(att_server_read_callback);
     att_set_write_callback(att_server_write_callback);
+
+    att_server_client_supported_features_handle = gatt_server_get_value_handle_for_characteristic_with_uuid16(0x0001, 0xffff, GAP_CLIENT_SUPPORTED_FEATURES);
 }
 
 void att_server_register_packet_handler(btstack_packet_handler_t handler){
@@ -1197,6 +1473,33 @@ int att_server_indicate(hci_con_handle_t con_handle, uint16_t attribute_handle,
     return 0;
 }
 
+int att_server_multiple_notify(hci_con_handle_t con_handle, uint8_t num_attributes,
+                               const uint16_t * attribute_handles, const uint8_t ** values_data, const uint16_t * values_len){
+    att_server_t * att_server = att_server_for_handle(con_handle);
+    if (!att_server) return ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER;
+
+    // only if client has set Multiple Handle Value Notifications bit in Client Supported Features
+    if ((att_server->client_supported_features & GATT_CLIENT_SUPPORTED_FEATURES_MULTIPLE_HANDLE_VALUE_NOTIFICATIONS) == 0u){
+        return ERROR_CODE_COMMAND_DISALLOWED;
+    }
+
+#ifdef ENABLE_GATT_OVER_EATT
+    // use idle EATT bearer if available
+    att_server_eatt_bearer_t * eatt_bearer = att_server_eatt_bearer_for_con_handle(con_handle);
+    if (eatt_bearer != NULL){
+        uint16_t size = att_prepare_handle_value_multiple_notification(&eatt_bearer->att_server.connection, num_attributes, attribute_handles, values_data, values_len, eatt_bearer->send_buffer);
+        return l2cap_le_send_data(eatt_bearer->l2cap_cid, eatt_bearer->send_buffer, size);
+    }
+#endif
+
+    if (!att_server_can_send_packet(att_server)) return BTSTACK_ACL_BUFFERS_FULL;
+
+    l2cap_reserve_packet_buffer();
+    uint8_t * packet_buffer = l2cap_get_outgoing_buffer();
+    uint16_t size = att_prepare_handle_value_multiple_notification(&att_server->connection, num_attributes, attribute_handles, values_data, values_len, packet_buffer);
+    return l2cap_send_prepared_connectionless(att_server->connection.con_handle, L2CAP_CID_ATTRIBUTE_PROTOCOL, size);
+}
+
 uint16_t att_server_get_mtu(hci_con_handle_t con_handle){
     att_server_t * att_server = att_server_for_handle(con_handle);
     if (!att_server) return 0;
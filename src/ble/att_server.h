@@ -124,6 +124,35 @@ int att_server_notify(hci_con_handle_t con_handle, uint16_t attribute_handle, co
  */
 int att_server_indicate(hci_con_handle_t con_handle, uint16_t attribute_handle, const uint8_t *value, uint16_t value_len);
 
+/*
+ * @brief notify client about multiple attribute value changes with a single ATT_MULTIPLE_HANDLE_VALUE_NOTIFICATION
+ * @note only values that fit completely into the ATT MTU are sent. Sent over an idle EATT bearer if available.
+ *       Requires the client to set the Multiple Handle Value Notifications bit in the GATT Client Supported Features
+ *       characteristic, which is handled by the ATT Server if declared as DYNAMIC in the ATT DB
+ * @param con_handle
+ * @param num_attributes
+ * @param attribute_handles list of attribute handles
+ * @param values_data list of pointers to values
+ * @param values_len list of value lengths
+ * @return 0 if ok, ERROR_CODE_COMMAND_DISALLOWED if not supported by client, error otherwise
+ */
+int att_server_multiple_notify(hci_con_handle_t con_handle, uint8_t num_attributes,
+                               const uint16_t * attribute_handles, const uint8_t ** values_data, const uint16_t * values_len);
+
+#ifdef ENABLE_GATT_OVER_EATT
+/**
+ * @brief Accept Enhanced ATT bearers on PSM_EATT using L2CAP Enhanced Credit-Based Flow Control Mode.
+ *        ATT requests received on each bearer are handled in parallel
+ * @note storage_buffer needs to be pointer-aligned and provide room for num_eatt_bearers bearers, each bearer
+ *       uses two ATT_REQUEST_BUFFER_SIZE buffers plus management overhead
+ * @param num_eatt_bearers
+ * @param storage_buffer
+ * @param storage_size
+ * @return status ERROR_CODE_SUCCESS or ERROR_CODE_MEMORY_CAPACITY_EXCEEDED if storage too small
+ */
+uint8_t att_server_eatt_init(uint8_t num_eatt_bearers, uint8_t * storage_buffer, uint16_t storage_size);
+#endif
+
 #ifdef ENABLE_ATT_DELAYED_RESPONSE
 /*
  * @brief response ready - called after returning ATT_READ__RESPONSE_PENDING in an att_read_callback or
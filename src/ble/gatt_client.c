@@ -37,6 +37,7 @@
 
 #define BTSTACK_FILE__ "gatt_client.c"
 
+#include <stddef.h>
 #include <stdint.h>
 #include <string.h>
 
@@ -53,6 +54,7 @@
 #include "btstack_event.h"
 #include "btstack_memory.h"
 #include "btstack_run_loop.h"
+#include "btstack_tlv.h"
 #include "btstack_util.h"
 #include "classic/sdp_util.h"
 #include "hci.h"
@@ -73,12 +75,84 @@ static uint8_t mtu_exchange_enabled;
 static void gatt_client_att_packet_handler(uint8_t packet_type, uint16_t handle, uint8_t *packet, uint16_t size);
 static void gatt_client_event_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size);
 static void gatt_client_report_error_if_pending(gatt_client_t *peripheral, uint8_t att_error_code);
+static void gatt_client_request_queue_abort(gatt_client_t * peripheral, uint8_t att_status);
+static void gatt_client_handle_att_response(gatt_client_t * peripheral, uint8_t * packet, uint16_t size);
+static void gatt_client_run(void);
+#ifdef ENABLE_GATT_OVER_EATT
+static void gatt_client_le_enhanced_bearer_closed(gatt_client_t * eatt_client);
+#endif
+
+// max number of reads combined into a single Read Multiple Variable Length Request
+#ifndef GATT_CLIENT_READ_MULTIPLE_VARIABLE_MAX_HANDLES
+#define GATT_CLIENT_READ_MULTIPLE_VARIABLE_MAX_HANDLES 8
+#endif
+
+// request flags
+#define GATT_CLIENT_REQUEST_FLAG_READ_SINGLE 1u
 
 #ifdef ENABLE_LE_SIGNED_WRITE
 static void att_signed_write_handle_cmac_result(uint8_t hash[8]);
 #endif
 
+#ifdef ENABLE_GATT_CLIENT_CACHE
+
+#ifndef GATT_CLIENT_CACHE_MAX_ENTRIES
+#define GATT_CLIENT_CACHE_MAX_ENTRIES 32
+#endif
+
+// cache flags
+#define GATT_CLIENT_CACHE_FLAG_SERVICES_COMPLETE        1u
+#define GATT_CLIENT_CACHE_FLAG_DATABASE_HASH            2u
+
+// entry flags
+#define GATT_CLIENT_CACHE_FLAG_CHARACTERISTICS_COMPLETE 1u
+#define GATT_CLIENT_CACHE_FLAG_DESCRIPTORS_COMPLETE     2u
+
+#define GATT_CLIENT_CACHE_ENTRY_SERVICE        1u
+#define GATT_CLIENT_CACHE_ENTRY_CHARACTERISTIC 2u
+#define GATT_CLIENT_CACHE_ENTRY_DESCRIPTOR     3u
+
+// primary service, characteristic or characteristic descriptor
+typedef struct {
+    uint8_t  type;
+    uint8_t  flags;
+    uint16_t start_handle;
+    uint16_t value_handle;
+    uint16_t end_handle;
+    uint16_t properties;
+    uint8_t  uuid128[16];
+} gatt_client_cache_entry_t;
+
+// attribute table of a bonded device, only the used entries are stored in TLV
+typedef struct {
+    bd_addr_t addr;
+    uint8_t   addr_type;
+    uint8_t   flags;
+    uint8_t   database_hash[16];
+    uint16_t  service_changed_handle;
+    uint16_t  num_entries;
+    gatt_client_cache_entry_t entries[GATT_CLIENT_CACHE_MAX_ENTRIES];
+} gatt_client_cache_t;
+
+// single working copy, written back to TLV on query complete or when another device is selected
+static gatt_client_cache_t gatt_client_cache;
+static int                 gatt_client_cache_device_index;
+static uint8_t             gatt_client_cache_dirty;
+
+// queries answered from cache are reported from the run loop instead of from within the discovery call
+static btstack_timer_source_t gatt_client_cache_report_timer;
+
+static void gatt_client_cache_add_entry(gatt_client_t * peripheral, uint8_t type, uint16_t start_handle, uint16_t value_handle, uint16_t end_handle, uint16_t properties, const uint8_t * uuid128);
+static void gatt_client_cache_query_complete(gatt_client_t * peripheral, uint8_t att_status);
+#endif
+
 static uint16_t peripheral_mtu(gatt_client_t *peripheral){
+#ifdef ENABLE_GATT_OVER_EATT
+    // EATT MTU is limited by bearer buffers
+    if (peripheral->l2cap_cid != 0){
+        return peripheral->mtu;
+    }
+#endif
     if (peripheral->mtu > l2cap_max_le_mtu()){
         log_error("Peripheral mtu is not initialized");
         return l2cap_max_le_mtu();
@@ -86,9 +160,34 @@ static uint16_t peripheral_mtu(gatt_client_t *peripheral){
     return peripheral->mtu;
 }
 
+static uint8_t * gatt_client_reserve_request_buffer(gatt_client_t * gatt_client){
+#ifdef ENABLE_GATT_OVER_EATT
+    if (gatt_client->l2cap_cid != 0){
+        return gatt_client->eatt_send_buffer;
+    }
+#else
+    UNUSED(gatt_client);
+#endif
+    l2cap_reserve_packet_buffer();
+    return l2cap_get_outgoing_buffer();
+}
+
+static uint8_t gatt_client_send(gatt_client_t * gatt_client, uint16_t len){
+#ifdef ENABLE_GATT_OVER_EATT
+    if (gatt_client->l2cap_cid != 0){
+        return l2cap_le_send_data(gatt_client->l2cap_cid, gatt_client->eatt_send_buffer, len);
+    }
+#endif
+    return l2cap_send_prepared_connectionless(gatt_client->con_handle, L2CAP_CID_ATTRIBUTE_PROTOCOL, len);
+}
+
 void gatt_client_init(void){
     gatt_client_connections = NULL;
     mtu_exchange_enabled = 1;
+#ifdef ENABLE_GATT_CLIENT_CACHE
+    gatt_client_cache_device_index = -1;
+    gatt_client_cache_dirty = 0;
+#endif
 
     // regsister for HCI Events
     hci_event_callback_registration.callback = &gatt_client_event_packet_handler;
@@ -112,6 +211,16 @@ static gatt_client_t * gatt_client_for_timer(btstack_timer_source_t * ts){
         if ( &peripheral->gc_timeout == ts) {
             return peripheral;
         }
+#ifdef ENABLE_GATT_OVER_EATT
+        btstack_linked_list_iterator_t eatt_it;
+        btstack_linked_list_iterator_init(&eatt_it, &peripheral->eatt_clients);
+        while (btstack_linked_list_iterator_has_next(&eatt_it)){
+            gatt_client_t * eatt_client = (gatt_client_t *) btstack_linked_list_iterator_next(&eatt_it);
+            if ( &eatt_client->gc_timeout == ts) {
+                return eatt_client;
+            }
+        }
+#endif
     }
     return NULL;
 }
@@ -170,13 +279,38 @@ static gatt_client_t * provide_context_for_conn_handle(hci_con_handle_t con_hand
         context->mtu_state = MTU_AUTO_EXCHANGE_DISABLED;
     }
     context->gatt_client_state = P_READY;
+#ifdef ENABLE_GATT_CLIENT_CACHE
+    context->cache_state = GATT_CLIENT_CACHE_IDLE;
+    context->cache_query = GATT_CLIENT_CACHE_QUERY_NONE;
+    context->cache_device_index = -1;
+#endif
     btstack_linked_list_add(&gatt_client_connections, (btstack_linked_item_t*)context);
     return context;
 }
 
+#ifdef ENABLE_GATT_OVER_EATT
+// use first idle EATT bearer, fall back to unenhanced bearer
+static gatt_client_t * gatt_client_select_bearer(gatt_client_t * gatt_client){
+    btstack_linked_list_iterator_t it;
+    btstack_linked_list_iterator_init(&it, &gatt_client->eatt_clients);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        gatt_client_t * eatt_client = (gatt_client_t *) btstack_linked_list_iterator_next(&it);
+        if (eatt_client->gatt_client_state != P_READY) continue;
+        if (!btstack_linked_list_empty(&eatt_client->request_queue)) continue;
+        return eatt_client;
+    }
+    return gatt_client;
+}
+#endif
+
 static gatt_client_t * provide_context_for_conn_handle_and_start_timer(hci_con_handle_t con_handle){
     gatt_client_t * context = provide_context_for_conn_handle(con_handle);
     if (context == NULL) return NULL;
+#ifdef ENABLE_GATT_OVER_EATT
+    if (context->gatt_client_state != P_READY){
+        context = gatt_client_select_bearer(context);
+    }
+#endif
     gatt_client_timeout_start(context);
     return context;
 }
@@ -208,29 +342,26 @@ uint8_t gatt_client_get_mtu(hci_con_handle_t con_handle, uint16_t * mtu){
 }
 
 // precondition: can_send_packet_now == TRUE
-static uint8_t att_confirmation(uint16_t peripheral_handle){
-    l2cap_reserve_packet_buffer();
-    uint8_t * request = l2cap_get_outgoing_buffer();
+static uint8_t att_confirmation(gatt_client_t * gatt_client){
+    uint8_t * request = gatt_client_reserve_request_buffer(gatt_client);
     request[0] = ATT_HANDLE_VALUE_CONFIRMATION;
     
-    return l2cap_send_prepared_connectionless(peripheral_handle, L2CAP_CID_ATTRIBUTE_PROTOCOL, 1);
+    return gatt_client_send(gatt_client, 1);
 }
 
 // precondition: can_send_packet_now == TRUE
-static uint8_t att_find_information_request(uint16_t request_type, uint16_t peripheral_handle, uint16_t start_handle, uint16_t end_handle){
-    l2cap_reserve_packet_buffer();
-    uint8_t * request = l2cap_get_outgoing_buffer();
+static uint8_t att_find_information_request(uint16_t request_type, gatt_client_t * gatt_client, uint16_t start_handle, uint16_t end_handle){
+    uint8_t * request = gatt_client_reserve_request_buffer(gatt_client);
     request[0] = request_type;
     little_endian_store_16(request, 1, start_handle);
     little_endian_store_16(request, 3, end_handle);
     
-    return l2cap_send_prepared_connectionless(peripheral_handle, L2CAP_CID_ATTRIBUTE_PROTOCOL, 5);
+    return gatt_client_send(gatt_client, 5);
 }
 
 // precondition: can_send_packet_now == TRUE
-static uint8_t att_find_by_type_value_request(uint16_t request_type, uint16_t attribute_group_type, uint16_t peripheral_handle, uint16_t start_handle, uint16_t end_handle, uint8_t * value, uint16_t value_size){
-    l2cap_reserve_packet_buffer();
-    uint8_t * request = l2cap_get_outgoing_buffer();
+static uint8_t att_find_by_type_value_request(uint16_t request_type, uint16_t attribute_group_type, gatt_client_t * gatt_client, uint16_t start_handle, uint16_t end_handle, uint8_t * value, uint16_t value_size){
+    uint8_t * request = gatt_client_reserve_request_buffer(gatt_client);
     
     request[0] = request_type;
     little_endian_store_16(request, 1, start_handle);
@@ -238,58 +369,53 @@ static uint8_t att_find_by_type_value_request(uint16_t request_type, uint16_t at
     little_endian_store_16(request, 5, attribute_group_type);
     (void)memcpy(&request[7], value, value_size);
     
-    return l2cap_send_prepared_connectionless(peripheral_handle, L2CAP_CID_ATTRIBUTE_PROTOCOL, 7u+value_size);
+    return gatt_client_send(gatt_client, 7u+value_size);
 }
 
 // precondition: can_send_packet_now == TRUE
-static uint8_t att_read_by_type_or_group_request_for_uuid16(uint16_t request_type, uint16_t uuid16, uint16_t peripheral_handle, uint16_t start_handle, uint16_t end_handle){
-    l2cap_reserve_packet_buffer();
-    uint8_t * request = l2cap_get_outgoing_buffer();
+static uint8_t att_read_by_type_or_group_request_for_uuid16(uint16_t request_type, uint16_t uuid16, gatt_client_t * gatt_client, uint16_t start_handle, uint16_t end_handle){
+    uint8_t * request = gatt_client_reserve_request_buffer(gatt_client);
     request[0] = request_type;
     little_endian_store_16(request, 1, start_handle);
     little_endian_store_16(request, 3, end_handle);
     little_endian_store_16(request, 5, uuid16);
     
-    return l2cap_send_prepared_connectionless(peripheral_handle, L2CAP_CID_ATTRIBUTE_PROTOCOL, 7);
+    return gatt_client_send(gatt_client, 7);
 }
 
 // precondition: can_send_packet_now == TRUE
-static uint8_t att_read_by_type_or_group_request_for_uuid128(uint16_t request_type, uint8_t * uuid128, uint16_t peripheral_handle, uint16_t start_handle, uint16_t end_handle){
-    l2cap_reserve_packet_buffer();
-    uint8_t * request = l2cap_get_outgoing_buffer();
+static uint8_t att_read_by_type_or_group_request_for_uuid128(uint16_t request_type, uint8_t * uuid128, gatt_client_t * gatt_client, uint16_t start_handle, uint16_t end_handle){
+    uint8_t * request = gatt_client_reserve_request_buffer(gatt_client);
     request[0] = request_type;
     little_endian_store_16(request, 1, start_handle);
     little_endian_store_16(request, 3, end_handle);
     reverse_128(uuid128, &request[5]);
     
-    return l2cap_send_prepared_connectionless(peripheral_handle, L2CAP_CID_ATTRIBUTE_PROTOCOL, 21);
+    return gatt_client_send(gatt_client, 21);
 }
 
 // precondition: can_send_packet_now == TRUE
-static uint8_t att_read_request(uint16_t request_type, uint16_t peripheral_handle, uint16_t attribute_handle){
-    l2cap_reserve_packet_buffer();
-    uint8_t * request = l2cap_get_outgoing_buffer();
+static uint8_t att_read_request(uint16_t request_type, gatt_client_t * gatt_client, uint16_t attribute_handle){
+    uint8_t * request = gatt_client_reserve_request_buffer(gatt_client);
     request[0] = request_type;
     little_endian_store_16(request, 1, attribute_handle);
     
-    return l2cap_send_prepared_connectionless(peripheral_handle, L2CAP_CID_ATTRIBUTE_PROTOCOL, 3);
+    return gatt_client_send(gatt_client, 3);
 }
 
 // precondition: can_send_packet_now == TRUE
-static uint8_t att_read_blob_request(uint16_t request_type, uint16_t peripheral_handle, uint16_t attribute_handle, uint16_t value_offset){
-    l2cap_reserve_packet_buffer();
-    uint8_t * request = l2cap_get_outgoing_buffer();
+static uint8_t att_read_blob_request(uint16_t request_type, gatt_client_t * gatt_client, uint16_t attribute_handle, uint16_t value_offset){
+    uint8_t * request = gatt_client_reserve_request_buffer(gatt_client);
     request[0] = request_type;
     little_endian_store_16(request, 1, attribute_handle);
     little_endian_store_16(request, 3, value_offset);
     
-    return l2cap_send_prepared_connectionless(peripheral_handle, L2CAP_CID_ATTRIBUTE_PROTOCOL, 5);
+    return gatt_client_send(gatt_client, 5);
 }
 
-static uint8_t att_read_multiple_request(uint16_t peripheral_handle, uint16_t num_value_handles, uint16_t * value_handles){
-    l2cap_reserve_packet_buffer();
-    uint8_t * request = l2cap_get_outgoing_buffer();
-    request[0] = ATT_READ_MULTIPLE_REQUEST;
+static uint8_t att_read_multiple_request(uint16_t request_type, gatt_client_t * gatt_client, uint16_t num_value_handles, uint16_t * value_handles){
+    uint8_t * request = gatt_client_reserve_request_buffer(gatt_client);
+    request[0] = request_type;
     int i;
     int offset = 1;
     for (i=0;i<num_value_handles;i++){
@@ -297,65 +423,60 @@ static uint8_t att_read_multiple_request(uint16_t peripheral_handle, uint16_t nu
         offset += 2;
     }
 
-    return l2cap_send_prepared_connectionless(peripheral_handle, L2CAP_CID_ATTRIBUTE_PROTOCOL, offset);
+    return gatt_client_send(gatt_client, offset);
 }
 
 #ifdef ENABLE_LE_SIGNED_WRITE
 // precondition: can_send_packet_now == TRUE
-static uint8_t att_signed_write_request(uint16_t request_type, uint16_t peripheral_handle, uint16_t attribute_handle, uint16_t value_length, uint8_t * value, uint32_t sign_counter, uint8_t sgn[8]){
-    l2cap_reserve_packet_buffer();
-    uint8_t * request = l2cap_get_outgoing_buffer();
+static uint8_t att_signed_write_request(uint16_t request_type, gatt_client_t * gatt_client, uint16_t attribute_handle, uint16_t value_length, uint8_t * value, uint32_t sign_counter, uint8_t sgn[8]){
+    uint8_t * request = gatt_client_reserve_request_buffer(gatt_client);
     request[0] = request_type;
     little_endian_store_16(request, 1, attribute_handle);
     (void)memcpy(&request[3], value, value_length);
     little_endian_store_32(request, 3 + value_length, sign_counter);
     reverse_64(sgn, &request[3 + value_length + 4]);
     
-    return l2cap_send_prepared_connectionless(peripheral_handle, L2CAP_CID_ATTRIBUTE_PROTOCOL, 3 + value_length + 12);
+    return gatt_client_send(gatt_client, 3 + value_length + 12);
 }
 #endif
 
 // precondition: can_send_packet_now == TRUE
-static uint8_t att_write_request(uint16_t request_type, uint16_t peripheral_handle, uint16_t attribute_handle, uint16_t value_length, uint8_t * value){
-    l2cap_reserve_packet_buffer();
-    uint8_t * request = l2cap_get_outgoing_buffer();
+static uint8_t att_write_request(uint16_t request_type, gatt_client_t * gatt_client, uint16_t attribute_handle, uint16_t value_length, uint8_t * value){
+    uint8_t * request = gatt_client_reserve_request_buffer(gatt_client);
     request[0] = request_type;
     little_endian_store_16(request, 1, attribute_handle);
     (void)memcpy(&request[3], value, value_length);
     
-    return l2cap_send_prepared_connectionless(peripheral_handle, L2CAP_CID_ATTRIBUTE_PROTOCOL, 3u + value_length);
+    return gatt_client_send(gatt_client, 3u + value_length);
 }
 
 // precondition: can_send_packet_now == TRUE
-static uint8_t att_execute_write_request(uint16_t request_type, uint16_t peripheral_handle, uint8_t execute_write){
-    l2cap_reserve_packet_buffer();
-    uint8_t * request = l2cap_get_outgoing_buffer();
+static uint8_t att_execute_write_request(uint16_t request_type, gatt_client_t * gatt_client, uint8_t execute_write){
+    uint8_t * request = gatt_client_reserve_request_buffer(gatt_client);
     request[0] = request_type;
     request[1] = execute_write;
     
-    return l2cap_send_prepared_connectionless(peripheral_handle, L2CAP_CID_ATTRIBUTE_PROTOCOL, 2);
+    return gatt_client_send(gatt_client, 2);
 }
 
 // precondition: can_send_packet_now == TRUE
-static uint8_t att_prepare_write_request(uint16_t request_type, uint16_t peripheral_handle,  uint16_t attribute_handle, uint16_t value_offset, uint16_t blob_length, uint8_t * value){
-    l2cap_reserve_packet_buffer();
-    uint8_t * request = l2cap_get_outgoing_buffer();
+static uint8_t att_prepare_write_request(uint16_t request_type, gatt_client_t * gatt_client,  uint16_t attribute_handle, uint16_t value_offset, uint16_t blob_length, uint8_t * value){
+    uint8_t * request = gatt_client_reserve_request_buffer(gatt_client);
     request[0] = request_type;
     little_endian_store_16(request, 1, attribute_handle);
     little_endian_store_16(request, 3, value_offset);
     (void)memcpy(&request[5], &value[value_offset], blob_length);
     
-    return l2cap_send_prepared_connectionless(peripheral_handle, L2CAP_CID_ATTRIBUTE_PROTOCOL, 5u+blob_length);
+    return gatt_client_send(gatt_client, 5u+blob_length);
 }
 
-static uint8_t att_exchange_mtu_request(uint16_t peripheral_handle){
+static uint8_t att_exchange_mtu_request(gatt_client_t * gatt_client){
     uint16_t mtu = l2cap_max_le_mtu();
-    l2cap_reserve_packet_buffer();
-    uint8_t * request = l2cap_get_outgoing_buffer();
+    uint8_t * request = gatt_client_reserve_request_buffer(gatt_client);
     request[0] = ATT_EXCHANGE_MTU_REQUEST;
     little_endian_store_16(request, 1, mtu);
     
-    return l2cap_send_prepared_connectionless(peripheral_handle, L2CAP_CID_ATTRIBUTE_PROTOCOL, 3);
+    return gatt_client_send(gatt_client, 3);
 }
 
 static uint16_t write_blob_length(gatt_client_t * peripheral){
@@ -371,19 +492,19 @@ static uint16_t write_blob_length(gatt_client_t * peripheral){
 }
 
 static void send_gatt_services_request(gatt_client_t *peripheral){
-    att_read_by_type_or_group_request_for_uuid16(ATT_READ_BY_GROUP_TYPE_REQUEST, GATT_PRIMARY_SERVICE_UUID, peripheral->con_handle, peripheral->start_group_handle, peripheral->end_group_handle);
+    att_read_by_type_or_group_request_for_uuid16(ATT_READ_BY_GROUP_TYPE_REQUEST, GATT_PRIMARY_SERVICE_UUID, peripheral, peripheral->start_group_handle, peripheral->end_group_handle);
 }
 
 static void send_gatt_by_uuid_request(gatt_client_t *peripheral, uint16_t attribute_group_type){
     if (peripheral->uuid16){
         uint8_t uuid16[2];
         little_endian_store_16(uuid16, 0, peripheral->uuid16);
-        att_find_by_type_value_request(ATT_FIND_BY_TYPE_VALUE_REQUEST, attribute_group_type, peripheral->con_handle, peripheral->start_group_handle, peripheral->end_group_handle, uuid16, 2);
+        att_find_by_type_value_request(ATT_FIND_BY_TYPE_VALUE_REQUEST, attribute_group_type, peripheral, peripheral->start_group_handle, peripheral->end_group_handle, uuid16, 2);
         return;
     }
     uint8_t uuid128[16];
     reverse_128(peripheral->uuid128, uuid128);
-    att_find_by_type_value_request(ATT_FIND_BY_TYPE_VALUE_REQUEST, attribute_group_type, peripheral->con_handle, peripheral->start_group_handle, peripheral->end_group_handle, uuid128, 16);
+    att_find_by_type_value_request(ATT_FIND_BY_TYPE_VALUE_REQUEST, attribute_group_type, peripheral, peripheral->start_group_handle, peripheral->end_group_handle, uuid128, 16);
 }
 
 static void send_gatt_services_by_uuid_request(gatt_client_t *peripheral){
@@ -391,74 +512,74 @@ static void send_gatt_services_by_uuid_request(gatt_client_t *peripheral){
 }
 
 static void send_gatt_included_service_uuid_request(gatt_client_t *peripheral){
-    att_read_request(ATT_READ_REQUEST, peripheral->con_handle, peripheral->query_start_handle);
+    att_read_request(ATT_READ_REQUEST, peripheral, peripheral->query_start_handle);
 }
 
 static void send_gatt_included_service_request(gatt_client_t *peripheral){
-    att_read_by_type_or_group_request_for_uuid16(ATT_READ_BY_TYPE_REQUEST, GATT_INCLUDE_SERVICE_UUID, peripheral->con_handle, peripheral->start_group_handle, peripheral->end_group_handle);
+    att_read_by_type_or_group_request_for_uuid16(ATT_READ_BY_TYPE_REQUEST, GATT_INCLUDE_SERVICE_UUID, peripheral, peripheral->start_group_handle, peripheral->end_group_handle);
 }
 
 static void send_gatt_characteristic_request(gatt_client_t *peripheral){
-    att_read_by_type_or_group_request_for_uuid16(ATT_READ_BY_TYPE_REQUEST, GATT_CHARACTERISTICS_UUID, peripheral->con_handle, peripheral->start_group_handle, peripheral->end_group_handle);
+    att_read_by_type_or_group_request_for_uuid16(ATT_READ_BY_TYPE_REQUEST, GATT_CHARACTERISTICS_UUID, peripheral, peripheral->start_group_handle, peripheral->end_group_handle);
 }
 
 static void send_gatt_characteristic_descriptor_request(gatt_client_t *peripheral){
-    att_find_information_request(ATT_FIND_INFORMATION_REQUEST, peripheral->con_handle, peripheral->start_group_handle, peripheral->end_group_handle);
+    att_find_information_request(ATT_FIND_INFORMATION_REQUEST, peripheral, peripheral->start_group_handle, peripheral->end_group_handle);
 }
 
 static void send_gatt_read_characteristic_value_request(gatt_client_t *peripheral){
-    att_read_request(ATT_READ_REQUEST, peripheral->con_handle, peripheral->attribute_handle);
+    att_read_request(ATT_READ_REQUEST, peripheral, peripheral->attribute_handle);
 }
 
 static void send_gatt_read_by_type_request(gatt_client_t * peripheral){
     if (peripheral->uuid16){
-        att_read_by_type_or_group_request_for_uuid16(ATT_READ_BY_TYPE_REQUEST, peripheral->uuid16, peripheral->con_handle, peripheral->start_group_handle, peripheral->end_group_handle);
+        att_read_by_type_or_group_request_for_uuid16(ATT_READ_BY_TYPE_REQUEST, peripheral->uuid16, peripheral, peripheral->start_group_handle, peripheral->end_group_handle);
     } else {
-        att_read_by_type_or_group_request_for_uuid128(ATT_READ_BY_TYPE_REQUEST, peripheral->uuid128, peripheral->con_handle, peripheral->start_group_handle, peripheral->end_group_handle);
+        att_read_by_type_or_group_request_for_uuid128(ATT_READ_BY_TYPE_REQUEST, peripheral->uuid128, peripheral, peripheral->start_group_handle, peripheral->end_group_handle);
     }
 }
 
 static void send_gatt_read_blob_request(gatt_client_t *peripheral){
-    att_read_blob_request(ATT_READ_BLOB_REQUEST, peripheral->con_handle, peripheral->attribute_handle, peripheral->attribute_offset);
+    att_read_blob_request(ATT_READ_BLOB_REQUEST, peripheral, peripheral->attribute_handle, peripheral->attribute_offset);
 }
 
 static void send_gatt_read_multiple_request(gatt_client_t * peripheral){
-    att_read_multiple_request(peripheral->con_handle, peripheral->read_multiple_handle_count, peripheral->read_multiple_handles);
+    att_read_multiple_request(ATT_READ_MULTIPLE_REQUEST, peripheral, peripheral->read_multiple_handle_count, peripheral->read_multiple_handles);
 }
 
 static void send_gatt_write_attribute_value_request(gatt_client_t * peripheral){
-    att_write_request(ATT_WRITE_REQUEST, peripheral->con_handle, peripheral->attribute_handle, peripheral->attribute_length, peripheral->attribute_value);
+    att_write_request(ATT_WRITE_REQUEST, peripheral, peripheral->attribute_handle, peripheral->attribute_length, peripheral->attribute_value);
 }
 
 static void send_gatt_write_client_characteristic_configuration_request(gatt_client_t * peripheral){
-    att_write_request(ATT_WRITE_REQUEST, peripheral->con_handle, peripheral->client_characteristic_configuration_handle, 2, peripheral->client_characteristic_configuration_value);
+    att_write_request(ATT_WRITE_REQUEST, peripheral, peripheral->client_characteristic_configuration_handle, 2, peripheral->client_characteristic_configuration_value);
 }
 
 static void send_gatt_prepare_write_request(gatt_client_t * peripheral){
-    att_prepare_write_request(ATT_PREPARE_WRITE_REQUEST, peripheral->con_handle, peripheral->attribute_handle, peripheral->attribute_offset, write_blob_length(peripheral), peripheral->attribute_value);
+    att_prepare_write_request(ATT_PREPARE_WRITE_REQUEST, peripheral, peripheral->attribute_handle, peripheral->attribute_offset, write_blob_length(peripheral), peripheral->attribute_value);
 }
 
 static void send_gatt_execute_write_request(gatt_client_t * peripheral){
-    att_execute_write_request(ATT_EXECUTE_WRITE_REQUEST, peripheral->con_handle, 1);
+    att_execute_write_request(ATT_EXECUTE_WRITE_REQUEST, peripheral, 1);
 }
 
 static void send_gatt_cancel_prepared_write_request(gatt_client_t * peripheral){
-    att_execute_write_request(ATT_EXECUTE_WRITE_REQUEST, peripheral->con_handle, 0);
+    att_execute_write_request(ATT_EXECUTE_WRITE_REQUEST, peripheral, 0);
 }
 
 #ifndef ENABLE_GATT_FIND_INFORMATION_FOR_CCC_DISCOVERY
 static void send_gatt_read_client_characteristic_configuration_request(gatt_client_t * peripheral){
-    att_read_by_type_or_group_request_for_uuid16(ATT_READ_BY_TYPE_REQUEST, GATT_CLIENT_CHARACTERISTICS_CONFIGURATION, peripheral->con_handle, peripheral->start_group_handle, peripheral->end_group_handle);
+    att_read_by_type_or_group_request_for_uuid16(ATT_READ_BY_TYPE_REQUEST, GATT_CLIENT_CHARACTERISTICS_CONFIGURATION, peripheral, peripheral->start_group_handle, peripheral->end_group_handle);
 }
 #endif
 
 static void send_gatt_read_characteristic_descriptor_request(gatt_client_t * peripheral){
-    att_read_request(ATT_READ_REQUEST, peripheral->con_handle, peripheral->attribute_handle);
+    att_read_request(ATT_READ_REQUEST, peripheral, peripheral->attribute_handle);
 }
 
 #ifdef ENABLE_LE_SIGNED_WRITE
 static void send_gatt_signed_write_request(gatt_client_t * peripheral, uint32_t sign_counter){
-    att_signed_write_request(ATT_SIGNED_WRITE_COMMAND, peripheral->con_handle, peripheral->attribute_handle, peripheral->attribute_length, peripheral->attribute_value, sign_counter, peripheral->cmac);
+    att_signed_write_request(ATT_SIGNED_WRITE_COMMAND, peripheral, peripheral->attribute_handle, peripheral->attribute_length, peripheral->attribute_value, sign_counter, peripheral->cmac);
 }
 #endif
 
@@ -521,6 +642,9 @@ static void emit_gatt_complete_event(gatt_client_t * peripheral, uint8_t att_sta
     packet[1] = 3;
     little_endian_store_16(packet, 2, peripheral->con_handle);
     packet[4] = att_status;
+#ifdef ENABLE_GATT_CLIENT_CACHE
+    gatt_client_cache_query_complete(peripheral, att_status);
+#endif
     emit_event_new(peripheral->callback, packet, sizeof(packet));
 }
 
@@ -534,6 +658,9 @@ static void emit_gatt_service_query_result_event(gatt_client_t * peripheral, uin
     little_endian_store_16(packet, 4, start_group_handle);
     little_endian_store_16(packet, 6, end_group_handle);
     reverse_128(uuid128, &packet[8]);
+#ifdef ENABLE_GATT_CLIENT_CACHE
+    gatt_client_cache_add_entry(peripheral, GATT_CLIENT_CACHE_ENTRY_SERVICE, start_group_handle, 0, end_group_handle, 0, uuid128);
+#endif
     emit_event_new(peripheral->callback, packet, sizeof(packet));
 }
 
@@ -565,6 +692,9 @@ static void emit_gatt_characteristic_query_result_event(gatt_client_t * peripher
     little_endian_store_16(packet, 8,  end_handle);
     little_endian_store_16(packet, 10, properties);
     reverse_128(uuid128, &packet[12]);
+#ifdef ENABLE_GATT_CLIENT_CACHE
+    gatt_client_cache_add_entry(peripheral, GATT_CLIENT_CACHE_ENTRY_CHARACTERISTIC, start_handle, value_handle, end_handle, properties, uuid128);
+#endif
     emit_event_new(peripheral->callback, packet, sizeof(packet));
 }
 
@@ -578,6 +708,9 @@ static void emit_gatt_all_characteristic_descriptors_result_event(
     ///
     little_endian_store_16(packet, 4,  descriptor_handle);
     reverse_128(uuid128, &packet[6]);
+#ifdef ENABLE_GATT_CLIENT_CACHE
+    gatt_client_cache_add_entry(peripheral, GATT_CLIENT_CACHE_ENTRY_DESCRIPTOR, descriptor_handle, 0, descriptor_handle, 0, uuid128);
+#endif
     emit_event_new(peripheral->callback, packet, sizeof(packet));
 }
 
@@ -591,6 +724,412 @@ static void emit_gatt_mtu_exchanged_result_event(gatt_client_t * peripheral, uin
     att_dispatch_client_mtu_exchanged(peripheral->con_handle, new_mtu);
     emit_event_new(peripheral->callback, packet, sizeof(packet));
 }
+#ifdef ENABLE_GATT_CLIENT_CACHE
+// ---------------------
+// GATT Client Cache
+
+static uint32_t gatt_client_cache_tag_for_index(uint8_t index){
+    return ('B' << 24u) | ('T' << 16u) | ('G' << 8u) | index;
+}
+
+static uint32_t gatt_client_cache_size(void){
+    return offsetof(gatt_client_cache_t, entries) + (gatt_client_cache.num_entries * sizeof(gatt_client_cache_entry_t));
+}
+
+static void gatt_client_cache_reset(int le_device_index){
+    int addr_type;
+    memset(&gatt_client_cache, 0, offsetof(gatt_client_cache_t, entries));
+    le_device_db_info(le_device_index, &addr_type, gatt_client_cache.addr, NULL);
+    gatt_client_cache.addr_type = (uint8_t) addr_type;
+}
+
+static void gatt_client_cache_store(void){
+    if (gatt_client_cache_dirty == 0u) return;
+    gatt_client_cache_dirty = 0;
+    if (gatt_client_cache_device_index < 0) return;
+
+    // get btstack_tlv
+    const btstack_tlv_t * tlv_impl = NULL;
+    void * tlv_context;
+    btstack_tlv_get_instance(&tlv_impl, &tlv_context);
+    if (!tlv_impl) return;
+
+    uint32_t tag = gatt_client_cache_tag_for_index(gatt_client_cache_device_index);
+    int result = tlv_impl->store_tag(tlv_context, tag, (const uint8_t *) &gatt_client_cache, gatt_client_cache_size());
+    if (result != 0){
+        log_error("GATT Client Cache: store for le device %d failed", gatt_client_cache_device_index);
+    }
+}
+
+// make cache of given device the working copy
+static void gatt_client_cache_select(int le_device_index){
+    if (gatt_client_cache_device_index == le_device_index) return;
+
+    // write back current device
+    gatt_client_cache_store();
+    gatt_client_cache_device_index = le_device_index;
+
+    // get btstack_tlv
+    const btstack_tlv_t * tlv_impl = NULL;
+    void * tlv_context;
+    btstack_tlv_get_instance(&tlv_impl, &tlv_context);
+
+    int len = 0;
+    if (tlv_impl){
+        uint32_t tag = gatt_client_cache_tag_for_index(le_device_index);
+        len = tlv_impl->get_tag(tlv_context, tag, (uint8_t *) &gatt_client_cache, sizeof(gatt_client_cache_t));
+    }
+
+    // validate size and owner, the device db index might have been re-used for another device
+    int addr_type;
+    bd_addr_t addr;
+    le_device_db_info(le_device_index, &addr_type, addr, NULL);
+    bool valid = (len >= (int) offsetof(gatt_client_cache_t, entries))
+              && (gatt_client_cache.num_entries <= GATT_CLIENT_CACHE_MAX_ENTRIES)
+              && (len == (int) gatt_client_cache_size())
+              && (gatt_client_cache.addr_type == (uint8_t) addr_type)
+              && (bd_addr_cmp(gatt_client_cache.addr, addr) == 0);
+    if (!valid){
+        gatt_client_cache_reset(le_device_index);
+    }
+    log_info("GATT Client Cache: le device %d, %u entries", le_device_index, gatt_client_cache.num_entries);
+}
+
+static gatt_client_cache_entry_t * gatt_client_cache_find_entry(uint8_t type, uint16_t start_handle){
+    uint16_t i;
+    for (i=0;i<gatt_client_cache.num_entries;i++){
+        gatt_client_cache_entry_t * entry = &gatt_client_cache.entries[i];
+        if (entry->type != type) continue;
+        if (entry->start_handle != start_handle) continue;
+        return entry;
+    }
+    return NULL;
+}
+
+// characteristic for descriptor query range
+static gatt_client_cache_entry_t * gatt_client_cache_find_characteristic(uint16_t start_handle, uint16_t end_handle){
+    uint16_t i;
+    for (i=0;i<gatt_client_cache.num_entries;i++){
+        gatt_client_cache_entry_t * entry = &gatt_client_cache.entries[i];
+        if (entry->type != GATT_CLIENT_CACHE_ENTRY_CHARACTERISTIC) continue;
+        if ((entry->value_handle + 1u) != start_handle) continue;
+        if (entry->end_handle != end_handle) continue;
+        return entry;
+    }
+    return NULL;
+}
+
+void gatt_client_cache_delete(int le_device_index){
+    if (le_device_index < 0) return;
+    log_info("GATT Client Cache: delete for le device %d", le_device_index);
+
+    // drop working copy
+    if (gatt_client_cache_device_index == le_device_index){
+        gatt_client_cache_device_index = -1;
+        gatt_client_cache_dirty = 0;
+    }
+
+    // get btstack_tlv
+    const btstack_tlv_t * tlv_impl = NULL;
+    void * tlv_context;
+    btstack_tlv_get_instance(&tlv_impl, &tlv_context);
+    if (tlv_impl){
+        tlv_impl->delete_tag(tlv_context, gatt_client_cache_tag_for_index(le_device_index));
+    }
+
+    // re-validate on next discovery, stop recording of active queries
+    btstack_linked_item_t *it;
+    for (it = (btstack_linked_item_t *) gatt_client_connections; it != NULL; it = it->next){
+        gatt_client_t * peripheral = (gatt_client_t *) it;
+        if (peripheral->cache_device_index != le_device_index) continue;
+        if (peripheral->cache_state == GATT_CLIENT_CACHE_ACTIVE){
+            peripheral->cache_state = GATT_CLIENT_CACHE_IDLE;
+        }
+        // pending report falls back to query over the air
+        if ((peripheral->cache_query != GATT_CLIENT_CACHE_QUERY_NONE) && (peripheral->cache_query != GATT_CLIENT_CACHE_QUERY_REPORT)){
+            peripheral->cache_query = GATT_CLIENT_CACHE_QUERY_BYPASS;
+        }
+    }
+}
+
+static void gatt_client_cache_add_entry(gatt_client_t * peripheral, uint8_t type, uint16_t start_handle, uint16_t value_handle, uint16_t end_handle, uint16_t properties, const uint8_t * uuid128){
+    // services found by UUID are recorded to allow caching of their characteristics
+    switch (peripheral->cache_query){
+        case GATT_CLIENT_CACHE_QUERY_SERVICES:
+        case GATT_CLIENT_CACHE_QUERY_SERVICES_BY_UUID:
+        case GATT_CLIENT_CACHE_QUERY_CHARACTERISTICS:
+        case GATT_CLIENT_CACHE_QUERY_DESCRIPTORS:
+            break;
+        default:
+            return;
+    }
+
+    gatt_client_cache_select(peripheral->cache_device_index);
+
+    gatt_client_cache_entry_t * entry = gatt_client_cache_find_entry(type, start_handle);
+    if (entry == NULL){
+        if (gatt_client_cache.num_entries >= GATT_CLIENT_CACHE_MAX_ENTRIES){
+            log_info("GATT Client Cache: full, increase GATT_CLIENT_CACHE_MAX_ENTRIES");
+            peripheral->cache_recording_failed = 1;
+            return;
+        }
+        entry = &gatt_client_cache.entries[gatt_client_cache.num_entries++];
+        entry->flags = 0;
+    }
+    entry->type         = type;
+    entry->start_handle = start_handle;
+    entry->value_handle = value_handle;
+    entry->end_handle   = end_handle;
+    entry->properties   = properties;
+    (void)memcpy(entry->uuid128, uuid128, 16);
+    gatt_client_cache_dirty = 1;
+
+    // remember Service Changed characteristic to detect database changes
+    if ((type == GATT_CLIENT_CACHE_ENTRY_CHARACTERISTIC) && uuid_has_bluetooth_prefix(uuid128)
+    && (big_endian_read_32(uuid128, 0) == GAP_SERVICE_CHANGED)){
+        gatt_client_cache.service_changed_handle = value_handle;
+    }
+}
+
+static void gatt_client_cache_query_complete(gatt_client_t * peripheral, uint8_t att_status){
+    gatt_client_cache_query_t query = peripheral->cache_query;
+    peripheral->cache_query = GATT_CLIENT_CACHE_QUERY_NONE;
+
+    switch (query){
+        case GATT_CLIENT_CACHE_QUERY_SERVICES:
+        case GATT_CLIENT_CACHE_QUERY_SERVICES_BY_UUID:
+        case GATT_CLIENT_CACHE_QUERY_CHARACTERISTICS:
+        case GATT_CLIENT_CACHE_QUERY_DESCRIPTORS:
+            break;
+        default:
+            return;
+    }
+
+    gatt_client_cache_select(peripheral->cache_device_index);
+
+    // mark range as complete
+    if ((att_status == ATT_ERROR_SUCCESS) && (peripheral->cache_recording_failed == 0u)){
+        gatt_client_cache_entry_t * entry;
+        switch (query){
+            case GATT_CLIENT_CACHE_QUERY_SERVICES:
+                gatt_client_cache.flags |= GATT_CLIENT_CACHE_FLAG_SERVICES_COMPLETE;
+                gatt_client_cache_dirty = 1;
+                break;
+            case GATT_CLIENT_CACHE_QUERY_CHARACTERISTICS:
+                entry = gatt_client_cache_find_entry(GATT_CLIENT_CACHE_ENTRY_SERVICE, peripheral->cache_query_start_handle);
+                if (entry == NULL) break;
+                if (entry->end_handle != peripheral->cache_query_end_handle) break;
+                entry->flags |= GATT_CLIENT_CACHE_FLAG_CHARACTERISTICS_COMPLETE;
+                gatt_client_cache_dirty = 1;
+                break;
+            case GATT_CLIENT_CACHE_QUERY_DESCRIPTORS:
+                entry = gatt_client_cache_find_characteristic(peripheral->cache_query_start_handle, peripheral->cache_query_end_handle);
+                if (entry == NULL) break;
+                entry->flags |= GATT_CLIENT_CACHE_FLAG_DESCRIPTORS_COMPLETE;
+                gatt_client_cache_dirty = 1;
+                break;
+            default:
+                break;
+        }
+    }
+
+    gatt_client_cache_store();
+}
+
+// @returns type of cached entries that answer the query, or 0 if query has to be sent over the air
+static uint8_t gatt_client_cache_entry_type_for_query(gatt_client_t * peripheral, gatt_client_cache_query_t query){
+    gatt_client_cache_select(peripheral->cache_device_index);
+
+    uint16_t start_handle = peripheral->start_group_handle;
+    uint16_t end_handle   = peripheral->end_group_handle;
+    gatt_client_cache_entry_t * entry;
+
+    switch (query){
+        case GATT_CLIENT_CACHE_QUERY_SERVICES:
+        case GATT_CLIENT_CACHE_QUERY_SERVICES_BY_UUID:
+            if ((gatt_client_cache.flags & GATT_CLIENT_CACHE_FLAG_SERVICES_COMPLETE) == 0u) return 0;
+            return GATT_CLIENT_CACHE_ENTRY_SERVICE;
+        case GATT_CLIENT_CACHE_QUERY_CHARACTERISTICS:
+        case GATT_CLIENT_CACHE_QUERY_CHARACTERISTICS_BY_UUID:
+            entry = gatt_client_cache_find_entry(GATT_CLIENT_CACHE_ENTRY_SERVICE, start_handle);
+            if (entry == NULL) return 0;
+            if (entry->end_handle != end_handle) return 0;
+            if ((entry->flags & GATT_CLIENT_CACHE_FLAG_CHARACTERISTICS_COMPLETE) == 0u) return 0;
+            return GATT_CLIENT_CACHE_ENTRY_CHARACTERISTIC;
+        case GATT_CLIENT_CACHE_QUERY_DESCRIPTORS:
+            entry = gatt_client_cache_find_characteristic(start_handle, end_handle);
+            if (entry == NULL) return 0;
+            if ((entry->flags & GATT_CLIENT_CACHE_FLAG_DESCRIPTORS_COMPLETE) == 0u) return 0;
+            return GATT_CLIENT_CACHE_ENTRY_DESCRIPTOR;
+        default:
+            return 0;
+    }
+}
+
+// @returns true if query was answered from cache
+static bool gatt_client_cache_report(gatt_client_t * peripheral, gatt_client_cache_query_t query){
+    uint8_t entry_type = gatt_client_cache_entry_type_for_query(peripheral, query);
+    if (entry_type == 0u) return false;
+
+    uint16_t start_handle = peripheral->start_group_handle;
+    uint16_t end_handle   = peripheral->end_group_handle;
+    gatt_client_cache_entry_t * entry;
+
+    log_info("GATT Client Cache: report query %u for range 0x%04x-0x%04x", (int) query, start_handle, end_handle);
+    gatt_client_handle_transaction_complete(peripheral);
+
+    uint16_t i;
+    for (i=0;i<gatt_client_cache.num_entries;i++){
+        entry = &gatt_client_cache.entries[i];
+        if (entry->type != entry_type) continue;
+        switch (query){
+            case GATT_CLIENT_CACHE_QUERY_SERVICES:
+                emit_gatt_service_query_result_event(peripheral, entry->start_handle, entry->end_handle, entry->uuid128);
+                break;
+            case GATT_CLIENT_CACHE_QUERY_SERVICES_BY_UUID:
+                if (memcmp(entry->uuid128, peripheral->uuid128, 16) != 0) break;
+                emit_gatt_service_query_result_event(peripheral, entry->start_handle, entry->end_handle, entry->uuid128);
+                break;
+            case GATT_CLIENT_CACHE_QUERY_CHARACTERISTICS_BY_UUID:
+                if (memcmp(entry->uuid128, peripheral->uuid128, 16) != 0) break;
+                /* fall through */
+            case GATT_CLIENT_CACHE_QUERY_CHARACTERISTICS:
+                if ((entry->start_handle < start_handle) || (entry->start_handle > end_handle)) break;
+                emit_gatt_characteristic_query_result_event(peripheral, entry->start_handle, entry->value_handle, entry->end_handle, entry->properties, entry->uuid128);
+                break;
+            case GATT_CLIENT_CACHE_QUERY_DESCRIPTORS:
+                if ((entry->start_handle < start_handle) || (entry->start_handle > end_handle)) break;
+                emit_gatt_all_characteristic_descriptors_result_event(peripheral, entry->start_handle, entry->uuid128);
+                break;
+            default:
+                break;
+        }
+    }
+    emit_gatt_complete_event(peripheral, ATT_ERROR_SUCCESS);
+    return true;
+}
+
+static gatt_client_cache_query_t gatt_client_cache_query_for_state(gatt_client_t * peripheral){
+    switch (peripheral->gatt_client_state){
+        case P_W2_SEND_SERVICE_QUERY:
+            return GATT_CLIENT_CACHE_QUERY_SERVICES;
+        case P_W2_SEND_SERVICE_WITH_UUID_QUERY:
+            return GATT_CLIENT_CACHE_QUERY_SERVICES_BY_UUID;
+        case P_W2_SEND_ALL_CHARACTERISTICS_OF_SERVICE_QUERY:
+            return GATT_CLIENT_CACHE_QUERY_CHARACTERISTICS;
+        case P_W2_SEND_CHARACTERISTIC_WITH_UUID_QUERY:
+            return GATT_CLIENT_CACHE_QUERY_CHARACTERISTICS_BY_UUID;
+        case P_W2_SEND_ALL_CHARACTERISTIC_DESCRIPTORS_QUERY:
+            return GATT_CLIENT_CACHE_QUERY_DESCRIPTORS;
+        default:
+            return GATT_CLIENT_CACHE_QUERY_NONE;
+    }
+}
+
+static void gatt_client_cache_report_if_pending(gatt_client_t * gatt_client){
+    if (gatt_client->cache_query != GATT_CLIENT_CACHE_QUERY_REPORT) return;
+    // cache might have been deleted in the meantime, then gatt_client_run sends query over the air
+    gatt_client->cache_query = GATT_CLIENT_CACHE_QUERY_NONE;
+    (void) gatt_client_cache_report(gatt_client, gatt_client_cache_query_for_state(gatt_client));
+}
+
+static void gatt_client_cache_report_timer_handler(btstack_timer_source_t * ts){
+    UNUSED(ts);
+    btstack_linked_item_t *it;
+    for (it = (btstack_linked_item_t *) gatt_client_connections; it != NULL; it = it->next){
+        gatt_client_t * peripheral = (gatt_client_t *) it;
+        gatt_client_cache_report_if_pending(peripheral);
+#ifdef ENABLE_GATT_OVER_EATT
+        btstack_linked_item_t *eatt_it;
+        for (eatt_it = (btstack_linked_item_t *) peripheral->eatt_clients; eatt_it != NULL; eatt_it = eatt_it->next){
+            gatt_client_cache_report_if_pending((gatt_client_t *) eatt_it);
+        }
+#endif
+    }
+    gatt_client_run();
+}
+
+static void gatt_client_cache_trigger_report(void){
+    (void)btstack_run_loop_remove_timer(&gatt_client_cache_report_timer);
+    btstack_run_loop_set_timer_handler(&gatt_client_cache_report_timer, &gatt_client_cache_report_timer_handler);
+    btstack_run_loop_set_timer(&gatt_client_cache_report_timer, 0);
+    btstack_run_loop_add_timer(&gatt_client_cache_report_timer);
+}
+
+// called before a discovery request is sent
+// @returns 1 if Database Hash read was sent, 0 if the query should continue over the air or will be reported from cache
+static int gatt_client_cache_run(gatt_client_t * peripheral){
+    // already decided for this query
+    if (peripheral->cache_query != GATT_CLIENT_CACHE_QUERY_NONE) return 0;
+
+    gatt_client_cache_query_t query = gatt_client_cache_query_for_state(peripheral);
+    if (query == GATT_CLIENT_CACHE_QUERY_NONE) return 0;
+
+    switch (peripheral->cache_state){
+        case GATT_CLIENT_CACHE_IDLE:
+            // only bonded devices are cached
+            peripheral->cache_device_index = sm_le_device_index(peripheral->con_handle);
+            if (peripheral->cache_device_index < 0){
+                peripheral->cache_query = GATT_CLIENT_CACHE_QUERY_BYPASS;
+                return 0;
+            }
+            // validate cache with Database Hash first
+            peripheral->cache_state = GATT_CLIENT_CACHE_W4_DATABASE_HASH;
+            att_read_by_type_or_group_request_for_uuid16(ATT_READ_BY_TYPE_REQUEST, GAP_DATABASE_HASH, peripheral, 0x0001, 0xffff);
+            return 1;
+        case GATT_CLIENT_CACHE_ACTIVE:
+            if (gatt_client_cache_entry_type_for_query(peripheral, query) != 0u){
+                peripheral->cache_query = GATT_CLIENT_CACHE_QUERY_REPORT;
+                gatt_client_cache_trigger_report();
+                return 0;
+            }
+            peripheral->cache_query = query;
+            peripheral->cache_query_start_handle = peripheral->start_group_handle;
+            peripheral->cache_query_end_handle   = peripheral->end_group_handle;
+            peripheral->cache_recording_failed = 0;
+            return 0;
+        default:
+            return 0;
+    }
+}
+
+// @param database_hash or NULL if not supported by remote
+static void gatt_client_cache_handle_database_hash(gatt_client_t * peripheral, const uint8_t * database_hash){
+    gatt_client_cache_select(peripheral->cache_device_index);
+    peripheral->cache_state = GATT_CLIENT_CACHE_ACTIVE;
+
+    bool cached_hash = (gatt_client_cache.flags & GATT_CLIENT_CACHE_FLAG_DATABASE_HASH) != 0u;
+    if (database_hash == NULL){
+        // without Database Hash, a bonded server indicates Service Changed
+        if (cached_hash == false) return;
+    } else {
+        if (cached_hash && (memcmp(gatt_client_cache.database_hash, database_hash, 16) == 0)) return;
+    }
+
+    log_info("GATT Client Cache: Database Hash changed, reset cache for le device %d", peripheral->cache_device_index);
+    gatt_client_cache_reset(peripheral->cache_device_index);
+    if (database_hash != NULL){
+        gatt_client_cache.flags |= GATT_CLIENT_CACHE_FLAG_DATABASE_HASH;
+        (void)memcpy(gatt_client_cache.database_hash, database_hash, 16);
+    }
+    gatt_client_cache_dirty = 1;
+    gatt_client_cache_store();
+}
+
+static void gatt_client_cache_handle_indication(gatt_client_t * peripheral, uint16_t value_handle){
+    int le_device_index = sm_le_device_index(peripheral->con_handle);
+    if (le_device_index < 0) return;
+    gatt_client_cache_select(le_device_index);
+    if (gatt_client_cache.service_changed_handle == 0u) return;
+    if (gatt_client_cache.service_changed_handle != value_handle) return;
+    log_info("GATT Client Cache: Service Changed");
+    gatt_client_cache_delete(le_device_index);
+}
+
+// GATT Client Cache
+// ---------------------
+#endif
+
 ///
 static void report_gatt_services(gatt_client_t * peripheral, uint8_t * packet,  uint16_t size){
     uint8_t attr_length = packet[1];
@@ -727,6 +1266,19 @@ static void report_gatt_notification(hci_con_handle_t con_handle, uint16_t value
 }
 
 // @note assume that value is part of an l2cap buffer - overwrite parts of the HCI/L2CAP/ATT packet (4/4/3) bytes 
+// @note { handle, length, value } tuples
+static void report_gatt_multiple_notification(hci_con_handle_t con_handle, uint8_t * packet, uint16_t size){
+    uint16_t offset = 1;
+    while ((offset + 4u) <= size){
+        uint16_t value_handle = little_endian_read_16(packet, offset);
+        uint16_t value_length = little_endian_read_16(packet, offset + 2u);
+        offset += 4u;
+        if ((offset + value_length) > size) break;
+        report_gatt_notification(con_handle, value_handle, &packet[offset], value_length);
+        offset += value_length;
+    }
+}
+
 static void report_gatt_indication(hci_con_handle_t con_handle, uint16_t value_handle, uint8_t * value, int length){
     uint8_t * packet = setup_characteristic_value_packet(GATT_EVENT_INDICATION, con_handle, value_handle, value, length);
     emit_event_to_registered_listeners(con_handle, value_handle, packet, characteristic_value_event_header_size + length);
@@ -851,6 +1403,200 @@ static int is_value_valid(gatt_client_t *peripheral, uint8_t *packet, uint16_t s
     return memcmp(&peripheral->attribute_value[peripheral->attribute_offset], &packet[5], size-5u) == 0u;
 }
 
+// ---------------------
+// Request Queue
+
+static bool gatt_client_request_queue_active(gatt_client_t * peripheral){
+    switch (peripheral->gatt_client_state){
+        case P_W4_REQUEST_QUEUE_READ_RESULT:
+        case P_W4_REQUEST_QUEUE_READ_MULTIPLE_VARIABLE_RESULT:
+        case P_W4_REQUEST_QUEUE_WRITE_RESULT:
+        case P_W4_REQUEST_QUEUE_CCC_HANDLE_RESULT:
+            return true;
+        default:
+            return false;
+    }
+}
+
+static void gatt_client_request_complete(gatt_client_t * peripheral, gatt_client_request_t * request, uint8_t att_status){
+    btstack_linked_list_remove(&peripheral->request_queue, (btstack_linked_item_t *) request);
+    // @format H21
+    uint8_t packet[7];
+    packet[0] = GATT_EVENT_REQUEST_COMPLETE;
+    packet[1] = sizeof(packet) - 2u;
+    little_endian_store_16(packet, 2, peripheral->con_handle);
+    little_endian_store_16(packet, 4, request->attribute_handle);
+    packet[6] = att_status;
+    emit_event_new(request->callback, packet, sizeof(packet));
+}
+
+static void gatt_client_request_report_value(gatt_client_t * peripheral, gatt_client_request_t * request, uint8_t * value, uint16_t length){
+    uint8_t * packet = setup_characteristic_value_packet(GATT_EVENT_CHARACTERISTIC_VALUE_QUERY_RESULT, peripheral->con_handle, request->attribute_handle, value, length);
+    emit_event_new(request->callback, packet, characteristic_value_event_header_size + length);
+}
+
+static void gatt_client_request_queue_abort(gatt_client_t * peripheral, uint8_t att_status){
+    peripheral->request_queue_num_in_flight = 0;
+    while (peripheral->request_queue != NULL){
+        gatt_client_request_complete(peripheral, (gatt_client_request_t *) peripheral->request_queue, att_status);
+    }
+}
+
+static int gatt_client_request_queue_run(gatt_client_t * peripheral){
+    while (peripheral->request_queue != NULL){
+        gatt_client_request_t * request = (gatt_client_request_t *) peripheral->request_queue;
+        switch (request->type){
+            case GATT_CLIENT_REQUEST_TYPE_READ_VALUE: {
+                // combine consecutive reads
+                uint16_t handles[GATT_CLIENT_READ_MULTIPLE_VARIABLE_MAX_HANDLES];
+                uint16_t num_handles = 0;
+                uint16_t max_handles = (peripheral_mtu(peripheral) - 1u) / 2u;
+                if (max_handles > GATT_CLIENT_READ_MULTIPLE_VARIABLE_MAX_HANDLES){
+                    max_handles = GATT_CLIENT_READ_MULTIPLE_VARIABLE_MAX_HANDLES;
+                }
+                if (peripheral->read_multiple_variable_not_supported == 0u){
+                    btstack_linked_item_t * it;
+                    for (it = peripheral->request_queue; it != NULL; it = it->next){
+                        gatt_client_request_t * item = (gatt_client_request_t *) it;
+                        if (item->type != GATT_CLIENT_REQUEST_TYPE_READ_VALUE) break;
+                        if ((item->flags & GATT_CLIENT_REQUEST_FLAG_READ_SINGLE) != 0u) break;
+                        if (num_handles == max_handles) break;
+                        handles[num_handles++] = item->attribute_handle;
+                    }
+                }
+                gatt_client_timeout_start(peripheral);
+                if (num_handles >= 2u){
+                    peripheral->gatt_client_state = P_W4_REQUEST_QUEUE_READ_MULTIPLE_VARIABLE_RESULT;
+                    peripheral->request_queue_num_in_flight = (uint8_t) num_handles;
+                    att_read_multiple_request(ATT_READ_MULTIPLE_VARIABLE_REQUEST, peripheral, num_handles, handles);
+                } else {
+                    peripheral->gatt_client_state = P_W4_REQUEST_QUEUE_READ_RESULT;
+                    peripheral->request_queue_num_in_flight = 1;
+                    att_read_request(ATT_READ_REQUEST, peripheral, request->attribute_handle);
+                }
+                return 1;
+            }
+            case GATT_CLIENT_REQUEST_TYPE_WRITE_VALUE:
+                if (request->value_length > (peripheral_mtu(peripheral) - 3u)){
+                    log_error("gatt_client_request_queue_run: value len %u > MTU %u - 3", request->value_length, peripheral_mtu(peripheral));
+                    gatt_client_request_complete(peripheral, request, ATT_ERROR_INVALID_ATTRIBUTE_VALUE_LENGTH);
+                    break;
+                }
+                gatt_client_timeout_start(peripheral);
+                peripheral->gatt_client_state = P_W4_REQUEST_QUEUE_WRITE_RESULT;
+                peripheral->request_queue_num_in_flight = 1;
+                att_write_request(ATT_WRITE_REQUEST, peripheral, request->attribute_handle, request->value_length, (uint8_t *) request->value);
+                return 1;
+            case GATT_CLIENT_REQUEST_TYPE_WRITE_CLIENT_CHARACTERISTIC_CONFIGURATION:
+                gatt_client_timeout_start(peripheral);
+                peripheral->request_queue_num_in_flight = 1;
+                if (request->client_characteristic_configuration_handle == 0u){
+                    peripheral->gatt_client_state = P_W4_REQUEST_QUEUE_CCC_HANDLE_RESULT;
+                    att_read_by_type_or_group_request_for_uuid16(ATT_READ_BY_TYPE_REQUEST, GATT_CLIENT_CHARACTERISTICS_CONFIGURATION,
+                        peripheral, request->attribute_handle, request->characteristic_end_handle);
+                } else {
+                    peripheral->gatt_client_state = P_W4_REQUEST_QUEUE_WRITE_RESULT;
+                    att_write_request(ATT_WRITE_REQUEST, peripheral, request->client_characteristic_configuration_handle, 2, request->client_characteristic_configuration_value);
+                }
+                return 1;
+            default:
+                btstack_assert(false);
+                break;
+        }
+    }
+    return 0;
+}
+
+static void gatt_client_request_queue_handle_read_multiple_variable_response(gatt_client_t * peripheral, uint8_t * packet, uint16_t size){
+    uint16_t offset = 1;
+    uint8_t  num_in_flight = peripheral->request_queue_num_in_flight;
+    uint8_t  i;
+    for (i=0;i<num_in_flight;i++){
+        gatt_client_request_t * request = (gatt_client_request_t *) peripheral->request_queue;
+        if ((offset + 2u) > size){
+            // missing: re-queue, use single read if nothing was returned at all
+            if (i == 0u){
+                request->flags |= GATT_CLIENT_REQUEST_FLAG_READ_SINGLE;
+            }
+            break;
+        }
+        uint16_t value_length = little_endian_read_16(packet, offset);
+        offset += 2u;
+        if ((offset + value_length) > size){
+            // truncated: remaining requests get re-queued, this one as single read
+            request->flags |= GATT_CLIENT_REQUEST_FLAG_READ_SINGLE;
+            break;
+        }
+        gatt_client_request_report_value(peripheral, request, &packet[offset], value_length);
+        offset += value_length;
+        gatt_client_request_complete(peripheral, request, ATT_ERROR_SUCCESS);
+    }
+}
+
+static void gatt_client_request_queue_handle_error(gatt_client_t * peripheral, uint16_t attribute_handle, uint8_t att_status){
+    gatt_client_request_t * request = (gatt_client_request_t *) peripheral->request_queue;
+    if (peripheral->gatt_client_state == P_W4_REQUEST_QUEUE_READ_MULTIPLE_VARIABLE_RESULT){
+        if (att_status == ATT_ERROR_REQUEST_NOT_SUPPORTED){
+            // fall back to individual reads
+            log_info("Read Multiple Variable Length not supported by server");
+            peripheral->read_multiple_variable_not_supported = 1;
+            return;
+        }
+        // complete request that caused the error, others get re-queued
+        btstack_linked_item_t * it;
+        uint8_t i = 0;
+        for (it = peripheral->request_queue; (it != NULL) && (i < peripheral->request_queue_num_in_flight); it = it->next){
+            gatt_client_request_t * item = (gatt_client_request_t *) it;
+            if (item->attribute_handle == attribute_handle){
+                request = item;
+                break;
+            }
+            i++;
+        }
+    }
+    gatt_client_request_complete(peripheral, request, att_status);
+}
+
+static void gatt_client_request_queue_handle_att_response(gatt_client_t * peripheral, uint8_t * packet, uint16_t size){
+    gatt_client_request_t * request = (gatt_client_request_t *) peripheral->request_queue;
+    btstack_assert(request != NULL);
+
+    switch (packet[0]){
+        case ATT_ERROR_RESPONSE:
+            if (size < 5u) return;
+            gatt_client_request_queue_handle_error(peripheral, little_endian_read_16(packet, 2), packet[4]);
+            break;
+        case ATT_READ_RESPONSE:
+            if (peripheral->gatt_client_state != P_W4_REQUEST_QUEUE_READ_RESULT) return;
+            gatt_client_request_report_value(peripheral, request, &packet[1], size - 1u);
+            gatt_client_request_complete(peripheral, request, ATT_ERROR_SUCCESS);
+            break;
+        case ATT_READ_MULTIPLE_VARIABLE_RESPONSE:
+            if (peripheral->gatt_client_state != P_W4_REQUEST_QUEUE_READ_MULTIPLE_VARIABLE_RESULT) return;
+            gatt_client_request_queue_handle_read_multiple_variable_response(peripheral, packet, size);
+            break;
+        case ATT_WRITE_RESPONSE:
+            if (peripheral->gatt_client_state != P_W4_REQUEST_QUEUE_WRITE_RESULT) return;
+            gatt_client_request_complete(peripheral, request, ATT_ERROR_SUCCESS);
+            break;
+        case ATT_READ_BY_TYPE_RESPONSE:
+            if (peripheral->gatt_client_state != P_W4_REQUEST_QUEUE_CCC_HANDLE_RESULT) return;
+            if (size < 4u) return;
+            // write configuration next
+            request->client_characteristic_configuration_handle = little_endian_read_16(packet, 2);
+            break;
+        default:
+            return;
+    }
+
+    // ready for next request
+    peripheral->request_queue_num_in_flight = 0;
+    gatt_client_handle_transaction_complete(peripheral);
+}
+
+// Request Queue
+// ---------------------
+
 // returns 1 if packet was sent
 static int gatt_client_run_for_peripheral( gatt_client_t * peripheral){
     // log_info("- handle_peripheral_list, mtu state %u, client state %u", peripheral->mtu_state, peripheral->gatt_client_state);
@@ -866,7 +1612,7 @@ static int gatt_client_run_for_peripheral( gatt_client_t * peripheral){
     switch (peripheral->mtu_state) {
         case SEND_MTU_EXCHANGE:
             peripheral->mtu_state = SENT_MTU_EXCHANGE;
-            att_exchange_mtu_request(peripheral->con_handle);
+            att_exchange_mtu_request(peripheral);
             return 1;
         case SENT_MTU_EXCHANGE:
             return 0;
@@ -876,10 +1622,22 @@ static int gatt_client_run_for_peripheral( gatt_client_t * peripheral){
 
     if (peripheral->send_confirmation){
         peripheral->send_confirmation = 0;
-        att_confirmation(peripheral->con_handle);
+        att_confirmation(peripheral);
         return 1;
     }
 
+#ifdef ENABLE_GATT_CLIENT_CACHE
+    // wait for Database Hash, then answer discovery from cache if possible
+    if (peripheral->cache_state == GATT_CLIENT_CACHE_W4_DATABASE_HASH) return 0;
+    if (gatt_client_cache_run(peripheral)) return 1;
+    if (peripheral->cache_query == GATT_CLIENT_CACHE_QUERY_REPORT) return 0;
+#endif
+
+    // send next queued requests when idle
+    if ((peripheral->gatt_client_state == P_READY) && (peripheral->request_queue != NULL)){
+        return gatt_client_request_queue_run(peripheral);
+    }
+
     // check MTU for writes
     switch (peripheral->gatt_client_state){
         case P_W2_SEND_WRITE_CHARACTERISTIC_VALUE:
@@ -1088,8 +1846,33 @@ static int gatt_client_run_for_peripheral( gatt_client_t * peripheral){
     return 0;
 }
 
+#ifdef ENABLE_GATT_OVER_EATT
+static void gatt_client_le_enhanced_run(void){
+    btstack_linked_item_t *it;
+    for (it = (btstack_linked_item_t *) gatt_client_connections; it != NULL; it = it->next){
+        gatt_client_t * peripheral = (gatt_client_t *) it;
+        btstack_linked_list_iterator_t eatt_it;
+        btstack_linked_list_iterator_init(&eatt_it, &peripheral->eatt_clients);
+        while (btstack_linked_list_iterator_has_next(&eatt_it)){
+            gatt_client_t * eatt_client = (gatt_client_t *) btstack_linked_list_iterator_next(&eatt_it);
+            if (eatt_client->gatt_client_state == P_W4_L2CAP_CONNECTION) continue;
+            if (!l2cap_le_can_send_now(eatt_client->l2cap_cid)){
+                l2cap_le_request_can_send_now_event(eatt_client->l2cap_cid);
+                continue;
+            }
+            if (gatt_client_run_for_peripheral(eatt_client)){
+                l2cap_le_request_can_send_now_event(eatt_client->l2cap_cid);
+            }
+        }
+    }
+}
+#endif
+
 static void gatt_client_run(void){
     btstack_linked_item_t *it;
+#ifdef ENABLE_GATT_OVER_EATT
+    gatt_client_le_enhanced_run();
+#endif
     for (it = (btstack_linked_item_t *) gatt_client_connections; it != NULL; it = it->next){
         gatt_client_t * peripheral = (gatt_client_t *) it;
         if (!att_dispatch_client_can_send_now(peripheral->con_handle)) {
@@ -1111,6 +1894,11 @@ static void gatt_client_run(void){
 
 static void gatt_client_report_error_if_pending(gatt_client_t *peripheral, uint8_t att_error_code) {
     if (is_ready(peripheral) == 1) return;
+    if (gatt_client_request_queue_active(peripheral)){
+        gatt_client_handle_transaction_complete(peripheral);
+        gatt_client_request_queue_abort(peripheral, att_error_code);
+        return;
+    }
     gatt_client_handle_transaction_complete(peripheral);
     emit_gatt_complete_event(peripheral, att_error_code);
 }
@@ -1131,7 +1919,14 @@ static void gatt_client_event_packet_handler(uint8_t packet_type, uint16_t chann
             if (peripheral == NULL) break;
             
             gatt_client_report_error_if_pending(peripheral, ATT_ERROR_HCI_DISCONNECT_RECEIVED);
+            gatt_client_request_queue_abort(peripheral, ATT_ERROR_HCI_DISCONNECT_RECEIVED);
             gatt_client_timeout_stop(peripheral);
+#ifdef ENABLE_GATT_OVER_EATT
+            while (!btstack_linked_list_empty(&peripheral->eatt_clients)){
+                gatt_client_t * eatt_client = (gatt_client_t *) btstack_linked_list_pop(&peripheral->eatt_clients);
+                gatt_client_le_enhanced_bearer_closed(eatt_client);
+            }
+#endif
             btstack_linked_list_remove(&gatt_client_connections, (btstack_linked_item_t *) peripheral);
             btstack_memory_gatt_client_free(peripheral);
             break;
@@ -1199,6 +1994,9 @@ static void gatt_client_att_packet_handler(uint8_t packet_type, uint16_t handle,
             if (size < 3u) return;
             report_gatt_notification(handle, little_endian_read_16(packet,1u), &packet[3], size-3u);
             return;                
+        case ATT_MULTIPLE_HANDLE_VALUE_NOTIFICATION:
+            report_gatt_multiple_notification(handle, packet, size);
+            return;
         case ATT_HANDLE_VALUE_INDICATION:
             peripheral = provide_context_for_conn_handle(handle);
             break;
@@ -1208,6 +2006,47 @@ static void gatt_client_att_packet_handler(uint8_t packet_type, uint16_t handle,
     }
 
     if (peripheral == NULL) return;
+
+    gatt_client_handle_att_response(peripheral, packet, size);
+}
+
+static void gatt_client_handle_att_response(gatt_client_t * peripheral, uint8_t * packet, uint16_t size){
+
+#ifdef ENABLE_GATT_CLIENT_CACHE
+    // response to Database Hash read
+    if (peripheral->cache_state == GATT_CLIENT_CACHE_W4_DATABASE_HASH){
+        switch (packet[0]){
+            case ATT_READ_BY_TYPE_RESPONSE:
+                // handle + 128-bit hash
+                if ((size >= 20u) && (packet[1] == 18u)){
+                    gatt_client_cache_handle_database_hash(peripheral, &packet[4]);
+                } else {
+                    gatt_client_cache_handle_database_hash(peripheral, NULL);
+                }
+                gatt_client_run();
+                return;
+            case ATT_ERROR_RESPONSE:
+                gatt_client_cache_handle_database_hash(peripheral, NULL);
+                gatt_client_run();
+                return;
+            default:
+                break;
+        }
+    }
+#endif
+
+    // responses to queued requests
+    if (gatt_client_request_queue_active(peripheral)){
+        switch (packet[0]){
+            case ATT_HANDLE_VALUE_INDICATION:
+            case ATT_EXCHANGE_MTU_RESPONSE:
+                break;
+            default:
+                gatt_client_request_queue_handle_att_response(peripheral, packet, size);
+                gatt_client_run();
+                return;
+        }
+    }
     
     switch (packet[0]){
         case ATT_EXCHANGE_MTU_RESPONSE:
@@ -1233,7 +2072,10 @@ static void gatt_client_att_packet_handler(uint8_t packet_type, uint16_t handle,
             break;
         case ATT_HANDLE_VALUE_INDICATION:
             if (size < 3u) break;
-            report_gatt_indication(handle, little_endian_read_16(packet,1u), &packet[3], size-3u);
+#ifdef ENABLE_GATT_CLIENT_CACHE
+            gatt_client_cache_handle_indication(peripheral, little_endian_read_16(packet,1u));
+#endif
+            report_gatt_indication(peripheral->con_handle, little_endian_read_16(packet,1u), &packet[3], size-3u);
             peripheral->send_confirmation = 1;
             break;
             
@@ -1903,7 +2745,7 @@ uint8_t gatt_client_write_value_of_characteristic_without_response(hci_con_handl
     if (value_length > (peripheral_mtu(peripheral) - 3u)) return GATT_CLIENT_VALUE_TOO_LONG;
     if (!att_dispatch_client_can_send_now(peripheral->con_handle)) return GATT_CLIENT_BUSY;
 
-    return att_write_request(ATT_WRITE_COMMAND, peripheral->con_handle, value_handle, value_length, value);
+    return att_write_request(ATT_WRITE_COMMAND, peripheral, value_handle, value_length, value);
 }
 
 uint8_t gatt_client_write_value_of_characteristic(btstack_packet_handler_t callback, hci_con_handle_t con_handle, uint16_t value_handle, uint16_t value_length, uint8_t * data){
@@ -2110,6 +2952,236 @@ uint8_t gatt_client_cancel_write(btstack_packet_handler_t callback, hci_con_hand
     return ERROR_CODE_SUCCESS;    
 }
 
+void gatt_client_request_init_read_value(gatt_client_request_t * request, uint16_t value_handle){
+    memset(request, 0, sizeof(gatt_client_request_t));
+    request->type = GATT_CLIENT_REQUEST_TYPE_READ_VALUE;
+    request->attribute_handle = value_handle;
+}
+
+void gatt_client_request_init_write_value(gatt_client_request_t * request, uint16_t value_handle, uint16_t value_length, const uint8_t * value){
+    memset(request, 0, sizeof(gatt_client_request_t));
+    request->type = GATT_CLIENT_REQUEST_TYPE_WRITE_VALUE;
+    request->attribute_handle = value_handle;
+    request->value_length = value_length;
+    request->value = value;
+}
+
+uint8_t gatt_client_request_init_write_client_characteristic_configuration(gatt_client_request_t * request, gatt_client_characteristic_t * characteristic, uint16_t configuration){
+    if ( (configuration & GATT_CLIENT_CHARACTERISTICS_CONFIGURATION_NOTIFICATION) &&
+        ((characteristic->properties & ATT_PROPERTY_NOTIFY) == 0u)) {
+        return GATT_CLIENT_CHARACTERISTIC_NOTIFICATION_NOT_SUPPORTED;
+    } else if ( (configuration & GATT_CLIENT_CHARACTERISTICS_CONFIGURATION_INDICATION) &&
+               ((characteristic->properties & ATT_PROPERTY_INDICATE) == 0u)){
+        return GATT_CLIENT_CHARACTERISTIC_INDICATION_NOT_SUPPORTED;
+    }
+    memset(request, 0, sizeof(gatt_client_request_t));
+    request->type = GATT_CLIENT_REQUEST_TYPE_WRITE_CLIENT_CHARACTERISTIC_CONFIGURATION;
+    request->attribute_handle = characteristic->value_handle;
+    request->characteristic_end_handle = characteristic->end_handle;
+    little_endian_store_16(request->client_characteristic_configuration_value, 0, configuration);
+    return ERROR_CODE_SUCCESS;
+}
+
+uint8_t gatt_client_request_queue_add(btstack_packet_handler_t callback, hci_con_handle_t con_handle, gatt_client_request_t * requests, uint16_t num_requests){
+    gatt_client_t * peripheral = provide_context_for_conn_handle(con_handle);
+    if (peripheral == NULL) return BTSTACK_MEMORY_ALLOC_FAILED;
+#ifdef ENABLE_GATT_OVER_EATT
+    // queue batch on the bearer with the fewest queued requests
+    int min_queued = btstack_linked_list_count(&peripheral->request_queue);
+    btstack_linked_list_iterator_t it;
+    btstack_linked_list_iterator_init(&it, &peripheral->eatt_clients);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        gatt_client_t * eatt_client = (gatt_client_t *) btstack_linked_list_iterator_next(&it);
+        if (eatt_client->gatt_client_state == P_W4_L2CAP_CONNECTION) continue;
+        int queued = btstack_linked_list_count(&eatt_client->request_queue);
+        if (queued >= min_queued) continue;
+        min_queued = queued;
+        peripheral = eatt_client;
+    }
+#endif
+    uint16_t i;
+    for (i=0;i<num_requests;i++){
+        gatt_client_request_t * request = &requests[i];
+        request->callback = callback;
+        request->flags = 0;
+        btstack_linked_list_add_tail(&peripheral->request_queue, (btstack_linked_item_t *) request);
+    }
+    gatt_client_run();
+    return ERROR_CODE_SUCCESS;
+}
+
+#ifdef ENABLE_GATT_OVER_EATT
+
+#define GATT_CLIENT_EATT_MIN_MTU 64
+
+static gatt_client_t * gatt_client_le_enhanced_get_context_for_l2cap_cid(uint16_t l2cap_cid, gatt_client_t ** out_gatt_client){
+    btstack_linked_item_t *it;
+    for (it = (btstack_linked_item_t *) gatt_client_connections; it != NULL; it = it->next){
+        gatt_client_t * gatt_client = (gatt_client_t *) it;
+        btstack_linked_list_iterator_t eatt_it;
+        btstack_linked_list_iterator_init(&eatt_it, &gatt_client->eatt_clients);
+        while (btstack_linked_list_iterator_has_next(&eatt_it)){
+            gatt_client_t * eatt_client = (gatt_client_t *) btstack_linked_list_iterator_next(&eatt_it);
+            if (eatt_client->l2cap_cid != l2cap_cid) continue;
+            if (out_gatt_client != NULL){
+                *out_gatt_client = gatt_client;
+            }
+            return eatt_client;
+        }
+    }
+    return NULL;
+}
+
+static void gatt_client_le_enhanced_emit_connected(gatt_client_t * gatt_client){
+    uint8_t num_bearers = (uint8_t) btstack_linked_list_count(&gatt_client->eatt_clients);
+    gatt_client->eatt_state = (num_bearers > 0u) ? GATT_CLIENT_EATT_READY : GATT_CLIENT_EATT_IDLE;
+    if (gatt_client->eatt_callback == NULL) return;
+    uint8_t event[6];
+    event[0] = GATT_EVENT_EATT_CONNECTED;
+    event[1] = sizeof(event) - 2u;
+    little_endian_store_16(event, 2, gatt_client->con_handle);
+    event[4] = (num_bearers > 0u) ? ERROR_CODE_SUCCESS : gatt_client->eatt_status;
+    event[5] = num_bearers;
+    (*gatt_client->eatt_callback)(HCI_EVENT_PACKET, gatt_client->con_handle, event, sizeof(event));
+}
+
+// bearer already removed from list
+static void gatt_client_le_enhanced_bearer_closed(gatt_client_t * eatt_client){
+    gatt_client_report_error_if_pending(eatt_client, ATT_ERROR_HCI_DISCONNECT_RECEIVED);
+    gatt_client_request_queue_abort(eatt_client, ATT_ERROR_HCI_DISCONNECT_RECEIVED);
+    gatt_client_timeout_stop(eatt_client);
+}
+
+static void gatt_client_le_enhanced_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
+    gatt_client_t * gatt_client = NULL;
+    gatt_client_t * eatt_client;
+    uint8_t status;
+
+    switch (packet_type){
+        case L2CAP_DATA_PACKET:
+            eatt_client = gatt_client_le_enhanced_get_context_for_l2cap_cid(channel, NULL);
+            if (eatt_client == NULL) break;
+            if (size < 1u) break;
+            switch (packet[0]){
+                case ATT_HANDLE_VALUE_NOTIFICATION:
+                    if (size < 3u) break;
+                    report_gatt_notification(eatt_client->con_handle, little_endian_read_16(packet,1u), &packet[3], size-3u);
+                    break;
+                case ATT_MULTIPLE_HANDLE_VALUE_NOTIFICATION:
+                    report_gatt_multiple_notification(eatt_client->con_handle, packet, size);
+                    break;
+                default:
+                    // ATT requests from remote client are only handled on bearers accepted by the ATT Server
+                    if ((packet[0] & 1u) == 0u) break;
+                    gatt_client_handle_att_response(eatt_client, packet, size);
+                    break;
+            }
+            break;
+
+        case HCI_EVENT_PACKET:
+            switch (hci_event_packet_get_type(packet)){
+                case L2CAP_EVENT_ECBM_CHANNEL_OPENED:
+                    eatt_client = gatt_client_le_enhanced_get_context_for_l2cap_cid(l2cap_event_ecbm_channel_opened_get_local_cid(packet), &gatt_client);
+                    if (eatt_client == NULL) break;
+                    status = l2cap_event_ecbm_channel_opened_get_status(packet);
+                    if (status == ERROR_CODE_SUCCESS){
+                        eatt_client->mtu = btstack_min(eatt_client->mtu, l2cap_event_ecbm_channel_opened_get_remote_mtu(packet));
+                        eatt_client->gatt_client_state = P_READY;
+                        log_info("EATT: bearer cid 0x%04x opened, mtu %u", eatt_client->l2cap_cid, eatt_client->mtu);
+                    } else {
+                        btstack_linked_list_remove(&gatt_client->eatt_clients, (btstack_linked_item_t *) eatt_client);
+                        gatt_client->eatt_status = status;
+                    }
+                    if (gatt_client->eatt_num_pending > 0u){
+                        gatt_client->eatt_num_pending--;
+                        if (gatt_client->eatt_num_pending == 0u){
+                            gatt_client_le_enhanced_emit_connected(gatt_client);
+                        }
+                    }
+                    break;
+
+                case L2CAP_EVENT_LE_CHANNEL_CLOSED:
+                    eatt_client = gatt_client_le_enhanced_get_context_for_l2cap_cid(l2cap_event_le_channel_closed_get_local_cid(packet), &gatt_client);
+                    if (eatt_client == NULL) break;
+                    log_info("EATT: bearer cid 0x%04x closed", eatt_client->l2cap_cid);
+                    btstack_linked_list_remove(&gatt_client->eatt_clients, (btstack_linked_item_t *) eatt_client);
+                    gatt_client_le_enhanced_bearer_closed(eatt_client);
+                    if (btstack_linked_list_empty(&gatt_client->eatt_clients)){
+                        gatt_client->eatt_state = GATT_CLIENT_EATT_IDLE;
+                    }
+                    break;
+
+                case L2CAP_EVENT_LE_CAN_SEND_NOW:
+                case L2CAP_EVENT_LE_PACKET_SENT:
+                    break;
+
+                default:
+                    return;
+            }
+            break;
+
+        default:
+            return;
+    }
+
+    gatt_client_run();
+}
+
+uint8_t gatt_client_le_enhanced_connect(btstack_packet_handler_t callback, hci_con_handle_t con_handle, uint8_t num_channels, uint8_t * storage_buffer, uint16_t storage_size){
+    gatt_client_t * gatt_client = provide_context_for_conn_handle(con_handle);
+    if (gatt_client == NULL) return BTSTACK_MEMORY_ALLOC_FAILED;
+    if (gatt_client->eatt_state != GATT_CLIENT_EATT_IDLE) return GATT_CLIENT_IN_WRONG_STATE;
+    // all bearers are requested with a single ECBM connection request
+    if ((num_channels == 0u) || (num_channels > L2CAP_ECBM_MAX_CID_ARRAY_SIZE)) return ERROR_CODE_INVALID_HCI_COMMAND_PARAMETERS;
+
+    // each bearer: gatt_client_t + receive buffer + send buffer, keep pointer alignment
+    uint16_t chunk_size  = (storage_size / num_channels) & ~(sizeof(void *) - 1u);
+    if (chunk_size <= sizeof(gatt_client_t)) return ERROR_CODE_MEMORY_CAPACITY_EXCEEDED;
+    uint16_t buffer_size = (chunk_size - sizeof(gatt_client_t)) / 2u;
+    if (buffer_size < GATT_CLIENT_EATT_MIN_MTU) return ERROR_CODE_MEMORY_CAPACITY_EXCEEDED;
+
+    uint8_t * receive_buffers[L2CAP_ECBM_MAX_CID_ARRAY_SIZE];
+    uint16_t  local_cids[L2CAP_ECBM_MAX_CID_ARRAY_SIZE];
+    gatt_client_t * eatt_clients[L2CAP_ECBM_MAX_CID_ARRAY_SIZE];
+    uint8_t i;
+    for (i = 0; i < num_channels; i++){
+        uint8_t * chunk = &storage_buffer[i * chunk_size];
+        gatt_client_t * eatt_client = (gatt_client_t *) chunk;
+        memset(eatt_client, 0, sizeof(gatt_client_t));
+        eatt_client->con_handle = con_handle;
+        eatt_client->mtu = buffer_size;
+        // no MTU exchange on EATT bearers
+        eatt_client->mtu_state = MTU_EXCHANGED;
+        eatt_client->gatt_client_state = P_W4_L2CAP_CONNECTION;
+        eatt_client->eatt_receive_buffer = &chunk[sizeof(gatt_client_t)];
+        eatt_client->eatt_send_buffer    = &chunk[sizeof(gatt_client_t) + buffer_size];
+#ifdef ENABLE_GATT_CLIENT_CACHE
+        eatt_client->cache_state = GATT_CLIENT_CACHE_IDLE;
+        eatt_client->cache_query = GATT_CLIENT_CACHE_QUERY_NONE;
+        eatt_client->cache_device_index = -1;
+#endif
+        eatt_clients[i] = eatt_client;
+        receive_buffers[i] = eatt_client->eatt_receive_buffer;
+    }
+
+    uint8_t status = l2cap_ecbm_create_channels(&gatt_client_le_enhanced_packet_handler, con_handle, LEVEL_2, PSM_EATT,
+                                                num_channels, L2CAP_LE_AUTOMATIC_CREDITS, buffer_size, receive_buffers, local_cids);
+    if (status != ERROR_CODE_SUCCESS) return status;
+
+    gatt_client->eatt_callback = callback;
+    gatt_client->eatt_status = ERROR_CODE_SUCCESS;
+    gatt_client->eatt_num_pending = 0;
+    for (i = 0; i < num_channels; i++){
+        eatt_clients[i]->l2cap_cid = local_cids[i];
+        btstack_linked_list_add_tail(&gatt_client->eatt_clients, (btstack_linked_item_t *) eatt_clients[i]);
+        gatt_client->eatt_num_pending++;
+    }
+
+    gatt_client->eatt_state = GATT_CLIENT_EATT_W4_CONNECTED;
+    return ERROR_CODE_SUCCESS;
+}
+#endif
+
 void gatt_client_deserialize_service(const uint8_t *packet, int offset, gatt_client_service_t *service){
     service->start_group_handle = little_endian_read_16(packet, offset);
     service->end_group_handle = little_endian_read_16(packet, offset + 2);
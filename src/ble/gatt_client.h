@@ -126,6 +126,15 @@ typedef enum {
     P_W4_CMAC_RESULT,
     P_W2_SEND_SIGNED_WRITE,
     P_W4_SEND_SINGED_WRITE_DONE,
+
+    // request queue
+    P_W4_REQUEST_QUEUE_READ_RESULT,
+    P_W4_REQUEST_QUEUE_READ_MULTIPLE_VARIABLE_RESULT,
+    P_W4_REQUEST_QUEUE_WRITE_RESULT,
+    P_W4_REQUEST_QUEUE_CCC_HANDLE_RESULT,
+
+    // EATT bearer
+    P_W4_L2CAP_CONNECTION,
 } gatt_client_state_t;
     
     
@@ -136,6 +145,33 @@ typedef enum{
     MTU_AUTO_EXCHANGE_DISABLED
 } gatt_client_mtu_t;
 
+#ifdef ENABLE_GATT_CLIENT_CACHE
+typedef enum {
+    GATT_CLIENT_CACHE_IDLE,
+    GATT_CLIENT_CACHE_W4_DATABASE_HASH,
+    GATT_CLIENT_CACHE_ACTIVE,
+} gatt_client_cache_state_t;
+
+typedef enum {
+    GATT_CLIENT_CACHE_QUERY_NONE,
+    GATT_CLIENT_CACHE_QUERY_BYPASS,
+    GATT_CLIENT_CACHE_QUERY_REPORT,
+    GATT_CLIENT_CACHE_QUERY_SERVICES,
+    GATT_CLIENT_CACHE_QUERY_SERVICES_BY_UUID,
+    GATT_CLIENT_CACHE_QUERY_CHARACTERISTICS,
+    GATT_CLIENT_CACHE_QUERY_CHARACTERISTICS_BY_UUID,
+    GATT_CLIENT_CACHE_QUERY_DESCRIPTORS,
+} gatt_client_cache_query_t;
+#endif
+
+#ifdef ENABLE_GATT_OVER_EATT
+typedef enum {
+    GATT_CLIENT_EATT_IDLE,
+    GATT_CLIENT_EATT_W4_CONNECTED,
+    GATT_CLIENT_EATT_READY,
+} gatt_client_eatt_state_t;
+#endif
+
 typedef struct gatt_client{
     btstack_linked_item_t    item;
     // TODO: rename gatt_client_state -> state
@@ -182,6 +218,11 @@ typedef struct gatt_client{
     uint8_t  filter_with_uuid;
     uint8_t  send_confirmation;
 
+    // request queue
+    btstack_linked_list_t request_queue;
+    uint8_t  request_queue_num_in_flight;
+    uint8_t  read_multiple_variable_not_supported;
+
     int      le_device_index;
     uint8_t  cmac[8];
 
@@ -193,8 +234,59 @@ typedef struct gatt_client{
     uint8_t  pending_error_code;
 #endif
 
+#ifdef ENABLE_GATT_CLIENT_CACHE
+    gatt_client_cache_state_t cache_state;
+    gatt_client_cache_query_t cache_query;
+    int      cache_device_index;
+    uint16_t cache_query_start_handle;
+    uint16_t cache_query_end_handle;
+    uint8_t  cache_recording_failed;
+#endif
+
+#ifdef ENABLE_GATT_OVER_EATT
+    // EATT bearer: L2CAP channel and its SDU buffers, l2cap_cid == 0 for the unenhanced bearer
+    uint16_t  l2cap_cid;
+    uint8_t * eatt_receive_buffer;
+    uint8_t * eatt_send_buffer;
+
+    // unenhanced bearer: list of EATT bearers for this connection
+    gatt_client_eatt_state_t eatt_state;
+    btstack_linked_list_t    eatt_clients;
+    btstack_packet_handler_t eatt_callback;
+    uint8_t                  eatt_num_pending;
+    uint8_t                  eatt_status;
+#endif
+
 } gatt_client_t;
 
+typedef enum {
+    GATT_CLIENT_REQUEST_TYPE_READ_VALUE,
+    GATT_CLIENT_REQUEST_TYPE_WRITE_VALUE,
+    GATT_CLIENT_REQUEST_TYPE_WRITE_CLIENT_CHARACTERISTIC_CONFIGURATION,
+} gatt_client_request_type_t;
+
+// item of per-connection request queue, owned by caller until GATT_EVENT_REQUEST_COMPLETE
+typedef struct gatt_client_request {
+    btstack_linked_item_t    item;
+    btstack_packet_handler_t callback;
+    gatt_client_request_type_t type;
+
+    // value handle
+    uint16_t attribute_handle;
+
+    // write value
+    uint16_t value_length;
+    const uint8_t * value;
+
+    // client characteristic configuration
+    uint16_t characteristic_end_handle;
+    uint16_t client_characteristic_configuration_handle;
+    uint8_t  client_characteristic_configuration_value[2];
+
+    // internal
+    uint8_t  flags;
+} gatt_client_request_t;
+
 typedef struct gatt_client_notification {
     btstack_linked_item_t    item;
     btstack_packet_handler_t callback;
@@ -735,6 +827,78 @@ uint8_t gatt_client_execute_write(btstack_packet_handler_t callback, hci_con_han
  */
 uint8_t gatt_client_cancel_write(btstack_packet_handler_t callback, hci_con_handle_t con_handle);
 
+/**
+ * @brief Setup request to read value of characteristic for gatt_client_request_queue_add.
+ * The value is reported with GATT_EVENT_CHARACTERISTIC_VALUE_QUERY_RESULT. Values longer than MTU - 1 are truncated.
+ * @param request
+ * @param value_handle
+ */
+void gatt_client_request_init_read_value(gatt_client_request_t * request, uint16_t value_handle);
+
+/**
+ * @brief Setup request to write value of characteristic with Write Request for gatt_client_request_queue_add
+ * @param request
+ * @param value_handle
+ * @param value_length up to MTU - 3
+ * @param value is not copied, make sure memory is accessible until GATT_EVENT_REQUEST_COMPLETE is received
+ */
+void gatt_client_request_init_write_value(gatt_client_request_t * request, uint16_t value_handle, uint16_t value_length, const uint8_t * value);
+
+/**
+ * @brief Setup request to write client characteristic configuration for gatt_client_request_queue_add
+ * @param request
+ * @param characteristic
+ * @param configuration GATT_CLIENT_CHARACTERISTICS_CONFIGURATION_NOTIFICATION, GATT_CLIENT_CHARACTERISTICS_CONFIGURATION_INDICATION
+ * @return status GATT_CLIENT_CHARACTERISTIC_NOTIFICATION_NOT_SUPPORTED     if configuring notification, but characteristic has no notification property set
+ *                GATT_CLIENT_CHARACTERISTIC_INDICATION_NOT_SUPPORTED       if configuring indication, but characteristic has no indication property set
+ *                ERROR_CODE_SUCCESS                                        if request is valid
+ */
+uint8_t gatt_client_request_init_write_client_characteristic_configuration(gatt_client_request_t * request, gatt_client_characteristic_t * characteristic, uint16_t configuration);
+
+/**
+ * @brief Add batch of requests to request queue of a connection. Queued requests are sent back-to-back as soon as the GATT client
+ * is ready; consecutive reads are combined into Read Multiple Variable Length Requests if supported by the server.
+ * Each request is completed by GATT_EVENT_REQUEST_COMPLETE, after which its struct can be re-used.
+ * @note While requests are pending, other GATT client queries for this connection return GATT_CLIENT_IN_WRONG_STATE
+ * @param  callback
+ * @param  con_handle
+ * @param  requests array
+ * @param  num_requests
+ * @return status BTSTACK_MEMORY_ALLOC_FAILED                               if no GATT client for con_handle is found
+ *                ERROR_CODE_SUCCESS                                        if requests are queued
+ */
+uint8_t gatt_client_request_queue_add(btstack_packet_handler_t callback, hci_con_handle_t con_handle, gatt_client_request_t * requests, uint16_t num_requests);
+
+#ifdef ENABLE_GATT_OVER_EATT
+/**
+ * @brief Setup Enhanced ATT bearers for an encrypted LE connection. GATT client queries for this connection are
+ * distributed over the idle EATT bearers and the unenhanced ATT bearer, which allows for parallel transactions.
+ * The bearers are requested with a single L2CAP Enhanced Credit-Based Flow Control Mode connection request.
+ * GATT_EVENT_EATT_CONNECTED is emitted once all L2CAP channels have been opened or failed.
+ * @note storage_buffer needs to be pointer-aligned and is split evenly between the bearers. Each bearer uses
+ *       a gatt_client_t plus receive and send buffers of equal size, which define its ATT MTU (at least 64).
+ * @param callback   for GATT_EVENT_EATT_CONNECTED
+ * @param con_handle
+ * @param num_channels   1..L2CAP_ECBM_MAX_CID_ARRAY_SIZE
+ * @param storage_buffer
+ * @param storage_size
+ * @return status BTSTACK_MEMORY_ALLOC_FAILED                               if no GATT client for con_handle could be allocated
+ *                GATT_CLIENT_IN_WRONG_STATE                                if EATT bearers have already been requested
+ *                ERROR_CODE_MEMORY_CAPACITY_EXCEEDED                       if storage is too small
+ *                ERROR_CODE_SUCCESS                                        if L2CAP channels are being set up
+ */
+uint8_t gatt_client_le_enhanced_connect(btstack_packet_handler_t callback, hci_con_handle_t con_handle, uint8_t num_channels, uint8_t * storage_buffer, uint16_t storage_size);
+#endif
+
+#ifdef ENABLE_GATT_CLIENT_CACHE
+/**
+ * @brief Delete cached services, characteristics and descriptors of a bonded device, e.g. after its bonding information was removed
+ * @note The cache is validated with the remote Database Hash on each connection and cleared on Service Changed indications
+ * @param le_device_index of the bonded device
+ */
+void gatt_client_cache_delete(int le_device_index);
+#endif
+
 /* API_END */
 
 // used by generated btstack_event.c
@@ -200,6 +200,10 @@ typedef enum {
 #define ERROR_CODE_CONNECTION_FAILED_TO_BE_ESTABLISHED     0x3E
 #define ERROR_CODE_MAC_CONNECTION_FAILED                   0x3F
 #define ERROR_CODE_COARSE_CLOCK_ADJUSTMENT_REJECTED_BUT_WILL_TRY_TO_ADJUST_USING_CLOCK_DRAGGING 0x40
+#define ERROR_CODE_TYPE0_SUBMAP_NOT_DEFINED                0x41
+#define ERROR_CODE_UNKNOWN_ADVERTISING_IDENTIFIER          0x42
+#define ERROR_CODE_LIMIT_REACHED                           0x43
+#define ERROR_CODE_OPERATION_CANCELLED_BY_HOST             0x44
 
 // BTstack defined ERRORS, mapped into BLuetooth status code range
 
@@ -579,6 +583,7 @@ typedef enum {
 #define ATT_ERROR_INSUFFICIENT_ENCRYPTION          0x0f
 #define ATT_ERROR_UNSUPPORTED_GROUP_TYPE           0x10
 #define ATT_ERROR_INSUFFICIENT_RESOURCES           0x11
+#define ATT_ERROR_VALUE_NOT_ALLOWED                0x13
 
 // MARK: ATT Error Codes used internally by BTstack
 #define ATT_ERROR_HCI_DISCONNECT_RECEIVED          0x1f
@@ -654,6 +659,13 @@ typedef enum {
 #define GAP_RECONNECTION_ADDRESS_UUID  0x2a03
 #define GAP_PERIPHERAL_PREFERRED_CONNECTION_PARAMETERS_UUID 0x2a04
 #define GAP_SERVICE_CHANGED            0x2a05
+#define GAP_CLIENT_SUPPORTED_FEATURES  0x2b29
+#define GAP_DATABASE_HASH              0x2b2a
+
+// GATT Client Supported Features bits
+#define GATT_CLIENT_SUPPORTED_FEATURES_ROBUST_CACHING                       0x01
+#define GATT_CLIENT_SUPPORTED_FEATURES_ENHANCED_ATT_BEARER                  0x02
+#define GATT_CLIENT_SUPPORTED_FEATURES_MULTIPLE_HANDLE_VALUE_NOTIFICATIONS  0x04
 
 // Bluetooth GATT types
 
@@ -65,6 +65,7 @@
 #include "btstack_memory_pool.h"
 #include "btstack_network.h"
 #include "btstack_run_loop.h"
+#include "btstack_stats.h"
 #include "btstack_stdin.h"
 #include "btstack_util.h"
 #include "gap.h"
@@ -113,6 +114,7 @@
 #include "classic/avrcp_media_item_iterator.h"
 #include "classic/avrcp_target.h"
 #include "classic/bnep.h"
+#include "classic/btstack_jitter_buffer.h"
 #include "classic/btstack_link_key_db.h"
 #include "classic/btstack_sbc.h"
 #include "classic/device_id_server.h"
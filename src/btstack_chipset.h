@@ -93,6 +93,13 @@ typedef struct {
      */
     void (*set_bd_addr_command)(bd_addr_t addr, uint8_t *hci_cmd_buffer); 
 
+    /**
+     * optional: max number of init script commands in flight. With ENABLE_HCI_INIT_PIPELINING,
+     * the next command is sent before the Command Complete of the previous one, as long as the
+     * Controller provides command credits. 0 or 1 = wait for each Command Complete
+     */
+    uint8_t init_script_pipeline_depth;
+
 } btstack_chipset_t;
 
 #if defined __cplusplus
@@ -43,6 +43,7 @@
 #include "btstack_debug.h"
 #include "btstack_event.h"
 #include "btstack_linked_list.h"
+#include "btstack_stats.h"
 #include "btstack_util.h"
 #include "hci.h"
 
@@ -839,6 +840,8 @@ static void btstack_crypto_run(void){
     // try to do as much as possible
     while (true){
 
+        BTSTACK_STATS_CRYPTO_QUEUE_DEPTH((uint16_t) btstack_linked_list_count(&btstack_crypto_operations));
+
         // anything to do?
         if (btstack_linked_list_empty(&btstack_crypto_operations)) return;
 
@@ -1176,13 +1179,19 @@ void btstack_crypto_init(void){
 #endif
 }
 
+static void btstack_crypto_queue_operation(btstack_crypto_t * btstack_crypto){
+    btstack_linked_list_add_tail(&btstack_crypto_operations, (btstack_linked_item_t*) btstack_crypto);
+    BTSTACK_STATS_INCREMENT(CRYPTO_OPERATIONS);
+    BTSTACK_STATS_CRYPTO_QUEUE_DEPTH((uint16_t) btstack_linked_list_count(&btstack_crypto_operations));
+}
+
 void btstack_crypto_random_generate(btstack_crypto_random_t * request, uint8_t * buffer, uint16_t size, void (* callback)(void * arg), void * callback_arg){
 	request->btstack_crypto.context_callback.callback  = callback;
 	request->btstack_crypto.context_callback.context   = callback_arg;
 	request->btstack_crypto.operation         		   = BTSTACK_CRYPTO_RANDOM;
 	request->buffer = buffer;
 	request->size   = size;
-	btstack_linked_list_add_tail(&btstack_crypto_operations, (btstack_linked_item_t*) request);
+	btstack_crypto_queue_operation((btstack_crypto_t *) request);
 	btstack_crypto_run();
 }
 
@@ -1193,7 +1202,7 @@ void btstack_crypto_aes128_encrypt(btstack_crypto_aes128_t * request, const uint
 	request->key 									   = key;
 	request->plaintext      					       = plaintext;
 	request->ciphertext 							   = ciphertext;
-	btstack_linked_list_add_tail(&btstack_crypto_operations, (btstack_linked_item_t*) request);
+	btstack_crypto_queue_operation((btstack_crypto_t *) request);
 	btstack_crypto_run();
 }
 
@@ -1205,7 +1214,7 @@ void btstack_crypto_aes128_cmac_generator(btstack_crypto_aes128_cmac_t * request
 	request->size 									   = size;
 	request->data.get_byte_callback					   = get_byte_callback;
 	request->hash 									   = hash;
-	btstack_linked_list_add_tail(&btstack_crypto_operations, (btstack_linked_item_t*) request);
+	btstack_crypto_queue_operation((btstack_crypto_t *) request);
 	btstack_crypto_run();
 }
 
@@ -1217,7 +1226,7 @@ void btstack_crypto_aes128_cmac_message(btstack_crypto_aes128_cmac_t * request,
 	request->size 									   = size;
 	request->data.message      						   = message;
 	request->hash 									   = hash;
-	btstack_linked_list_add_tail(&btstack_crypto_operations, (btstack_linked_item_t*) request);
+	btstack_crypto_queue_operation((btstack_crypto_t *) request);
 	btstack_crypto_run();
 }
 
@@ -1229,7 +1238,7 @@ void btstack_crypto_aes128_cmac_zero(btstack_crypto_aes128_cmac_t * request, uin
     request->size                                      = len;
     request->data.message                              = message;
     request->hash                                      = hash;
-    btstack_linked_list_add_tail(&btstack_crypto_operations, (btstack_linked_item_t*) request);
+    btstack_crypto_queue_operation((btstack_crypto_t *) request);
     btstack_crypto_run();
 }
 
@@ -1244,7 +1253,7 @@ void btstack_crypto_ecc_p256_generate_key(btstack_crypto_ecc_p256_t * request, u
     request->btstack_crypto.context_callback.context   = callback_arg;
     request->btstack_crypto.operation                  = BTSTACK_CRYPTO_ECC_P256_GENERATE_KEY;
     request->public_key                                = public_key;
-    btstack_linked_list_add_tail(&btstack_crypto_operations, (btstack_linked_item_t*) request);
+    btstack_crypto_queue_operation((btstack_crypto_t *) request);
     btstack_crypto_run();
 }
 
@@ -1254,7 +1263,7 @@ void btstack_crypto_ecc_p256_calculate_dhkey(btstack_crypto_ecc_p256_t * request
     request->btstack_crypto.operation                  = BTSTACK_CRYPTO_ECC_P256_CALCULATE_DHKEY;
     request->public_key                                = (uint8_t *) public_key;
     request->dhkey                                     = dhkey;
-    btstack_linked_list_add_tail(&btstack_crypto_operations, (btstack_linked_item_t*) request);
+    btstack_crypto_queue_operation((btstack_crypto_t *) request);
     btstack_crypto_run();
 }
 
@@ -1308,7 +1317,7 @@ void btstack_crypto_ccm_digest(btstack_crypto_ccm_t * request, uint8_t * additio
     request->btstack_crypto.operation                  = BTSTACK_CRYPTO_CCM_DIGEST_BLOCK;
     request->block_len                                 = additional_authenticated_data_len;
     request->input                                     = additional_authenticated_data;
-    btstack_linked_list_add_tail(&btstack_crypto_operations, (btstack_linked_item_t*) request);
+    btstack_crypto_queue_operation((btstack_crypto_t *) request);
     btstack_crypto_run();
 }
 
@@ -1329,7 +1338,7 @@ void btstack_crypto_ccm_encrypt_block(btstack_crypto_ccm_t * request, uint16_t b
     if (request->state != CCM_CALCULATE_X1){
         request->state  = CCM_CALCULATE_XN;
     }
-    btstack_linked_list_add_tail(&btstack_crypto_operations, (btstack_linked_item_t*) request);
+    btstack_crypto_queue_operation((btstack_crypto_t *) request);
     btstack_crypto_run();
 }
 
@@ -1343,7 +1352,7 @@ void btstack_crypto_ccm_decrypt_block(btstack_crypto_ccm_t * request, uint16_t b
     if (request->state != CCM_CALCULATE_X1){
         request->state  = CCM_CALCULATE_SN;
     }
-    btstack_linked_list_add_tail(&btstack_crypto_operations, (btstack_linked_item_t*) request);
+    btstack_crypto_queue_operation((btstack_crypto_t *) request);
     btstack_crypto_run();
 }
 
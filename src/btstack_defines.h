@@ -162,6 +162,24 @@ typedef uint8_t sm_key_t[16];
 // set global Bluetooth state
 #define BTSTACK_SET_BLUETOOTH_ENABLED                      0x08
 
+// subscribe to / unsubscribe from event: param event_code(8)
+#define BTSTACK_SUBSCRIBE_EVENT                            0x09
+#define BTSTACK_UNSUBSCRIBE_EVENT                          0x0a
+
+// subscribe to / unsubscribe from events and data for connection: param con_handle(16)
+#define BTSTACK_SUBSCRIBE_CON_HANDLE                       0x0b
+#define BTSTACK_UNSUBSCRIBE_CON_HANDLE                     0x0c
+
+// subscribe to / unsubscribe from events for L2CAP/RFCOMM channel: param local_cid(16)
+#define BTSTACK_SUBSCRIBE_CHANNEL                          0x0d
+#define BTSTACK_UNSUBSCRIBE_CHANNEL                        0x0e
+
+// remove all subscriptions, client receives all events again
+#define BTSTACK_CLEAR_SUBSCRIPTIONS                        0x0f
+
+// get btstack_stats counters as Prometheus text, answered with DAEMON_EVENT_STATS events
+#define BTSTACK_GET_STATS                                  0x10
+
 // create l2cap channel: param bd_addr(48), psm (16)
 #define L2CAP_CREATE_CHANNEL                               0x20
 
@@ -644,6 +662,68 @@ typedef uint8_t sm_key_t[16];
 // array of advertisements, not handled by event accessor generator
 #define HCI_SUBEVENT_LE_DIRECT_ADVERTISING_REPORT          0x0B
 
+// array of advertisements, not handled by event accessor generator
+#define HCI_SUBEVENT_LE_EXTENDED_ADVERTISING_REPORT        0x0D
+
+/**
+ * @format 112111B121
+ * @param subevent_code
+ * @param status
+ * @param sync_handle
+ * @param advertising_sid
+ * @param advertiser_address_type
+ * @param advertiser_address
+ * @param advertiser_phy
+ * @param periodic_advertising_interval
+ * @param advertiser_clock_accuracy
+ */
+#define HCI_SUBEVENT_LE_PERIODIC_ADVERTISING_SYNC_ESTABLISHMENT 0x0E
+
+/**
+ * @format 121111JV
+ * @param subevent_code
+ * @param sync_handle
+ * @param tx_power
+ * @param rssi
+ * @param cte_type
+ * @param data_status
+ * @param data_length
+ * @param data
+ */
+#define HCI_SUBEVENT_LE_PERIODIC_ADVERTISING_REPORT        0x0F
+
+/**
+ * @format 12
+ * @param subevent_code
+ * @param sync_handle
+ */
+#define HCI_SUBEVENT_LE_PERIODIC_ADVERTISING_SYNC_LOST     0x10
+
+/**
+ * @format 1
+ * @param subevent_code
+ */
+#define HCI_SUBEVENT_LE_SCAN_TIMEOUT                       0x11
+
+/**
+ * @format 111H1
+ * @param subevent_code
+ * @param status
+ * @param advertising_handle
+ * @param connection_handle
+ * @param num_completed_extended_advertising_events
+ */
+#define HCI_SUBEVENT_LE_ADVERTISING_SET_TERMINATED         0x12
+
+/**
+ * @format 111B
+ * @param subevent_code
+ * @param advertising_handle
+ * @param scanner_address_type
+ * @param scanner_address
+ */
+#define HCI_SUBEVENT_LE_SCAN_REQUEST_RECEIVED              0x13
+
 
 /**
  * @format 1
@@ -701,6 +781,15 @@ typedef uint8_t sm_key_t[16];
 // internal - data: event(8)
 #define DAEMON_EVENT_CONNECTION_CLOSED                     0x68
 
+/**
+ * @brief Part of btstack_stats counters in Prometheus text format, response to BTSTACK_GET_STATS
+ * @format 1JV
+ * @param more_follows
+ * @param data_len
+ * @param data
+ */
+#define DAEMON_EVENT_STATS                                 0x6A
+
 // data: event(8), len(8), local_cid(16), credits(8)
 #define DAEMON_EVENT_L2CAP_CREDITS                         0x74
 
@@ -888,6 +977,50 @@ typedef uint8_t sm_key_t[16];
  */
 #define L2CAP_EVENT_TRIGGER_RUN                            0x7f
 
+// LE Enhanced Credit-Based Flow Control Mode
+
+/**
+ * @format 1BH2122
+ * @param address_type
+ * @param address
+ * @param handle
+ * @param psm
+ * @param num_channels
+ * @param local_cid
+ * @param remote_mtu
+ */
+#define L2CAP_EVENT_ECBM_INCOMING_CONNECTION               0x8a
+
+/**
+ * @format 11BH122222
+ * @param status
+ * @param address_type
+ * @param address
+ * @param handle
+ * @param incoming
+ * @param psm
+ * @param local_cid
+ * @param remote_cid
+ * @param local_mtu
+ * @param remote_mtu
+ */
+#define L2CAP_EVENT_ECBM_CHANNEL_OPENED                    0x8b
+
+/*
+ * @format 222
+ * @param local_cid
+ * @param remote_mtu
+ * @param remote_mps
+ */
+#define L2CAP_EVENT_ECBM_RECONFIGURED                      0x8c
+
+/*
+ * @format 22
+ * @param local_cid
+ * @param result
+ */
+#define L2CAP_EVENT_ECBM_RECONFIGURATION_COMPLETE          0x8d
+
 
 // RFCOMM EVENTS
 
@@ -1090,6 +1223,22 @@ typedef uint8_t sm_key_t[16];
  */
 #define GATT_EVENT_CAN_WRITE_WITHOUT_RESPONSE                    0xAC
 
+/**
+ * @format H21
+ * @param handle
+ * @param attribute_handle
+ * @param att_status  see ATT errors in bluetooth.h
+ */
+#define GATT_EVENT_REQUEST_COMPLETE                              0xAD
+
+/**
+ * @format H11
+ * @param handle
+ * @param status
+ * @param num_bearers
+ */
+#define GATT_EVENT_EATT_CONNECTED                                0xAE
+
 /** 
  * @format 1BH
  * @param address_type
@@ -1379,6 +1528,26 @@ typedef uint8_t sm_key_t[16];
  */
 #define GAP_EVENT_RSSI_MEASUREMENT                            0xE5
 
+/**
+ * @format 21B1111121BLV
+ * @param advertising_event_type
+ * @param address_type
+ * @param address
+ * @param primary_phy
+ * @param secondary_phy
+ * @param advertising_sid
+ * @param tx_power
+ * @param rssi
+ * @param periodic_advertising_interval
+ * @param direct_address_type
+ * @param direct_address
+ * @param data_length
+ * @param data
+ * @note Reassembled from chained LE Extended Advertising Reports. Reports with more than 230 bytes of data are split
+ *       into several events, all but the last one with data status 'incomplete, more data to come' in advertising_event_type
+ */
+#define GAP_EVENT_EXTENDED_ADVERTISING_REPORT                 0xE6
+
 // Meta Events, see below for sub events
 #define HCI_EVENT_HSP_META                                 0xE8
 #define HCI_EVENT_HFP_META                                 0xE9
@@ -40,6 +40,7 @@
 #include <string.h>
 
 #include "btstack_hid_parser.h"
+#include "btstack_bool.h"
 #include "btstack_util.h"
 #include "btstack_debug.h"
 
@@ -518,3 +519,392 @@ int btstack_hid_report_id_declared(uint16_t hid_descriptor_len, const uint8_t *
     }
     return 0;
 }
+
+// COMPILED REPORT LAYOUT
+
+void btstack_hid_report_layout_init(btstack_hid_report_layout_t * layout, btstack_hid_report_t * reports, uint16_t max_reports, btstack_hid_field_t * fields, uint16_t max_fields){
+    memset(layout, 0, sizeof(btstack_hid_report_layout_t));
+    layout->reports     = reports;
+    layout->max_reports = max_reports;
+    layout->fields      = fields;
+    layout->max_fields  = (fields == NULL) ? 0 : max_fields;
+}
+
+static btstack_hid_report_t * hid_report_layout_get_or_add_report(btstack_hid_report_layout_t * layout, hid_report_type_t report_type, uint8_t report_id){
+    uint16_t i;
+    for (i = 0; i < layout->num_reports; i++){
+        btstack_hid_report_t * report = &layout->reports[i];
+        if ((report->report_type == (uint8_t) report_type) && (report->report_id == report_id)) return report;
+    }
+    if (layout->num_reports == layout->max_reports) return NULL;
+    btstack_hid_report_t * report = &layout->reports[layout->num_reports++];
+    memset(report, 0, sizeof(btstack_hid_report_t));
+    report->report_type = (uint8_t) report_type;
+    report->report_id   = report_id;
+    report->first_field = layout->num_fields;
+    return report;
+}
+
+static bool hid_report_layout_add_field(btstack_hid_report_layout_t * layout, btstack_hid_report_t * report, const btstack_hid_field_t * field){
+    if (layout->fields == NULL) return true;
+    uint16_t pos = report->first_field + report->num_fields;
+
+    // extend previous field if usages continue, e.g. X and Y declared with separate Usage items
+    if (report->num_fields > 0u){
+        btstack_hid_field_t * previous = &layout->fields[pos - 1u];
+        if ((previous->flags & 2u) && (previous->flags == field->flags)
+        && (previous->report_size == field->report_size)
+        && (previous->logical_minimum == field->logical_minimum)
+        && (previous->logical_maximum == field->logical_maximum)
+        && ((previous->bit_offset + (previous->report_count * previous->report_size)) == field->bit_offset)
+        && ((previous->usage_maximum - previous->usage_minimum + 1u) == previous->report_count)
+        && ((previous->usage_maximum + 1u) == field->usage_minimum)){
+            previous->report_count += field->report_count;
+            previous->usage_maximum = field->usage_maximum;
+            return true;
+        }
+    }
+
+    if (layout->num_fields == layout->max_fields) return false;
+
+    // keep fields grouped by report
+    memmove(&layout->fields[pos + 1u], &layout->fields[pos], (layout->num_fields - pos) * sizeof(btstack_hid_field_t));
+    layout->fields[pos] = *field;
+    layout->num_fields++;
+    report->num_fields++;
+    btstack_hid_report_t * next_report;
+    for (next_report = report + 1; next_report < &layout->reports[layout->num_reports]; next_report++){
+        next_report->first_field++;
+    }
+    return true;
+}
+
+// emit fields for main item using the local usage items declared since the last main item
+static bool hid_report_layout_add_fields(btstack_hid_report_layout_t * layout, btstack_hid_report_t * report, btstack_hid_field_t * field,
+                                         const uint8_t * usage_items, uint16_t usage_items_len, uint16_t usage_page){
+    int is_variable = field->flags & 2u;
+    uint16_t remaining = field->report_count;
+    uint32_t last_usage = ((uint32_t) usage_page) << 16;
+    uint32_t usage_minimum = 0;
+    uint32_t usage_maximum = 0;
+    int have_usage_min = 0;
+    int have_usage_max = 0;
+    int have_usage = 0;
+
+    uint32_t array_usage_minimum = last_usage;
+    uint32_t array_usage_maximum = last_usage;
+
+    while (usage_items_len){
+        hid_descriptor_item_t item;
+        btstack_hid_parse_descriptor_item(&item, usage_items, usage_items_len);
+        if (item.item_size == 0u) break;
+        usage_items_len -= item.item_size;
+        usage_items     += item.item_size;
+
+        if ((item.item_type == Global) && (item.item_tag == UsagePage)){
+            usage_page = item.item_value;
+            continue;
+        }
+        if (item.item_type != Local) continue;
+
+        uint32_t usage_value = (item.data_size > 2u) ? (uint32_t) item.item_value : ((((uint32_t) usage_page) << 16u) | (uint32_t) item.item_value);
+        int have_range = 0;
+        switch (item.item_tag){
+            case Usage:
+                usage_minimum = usage_value;
+                usage_maximum = usage_value;
+                have_range = 1;
+                break;
+            case UsageMinimum:
+                usage_minimum = usage_value;
+                have_usage_min = 1;
+                break;
+            case UsageMaximum:
+                usage_maximum = usage_value;
+                have_usage_max = 1;
+                break;
+            default:
+                break;
+        }
+        if (have_usage_min && have_usage_max){
+            have_usage_min = 0;
+            have_usage_max = 0;
+            have_range = usage_maximum >= usage_minimum;
+        }
+        if (!have_range) continue;
+
+        if (!is_variable){
+            if (!have_usage){
+                array_usage_minimum = usage_minimum;
+            }
+            array_usage_maximum = usage_maximum;
+            have_usage = 1;
+            continue;
+        }
+
+        if (remaining == 0u) continue;
+        uint32_t num_usages = usage_maximum - usage_minimum + 1u;
+        uint16_t count = (num_usages < remaining) ? (uint16_t) num_usages : remaining;
+        field->usage_minimum = usage_minimum;
+        field->usage_maximum = usage_minimum + count - 1u;
+        field->report_count  = count;
+        if (!hid_report_layout_add_field(layout, report, field)) return false;
+        field->bit_offset += count * field->report_size;
+        remaining  -= count;
+        last_usage  = field->usage_maximum;
+    }
+
+    if (!is_variable){
+        field->usage_minimum = array_usage_minimum;
+        field->usage_maximum = array_usage_maximum;
+        return hid_report_layout_add_field(layout, report, field);
+    }
+
+    // remaining elements use last usage
+    if (remaining == 0u) return true;
+    field->usage_minimum = last_usage;
+    field->usage_maximum = last_usage;
+    field->report_count  = remaining;
+    return hid_report_layout_add_field(layout, report, field);
+}
+
+uint8_t btstack_hid_report_layout_compile(btstack_hid_report_layout_t * layout, uint16_t hid_descriptor_len, const uint8_t * hid_descriptor){
+    layout->num_reports = 0;
+    layout->num_fields  = 0;
+    layout->report_id_declared = 0;
+
+    int32_t  global_logical_minimum = 0;
+    int32_t  global_logical_maximum = 0;
+    uint16_t global_usage_page   = 0;
+    uint16_t global_report_size  = 0;
+    uint16_t global_report_count = 0;
+    uint8_t  global_report_id    = 0;
+
+    // local items since last main item
+    uint16_t usage_pos  = 0;
+    uint16_t usage_page = 0;
+
+    uint16_t pos = 0;
+    while (pos < hid_descriptor_len){
+        hid_descriptor_item_t item;
+        btstack_hid_parse_descriptor_item(&item, &hid_descriptor[pos], hid_descriptor_len - pos);
+        if ((item.item_size == 0u) || (item.item_size > (hid_descriptor_len - pos))) break;
+
+        hid_report_type_t report_type = HID_REPORT_TYPE_RESERVED;
+        switch (item.item_type){
+            case Global:
+                switch ((GlobalItemTag)item.item_tag){
+                    case UsagePage:
+                        global_usage_page = item.item_value;
+                        break;
+                    case LogicalMinimum:
+                        global_logical_minimum = item.item_value;
+                        break;
+                    case LogicalMaximum:
+                        global_logical_maximum = item.item_value;
+                        break;
+                    case ReportSize:
+                        global_report_size = item.item_value;
+                        break;
+                    case ReportID:
+                        global_report_id = item.item_value;
+                        layout->report_id_declared = 1;
+                        break;
+                    case ReportCount:
+                        global_report_count = item.item_value;
+                        break;
+                    default:
+                        break;
+                }
+                break;
+            case Main:
+                switch ((MainItemTag)item.item_tag){
+                    case Input:
+                        report_type = HID_REPORT_TYPE_INPUT;
+                        break;
+                    case Output:
+                        report_type = HID_REPORT_TYPE_OUTPUT;
+                        break;
+                    case Feature:
+                        report_type = HID_REPORT_TYPE_FEATURE;
+                        break;
+                    default:
+                        break;
+                }
+                break;
+            default:
+                break;
+        }
+
+        if (report_type != HID_REPORT_TYPE_RESERVED){
+            btstack_hid_report_t * report = hid_report_layout_get_or_add_report(layout, report_type, global_report_id);
+            if (report == NULL){
+                log_error("HID layout: more than %u reports", layout->max_reports);
+                return ERROR_CODE_MEMORY_CAPACITY_EXCEEDED;
+            }
+            uint16_t bit_offset = report->report_size_in_bits;
+            report->report_size_in_bits += global_report_size * global_report_count;
+
+            // skip constant fields used for padding and empty items
+            int is_constant = item.item_value & 1;
+            if (!is_constant && (global_report_count > 0u)){
+                if ((global_report_size == 0u) || (global_report_size > 32u)){
+                    log_error("HID layout: report size %u not supported", global_report_size);
+                } else {
+                    btstack_hid_field_t field;
+                    memset(&field, 0, sizeof(btstack_hid_field_t));
+                    field.logical_minimum = global_logical_minimum;
+                    field.logical_maximum = global_logical_maximum;
+                    field.bit_offset      = bit_offset;
+                    field.report_count    = global_report_count;
+                    field.report_size     = (uint8_t) global_report_size;
+                    field.flags           = (uint8_t) item.item_value;
+                    if (!hid_report_layout_add_fields(layout, report, &field, &hid_descriptor[usage_pos], pos - usage_pos, usage_page)){
+                        log_error("HID layout: more than %u fields", layout->max_fields);
+                        return ERROR_CODE_MEMORY_CAPACITY_EXCEEDED;
+                    }
+                }
+            }
+        }
+
+        pos += item.item_size;
+
+        // local items only apply to next main item
+        if (item.item_type == Main){
+            usage_pos  = pos;
+            usage_page = global_usage_page;
+        }
+    }
+    return ERROR_CODE_SUCCESS;
+}
+
+const btstack_hid_report_t * btstack_hid_report_layout_get_report(const btstack_hid_report_layout_t * layout, hid_report_type_t report_type, int report_id){
+    uint16_t i;
+    for (i = 0; i < layout->num_reports; i++){
+        const btstack_hid_report_t * report = &layout->reports[i];
+        if ((report->report_type == (uint8_t) report_type) && (report->report_id == report_id)) return report;
+    }
+    return NULL;
+}
+
+int btstack_hid_report_layout_get_report_size(const btstack_hid_report_layout_t * layout, int report_id, hid_report_type_t report_type){
+    const btstack_hid_report_t * report = btstack_hid_report_layout_get_report(layout, report_type, report_id);
+    if (report == NULL) return 0;
+    return (report->report_size_in_bits + 7u) / 8u;
+}
+
+hid_report_id_status_t btstack_hid_report_layout_id_valid(const btstack_hid_report_layout_t * layout, int report_id){
+    if (!layout->report_id_declared) return HID_REPORT_ID_UNDECLARED;
+    uint16_t i;
+    for (i = 0; i < layout->num_reports; i++){
+        if (layout->reports[i].report_id == report_id) return HID_REPORT_ID_VALID;
+    }
+    return HID_REPORT_ID_INVALID;
+}
+
+int btstack_hid_report_layout_report_id_declared(const btstack_hid_report_layout_t * layout){
+    return layout->report_id_declared;
+}
+
+static uint32_t hid_field_get_usage(const btstack_hid_field_t * field, uint16_t element){
+    if (element > (field->usage_maximum - field->usage_minimum)) return field->usage_maximum;
+    return field->usage_minimum + element;
+}
+
+const btstack_hid_field_t * btstack_hid_report_layout_find_usage(const btstack_hid_report_layout_t * layout, const btstack_hid_report_t * report, uint16_t usage_page, uint16_t usage, uint16_t * element){
+    if ((layout->fields == NULL) || (report == NULL)) return NULL;
+    uint32_t extended_usage = (((uint32_t) usage_page) << 16) | usage;
+    uint16_t i;
+    for (i = 0; i < report->num_fields; i++){
+        const btstack_hid_field_t * field = &layout->fields[report->first_field + i];
+        if ((field->flags & 2u) == 0u) continue;
+        if (extended_usage < field->usage_minimum) continue;
+        if (extended_usage > field->usage_maximum) continue;
+        *element = extended_usage - field->usage_minimum;
+        return field;
+    }
+    return NULL;
+}
+
+static uint32_t hid_field_read_bits(const uint8_t * report_data, uint16_t report_data_len, uint32_t bit_pos, uint8_t num_bits){
+    uint32_t value = 0;
+    uint8_t bits_read = 0;
+    while (bits_read < num_bits){
+        uint32_t byte_pos    = bit_pos >> 3;
+        uint8_t  bit_in_byte = bit_pos & 0x07u;
+        uint8_t  chunk       = btstack_min(8u - bit_in_byte, num_bits - bits_read);
+        uint32_t byte_value  = (byte_pos < report_data_len) ? report_data[byte_pos] : 0u;
+        value     |= ((byte_value >> bit_in_byte) & ((1u << chunk) - 1u)) << bits_read;
+        bits_read += chunk;
+        bit_pos   += chunk;
+    }
+    return value;
+}
+
+int32_t btstack_hid_field_get_value(const btstack_hid_field_t * field, uint16_t element, const uint8_t * report_data, uint16_t report_data_len){
+    uint32_t bit_pos = field->bit_offset + ((uint32_t) element * field->report_size);
+    uint32_t unsigned_value = hid_field_read_bits(report_data, report_data_len, bit_pos, field->report_size);
+    if ((field->logical_minimum < 0) && (field->report_size < 32u) && (unsigned_value & (1u << (field->report_size - 1u)))){
+        unsigned_value |= ~((1u << field->report_size) - 1u);
+    }
+    return (int32_t) unsigned_value;
+}
+
+void btstack_hid_field_set_value(const btstack_hid_field_t * field, uint16_t element, int32_t value, uint8_t * report_data, uint16_t report_data_len){
+    uint32_t bit_pos = field->bit_offset + ((uint32_t) element * field->report_size);
+    uint32_t unsigned_value = (uint32_t) value;
+    uint8_t bits_written = 0;
+    while (bits_written < field->report_size){
+        uint32_t byte_pos    = bit_pos >> 3;
+        uint8_t  bit_in_byte = bit_pos & 0x07u;
+        uint8_t  chunk       = btstack_min(8u - bit_in_byte, field->report_size - bits_written);
+        if (byte_pos >= report_data_len) break;
+        uint8_t  mask        = ((1u << chunk) - 1u) << bit_in_byte;
+        uint8_t  bits        = ((unsigned_value >> bits_written) << bit_in_byte) & mask;
+        report_data[byte_pos] = (report_data[byte_pos] & ~mask) | bits;
+        bits_written += chunk;
+        bit_pos      += chunk;
+    }
+}
+
+void btstack_hid_report_iterator_init(btstack_hid_report_iterator_t * iterator, const btstack_hid_report_layout_t * layout, hid_report_type_t report_type, const uint8_t * hid_report, uint16_t hid_report_len){
+    memset(iterator, 0, sizeof(btstack_hid_report_iterator_t));
+    uint8_t report_id = 0;
+    if (layout->report_id_declared){
+        if (hid_report_len == 0u) return;
+        report_id = hid_report[0];
+        hid_report++;
+        hid_report_len--;
+    }
+    const btstack_hid_report_t * report = btstack_hid_report_layout_get_report(layout, report_type, report_id);
+    if ((report == NULL) || (layout->fields == NULL)) return;
+    iterator->field           = &layout->fields[report->first_field];
+    iterator->fields_end      = iterator->field + report->num_fields;
+    iterator->report_data     = hid_report;
+    iterator->report_data_len = hid_report_len;
+}
+
+int btstack_hid_report_iterator_has_more(const btstack_hid_report_iterator_t * iterator){
+    return iterator->field < iterator->fields_end;
+}
+
+void btstack_hid_report_iterator_get_field(btstack_hid_report_iterator_t * iterator, uint16_t * usage_page, uint16_t * usage, int32_t * value){
+    const btstack_hid_field_t * field = iterator->field;
+    if (field->flags & 2u){
+        uint32_t extended_usage = hid_field_get_usage(field, iterator->element);
+        *usage_page = extended_usage >> 16;
+        *usage      = extended_usage & 0xffffu;
+        *value      = btstack_hid_field_get_value(field, iterator->element, iterator->report_data, iterator->report_data_len);
+    } else {
+        // array: field contains usage
+        uint32_t bit_pos = field->bit_offset + ((uint32_t) iterator->element * field->report_size);
+        *usage_page = field->usage_minimum >> 16;
+        *usage      = hid_field_read_bits(iterator->report_data, iterator->report_data_len, bit_pos, field->report_size);
+        *value      = 1;
+    }
+    iterator->element++;
+    if (iterator->element == field->report_count){
+        iterator->element = 0;
+        iterator->field++;
+    }
+}
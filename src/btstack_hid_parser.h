@@ -39,6 +39,7 @@
  *  btstack_hid_parser.h
  *
  *  Single-pass HID Report Parser: HID Report is directly parsed without preprocessing HID Descriptor to minimize memory
+ *  Compiled Report Layout: HID Descriptor is parsed once into per-report field tables for fast report decoding/encoding
  */
 
 #ifndef BTSTACK_HID_PARSER_H
@@ -161,6 +162,48 @@ typedef struct {
     uint8_t         global_report_id;
 } btstack_hid_parser_t;
 
+// compiled report layout
+
+typedef struct {
+    // (usage page << 16) | usage of first and last element, elements past usage_maximum reuse it
+    uint32_t        usage_minimum;
+    uint32_t        usage_maximum;
+    int32_t         logical_minimum;
+    int32_t         logical_maximum;
+    // position in report data without Report ID
+    uint16_t        bit_offset;
+    uint16_t        report_count;
+    uint8_t         report_size;
+    // data bits of main item: 0x01 constant, 0x02 variable, 0x04 relative
+    uint8_t         flags;
+} btstack_hid_field_t;
+
+typedef struct {
+    uint8_t         report_id;
+    uint8_t         report_type;
+    uint16_t        report_size_in_bits;
+    uint16_t        first_field;
+    uint16_t        num_fields;
+} btstack_hid_report_t;
+
+typedef struct {
+    btstack_hid_report_t * reports;
+    btstack_hid_field_t  * fields;
+    uint16_t        max_reports;
+    uint16_t        max_fields;
+    uint16_t        num_reports;
+    uint16_t        num_fields;
+    uint8_t         report_id_declared;
+} btstack_hid_report_layout_t;
+
+typedef struct {
+    const btstack_hid_field_t * field;
+    const btstack_hid_field_t * fields_end;
+    const uint8_t * report_data;
+    uint16_t        report_data_len;
+    uint16_t        element;
+} btstack_hid_report_iterator_t;
+
 /* API_START */
 
 /**
@@ -220,6 +263,116 @@ hid_report_id_status_t btstack_hid_id_valid(int report_id, uint16_t hid_descript
  * @param hid_descriptor
  */
 int btstack_hid_report_id_declared(uint16_t hid_descriptor_len, const uint8_t * hid_descriptor);
+
+/**
+ * @brief Initialize report layout with storage for reports and fields
+ * @note fields can be NULL if only report sizes and IDs are needed
+ * @param layout
+ * @param reports
+ * @param max_reports
+ * @param fields
+ * @param max_fields
+ */
+void btstack_hid_report_layout_init(btstack_hid_report_layout_t * layout, btstack_hid_report_t * reports, uint16_t max_reports, btstack_hid_field_t * fields, uint16_t max_fields);
+
+/**
+ * @brief Parse descriptor once and store position, size, usages and logical range of all report fields
+ * @param layout
+ * @param hid_descriptor_len
+ * @param hid_descriptor
+ * @return status ERROR_CODE_SUCCESS or ERROR_CODE_MEMORY_CAPACITY_EXCEEDED if report or field table is too small
+ */
+uint8_t btstack_hid_report_layout_compile(btstack_hid_report_layout_t * layout, uint16_t hid_descriptor_len, const uint8_t * hid_descriptor);
+
+/**
+ * @brief Get compiled report for given report type and report ID
+ * @param layout
+ * @param report_type
+ * @param report_id
+ * @return report or NULL if not found
+ */
+const btstack_hid_report_t * btstack_hid_report_layout_get_report(const btstack_hid_report_layout_t * layout, hid_report_type_t report_type, int report_id);
+
+/**
+ * @brief Get report size for given report ID and report type, same as btstack_hid_get_report_size_for_id
+ * @param layout
+ * @param report_id
+ * @param report_type
+ * @return report size in bytes without Report ID, 0 if not found
+ */
+int btstack_hid_report_layout_get_report_size(const btstack_hid_report_layout_t * layout, int report_id, hid_report_type_t report_type);
+
+/**
+ * @brief Check report ID, same as btstack_hid_id_valid
+ * @param layout
+ * @param report_id
+ */
+hid_report_id_status_t btstack_hid_report_layout_id_valid(const btstack_hid_report_layout_t * layout, int report_id);
+
+/**
+ * @brief Returns 1 if report ID was found in descriptor, same as btstack_hid_report_id_declared
+ * @param layout
+ */
+int btstack_hid_report_layout_report_id_declared(const btstack_hid_report_layout_t * layout);
+
+/**
+ * @brief Find field for usage in report
+ * @param layout
+ * @param report
+ * @param usage_page
+ * @param usage
+ * @param element index within field
+ * @return field or NULL if not found
+ */
+const btstack_hid_field_t * btstack_hid_report_layout_find_usage(const btstack_hid_report_layout_t * layout, const btstack_hid_report_t * report, uint16_t usage_page, uint16_t usage, uint16_t * element);
+
+/**
+ * @brief Read element of field from report data
+ * @note fields with negative logical minimum are sign extended, bits past report data len are read as 0
+ * @param field
+ * @param element
+ * @param report_data without Report ID
+ * @param report_data_len
+ * @return value
+ */
+int32_t btstack_hid_field_get_value(const btstack_hid_field_t * field, uint16_t element, const uint8_t * report_data, uint16_t report_data_len);
+
+/**
+ * @brief Write element of field into report data
+ * @note value is truncated to report size, bits past report data len are ignored
+ * @param field
+ * @param element
+ * @param value
+ * @param report_data without Report ID
+ * @param report_data_len
+ */
+void btstack_hid_field_set_value(const btstack_hid_field_t * field, uint16_t element, int32_t value, uint8_t * report_data, uint16_t report_data_len);
+
+/**
+ * @brief Initialize iterator over all fields in HID report using compiled layout
+ * @param iterator
+ * @param layout
+ * @param report_type
+ * @param hid_report starts with Report ID if declared in descriptor
+ * @param hid_report_len
+ */
+void btstack_hid_report_iterator_init(btstack_hid_report_iterator_t * iterator, const btstack_hid_report_layout_t * layout, hid_report_type_t report_type, const uint8_t * hid_report, uint16_t hid_report_len);
+
+/**
+ * @brief Checks if more fields are available
+ * @param iterator
+ */
+int btstack_hid_report_iterator_has_more(const btstack_hid_report_iterator_t * iterator);
+
+/**
+ * @brief Get next field, same as btstack_hid_parser_get_field
+ * @param iterator
+ * @param usage_page
+ * @param usage
+ * @param value provided in HID report
+ */
+void btstack_hid_report_iterator_get_field(btstack_hid_report_iterator_t * iterator, uint16_t * usage_page, uint16_t * usage, int32_t * value);
+
 /* API_END */
 
 #if defined __cplusplus
@@ -38,6 +38,7 @@
 
 #define BTSTACK_FILE__ "btstack_memory.c"
 
+
 /*
  *  btstack_memory.c
  *
@@ -50,9 +51,15 @@
 
 #include "btstack_memory.h"
 #include "btstack_memory_pool.h"
+#include "btstack_memory_slab.h"
 
 #include <stdlib.h>
 
+// with ENABLE_BTSTACK_MEMORY_SLAB, types without MAX_NR_* use growable slabs instead of malloc per object
+#if defined(HAVE_MALLOC) && defined(ENABLE_BTSTACK_MEMORY_SLAB)
+#define BTSTACK_MEMORY_USE_SLAB
+#endif
+
 
 
 // MARK: hci_connection_t
@@ -87,6 +94,14 @@ void btstack_memory_hci_connection_free(hci_connection_t *hci_connection){
     (void) hci_connection;
 };
 #endif
+#elif defined(BTSTACK_MEMORY_USE_SLAB)
+static btstack_memory_slab_t hci_connection_slab;
+hci_connection_t * btstack_memory_hci_connection_get(void){
+    return (hci_connection_t *) btstack_memory_slab_get(&hci_connection_slab);
+}
+void btstack_memory_hci_connection_free(hci_connection_t *hci_connection){
+    btstack_memory_slab_free(&hci_connection_slab, hci_connection);
+}
 #elif defined(HAVE_MALLOC)
 hci_connection_t * btstack_memory_hci_connection_get(void){
     void * buffer = malloc(sizeof(hci_connection_t));
@@ -134,6 +149,14 @@ void btstack_memory_l2cap_service_free(l2cap_service_t *l2cap_service){
     (void) l2cap_service;
 };
 #endif
+#elif defined(BTSTACK_MEMORY_USE_SLAB)
+static btstack_memory_slab_t l2cap_service_slab;
+l2cap_service_t * btstack_memory_l2cap_service_get(void){
+    return (l2cap_service_t *) btstack_memory_slab_get(&l2cap_service_slab);
+}
+void btstack_memory_l2cap_service_free(l2cap_service_t *l2cap_service){
+    btstack_memory_slab_free(&l2cap_service_slab, l2cap_service);
+}
 #elif defined(HAVE_MALLOC)
 l2cap_service_t * btstack_memory_l2cap_service_get(void){
     void * buffer = malloc(sizeof(l2cap_service_t));
@@ -180,6 +203,14 @@ void btstack_memory_l2cap_channel_free(l2cap_channel_t *l2cap_channel){
     (void) l2cap_channel;
 };
 #endif
+#elif defined(BTSTACK_MEMORY_USE_SLAB)
+static btstack_memory_slab_t l2cap_channel_slab;
+l2cap_channel_t * btstack_memory_l2cap_channel_get(void){
+    return (l2cap_channel_t *) btstack_memory_slab_get(&l2cap_channel_slab);
+}
+void btstack_memory_l2cap_channel_free(l2cap_channel_t *l2cap_channel){
+    btstack_memory_slab_free(&l2cap_channel_slab, l2cap_channel);
+}
 #elif defined(HAVE_MALLOC)
 l2cap_channel_t * btstack_memory_l2cap_channel_get(void){
     void * buffer = malloc(sizeof(l2cap_channel_t));
@@ -228,6 +259,14 @@ void btstack_memory_rfcomm_multiplexer_free(rfcomm_multiplexer_t *rfcomm_multipl
     (void) rfcomm_multiplexer;
 };
 #endif
+#elif defined(BTSTACK_MEMORY_USE_SLAB)
+static btstack_memory_slab_t rfcomm_multiplexer_slab;
+rfcomm_multiplexer_t * btstack_memory_rfcomm_multiplexer_get(void){
+    return (rfcomm_multiplexer_t *) btstack_memory_slab_get(&rfcomm_multiplexer_slab);
+}
+void btstack_memory_rfcomm_multiplexer_free(rfcomm_multiplexer_t *rfcomm_multiplexer){
+    btstack_memory_slab_free(&rfcomm_multiplexer_slab, rfcomm_multiplexer);
+}
 #elif defined(HAVE_MALLOC)
 rfcomm_multiplexer_t * btstack_memory_rfcomm_multiplexer_get(void){
     void * buffer = malloc(sizeof(rfcomm_multiplexer_t));
@@ -274,6 +313,14 @@ void btstack_memory_rfcomm_service_free(rfcomm_service_t *rfcomm_service){
     (void) rfcomm_service;
 };
 #endif
+#elif defined(BTSTACK_MEMORY_USE_SLAB)
+static btstack_memory_slab_t rfcomm_service_slab;
+rfcomm_service_t * btstack_memory_rfcomm_service_get(void){
+    return (rfcomm_service_t *) btstack_memory_slab_get(&rfcomm_service_slab);
+}
+void btstack_memory_rfcomm_service_free(rfcomm_service_t *rfcomm_service){
+    btstack_memory_slab_free(&rfcomm_service_slab, rfcomm_service);
+}
 #elif defined(HAVE_MALLOC)
 rfcomm_service_t * btstack_memory_rfcomm_service_get(void){
     void * buffer = malloc(sizeof(rfcomm_service_t));
@@ -320,6 +367,14 @@ void btstack_memory_rfcomm_channel_free(rfcomm_channel_t *rfcomm_channel){
     (void) rfcomm_channel;
 };
 #endif
+#elif defined(BTSTACK_MEMORY_USE_SLAB)
+static btstack_memory_slab_t rfcomm_channel_slab;
+rfcomm_channel_t * btstack_memory_rfcomm_channel_get(void){
+    return (rfcomm_channel_t *) btstack_memory_slab_get(&rfcomm_channel_slab);
+}
+void btstack_memory_rfcomm_channel_free(rfcomm_channel_t *rfcomm_channel){
+    btstack_memory_slab_free(&rfcomm_channel_slab, rfcomm_channel);
+}
 #elif defined(HAVE_MALLOC)
 rfcomm_channel_t * btstack_memory_rfcomm_channel_get(void){
     void * buffer = malloc(sizeof(rfcomm_channel_t));
@@ -367,6 +422,14 @@ void btstack_memory_btstack_link_key_db_memory_entry_free(btstack_link_key_db_me
     (void) btstack_link_key_db_memory_entry;
 };
 #endif
+#elif defined(BTSTACK_MEMORY_USE_SLAB)
+static btstack_memory_slab_t btstack_link_key_db_memory_entry_slab;
+btstack_link_key_db_memory_entry_t * btstack_memory_btstack_link_key_db_memory_entry_get(void){
+    return (btstack_link_key_db_memory_entry_t *) btstack_memory_slab_get(&btstack_link_key_db_memory_entry_slab);
+}
+void btstack_memory_btstack_link_key_db_memory_entry_free(btstack_link_key_db_memory_entry_t *btstack_link_key_db_memory_entry){
+    btstack_memory_slab_free(&btstack_link_key_db_memory_entry_slab, btstack_link_key_db_memory_entry);
+}
 #elif defined(HAVE_MALLOC)
 btstack_link_key_db_memory_entry_t * btstack_memory_btstack_link_key_db_memory_entry_get(void){
     void * buffer = malloc(sizeof(btstack_link_key_db_memory_entry_t));
@@ -414,6 +477,14 @@ void btstack_memory_bnep_service_free(bnep_service_t *bnep_service){
     (void) bnep_service;
 };
 #endif
+#elif defined(BTSTACK_MEMORY_USE_SLAB)
+static btstack_memory_slab_t bnep_service_slab;
+bnep_service_t * btstack_memory_bnep_service_get(void){
+    return (bnep_service_t *) btstack_memory_slab_get(&bnep_service_slab);
+}
+void btstack_memory_bnep_service_free(bnep_service_t *bnep_service){
+    btstack_memory_slab_free(&bnep_service_slab, bnep_service);
+}
 #elif defined(HAVE_MALLOC)
 bnep_service_t * btstack_memory_bnep_service_get(void){
     void * buffer = malloc(sizeof(bnep_service_t));
@@ -460,6 +531,14 @@ void btstack_memory_bnep_channel_free(bnep_channel_t *bnep_channel){
     (void) bnep_channel;
 };
 #endif
+#elif defined(BTSTACK_MEMORY_USE_SLAB)
+static btstack_memory_slab_t bnep_channel_slab;
+bnep_channel_t * btstack_memory_bnep_channel_get(void){
+    return (bnep_channel_t *) btstack_memory_slab_get(&bnep_channel_slab);
+}
+void btstack_memory_bnep_channel_free(bnep_channel_t *bnep_channel){
+    btstack_memory_slab_free(&bnep_channel_slab, bnep_channel);
+}
 #elif defined(HAVE_MALLOC)
 bnep_channel_t * btstack_memory_bnep_channel_get(void){
     void * buffer = malloc(sizeof(bnep_channel_t));
@@ -507,6 +586,14 @@ void btstack_memory_hfp_connection_free(hfp_connection_t *hfp_connection){
     (void) hfp_connection;
 };
 #endif
+#elif defined(BTSTACK_MEMORY_USE_SLAB)
+static btstack_memory_slab_t hfp_connection_slab;
+hfp_connection_t * btstack_memory_hfp_connection_get(void){
+    return (hfp_connection_t *) btstack_memory_slab_get(&hfp_connection_slab);
+}
+void btstack_memory_hfp_connection_free(hfp_connection_t *hfp_connection){
+    btstack_memory_slab_free(&hfp_connection_slab, hfp_connection);
+}
 #elif defined(HAVE_MALLOC)
 hfp_connection_t * btstack_memory_hfp_connection_get(void){
     void * buffer = malloc(sizeof(hfp_connection_t));
@@ -554,6 +641,14 @@ void btstack_memory_service_record_item_free(service_record_item_t *service_reco
     (void) service_record_item;
 };
 #endif
+#elif defined(BTSTACK_MEMORY_USE_SLAB)
+static btstack_memory_slab_t service_record_item_slab;
+service_record_item_t * btstack_memory_service_record_item_get(void){
+    return (service_record_item_t *) btstack_memory_slab_get(&service_record_item_slab);
+}
+void btstack_memory_service_record_item_free(service_record_item_t *service_record_item){
+    btstack_memory_slab_free(&service_record_item_slab, service_record_item);
+}
 #elif defined(HAVE_MALLOC)
 service_record_item_t * btstack_memory_service_record_item_get(void){
     void * buffer = malloc(sizeof(service_record_item_t));
@@ -601,6 +696,14 @@ void btstack_memory_avdtp_stream_endpoint_free(avdtp_stream_endpoint_t *avdtp_st
     (void) avdtp_stream_endpoint;
 };
 #endif
+#elif defined(BTSTACK_MEMORY_USE_SLAB)
+static btstack_memory_slab_t avdtp_stream_endpoint_slab;
+avdtp_stream_endpoint_t * btstack_memory_avdtp_stream_endpoint_get(void){
+    return (avdtp_stream_endpoint_t *) btstack_memory_slab_get(&avdtp_stream_endpoint_slab);
+}
+void btstack_memory_avdtp_stream_endpoint_free(avdtp_stream_endpoint_t *avdtp_stream_endpoint){
+    btstack_memory_slab_free(&avdtp_stream_endpoint_slab, avdtp_stream_endpoint);
+}
 #elif defined(HAVE_MALLOC)
 avdtp_stream_endpoint_t * btstack_memory_avdtp_stream_endpoint_get(void){
     void * buffer = malloc(sizeof(avdtp_stream_endpoint_t));
@@ -648,6 +751,14 @@ void btstack_memory_avdtp_connection_free(avdtp_connection_t *avdtp_connection){
     (void) avdtp_connection;
 };
 #endif
+#elif defined(BTSTACK_MEMORY_USE_SLAB)
+static btstack_memory_slab_t avdtp_connection_slab;
+avdtp_connection_t * btstack_memory_avdtp_connection_get(void){
+    return (avdtp_connection_t *) btstack_memory_slab_get(&avdtp_connection_slab);
+}
+void btstack_memory_avdtp_connection_free(avdtp_connection_t *avdtp_connection){
+    btstack_memory_slab_free(&avdtp_connection_slab, avdtp_connection);
+}
 #elif defined(HAVE_MALLOC)
 avdtp_connection_t * btstack_memory_avdtp_connection_get(void){
     void * buffer = malloc(sizeof(avdtp_connection_t));
@@ -695,6 +806,14 @@ void btstack_memory_avrcp_connection_free(avrcp_connection_t *avrcp_connection){
     (void) avrcp_connection;
 };
 #endif
+#elif defined(BTSTACK_MEMORY_USE_SLAB)
+static btstack_memory_slab_t avrcp_connection_slab;
+avrcp_connection_t * btstack_memory_avrcp_connection_get(void){
+    return (avrcp_connection_t *) btstack_memory_slab_get(&avrcp_connection_slab);
+}
+void btstack_memory_avrcp_connection_free(avrcp_connection_t *avrcp_connection){
+    btstack_memory_slab_free(&avrcp_connection_slab, avrcp_connection);
+}
 #elif defined(HAVE_MALLOC)
 avrcp_connection_t * btstack_memory_avrcp_connection_get(void){
     void * buffer = malloc(sizeof(avrcp_connection_t));
@@ -742,6 +861,14 @@ void btstack_memory_avrcp_browsing_connection_free(avrcp_browsing_connection_t *
     (void) avrcp_browsing_connection;
 };
 #endif
+#elif defined(BTSTACK_MEMORY_USE_SLAB)
+static btstack_memory_slab_t avrcp_browsing_connection_slab;
+avrcp_browsing_connection_t * btstack_memory_avrcp_browsing_connection_get(void){
+    return (avrcp_browsing_connection_t *) btstack_memory_slab_get(&avrcp_browsing_connection_slab);
+}
+void btstack_memory_avrcp_browsing_connection_free(avrcp_browsing_connection_t *avrcp_browsing_connection){
+    btstack_memory_slab_free(&avrcp_browsing_connection_slab, avrcp_browsing_connection);
+}
 #elif defined(HAVE_MALLOC)
 avrcp_browsing_connection_t * btstack_memory_avrcp_browsing_connection_get(void){
     void * buffer = malloc(sizeof(avrcp_browsing_connection_t));
@@ -791,6 +918,14 @@ void btstack_memory_gatt_client_free(gatt_client_t *gatt_client){
     (void) gatt_client;
 };
 #endif
+#elif defined(BTSTACK_MEMORY_USE_SLAB)
+static btstack_memory_slab_t gatt_client_slab;
+gatt_client_t * btstack_memory_gatt_client_get(void){
+    return (gatt_client_t *) btstack_memory_slab_get(&gatt_client_slab);
+}
+void btstack_memory_gatt_client_free(gatt_client_t *gatt_client){
+    btstack_memory_slab_free(&gatt_client_slab, gatt_client);
+}
 #elif defined(HAVE_MALLOC)
 gatt_client_t * btstack_memory_gatt_client_get(void){
     void * buffer = malloc(sizeof(gatt_client_t));
@@ -837,6 +972,14 @@ void btstack_memory_whitelist_entry_free(whitelist_entry_t *whitelist_entry){
     (void) whitelist_entry;
 };
 #endif
+#elif defined(BTSTACK_MEMORY_USE_SLAB)
+static btstack_memory_slab_t whitelist_entry_slab;
+whitelist_entry_t * btstack_memory_whitelist_entry_get(void){
+    return (whitelist_entry_t *) btstack_memory_slab_get(&whitelist_entry_slab);
+}
+void btstack_memory_whitelist_entry_free(whitelist_entry_t *whitelist_entry){
+    btstack_memory_slab_free(&whitelist_entry_slab, whitelist_entry);
+}
 #elif defined(HAVE_MALLOC)
 whitelist_entry_t * btstack_memory_whitelist_entry_get(void){
     void * buffer = malloc(sizeof(whitelist_entry_t));
@@ -883,6 +1026,14 @@ void btstack_memory_sm_lookup_entry_free(sm_lookup_entry_t *sm_lookup_entry){
     (void) sm_lookup_entry;
 };
 #endif
+#elif defined(BTSTACK_MEMORY_USE_SLAB)
+static btstack_memory_slab_t sm_lookup_entry_slab;
+sm_lookup_entry_t * btstack_memory_sm_lookup_entry_get(void){
+    return (sm_lookup_entry_t *) btstack_memory_slab_get(&sm_lookup_entry_slab);
+}
+void btstack_memory_sm_lookup_entry_free(sm_lookup_entry_t *sm_lookup_entry){
+    btstack_memory_slab_free(&sm_lookup_entry_slab, sm_lookup_entry);
+}
 #elif defined(HAVE_MALLOC)
 sm_lookup_entry_t * btstack_memory_sm_lookup_entry_get(void){
     void * buffer = malloc(sizeof(sm_lookup_entry_t));
@@ -932,6 +1083,14 @@ void btstack_memory_mesh_network_pdu_free(mesh_network_pdu_t *mesh_network_pdu){
     (void) mesh_network_pdu;
 };
 #endif
+#elif defined(BTSTACK_MEMORY_USE_SLAB)
+static btstack_memory_slab_t mesh_network_pdu_slab;
+mesh_network_pdu_t * btstack_memory_mesh_network_pdu_get(void){
+    return (mesh_network_pdu_t *) btstack_memory_slab_get(&mesh_network_pdu_slab);
+}
+void btstack_memory_mesh_network_pdu_free(mesh_network_pdu_t *mesh_network_pdu){
+    btstack_memory_slab_free(&mesh_network_pdu_slab, mesh_network_pdu);
+}
 #elif defined(HAVE_MALLOC)
 mesh_network_pdu_t * btstack_memory_mesh_network_pdu_get(void){
     void * buffer = malloc(sizeof(mesh_network_pdu_t));
@@ -978,6 +1137,14 @@ void btstack_memory_mesh_segmented_pdu_free(mesh_segmented_pdu_t *mesh_segmented
     (void) mesh_segmented_pdu;
 };
 #endif
+#elif defined(BTSTACK_MEMORY_USE_SLAB)
+static btstack_memory_slab_t mesh_segmented_pdu_slab;
+mesh_segmented_pdu_t * btstack_memory_mesh_segmented_pdu_get(void){
+    return (mesh_segmented_pdu_t *) btstack_memory_slab_get(&mesh_segmented_pdu_slab);
+}
+void btstack_memory_mesh_segmented_pdu_free(mesh_segmented_pdu_t *mesh_segmented_pdu){
+    btstack_memory_slab_free(&mesh_segmented_pdu_slab, mesh_segmented_pdu);
+}
 #elif defined(HAVE_MALLOC)
 mesh_segmented_pdu_t * btstack_memory_mesh_segmented_pdu_get(void){
     void * buffer = malloc(sizeof(mesh_segmented_pdu_t));
@@ -1024,6 +1191,14 @@ void btstack_memory_mesh_upper_transport_pdu_free(mesh_upper_transport_pdu_t *me
     (void) mesh_upper_transport_pdu;
 };
 #endif
+#elif defined(BTSTACK_MEMORY_USE_SLAB)
+static btstack_memory_slab_t mesh_upper_transport_pdu_slab;
+mesh_upper_transport_pdu_t * btstack_memory_mesh_upper_transport_pdu_get(void){
+    return (mesh_upper_transport_pdu_t *) btstack_memory_slab_get(&mesh_upper_transport_pdu_slab);
+}
+void btstack_memory_mesh_upper_transport_pdu_free(mesh_upper_transport_pdu_t *mesh_upper_transport_pdu){
+    btstack_memory_slab_free(&mesh_upper_transport_pdu_slab, mesh_upper_transport_pdu);
+}
 #elif defined(HAVE_MALLOC)
 mesh_upper_transport_pdu_t * btstack_memory_mesh_upper_transport_pdu_get(void){
     void * buffer = malloc(sizeof(mesh_upper_transport_pdu_t));
@@ -1070,6 +1245,14 @@ void btstack_memory_mesh_network_key_free(mesh_network_key_t *mesh_network_key){
     (void) mesh_network_key;
 };
 #endif
+#elif defined(BTSTACK_MEMORY_USE_SLAB)
+static btstack_memory_slab_t mesh_network_key_slab;
+mesh_network_key_t * btstack_memory_mesh_network_key_get(void){
+    return (mesh_network_key_t *) btstack_memory_slab_get(&mesh_network_key_slab);
+}
+void btstack_memory_mesh_network_key_free(mesh_network_key_t *mesh_network_key){
+    btstack_memory_slab_free(&mesh_network_key_slab, mesh_network_key);
+}
 #elif defined(HAVE_MALLOC)
 mesh_network_key_t * btstack_memory_mesh_network_key_get(void){
     void * buffer = malloc(sizeof(mesh_network_key_t));
@@ -1116,6 +1299,14 @@ void btstack_memory_mesh_transport_key_free(mesh_transport_key_t *mesh_transport
     (void) mesh_transport_key;
 };
 #endif
+#elif defined(BTSTACK_MEMORY_USE_SLAB)
+static btstack_memory_slab_t mesh_transport_key_slab;
+mesh_transport_key_t * btstack_memory_mesh_transport_key_get(void){
+    return (mesh_transport_key_t *) btstack_memory_slab_get(&mesh_transport_key_slab);
+}
+void btstack_memory_mesh_transport_key_free(mesh_transport_key_t *mesh_transport_key){
+    btstack_memory_slab_free(&mesh_transport_key_slab, mesh_transport_key);
+}
 #elif defined(HAVE_MALLOC)
 mesh_transport_key_t * btstack_memory_mesh_transport_key_get(void){
     void * buffer = malloc(sizeof(mesh_transport_key_t));
@@ -1162,6 +1353,14 @@ void btstack_memory_mesh_virtual_address_free(mesh_virtual_address_t *mesh_virtu
     (void) mesh_virtual_address;
 };
 #endif
+#elif defined(BTSTACK_MEMORY_USE_SLAB)
+static btstack_memory_slab_t mesh_virtual_address_slab;
+mesh_virtual_address_t * btstack_memory_mesh_virtual_address_get(void){
+    return (mesh_virtual_address_t *) btstack_memory_slab_get(&mesh_virtual_address_slab);
+}
+void btstack_memory_mesh_virtual_address_free(mesh_virtual_address_t *mesh_virtual_address){
+    btstack_memory_slab_free(&mesh_virtual_address_slab, mesh_virtual_address);
+}
 #elif defined(HAVE_MALLOC)
 mesh_virtual_address_t * btstack_memory_mesh_virtual_address_get(void){
     void * buffer = malloc(sizeof(mesh_virtual_address_t));
@@ -1208,6 +1407,14 @@ void btstack_memory_mesh_subnet_free(mesh_subnet_t *mesh_subnet){
     (void) mesh_subnet;
 };
 #endif
+#elif defined(BTSTACK_MEMORY_USE_SLAB)
+static btstack_memory_slab_t mesh_subnet_slab;
+mesh_subnet_t * btstack_memory_mesh_subnet_get(void){
+    return (mesh_subnet_t *) btstack_memory_slab_get(&mesh_subnet_slab);
+}
+void btstack_memory_mesh_subnet_free(mesh_subnet_t *mesh_subnet){
+    btstack_memory_slab_free(&mesh_subnet_slab, mesh_subnet);
+}
 #elif defined(HAVE_MALLOC)
 mesh_subnet_t * btstack_memory_mesh_subnet_get(void){
     void * buffer = malloc(sizeof(mesh_subnet_t));
@@ -1227,83 +1434,218 @@ void btstack_memory_mesh_subnet_free(mesh_subnet_t *mesh_subnet){
 void btstack_memory_init(void){
 #if MAX_NR_HCI_CONNECTIONS > 0
     btstack_memory_pool_create(&hci_connection_pool, hci_connection_storage, MAX_NR_HCI_CONNECTIONS, sizeof(hci_connection_t));
+#elif !defined(MAX_NR_HCI_CONNECTIONS) && defined(BTSTACK_MEMORY_USE_SLAB)
+    btstack_memory_slab_create(&hci_connection_slab, "hci_connection_t", sizeof(hci_connection_t));
 #endif
 #if MAX_NR_L2CAP_SERVICES > 0
     btstack_memory_pool_create(&l2cap_service_pool, l2cap_service_storage, MAX_NR_L2CAP_SERVICES, sizeof(l2cap_service_t));
+#elif !defined(MAX_NR_L2CAP_SERVICES) && defined(BTSTACK_MEMORY_USE_SLAB)
+    btstack_memory_slab_create(&l2cap_service_slab, "l2cap_service_t", sizeof(l2cap_service_t));
 #endif
 #if MAX_NR_L2CAP_CHANNELS > 0
     btstack_memory_pool_create(&l2cap_channel_pool, l2cap_channel_storage, MAX_NR_L2CAP_CHANNELS, sizeof(l2cap_channel_t));
+#elif !defined(MAX_NR_L2CAP_CHANNELS) && defined(BTSTACK_MEMORY_USE_SLAB)
+    btstack_memory_slab_create(&l2cap_channel_slab, "l2cap_channel_t", sizeof(l2cap_channel_t));
 #endif
 #ifdef ENABLE_CLASSIC
 #if MAX_NR_RFCOMM_MULTIPLEXERS > 0
     btstack_memory_pool_create(&rfcomm_multiplexer_pool, rfcomm_multiplexer_storage, MAX_NR_RFCOMM_MULTIPLEXERS, sizeof(rfcomm_multiplexer_t));
+#elif !defined(MAX_NR_RFCOMM_MULTIPLEXERS) && defined(BTSTACK_MEMORY_USE_SLAB)
+    btstack_memory_slab_create(&rfcomm_multiplexer_slab, "rfcomm_multiplexer_t", sizeof(rfcomm_multiplexer_t));
 #endif
 #if MAX_NR_RFCOMM_SERVICES > 0
     btstack_memory_pool_create(&rfcomm_service_pool, rfcomm_service_storage, MAX_NR_RFCOMM_SERVICES, sizeof(rfcomm_service_t));
+#elif !defined(MAX_NR_RFCOMM_SERVICES) && defined(BTSTACK_MEMORY_USE_SLAB)
+    btstack_memory_slab_create(&rfcomm_service_slab, "rfcomm_service_t", sizeof(rfcomm_service_t));
 #endif
 #if MAX_NR_RFCOMM_CHANNELS > 0
     btstack_memory_pool_create(&rfcomm_channel_pool, rfcomm_channel_storage, MAX_NR_RFCOMM_CHANNELS, sizeof(rfcomm_channel_t));
+#elif !defined(MAX_NR_RFCOMM_CHANNELS) && defined(BTSTACK_MEMORY_USE_SLAB)
+    btstack_memory_slab_create(&rfcomm_channel_slab, "rfcomm_channel_t", sizeof(rfcomm_channel_t));
 #endif
 #if MAX_NR_BTSTACK_LINK_KEY_DB_MEMORY_ENTRIES > 0
     btstack_memory_pool_create(&btstack_link_key_db_memory_entry_pool, btstack_link_key_db_memory_entry_storage, MAX_NR_BTSTACK_LINK_KEY_DB_MEMORY_ENTRIES, sizeof(btstack_link_key_db_memory_entry_t));
+#elif !defined(MAX_NR_BTSTACK_LINK_KEY_DB_MEMORY_ENTRIES) && defined(BTSTACK_MEMORY_USE_SLAB)
+    btstack_memory_slab_create(&btstack_link_key_db_memory_entry_slab, "btstack_link_key_db_memory_entry_t", sizeof(btstack_link_key_db_memory_entry_t));
 #endif
 #if MAX_NR_BNEP_SERVICES > 0
     btstack_memory_pool_create(&bnep_service_pool, bnep_service_storage, MAX_NR_BNEP_SERVICES, sizeof(bnep_service_t));
+#elif !defined(MAX_NR_BNEP_SERVICES) && defined(BTSTACK_MEMORY_USE_SLAB)
+    btstack_memory_slab_create(&bnep_service_slab, "bnep_service_t", sizeof(bnep_service_t));
 #endif
 #if MAX_NR_BNEP_CHANNELS > 0
     btstack_memory_pool_create(&bnep_channel_pool, bnep_channel_storage, MAX_NR_BNEP_CHANNELS, sizeof(bnep_channel_t));
+#elif !defined(MAX_NR_BNEP_CHANNELS) && defined(BTSTACK_MEMORY_USE_SLAB)
+    btstack_memory_slab_create(&bnep_channel_slab, "bnep_channel_t", sizeof(bnep_channel_t));
 #endif
 #if MAX_NR_HFP_CONNECTIONS > 0
     btstack_memory_pool_create(&hfp_connection_pool, hfp_connection_storage, MAX_NR_HFP_CONNECTIONS, sizeof(hfp_connection_t));
+#elif !defined(MAX_NR_HFP_CONNECTIONS) && defined(BTSTACK_MEMORY_USE_SLAB)
+    btstack_memory_slab_create(&hfp_connection_slab, "hfp_connection_t", sizeof(hfp_connection_t));
 #endif
 #if MAX_NR_SERVICE_RECORD_ITEMS > 0
     btstack_memory_pool_create(&service_record_item_pool, service_record_item_storage, MAX_NR_SERVICE_RECORD_ITEMS, sizeof(service_record_item_t));
+#elif !defined(MAX_NR_SERVICE_RECORD_ITEMS) && defined(BTSTACK_MEMORY_USE_SLAB)
+    btstack_memory_slab_create(&service_record_item_slab, "service_record_item_t", sizeof(service_record_item_t));
 #endif
 #if MAX_NR_AVDTP_STREAM_ENDPOINTS > 0
     btstack_memory_pool_create(&avdtp_stream_endpoint_pool, avdtp_stream_endpoint_storage, MAX_NR_AVDTP_STREAM_ENDPOINTS, sizeof(avdtp_stream_endpoint_t));
+#elif !defined(MAX_NR_AVDTP_STREAM_ENDPOINTS) && defined(BTSTACK_MEMORY_USE_SLAB)
+    btstack_memory_slab_create(&avdtp_stream_endpoint_slab, "avdtp_stream_endpoint_t", sizeof(avdtp_stream_endpoint_t));
 #endif
 #if MAX_NR_AVDTP_CONNECTIONS > 0
     btstack_memory_pool_create(&avdtp_connection_pool, avdtp_connection_storage, MAX_NR_AVDTP_CONNECTIONS, sizeof(avdtp_connection_t));
+#elif !defined(MAX_NR_AVDTP_CONNECTIONS) && defined(BTSTACK_MEMORY_USE_SLAB)
+    btstack_memory_slab_create(&avdtp_connection_slab, "avdtp_connection_t", sizeof(avdtp_connection_t));
 #endif
 #if MAX_NR_AVRCP_CONNECTIONS > 0
     btstack_memory_pool_create(&avrcp_connection_pool, avrcp_connection_storage, MAX_NR_AVRCP_CONNECTIONS, sizeof(avrcp_connection_t));
+#elif !defined(MAX_NR_AVRCP_CONNECTIONS) && defined(BTSTACK_MEMORY_USE_SLAB)
+    btstack_memory_slab_create(&avrcp_connection_slab, "avrcp_connection_t", sizeof(avrcp_connection_t));
 #endif
 #if MAX_NR_AVRCP_BROWSING_CONNECTIONS > 0
     btstack_memory_pool_create(&avrcp_browsing_connection_pool, avrcp_browsing_connection_storage, MAX_NR_AVRCP_BROWSING_CONNECTIONS, sizeof(avrcp_browsing_connection_t));
+#elif !defined(MAX_NR_AVRCP_BROWSING_CONNECTIONS) && defined(BTSTACK_MEMORY_USE_SLAB)
+    btstack_memory_slab_create(&avrcp_browsing_connection_slab, "avrcp_browsing_connection_t", sizeof(avrcp_browsing_connection_t));
 #endif
 #endif
 #ifdef ENABLE_BLE
 #if MAX_NR_GATT_CLIENTS > 0
     btstack_memory_pool_create(&gatt_client_pool, gatt_client_storage, MAX_NR_GATT_CLIENTS, sizeof(gatt_client_t));
+#elif !defined(MAX_NR_GATT_CLIENTS) && defined(BTSTACK_MEMORY_USE_SLAB)
+    btstack_memory_slab_create(&gatt_client_slab, "gatt_client_t", sizeof(gatt_client_t));
 #endif
 #if MAX_NR_WHITELIST_ENTRIES > 0
     btstack_memory_pool_create(&whitelist_entry_pool, whitelist_entry_storage, MAX_NR_WHITELIST_ENTRIES, sizeof(whitelist_entry_t));
+#elif !defined(MAX_NR_WHITELIST_ENTRIES) && defined(BTSTACK_MEMORY_USE_SLAB)
+    btstack_memory_slab_create(&whitelist_entry_slab, "whitelist_entry_t", sizeof(whitelist_entry_t));
 #endif
 #if MAX_NR_SM_LOOKUP_ENTRIES > 0
     btstack_memory_pool_create(&sm_lookup_entry_pool, sm_lookup_entry_storage, MAX_NR_SM_LOOKUP_ENTRIES, sizeof(sm_lookup_entry_t));
+#elif !defined(MAX_NR_SM_LOOKUP_ENTRIES) && defined(BTSTACK_MEMORY_USE_SLAB)
+    btstack_memory_slab_create(&sm_lookup_entry_slab, "sm_lookup_entry_t", sizeof(sm_lookup_entry_t));
 #endif
 #endif
 #ifdef ENABLE_MESH
 #if MAX_NR_MESH_NETWORK_PDUS > 0
     btstack_memory_pool_create(&mesh_network_pdu_pool, mesh_network_pdu_storage, MAX_NR_MESH_NETWORK_PDUS, sizeof(mesh_network_pdu_t));
+#elif !defined(MAX_NR_MESH_NETWORK_PDUS) && defined(BTSTACK_MEMORY_USE_SLAB)
+    btstack_memory_slab_create(&mesh_network_pdu_slab, "mesh_network_pdu_t", sizeof(mesh_network_pdu_t));
 #endif
 #if MAX_NR_MESH_SEGMENTED_PDUS > 0
     btstack_memory_pool_create(&mesh_segmented_pdu_pool, mesh_segmented_pdu_storage, MAX_NR_MESH_SEGMENTED_PDUS, sizeof(mesh_segmented_pdu_t));
+#elif !defined(MAX_NR_MESH_SEGMENTED_PDUS) && defined(BTSTACK_MEMORY_USE_SLAB)
+    btstack_memory_slab_create(&mesh_segmented_pdu_slab, "mesh_segmented_pdu_t", sizeof(mesh_segmented_pdu_t));
 #endif
 #if MAX_NR_MESH_UPPER_TRANSPORT_PDUS > 0
     btstack_memory_pool_create(&mesh_upper_transport_pdu_pool, mesh_upper_transport_pdu_storage, MAX_NR_MESH_UPPER_TRANSPORT_PDUS, sizeof(mesh_upper_transport_pdu_t));
+#elif !defined(MAX_NR_MESH_UPPER_TRANSPORT_PDUS) && defined(BTSTACK_MEMORY_USE_SLAB)
+    btstack_memory_slab_create(&mesh_upper_transport_pdu_slab, "mesh_upper_transport_pdu_t", sizeof(mesh_upper_transport_pdu_t));
 #endif
 #if MAX_NR_MESH_NETWORK_KEYS > 0
     btstack_memory_pool_create(&mesh_network_key_pool, mesh_network_key_storage, MAX_NR_MESH_NETWORK_KEYS, sizeof(mesh_network_key_t));
+#elif !defined(MAX_NR_MESH_NETWORK_KEYS) && defined(BTSTACK_MEMORY_USE_SLAB)
+    btstack_memory_slab_create(&mesh_network_key_slab, "mesh_network_key_t", sizeof(mesh_network_key_t));
 #endif
 #if MAX_NR_MESH_TRANSPORT_KEYS > 0
     btstack_memory_pool_create(&mesh_transport_key_pool, mesh_transport_key_storage, MAX_NR_MESH_TRANSPORT_KEYS, sizeof(mesh_transport_key_t));
+#elif !defined(MAX_NR_MESH_TRANSPORT_KEYS) && defined(BTSTACK_MEMORY_USE_SLAB)
+    btstack_memory_slab_create(&mesh_transport_key_slab, "mesh_transport_key_t", sizeof(mesh_transport_key_t));
 #endif
 #if MAX_NR_MESH_VIRTUAL_ADDRESSS > 0
     btstack_memory_pool_create(&mesh_virtual_address_pool, mesh_virtual_address_storage, MAX_NR_MESH_VIRTUAL_ADDRESSS, sizeof(mesh_virtual_address_t));
+#elif !defined(MAX_NR_MESH_VIRTUAL_ADDRESSS) && defined(BTSTACK_MEMORY_USE_SLAB)
+    btstack_memory_slab_create(&mesh_virtual_address_slab, "mesh_virtual_address_t", sizeof(mesh_virtual_address_t));
 #endif
 #if MAX_NR_MESH_SUBNETS > 0
     btstack_memory_pool_create(&mesh_subnet_pool, mesh_subnet_storage, MAX_NR_MESH_SUBNETS, sizeof(mesh_subnet_t));
+#elif !defined(MAX_NR_MESH_SUBNETS) && defined(BTSTACK_MEMORY_USE_SLAB)
+    btstack_memory_slab_create(&mesh_subnet_slab, "mesh_subnet_t", sizeof(mesh_subnet_t));
+#endif
+#endif
+}
+
+// deinit
+void btstack_memory_deinit(void){
+#if !defined(MAX_NR_HCI_CONNECTIONS) && defined(BTSTACK_MEMORY_USE_SLAB)
+    btstack_memory_slab_deinit(&hci_connection_slab);
+#endif
+#if !defined(MAX_NR_L2CAP_SERVICES) && defined(BTSTACK_MEMORY_USE_SLAB)
+    btstack_memory_slab_deinit(&l2cap_service_slab);
+#endif
+#if !defined(MAX_NR_L2CAP_CHANNELS) && defined(BTSTACK_MEMORY_USE_SLAB)
+    btstack_memory_slab_deinit(&l2cap_channel_slab);
+#endif
+#ifdef ENABLE_CLASSIC
+#if !defined(MAX_NR_RFCOMM_MULTIPLEXERS) && defined(BTSTACK_MEMORY_USE_SLAB)
+    btstack_memory_slab_deinit(&rfcomm_multiplexer_slab);
+#endif
+#if !defined(MAX_NR_RFCOMM_SERVICES) && defined(BTSTACK_MEMORY_USE_SLAB)
+    btstack_memory_slab_deinit(&rfcomm_service_slab);
+#endif
+#if !defined(MAX_NR_RFCOMM_CHANNELS) && defined(BTSTACK_MEMORY_USE_SLAB)
+    btstack_memory_slab_deinit(&rfcomm_channel_slab);
+#endif
+#if !defined(MAX_NR_BTSTACK_LINK_KEY_DB_MEMORY_ENTRIES) && defined(BTSTACK_MEMORY_USE_SLAB)
+    btstack_memory_slab_deinit(&btstack_link_key_db_memory_entry_slab);
+#endif
+#if !defined(MAX_NR_BNEP_SERVICES) && defined(BTSTACK_MEMORY_USE_SLAB)
+    btstack_memory_slab_deinit(&bnep_service_slab);
+#endif
+#if !defined(MAX_NR_BNEP_CHANNELS) && defined(BTSTACK_MEMORY_USE_SLAB)
+    btstack_memory_slab_deinit(&bnep_channel_slab);
+#endif
+#if !defined(MAX_NR_HFP_CONNECTIONS) && defined(BTSTACK_MEMORY_USE_SLAB)
+    btstack_memory_slab_deinit(&hfp_connection_slab);
+#endif
+#if !defined(MAX_NR_SERVICE_RECORD_ITEMS) && defined(BTSTACK_MEMORY_USE_SLAB)
+    btstack_memory_slab_deinit(&service_record_item_slab);
+#endif
+#if !defined(MAX_NR_AVDTP_STREAM_ENDPOINTS) && defined(BTSTACK_MEMORY_USE_SLAB)
+    btstack_memory_slab_deinit(&avdtp_stream_endpoint_slab);
+#endif
+#if !defined(MAX_NR_AVDTP_CONNECTIONS) && defined(BTSTACK_MEMORY_USE_SLAB)
+    btstack_memory_slab_deinit(&avdtp_connection_slab);
+#endif
+#if !defined(MAX_NR_AVRCP_CONNECTIONS) && defined(BTSTACK_MEMORY_USE_SLAB)
+    btstack_memory_slab_deinit(&avrcp_connection_slab);
+#endif
+#if !defined(MAX_NR_AVRCP_BROWSING_CONNECTIONS) && defined(BTSTACK_MEMORY_USE_SLAB)
+    btstack_memory_slab_deinit(&avrcp_browsing_connection_slab);
+#endif
+#endif
+#ifdef ENABLE_BLE
+#if !defined(MAX_NR_GATT_CLIENTS) && defined(BTSTACK_MEMORY_USE_SLAB)
+    btstack_memory_slab_deinit(&gatt_client_slab);
+#endif
+#if !defined(MAX_NR_WHITELIST_ENTRIES) && defined(BTSTACK_MEMORY_USE_SLAB)
+    btstack_memory_slab_deinit(&whitelist_entry_slab);
+#endif
+#if !defined(MAX_NR_SM_LOOKUP_ENTRIES) && defined(BTSTACK_MEMORY_USE_SLAB)
+    btstack_memory_slab_deinit(&sm_lookup_entry_slab);
+#endif
+#endif
+#ifdef ENABLE_MESH
+#if !defined(MAX_NR_MESH_NETWORK_PDUS) && defined(BTSTACK_MEMORY_USE_SLAB)
+    btstack_memory_slab_deinit(&mesh_network_pdu_slab);
+#endif
+#if !defined(MAX_NR_MESH_SEGMENTED_PDUS) && defined(BTSTACK_MEMORY_USE_SLAB)
+    btstack_memory_slab_deinit(&mesh_segmented_pdu_slab);
+#endif
+#if !defined(MAX_NR_MESH_UPPER_TRANSPORT_PDUS) && defined(BTSTACK_MEMORY_USE_SLAB)
+    btstack_memory_slab_deinit(&mesh_upper_transport_pdu_slab);
+#endif
+#if !defined(MAX_NR_MESH_NETWORK_KEYS) && defined(BTSTACK_MEMORY_USE_SLAB)
+    btstack_memory_slab_deinit(&mesh_network_key_slab);
+#endif
+#if !defined(MAX_NR_MESH_TRANSPORT_KEYS) && defined(BTSTACK_MEMORY_USE_SLAB)
+    btstack_memory_slab_deinit(&mesh_transport_key_slab);
+#endif
+#if !defined(MAX_NR_MESH_VIRTUAL_ADDRESSS) && defined(BTSTACK_MEMORY_USE_SLAB)
+    btstack_memory_slab_deinit(&mesh_virtual_address_slab);
+#endif
+#if !defined(MAX_NR_MESH_SUBNETS) && defined(BTSTACK_MEMORY_USE_SLAB)
+    btstack_memory_slab_deinit(&mesh_subnet_slab);
 #endif
 #endif
 }
@@ -87,6 +87,11 @@ extern "C" {
  */
 void btstack_memory_init(void);
 
+/**
+ * @brief Frees slab arenas and reports objects that have not been freed, see ENABLE_BTSTACK_MEMORY_SLAB
+ */
+void btstack_memory_deinit(void);
+
 /* API_END */
 
 // hci_connection
@@ -0,0 +1,172 @@
+/*
+ * Copyright (C) 2019 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+#define BTSTACK_FILE__ "btstack_memory_slab.c"
+
+/*
+ *  btstack_memory_slab.c
+ *
+ *  Growable slab allocator
+ *
+ *  A slab starts with a list item to keep track of it, followed by the aligned objects.
+ *  Free objects are kept in a singly linked list stored in the objects themselves.
+ */
+
+#include "btstack_memory_slab.h"
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "btstack_bool.h"
+#include "btstack_debug.h"
+
+#if BTSTACK_MEMORY_SLAB_ALIGNMENT & (BTSTACK_MEMORY_SLAB_ALIGNMENT - 1)
+#error "BTSTACK_MEMORY_SLAB_ALIGNMENT must be a power of 2"
+#endif
+
+typedef struct btstack_memory_slab_node {
+    struct btstack_memory_slab_node * next;
+} btstack_memory_slab_node_t;
+
+static btstack_linked_list_t btstack_memory_slabs;
+
+static uintptr_t btstack_memory_slab_align(uintptr_t value){
+    return (value + (BTSTACK_MEMORY_SLAB_ALIGNMENT - 1u)) & ~((uintptr_t) (BTSTACK_MEMORY_SLAB_ALIGNMENT - 1u));
+}
+
+static void btstack_memory_slab_free_slabs(btstack_memory_slab_t * slab){
+    while (slab->slabs != NULL){
+        btstack_linked_item_t * item = btstack_linked_list_pop(&slab->slabs);
+        free(item);
+    }
+    slab->free_objects = NULL;
+    slab->num_objects = 0;
+    slab->num_outstanding = 0;
+}
+
+void btstack_memory_slab_create(btstack_memory_slab_t * slab, const char * name, uint32_t object_size){
+    btstack_memory_slab_free_slabs(slab);
+    slab->name = name;
+    // object needs to hold free list pointer
+    if (object_size < sizeof(btstack_memory_slab_node_t)){
+        object_size = sizeof(btstack_memory_slab_node_t);
+    }
+    slab->object_size = (uint32_t) btstack_memory_slab_align(object_size);
+    slab->num_outstanding_max = 0;
+    slab->num_allocations = 0;
+    btstack_linked_list_add_tail(&btstack_memory_slabs, &slab->item);
+}
+
+static bool btstack_memory_slab_grow(btstack_memory_slab_t * slab){
+    // header + padding for alignment + objects
+    size_t size = sizeof(btstack_linked_item_t) + (BTSTACK_MEMORY_SLAB_ALIGNMENT - 1u) + ((size_t) BTSTACK_MEMORY_SLAB_OBJECTS * slab->object_size);
+    btstack_linked_item_t * item = (btstack_linked_item_t *) malloc(size);
+    if (item == NULL){
+        log_error("%s: slab allocation failed", slab->name);
+        return false;
+    }
+    btstack_linked_list_add(&slab->slabs, item);
+
+    uint8_t * object = (uint8_t *) btstack_memory_slab_align((uintptr_t) (item + 1));
+    uint16_t i;
+    for (i = 0; i < BTSTACK_MEMORY_SLAB_OBJECTS; i++){
+        btstack_memory_slab_node_t * node = (btstack_memory_slab_node_t *) object;
+        node->next = (btstack_memory_slab_node_t *) slab->free_objects;
+        slab->free_objects = node;
+        object += slab->object_size;
+    }
+    slab->num_objects += BTSTACK_MEMORY_SLAB_OBJECTS;
+    log_debug("%s: new slab, %u objects", slab->name, (unsigned int) slab->num_objects);
+    return true;
+}
+
+void * btstack_memory_slab_get(btstack_memory_slab_t * slab){
+    if (slab->free_objects == NULL){
+        if (!btstack_memory_slab_grow(slab)) return NULL;
+    }
+    btstack_memory_slab_node_t * node = (btstack_memory_slab_node_t *) slab->free_objects;
+    slab->free_objects = node->next;
+
+    slab->num_allocations++;
+    slab->num_outstanding++;
+    if (slab->num_outstanding > slab->num_outstanding_max){
+        slab->num_outstanding_max = slab->num_outstanding;
+    }
+
+    memset(node, 0, slab->object_size);
+    return node;
+}
+
+void btstack_memory_slab_free(btstack_memory_slab_t * slab, void * object){
+    btstack_assert(slab->num_outstanding > 0u);
+    slab->num_outstanding--;
+
+    btstack_memory_slab_node_t * node = (btstack_memory_slab_node_t *) object;
+    node->next = (btstack_memory_slab_node_t *) slab->free_objects;
+    slab->free_objects = node;
+}
+
+uint32_t btstack_memory_slab_deinit(btstack_memory_slab_t * slab){
+    uint32_t num_leaked = slab->num_outstanding;
+    if (num_leaked > 0u){
+        log_error("%s: %u of %u objects not freed", slab->name, (unsigned int) num_leaked, (unsigned int) slab->num_allocations);
+    }
+    btstack_memory_slab_free_slabs(slab);
+    btstack_linked_list_remove(&btstack_memory_slabs, &slab->item);
+    return num_leaked;
+}
+
+void btstack_memory_slab_for_each(void (*handler)(const btstack_memory_slab_t * slab, void * context), void * context){
+    btstack_linked_list_iterator_t it;
+    btstack_linked_list_iterator_init(&it, &btstack_memory_slabs);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        const btstack_memory_slab_t * slab = (const btstack_memory_slab_t *) btstack_linked_list_iterator_next(&it);
+        (*handler)(slab, context);
+    }
+}
+
+static void btstack_memory_slab_dump_slab(const btstack_memory_slab_t * slab, void * context){
+    UNUSED(context);
+    log_info("%s: size %u, capacity %u, outstanding %u, max %u, allocations %u", slab->name,
+             (unsigned int) slab->object_size, (unsigned int) slab->num_objects, (unsigned int) slab->num_outstanding,
+             (unsigned int) slab->num_outstanding_max, (unsigned int) slab->num_allocations);
+}
+
+void btstack_memory_slab_dump(void){
+    btstack_memory_slab_for_each(&btstack_memory_slab_dump_slab, NULL);
+}
@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) 2019 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+/*
+ *  btstack_memory_slab.h
+ *
+ *  @brief Growable slab allocator for objects of a single type
+ *
+ *  Objects are taken from slabs of BTSTACK_MEMORY_SLAB_OBJECTS objects each, which are allocated
+ *  with malloc on demand and kept until btstack_memory_slab_deinit. Objects start on a
+ *  BTSTACK_MEMORY_SLAB_ALIGNMENT boundary, freed objects are kept in a free list for reuse.
+ *
+ *  Outstanding objects, high water mark and number of allocations are tracked per type.
+ *  Objects that have not been freed are reported by btstack_memory_slab_deinit.
+ *
+ *  @note not thread-safe, all objects must be allocated and freed on the run loop thread
+ */
+
+#ifndef BTSTACK_MEMORY_SLAB_H
+#define BTSTACK_MEMORY_SLAB_H
+
+#include <stdint.h>
+
+#include "btstack_config.h"
+#include "btstack_linked_list.h"
+
+#if defined __cplusplus
+extern "C" {
+#endif
+
+#ifndef BTSTACK_MEMORY_SLAB_ALIGNMENT
+#define BTSTACK_MEMORY_SLAB_ALIGNMENT 64
+#endif
+
+#ifndef BTSTACK_MEMORY_SLAB_OBJECTS
+#define BTSTACK_MEMORY_SLAB_OBJECTS 8
+#endif
+
+typedef struct {
+    // in list of all slab allocators
+    btstack_linked_item_t item;
+    // type name for statistics and leak report
+    const char *          name;
+    // size of object rounded up to alignment
+    uint32_t              object_size;
+    // allocated slabs
+    btstack_linked_list_t slabs;
+    // singly linked list of free objects
+    void *                free_objects;
+    // statistics
+    uint32_t              num_objects;
+    uint32_t              num_outstanding;
+    uint32_t              num_outstanding_max;
+    uint32_t              num_allocations;
+} btstack_memory_slab_t;
+
+/* API_START */
+
+/**
+ * @brief Setup slab allocator, slabs from previous use are freed. Slab needs to be zero-initialized before first use
+ * @param slab
+ * @param name of type, e.g. "hci_connection_t"
+ * @param object_size
+ */
+void btstack_memory_slab_create(btstack_memory_slab_t * slab, const char * name, uint32_t object_size);
+
+/**
+ * @brief Get object initialized with 0, allocates new slab if no free object is available
+ * @param slab
+ * @return object or NULL if malloc failed
+ */
+void * btstack_memory_slab_get(btstack_memory_slab_t * slab);
+
+/**
+ * @brief Return object to slab allocator
+ * @param slab
+ * @param object
+ */
+void btstack_memory_slab_free(btstack_memory_slab_t * slab, void * object);
+
+/**
+ * @brief Report objects that have not been freed and free all slabs
+ * @param slab
+ * @return number of objects that have not been freed
+ */
+uint32_t btstack_memory_slab_deinit(btstack_memory_slab_t * slab);
+
+/**
+ * @brief Call handler for all slab allocators, e.g. to collect statistics
+ * @param handler
+ * @param context
+ */
+void btstack_memory_slab_for_each(void (*handler)(const btstack_memory_slab_t * slab, void * context), void * context);
+
+/**
+ * @brief Log statistics of all slab allocators
+ */
+void btstack_memory_slab_dump(void);
+
+/* API_END */
+
+#if defined __cplusplus
+}
+#endif
+
+#endif // BTSTACK_MEMORY_SLAB_H
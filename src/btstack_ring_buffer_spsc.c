@@ -0,0 +1,163 @@
+/*
+ * Copyright (C) 2019 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+#define BTSTACK_FILE__ "btstack_ring_buffer_spsc.c"
+
+/*
+ *  btstack_ring_buffer_spsc.c
+ *
+ *  Read and write index run freely and are only masked on access, so a full buffer
+ *  (write_index - read_index == size) can be distinguished from an empty one without a flag.
+ */
+
+#include <string.h>
+
+#include "btstack_ring_buffer_spsc.h"
+#include "btstack_util.h"
+
+#define ERROR_CODE_MEMORY_CAPACITY_EXCEEDED 0x07
+
+#ifdef BTSTACK_RING_BUFFER_SPSC_C11_ATOMICS
+#define INDEX_LOAD_RELAXED(index)         atomic_load_explicit(&(index), memory_order_relaxed)
+#define INDEX_LOAD_ACQUIRE(index)         atomic_load_explicit(&(index), memory_order_acquire)
+#define INDEX_STORE_RELEASE(index, value) atomic_store_explicit(&(index), (value), memory_order_release)
+#else
+#define INDEX_LOAD_RELAXED(index)         __atomic_load_n(&(index), __ATOMIC_RELAXED)
+#define INDEX_LOAD_ACQUIRE(index)         __atomic_load_n(&(index), __ATOMIC_ACQUIRE)
+#define INDEX_STORE_RELEASE(index, value) __atomic_store_n(&(index), (value), __ATOMIC_RELEASE)
+#endif
+
+void btstack_ring_buffer_spsc_init(btstack_ring_buffer_spsc_t * ring_buffer, uint8_t * storage, uint32_t storage_size){
+    // keep highest bit only
+    while ((storage_size & (storage_size - 1u)) != 0u){
+        storage_size &= storage_size - 1u;
+    }
+    ring_buffer->storage = storage;
+    ring_buffer->size = storage_size;
+    ring_buffer->mask = (storage_size == 0u) ? 0u : (storage_size - 1u);
+    btstack_ring_buffer_spsc_reset(ring_buffer);
+}
+
+void btstack_ring_buffer_spsc_reset(btstack_ring_buffer_spsc_t * ring_buffer){
+    ring_buffer->read_index_cached  = 0;
+    ring_buffer->write_index_cached = 0;
+    INDEX_STORE_RELEASE(ring_buffer->write_index, 0u);
+    INDEX_STORE_RELEASE(ring_buffer->read_index,  0u);
+}
+
+uint32_t btstack_ring_buffer_spsc_bytes_available(btstack_ring_buffer_spsc_t * ring_buffer){
+    uint32_t read_index = INDEX_LOAD_RELAXED(ring_buffer->read_index);
+    ring_buffer->write_index_cached = INDEX_LOAD_ACQUIRE(ring_buffer->write_index);
+    return ring_buffer->write_index_cached - read_index;
+}
+
+uint32_t btstack_ring_buffer_spsc_bytes_free(btstack_ring_buffer_spsc_t * ring_buffer){
+    uint32_t write_index = INDEX_LOAD_RELAXED(ring_buffer->write_index);
+    ring_buffer->read_index_cached = INDEX_LOAD_ACQUIRE(ring_buffer->read_index);
+    return ring_buffer->size - (write_index - ring_buffer->read_index_cached);
+}
+
+uint8_t * btstack_ring_buffer_spsc_write_acquire(btstack_ring_buffer_spsc_t * ring_buffer, uint32_t * span_len){
+    uint32_t write_index = INDEX_LOAD_RELAXED(ring_buffer->write_index);
+    uint32_t offset = write_index & ring_buffer->mask;
+    uint32_t bytes_until_end = ring_buffer->size - offset;
+    uint32_t bytes_free = ring_buffer->size - (write_index - ring_buffer->read_index_cached);
+    // only touch the consumer's cache line if the last seen read index limits the span
+    if (bytes_free < bytes_until_end){
+        bytes_free = btstack_ring_buffer_spsc_bytes_free(ring_buffer);
+    }
+    *span_len = btstack_min(bytes_free, bytes_until_end);
+    return &ring_buffer->storage[offset];
+}
+
+void btstack_ring_buffer_spsc_write_commit(btstack_ring_buffer_spsc_t * ring_buffer, uint32_t len){
+    uint32_t write_index = INDEX_LOAD_RELAXED(ring_buffer->write_index);
+    INDEX_STORE_RELEASE(ring_buffer->write_index, write_index + len);
+}
+
+const uint8_t * btstack_ring_buffer_spsc_read_acquire(btstack_ring_buffer_spsc_t * ring_buffer, uint32_t * span_len){
+    uint32_t read_index = INDEX_LOAD_RELAXED(ring_buffer->read_index);
+    uint32_t offset = read_index & ring_buffer->mask;
+    uint32_t bytes_until_end = ring_buffer->size - offset;
+    uint32_t bytes_available = ring_buffer->write_index_cached - read_index;
+    // only touch the producer's cache line if the last seen write index limits the span
+    if (bytes_available < bytes_until_end){
+        bytes_available = btstack_ring_buffer_spsc_bytes_available(ring_buffer);
+    }
+    *span_len = btstack_min(bytes_available, bytes_until_end);
+    return &ring_buffer->storage[offset];
+}
+
+void btstack_ring_buffer_spsc_read_commit(btstack_ring_buffer_spsc_t * ring_buffer, uint32_t len){
+    uint32_t read_index = INDEX_LOAD_RELAXED(ring_buffer->read_index);
+    INDEX_STORE_RELEASE(ring_buffer->read_index, read_index + len);
+}
+
+int btstack_ring_buffer_spsc_write(btstack_ring_buffer_spsc_t * ring_buffer, const uint8_t * data, uint32_t data_length){
+    if (btstack_ring_buffer_spsc_bytes_free(ring_buffer) < data_length){
+        return ERROR_CODE_MEMORY_CAPACITY_EXCEEDED;
+    }
+
+    // copy first chunk up to end of storage, second chunk to start of storage
+    uint32_t write_index = INDEX_LOAD_RELAXED(ring_buffer->write_index);
+    uint32_t offset = write_index & ring_buffer->mask;
+    uint32_t bytes_to_copy = btstack_min(ring_buffer->size - offset, data_length);
+    (void)memcpy(&ring_buffer->storage[offset], data, bytes_to_copy);
+    if (bytes_to_copy < data_length){
+        (void)memcpy(&ring_buffer->storage[0], &data[bytes_to_copy], data_length - bytes_to_copy);
+    }
+
+    INDEX_STORE_RELEASE(ring_buffer->write_index, write_index + data_length);
+    return 0;
+}
+
+void btstack_ring_buffer_spsc_read(btstack_ring_buffer_spsc_t * ring_buffer, uint8_t * data, uint32_t data_length, uint32_t * number_of_bytes_read){
+    // limit data to get and report
+    data_length = btstack_min(data_length, btstack_ring_buffer_spsc_bytes_available(ring_buffer));
+    *number_of_bytes_read = data_length;
+
+    // copy first chunk up to end of storage, second chunk from start of storage
+    uint32_t read_index = INDEX_LOAD_RELAXED(ring_buffer->read_index);
+    uint32_t offset = read_index & ring_buffer->mask;
+    uint32_t bytes_to_copy = btstack_min(ring_buffer->size - offset, data_length);
+    (void)memcpy(data, &ring_buffer->storage[offset], bytes_to_copy);
+    if (bytes_to_copy < data_length){
+        (void)memcpy(&data[bytes_to_copy], &ring_buffer->storage[0], data_length - bytes_to_copy);
+    }
+
+    INDEX_STORE_RELEASE(ring_buffer->read_index, read_index + data_length);
+}
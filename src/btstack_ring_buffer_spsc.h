@@ -0,0 +1,175 @@
+/*
+ * Copyright (C) 2019 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+/*
+ *  btstack_ring_buffer_spsc.h
+ *
+ *  Lock-free ring buffer for a single producer and a single consumer, e.g. an audio callback
+ *  running on a different thread than the BTstack run loop.
+ *
+ *  The producer acquires a contiguous span of free space, fills it in place, and commits it.
+ *  The consumer acquires a contiguous span of stored data, processes it in place, and commits it.
+ *  Only the producer updates the write index and only the consumer updates the read index, both
+ *  are accessed with C11 atomics (or the equivalent GCC/Clang builtins if C11 atomics are not
+ *  available) and are kept on separate cache lines.
+ *
+ *  The usable size is the largest power of two not larger than the provided storage.
+ */
+
+#ifndef BTSTACK_RING_BUFFER_SPSC_H
+#define BTSTACK_RING_BUFFER_SPSC_H
+
+#include <stdint.h>
+
+#if !defined(__cplusplus) && defined(__STDC_VERSION__) && (__STDC_VERSION__ >= 201112L) && !defined(__STDC_NO_ATOMICS__)
+#include <stdatomic.h>
+#define BTSTACK_RING_BUFFER_SPSC_C11_ATOMICS
+typedef _Atomic uint32_t btstack_ring_buffer_spsc_index_t;
+#elif defined(__GNUC__) || defined(__clang__)
+typedef uint32_t btstack_ring_buffer_spsc_index_t;
+#else
+#error "btstack_ring_buffer_spsc requires C11 atomics or GCC/Clang __atomic builtins"
+#endif
+
+#if defined __cplusplus
+extern "C" {
+#endif
+
+// at least 32 bytes
+#ifndef BTSTACK_RING_BUFFER_SPSC_CACHE_LINE_SIZE
+#define BTSTACK_RING_BUFFER_SPSC_CACHE_LINE_SIZE 64
+#endif
+
+typedef struct btstack_ring_buffer_spsc {
+    // set by init
+    uint8_t  * storage;
+    uint32_t size;
+    uint32_t mask;
+    uint8_t  padding_config[BTSTACK_RING_BUFFER_SPSC_CACHE_LINE_SIZE - sizeof(uint8_t *) - (2 * sizeof(uint32_t))];
+
+    // producer: free running write index and last seen read index
+    btstack_ring_buffer_spsc_index_t write_index;
+    uint32_t read_index_cached;
+    uint8_t  padding_producer[BTSTACK_RING_BUFFER_SPSC_CACHE_LINE_SIZE - (2 * sizeof(uint32_t))];
+
+    // consumer: free running read index and last seen write index
+    btstack_ring_buffer_spsc_index_t read_index;
+    uint32_t write_index_cached;
+    uint8_t  padding_consumer[BTSTACK_RING_BUFFER_SPSC_CACHE_LINE_SIZE - (2 * sizeof(uint32_t))];
+} btstack_ring_buffer_spsc_t;
+
+/**
+ * Init ring buffer
+ * @param ring_buffer object
+ * @param storage
+ * @param storage_size in bytes, only the largest power of two <= storage_size is used
+ */
+void btstack_ring_buffer_spsc_init(btstack_ring_buffer_spsc_t * ring_buffer, uint8_t * storage, uint32_t storage_size);
+
+/**
+ * Reset ring buffer to initial state (empty). Neither producer nor consumer may be active
+ * @param ring_buffer object
+ */
+void btstack_ring_buffer_spsc_reset(btstack_ring_buffer_spsc_t * ring_buffer);
+
+/**
+ * Get number of bytes available for read, safe to call from consumer
+ * @param ring_buffer object
+ * @return number of bytes available for read
+ */
+uint32_t btstack_ring_buffer_spsc_bytes_available(btstack_ring_buffer_spsc_t * ring_buffer);
+
+/**
+ * Get free space available for write, safe to call from producer
+ * @param ring_buffer object
+ * @return number of bytes available for write
+ */
+uint32_t btstack_ring_buffer_spsc_bytes_free(btstack_ring_buffer_spsc_t * ring_buffer);
+
+/**
+ * Producer: get contiguous free space starting at the write position
+ * @param ring_buffer object
+ * @param span_len number of bytes that can be written to returned span, 0 if full
+ * @return span
+ */
+uint8_t * btstack_ring_buffer_spsc_write_acquire(btstack_ring_buffer_spsc_t * ring_buffer, uint32_t * span_len);
+
+/**
+ * Producer: make bytes written to the acquired span available to the consumer
+ * @param ring_buffer object
+ * @param len <= span_len of last write_acquire
+ */
+void btstack_ring_buffer_spsc_write_commit(btstack_ring_buffer_spsc_t * ring_buffer, uint32_t len);
+
+/**
+ * Consumer: get contiguous data starting at the read position
+ * @param ring_buffer object
+ * @param span_len number of bytes that can be read from returned span, 0 if empty
+ * @return span
+ */
+const uint8_t * btstack_ring_buffer_spsc_read_acquire(btstack_ring_buffer_spsc_t * ring_buffer, uint32_t * span_len);
+
+/**
+ * Consumer: release bytes of the acquired span to the producer
+ * @param ring_buffer object
+ * @param len <= span_len of last read_acquire
+ */
+void btstack_ring_buffer_spsc_read_commit(btstack_ring_buffer_spsc_t * ring_buffer, uint32_t len);
+
+/**
+ * Producer: copy bytes into ring buffer
+ * @param ring_buffer object
+ * @param data to store
+ * @param data_length
+ * @return 0 if ok, ERROR_CODE_MEMORY_CAPACITY_EXCEEDED if not enough space in buffer
+ */
+int btstack_ring_buffer_spsc_write(btstack_ring_buffer_spsc_t * ring_buffer, const uint8_t * data, uint32_t data_length);
+
+/**
+ * Consumer: copy bytes from ring buffer
+ * @param ring_buffer object
+ * @param buffer to store read data
+ * @param length to read
+ * @param number_of_bytes_read
+ */
+void btstack_ring_buffer_spsc_read(btstack_ring_buffer_spsc_t * ring_buffer, uint8_t * buffer, uint32_t length, uint32_t * number_of_bytes_read);
+
+#if defined __cplusplus
+}
+#endif
+
+#endif // BTSTACK_RING_BUFFER_SPSC_H
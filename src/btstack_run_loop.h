@@ -47,6 +47,7 @@
 #include "btstack_config.h"
 
 #include "btstack_bool.h"
+#include "btstack_defines.h"
 #include "btstack_linked_list.h"
 
 #include <stdint.h>
@@ -106,6 +107,7 @@ typedef struct btstack_run_loop {
 	void (*execute)(void);
 	void (*dump_timer)(void);
 	uint32_t (*get_time_ms)(void);
+	void (*execute_on_main_thread)(btstack_context_callback_registration_t * callback_registration);
 } btstack_run_loop_t;
 
 void btstack_run_loop_timer_dump(void);
@@ -220,6 +222,15 @@ int btstack_run_loop_remove_data_source(btstack_data_source_t * data_source);
  */
 void btstack_run_loop_execute(void);
 
+/**
+ * @brief Execute callback on run loop thread. Can be used to control BTstack from a different thread.
+ * The callback is queued and executed with all other pending callbacks in the next run loop iteration.
+ * @note The callback registration is owned by the caller and must not be modified or queued again before its callback was executed
+ * @note Supported by the POSIX and FreeRTOS run loops from any thread and by the embedded run loop also from ISRs
+ * @param callback_registration
+ */
+void btstack_run_loop_execute_on_main_thread(btstack_context_callback_registration_t * callback_registration);
+
 /* API_END */
 
 #if defined __cplusplus
@@ -45,6 +45,7 @@
 
 #include "btstack_debug.h"
 #include "btstack_config.h"
+#include "btstack_stats.h"
 #include "btstack_util.h"
 
 #include "btstack_run_loop_base.h"
@@ -102,6 +103,7 @@ void btstack_run_loop_base_process_timers(uint32_t now){
         int32_t delta = btstack_time_delta(ts->timeout, now);
         if (delta > 0) break;
         btstack_run_loop_base_remove_timer(ts);
+        BTSTACK_STATS_TIMER_PROCESSED((uint32_t) -delta);
         ts->process(ts);
     }
 }
@@ -44,11 +44,16 @@
 
 #include "btstack_slip.h"
 #include "btstack_debug.h"
+#include "btstack_util.h"
+
+#include <string.h>
 
 typedef enum {
 	SLIP_ENCODER_DEFAULT,
 	SLIP_ENCODER_SEND_DC,
-	SLIP_ENCODER_SEND_DD
+	SLIP_ENCODER_SEND_DD,
+	SLIP_ENCODER_SEND_DE,
+	SLIP_ENCODER_SEND_DF
 } btstack_slip_encoder_state_t;
 
 // h5 slip state machine
@@ -65,6 +70,7 @@ typedef enum {
 static btstack_slip_encoder_state_t encoder_state;
 static const uint8_t * encoder_data;
 static uint16_t  encoder_len;
+static int       encoder_oof_flow_control;
 
 // decoder 
 static btstack_slip_decoder_state_t decoder_state;
@@ -86,6 +92,14 @@ void btstack_slip_encoder_start(const uint8_t * data, uint16_t len){
 	encoder_len   = len;
 }
 
+/**
+ * @brief Escape XON/XOFF for out-of-frame software flow control
+ * @param enabled
+ */
+void btstack_slip_encoder_set_oof_flow_control(int enabled){
+	encoder_oof_flow_control = enabled;
+}
+
 /**
  * @brief Check if encoder has data ready
  * @return True if data ready
@@ -112,6 +126,14 @@ uint8_t btstack_slip_encoder_get_byte(void){
 				case 0xdb:
 					encoder_state = SLIP_ENCODER_SEND_DD;
 					return 0xdb;
+				case BTSTACK_SLIP_XON:
+					if (!encoder_oof_flow_control) break;
+					encoder_state = SLIP_ENCODER_SEND_DE;
+					return 0xdb;
+				case BTSTACK_SLIP_XOFF:
+					if (!encoder_oof_flow_control) break;
+					encoder_state = SLIP_ENCODER_SEND_DF;
+					return 0xdb;
 				default:
                     break;
 			}
@@ -122,12 +144,63 @@ uint8_t btstack_slip_encoder_get_byte(void){
 		case SLIP_ENCODER_SEND_DD:
 			encoder_state = SLIP_ENCODER_DEFAULT;
 			return 0x0dd;
+		case SLIP_ENCODER_SEND_DE:
+			encoder_state = SLIP_ENCODER_DEFAULT;
+			return 0x0de;
+		case SLIP_ENCODER_SEND_DF:
+			encoder_state = SLIP_ENCODER_DEFAULT;
+			return 0x0df;
         default:
             log_error("btstack_slip_encoder_get_byte invalid state %x", encoder_state);
             return 0x00;
 	}
 }
 
+// length of run at start of data that can be sent without escaping
+static uint16_t btstack_slip_encoder_run_length(const uint8_t * data, uint16_t len){
+	const uint8_t * end = data + len;
+	const uint8_t * special;
+	special = (const uint8_t *) memchr(data, BTSTACK_SLIP_SOF, end - data);
+	if (special != NULL) end = special;
+	special = (const uint8_t *) memchr(data, 0xdb, end - data);
+	if (special != NULL) end = special;
+	if (encoder_oof_flow_control){
+		special = (const uint8_t *) memchr(data, BTSTACK_SLIP_XON, end - data);
+		if (special != NULL) end = special;
+		special = (const uint8_t *) memchr(data, BTSTACK_SLIP_XOFF, end - data);
+		if (special != NULL) end = special;
+	}
+	return (uint16_t) (end - data);
+}
+
+/**
+ * @brief Get next bytes from encoder
+ * @param buffer to store encoded data
+ * @param max_len of buffer
+ * @return number of bytes stored in buffer
+ */
+uint16_t btstack_slip_encoder_get_bytes(uint8_t * buffer, uint16_t max_len){
+	uint16_t pos = 0;
+	while (pos < max_len){
+		if (encoder_state != SLIP_ENCODER_DEFAULT){
+			buffer[pos++] = btstack_slip_encoder_get_byte();
+			continue;
+		}
+		if (encoder_len == 0u) break;
+		uint16_t bytes_to_copy = btstack_min(encoder_len, max_len - pos);
+		uint16_t run_len = btstack_slip_encoder_run_length(encoder_data, bytes_to_copy);
+		(void)memcpy(&buffer[pos], encoder_data, run_len);
+		pos          += run_len;
+		encoder_data += run_len;
+		encoder_len  -= run_len;
+		if (run_len < bytes_to_copy){
+			// next byte needs to be escaped
+			buffer[pos++] = btstack_slip_encoder_get_byte();
+		}
+	}
+	return pos;
+}
+
 // Decoder
 
 static void btstack_slip_decoder_reset(void){
@@ -193,6 +266,15 @@ void btstack_slip_decoder_process(uint8_t input){
                     btstack_slip_decoder_store_byte(0xdb);
                     decoder_state = SLIP_DECODER_ACTIVE;
                     break;
+                // only used with out-of-frame software flow control
+                case 0xde:
+                    btstack_slip_decoder_store_byte(BTSTACK_SLIP_XON);
+                    decoder_state = SLIP_DECODER_ACTIVE;
+                    break;
+                case 0xdf:
+                    btstack_slip_decoder_store_byte(BTSTACK_SLIP_XOFF);
+                    decoder_state = SLIP_DECODER_ACTIVE;
+                    break;
                 default:
                     btstack_slip_decoder_reset();
                     break;
@@ -231,3 +313,48 @@ uint16_t btstack_slip_decoder_frame_size(void){
 			return 0;
 	}
 }
+
+/**
+ * @brief Get number of bytes decoded for current frame
+ * @return number of bytes, 0 if not inside a frame
+ */
+uint16_t btstack_slip_decoder_bytes_decoded(void){
+	switch (decoder_state){
+		case SLIP_DECODER_UNKNOWN:
+			return 0;
+		default:
+			return decoder_pos;
+	}
+}
+
+/**
+ * @brief Process block of received bytes, stops after a complete frame
+ * @param data
+ * @param len
+ * @return number of bytes processed
+ */
+uint16_t btstack_slip_decoder_process_block(const uint8_t * data, uint16_t len){
+	uint16_t pos = 0;
+	while (pos < len){
+		if (decoder_state == SLIP_DECODER_COMPLETE) break;
+		if (decoder_state == SLIP_DECODER_ACTIVE){
+			// store run of regular bytes up to next SOF or escape
+			const uint8_t * start = &data[pos];
+			const uint8_t * end   = &data[len];
+			const uint8_t * special;
+			special = (const uint8_t *) memchr(start, BTSTACK_SLIP_SOF, end - start);
+			if (special != NULL) end = special;
+			special = (const uint8_t *) memchr(start, 0xdb, end - start);
+			if (special != NULL) end = special;
+			uint16_t run_len = (uint16_t) (end - start);
+			if ((decoder_pos + run_len) <= decoder_max_size){
+				(void)memcpy(&decoder_buffer[decoder_pos], start, run_len);
+				decoder_pos += run_len;
+				pos         += run_len;
+				if (pos == len) break;
+			}
+		}
+		btstack_slip_decoder_process(data[pos++]);
+	}
+	return pos;
+}
@@ -51,6 +51,10 @@ extern "C" {
 
 #define BTSTACK_SLIP_SOF 0xc0
 
+// out-of-frame software flow control
+#define BTSTACK_SLIP_XON  0x11
+#define BTSTACK_SLIP_XOFF 0x13
+
 // ENCODER
 
 /**
@@ -60,6 +64,12 @@ extern "C" {
  */
 void btstack_slip_encoder_start(const uint8_t * data, uint16_t len);
 
+/**
+ * @brief Escape XON/XOFF for out-of-frame software flow control
+ * @param enabled
+ */
+void btstack_slip_encoder_set_oof_flow_control(int enabled);
+
 /**
  * @brief Check if encoder has data ready
  * @return True if data ready
@@ -72,6 +82,14 @@ int  btstack_slip_encoder_has_data(void);
  */
 uint8_t btstack_slip_encoder_get_byte(void);
 
+/**
+ * @brief Get next bytes from encoder. Runs without special characters are copied as a block
+ * @param buffer to store encoded data
+ * @param max_len of buffer
+ * @return number of bytes stored in buffer
+ */
+uint16_t btstack_slip_encoder_get_bytes(uint8_t * buffer, uint16_t max_len);
+
 // DECODER
 
 /**
@@ -95,6 +113,22 @@ void btstack_slip_decoder_process(uint8_t input);
 
 uint16_t btstack_slip_decoder_frame_size(void);
 
+/**
+ * @brief Get number of bytes decoded for current frame
+ * @return number of bytes, 0 if not inside a frame
+ */
+uint16_t btstack_slip_decoder_bytes_decoded(void);
+
+/**
+ * @brief Process block of received bytes, stops after a complete frame
+ * @note call btstack_slip_decoder_frame_size to check for complete frame and
+ *       call again with remaining bytes after frame has been handled and decoder re-initialised
+ * @param data
+ * @param len
+ * @return number of bytes processed
+ */
+uint16_t btstack_slip_decoder_process_block(const uint8_t * data, uint16_t len);
+
 #if defined __cplusplus
 }
 #endif
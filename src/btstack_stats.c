@@ -0,0 +1,300 @@
+/*
+ * Copyright (C) 2019 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+#define BTSTACK_FILE__ "btstack_stats.c"
+
+/*
+ *  btstack_stats.c
+ */
+
+#include "btstack_stats.h"
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "btstack_bool.h"
+#include "btstack_run_loop.h"
+#include "btstack_util.h"
+
+typedef struct {
+    const char * name;
+    const char * help;
+} btstack_stats_counter_info_t;
+
+static const btstack_stats_counter_info_t btstack_stats_counter_info[BTSTACK_STATS_COUNTER_NUM] = {
+    { "btstack_hci_commands_sent_total",            "HCI Commands sent to Controller" },
+    { "btstack_hci_events_received_total",          "HCI Events received from Controller" },
+    { "btstack_hci_acl_credit_stalls_total",        "ACL packets not sent as all Controller buffers were in use" },
+    { "btstack_hci_packet_buffer_contention_total", "Outgoing HCI packet buffer requested while already reserved" },
+    { "btstack_crypto_operations_total",            "Crypto operations queued" },
+    { "btstack_run_loop_iterations_total",          "Run loop iterations" },
+    { "btstack_run_loop_timers_total",              "Run loop timers processed" },
+};
+
+static const char * btstack_stats_trace_point_names[] = {
+    "HCI ACL",
+    "L2CAP",
+    "L2CAP Channel",
+    "L2CAP Fixed Channel",
+    "RFCOMM Channel",
+};
+
+static btstack_stats_t       btstack_stats;
+static btstack_linked_list_t btstack_stats_sources;
+static uint32_t           (* btstack_stats_get_time_us)(void);
+
+static btstack_stats_trace_entry_t btstack_stats_trace_entries[BTSTACK_STATS_TRACE_SIZE];
+static uint16_t                    btstack_stats_trace_head;
+static uint16_t                    btstack_stats_trace_count;
+
+// output writer, keeps buffer '\0' terminated and drops output that does not fit
+typedef struct {
+    char *   buffer;
+    uint32_t size;
+    uint32_t pos;
+} btstack_stats_writer_t;
+
+static void btstack_stats_writer_init(btstack_stats_writer_t * writer, char * buffer, uint32_t size){
+    writer->buffer = buffer;
+    writer->size = size;
+    writer->pos = 0;
+    if (size > 0u){
+        buffer[0] = '\0';
+    }
+}
+
+static void btstack_stats_writer_printf(btstack_stats_writer_t * writer, const char * format, ...){
+    if ((writer->pos + 1u) >= writer->size) return;
+    uint32_t space = writer->size - writer->pos;
+    va_list argptr;
+    va_start(argptr, format);
+    int len = vsnprintf(&writer->buffer[writer->pos], space, format, argptr);
+    va_end(argptr);
+    if (len < 0) return;
+    if ((uint32_t) len >= space){
+        // truncated
+        writer->pos = writer->size - 1u;
+    } else {
+        writer->pos += (uint32_t) len;
+    }
+}
+
+void btstack_stats_reset(void){
+    memset(&btstack_stats, 0, sizeof(btstack_stats));
+}
+
+const btstack_stats_t * btstack_stats_get(void){
+    return &btstack_stats;
+}
+
+void btstack_stats_add_source(btstack_stats_source_t * source){
+    btstack_linked_list_add_tail(&btstack_stats_sources, (btstack_linked_item_t *) source);
+}
+
+void btstack_stats_remove_source(btstack_stats_source_t * source){
+    btstack_linked_list_remove(&btstack_stats_sources, (btstack_linked_item_t *) source);
+}
+
+void btstack_stats_for_each_traffic(btstack_stats_traffic_handler_t handler, void * context){
+    btstack_linked_list_iterator_t it;
+    btstack_linked_list_iterator_init(&it, &btstack_stats_sources);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        btstack_stats_source_t * source = (btstack_stats_source_t *) btstack_linked_list_iterator_next(&it);
+        (*source->for_each_traffic)(handler, context);
+    }
+}
+
+void btstack_stats_set_time_source(uint32_t (*get_time_us)(void)){
+    btstack_stats_get_time_us = get_time_us;
+}
+
+// counters
+
+void btstack_stats_increment(btstack_stats_counter_t counter){
+    btstack_stats.counters[counter]++;
+}
+
+void btstack_stats_traffic_in(btstack_stats_traffic_t * traffic, uint16_t size){
+    traffic->packets_in++;
+    traffic->bytes_in += size;
+}
+
+void btstack_stats_traffic_out(btstack_stats_traffic_t * traffic, uint16_t size){
+    traffic->packets_out++;
+    traffic->bytes_out += size;
+}
+
+void btstack_stats_hci_acl_in(uint16_t size){
+    btstack_stats_traffic_in(&btstack_stats.hci_acl, size);
+}
+
+void btstack_stats_hci_acl_out(uint16_t size){
+    btstack_stats_traffic_out(&btstack_stats.hci_acl, size);
+}
+
+void btstack_stats_crypto_queue_depth(uint16_t depth){
+    btstack_stats.crypto_queue_depth = depth;
+    btstack_stats.crypto_queue_depth_max = (uint16_t) btstack_max(btstack_stats.crypto_queue_depth_max, depth);
+}
+
+void btstack_stats_timer_processed(uint32_t latency_ms){
+    btstack_stats.counters[BTSTACK_STATS_RUN_LOOP_TIMERS]++;
+    btstack_stats.run_loop_timer_latency_sum_ms += latency_ms;
+    btstack_stats.run_loop_timer_latency_max_ms = btstack_max(btstack_stats.run_loop_timer_latency_max_ms, latency_ms);
+}
+
+// trace
+
+void btstack_stats_trace(btstack_stats_trace_point_t point, uint16_t id, uint8_t begin){
+    uint32_t timestamp_us;
+    if (btstack_stats_get_time_us != NULL){
+        timestamp_us = (*btstack_stats_get_time_us)();
+    } else {
+        timestamp_us = btstack_run_loop_get_time_ms() * 1000u;
+    }
+    uint16_t index = (btstack_stats_trace_head + btstack_stats_trace_count) % BTSTACK_STATS_TRACE_SIZE;
+    if (btstack_stats_trace_count < BTSTACK_STATS_TRACE_SIZE){
+        btstack_stats_trace_count++;
+    } else {
+        // overwrite oldest entry
+        btstack_stats_trace_head = (btstack_stats_trace_head + 1u) % BTSTACK_STATS_TRACE_SIZE;
+    }
+    btstack_stats_trace_entry_t * entry = &btstack_stats_trace_entries[index];
+    entry->timestamp_us = timestamp_us;
+    entry->id = id;
+    entry->point = (uint8_t) point;
+    entry->begin = begin;
+}
+
+uint16_t btstack_stats_trace_get_num_entries(void){
+    return btstack_stats_trace_count;
+}
+
+const btstack_stats_trace_entry_t * btstack_stats_trace_get_entry(uint16_t index){
+    if (index >= btstack_stats_trace_count) return NULL;
+    return &btstack_stats_trace_entries[(btstack_stats_trace_head + index) % BTSTACK_STATS_TRACE_SIZE];
+}
+
+void btstack_stats_trace_clear(void){
+    btstack_stats_trace_head = 0;
+    btstack_stats_trace_count = 0;
+}
+
+// export
+
+static void btstack_stats_export_metric_header(btstack_stats_writer_t * writer, const char * name, const char * type, const char * help){
+    btstack_stats_writer_printf(writer, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+}
+
+static void btstack_stats_export_value(btstack_stats_writer_t * writer, const char * name, const char * type, const char * help, uint32_t value){
+    btstack_stats_export_metric_header(writer, name, type, help);
+    btstack_stats_writer_printf(writer, "%s %u\n", name, (unsigned int) value);
+}
+
+typedef struct {
+    btstack_stats_writer_t * writer;
+    const char * name;
+    // offset of counter in btstack_stats_traffic_t
+    uint16_t offset;
+} btstack_stats_traffic_export_t;
+
+static void btstack_stats_export_traffic_handler(void * context, const char * source, uint16_t id, const btstack_stats_traffic_t * traffic){
+    const btstack_stats_traffic_export_t * export_context = (const btstack_stats_traffic_export_t *) context;
+    uint32_t value;
+    (void)memcpy(&value, ((const uint8_t *) traffic) + export_context->offset, sizeof(value));
+    btstack_stats_writer_printf(export_context->writer, "%s{source=\"%s\",id=\"%u\"} %u\n", export_context->name, source, id, (unsigned int) value);
+}
+
+static void btstack_stats_export_traffic(btstack_stats_writer_t * writer, const char * name, const char * help, uint16_t offset, uint32_t hci_acl_value){
+    btstack_stats_export_metric_header(writer, name, "counter", help);
+    btstack_stats_writer_printf(writer, "%s{source=\"hci_acl\",id=\"0\"} %u\n", name, (unsigned int) hci_acl_value);
+    btstack_stats_traffic_export_t export_context;
+    export_context.writer = writer;
+    export_context.name = name;
+    export_context.offset = offset;
+    btstack_stats_for_each_traffic(&btstack_stats_export_traffic_handler, &export_context);
+}
+
+uint32_t btstack_stats_export_prometheus(char * buffer, uint32_t size){
+    btstack_stats_writer_t writer;
+    btstack_stats_writer_init(&writer, buffer, size);
+
+    uint16_t i;
+    for (i = 0; i < (uint16_t) BTSTACK_STATS_COUNTER_NUM; i++){
+        btstack_stats_export_value(&writer, btstack_stats_counter_info[i].name, "counter", btstack_stats_counter_info[i].help, btstack_stats.counters[i]);
+    }
+    btstack_stats_export_value(&writer, "btstack_crypto_queue_depth",     "gauge",   "Pending crypto operations",                 btstack_stats.crypto_queue_depth);
+    btstack_stats_export_value(&writer, "btstack_crypto_queue_depth_max", "gauge",   "Maximal number of pending crypto operations", btstack_stats.crypto_queue_depth_max);
+    btstack_stats_export_value(&writer, "btstack_run_loop_timer_latency_ms_sum", "counter", "Sum of timer processing delays",    btstack_stats.run_loop_timer_latency_sum_ms);
+    btstack_stats_export_value(&writer, "btstack_run_loop_timer_latency_ms_max", "gauge",   "Maximal timer processing delay",    btstack_stats.run_loop_timer_latency_max_ms);
+
+    // HCI ACL in total and per HCI connection, L2CAP channel and RFCOMM channel
+    btstack_stats_export_traffic(&writer, "btstack_packets_in_total",  "Packets received", offsetof(btstack_stats_traffic_t, packets_in),  btstack_stats.hci_acl.packets_in);
+    btstack_stats_export_traffic(&writer, "btstack_bytes_in_total",    "Bytes received",   offsetof(btstack_stats_traffic_t, bytes_in),    btstack_stats.hci_acl.bytes_in);
+    btstack_stats_export_traffic(&writer, "btstack_packets_out_total", "Packets sent",     offsetof(btstack_stats_traffic_t, packets_out), btstack_stats.hci_acl.packets_out);
+    btstack_stats_export_traffic(&writer, "btstack_bytes_out_total",   "Bytes sent",       offsetof(btstack_stats_traffic_t, bytes_out),   btstack_stats.hci_acl.bytes_out);
+
+    return writer.pos;
+}
+
+uint32_t btstack_stats_export_chrome_trace(char * buffer, uint32_t size){
+    btstack_stats_writer_t writer;
+    btstack_stats_writer_init(&writer, buffer, size);
+
+    btstack_stats_writer_printf(&writer, "{\"traceEvents\":[");
+    // skip end entries without begin, e.g. if begin was overwritten
+    uint16_t depth = 0;
+    bool first = true;
+    uint16_t i;
+    for (i = 0; i < btstack_stats_trace_count; i++){
+        const btstack_stats_trace_entry_t * entry = btstack_stats_trace_get_entry(i);
+        if (entry->begin != 0u){
+            depth++;
+        } else {
+            if (depth == 0u) continue;
+            depth--;
+        }
+        btstack_stats_writer_printf(&writer, "%s\n{\"name\":\"%s\",\"cat\":\"btstack\",\"ph\":\"%c\",\"ts\":%u,\"pid\":1,\"tid\":1,\"args\":{\"id\":%u}}",
+                                    first ? "" : ",", btstack_stats_trace_point_names[entry->point], (entry->begin != 0u) ? 'B' : 'E',
+                                    (unsigned int) entry->timestamp_us, entry->id);
+        first = false;
+    }
+    btstack_stats_writer_printf(&writer, "\n],\"displayTimeUnit\":\"ms\"}\n");
+    return writer.pos;
+}
@@ -0,0 +1,252 @@
+/*
+ * Copyright (C) 2019 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+/*
+ *  btstack_stats.h
+ *
+ *  Counters and timestamps for the hot paths of the stack
+ *
+ *  Enabled with ENABLE_BTSTACK_STATS. Without it, all BTSTACK_STATS_* macros used by the stack
+ *  compile to nothing. Global counters cover HCI traffic, ACL credit stalls, contention for the
+ *  outgoing HCI packet buffer, the crypto queue, and the run loop. HCI connections, L2CAP channels
+ *  and RFCOMM channels count their own traffic and are reported via registered sources.
+ *
+ *  With ENABLE_BTSTACK_STATS_TRACE, entry and exit of the HCI ACL, L2CAP and channel packet
+ *  handlers are recorded in a ring buffer of BTSTACK_STATS_TRACE_SIZE entries.
+ *
+ *  Counters can be exported as Prometheus text, the trace as Chrome Trace Event JSON.
+ */
+
+#ifndef BTSTACK_STATS_H
+#define BTSTACK_STATS_H
+
+#include <stdint.h>
+
+#include "btstack_config.h"
+#include "btstack_linked_list.h"
+
+#if defined __cplusplus
+extern "C" {
+#endif
+
+#ifndef BTSTACK_STATS_TRACE_SIZE
+#define BTSTACK_STATS_TRACE_SIZE 256
+#endif
+
+/* API_START */
+
+typedef enum {
+    BTSTACK_STATS_HCI_COMMANDS_SENT = 0,
+    BTSTACK_STATS_HCI_EVENTS_RECEIVED,
+    // ACL packet could not be sent as all Controller buffers were in use, counted once until buffers are available again
+    BTSTACK_STATS_HCI_ACL_CREDIT_STALLS,
+    // outgoing HCI packet buffer was requested while already reserved, counted once until buffer is released
+    BTSTACK_STATS_HCI_PACKET_BUFFER_CONTENTION,
+    BTSTACK_STATS_CRYPTO_OPERATIONS,
+    BTSTACK_STATS_RUN_LOOP_ITERATIONS,
+    BTSTACK_STATS_RUN_LOOP_TIMERS,
+    BTSTACK_STATS_COUNTER_NUM
+} btstack_stats_counter_t;
+
+typedef struct {
+    uint32_t packets_in;
+    uint32_t bytes_in;
+    uint32_t packets_out;
+    uint32_t bytes_out;
+} btstack_stats_traffic_t;
+
+typedef struct {
+    uint32_t counters[BTSTACK_STATS_COUNTER_NUM];
+    // ACL packets from and to Controller
+    btstack_stats_traffic_t hci_acl;
+    // pending operations in btstack_crypto
+    uint16_t crypto_queue_depth;
+    uint16_t crypto_queue_depth_max;
+    // time between timer timeout and its processing
+    uint32_t run_loop_timer_latency_sum_ms;
+    uint32_t run_loop_timer_latency_max_ms;
+} btstack_stats_t;
+
+typedef enum {
+    // id = con handle
+    BTSTACK_STATS_TRACE_HCI_ACL = 0,
+    // id = con handle
+    BTSTACK_STATS_TRACE_L2CAP,
+    // id = local cid
+    BTSTACK_STATS_TRACE_L2CAP_CHANNEL,
+    // id = fixed channel id
+    BTSTACK_STATS_TRACE_L2CAP_FIXED_CHANNEL,
+    // id = rfcomm cid
+    BTSTACK_STATS_TRACE_RFCOMM_CHANNEL,
+} btstack_stats_trace_point_t;
+
+typedef struct {
+    uint32_t timestamp_us;
+    uint16_t id;
+    uint8_t  point;
+    uint8_t  begin;
+} btstack_stats_trace_entry_t;
+
+/**
+ * @brief Callback for traffic counters of a single object
+ * @param context
+ * @param source e.g. "hci_connection"
+ * @param id e.g. con handle
+ * @param traffic
+ */
+typedef void (*btstack_stats_traffic_handler_t)(void * context, const char * source, uint16_t id, const btstack_stats_traffic_t * traffic);
+
+typedef struct {
+    btstack_linked_item_t item;
+    // calls handler for each object that counts its traffic
+    void (*for_each_traffic)(btstack_stats_traffic_handler_t handler, void * context);
+} btstack_stats_source_t;
+
+/**
+ * @brief Reset all counters, trace and per-object counters are not affected
+ */
+void btstack_stats_reset(void);
+
+/**
+ * @brief Get global counters
+ * @return stats
+ */
+const btstack_stats_t * btstack_stats_get(void);
+
+/**
+ * @brief Register source of per-object traffic counters
+ * @param source
+ */
+void btstack_stats_add_source(btstack_stats_source_t * source);
+
+/**
+ * @brief Unregister source of per-object traffic counters
+ * @param source
+ */
+void btstack_stats_remove_source(btstack_stats_source_t * source);
+
+/**
+ * @brief Iterate over traffic counters of all objects of all registered sources
+ * @param handler
+ * @param context
+ */
+void btstack_stats_for_each_traffic(btstack_stats_traffic_handler_t handler, void * context);
+
+/**
+ * @brief Set time source for trace timestamps. Default: btstack_run_loop_get_time_ms() * 1000
+ * @param get_time_us
+ */
+void btstack_stats_set_time_source(uint32_t (*get_time_us)(void));
+
+/**
+ * @brief Get number of trace entries, at most BTSTACK_STATS_TRACE_SIZE
+ * @return num entries
+ */
+uint16_t btstack_stats_trace_get_num_entries(void);
+
+/**
+ * @brief Get trace entry, oldest first
+ * @param index
+ * @return entry or NULL if index is invalid
+ */
+const btstack_stats_trace_entry_t * btstack_stats_trace_get_entry(uint16_t index);
+
+/**
+ * @brief Clear trace
+ */
+void btstack_stats_trace_clear(void);
+
+/**
+ * @brief Export counters in Prometheus text exposition format
+ * @param buffer
+ * @param size of buffer, output is truncated and always '\0' terminated
+ * @return length of output without '\0'
+ */
+uint32_t btstack_stats_export_prometheus(char * buffer, uint32_t size);
+
+/**
+ * @brief Export trace in Chrome Trace Event JSON format, e.g. for chrome://tracing or Perfetto
+ * @param buffer
+ * @param size of buffer, output is truncated and always '\0' terminated
+ * @return length of output without '\0'
+ */
+uint32_t btstack_stats_export_chrome_trace(char * buffer, uint32_t size);
+
+/* API_END */
+
+// internal use by stack via BTSTACK_STATS_* macros
+
+void btstack_stats_increment(btstack_stats_counter_t counter);
+void btstack_stats_traffic_in(btstack_stats_traffic_t * traffic, uint16_t size);
+void btstack_stats_traffic_out(btstack_stats_traffic_t * traffic, uint16_t size);
+void btstack_stats_hci_acl_in(uint16_t size);
+void btstack_stats_hci_acl_out(uint16_t size);
+void btstack_stats_crypto_queue_depth(uint16_t depth);
+void btstack_stats_timer_processed(uint32_t latency_ms);
+void btstack_stats_trace(btstack_stats_trace_point_t point, uint16_t id, uint8_t begin);
+
+#ifdef ENABLE_BTSTACK_STATS
+#define BTSTACK_STATS_INCREMENT(counter)          btstack_stats_increment(BTSTACK_STATS_##counter)
+#define BTSTACK_STATS_TRAFFIC_IN(traffic, size)   btstack_stats_traffic_in(traffic, size)
+#define BTSTACK_STATS_TRAFFIC_OUT(traffic, size)  btstack_stats_traffic_out(traffic, size)
+#define BTSTACK_STATS_HCI_ACL_IN(size)            btstack_stats_hci_acl_in(size)
+#define BTSTACK_STATS_HCI_ACL_OUT(size)           btstack_stats_hci_acl_out(size)
+#define BTSTACK_STATS_CRYPTO_QUEUE_DEPTH(depth)   btstack_stats_crypto_queue_depth(depth)
+#define BTSTACK_STATS_TIMER_PROCESSED(latency_ms) btstack_stats_timer_processed(latency_ms)
+#else
+#define BTSTACK_STATS_INCREMENT(counter)          (void)(0)
+#define BTSTACK_STATS_TRAFFIC_IN(traffic, size)   (void)(0)
+#define BTSTACK_STATS_TRAFFIC_OUT(traffic, size)  (void)(0)
+#define BTSTACK_STATS_HCI_ACL_IN(size)            (void)(0)
+#define BTSTACK_STATS_HCI_ACL_OUT(size)           (void)(0)
+#define BTSTACK_STATS_CRYPTO_QUEUE_DEPTH(depth)   (void)(0)
+#define BTSTACK_STATS_TIMER_PROCESSED(latency_ms) (void)(0)
+#endif
+
+#if defined(ENABLE_BTSTACK_STATS) && defined(ENABLE_BTSTACK_STATS_TRACE)
+#define BTSTACK_STATS_TRACE_BEGIN(point, id)      btstack_stats_trace(BTSTACK_STATS_TRACE_##point, id, 1)
+#define BTSTACK_STATS_TRACE_END(point, id)        btstack_stats_trace(BTSTACK_STATS_TRACE_##point, id, 0)
+#else
+#define BTSTACK_STATS_TRACE_BEGIN(point, id)      (void)(0)
+#define BTSTACK_STATS_TRACE_END(point, id)        (void)(0)
+#endif
+
+#if defined __cplusplus
+}
+#endif
+
+#endif // BTSTACK_STATS_H
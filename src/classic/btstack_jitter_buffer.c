@@ -0,0 +1,374 @@
+/*
+ * Copyright (C) 2019 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+#define BTSTACK_FILE__ "btstack_jitter_buffer.c"
+
+/*
+ *  btstack_jitter_buffer.c
+ */
+
+#include <string.h>
+
+#include "btstack_jitter_buffer.h"
+
+#define ERROR_CODE_MEMORY_CAPACITY_EXCEEDED 0x07
+
+// sequence numbers further away are considered a new stream
+#define RESYNC_DISTANCE            1000
+
+#define TARGET_LATENCY_MIN_MS_DEFAULT  40
+#define TARGET_LATENCY_MAX_MS_DEFAULT 300
+
+// target latency = packet duration + TARGET_JITTER_MULTIPLIER * jitter
+#define TARGET_JITTER_MULTIPLIER      3
+
+// drift is the slope of the min transit time over the last BTSTACK_JITTER_BUFFER_DRIFT_WINDOWS windows
+#define DRIFT_WINDOW_MS             5000
+#define DRIFT_MAX_PPM               1000
+
+// max compensation for deviation from target latency (0x100 = 0.4 %)
+#define LEVEL_COMPENSATION_MAX     0x100
+
+static uint32_t btstack_jitter_buffer_samples_to_ms(btstack_jitter_buffer_t * jitter_buffer, uint32_t num_samples){
+    return (uint32_t) (((uint64_t) num_samples * 1000u) / jitter_buffer->sample_rate);
+}
+
+static uint32_t btstack_jitter_buffer_ms_to_samples(btstack_jitter_buffer_t * jitter_buffer, uint32_t time_ms){
+    return (uint32_t) (((uint64_t) time_ms * jitter_buffer->sample_rate) / 1000u);
+}
+
+static void btstack_jitter_buffer_update_latency(btstack_jitter_buffer_t * jitter_buffer){
+    btstack_jitter_buffer_statistics_t * statistics = &jitter_buffer->statistics;
+    statistics->latency_ms = btstack_jitter_buffer_samples_to_ms(jitter_buffer, jitter_buffer->buffered_samples);
+    if (statistics->latency_ms > statistics->latency_max_ms){
+        statistics->latency_max_ms = statistics->latency_ms;
+    }
+}
+
+static void btstack_jitter_buffer_free_slot(btstack_jitter_buffer_t * jitter_buffer, btstack_jitter_buffer_slot_t * slot){
+    jitter_buffer->buffered_samples -= (uint32_t) slot->num_frames * slot->samples_per_frame;
+    jitter_buffer->num_packets--;
+    slot->in_use = 0;
+}
+
+// @param distance from next_sequence_number, less than num_slots
+static uint16_t btstack_jitter_buffer_slot_index(btstack_jitter_buffer_t * jitter_buffer, uint16_t distance){
+    uint32_t slot_index = (uint32_t) jitter_buffer->next_slot_index + distance;
+    if (slot_index >= jitter_buffer->num_slots){
+        slot_index -= jitter_buffer->num_slots;
+    }
+    return (uint16_t) slot_index;
+}
+
+static void btstack_jitter_buffer_advance(btstack_jitter_buffer_t * jitter_buffer){
+    jitter_buffer->next_sequence_number++;
+    jitter_buffer->next_slot_index = btstack_jitter_buffer_slot_index(jitter_buffer, 1);
+}
+
+static void btstack_jitter_buffer_flush(btstack_jitter_buffer_t * jitter_buffer){
+    uint16_t i;
+    for (i = 0; i < jitter_buffer->num_slots; i++){
+        jitter_buffer->slots[i].in_use = 0;
+    }
+    jitter_buffer->next_slot_index = 0;
+    jitter_buffer->num_packets = 0;
+    jitter_buffer->buffered_samples = 0;
+    jitter_buffer->state = BTSTACK_JITTER_BUFFER_STATE_BUFFERING;
+}
+
+static void btstack_jitter_buffer_reset_estimates(btstack_jitter_buffer_t * jitter_buffer){
+    jitter_buffer->have_last_arrival = 0;
+    jitter_buffer->jitter_samples_q4 = 0;
+    jitter_buffer->have_drift_reference = 0;
+    jitter_buffer->num_windows = 0;
+    jitter_buffer->target_samples = jitter_buffer->target_min_samples;
+    jitter_buffer->statistics.jitter_us = 0;
+    jitter_buffer->statistics.drift_ppm = 0;
+    jitter_buffer->statistics.target_latency_ms = btstack_jitter_buffer_samples_to_ms(jitter_buffer, jitter_buffer->target_samples);
+}
+
+void btstack_jitter_buffer_init(btstack_jitter_buffer_t * jitter_buffer, btstack_jitter_buffer_slot_t * slots, uint8_t * payload_storage,
+                                uint16_t num_slots, uint16_t max_payload_len, uint32_t sample_rate){
+    memset(jitter_buffer, 0, sizeof(btstack_jitter_buffer_t));
+    jitter_buffer->slots = slots;
+    jitter_buffer->payload_storage = payload_storage;
+    jitter_buffer->num_slots = num_slots;
+    jitter_buffer->max_payload_len = max_payload_len;
+    jitter_buffer->sample_rate = sample_rate;
+    btstack_jitter_buffer_set_target_latency_range(jitter_buffer, TARGET_LATENCY_MIN_MS_DEFAULT, TARGET_LATENCY_MAX_MS_DEFAULT);
+    btstack_jitter_buffer_reset(jitter_buffer);
+}
+
+void btstack_jitter_buffer_set_target_latency_range(btstack_jitter_buffer_t * jitter_buffer, uint16_t min_ms, uint16_t max_ms){
+    jitter_buffer->target_min_samples = btstack_jitter_buffer_ms_to_samples(jitter_buffer, min_ms);
+    jitter_buffer->target_max_samples = btstack_jitter_buffer_ms_to_samples(jitter_buffer, max_ms);
+    if (jitter_buffer->target_max_samples < jitter_buffer->target_min_samples){
+        jitter_buffer->target_max_samples = jitter_buffer->target_min_samples;
+    }
+    if (jitter_buffer->target_samples < jitter_buffer->target_min_samples){
+        jitter_buffer->target_samples = jitter_buffer->target_min_samples;
+    }
+    if (jitter_buffer->target_samples > jitter_buffer->target_max_samples){
+        jitter_buffer->target_samples = jitter_buffer->target_max_samples;
+    }
+}
+
+void btstack_jitter_buffer_reset(btstack_jitter_buffer_t * jitter_buffer){
+    btstack_jitter_buffer_flush(jitter_buffer);
+    btstack_jitter_buffer_reset_estimates(jitter_buffer);
+    jitter_buffer->have_sequence_number = 0;
+    jitter_buffer->statistics.latency_ms = 0;
+}
+
+// RFC 3550 inter-arrival jitter, but follow increases faster than decreases
+static void btstack_jitter_buffer_update_jitter(btstack_jitter_buffer_t * jitter_buffer, uint32_t timestamp, uint32_t arrival_time_ms){
+    if (jitter_buffer->have_last_arrival != 0u){
+        uint32_t arrival_samples = btstack_jitter_buffer_ms_to_samples(jitter_buffer, arrival_time_ms - jitter_buffer->last_arrival_time_ms);
+        int32_t  deviation = (int32_t) arrival_samples - (int32_t) (timestamp - jitter_buffer->last_timestamp);
+        uint32_t deviation_q4 = ((deviation < 0) ? (uint32_t) -deviation : (uint32_t) deviation) << 4;
+        if (deviation_q4 > jitter_buffer->jitter_samples_q4){
+            jitter_buffer->jitter_samples_q4 += (deviation_q4 - jitter_buffer->jitter_samples_q4) / 2u;
+        } else {
+            jitter_buffer->jitter_samples_q4 -= (jitter_buffer->jitter_samples_q4 - deviation_q4) / 16u;
+        }
+    }
+    jitter_buffer->have_last_arrival = 1;
+    jitter_buffer->last_arrival_time_ms = arrival_time_ms;
+    jitter_buffer->last_timestamp = timestamp;
+    jitter_buffer->statistics.jitter_us = (uint32_t) (((uint64_t) (jitter_buffer->jitter_samples_q4 >> 4) * 1000000u) / jitter_buffer->sample_rate);
+}
+
+static void btstack_jitter_buffer_update_target(btstack_jitter_buffer_t * jitter_buffer, uint32_t samples_per_packet){
+    uint32_t target = samples_per_packet + (TARGET_JITTER_MULTIPLIER * (jitter_buffer->jitter_samples_q4 >> 4));
+    // keep half of the slots for bursts
+    uint32_t capacity = (jitter_buffer->num_slots / 2u) * samples_per_packet;
+    if (target > jitter_buffer->target_max_samples){
+        target = jitter_buffer->target_max_samples;
+    }
+    if (target > capacity){
+        target = capacity;
+    }
+    if (target < jitter_buffer->target_min_samples){
+        target = jitter_buffer->target_min_samples;
+    }
+    jitter_buffer->target_samples = target;
+    jitter_buffer->statistics.target_latency_ms = btstack_jitter_buffer_samples_to_ms(jitter_buffer, target);
+}
+
+// packets that were not delayed have the min transit time, its slope over time is the clock drift
+static void btstack_jitter_buffer_update_drift(btstack_jitter_buffer_t * jitter_buffer, uint32_t timestamp, uint32_t arrival_time_ms){
+    if (jitter_buffer->have_drift_reference == 0u){
+        jitter_buffer->have_drift_reference = 1;
+        jitter_buffer->drift_reference_arrival_time_ms = arrival_time_ms;
+        jitter_buffer->drift_reference_timestamp = timestamp;
+        jitter_buffer->window_start_timestamp = timestamp;
+        jitter_buffer->window_min_transit = 0;
+        return;
+    }
+
+    uint32_t arrival_samples = btstack_jitter_buffer_ms_to_samples(jitter_buffer, arrival_time_ms - jitter_buffer->drift_reference_arrival_time_ms);
+    int32_t transit = (int32_t) (arrival_samples - (timestamp - jitter_buffer->drift_reference_timestamp));
+    if (transit < jitter_buffer->window_min_transit){
+        jitter_buffer->window_min_transit = transit;
+    }
+
+    int32_t window_samples = (int32_t) (timestamp - jitter_buffer->window_start_timestamp);
+    if (window_samples < (int32_t) btstack_jitter_buffer_ms_to_samples(jitter_buffer, DRIFT_WINDOW_MS)) return;
+
+    // store completed window
+    uint8_t i;
+    if (jitter_buffer->num_windows == BTSTACK_JITTER_BUFFER_DRIFT_WINDOWS){
+        for (i = 1; i < BTSTACK_JITTER_BUFFER_DRIFT_WINDOWS; i++){
+            jitter_buffer->windows_min_transit[i-1]     = jitter_buffer->windows_min_transit[i];
+            jitter_buffer->windows_start_timestamp[i-1] = jitter_buffer->windows_start_timestamp[i];
+        }
+        jitter_buffer->num_windows--;
+    }
+    jitter_buffer->windows_min_transit[jitter_buffer->num_windows]     = jitter_buffer->window_min_transit;
+    jitter_buffer->windows_start_timestamp[jitter_buffer->num_windows] = jitter_buffer->window_start_timestamp;
+    jitter_buffer->num_windows++;
+
+    // slope between oldest and newest window, transit decreases if sender is faster
+    if (jitter_buffer->num_windows >= 2u){
+        uint8_t newest = (uint8_t) (jitter_buffer->num_windows - 1u);
+        int64_t transit_delta = (int64_t) jitter_buffer->windows_min_transit[0] - jitter_buffer->windows_min_transit[newest];
+        uint32_t span = jitter_buffer->windows_start_timestamp[newest] - jitter_buffer->windows_start_timestamp[0];
+        int64_t drift_ppm = (transit_delta * 1000000) / (int64_t) span;
+        if (drift_ppm >  DRIFT_MAX_PPM) drift_ppm =  DRIFT_MAX_PPM;
+        if (drift_ppm < -DRIFT_MAX_PPM) drift_ppm = -DRIFT_MAX_PPM;
+        jitter_buffer->statistics.drift_ppm = (int32_t) drift_ppm;
+    }
+
+    // start next window with this packet as reference, keeps transit values small
+    for (i = 0; i < jitter_buffer->num_windows; i++){
+        jitter_buffer->windows_min_transit[i] -= transit;
+    }
+    jitter_buffer->drift_reference_arrival_time_ms = arrival_time_ms;
+    jitter_buffer->drift_reference_timestamp = timestamp;
+    jitter_buffer->window_start_timestamp = timestamp;
+    jitter_buffer->window_min_transit = 0;
+}
+
+int btstack_jitter_buffer_add_packet(btstack_jitter_buffer_t * jitter_buffer, uint16_t sequence_number, uint32_t timestamp, uint32_t arrival_time_ms,
+                                     const uint8_t * payload, uint16_t payload_len, uint8_t num_frames, uint16_t num_samples){
+    if (payload_len > jitter_buffer->max_payload_len){
+        return ERROR_CODE_MEMORY_CAPACITY_EXCEEDED;
+    }
+    if (num_frames == 0u) return 0;
+
+    btstack_jitter_buffer_statistics_t * statistics = &jitter_buffer->statistics;
+    statistics->packets_received++;
+
+    if (jitter_buffer->have_sequence_number == 0u){
+        jitter_buffer->have_sequence_number = 1;
+        jitter_buffer->next_sequence_number = sequence_number;
+    }
+
+    int16_t distance = (int16_t) (sequence_number - jitter_buffer->next_sequence_number);
+    if ((distance >= RESYNC_DISTANCE) || (distance <= -RESYNC_DISTANCE)){
+        // new stream
+        statistics->resyncs++;
+        btstack_jitter_buffer_flush(jitter_buffer);
+        btstack_jitter_buffer_reset_estimates(jitter_buffer);
+        jitter_buffer->next_sequence_number = sequence_number;
+        distance = 0;
+    }
+
+    if ((distance >= 0) && (distance < (int16_t) jitter_buffer->num_slots)){
+        btstack_jitter_buffer_slot_t * slot = &jitter_buffer->slots[btstack_jitter_buffer_slot_index(jitter_buffer, (uint16_t) distance)];
+        if ((slot->in_use != 0u) && (slot->sequence_number == sequence_number)){
+            statistics->packets_duplicate++;
+            return 0;
+        }
+    }
+
+    // late packets still tell about the network
+    btstack_jitter_buffer_update_jitter(jitter_buffer, timestamp, arrival_time_ms);
+    btstack_jitter_buffer_update_target(jitter_buffer, num_samples);
+    btstack_jitter_buffer_update_drift(jitter_buffer, timestamp, arrival_time_ms);
+
+    if (distance < 0){
+        statistics->packets_late++;
+        return 0;
+    }
+
+    // make room by dropping oldest packets
+    while (distance >= (int16_t) jitter_buffer->num_slots){
+        btstack_jitter_buffer_slot_t * oldest = &jitter_buffer->slots[jitter_buffer->next_slot_index];
+        if (oldest->in_use != 0u){
+            statistics->packets_dropped_overflow++;
+            btstack_jitter_buffer_free_slot(jitter_buffer, oldest);
+        }
+        btstack_jitter_buffer_advance(jitter_buffer);
+        distance--;
+    }
+
+    // store
+    uint16_t slot_index = btstack_jitter_buffer_slot_index(jitter_buffer, (uint16_t) distance);
+    btstack_jitter_buffer_slot_t * slot = &jitter_buffer->slots[slot_index];
+    slot->sequence_number = sequence_number;
+    slot->in_use = 1;
+    slot->num_frames = num_frames;
+    slot->frame_len = payload_len / num_frames;
+    slot->frame_offset = 0;
+    slot->samples_per_frame = num_samples / num_frames;
+    (void)memcpy(&jitter_buffer->payload_storage[slot_index * jitter_buffer->max_payload_len], payload, payload_len);
+    jitter_buffer->num_packets++;
+    jitter_buffer->buffered_samples += (uint32_t) num_frames * slot->samples_per_frame;
+
+    if ((jitter_buffer->state == BTSTACK_JITTER_BUFFER_STATE_BUFFERING) && (jitter_buffer->buffered_samples >= jitter_buffer->target_samples)){
+        jitter_buffer->state = BTSTACK_JITTER_BUFFER_STATE_PLAYING;
+    }
+
+    btstack_jitter_buffer_update_latency(jitter_buffer);
+    return 0;
+}
+
+const uint8_t * btstack_jitter_buffer_get_frame(btstack_jitter_buffer_t * jitter_buffer, uint16_t * frame_len){
+    if (jitter_buffer->state != BTSTACK_JITTER_BUFFER_STATE_PLAYING) return NULL;
+
+    while (jitter_buffer->num_packets > 0u){
+        uint16_t slot_index = jitter_buffer->next_slot_index;
+        btstack_jitter_buffer_slot_t * slot = &jitter_buffer->slots[slot_index];
+        if (slot->in_use == 0u){
+            // audio is needed now, skip missing packet
+            jitter_buffer->statistics.packets_lost++;
+            btstack_jitter_buffer_advance(jitter_buffer);
+            continue;
+        }
+
+        const uint8_t * frame = &jitter_buffer->payload_storage[(slot_index * jitter_buffer->max_payload_len) + slot->frame_offset];
+        *frame_len = slot->frame_len;
+        slot->frame_offset += slot->frame_len;
+        slot->num_frames--;
+        jitter_buffer->buffered_samples -= slot->samples_per_frame;
+        if (slot->num_frames == 0u){
+            btstack_jitter_buffer_free_slot(jitter_buffer, slot);
+            btstack_jitter_buffer_advance(jitter_buffer);
+        }
+        btstack_jitter_buffer_update_latency(jitter_buffer);
+        return frame;
+    }
+
+    // underrun, buffer up to target latency again
+    jitter_buffer->statistics.underruns++;
+    jitter_buffer->state = BTSTACK_JITTER_BUFFER_STATE_BUFFERING;
+    return NULL;
+}
+
+int btstack_jitter_buffer_is_playing(btstack_jitter_buffer_t * jitter_buffer){
+    return jitter_buffer->state == BTSTACK_JITTER_BUFFER_STATE_PLAYING;
+}
+
+uint32_t btstack_jitter_buffer_get_resampling_factor(btstack_jitter_buffer_t * jitter_buffer){
+    // consume faster if sender is faster
+    int32_t factor = 0x10000 + (int32_t) (((int64_t) jitter_buffer->statistics.drift_ppm * 0x10000) / 1000000);
+
+    // converge to target latency
+    if (jitter_buffer->state == BTSTACK_JITTER_BUFFER_STATE_PLAYING){
+        int64_t deviation = (int64_t) jitter_buffer->buffered_samples - (int64_t) jitter_buffer->target_samples;
+        int32_t compensation = (int32_t) ((deviation * LEVEL_COMPENSATION_MAX) / (int64_t) jitter_buffer->target_samples);
+        if (compensation >  LEVEL_COMPENSATION_MAX) compensation =  LEVEL_COMPENSATION_MAX;
+        if (compensation < -LEVEL_COMPENSATION_MAX) compensation = -LEVEL_COMPENSATION_MAX;
+        factor += compensation;
+    }
+    return (uint32_t) factor;
+}
+
+const btstack_jitter_buffer_statistics_t * btstack_jitter_buffer_get_statistics(btstack_jitter_buffer_t * jitter_buffer){
+    return &jitter_buffer->statistics;
+}
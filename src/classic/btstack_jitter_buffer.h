@@ -0,0 +1,217 @@
+/*
+ * Copyright (C) 2019 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+/*
+ *  btstack_jitter_buffer.h
+ *
+ *  Adaptive jitter buffer for RTP based media streams, e.g. A2DP Sink
+ *
+ *  Packets are stored in a slot per sequence number, which reorders them and drops duplicates
+ *  and packets that arrive after their playout. Codec frames are then read in sequence order.
+ *  Playout starts once the target latency is buffered, and pauses again on underrun until
+ *  the target latency is buffered again.
+ *
+ *  The target latency follows the inter-arrival jitter (RFC 3550) of the stream. The jitter
+ *  estimate rises fast on bursts and decays slowly.
+ *
+ *  The clock drift between sender and receiver is estimated from the minimal transit time per
+ *  window, i.e. packets that were not delayed by jitter. Together with the deviation of the buffer
+ *  level from the target, it gives the resampling factor for btstack_resample.
+ */
+
+#ifndef BTSTACK_JITTER_BUFFER_H
+#define BTSTACK_JITTER_BUFFER_H
+
+#include <stdint.h>
+
+#if defined __cplusplus
+extern "C" {
+#endif
+
+#define BTSTACK_JITTER_BUFFER_DRIFT_WINDOWS 8
+
+typedef struct {
+    uint16_t sequence_number;
+    uint8_t  in_use;
+    // frames not played yet
+    uint8_t  num_frames;
+    uint16_t frame_len;
+    uint16_t frame_offset;
+    uint16_t samples_per_frame;
+} btstack_jitter_buffer_slot_t;
+
+typedef struct {
+    uint32_t packets_received;
+    uint32_t packets_duplicate;
+    uint32_t packets_late;
+    uint32_t packets_lost;
+    uint32_t packets_dropped_overflow;
+    uint32_t underruns;
+    uint32_t resyncs;
+    // current and max buffered audio
+    uint32_t latency_ms;
+    uint32_t latency_max_ms;
+    uint32_t target_latency_ms;
+    // inter-arrival jitter in us
+    uint32_t jitter_us;
+    // sender clock relative to receiver clock, positive if sender is faster
+    int32_t  drift_ppm;
+} btstack_jitter_buffer_statistics_t;
+
+typedef enum {
+    BTSTACK_JITTER_BUFFER_STATE_BUFFERING = 0,
+    BTSTACK_JITTER_BUFFER_STATE_PLAYING,
+} btstack_jitter_buffer_state_t;
+
+typedef struct {
+    // storage
+    btstack_jitter_buffer_slot_t * slots;
+    uint8_t  * payload_storage;
+    uint16_t num_slots;
+    uint16_t max_payload_len;
+
+    // config
+    uint32_t sample_rate;
+    uint32_t target_min_samples;
+    uint32_t target_max_samples;
+
+    // playout
+    btstack_jitter_buffer_state_t state;
+    uint8_t  have_sequence_number;
+    uint16_t next_sequence_number;
+    // slot of next_sequence_number, slots are indexed relative to it as num_slots might not divide 2^16
+    uint16_t next_slot_index;
+    uint16_t num_packets;
+    uint32_t buffered_samples;
+    uint32_t target_samples;
+
+    // inter-arrival jitter
+    uint8_t  have_last_arrival;
+    uint32_t last_arrival_time_ms;
+    uint32_t last_timestamp;
+    uint32_t jitter_samples_q4;
+
+    // clock drift: transit = arrival time in samples - timestamp, relative to reference packet
+    uint8_t  have_drift_reference;
+    uint32_t drift_reference_arrival_time_ms;
+    uint32_t drift_reference_timestamp;
+    uint32_t window_start_timestamp;
+    int32_t  window_min_transit;
+    // min transit and start timestamp of completed windows, oldest first
+    uint8_t  num_windows;
+    int32_t  windows_min_transit[BTSTACK_JITTER_BUFFER_DRIFT_WINDOWS];
+    uint32_t windows_start_timestamp[BTSTACK_JITTER_BUFFER_DRIFT_WINDOWS];
+
+    btstack_jitter_buffer_statistics_t statistics;
+} btstack_jitter_buffer_t;
+
+/**
+ * @brief Init jitter buffer
+ * @param jitter_buffer
+ * @param slots storage for num_slots packet headers
+ * @param payload_storage storage for num_slots * max_payload_len bytes
+ * @param num_slots any number, does not need to divide 2^16
+ * @param max_payload_len
+ * @param sample_rate of RTP timestamps and audio
+ */
+void btstack_jitter_buffer_init(btstack_jitter_buffer_t * jitter_buffer, btstack_jitter_buffer_slot_t * slots, uint8_t * payload_storage,
+                                uint16_t num_slots, uint16_t max_payload_len, uint32_t sample_rate);
+
+/**
+ * @brief Set range for target latency, default 40 - 300 ms. Max is limited by number of slots
+ * @param jitter_buffer
+ * @param min_ms
+ * @param max_ms
+ */
+void btstack_jitter_buffer_set_target_latency_range(btstack_jitter_buffer_t * jitter_buffer, uint16_t min_ms, uint16_t max_ms);
+
+/**
+ * @brief Drop all packets and estimates, e.g. when stream is restarted
+ * @param jitter_buffer
+ */
+void btstack_jitter_buffer_reset(btstack_jitter_buffer_t * jitter_buffer);
+
+/**
+ * @brief Add media packet
+ * @param jitter_buffer
+ * @param sequence_number from RTP header
+ * @param timestamp from RTP header
+ * @param arrival_time_ms e.g. btstack_run_loop_get_time_ms()
+ * @param payload with num_frames codec frames of equal size
+ * @param payload_len
+ * @param num_frames
+ * @param num_samples audio frames in payload
+ * @return 0 if ok, ERROR_CODE_MEMORY_CAPACITY_EXCEEDED if payload is larger than max_payload_len
+ */
+int btstack_jitter_buffer_add_packet(btstack_jitter_buffer_t * jitter_buffer, uint16_t sequence_number, uint32_t timestamp, uint32_t arrival_time_ms,
+                                     const uint8_t * payload, uint16_t payload_len, uint8_t num_frames, uint16_t num_samples);
+
+/**
+ * @brief Get next codec frame in sequence order
+ * @note returned frame is valid until next call to btstack_jitter_buffer_add_packet or btstack_jitter_buffer_get_frame
+ * @param jitter_buffer
+ * @param frame_len
+ * @return frame or NULL, if buffering or underrun
+ */
+const uint8_t * btstack_jitter_buffer_get_frame(btstack_jitter_buffer_t * jitter_buffer, uint16_t * frame_len);
+
+/**
+ * @brief Check if enough audio has been buffered to play
+ * @param jitter_buffer
+ * @return true if playing
+ */
+int btstack_jitter_buffer_is_playing(btstack_jitter_buffer_t * jitter_buffer);
+
+/**
+ * @brief Get resampling factor that compensates clock drift and deviation from target latency
+ * @param jitter_buffer
+ * @return factor for btstack_resample_set_factor as fixed point value, identity is 0x10000
+ */
+uint32_t btstack_jitter_buffer_get_resampling_factor(btstack_jitter_buffer_t * jitter_buffer);
+
+/**
+ * @brief Get statistics
+ * @param jitter_buffer
+ * @return statistics
+ */
+const btstack_jitter_buffer_statistics_t * btstack_jitter_buffer_get_statistics(btstack_jitter_buffer_t * jitter_buffer);
+
+#if defined __cplusplus
+}
+#endif
+
+#endif // BTSTACK_JITTER_BUFFER_H
@@ -49,6 +49,10 @@
 #include "classic/sdp_util.h"
 #include "l2cap.h"
 
+#ifndef HID_DEVICE_MAX_REPORTS
+#define HID_DEVICE_MAX_REPORTS 16
+#endif
+
 typedef enum {
     HID_DEVICE_IDLE,
     HID_DEVICE_CONNECTED,
@@ -85,6 +89,11 @@ static uint8_t hid_boot_protocol_mode_supported;
 static const uint8_t * hid_descriptor;
 static uint16_t hid_descriptor_len;
 
+// report sizes and IDs compiled from descriptor, fallback to parsing descriptor if too many reports
+static btstack_hid_report_layout_t hid_report_layout;
+static btstack_hid_report_t hid_reports[HID_DEVICE_MAX_REPORTS];
+static bool hid_report_layout_valid;
+
 static int dummy_write_report(uint16_t hid_cid, hid_report_type_t report_type, uint16_t report_id, int * out_report_size, uint8_t * out_report){
     UNUSED(hid_cid);
     UNUSED(report_type);
@@ -355,6 +364,20 @@ static inline void hid_device_emit_event(hid_device_t * context, uint8_t subeven
     hid_callback(HCI_EVENT_PACKET, context->cid, &event[0], pos);
 }
 
+static int hid_device_report_id_declared(void){
+    if (hid_report_layout_valid){
+        return btstack_hid_report_layout_report_id_declared(&hid_report_layout);
+    }
+    return btstack_hid_report_id_declared(hid_descriptor_len, hid_descriptor);
+}
+
+static int hid_device_get_report_size_from_descriptor(int report_id, hid_report_type_t report_type){
+    if (hid_report_layout_valid){
+        return btstack_hid_report_layout_get_report_size(&hid_report_layout, report_id, report_type);
+    }
+    return btstack_hid_get_report_size_for_id(report_id, report_type, hid_descriptor_len, hid_descriptor);
+}
+
 static int hid_report_size_valid(uint16_t cid, int report_id, hid_report_type_t report_type, int report_size){
     if (!report_size) return 0;
     if (hid_device_in_boot_protocol_mode(cid)){
@@ -369,13 +392,13 @@ static int hid_report_size_valid(uint16_t cid, int report_id, hid_report_type_t
                 return 0;
         }
     } else {
-        int size =  btstack_hid_get_report_size_for_id(report_id, report_type, hid_descriptor_len, hid_descriptor);
+        int size = hid_device_get_report_size_from_descriptor(report_id, report_type);
         if ((size == 0) || (size != report_size)) return 0;
     }
     return 1;
 }
 
-static int hid_get_report_size_for_id(uint16_t cid, int report_id, hid_report_type_t report_type, uint16_t descriptor_len, const uint8_t * descriptor){
+static int hid_get_report_size_for_id(uint16_t cid, int report_id, hid_report_type_t report_type){
     if (hid_device_in_boot_protocol_mode(cid)){
         switch (report_id){
             case HID_BOOT_MODE_KEYBOARD_ID:
@@ -386,7 +409,7 @@ static int hid_get_report_size_for_id(uint16_t cid, int report_id, hid_report_ty
                 return 0;
         }
     } else {
-        return btstack_hid_get_report_size_for_id(report_id, report_type, descriptor_len, descriptor);
+        return hid_device_get_report_size_from_descriptor(report_id, report_type);
     }
 }
 
@@ -400,6 +423,9 @@ static hid_report_id_status_t hid_report_id_status(uint16_t cid, uint16_t report
                 return HID_REPORT_ID_INVALID;
         }
     } else {
+        if (hid_report_layout_valid){
+            return btstack_hid_report_layout_id_valid(&hid_report_layout, report_id);
+        }
         return btstack_hid_id_valid(report_id, hid_descriptor_len, hid_descriptor);
     }
 }
@@ -408,7 +434,7 @@ static hid_handshake_param_type_t hid_device_set_report_cmd_is_valid(uint16_t ci
     int pos = 0;
     int report_id = 0;
 
-    if (btstack_hid_report_id_declared(hid_descriptor_len, hid_descriptor)){
+    if (hid_device_report_id_declared()){
         report_id = report[pos++];
         hid_report_id_status_t report_id_status = hid_report_id_status(cid, report_id);
         switch (report_id_status){
@@ -469,7 +495,7 @@ static void packet_handler(uint8_t packet_type, uint16_t channel, uint8_t * pack
                             device->report_id = packet[pos++];
                             break;
                         case HID_PROTOCOL_MODE_REPORT:
-                            if (!btstack_hid_report_id_declared(hid_descriptor_len, hid_descriptor)) {
+                            if (!hid_device_report_id_declared()) {
                                 if (packet_size < 2) break;
                                 if (packet[0] & 0x08){ 
                                     if (packet_size > 2) {
@@ -501,7 +527,7 @@ static void packet_handler(uint8_t packet_type, uint16_t channel, uint8_t * pack
                             break;
                     }
                     
-                    device->expected_report_size = hid_get_report_size_for_id(device->cid, device->report_id, device->report_type, hid_descriptor_len, hid_descriptor); 
+                    device->expected_report_size = hid_get_report_size_for_id(device->cid, device->report_id, device->report_type); 
                     report_size =  device->expected_report_size + pos; // add 1 for header size and report id
                     
                     if ((packet[0] & 0x08) && (packet_size >= (pos + 1))){
@@ -610,7 +636,7 @@ static void packet_handler(uint8_t packet_type, uint16_t channel, uint8_t * pack
                     pos = 0;
                     device->report_type = (hid_report_type_t)(packet[pos++] & 0x03);
                     device->report_id = 0;
-                    if (btstack_hid_report_id_declared(hid_descriptor_len, hid_descriptor)){
+                    if (hid_device_report_id_declared()){
                         device->report_id = packet[pos++];
                     }
                     
@@ -847,6 +873,8 @@ void hid_device_init(uint8_t boot_protocol_mode_supported, uint16_t descriptor_l
     hid_boot_protocol_mode_supported = boot_protocol_mode_supported;
     hid_descriptor =  descriptor;
     hid_descriptor_len = descriptor_len;
+    btstack_hid_report_layout_init(&hid_report_layout, hid_reports, HID_DEVICE_MAX_REPORTS, NULL, 0);
+    hid_report_layout_valid = btstack_hid_report_layout_compile(&hid_report_layout, descriptor_len, descriptor) == ERROR_CODE_SUCCESS;
     hci_device_get_report = dummy_write_report;
     hci_device_set_report = dummy_set_report;
     hci_device_report_data = dummy_report_data;
@@ -170,6 +170,22 @@ static btstack_linked_list_t rfcomm_services = NULL;
 
 static gap_security_level_t rfcomm_security_level;
 
+#ifdef ENABLE_BTSTACK_STATS
+static void rfcomm_stats_for_each_traffic(btstack_stats_traffic_handler_t handler, void * context){
+    btstack_linked_list_iterator_t it;
+    btstack_linked_list_iterator_init(&it, &rfcomm_channels);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        rfcomm_channel_t * channel = (rfcomm_channel_t *) btstack_linked_list_iterator_next(&it);
+        (*handler)(context, "rfcomm_channel", channel->rfcomm_cid, &channel->stats);
+    }
+}
+
+static btstack_stats_source_t rfcomm_stats_source = {
+    { NULL },
+    &rfcomm_stats_for_each_traffic
+};
+#endif
+
 #ifdef RFCOMM_USE_ERTM
 static uint16_t rfcomm_ertm_id;
 void (*rfcomm_ertm_request_callback)(rfcomm_ertm_request_t * request);
@@ -1453,9 +1469,13 @@ static void rfcomm_channel_packet_handler_uih(rfcomm_multiplexer_t *multiplexer,
             channel->credits_incoming--;
         }
         
-        // deliver payload
-        (channel->packet_handler)(RFCOMM_DATA_PACKET, channel->rfcomm_cid,
+        // deliver payload, channel might get freed in packet handler
+        uint16_t rfcomm_cid = channel->rfcomm_cid;
+        BTSTACK_STATS_TRAFFIC_IN(&channel->stats, size-payload_offset-1);
+        BTSTACK_STATS_TRACE_BEGIN(RFCOMM_CHANNEL, rfcomm_cid);
+        (channel->packet_handler)(RFCOMM_DATA_PACKET, rfcomm_cid,
                               &packet[payload_offset], size-payload_offset-1);
+        BTSTACK_STATS_TRACE_END(RFCOMM_CHANNEL, rfcomm_cid);
     }
     
     // automatically provide new credits to remote device, if no incoming flow control
@@ -2185,6 +2205,9 @@ void rfcomm_init(void){
     rfcomm_services     = NULL;
     rfcomm_channels     = NULL;
     rfcomm_security_level = gap_get_security_level();
+#ifdef ENABLE_BTSTACK_STATS
+    btstack_stats_add_source(&rfcomm_stats_source);
+#endif
 }
 
 void rfcomm_set_required_security_level(gap_security_level_t security_level){
@@ -2310,7 +2333,8 @@ int rfcomm_send_prepared(uint16_t rfcomm_cid, uint16_t len){
         log_error("rfcomm_send_prepared: error %d", result);
         return result;
     }
-    
+
+    BTSTACK_STATS_TRAFFIC_OUT(&channel->stats, len);
     return result;
 }
 
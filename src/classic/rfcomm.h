@@ -247,6 +247,11 @@ typedef struct {
     //
     uint8_t   waiting_for_can_send_now;
         
+
+#ifdef ENABLE_BTSTACK_STATS
+    // traffic of this channel
+    btstack_stats_traffic_t stats;
+#endif
 } rfcomm_channel_t;
 
 // struct used in ERTM callback
@@ -112,6 +112,87 @@ typedef enum {
     AUTHORIZATION_GRANTED
 } authorization_state_t;
 
+// LE Scan Filter criteria
+#define GAP_LE_SCAN_FILTER_ADDRESS              (1u << 0)
+#define GAP_LE_SCAN_FILTER_SERVICE_UUID16       (1u << 1)
+#define GAP_LE_SCAN_FILTER_SERVICE_UUID128      (1u << 2)
+#define GAP_LE_SCAN_FILTER_MANUFACTURER_DATA    (1u << 3)
+#define GAP_LE_SCAN_FILTER_RSSI                 (1u << 4)
+
+// LE Scan Filter, all criteria set in 'criteria' have to match
+typedef struct {
+    btstack_linked_item_t item;
+    uint8_t         criteria;
+
+    // GAP_LE_SCAN_FILTER_ADDRESS
+    bd_addr_type_t  address_type;
+    bd_addr_t       address;
+    // GAP_LE_SCAN_FILTER_SERVICE_UUID16 / GAP_LE_SCAN_FILTER_SERVICE_UUID128 (big endian)
+    uint16_t        service_uuid16;
+    const uint8_t * service_uuid128;
+    // GAP_LE_SCAN_FILTER_MANUFACTURER_DATA: Company ID and data prefix after it, optional mask for prefix
+    uint16_t        manufacturer_id;
+    const uint8_t * manufacturer_data_prefix;
+    const uint8_t * manufacturer_data_mask;
+    uint8_t         manufacturer_data_prefix_len;
+    // GAP_LE_SCAN_FILTER_RSSI: minimal RSSI in dBm
+    int8_t          rssi_threshold;
+
+    // number of advertising reports that matched this filter
+    uint32_t        num_matches;
+} gap_le_scan_filter_t;
+
+// LE Extended Advertising Parameters, see LE Set Extended Advertising Parameters command
+typedef struct {
+    uint16_t        advertising_event_properties;
+    uint32_t        primary_advertising_interval_min;
+    uint32_t        primary_advertising_interval_max;
+    uint8_t         primary_advertising_channel_map;
+    bd_addr_type_t  own_address_type;
+    bd_addr_type_t  peer_address_type;
+    bd_addr_t       peer_address;
+    uint8_t         advertising_filter_policy;
+    int8_t          advertising_tx_power;
+    uint8_t         primary_advertising_phy;
+    uint8_t         secondary_advertising_max_skip;
+    uint8_t         secondary_advertising_phy;
+    uint8_t         advertising_sid;
+    uint8_t         scan_request_notification_enable;
+} le_extended_advertising_parameters_t;
+
+// LE Periodic Advertising Parameters, see LE Set Periodic Advertising Parameters command
+typedef struct {
+    uint16_t        periodic_advertising_interval_min;
+    uint16_t        periodic_advertising_interval_max;
+    uint16_t        periodic_advertising_properties;
+} le_periodic_advertising_parameters_t;
+
+// LE Advertising Set, storage provided by application
+typedef struct {
+    btstack_linked_item_t item;
+    uint8_t         advertising_handle;
+    uint8_t         state;
+    uint8_t         tasks;
+
+    le_extended_advertising_parameters_t extended_params;
+    le_periodic_advertising_parameters_t periodic_params;
+
+    // data is not copied, fragments are sent from the current position
+    const uint8_t * adv_data;
+    uint16_t        adv_data_len;
+    uint16_t        adv_data_pos;
+    const uint8_t * scan_data;
+    uint16_t        scan_data_len;
+    uint16_t        scan_data_pos;
+    const uint8_t * periodic_data;
+    uint16_t        periodic_data_len;
+    uint16_t        periodic_data_pos;
+
+    // duration in 10 ms and max number of extended advertising events for start
+    uint16_t        enable_timeout;
+    uint8_t         enable_max_events;
+} le_advertising_set_t;
+
 
 /* API_START */
 
@@ -309,6 +390,72 @@ void gap_start_scan(void);
  */
 void gap_stop_scan(void);
 
+/**
+ * @brief Set PHYs used for LE Extended Scan and LE Extended Create Connection
+ * @note requires ENABLE_LE_EXTENDED_ADVERTISING and a Controller that supports the LE Extended Advertising commands
+ * @param phys with bit 0 = LE 1M PHY, bit 2 = LE Coded PHY, default: LE 1M PHY
+ */
+void gap_set_scan_phys(uint8_t phys);
+
+/**
+ * @brief Synchronize with Periodic Advertising train. Scanning needs to be active.
+ * @note HCI_SUBEVENT_LE_PERIODIC_ADVERTISING_SYNC_ESTABLISHMENT is emitted when done
+ * @param options see LE Periodic Advertising Create Sync command
+ * @param advertising_sid
+ * @param advertiser_address_type
+ * @param advertiser_address
+ * @param skip number of periodic advertising packets that can be skipped
+ * @param sync_timeout in 10 ms
+ * @return status
+ */
+uint8_t gap_periodic_advertising_create_sync(uint8_t options, uint8_t advertising_sid, bd_addr_type_t advertiser_address_type,
+                                             const bd_addr_t advertiser_address, uint16_t skip, uint16_t sync_timeout);
+
+/**
+ * @brief Cancel pending sync with Periodic Advertising train
+ * @return status
+ */
+uint8_t gap_periodic_advertising_create_sync_cancel(void);
+
+/**
+ * @brief Stop sync with Periodic Advertising train
+ * @param sync_handle
+ * @return status
+ */
+uint8_t gap_periodic_advertising_terminate_sync(uint16_t sync_handle);
+
+/**
+ * @brief Add LE Scan Filter. If filters are registered, only advertising reports that match at least one of them are forwarded as GAP_EVENT_ADVERTISING_REPORT
+ * @note requires ENABLE_LE_SCAN_FILTER
+ * @param filter
+ */
+void gap_le_scan_filter_add(gap_le_scan_filter_t * filter);
+
+/**
+ * @brief Remove LE Scan Filter
+ * @param filter
+ */
+void gap_le_scan_filter_remove(gap_le_scan_filter_t * filter);
+
+/**
+ * @brief Suppress advertising reports with same address, event type and data within time window
+ * @param window_ms or 0 to disable duplicate suppression
+ */
+void gap_le_scan_filter_set_duplicate_window(uint32_t window_ms);
+
+/**
+ * @brief Get number of received advertising reports, reports dropped by filters and suppressed duplicates
+ * @param num_reports
+ * @param num_dropped
+ * @param num_duplicates
+ */
+void gap_le_scan_filter_get_counters(uint32_t * num_reports, uint32_t * num_dropped, uint32_t * num_duplicates);
+
+/**
+ * @brief Reset counters incl. match counters of all filters
+ */
+void gap_le_scan_filter_reset_counters(void);
+
 /**
  * @brief Enable privacy by using random addresses
  * @param random_address_type to use (incl. OFF)
@@ -374,6 +521,102 @@ void gap_advertisements_enable(int enabled);
  */
 void gap_scan_response_set_data(uint8_t scan_response_data_length, uint8_t * scan_response_data);
 
+/**
+ * @brief Setup LE Extended Advertising Set. With a Controller that supports the LE Extended Advertising commands,
+ *        the legacy advertising above uses advertising handle 0 with legacy PDUs.
+ * @note requires ENABLE_LE_EXTENDED_ADVERTISING
+ * @param storage for advertising set, has to stay valid until the set is removed
+ * @param advertising_parameters are copied
+ * @param out_advertising_handle
+ * @return status
+ */
+uint8_t gap_extended_advertising_setup(le_advertising_set_t * storage, const le_extended_advertising_parameters_t * advertising_parameters, uint8_t * out_advertising_handle);
+
+/**
+ * @brief Set LE Extended Advertising Parameters
+ * @param advertising_handle
+ * @param advertising_parameters are copied
+ * @return status
+ */
+uint8_t gap_extended_advertising_set_params(uint8_t advertising_handle, const le_extended_advertising_parameters_t * advertising_parameters);
+
+/**
+ * @brief Set LE Extended Advertising Data
+ * @param advertising_handle
+ * @param advertising_data_length up to LE_EXTENDED_ADVERTISING_MAX_DATA_LEN
+ * @param advertising_data
+ * @note data is not copied, pointer has to stay valid. It is sent in fragments of up to 251 bytes
+ * @return status
+ */
+uint8_t gap_extended_advertising_set_adv_data(uint8_t advertising_handle, uint16_t advertising_data_length, const uint8_t * advertising_data);
+
+/**
+ * @brief Set LE Extended Scan Response Data
+ * @param advertising_handle
+ * @param scan_response_data_length up to LE_EXTENDED_ADVERTISING_MAX_DATA_LEN
+ * @param scan_response_data
+ * @note data is not copied, pointer has to stay valid
+ * @return status
+ */
+uint8_t gap_extended_advertising_set_scan_response_data(uint8_t advertising_handle, uint16_t scan_response_data_length, const uint8_t * scan_response_data);
+
+/**
+ * @brief Start LE Extended Advertising. Multiple advertising sets can be active at the same time
+ * @note HCI_SUBEVENT_LE_ADVERTISING_SET_TERMINATED is emitted if advertising stops on its own, e.g. after a connection
+ * @param advertising_handle
+ * @param timeout in 10 ms, or 0 = no timeout
+ * @param num_extended_advertising_events, or 0 = no limit
+ * @return status
+ */
+uint8_t gap_extended_advertising_start(uint8_t advertising_handle, uint16_t timeout, uint8_t num_extended_advertising_events);
+
+/**
+ * @brief Stop LE Extended Advertising
+ * @param advertising_handle
+ * @return status
+ */
+uint8_t gap_extended_advertising_stop(uint8_t advertising_handle);
+
+/**
+ * @brief Remove LE Extended Advertising Set. Storage can be re-used after next HCI_EVENT_COMMAND_COMPLETE for
+ *        LE Remove Advertising Set
+ * @param advertising_handle
+ * @return status
+ */
+uint8_t gap_extended_advertising_remove(uint8_t advertising_handle);
+
+/**
+ * @brief Set LE Periodic Advertising Parameters. Advertising set must be non-connectable and non-scannable
+ * @param advertising_handle
+ * @param periodic_advertising_parameters are copied
+ * @return status
+ */
+uint8_t gap_periodic_advertising_set_params(uint8_t advertising_handle, const le_periodic_advertising_parameters_t * periodic_advertising_parameters);
+
+/**
+ * @brief Set LE Periodic Advertising Data
+ * @param advertising_handle
+ * @param periodic_data_length up to LE_EXTENDED_ADVERTISING_MAX_DATA_LEN
+ * @param periodic_data
+ * @note data is not copied, pointer has to stay valid. It is sent in fragments of up to 252 bytes
+ * @return status
+ */
+uint8_t gap_periodic_advertising_set_data(uint8_t advertising_handle, uint16_t periodic_data_length, const uint8_t * periodic_data);
+
+/**
+ * @brief Start LE Periodic Advertising
+ * @param advertising_handle
+ * @return status
+ */
+uint8_t gap_periodic_advertising_start(uint8_t advertising_handle);
+
+/**
+ * @brief Stop LE Periodic Advertising
+ * @param advertising_handle
+ * @return status
+ */
+uint8_t gap_periodic_advertising_stop(uint8_t advertising_handle);
+
 /**
  * @brief Set connection parameters for outgoing connections
  * @param conn_scan_interval (unit: 0.625 msec), default: 60 ms
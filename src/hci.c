@@ -70,6 +70,7 @@
 #include "btstack_event.h"
 #include "btstack_linked_list.h"
 #include "btstack_memory.h"
+#include "btstack_stats.h"
 #include "bluetooth_company_id.h"
 #include "bluetooth_data_types.h"
 #include "gap.h"
@@ -78,6 +79,11 @@
 #include "hci_dump.h"
 #include "ad_parser.h"
 
+#ifdef ENABLE_HCI_CAPABILITIES_CACHE
+#include <stddef.h>
+#include "btstack_tlv.h"
+#endif
+
 #ifdef ENABLE_HCI_CONTROLLER_TO_HOST_FLOW_CONTROL
 #ifndef HCI_HOST_ACL_PACKET_NUM
 #error "ENABLE_HCI_CONTROLLER_TO_HOST_FLOW_CONTROL requires to define HCI_HOST_ACL_PACKET_NUM"
@@ -156,6 +162,9 @@ static void hci_emit_event(uint8_t * event, uint16_t size, int dump);
 static void hci_emit_acl_packet(uint8_t * packet, uint16_t size);
 static void hci_run(void);
 static int  hci_is_le_connection(hci_connection_t * connection);
+static void hci_initializing_transition(void);
+static void hci_init_done(void);
+static void handle_command_complete_event(uint8_t * packet, uint16_t size);
 static int  hci_number_free_acl_slots_for_connection_type( bd_addr_type_t address_type);
 
 #ifdef ENABLE_CLASSIC
@@ -166,6 +175,10 @@ static int hci_have_usb_transport(void);
 #ifdef ENABLE_LE_CENTRAL
 // called from test/ble_client/advertising_data_parser.c
 void le_handle_advertisement_report(uint8_t *packet, uint16_t size);
+#ifdef ENABLE_LE_EXTENDED_ADVERTISING
+// called from test/ble_client/le_extended_advertising_test.c
+void le_handle_extended_advertisement_report(uint8_t * packet, uint16_t size);
+#endif
 static uint8_t hci_whitelist_remove(bd_addr_type_t address_type, const bd_addr_t address);
 static hci_connection_t * gap_get_outgoing_connection(void);
 #endif
@@ -177,6 +190,55 @@ static hci_stack_t   hci_stack_static;
 #endif
 static hci_stack_t * hci_stack = NULL;
 
+#ifdef ENABLE_HCI_MULTIPLE_CONTROLLERS
+#ifndef MAX_NR_HCI_CONTROLLERS
+#define MAX_NR_HCI_CONTROLLERS 2
+#endif
+// plain number, used to generate the per-controller packet handlers
+#if (MAX_NR_HCI_CONTROLLERS < 2) || (MAX_NR_HCI_CONTROLLERS > 4)
+#error "MAX_NR_HCI_CONTROLLERS needs to be 2..4"
+#endif
+#ifndef HAVE_MALLOC
+static hci_stack_t   hci_stack_secondary_static[MAX_NR_HCI_CONTROLLERS - 1];
+#endif
+// controller 0 is the primary controller set up by hci_init
+static hci_stack_t * hci_instances[MAX_NR_HCI_CONTROLLERS];
+static uint8_t       hci_num_instances;
+// stack layers that serve all controllers, e.g. L2CAP
+static btstack_linked_list_t hci_shared_event_handlers;
+
+// find controller instance that owns the timer
+static hci_stack_t * hci_instance_for_timer(btstack_timer_source_t * ts){
+    uint8_t i;
+    for (i = 0; i < hci_num_instances; i++){
+        hci_stack_t * instance = hci_instances[i];
+        if (&instance->timeout == ts) return instance;
+        btstack_linked_list_iterator_t it;
+        btstack_linked_list_iterator_init(&it, &instance->connections);
+        while (btstack_linked_list_iterator_has_next(&it)){
+            hci_connection_t * connection = (hci_connection_t *) btstack_linked_list_iterator_next(&it);
+            if (&connection->timeout == ts) return instance;
+#ifdef ENABLE_CLASSIC
+            if (&connection->timeout_sco == ts) return instance;
+#endif
+        }
+    }
+    return hci_stack;
+}
+#endif
+
+// process timer with the controller instance that owns it selected
+static void hci_instance_process_timer(btstack_timer_source_t * ts, void (*process)(btstack_timer_source_t * ts)){
+#ifdef ENABLE_HCI_MULTIPLE_CONTROLLERS
+    hci_stack_t * selected_instance = hci_stack;
+    hci_stack = hci_instance_for_timer(ts);
+    (*process)(ts);
+    hci_stack = selected_instance;
+#else
+    (*process)(ts);
+#endif
+}
+
 #ifdef ENABLE_CLASSIC
 // default name
 static const char * default_classic_name = "BTstack 00:00:00:00:00:00";
@@ -341,7 +403,7 @@ static int hci_number_sco_connections(void){
 }
 #endif
 
-static void hci_connection_timeout_handler(btstack_timer_source_t *timer){
+static void hci_connection_timeout_process(btstack_timer_source_t *timer){
     hci_connection_t * connection = (hci_connection_t *) btstack_run_loop_get_timer_context(timer);
 #ifdef HAVE_EMBEDDED_TICK
     if (btstack_run_loop_embedded_get_ticks() > connection->timestamp + btstack_run_loop_embedded_ticks_for_ms(HCI_CONNECTION_TIMEOUT_MS)){
@@ -356,6 +418,10 @@ static void hci_connection_timeout_handler(btstack_timer_source_t *timer){
 #endif
 }
 
+static void hci_connection_timeout_handler(btstack_timer_source_t * ts){
+    hci_instance_process_timer(ts, &hci_connection_timeout_process);
+}
+
 static void hci_connection_timestamp(hci_connection_t *connection){
 #ifdef HAVE_EMBEDDED_TICK
     connection->timestamp = btstack_run_loop_embedded_get_ticks();
@@ -579,29 +645,65 @@ static int hci_transport_can_send_prepared_packet_now(uint8_t packet_type){
     return hci_stack->hci_transport->can_send_packet_now(packet_type);
 }
 
+// can send predicates are polled, count ACL credit stall and packet buffer contention only once per occurrence
+static void hci_stats_acl_credits(int free_slots){
+#ifdef ENABLE_BTSTACK_STATS
+    if (free_slots > 0){
+        hci_stack->stats_acl_credit_stall = 0;
+        return;
+    }
+    if (hci_stack->stats_acl_credit_stall) return;
+    hci_stack->stats_acl_credit_stall = 1;
+    BTSTACK_STATS_INCREMENT(HCI_ACL_CREDIT_STALLS);
+#else
+    UNUSED(free_slots);
+#endif
+}
+
+static void hci_stats_packet_buffer_contention(void){
+#ifdef ENABLE_BTSTACK_STATS
+    if (hci_stack->stats_packet_buffer_contention) return;
+    hci_stack->stats_packet_buffer_contention = 1;
+    BTSTACK_STATS_INCREMENT(HCI_PACKET_BUFFER_CONTENTION);
+#endif
+}
+
 static int hci_can_send_prepared_acl_packet_for_address_type(bd_addr_type_t address_type){
     if (!hci_transport_can_send_prepared_packet_now(HCI_ACL_DATA_PACKET)) return 0;
-    return hci_number_free_acl_slots_for_connection_type(address_type) > 0;
+    int free_slots = hci_number_free_acl_slots_for_connection_type(address_type);
+    hci_stats_acl_credits(free_slots);
+    return free_slots > 0;
 }
 
 int hci_can_send_acl_le_packet_now(void){
-    if (hci_stack->hci_packet_buffer_reserved) return 0;
+    if (hci_stack->hci_packet_buffer_reserved) {
+        hci_stats_packet_buffer_contention();
+        return 0;
+    }
     return hci_can_send_prepared_acl_packet_for_address_type(BD_ADDR_TYPE_LE_PUBLIC);
 }
 
 int hci_can_send_prepared_acl_packet_now(hci_con_handle_t con_handle) {
     if (!hci_transport_can_send_prepared_packet_now(HCI_ACL_DATA_PACKET)) return 0;
-    return hci_number_free_acl_slots_for_handle(con_handle) > 0;
+    int free_slots = hci_number_free_acl_slots_for_handle(con_handle);
+    hci_stats_acl_credits(free_slots);
+    return free_slots > 0;
 }
 
 int hci_can_send_acl_packet_now(hci_con_handle_t con_handle){
-    if (hci_stack->hci_packet_buffer_reserved) return 0;
+    if (hci_stack->hci_packet_buffer_reserved) {
+        hci_stats_packet_buffer_contention();
+        return 0;
+    }
     return hci_can_send_prepared_acl_packet_now(con_handle);
 }
 
 #ifdef ENABLE_CLASSIC
 int hci_can_send_acl_classic_packet_now(void){
-    if (hci_stack->hci_packet_buffer_reserved) return 0;
+    if (hci_stack->hci_packet_buffer_reserved) {
+        hci_stats_packet_buffer_contention();
+        return 0;
+    }
     return hci_can_send_prepared_acl_packet_for_address_type(BD_ADDR_TYPE_ACL);
 }
 
@@ -634,6 +736,7 @@ int hci_is_packet_buffer_reserved(void){
 int hci_reserve_packet_buffer(void){
     if (hci_stack->hci_packet_buffer_reserved) {
         log_error("hci_reserve_packet_buffer called but buffer already reserved");
+        hci_stats_packet_buffer_contention();
         return 0;
     }
     hci_stack->hci_packet_buffer_reserved = 1;
@@ -642,6 +745,9 @@ int hci_reserve_packet_buffer(void){
 
 void hci_release_packet_buffer(void){
     hci_stack->hci_packet_buffer_reserved = 0;
+#ifdef ENABLE_BTSTACK_STATS
+    hci_stack->stats_packet_buffer_contention = 0;
+#endif
 }
 
 // assumption: synchronous implementations don't provide can_send_packet_now as they don't keep the buffer after the call
@@ -696,6 +802,8 @@ static int hci_send_acl_packet_fragments(hci_connection_t *connection){
 
         // count packet
         connection->num_packets_sent++;
+        BTSTACK_STATS_HCI_ACL_OUT(current_acl_data_packet_length + 4);
+        BTSTACK_STATS_TRAFFIC_OUT(&connection->stats, current_acl_data_packet_length + 4);
         log_debug("hci_send_acl_packet_fragments loop before send (more fragments %d)", more_fragments);
 
         // update state for next fragment (if any) as "transport done" might be sent during send_packet already
@@ -720,6 +828,9 @@ static int hci_send_acl_packet_fragments(hci_connection_t *connection){
         // done yet?
         if (!more_fragments) break;
 
+        // remaining fragments already sent, if transport emitted HCI_EVENT_TRANSPORT_PACKET_SENT during send_packet
+        if (hci_stack->acl_fragmentation_total_size == 0u) return err;
+
         // can send more?
         if (!hci_can_send_prepared_acl_packet_now(connection->con_handle)) return err;
     }
@@ -856,6 +967,9 @@ static void acl_handler(uint8_t *packet, uint16_t size){
         return;
     }
 
+    BTSTACK_STATS_HCI_ACL_IN(size);
+    BTSTACK_STATS_TRAFFIC_IN(&conn->stats, size);
+
 #ifdef ENABLE_CLASSIC
     // update idle timestamp
     hci_connection_timestamp(conn);
@@ -1078,6 +1192,114 @@ void gap_le_get_own_address(uint8_t * addr_type, bd_addr_t addr){
 }
 
 #ifdef ENABLE_LE_CENTRAL
+
+#ifdef ENABLE_LE_SCAN_FILTER
+static bool hci_le_scan_filter_manufacturer_data_matches(const gap_le_scan_filter_t * filter, uint8_t data_length, const uint8_t * data){
+    ad_context_t context;
+    for (ad_iterator_init(&context, data_length, data) ; ad_iterator_has_more(&context) ; ad_iterator_next(&context)){
+        if (ad_iterator_get_data_type(&context) != BLUETOOTH_DATA_TYPE_MANUFACTURER_SPECIFIC_DATA) continue;
+        uint8_t ad_len = ad_iterator_get_data_len(&context);
+        const uint8_t * ad_data = ad_iterator_get_data(&context);
+        if (ad_len < (2u + filter->manufacturer_data_prefix_len)) continue;
+        if (little_endian_read_16(ad_data, 0) != filter->manufacturer_id) continue;
+        uint8_t i;
+        for (i = 0; i < filter->manufacturer_data_prefix_len; i++){
+            uint8_t mask = (filter->manufacturer_data_mask != NULL) ? filter->manufacturer_data_mask[i] : 0xffu;
+            if (((ad_data[2u + i] ^ filter->manufacturer_data_prefix[i]) & mask) != 0u) break;
+        }
+        if (i == filter->manufacturer_data_prefix_len) return true;
+    }
+    return false;
+}
+
+static bool hci_le_scan_filter_matches(const gap_le_scan_filter_t * filter, uint8_t address_type, const uint8_t * address,
+                                       int8_t rssi, uint8_t data_length, const uint8_t * data){
+    // cheap checks first
+    if (filter->criteria & GAP_LE_SCAN_FILTER_RSSI){
+        if (rssi < filter->rssi_threshold) return false;
+    }
+    if (filter->criteria & GAP_LE_SCAN_FILTER_ADDRESS){
+        if (address_type != (uint8_t) filter->address_type) return false;
+        if (memcmp(address, filter->address, 6) != 0) return false;
+    }
+    if (filter->criteria & GAP_LE_SCAN_FILTER_SERVICE_UUID16){
+        if (!ad_data_contains_uuid16(data_length, data, filter->service_uuid16)) return false;
+    }
+    if (filter->criteria & GAP_LE_SCAN_FILTER_SERVICE_UUID128){
+        if (!ad_data_contains_uuid128(data_length, data, filter->service_uuid128)) return false;
+    }
+    if (filter->criteria & GAP_LE_SCAN_FILTER_MANUFACTURER_DATA){
+        if (!hci_le_scan_filter_manufacturer_data_matches(filter, data_length, data)) return false;
+    }
+    return true;
+}
+
+// FNV-1a
+static uint32_t hci_le_scan_filter_hash(uint8_t data_length, const uint8_t * data){
+    uint32_t hash = 2166136261u;
+    uint8_t i;
+    for (i = 0; i < data_length; i++){
+        hash ^= data[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static bool hci_le_scan_filter_is_duplicate(uint8_t event_type, uint8_t address_type, const uint8_t * address, uint8_t data_length, const uint8_t * data){
+    if (hci_stack->le_scan_filter_duplicate_window_ms == 0u) return false;
+    uint32_t now = btstack_run_loop_get_time_ms();
+    uint32_t data_hash = hci_le_scan_filter_hash(data_length, data);
+    le_scan_filter_duplicate_t * oldest = &hci_stack->le_scan_filter_duplicates[0];
+    uint16_t i;
+    for (i = 0; i < LE_SCAN_FILTER_DUPLICATE_ENTRIES; i++){
+        le_scan_filter_duplicate_t * entry = &hci_stack->le_scan_filter_duplicates[i];
+        if ((entry->event_type == event_type) && (entry->address_type == address_type) && (memcmp(entry->address, address, 6) == 0)){
+            if ((entry->data_hash == data_hash) && ((now - entry->timestamp_ms) < hci_stack->le_scan_filter_duplicate_window_ms)){
+                return true;
+            }
+            // data changed or window expired
+            entry->data_hash = data_hash;
+            entry->timestamp_ms = now;
+            return false;
+        }
+        if ((int32_t)(entry->timestamp_ms - oldest->timestamp_ms) < 0){
+            oldest = entry;
+        }
+    }
+    // replace least recently forwarded report
+    (void)memcpy(oldest->address, address, 6);
+    oldest->address_type = address_type;
+    oldest->event_type   = event_type;
+    oldest->data_hash    = data_hash;
+    oldest->timestamp_ms = now;
+    return false;
+}
+
+static bool hci_le_scan_filter_accept(uint8_t event_type, uint8_t address_type, const uint8_t * address, int8_t rssi, uint8_t data_length, const uint8_t * data){
+    hci_stack->le_scan_filter_num_reports++;
+    if (hci_stack->le_scan_filters != NULL){
+        bool match = false;
+        btstack_linked_list_iterator_t it;
+        btstack_linked_list_iterator_init(&it, &hci_stack->le_scan_filters);
+        while (btstack_linked_list_iterator_has_next(&it)){
+            gap_le_scan_filter_t * filter = (gap_le_scan_filter_t *) btstack_linked_list_iterator_next(&it);
+            if (!hci_le_scan_filter_matches(filter, address_type, address, rssi, data_length, data)) continue;
+            filter->num_matches++;
+            match = true;
+        }
+        if (!match){
+            hci_stack->le_scan_filter_num_dropped++;
+            return false;
+        }
+    }
+    if (hci_le_scan_filter_is_duplicate(event_type, address_type, address, data_length, data)){
+        hci_stack->le_scan_filter_num_duplicates++;
+        return false;
+    }
+    return true;
+}
+#endif
+
 void le_handle_advertisement_report(uint8_t *packet, uint16_t size){
 
     int offset = 3;
@@ -1092,6 +1314,14 @@ void le_handle_advertisement_report(uint8_t *packet, uint16_t size){
         uint8_t data_length = packet[offset + 8];
         if (data_length > LE_ADVERTISING_DATA_SIZE) return;
         if ((offset + 9u + data_length + 1u) > size)    return;
+#ifdef ENABLE_LE_SCAN_FILTER
+        // evaluate filters before creating event
+        if (!hci_le_scan_filter_accept(packet[offset], packet[offset + 1], &packet[offset + 2], (int8_t) packet[offset + 9 + data_length],
+                                       data_length, &packet[offset + 9])){
+            offset += 9u + data_length + 1u;
+            continue;
+        }
+#endif
         // setup event
         uint8_t event_size = 10u + data_length;
         int pos = 0;
@@ -1109,9 +1339,268 @@ void le_handle_advertisement_report(uint8_t *packet, uint16_t size){
         hci_emit_event(event, pos, 1);
     }
 }
+
+#ifdef ENABLE_LE_EXTENDED_ADVERTISING
+// LE Extended Advertising Report: event type (2), address type (1), address (6), primary phy (1), secondary phy (1),
+// sid (1), tx power (1), rssi (1), periodic advertising interval (2), direct address type (1), direct address (6),
+// data length (1), data
+#define LE_EXTENDED_ADVERTISING_REPORT_FIXED_SIZE 24
+
+#define LE_EXTENDED_ADVERTISING_EVENT_TYPE_LEGACY            0x0010u
+#define LE_EXTENDED_ADVERTISING_EVENT_TYPE_DATA_STATUS_MASK  0x0060u
+#define LE_EXTENDED_ADVERTISING_DATA_STATUS_COMPLETE         0u
+#define LE_EXTENDED_ADVERTISING_DATA_STATUS_INCOMPLETE       1u
+#define LE_EXTENDED_ADVERTISING_DATA_STATUS_TRUNCATED        2u
+
+// forward legacy PDU as LE Advertising Report to share scan filter and GAP_EVENT_ADVERTISING_REPORT creation
+static void le_handle_extended_advertisement_legacy_report(const uint8_t * report){
+    uint8_t event_type;
+    switch (little_endian_read_16(report, 0) & 0x1fu){
+        case 0x13:  // ADV_IND
+            event_type = 0;
+            break;
+        case 0x15:  // ADV_DIRECT_IND
+            event_type = 1;
+            break;
+        case 0x12:  // ADV_SCAN_IND
+            event_type = 2;
+            break;
+        case 0x10:  // ADV_NONCONN_IND
+            event_type = 3;
+            break;
+        case 0x1a:  // SCAN_RSP to ADV_SCAN_IND
+        case 0x1b:  // SCAN_RSP to ADV_IND
+            event_type = 4;
+            break;
+        default:
+            return;
+    }
+    uint8_t data_length = report[23];
+    if (data_length > LE_ADVERTISING_DATA_SIZE) return;
+    uint8_t packet[14 + LE_ADVERTISING_DATA_SIZE];
+    packet[0] = HCI_EVENT_LE_META;
+    packet[1] = 12u + data_length;
+    packet[2] = HCI_SUBEVENT_LE_ADVERTISING_REPORT;
+    packet[3] = 1;
+    packet[4] = event_type;
+    (void)memcpy(&packet[5], &report[2], 1 + 6);   // address type + address
+    packet[12] = data_length;
+    (void)memcpy(&packet[13], &report[24], data_length);
+    packet[13u + data_length] = report[13];         // rssi
+    le_handle_advertisement_report(packet, 14u + data_length);
+}
+
+static void le_extended_advertising_report_setup_event(uint8_t * event, const uint8_t * report){
+    event[0] = GAP_EVENT_EXTENDED_ADVERTISING_REPORT;
+    little_endian_store_16(event, 2, little_endian_read_16(report, 0) & ~LE_EXTENDED_ADVERTISING_EVENT_TYPE_DATA_STATUS_MASK);
+    // address type .. direct address
+    (void)memcpy(&event[4], &report[2], 21);
+    little_endian_store_16(event, 25, 0);
+}
+
+static void le_extended_advertising_report_emit(uint8_t * event, uint8_t data_status){
+    uint16_t data_length = little_endian_read_16(event, 25);
+    uint16_t event_type  = little_endian_read_16(event, 2);
+    uint16_t offset = 0;
+    // event length field is only 8 bit, split long reports with data status 'incomplete, more data to come'
+    while (true){
+        uint16_t fragment_len = btstack_min(data_length - offset, LE_EXTENDED_ADVERTISING_REPORT_MAX_FRAGMENT_LEN);
+        bool last_fragment = (offset + fragment_len) == data_length;
+        uint8_t fragment_status = last_fragment ? data_status : LE_EXTENDED_ADVERTISING_DATA_STATUS_INCOMPLETE;
+        uint8_t * fragment = &event[offset];
+        little_endian_store_16(fragment, 2, event_type | (uint16_t) (fragment_status << 5));
+        little_endian_store_16(fragment, 25, fragment_len);
+        fragment[1] = (uint8_t) (LE_EXTENDED_ADVERTISING_REPORT_HEADER_SIZE - 2u + fragment_len);
+        hci_emit_event(fragment, LE_EXTENDED_ADVERTISING_REPORT_HEADER_SIZE + fragment_len, 1);
+        if (last_fragment) break;
+        // move header in front of next fragment, overwriting data that has been emitted
+        offset += fragment_len;
+        (void)memmove(&event[offset], fragment, LE_EXTENDED_ADVERTISING_REPORT_HEADER_SIZE);
+    }
+}
+
+static bool le_extended_advertising_reassembly_matches(const le_extended_advertising_reassembly_t * reassembly, const uint8_t * report){
+    if (!reassembly->active) return false;
+    // event type (w/o data status), address type + address, sid
+    uint16_t event_type = little_endian_read_16(report, 0) & ~LE_EXTENDED_ADVERTISING_EVENT_TYPE_DATA_STATUS_MASK;
+    if (little_endian_read_16(reassembly->event, 2) != event_type) return false;
+    if (memcmp(&reassembly->event[4], &report[2], 7) != 0) return false;
+    return reassembly->event[13] == report[11];
+}
+
+static le_extended_advertising_reassembly_t * le_extended_advertising_reassembly_for_report(const uint8_t * report){
+    uint8_t i;
+    for (i = 0; i < LE_EXTENDED_ADVERTISING_REASSEMBLY_BUFFERS; i++){
+        if (le_extended_advertising_reassembly_matches(&hci_stack->le_extended_advertising_reassembly[i], report)){
+            return &hci_stack->le_extended_advertising_reassembly[i];
+        }
+    }
+    return NULL;
+}
+
+static le_extended_advertising_reassembly_t * le_extended_advertising_reassembly_allocate(void){
+    le_extended_advertising_reassembly_t * oldest = &hci_stack->le_extended_advertising_reassembly[0];
+    uint8_t i;
+    for (i = 0; i < LE_EXTENDED_ADVERTISING_REASSEMBLY_BUFFERS; i++){
+        le_extended_advertising_reassembly_t * reassembly = &hci_stack->le_extended_advertising_reassembly[i];
+        if (!reassembly->active) return reassembly;
+        if ((int32_t)(reassembly->sequence_nr - oldest->sequence_nr) < 0){
+            oldest = reassembly;
+        }
+    }
+    // all in use: forward oldest as truncated
+    log_info("Extended advertising reassembly full, truncate oldest");
+    le_extended_advertising_report_emit(oldest->event, LE_EXTENDED_ADVERTISING_DATA_STATUS_TRUNCATED);
+    oldest->active = false;
+    return oldest;
+}
+
+void le_handle_extended_advertisement_report(uint8_t * packet, uint16_t size){
+    uint8_t num_reports = packet[3];
+    uint16_t offset = 4;
+    uint8_t i;
+    for (i = 0; i < num_reports; i++){
+        if ((offset + LE_EXTENDED_ADVERTISING_REPORT_FIXED_SIZE) > size) return;
+        const uint8_t * report = &packet[offset];
+        uint8_t data_length = report[23];
+        if ((offset + LE_EXTENDED_ADVERTISING_REPORT_FIXED_SIZE + data_length) > size) return;
+        offset += LE_EXTENDED_ADVERTISING_REPORT_FIXED_SIZE + data_length;
+
+        uint16_t event_type = little_endian_read_16(report, 0);
+        if ((event_type & LE_EXTENDED_ADVERTISING_EVENT_TYPE_LEGACY) != 0u){
+            le_handle_extended_advertisement_legacy_report(report);
+            continue;
+        }
+
+        uint8_t data_status = (uint8_t) ((event_type & LE_EXTENDED_ADVERTISING_EVENT_TYPE_DATA_STATUS_MASK) >> 5);
+        le_extended_advertising_reassembly_t * reassembly = le_extended_advertising_reassembly_for_report(report);
+        if (reassembly == NULL){
+            if (data_status == LE_EXTENDED_ADVERTISING_DATA_STATUS_COMPLETE){
+                // not chained, emit without reassembly buffer
+                uint8_t event[LE_EXTENDED_ADVERTISING_REPORT_HEADER_SIZE + 255];
+                le_extended_advertising_report_setup_event(event, report);
+                little_endian_store_16(event, 25, data_length);
+                (void)memcpy(&event[LE_EXTENDED_ADVERTISING_REPORT_HEADER_SIZE], &report[24], data_length);
+                le_extended_advertising_report_emit(event, data_status);
+                continue;
+            }
+            reassembly = le_extended_advertising_reassembly_allocate();
+            reassembly->active = true;
+            reassembly->sequence_nr = hci_stack->le_extended_advertising_reassembly_sequence_nr++;
+            le_extended_advertising_report_setup_event(reassembly->event, report);
+        }
+
+        // append fragment, rssi and tx power are taken from the last one
+        uint16_t reassembly_len = little_endian_read_16(reassembly->event, 25);
+        uint16_t fragment_len = btstack_min(data_length, LE_EXTENDED_ADVERTISING_MAX_DATA_LEN - reassembly_len);
+        (void)memcpy(&reassembly->event[LE_EXTENDED_ADVERTISING_REPORT_HEADER_SIZE + reassembly_len], &report[24], fragment_len);
+        reassembly_len += fragment_len;
+        little_endian_store_16(reassembly->event, 25, reassembly_len);
+        reassembly->event[14] = report[12];
+        reassembly->event[15] = report[13];
+        if (fragment_len < data_length){
+            data_status = LE_EXTENDED_ADVERTISING_DATA_STATUS_TRUNCATED;
+        }
+        if (data_status == LE_EXTENDED_ADVERTISING_DATA_STATUS_INCOMPLETE) continue;
+
+        le_extended_advertising_report_emit(reassembly->event, data_status);
+        reassembly->active = false;
+    }
+}
+#endif
 #endif
 #endif
 
+#ifdef ENABLE_BLE
+// Legacy and extended advertising/scanning/initiating commands cannot be mixed, use extended ones if supported
+static bool hci_le_extended_advertising_supported(void){
+#ifdef ENABLE_LE_EXTENDED_ADVERTISING
+    // LE Set Extended Advertising Parameters, LE Set Extended Scan Parameters, LE Extended Create Connection
+    return (hci_stack->local_supported_commands[1] & 0x38u) == 0x38u;
+#else
+    return false;
+#endif
+}
+#endif
+
+#ifdef ENABLE_LE_CENTRAL
+static void hci_send_le_scan_parameters(void){
+#ifdef ENABLE_LE_EXTENDED_ADVERTISING
+    if (hci_le_extended_advertising_supported()){
+        // same parameters for all scanning PHYs
+        uint8_t  scan_types[2];
+        uint16_t scan_intervals[2];
+        uint16_t scan_windows[2];
+        uint8_t i;
+        for (i = 0; i < 2; i++){
+            scan_types[i]     = hci_stack->le_scan_type;
+            scan_intervals[i] = hci_stack->le_scan_interval;
+            scan_windows[i]   = hci_stack->le_scan_window;
+        }
+        hci_send_cmd(&hci_le_set_extended_scan_parameters, hci_stack->le_own_addr_type, hci_stack->le_scan_filter_policy,
+                     hci_stack->le_scan_phys, scan_types, scan_intervals, scan_windows);
+        return;
+    }
+#endif
+    hci_send_cmd(&hci_le_set_scan_parameters, hci_stack->le_scan_type, hci_stack->le_scan_interval, hci_stack->le_scan_window,
+                 hci_stack->le_own_addr_type, hci_stack->le_scan_filter_policy);
+}
+
+static void hci_send_le_scan_enable(uint8_t enable){
+    if (hci_le_extended_advertising_supported()){
+        hci_send_cmd(&hci_le_set_extended_scan_enable, enable, 0, 0, 0);
+    } else {
+        hci_send_cmd(&hci_le_set_scan_enable, enable, 0);
+    }
+}
+
+static void hci_send_le_create_connection(uint8_t initiator_filter_policy, bd_addr_type_t peer_address_type, const uint8_t * peer_address){
+#ifdef ENABLE_LE_EXTENDED_ADVERTISING
+    if (hci_le_extended_advertising_supported()){
+        // same parameters for all initiating PHYs
+        uint16_t scan_intervals[3];
+        uint16_t scan_windows[3];
+        uint16_t connection_intervals_min[3];
+        uint16_t connection_intervals_max[3];
+        uint16_t connection_latencies[3];
+        uint16_t supervision_timeouts[3];
+        uint16_t minimum_ce_lengths[3];
+        uint16_t maximum_ce_lengths[3];
+        uint8_t i;
+        for (i = 0; i < 3; i++){
+            scan_intervals[i]           = hci_stack->le_connection_scan_interval;
+            scan_windows[i]             = hci_stack->le_connection_scan_window;
+            connection_intervals_min[i] = hci_stack->le_connection_interval_min;
+            connection_intervals_max[i] = hci_stack->le_connection_interval_max;
+            connection_latencies[i]     = hci_stack->le_connection_latency;
+            supervision_timeouts[i]     = hci_stack->le_supervision_timeout;
+            minimum_ce_lengths[i]       = hci_stack->le_minimum_ce_length;
+            maximum_ce_lengths[i]       = hci_stack->le_maximum_ce_length;
+        }
+        hci_send_cmd(&hci_le_extended_create_connection, initiator_filter_policy, hci_stack->le_own_addr_type,
+                     peer_address_type, peer_address, hci_stack->le_scan_phys, scan_intervals, scan_windows,
+                     connection_intervals_min, connection_intervals_max, connection_latencies, supervision_timeouts,
+                     minimum_ce_lengths, maximum_ce_lengths);
+        return;
+    }
+#endif
+    hci_send_cmd(&hci_le_create_connection,
+                 hci_stack->le_connection_scan_interval,    // conn scan interval
+                 hci_stack->le_connection_scan_window,      // conn scan windows
+                 initiator_filter_policy,                   // use whitelist
+                 peer_address_type,                         // peer address type
+                 peer_address,                              // peer bd addr
+                 hci_stack->le_own_addr_type,               // our addr type:
+                 hci_stack->le_connection_interval_min,     // conn interval min
+                 hci_stack->le_connection_interval_max,     // conn interval max
+                 hci_stack->le_connection_latency,          // conn latency
+                 hci_stack->le_supervision_timeout,         // conn latency
+                 hci_stack->le_minimum_ce_length,           // min ce length
+                 hci_stack->le_maximum_ce_length            // max ce length
+    );
+}
+#endif
+
 #ifdef ENABLE_BLE
 #ifdef ENABLE_LE_PERIPHERAL
 static void hci_update_advertisements_enabled_for_current_roles(void){
@@ -1134,6 +1623,76 @@ static void hci_update_advertisements_enabled_for_current_roles(void){
         hci_stack->le_advertisements_enabled_for_current_roles = false;
     }
 }
+
+#ifdef ENABLE_LE_EXTENDED_ADVERTISING
+static le_advertising_set_t * hci_advertising_set_for_handle(uint8_t advertising_handle){
+    btstack_linked_list_iterator_t it;
+    btstack_linked_list_iterator_init(&it, &hci_stack->le_advertising_sets);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        le_advertising_set_t * advertising_set = (le_advertising_set_t *) btstack_linked_list_iterator_next(&it);
+        if (advertising_set->advertising_handle == advertising_handle) return advertising_set;
+    }
+    return NULL;
+}
+
+static void hci_handle_le_advertising_set_terminated(uint8_t advertising_handle){
+    if (advertising_handle == 0u){
+        // legacy advertising, see connection complete
+        hci_stack->le_advertisements_active = false;
+        return;
+    }
+    le_advertising_set_t * advertising_set = hci_advertising_set_for_handle(advertising_handle);
+    if (advertising_set == NULL) return;
+    // connection, timeout or max events reached
+    advertising_set->state &= ~(LE_ADVERTISEMENT_STATE_ACTIVE | LE_ADVERTISEMENT_STATE_ENABLED);
+}
+
+// advertising sets have their own random address
+static void hci_le_advertising_sets_update_random_address(void){
+    if (!hci_le_extended_advertising_supported()) return;
+    if (hci_stack->le_advertisements_legacy_set_configured && ((hci_stack->le_own_addr_type & 1u) != 0u)){
+        hci_stack->le_advertisements_todo |= LE_ADVERTISEMENT_TASKS_SET_ADDRESS;
+    }
+    btstack_linked_list_iterator_t it;
+    btstack_linked_list_iterator_init(&it, &hci_stack->le_advertising_sets);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        le_advertising_set_t * advertising_set = (le_advertising_set_t *) btstack_linked_list_iterator_next(&it);
+        if (((uint8_t) advertising_set->extended_params.own_address_type & 1u) == 0u) continue;
+        advertising_set->tasks |= LE_ADVERTISEMENT_TASKS_SET_ADDRESS;
+    }
+}
+
+// advertising sets are lost on power off, configure them again
+static void hci_le_advertising_sets_reset(void){
+    hci_stack->le_advertisements_legacy_set_configured = false;
+    btstack_linked_list_iterator_t it;
+    btstack_linked_list_iterator_init(&it, &hci_stack->le_advertising_sets);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        le_advertising_set_t * advertising_set = (le_advertising_set_t *) btstack_linked_list_iterator_next(&it);
+        if (advertising_set->tasks & LE_ADVERTISEMENT_TASKS_REMOVE_SET){
+            btstack_linked_list_iterator_remove(&it);
+            continue;
+        }
+        advertising_set->state &= ~(LE_ADVERTISEMENT_STATE_ACTIVE | LE_ADVERTISEMENT_STATE_PERIODIC_ACTIVE);
+        advertising_set->tasks = LE_ADVERTISEMENT_TASKS_SET_PARAMS;
+        advertising_set->adv_data_pos = 0;
+        advertising_set->scan_data_pos = 0;
+        advertising_set->periodic_data_pos = 0;
+        if (advertising_set->adv_data_len > 0u){
+            advertising_set->tasks |= LE_ADVERTISEMENT_TASKS_SET_ADV_DATA;
+        }
+        if (advertising_set->scan_data_len > 0u){
+            advertising_set->tasks |= LE_ADVERTISEMENT_TASKS_SET_SCAN_DATA;
+        }
+        if (advertising_set->periodic_params.periodic_advertising_interval_min > 0u){
+            advertising_set->tasks |= LE_ADVERTISEMENT_TASKS_SET_PERIODIC_PARAMS;
+            if (advertising_set->periodic_data_len > 0u){
+                advertising_set->tasks |= LE_ADVERTISEMENT_TASKS_SET_PERIODIC_DATA;
+            }
+        }
+    }
+}
+#endif
 #endif
 #endif
 
@@ -1149,7 +1708,7 @@ static uint32_t hci_transport_uart_get_main_baud_rate(void){
     return baud_rate;
 }
 
-static void hci_initialization_timeout_handler(btstack_timer_source_t * ds){
+static void hci_initialization_timeout_process(btstack_timer_source_t * ds){
     UNUSED(ds);
 
     switch (hci_stack->substate){
@@ -1198,15 +1757,300 @@ static void hci_initialization_timeout_handler(btstack_timer_source_t * ds){
             break;
     }
 }
+
+static void hci_initialization_timeout_handler(btstack_timer_source_t * ts){
+    hci_instance_process_timer(ts, &hci_initialization_timeout_process);
+}
 #endif
 
 static void hci_initializing_next_state(void){
     hci_stack->substate = (hci_substate_t )( ((int) hci_stack->substate) + 1);
 }
 
+// HCI Init Timing
+
+static void hci_init_phase_start(void){
+    hci_stack->init_phase = HCI_INIT_PHASE_RESET;
+    hci_stack->init_phase_start_ms = btstack_run_loop_get_time_ms();
+    memset(hci_stack->init_phase_duration_ms, 0, sizeof(hci_stack->init_phase_duration_ms));
+    hci_stack->init_script_num_commands = 0;
+    hci_stack->init_script_num_bytes = 0;
+}
+
+static void hci_init_phase_complete(void){
+    uint32_t now = btstack_run_loop_get_time_ms();
+    hci_stack->init_phase_duration_ms[hci_stack->init_phase] = now - hci_stack->init_phase_start_ms;
+    hci_stack->init_phase_start_ms = now;
+}
+
+static void hci_init_phase_enter(hci_init_phase_t phase){
+    if (phase <= hci_stack->init_phase) return;
+    hci_init_phase_complete();
+    hci_stack->init_phase = phase;
+}
+
+#ifdef ENABLE_HCI_INIT_PIPELINING
+// HCI Init Pipelining
+//
+// Commands after Read BD_ADDR only depend on results that have been read before,
+// so they are sent back-to-back as long as the Controller provides command credits
+
+static bool hci_initializing_pipelined(void){
+    return (hci_stack->substate > HCI_INIT_W4_READ_BD_ADDR) && (hci_stack->substate < HCI_INIT_DONE);
+}
+
+static bool hci_initializing_pipeline_blocked(void){
+    if (hci_stack->init_pipeline_outstanding == 0u) return false;
+    if (hci_stack->init_pipeline_outstanding >= HCI_INIT_PIPELINE_DEPTH) return true;
+    // wait for all outstanding commands if next command depends on their results
+    switch (hci_stack->substate){
+        case HCI_INIT_SET_EVENT_MASK:                   // uses local supported features
+#ifdef ENABLE_LE_DATA_LENGTH_EXTENSION
+        case HCI_INIT_LE_WRITE_SUGGESTED_DATA_LENGTH:   // uses result of LE Read Maximum Data Length
+#endif
+            return true;
+        default:
+            return false;
+    }
+}
+
+static void hci_initializing_pipeline_event_handler(const uint8_t * packet){
+    uint16_t opcode;
+    switch (hci_event_packet_get_type(packet)){
+        case HCI_EVENT_COMMAND_COMPLETE:
+            opcode = hci_event_command_complete_get_command_opcode(packet);
+            break;
+        case HCI_EVENT_COMMAND_STATUS:
+            // command is only completed by command status on error
+            if (hci_event_command_status_get_status(packet) == ERROR_CODE_SUCCESS) return;
+            opcode = hci_event_command_status_get_command_opcode(packet);
+            break;
+        default:
+            return;
+    }
+
+    uint8_t i;
+    for (i = 0; i < hci_stack->init_pipeline_outstanding; i++){
+        if (hci_stack->init_pipeline_opcodes[i] != opcode) continue;
+        hci_stack->init_pipeline_outstanding--;
+        (void)memmove(&hci_stack->init_pipeline_opcodes[i], &hci_stack->init_pipeline_opcodes[i+1],
+                      (hci_stack->init_pipeline_outstanding - i) * sizeof(uint16_t));
+        log_debug("Command complete for opcode %04x, %u outstanding", opcode, hci_stack->init_pipeline_outstanding);
+        if ((hci_stack->init_pipeline_outstanding == 0u) && (hci_stack->substate == HCI_INIT_DONE)){
+            hci_init_done();
+        }
+        // continue init script upload
+        if ((hci_stack->substate == HCI_INIT_W4_CUSTOM_INIT)
+        && ((hci_stack->init_script_result_pending == false) || (hci_stack->init_pipeline_outstanding == 0u))){
+            hci_stack->substate = HCI_INIT_CUSTOM_INIT;
+        }
+        return;
+    }
+    log_info("Command complete for unexpected opcode %04x during pipelined init", opcode);
+}
+
+static uint8_t hci_initializing_init_script_pipeline_depth(void){
+    if (hci_stack->chipset == NULL) return 0;
+    return btstack_min(hci_stack->chipset->init_script_pipeline_depth, HCI_INIT_PIPELINE_DEPTH);
+}
+
+static bool hci_initializing_init_script_pipelined(void){
+    if ((hci_stack->substate != HCI_INIT_CUSTOM_INIT) && (hci_stack->substate != HCI_INIT_W4_CUSTOM_INIT)) return false;
+    return hci_initializing_init_script_pipeline_depth() > 1u;
+}
+
+// send prepared init script command and stay in HCI_INIT_CUSTOM_INIT while depth and credits allow
+static void hci_initializing_send_init_script_command_pipelined(uint16_t size){
+    hci_stack->init_pipeline_opcodes[hci_stack->init_pipeline_outstanding++] = hci_stack->last_cmd_opcode;
+    if (hci_stack->init_pipeline_outstanding < hci_initializing_init_script_pipeline_depth()){
+        hci_stack->substate = HCI_INIT_CUSTOM_INIT;
+    }
+    hci_reserve_packet_buffer();
+    int err = hci_send_cmd_packet(hci_stack->hci_packet_buffer, size);
+    // release packet buffer on error or for synchronous transport implementations
+    if ((err < 0) || hci_transport_synchronous()){
+        hci_release_packet_buffer();
+        hci_emit_transport_packet_sent();
+    }
+}
+#endif
+
+static void hci_initializing_next_init_script_command(void){
+#ifdef ENABLE_HCI_INIT_PIPELINING
+    // result has been kept while waiting for outstanding init script commands
+    if (hci_stack->init_script_result_pending){
+        hci_stack->init_script_result_pending = false;
+        return;
+    }
+#endif
+    hci_stack->chipset_result = (*hci_stack->chipset->next_command)(hci_stack->hci_packet_buffer);
+}
+
+#ifdef ENABLE_HCI_CAPABILITIES_CACHE
+// HCI Capabilities Cache
+//
+// Results of read-only capability commands are stored in TLV and replayed on warm restarts
+// for the same Controller, identified by its Local Version Information and BD_ADDR
+
+#define HCI_CAPABILITIES_CACHE_TAG (((uint32_t) 'B' << 24u) | ((uint32_t) 'T' << 16u) | ((uint32_t) 'H' << 8u) | 'C')
+
+static uint16_t hci_capabilities_cache_opcode_for_substate(hci_substate_t substate){
+    switch (substate){
+        case HCI_INIT_READ_BUFFER_SIZE:
+            return HCI_OPCODE_HCI_READ_BUFFER_SIZE;
+        case HCI_INIT_READ_LOCAL_SUPPORTED_FEATURES:
+            return HCI_OPCODE_HCI_READ_LOCAL_SUPPORTED_FEATURES;
+#ifdef ENABLE_BLE
+        case HCI_INIT_LE_READ_BUFFER_SIZE:
+            return HCI_OPCODE_HCI_LE_READ_BUFFER_SIZE;
+#endif
+#ifdef ENABLE_LE_DATA_LENGTH_EXTENSION
+        case HCI_INIT_LE_READ_MAX_DATA_LENGTH:
+            return HCI_OPCODE_HCI_LE_READ_MAXIMUM_DATA_LENGTH;
+#endif
+#ifdef ENABLE_LE_CENTRAL
+        case HCI_INIT_READ_WHITE_LIST_SIZE:
+            return HCI_OPCODE_HCI_LE_READ_WHITE_LIST_SIZE;
+#endif
+        default:
+            return 0;
+    }
+}
+
+static bool hci_capabilities_cache_opcode_cached(uint16_t opcode){
+    switch (opcode){
+        case HCI_OPCODE_HCI_READ_BUFFER_SIZE:
+        case HCI_OPCODE_HCI_READ_LOCAL_SUPPORTED_FEATURES:
+        case HCI_OPCODE_HCI_LE_READ_BUFFER_SIZE:
+        case HCI_OPCODE_HCI_LE_READ_MAXIMUM_DATA_LENGTH:
+        case HCI_OPCODE_HCI_LE_READ_WHITE_LIST_SIZE:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// returns offset of entry for opcode or -1
+static int hci_capabilities_cache_find(uint16_t opcode){
+    const hci_capabilities_cache_t * cache = &hci_stack->capabilities_cache;
+    uint16_t pos = 0;
+    while ((pos + 3u) <= cache->data_len){
+        if (little_endian_read_16(cache->data, pos) == opcode) return pos;
+        pos += 3u + cache->data[pos + 2u];
+    }
+    return -1;
+}
+
+static void hci_capabilities_cache_record(const uint8_t * packet){
+    if (hci_stack->capabilities_cache_hit) return;
+    if (hci_event_packet_get_type(packet) != HCI_EVENT_COMMAND_COMPLETE) return;
+    uint16_t opcode = hci_event_command_complete_get_command_opcode(packet);
+    if (!hci_capabilities_cache_opcode_cached(opcode)) return;
+    if (packet[OFFSET_OF_DATA_IN_COMMAND_COMPLETE] != ERROR_CODE_SUCCESS) return;
+    if (hci_capabilities_cache_find(opcode) >= 0) return;
+
+    hci_capabilities_cache_t * cache = &hci_stack->capabilities_cache;
+    uint8_t params_len = packet[1] - 3u;
+    if ((cache->data_len + 3u + params_len) > HCI_CAPABILITIES_CACHE_DATA_LEN) return;
+    little_endian_store_16(cache->data, cache->data_len, opcode);
+    cache->data[cache->data_len + 2u] = params_len;
+    (void)memcpy(&cache->data[cache->data_len + 3u], &packet[OFFSET_OF_DATA_IN_COMMAND_COMPLETE], params_len);
+    cache->data_len += 3u + params_len;
+}
+
+static void hci_capabilities_cache_replay(void){
+    const hci_capabilities_cache_t * cache = &hci_stack->capabilities_cache;
+    uint8_t event[OFFSET_OF_DATA_IN_COMMAND_COMPLETE + HCI_CAPABILITIES_CACHE_DATA_LEN];
+    uint16_t pos = 0;
+    while ((pos + 3u) <= cache->data_len){
+        uint8_t params_len = cache->data[pos + 2u];
+        if ((pos + 3u + params_len) > cache->data_len) break;
+        // process stored result as Command Complete, keeping current command credits
+        event[0] = HCI_EVENT_COMMAND_COMPLETE;
+        event[1] = 3u + params_len;
+        event[2] = hci_stack->num_cmd_packets;
+        little_endian_store_16(event, 3, little_endian_read_16(cache->data, pos));
+        (void)memcpy(&event[OFFSET_OF_DATA_IN_COMMAND_COMPLETE], &cache->data[pos + 3u], params_len);
+        handle_command_complete_event(event, OFFSET_OF_DATA_IN_COMMAND_COMPLETE + params_len);
+        pos += 3u + params_len;
+    }
+}
+
+// called after Read BD_ADDR completed
+static void hci_capabilities_cache_load(void){
+    hci_capabilities_cache_t * cache = &hci_stack->capabilities_cache;
+    hci_stack->capabilities_cache_hit = false;
+    (void)memcpy(cache->local_bd_addr, hci_stack->local_bd_addr, 6);
+    cache->data_len = 0;
+
+    // get btstack_tlv
+    const btstack_tlv_t * tlv_impl = NULL;
+    void * tlv_context;
+    btstack_tlv_get_instance(&tlv_impl, &tlv_context);
+    if (!tlv_impl) return;
+
+    hci_capabilities_cache_t stored;
+    int len = tlv_impl->get_tag(tlv_context, HCI_CAPABILITIES_CACHE_TAG, (uint8_t *) &stored, sizeof(stored));
+
+    // validate size and key
+    bool valid = (len >= (int) offsetof(hci_capabilities_cache_t, data))
+              && (stored.data_len <= HCI_CAPABILITIES_CACHE_DATA_LEN)
+              && (len == (int) (offsetof(hci_capabilities_cache_t, data) + stored.data_len))
+              && (memcmp(stored.local_version_information, cache->local_version_information, sizeof(cache->local_version_information)) == 0)
+              && (bd_addr_cmp(stored.local_bd_addr, cache->local_bd_addr) == 0);
+    if (!valid){
+        log_info("Capabilities cache: no valid entry for %s", bd_addr_to_str(cache->local_bd_addr));
+        return;
+    }
+
+    log_info("Capabilities cache: restore %u bytes", stored.data_len);
+    (void)memcpy(cache, &stored, sizeof(hci_capabilities_cache_t));
+    hci_stack->capabilities_cache_hit = true;
+    hci_capabilities_cache_replay();
+}
+
+static void hci_capabilities_cache_store(void){
+    if (hci_stack->capabilities_cache_hit) return;
+    const hci_capabilities_cache_t * cache = &hci_stack->capabilities_cache;
+    if (cache->data_len == 0u) return;
+
+    // get btstack_tlv
+    const btstack_tlv_t * tlv_impl = NULL;
+    void * tlv_context;
+    btstack_tlv_get_instance(&tlv_impl, &tlv_context);
+    if (!tlv_impl) return;
+
+    int result = tlv_impl->store_tag(tlv_context, HCI_CAPABILITIES_CACHE_TAG, (const uint8_t *) cache,
+                                     offsetof(hci_capabilities_cache_t, data) + cache->data_len);
+    if (result != 0){
+        log_error("Capabilities cache: store failed");
+    }
+}
+
+// skip command if its result has been restored from cache
+static bool hci_capabilities_cache_skip_command(void){
+    if (!hci_stack->capabilities_cache_hit) return false;
+    uint16_t opcode = hci_capabilities_cache_opcode_for_substate(hci_stack->substate);
+    if (opcode == 0u) return false;
+    if (hci_capabilities_cache_find(opcode) < 0) return false;
+    log_debug("Capabilities cache: skip opcode %04x", opcode);
+    // W4 state follows send state
+    hci_initializing_next_state();
+    return true;
+}
+#endif
+
 // assumption: hci_can_send_command_packet_now() == true
 static void hci_initializing_run(void){
     log_debug("hci_initializing_run: substate %u, can send %u", hci_stack->substate, hci_can_send_command_packet_now());
+#ifdef ENABLE_HCI_CAPABILITIES_CACHE
+    while (hci_capabilities_cache_skip_command()){
+        hci_initializing_transition();
+    }
+#endif
+#ifdef ENABLE_HCI_INIT_PIPELINING
+    if (hci_initializing_pipeline_blocked()) return;
+#endif
     switch (hci_stack->substate){
         case HCI_INIT_SEND_RESET:
             hci_state_reset();
@@ -1222,6 +2066,7 @@ static void hci_initializing_run(void){
             hci_send_cmd(&hci_reset);
             break;
         case HCI_INIT_SEND_READ_LOCAL_VERSION_INFORMATION:
+            hci_init_phase_enter(HCI_INIT_PHASE_CHIPSET);
             hci_send_cmd(&hci_read_local_version_information);
             hci_stack->substate = HCI_INIT_W4_SEND_READ_LOCAL_VERSION_INFORMATION;
             break;
@@ -1271,7 +2116,15 @@ static void hci_initializing_run(void){
         case HCI_INIT_CUSTOM_INIT:
             // Custom initialization
             if (hci_stack->chipset && hci_stack->chipset->next_command){
-                hci_stack->chipset_result = (*hci_stack->chipset->next_command)(hci_stack->hci_packet_buffer);
+                hci_initializing_next_init_script_command();
+#ifdef ENABLE_HCI_INIT_PIPELINING
+                if ((hci_stack->chipset_result != BTSTACK_CHIPSET_VALID_COMMAND) && (hci_stack->init_pipeline_outstanding > 0u)){
+                    // wait for Command Complete of outstanding commands before acting on result
+                    hci_stack->init_script_result_pending = true;
+                    hci_stack->substate = HCI_INIT_W4_CUSTOM_INIT;
+                    return;
+                }
+#endif
                 int send_cmd = 0;
                 switch (hci_stack->chipset_result){
                     case BTSTACK_CHIPSET_VALID_COMMAND:
@@ -1303,11 +2156,31 @@ static void hci_initializing_run(void){
                 if (send_cmd){
                     int size = 3u + hci_stack->hci_packet_buffer[2u];
                     hci_stack->last_cmd_opcode = little_endian_read_16(hci_stack->hci_packet_buffer, 0);
+                    if (hci_stack->init_script_num_commands == 0u){
+                        hci_stack->init_script_start_ms = btstack_run_loop_get_time_ms();
+                    }
+                    hci_stack->init_script_num_commands++;
+                    hci_stack->init_script_num_bytes += size;
+#ifdef ENABLE_HCI_INIT_PIPELINING
+                    if ((hci_stack->chipset_result == BTSTACK_CHIPSET_VALID_COMMAND) && hci_initializing_init_script_pipelined()){
+                        hci_initializing_send_init_script_command_pipelined(size);
+                        if ((hci_stack->substate == HCI_INIT_CUSTOM_INIT) && hci_can_send_command_packet_now()){
+                            hci_initializing_run();
+                        }
+                        return;
+                    }
+#endif
+                    BTSTACK_STATS_INCREMENT(HCI_COMMANDS_SENT);
                     hci_dump_packet(HCI_COMMAND_DATA_PACKET, 0, hci_stack->hci_packet_buffer, size);
                     hci_stack->hci_transport->send_packet(HCI_COMMAND_DATA_PACKET, hci_stack->hci_packet_buffer, size);
                     break;
                 }
                 log_info("Init script done");
+                if (hci_stack->init_script_num_commands > 0u){
+                    log_info("%s: init script upload: %u commands, %u bytes in %u ms", hci_stack->chipset->name,
+                             hci_stack->init_script_num_commands, (unsigned int) hci_stack->init_script_num_bytes,
+                             (unsigned int) (btstack_run_loop_get_time_ms() - hci_stack->init_script_start_ms));
+                }
 
                 // Init script download on Broadcom chipsets causes:
                 if ( (hci_stack->chipset_result != BTSTACK_CHIPSET_NO_INIT_SCRIPT) &&
@@ -1351,11 +2224,13 @@ static void hci_initializing_run(void){
 #endif
 
         case HCI_INIT_READ_LOCAL_SUPPORTED_COMMANDS:
+            hci_init_phase_enter(HCI_INIT_PHASE_CHIPSET);
             log_info("Resend hci_read_local_supported_commands after CSR Warm Boot double reset");
             hci_stack->substate = HCI_INIT_W4_READ_LOCAL_SUPPORTED_COMMANDS;
             hci_send_cmd(&hci_read_local_supported_commands);
             break;       
         case HCI_INIT_READ_BD_ADDR:
+            hci_init_phase_enter(HCI_INIT_PHASE_CAPABILITIES);
             hci_stack->substate = HCI_INIT_W4_READ_BD_ADDR;
             hci_send_cmd(&hci_read_bd_addr);
             break;
@@ -1381,6 +2256,7 @@ static void hci_initializing_run(void){
 #endif
 
         case HCI_INIT_SET_EVENT_MASK:
+            hci_init_phase_enter(HCI_INIT_PHASE_CONFIGURATION);
             hci_stack->substate = HCI_INIT_W4_SET_EVENT_MASK;
             if (hci_le_supported()){
                 hci_send_cmd(&hci_set_event_mask,0xffffffff, 0x3FFFFFFF);
@@ -1506,7 +2382,11 @@ static void hci_initializing_run(void){
             break;
         case HCI_INIT_LE_SET_EVENT_MASK:
             hci_stack->substate = HCI_INIT_W4_LE_SET_EVENT_MASK;
-            hci_send_cmd(&hci_le_set_event_mask, 0x809FF, 0x0); // bits 0-8, 11, 19 
+            if (hci_le_extended_advertising_supported()){
+                hci_send_cmd(&hci_le_set_event_mask, 0xFF9FF, 0x0); // bits 0-8, 11-19
+            } else {
+                hci_send_cmd(&hci_le_set_event_mask, 0x809FF, 0x0); // bits 0-8, 11, 19
+            }
             break;
         case HCI_INIT_WRITE_LE_HOST_SUPPORTED:
             // LE Supported Host = 1, Simultaneous Host = 0
@@ -1533,15 +2413,35 @@ static void hci_initializing_run(void){
             break;
         case HCI_INIT_LE_SET_SCAN_PARAMETERS:
             hci_stack->substate = HCI_INIT_W4_LE_SET_SCAN_PARAMETERS;
-            hci_send_cmd(&hci_le_set_scan_parameters, hci_stack->le_scan_type, hci_stack->le_scan_interval, hci_stack->le_scan_window, hci_stack->le_own_addr_type, hci_stack->le_scan_filter_policy);
+            hci_send_le_scan_parameters();
             break;
 #endif
         default:
             return;
     }
+
+#ifdef ENABLE_HCI_INIT_PIPELINING
+    if (!hci_initializing_pipelined()) return;
+    // track command and continue with next state without waiting for its Command Complete
+    hci_stack->init_pipeline_opcodes[hci_stack->init_pipeline_outstanding++] = hci_stack->last_cmd_opcode;
+    hci_initializing_transition();
+    if (!hci_can_send_command_packet_now()) return;
+    hci_initializing_run();
+#endif
 }
 
 static void hci_init_done(void){
+    hci_init_phase_complete();
+    log_info("Init timing: reset %u ms, chipset %u ms, capabilities %u ms, configuration %u ms",
+             (unsigned int) hci_stack->init_phase_duration_ms[HCI_INIT_PHASE_RESET],
+             (unsigned int) hci_stack->init_phase_duration_ms[HCI_INIT_PHASE_CHIPSET],
+             (unsigned int) hci_stack->init_phase_duration_ms[HCI_INIT_PHASE_CAPABILITIES],
+             (unsigned int) hci_stack->init_phase_duration_ms[HCI_INIT_PHASE_CONFIGURATION]);
+
+#ifdef ENABLE_HCI_CAPABILITIES_CACHE
+    hci_capabilities_cache_store();
+#endif
+
     // done. tell the app
     log_info("hci_init_done -> HCI_STATE_WORKING");
     hci_stack->state = HCI_STATE_WORKING;
@@ -1597,7 +2497,18 @@ static bool hci_initializing_event_handler_command_completed(const uint8_t * pac
 static void hci_initializing_event_handler(const uint8_t * packet, uint16_t size){
 
     UNUSED(size);   // ok: less than 6 bytes are read from our buffer
-    
+
+#ifdef ENABLE_HCI_CAPABILITIES_CACHE
+    hci_capabilities_cache_record(packet);
+#endif
+
+#ifdef ENABLE_HCI_INIT_PIPELINING
+    if (hci_stack->init_pipeline_outstanding > 0u){
+        hci_initializing_pipeline_event_handler(packet);
+        return;
+    }
+#endif
+
     bool command_completed =  hci_initializing_event_handler_command_completed(packet);
 
 #if !defined(HAVE_PLATFORM_IPHONE_OS) && !defined (HAVE_HOST_CONTROLLER_API)
@@ -1657,6 +2568,15 @@ static void hci_initializing_event_handler(const uint8_t * packet, uint16_t size
 
     if (!command_completed) return;
 
+    hci_initializing_transition();
+    if (hci_stack->substate == HCI_INIT_DONE){
+        hci_init_done();
+    }
+}
+
+// select next init state after command complete
+static void hci_initializing_transition(void){
+
     bool need_baud_change = false;
     bool need_addr_change = false;
 
@@ -1758,6 +2678,9 @@ static void hci_initializing_event_handler(const uint8_t * packet, uint16_t size
             return;
 #endif
         case HCI_INIT_W4_READ_BD_ADDR:
+#ifdef ENABLE_HCI_CAPABILITIES_CACHE
+            hci_capabilities_cache_load();
+#endif
             // only read buffer size if supported
             if (hci_stack->local_supported_commands[0u] & 0x01u) {
                 hci_stack->substate = HCI_INIT_READ_BUFFER_SIZE;
@@ -1776,7 +2699,7 @@ static void hci_initializing_event_handler(const uint8_t * packet, uint16_t size
                 }
 #endif
                 log_error("Neither BR/EDR nor LE supported");
-                hci_init_done();
+                hci_stack->substate = HCI_INIT_DONE;
                 return;
             }
             if (!gap_ssp_supported()){
@@ -1803,7 +2726,7 @@ static void hci_initializing_event_handler(const uint8_t * packet, uint16_t size
 #ifdef ENABLE_LE_CENTRAL
             hci_stack->substate = HCI_INIT_READ_WHITE_LIST_SIZE;
 #else
-            hci_init_done();
+            hci_stack->substate = HCI_INIT_DONE;
 #endif
             return;
 #endif  /* ENABLE_LE_DATA_LENGTH_EXTENSION */
@@ -1843,7 +2766,7 @@ static void hci_initializing_event_handler(const uint8_t * packet, uint16_t size
         case HCI_INIT_W4_BCM_WRITE_SCO_PCM_INT:
             if (!hci_le_supported()){
                 // SKIP LE init for Classic only configuration
-                hci_init_done();
+                hci_stack->substate = HCI_INIT_DONE;
                 return;
             }
             break;
@@ -1858,18 +2781,10 @@ static void hci_initializing_event_handler(const uint8_t * packet, uint16_t size
             }
 #endif
             // SKIP LE init for Classic only configuration
-            hci_init_done();
+            hci_stack->substate = HCI_INIT_DONE;
             return;
 #endif /* ENABLE_SCO_OVER_HCI */
 
-// avoid compile error due to duplicate cases: HCI_INIT_W4_BCM_WRITE_SCO_PCM_INT == HCI_INIT_DONE-1
-#if defined(ENABLE_BLE) || defined(ENABLE_LE_DATA_LENGTH_EXTENSION) || defined(ENABLE_LE_CENTRAL)
-        // Response to command before init done state -> init done
-        case (HCI_INIT_DONE-1):
-            hci_init_done();
-            return;
-#endif
-            
         default:
             break;
     }
@@ -1979,6 +2894,22 @@ static void hci_handle_read_encryption_key_size_complete(hci_connection_t * conn
 }
 #endif
 
+static uint8_t hci_num_cmd_packets_for_event(uint8_t num_hci_command_packets){
+    if (num_hci_command_packets == 0u) return 0;
+#ifdef ENABLE_HCI_INIT_PIPELINING
+    // use all command credits during pipelined init, starting with Command Complete for Read BD_ADDR
+    if ((hci_stack->state == HCI_STATE_INITIALIZING) && (hci_stack->substate >= HCI_INIT_W4_READ_BD_ADDR) && (hci_stack->substate < HCI_INIT_DONE)){
+        return btstack_min(num_hci_command_packets, HCI_INIT_PIPELINE_DEPTH);
+    }
+    // and during init script upload if supported by chipset driver
+    if ((hci_stack->state == HCI_STATE_INITIALIZING) && hci_initializing_init_script_pipelined()){
+        return btstack_min(num_hci_command_packets, hci_initializing_init_script_pipeline_depth());
+    }
+#endif
+    // limit to 1 to reduce complexity
+    return 1;
+}
+
 static void handle_command_complete_event(uint8_t * packet, uint16_t size){
     UNUSED(size);
 
@@ -1988,8 +2919,7 @@ static void handle_command_complete_event(uint8_t * packet, uint16_t size){
     hci_connection_t * conn;
     uint8_t status;
 #endif
-    // get num cmd packets - limit to 1 to reduce complexity
-    hci_stack->num_cmd_packets = packet[2] ? 1 : 0;
+    hci_stack->num_cmd_packets = hci_num_cmd_packets_for_event(packet[2]);
 
     uint16_t opcode = hci_event_command_complete_get_command_opcode(packet);
     switch (opcode){
@@ -2092,6 +3022,9 @@ static void handle_command_complete_event(uint8_t * packet, uint16_t size){
             }
             hci_stack->manufacturer = manufacturer;
             log_info("Manufacturer: 0x%04x", hci_stack->manufacturer);
+#ifdef ENABLE_HCI_CAPABILITIES_CACHE
+            (void)memcpy(hci_stack->capabilities_cache.local_version_information, &packet[6], 8);
+#endif
             break;
         case HCI_OPCODE_HCI_READ_LOCAL_SUPPORTED_COMMANDS:
             hci_stack->local_supported_commands[0] =
@@ -2106,7 +3039,11 @@ static void handle_command_complete_event(uint8_t * packet, uint16_t size){
             hci_stack->local_supported_commands[1] =
                 ((packet[OFFSET_OF_DATA_IN_COMMAND_COMPLETE+1u+ 2u] & 0x40u) >> 6u) |  // bit  8 = Octet  2, bit 6 / Read Remote Extended Features
                 ((packet[OFFSET_OF_DATA_IN_COMMAND_COMPLETE+1u+32u] & 0x08u) >> 2u) |  // bit  9 = Octet 32, bit 3 / Write Secure Connections Host
-                ((packet[OFFSET_OF_DATA_IN_COMMAND_COMPLETE+1u+35u] & 0x02u) << 1u);   // bit 10 = Octet 35, bit 1 / LE Set Address Resolution Enable
+                ((packet[OFFSET_OF_DATA_IN_COMMAND_COMPLETE+1u+35u] & 0x02u) << 1u) |  // bit 10 = Octet 35, bit 1 / LE Set Address Resolution Enable
+                ((packet[OFFSET_OF_DATA_IN_COMMAND_COMPLETE+1u+36u] & 0x04u) << 1u) |  // bit 11 = Octet 36, bit 2 / LE Set Extended Advertising Parameters
+                ((packet[OFFSET_OF_DATA_IN_COMMAND_COMPLETE+1u+37u] & 0x20u) >> 1u) |  // bit 12 = Octet 37, bit 5 / LE Set Extended Scan Parameters
+                ((packet[OFFSET_OF_DATA_IN_COMMAND_COMPLETE+1u+37u] & 0x80u) >> 2u) |  // bit 13 = Octet 37, bit 7 / LE Extended Create Connection
+                ((packet[OFFSET_OF_DATA_IN_COMMAND_COMPLETE+1u+37u] & 0x04u) << 4u);   // bit 14 = Octet 37, bit 2 / LE Set Periodic Advertising Parameters
             log_info("Local supported commands summary %02x - %02x", hci_stack->local_supported_commands[0],  hci_stack->local_supported_commands[1]);
             break;
 #ifdef ENABLE_CLASSIC
@@ -2235,6 +3172,8 @@ static void event_handler(uint8_t *packet, uint16_t size){
         return;
     }
 
+    BTSTACK_STATS_INCREMENT(HCI_EVENTS_RECEIVED);
+
     bd_addr_t addr;
     bd_addr_type_t addr_type;
     hci_con_handle_t handle;
@@ -2255,8 +3194,7 @@ static void event_handler(uint8_t *packet, uint16_t size){
             break;
             
         case HCI_EVENT_COMMAND_STATUS:
-            // get num cmd packets - limit to 1 to reduce complexity
-            hci_stack->num_cmd_packets = packet[3] ? 1 : 0;
+            hci_stack->num_cmd_packets = hci_num_cmd_packets_for_event(packet[3]);
 
             // check command status to detected failed outgoing connections
             create_connection_cmd = 0;
@@ -2269,6 +3207,9 @@ static void event_handler(uint8_t *packet, uint16_t size){
             if (HCI_EVENT_IS_COMMAND_STATUS(packet, hci_le_create_connection)){
                 create_connection_cmd = 1;
             }
+            if (HCI_EVENT_IS_COMMAND_STATUS(packet, hci_le_extended_create_connection)){
+                create_connection_cmd = 1;
+            }
 #endif
             if (create_connection_cmd) {
                 uint8_t status = hci_event_command_status_get_status(packet);
@@ -2735,6 +3676,19 @@ static void event_handler(uint8_t *packet, uint16_t size){
                     if (!hci_stack->le_scanning_enabled) break;
                     le_handle_advertisement_report(packet, size);
                     break;
+#ifdef ENABLE_LE_EXTENDED_ADVERTISING
+                case HCI_SUBEVENT_LE_EXTENDED_ADVERTISING_REPORT:
+                    if (!hci_stack->le_scanning_enabled) break;
+                    le_handle_extended_advertisement_report(packet, size);
+                    break;
+#endif
+#endif
+#ifdef ENABLE_LE_PERIPHERAL
+#ifdef ENABLE_LE_EXTENDED_ADVERTISING
+                case HCI_SUBEVENT_LE_ADVERTISING_SET_TERMINATED:
+                    hci_handle_le_advertising_set_terminated(hci_subevent_le_advertising_set_terminated_get_advertising_handle(packet));
+                    break;
+#endif
 #endif
                 case HCI_SUBEVENT_LE_CONNECTION_COMPLETE:
 					event_handle_le_connection_complete(packet);
@@ -2827,7 +3781,7 @@ static void event_handler(uint8_t *packet, uint16_t size){
 static void sco_tx_timeout_handler(btstack_timer_source_t * ts);
 static void sco_schedule_tx(hci_connection_t * conn);
 
-static void sco_tx_timeout_handler(btstack_timer_source_t * ts){
+static void sco_tx_timeout_process(btstack_timer_source_t * ts){
     log_debug("SCO TX Timeout");
     hci_con_handle_t con_handle = (hci_con_handle_t) (uintptr_t) btstack_run_loop_get_timer_context(ts);
     hci_connection_t * conn = hci_connection_for_handle(con_handle);
@@ -2842,6 +3796,10 @@ static void sco_tx_timeout_handler(btstack_timer_source_t * ts){
     hci_notify_if_sco_can_send_now();
 }
 
+static void sco_tx_timeout_handler(btstack_timer_source_t * ts){
+    hci_instance_process_timer(ts, &sco_tx_timeout_process);
+}
+
 
 #define SCO_TX_AFTER_RX_MS (6)
 
@@ -2926,7 +3884,9 @@ static void packet_handler(uint8_t packet_type, uint8_t *packet, uint16_t size){
             event_handler(packet, size);
             break;
         case HCI_ACL_DATA_PACKET:
+            BTSTACK_STATS_TRACE_BEGIN(HCI_ACL, READ_ACL_CONNECTION_HANDLE(packet));
             acl_handler(packet, size);
+            BTSTACK_STATS_TRACE_END(HCI_ACL, READ_ACL_CONNECTION_HANDLE(packet));
             break;
 #ifdef ENABLE_CLASSIC
         case HCI_SCO_DATA_PACKET:
@@ -2938,6 +3898,38 @@ static void packet_handler(uint8_t packet_type, uint8_t *packet, uint16_t size){
     }
 }
 
+#ifdef ENABLE_HCI_MULTIPLE_CONTROLLERS
+// process packet from controller transport with its instance selected
+static void hci_instance_packet_handler(uint8_t controller_index, uint8_t packet_type, uint8_t *packet, uint16_t size){
+    hci_stack_t * selected_instance = hci_stack;
+    hci_stack = hci_instances[controller_index];
+    packet_handler(packet_type, packet, size);
+    // hci_close might have been called
+    if (hci_num_instances == 0) return;
+    hci_stack = selected_instance;
+}
+
+// transports don't provide context: generate one packet handler per controller index up to MAX_NR_HCI_CONTROLLERS
+#define HCI_FOR_EACH_CONTROLLER_INDEX_1(X) X(0)
+#define HCI_FOR_EACH_CONTROLLER_INDEX_2(X) HCI_FOR_EACH_CONTROLLER_INDEX_1(X) X(1)
+#define HCI_FOR_EACH_CONTROLLER_INDEX_3(X) HCI_FOR_EACH_CONTROLLER_INDEX_2(X) X(2)
+#define HCI_FOR_EACH_CONTROLLER_INDEX_4(X) HCI_FOR_EACH_CONTROLLER_INDEX_3(X) X(3)
+#define HCI_FOR_EACH_CONTROLLER_INDEX_EXPAND(num, X) HCI_FOR_EACH_CONTROLLER_INDEX_ ## num(X)
+#define HCI_FOR_EACH_CONTROLLER_INDEX(num, X) HCI_FOR_EACH_CONTROLLER_INDEX_EXPAND(num, X)
+
+#define HCI_CONTROLLER_PACKET_HANDLER(index) \
+static void hci_controller_ ## index ## _packet_handler(uint8_t packet_type, uint8_t *packet, uint16_t size){ \
+    hci_instance_packet_handler(index, packet_type, packet, size); \
+}
+#define HCI_CONTROLLER_PACKET_HANDLER_ENTRY(index) &hci_controller_ ## index ## _packet_handler,
+
+HCI_FOR_EACH_CONTROLLER_INDEX(MAX_NR_HCI_CONTROLLERS, HCI_CONTROLLER_PACKET_HANDLER)
+
+static void (* const hci_instance_packet_handlers[MAX_NR_HCI_CONTROLLERS])(uint8_t packet_type, uint8_t *packet, uint16_t size) = {
+    HCI_FOR_EACH_CONTROLLER_INDEX(MAX_NR_HCI_CONTROLLERS, HCI_CONTROLLER_PACKET_HANDLER_ENTRY)
+};
+#endif
+
 /**
  * @brief Add event packet handler. 
  */
@@ -2945,10 +3937,23 @@ void hci_add_event_handler(btstack_packet_callback_registration_t * callback_han
     btstack_linked_list_add_tail(&hci_stack->event_handlers, (btstack_linked_item_t*) callback_handler);
 }
 
+#ifdef ENABLE_HCI_MULTIPLE_CONTROLLERS
+void hci_add_shared_event_handler(btstack_packet_callback_registration_t * callback_handler){
+    btstack_linked_list_add_tail(&hci_shared_event_handlers, (btstack_linked_item_t*) callback_handler);
+}
+#endif
 
 /** Register HCI packet handlers */
 void hci_register_acl_packet_handler(btstack_packet_handler_t handler){
+#ifdef ENABLE_HCI_MULTIPLE_CONTROLLERS
+    // ACL data of all controllers goes to L2CAP
+    uint8_t i;
+    for (i = 0; i < hci_num_instances; i++){
+        hci_instances[i]->acl_packet_handler = handler;
+    }
+#else
     hci_stack->acl_packet_handler = handler;
+#endif
 }
 
 #ifdef ENABLE_CLASSIC
@@ -2956,7 +3961,14 @@ void hci_register_acl_packet_handler(btstack_packet_handler_t handler){
  * @brief Registers a packet handler for SCO data. Used for HSP and HFP profiles.
  */
 void hci_register_sco_packet_handler(btstack_packet_handler_t handler){
+#ifdef ENABLE_HCI_MULTIPLE_CONTROLLERS
+    uint8_t i;
+    for (i = 0; i < hci_num_instances; i++){
+        hci_instances[i]->sco_packet_handler = handler;
+    }
+#else
     hci_stack->sco_packet_handler = handler;    
+#endif
 }
 #endif
 
@@ -2972,6 +3984,18 @@ static void hci_state_reset(void){
 
     // buffer is free
     hci_stack->hci_packet_buffer_reserved = 0;
+#ifdef ENABLE_BTSTACK_STATS
+    hci_stack->stats_acl_credit_stall = 0;
+    hci_stack->stats_packet_buffer_contention = 0;
+#endif
+
+#ifdef ENABLE_HCI_INIT_PIPELINING
+    hci_stack->init_pipeline_outstanding = 0;
+    hci_stack->init_script_result_pending = false;
+#endif
+#ifdef ENABLE_HCI_CAPABILITIES_CACHE
+    hci_stack->capabilities_cache_hit = false;
+#endif
 
     // no pending cmds
     hci_stack->decline_reason = 0;
@@ -2988,6 +4012,15 @@ static void hci_state_reset(void){
     hci_stack->le_connecting_request = LE_CONNECTING_IDLE;
     hci_stack->le_whitelist_capacity = 0;
 #endif
+#ifdef ENABLE_LE_EXTENDED_ADVERTISING
+#ifdef ENABLE_LE_CENTRAL
+    memset(hci_stack->le_extended_advertising_reassembly, 0, sizeof(hci_stack->le_extended_advertising_reassembly));
+    hci_stack->le_periodic_sync_request = LE_PERIODIC_SYNC_REQUEST_IDLE;
+#endif
+#ifdef ENABLE_LE_PERIPHERAL
+    hci_le_advertising_sets_reset();
+#endif
+#endif
 }
 
 #ifdef ENABLE_CLASSIC
@@ -3003,15 +4036,8 @@ void hci_set_link_key_db(btstack_link_key_db_t const * link_key_db){
 }
 #endif
 
-void hci_init(const hci_transport_t *transport, const void *config){
-    
-#ifdef HAVE_MALLOC
-    if (!hci_stack) {
-        hci_stack = (hci_stack_t*) malloc(sizeof(hci_stack_t));
-    }
-#else
-    hci_stack = &hci_stack_static;
-#endif
+static void hci_init_instance(const hci_transport_t *transport, const void *config, void (*transport_packet_handler)(uint8_t packet_type, uint8_t *packet, uint16_t size)){
+
     memset(hci_stack, 0, sizeof(hci_stack_t));
 
     // reference to use transport layer implementation
@@ -3027,7 +4053,7 @@ void hci_init(const hci_transport_t *transport, const void *config){
     hci_stack->acl_data_packet_length = HCI_ACL_PAYLOAD_SIZE;
     
     // register packet handlers with transport
-    transport->register_packet_handler(&packet_handler);
+    transport->register_packet_handler(transport_packet_handler);
 
     hci_stack->state = HCI_STATE_OFF;
 
@@ -3066,37 +4092,154 @@ void hci_init(const hci_transport_t *transport, const void *config){
     // voice setting - signed 16 bit pcm data with CVSD over the air
     hci_stack->sco_voice_setting = 0x60;
 
-#ifdef ENABLE_LE_CENTRAL
-    // connection parameter to use for outgoing connections
-    hci_stack->le_connection_scan_interval = 0x0060;   // 60ms
-    hci_stack->le_connection_scan_window  = 0x0030;    // 30ms
-    hci_stack->le_connection_interval_min = 0x0008;    // 10 ms
-    hci_stack->le_connection_interval_max = 0x0018;    // 30 ms
-    hci_stack->le_connection_latency      = 4;         // 4
-    hci_stack->le_supervision_timeout     = 0x0048;    // 720 ms
-    hci_stack->le_minimum_ce_length       = 2;         // 1.25 ms
-    hci_stack->le_maximum_ce_length       = 0x0030;    // 30 ms
+#ifdef ENABLE_LE_CENTRAL
+    // connection parameter to use for outgoing connections
+    hci_stack->le_connection_scan_interval = 0x0060;   // 60ms
+    hci_stack->le_connection_scan_window  = 0x0030;    // 30ms
+    hci_stack->le_connection_interval_min = 0x0008;    // 10 ms
+    hci_stack->le_connection_interval_max = 0x0018;    // 30 ms
+    hci_stack->le_connection_latency      = 4;         // 4
+    hci_stack->le_supervision_timeout     = 0x0048;    // 720 ms
+    hci_stack->le_minimum_ce_length       = 2;         // 1.25 ms
+    hci_stack->le_maximum_ce_length       = 0x0030;    // 30 ms
+
+    // default LE Scanning
+    hci_stack->le_scan_type     =   0x1; // active
+    hci_stack->le_scan_interval = 0x1e0; // 300 ms
+    hci_stack->le_scan_window   =  0x30; //  30 ms
+#ifdef ENABLE_LE_EXTENDED_ADVERTISING
+    hci_stack->le_scan_phys     =  0x01; // LE 1M PHY
+#endif
+#endif
+
+#ifdef ENABLE_LE_PERIPHERAL
+    hci_stack->le_max_number_peripheral_connections = 1; // only single connection as peripheral
+#endif
+
+    // connection parameter range used to answer connection parameter update requests in l2cap
+    hci_stack->le_connection_parameter_range.le_conn_interval_min =          6; 
+    hci_stack->le_connection_parameter_range.le_conn_interval_max =       3200;
+    hci_stack->le_connection_parameter_range.le_conn_latency_min =           0;
+    hci_stack->le_connection_parameter_range.le_conn_latency_max =         500;
+    hci_stack->le_connection_parameter_range.le_supervision_timeout_min =   10;
+    hci_stack->le_connection_parameter_range.le_supervision_timeout_max = 3200;
+
+    hci_state_reset();
+}
+
+#ifdef ENABLE_BTSTACK_STATS
+static void hci_stats_for_each_traffic_of_instance(hci_stack_t * instance, btstack_stats_traffic_handler_t handler, void * context){
+    btstack_linked_list_iterator_t it;
+    btstack_linked_list_iterator_init(&it, &instance->connections);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        hci_connection_t * connection = (hci_connection_t *) btstack_linked_list_iterator_next(&it);
+        (*handler)(context, "hci_connection", connection->con_handle, &connection->stats);
+    }
+}
+
+static void hci_stats_for_each_traffic(btstack_stats_traffic_handler_t handler, void * context){
+#ifdef ENABLE_HCI_MULTIPLE_CONTROLLERS
+    uint8_t i;
+    for (i = 0; i < hci_num_instances; i++){
+        hci_stats_for_each_traffic_of_instance(hci_instances[i], handler, context);
+    }
+#else
+    if (hci_stack == NULL) return;
+    hci_stats_for_each_traffic_of_instance(hci_stack, handler, context);
+#endif
+}
+
+static btstack_stats_source_t hci_stats_source = {
+    { NULL },
+    &hci_stats_for_each_traffic
+};
+#endif
+
+void hci_init(const hci_transport_t *transport, const void *config){
+    
+#ifdef HAVE_MALLOC
+    if (!hci_stack) {
+        hci_stack = (hci_stack_t*) malloc(sizeof(hci_stack_t));
+    }
+#else
+    hci_stack = &hci_stack_static;
+#endif
+
+#ifdef ENABLE_HCI_MULTIPLE_CONTROLLERS
+    hci_instances[0] = hci_stack;
+    hci_num_instances = 1;
+    hci_shared_event_handlers = NULL;
+    hci_init_instance(transport, config, hci_instance_packet_handlers[0]);
+#else
+    hci_init_instance(transport, config, &packet_handler);
+#endif
 
-    // default LE Scanning
-    hci_stack->le_scan_type     =   0x1; // active
-    hci_stack->le_scan_interval = 0x1e0; // 300 ms
-    hci_stack->le_scan_window   =  0x30; //  30 ms
+#ifdef ENABLE_BTSTACK_STATS
+    btstack_stats_add_source(&hci_stats_source);
 #endif
+}
 
-#ifdef ENABLE_LE_PERIPHERAL
-    hci_stack->le_max_number_peripheral_connections = 1; // only single connection as peripheral
+#ifdef ENABLE_HCI_MULTIPLE_CONTROLLERS
+int hci_add_controller(const hci_transport_t *transport, const void *config){
+    btstack_assert(hci_num_instances > 0);
+    if (hci_num_instances >= MAX_NR_HCI_CONTROLLERS) return -1;
+#ifdef HAVE_MALLOC
+    hci_stack_t * instance = (hci_stack_t*) malloc(sizeof(hci_stack_t));
+    if (instance == NULL) return -1;
+#else
+    hci_stack_t * instance = &hci_stack_secondary_static[hci_num_instances - 1];
+#endif
+    uint8_t controller_index = hci_num_instances;
+    hci_instances[controller_index] = instance;
+    hci_num_instances++;
+
+    // init with new instance selected
+    hci_stack_t * selected_instance = hci_stack;
+    hci_stack = instance;
+    hci_init_instance(transport, config, hci_instance_packet_handlers[controller_index]);
+    // ACL and SCO data handlers are shared with the primary controller
+    instance->acl_packet_handler = hci_instances[0]->acl_packet_handler;
+#ifdef ENABLE_CLASSIC
+    instance->sco_packet_handler = hci_instances[0]->sco_packet_handler;
 #endif
+    hci_stack = selected_instance;
 
-    // connection parameter range used to answer connection parameter update requests in l2cap
-    hci_stack->le_connection_parameter_range.le_conn_interval_min =          6; 
-    hci_stack->le_connection_parameter_range.le_conn_interval_max =       3200;
-    hci_stack->le_connection_parameter_range.le_conn_latency_min =           0;
-    hci_stack->le_connection_parameter_range.le_conn_latency_max =         500;
-    hci_stack->le_connection_parameter_range.le_supervision_timeout_min =   10;
-    hci_stack->le_connection_parameter_range.le_supervision_timeout_max = 3200;
+    log_info("Controller %u added", controller_index);
+    return controller_index;
+}
 
-    hci_state_reset();
+uint8_t hci_get_num_controllers(void){
+    return hci_num_instances;
+}
+
+void hci_select_controller(uint8_t controller_index){
+    btstack_assert(controller_index < hci_num_instances);
+    hci_stack = hci_instances[controller_index];
+}
+
+uint8_t hci_get_selected_controller(void){
+    uint8_t i;
+    for (i = 0; i < hci_num_instances; i++){
+        if (hci_instances[i] == hci_stack) break;
+    }
+    return i;
+}
+
+uint8_t hci_get_controller_with_fewest_connections(void){
+    uint8_t controller_index = 0;
+    int min_connections = -1;
+    uint8_t i;
+    for (i = 0; i < hci_num_instances; i++){
+        if (hci_instances[i]->state != HCI_STATE_WORKING) continue;
+        int num_connections = btstack_linked_list_count(&hci_instances[i]->connections);
+        if ((min_connections < 0) || (num_connections < min_connections)){
+            min_connections = num_connections;
+            controller_index = i;
+        }
+    }
+    return controller_index;
 }
+#endif
 
 /**
  * @brief Configure Bluetooth chipset driver. Has to be called before power on, or right after receiving the local version information
@@ -3120,7 +4263,7 @@ void hci_set_control(const btstack_control_t *hardware_control){
     hardware_control->init(hci_stack->config);
 }
 
-void hci_close(void){
+static void hci_close_instance(void){
     // close remote device db
     if (hci_stack->link_key_db) {
         hci_stack->link_key_db->close();
@@ -3136,6 +4279,34 @@ void hci_close(void){
     }
 
     hci_power_control(HCI_POWER_OFF);
+}
+
+void hci_close(void){
+#ifdef ENABLE_HCI_MULTIPLE_CONTROLLERS
+    // close secondary controllers first, keep them registered while L2CAP handles the disconnects
+    while (hci_num_instances > 1){
+        uint8_t controller_index = hci_num_instances - 1u;
+        hci_stack = hci_instances[controller_index];
+        hci_close_instance();
+#ifdef HAVE_MALLOC
+        free(hci_stack);
+#endif
+        hci_instances[controller_index] = NULL;
+        hci_num_instances--;
+    }
+    hci_stack = hci_instances[0];
+#endif
+
+    hci_close_instance();
+
+#ifdef ENABLE_HCI_MULTIPLE_CONTROLLERS
+    hci_instances[0] = NULL;
+    hci_num_instances = 0;
+#endif
+
+#ifdef ENABLE_BTSTACK_STATS
+    btstack_stats_remove_source(&hci_stats_source);
+#endif
     
 #ifdef HAVE_MALLOC
     free(hci_stack);
@@ -3308,6 +4479,7 @@ static void hci_power_transition_to_initializing(void){
     hci_stack->hci_packet_buffer_reserved = 0;
     hci_stack->state = HCI_STATE_INITIALIZING;
     hci_stack->substate = HCI_INIT_SEND_RESET;
+    hci_init_phase_start();
 }
 
 int hci_power_control(HCI_POWER_MODE power_mode){
@@ -3518,6 +4690,7 @@ static void hci_host_num_completed_packets(void){
 
     hci_stack->host_completed_packets = 0;
 
+    BTSTACK_STATS_INCREMENT(HCI_COMMANDS_SENT);
     hci_dump_packet(HCI_COMMAND_DATA_PACKET, 0, packet, size);
     hci_stack->hci_transport->send_packet(HCI_COMMAND_DATA_PACKET, packet, size);
 
@@ -3529,7 +4702,7 @@ static void hci_host_num_completed_packets(void){
 }
 #endif
 
-static void hci_halting_timeout_handler(btstack_timer_source_t * ds){
+static void hci_halting_timeout_process(btstack_timer_source_t * ds){
     UNUSED(ds);
     hci_stack->substate = HCI_HALTING_CLOSE;
     // allow packet handlers to defer final shutdown
@@ -3537,6 +4710,10 @@ static void hci_halting_timeout_handler(btstack_timer_source_t * ds){
     hci_run();
 }   
 
+static void hci_halting_timeout_handler(btstack_timer_source_t * ts){
+    hci_instance_process_timer(ts, &hci_halting_timeout_process);
+}
+
 static bool hci_run_acl_fragments(void){
     if (hci_stack->acl_fragmentation_total_size > 0u) {
         hci_con_handle_t con_handle = READ_ACL_CONNECTION_HANDLE(hci_stack->hci_packet_buffer);
@@ -3623,6 +4800,263 @@ static bool hci_run_general_gap_classic(void){
 }
 #endif
 
+#ifdef ENABLE_LE_EXTENDED_ADVERTISING
+#ifdef ENABLE_LE_PERIPHERAL
+#define LE_EXTENDED_ADVERTISING_MAX_FRAGMENT_LEN  251
+#define LE_PERIODIC_ADVERTISING_MAX_FRAGMENT_LEN  252
+
+#define LE_ADVERTISEMENT_TASKS_EXTENDED_MASK (LE_ADVERTISEMENT_TASKS_SET_ADV_DATA | LE_ADVERTISEMENT_TASKS_SET_SCAN_DATA | \
+    LE_ADVERTISEMENT_TASKS_SET_PARAMS | LE_ADVERTISEMENT_TASKS_SET_ADDRESS | LE_ADVERTISEMENT_TASKS_REMOVE_SET)
+#define LE_ADVERTISEMENT_TASKS_PERIODIC_MASK (LE_ADVERTISEMENT_TASKS_SET_PERIODIC_PARAMS | LE_ADVERTISEMENT_TASKS_SET_PERIODIC_DATA | \
+    LE_ADVERTISEMENT_TASKS_REMOVE_SET)
+
+static uint16_t hci_le_legacy_advertising_event_properties(uint8_t advertising_type){
+    switch (advertising_type){
+        case 1:     // ADV_DIRECT_IND (high duty cycle)
+            return 0x1d;
+        case 2:     // ADV_SCAN_IND
+            return 0x12;
+        case 3:     // ADV_NONCONN_IND
+            return 0x10;
+        case 4:     // ADV_DIRECT_IND (low duty cycle)
+            return 0x15;
+        default:    // ADV_IND
+            return 0x13;
+    }
+}
+
+// get operation and length for next fragment of advertising data at data_pos
+static uint8_t hci_le_advertising_data_fragment(uint16_t data_len, uint16_t data_pos, uint16_t max_fragment_len, uint8_t * out_fragment_len){
+    uint16_t remaining_len = data_len - data_pos;
+    uint16_t fragment_len = btstack_min(remaining_len, max_fragment_len);
+    *out_fragment_len = (uint8_t) fragment_len;
+    if (data_pos == 0u){
+        // complete or first fragment
+        return (fragment_len == remaining_len) ? 3 : 1;
+    }
+    // last or intermediate fragment
+    return (fragment_len == remaining_len) ? 2 : 0;
+}
+
+// legacy advertising uses advertising handle 0 with legacy PDUs
+static bool hci_run_le_legacy_advertising_set(void){
+    if (hci_stack->le_advertisements_enabled_for_current_roles && !hci_stack->le_advertisements_legacy_set_configured){
+        hci_stack->le_advertisements_todo |= LE_ADVERTISEMENT_TASKS_SET_PARAMS | LE_ADVERTISEMENT_TASKS_SET_ADV_DATA | LE_ADVERTISEMENT_TASKS_SET_SCAN_DATA;
+    }
+    if (hci_stack->le_advertisements_todo & LE_ADVERTISEMENT_TASKS_SET_PARAMS){
+        hci_stack->le_advertisements_todo &= ~LE_ADVERTISEMENT_TASKS_SET_PARAMS;
+        hci_stack->le_advertisements_legacy_set_configured = true;
+        if (((hci_stack->le_own_addr_type & 1u) != 0u) && (hci_stack->le_random_address_set != 0u)){
+            hci_stack->le_advertisements_todo |= LE_ADVERTISEMENT_TASKS_SET_ADDRESS;
+        }
+        hci_send_cmd(&hci_le_set_extended_advertising_parameters, 0,
+                     hci_le_legacy_advertising_event_properties(hci_stack->le_advertisements_type),
+                     (uint32_t) hci_stack->le_advertisements_interval_min,
+                     (uint32_t) hci_stack->le_advertisements_interval_max,
+                     hci_stack->le_advertisements_channel_map,
+                     hci_stack->le_own_addr_type,
+                     hci_stack->le_advertisements_direct_address_type,
+                     hci_stack->le_advertisements_direct_address,
+                     hci_stack->le_advertisements_filter_policy,
+                     0x7f,  // no tx power preference
+                     0x01,  // LE 1M PHY
+                     0,
+                     0x01,  // LE 1M PHY
+                     0,
+                     0);
+        return true;
+    }
+    if (hci_stack->le_advertisements_todo & LE_ADVERTISEMENT_TASKS_SET_ADDRESS){
+        hci_stack->le_advertisements_todo &= ~LE_ADVERTISEMENT_TASKS_SET_ADDRESS;
+        hci_send_cmd(&hci_le_set_advertising_set_random_address, 0, hci_stack->le_random_address);
+        return true;
+    }
+    if (hci_stack->le_advertisements_todo & LE_ADVERTISEMENT_TASKS_SET_ADV_DATA){
+        hci_stack->le_advertisements_todo &= ~LE_ADVERTISEMENT_TASKS_SET_ADV_DATA;
+        uint8_t adv_data_clean[31];
+        (void)memcpy(adv_data_clean, hci_stack->le_advertisements_data, hci_stack->le_advertisements_data_len);
+        btstack_replace_bd_addr_placeholder(adv_data_clean, hci_stack->le_advertisements_data_len, hci_stack->local_bd_addr);
+        hci_send_cmd(&hci_le_set_extended_advertising_data, 0, 3, 1, hci_stack->le_advertisements_data_len, adv_data_clean);
+        return true;
+    }
+    if (hci_stack->le_advertisements_todo & LE_ADVERTISEMENT_TASKS_SET_SCAN_DATA){
+        hci_stack->le_advertisements_todo &= ~LE_ADVERTISEMENT_TASKS_SET_SCAN_DATA;
+        uint8_t scan_data_clean[31];
+        (void)memcpy(scan_data_clean, hci_stack->le_scan_response_data, hci_stack->le_scan_response_data_len);
+        btstack_replace_bd_addr_placeholder(scan_data_clean, hci_stack->le_scan_response_data_len, hci_stack->local_bd_addr);
+        hci_send_cmd(&hci_le_set_extended_scan_response_data, 0, 3, 1, hci_stack->le_scan_response_data_len, scan_data_clean);
+        return true;
+    }
+    return false;
+}
+
+static bool hci_run_le_advertising_sets_stop(bool whitelist_modification_pending, bool resolving_list_modification_pending){
+    btstack_linked_list_iterator_t it;
+    btstack_linked_list_iterator_init(&it, &hci_stack->le_advertising_sets);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        le_advertising_set_t * advertising_set = (le_advertising_set_t *) btstack_linked_list_iterator_next(&it);
+        // periodic advertising needs to be stopped to update its parameters or fragmented data
+        if ((advertising_set->state & LE_ADVERTISEMENT_STATE_PERIODIC_ACTIVE) != 0u){
+            if (((advertising_set->tasks & LE_ADVERTISEMENT_TASKS_PERIODIC_MASK) != 0u) ||
+                ((advertising_set->state & LE_ADVERTISEMENT_STATE_PERIODIC_ENABLED) == 0u)){
+                advertising_set->state &= ~LE_ADVERTISEMENT_STATE_PERIODIC_ACTIVE;
+                hci_send_cmd(&hci_le_set_periodic_advertising_enable, 0, advertising_set->advertising_handle);
+                return true;
+            }
+        }
+        // same rules as for legacy advertising
+        if ((advertising_set->state & LE_ADVERTISEMENT_STATE_ACTIVE) != 0u){
+            bool advertising_uses_whitelist = advertising_set->extended_params.advertising_filter_policy > 0u;
+            if (((advertising_set->tasks & LE_ADVERTISEMENT_TASKS_EXTENDED_MASK) != 0u) ||
+                ((advertising_set->state & LE_ADVERTISEMENT_STATE_ENABLED) == 0u) ||
+                (advertising_uses_whitelist && whitelist_modification_pending) ||
+                resolving_list_modification_pending){
+                advertising_set->state &= ~LE_ADVERTISEMENT_STATE_ACTIVE;
+                hci_send_cmd(&hci_le_set_extended_advertising_enable, 0, 1, advertising_set->advertising_handle, 0, 0);
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+static bool hci_run_le_advertising_sets_modify(void){
+    uint8_t fragment_len;
+    uint8_t operation;
+    btstack_linked_list_iterator_t it;
+    btstack_linked_list_iterator_init(&it, &hci_stack->le_advertising_sets);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        le_advertising_set_t * advertising_set = (le_advertising_set_t *) btstack_linked_list_iterator_next(&it);
+        uint8_t advertising_handle = advertising_set->advertising_handle;
+        if (advertising_set->tasks & LE_ADVERTISEMENT_TASKS_REMOVE_SET){
+            btstack_linked_list_iterator_remove(&it);
+            hci_send_cmd(&hci_le_remove_advertising_set, advertising_handle);
+            return true;
+        }
+        if (advertising_set->tasks & LE_ADVERTISEMENT_TASKS_SET_PARAMS){
+            advertising_set->tasks &= ~LE_ADVERTISEMENT_TASKS_SET_PARAMS;
+            const le_extended_advertising_parameters_t * params = &advertising_set->extended_params;
+            if (((params->own_address_type & 1u) != 0u) && (hci_stack->le_random_address_set != 0u)){
+                advertising_set->tasks |= LE_ADVERTISEMENT_TASKS_SET_ADDRESS;
+            }
+            hci_send_cmd(&hci_le_set_extended_advertising_parameters, advertising_handle,
+                         params->advertising_event_properties,
+                         params->primary_advertising_interval_min,
+                         params->primary_advertising_interval_max,
+                         params->primary_advertising_channel_map,
+                         (uint8_t) params->own_address_type,
+                         (uint8_t) params->peer_address_type,
+                         params->peer_address,
+                         params->advertising_filter_policy,
+                         (uint8_t) params->advertising_tx_power,
+                         params->primary_advertising_phy,
+                         params->secondary_advertising_max_skip,
+                         params->secondary_advertising_phy,
+                         params->advertising_sid,
+                         params->scan_request_notification_enable);
+            return true;
+        }
+        if (advertising_set->tasks & LE_ADVERTISEMENT_TASKS_SET_ADDRESS){
+            advertising_set->tasks &= ~LE_ADVERTISEMENT_TASKS_SET_ADDRESS;
+            hci_send_cmd(&hci_le_set_advertising_set_random_address, advertising_handle, hci_stack->le_random_address);
+            return true;
+        }
+        if (advertising_set->tasks & LE_ADVERTISEMENT_TASKS_SET_ADV_DATA){
+            operation = hci_le_advertising_data_fragment(advertising_set->adv_data_len, advertising_set->adv_data_pos,
+                                                         LE_EXTENDED_ADVERTISING_MAX_FRAGMENT_LEN, &fragment_len);
+            hci_send_cmd(&hci_le_set_extended_advertising_data, advertising_handle, operation, 1, fragment_len,
+                         &advertising_set->adv_data[advertising_set->adv_data_pos]);
+            advertising_set->adv_data_pos += fragment_len;
+            if (advertising_set->adv_data_pos == advertising_set->adv_data_len){
+                advertising_set->adv_data_pos = 0;
+                advertising_set->tasks &= ~LE_ADVERTISEMENT_TASKS_SET_ADV_DATA;
+            }
+            return true;
+        }
+        if (advertising_set->tasks & LE_ADVERTISEMENT_TASKS_SET_SCAN_DATA){
+            operation = hci_le_advertising_data_fragment(advertising_set->scan_data_len, advertising_set->scan_data_pos,
+                                                         LE_EXTENDED_ADVERTISING_MAX_FRAGMENT_LEN, &fragment_len);
+            hci_send_cmd(&hci_le_set_extended_scan_response_data, advertising_handle, operation, 1, fragment_len,
+                         &advertising_set->scan_data[advertising_set->scan_data_pos]);
+            advertising_set->scan_data_pos += fragment_len;
+            if (advertising_set->scan_data_pos == advertising_set->scan_data_len){
+                advertising_set->scan_data_pos = 0;
+                advertising_set->tasks &= ~LE_ADVERTISEMENT_TASKS_SET_SCAN_DATA;
+            }
+            return true;
+        }
+        if (advertising_set->tasks & LE_ADVERTISEMENT_TASKS_SET_PERIODIC_PARAMS){
+            advertising_set->tasks &= ~LE_ADVERTISEMENT_TASKS_SET_PERIODIC_PARAMS;
+            const le_periodic_advertising_parameters_t * params = &advertising_set->periodic_params;
+            hci_send_cmd(&hci_le_set_periodic_advertising_parameters, advertising_handle,
+                         params->periodic_advertising_interval_min,
+                         params->periodic_advertising_interval_max,
+                         params->periodic_advertising_properties);
+            return true;
+        }
+        if (advertising_set->tasks & LE_ADVERTISEMENT_TASKS_SET_PERIODIC_DATA){
+            operation = hci_le_advertising_data_fragment(advertising_set->periodic_data_len, advertising_set->periodic_data_pos,
+                                                         LE_PERIODIC_ADVERTISING_MAX_FRAGMENT_LEN, &fragment_len);
+            hci_send_cmd(&hci_le_set_periodic_advertising_data, advertising_handle, operation, fragment_len,
+                         &advertising_set->periodic_data[advertising_set->periodic_data_pos]);
+            advertising_set->periodic_data_pos += fragment_len;
+            if (advertising_set->periodic_data_pos == advertising_set->periodic_data_len){
+                advertising_set->periodic_data_pos = 0;
+                advertising_set->tasks &= ~LE_ADVERTISEMENT_TASKS_SET_PERIODIC_DATA;
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool hci_run_le_advertising_sets_start(void){
+    btstack_linked_list_iterator_t it;
+    btstack_linked_list_iterator_init(&it, &hci_stack->le_advertising_sets);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        le_advertising_set_t * advertising_set = (le_advertising_set_t *) btstack_linked_list_iterator_next(&it);
+        if (((advertising_set->state & LE_ADVERTISEMENT_STATE_ENABLED) != 0u) &&
+            ((advertising_set->state & LE_ADVERTISEMENT_STATE_ACTIVE) == 0u)){
+            advertising_set->state |= LE_ADVERTISEMENT_STATE_ACTIVE;
+            hci_send_cmd(&hci_le_set_extended_advertising_enable, 1, 1, advertising_set->advertising_handle,
+                         advertising_set->enable_timeout, advertising_set->enable_max_events);
+            return true;
+        }
+        if (((advertising_set->state & LE_ADVERTISEMENT_STATE_PERIODIC_ENABLED) != 0u) &&
+            ((advertising_set->state & LE_ADVERTISEMENT_STATE_PERIODIC_ACTIVE) == 0u)){
+            advertising_set->state |= LE_ADVERTISEMENT_STATE_PERIODIC_ACTIVE;
+            hci_send_cmd(&hci_le_set_periodic_advertising_enable, 1, advertising_set->advertising_handle);
+            return true;
+        }
+    }
+    return false;
+}
+#endif
+
+#ifdef ENABLE_LE_CENTRAL
+static bool hci_run_le_periodic_sync(void){
+    le_periodic_sync_request_t request = hci_stack->le_periodic_sync_request;
+    hci_stack->le_periodic_sync_request = LE_PERIODIC_SYNC_REQUEST_IDLE;
+    switch (request){
+        case LE_PERIODIC_SYNC_REQUEST_CREATE:
+            hci_send_cmd(&hci_le_periodic_advertising_create_sync, hci_stack->le_periodic_sync_options,
+                         hci_stack->le_periodic_sync_advertising_sid, (uint8_t) hci_stack->le_periodic_sync_advertiser_address_type,
+                         hci_stack->le_periodic_sync_advertiser_address, hci_stack->le_periodic_sync_skip,
+                         hci_stack->le_periodic_sync_timeout, 0);
+            return true;
+        case LE_PERIODIC_SYNC_REQUEST_CANCEL:
+            hci_send_cmd(&hci_le_periodic_advertising_create_sync_cancel);
+            return true;
+        case LE_PERIODIC_SYNC_REQUEST_TERMINATE:
+            hci_send_cmd(&hci_le_periodic_advertising_terminate_sync, hci_stack->le_periodic_sync_handle);
+            return true;
+        default:
+            return false;
+    }
+}
+#endif
+#endif
+
 #ifdef ENABLE_BLE
 static bool hci_run_general_gap_le(void){
 
@@ -3726,7 +5160,7 @@ static bool hci_run_general_gap_le(void){
 #ifdef ENABLE_LE_CENTRAL
     if (scanning_stop){
         hci_stack->le_scanning_active = false;
-        hci_send_cmd(&hci_le_set_scan_enable, 0, 0);
+        hci_send_le_scan_enable(0);
         return true;
     }
 #endif
@@ -3743,7 +5177,17 @@ static bool hci_run_general_gap_le(void){
 #ifdef ENABLE_LE_PERIPHERAL
     if (advertising_stop){
         hci_stack->le_advertisements_active = false;
-        hci_send_cmd(&hci_le_set_advertise_enable, 0);
+        if (hci_le_extended_advertising_supported()){
+            hci_send_cmd(&hci_le_set_extended_advertising_enable, 0, 1, 0, 0, 0);
+        } else {
+            hci_send_cmd(&hci_le_set_advertise_enable, 0);
+        }
+        return true;
+    }
+#endif
+
+#if defined(ENABLE_LE_PERIPHERAL) && defined(ENABLE_LE_EXTENDED_ADVERTISING)
+    if (hci_le_extended_advertising_supported() && hci_run_le_advertising_sets_stop(whitelist_modification_pending, resolving_list_modification_pending)){
         return true;
     }
 #endif
@@ -3753,13 +5197,18 @@ static bool hci_run_general_gap_le(void){
 #ifdef ENABLE_LE_CENTRAL
     if (hci_stack->le_scanning_param_update){
         hci_stack->le_scanning_param_update = false;
-        hci_send_cmd(&hci_le_set_scan_parameters, hci_stack->le_scan_type, hci_stack->le_scan_interval, hci_stack->le_scan_window,
-                     hci_stack->le_own_addr_type, hci_stack->le_scan_filter_policy);
+        hci_send_le_scan_parameters();
         return true;
     }
 #endif
 
 #ifdef ENABLE_LE_PERIPHERAL
+#ifdef ENABLE_LE_EXTENDED_ADVERTISING
+    if (hci_le_extended_advertising_supported()){
+        if (hci_run_le_legacy_advertising_set()) return true;
+        if (hci_run_le_advertising_sets_modify()) return true;
+    }
+#endif
     if (hci_stack->le_advertisements_todo & LE_ADVERTISEMENT_TASKS_SET_PARAMS){
         hci_stack->le_advertisements_todo &= ~LE_ADVERTISEMENT_TASKS_SET_PARAMS;
         hci_send_cmd(&hci_le_set_advertising_parameters,
@@ -3917,30 +5366,23 @@ static bool hci_run_general_gap_le(void){
     // re-start scanning
     if ((hci_stack->le_scanning_enabled && !hci_stack->le_scanning_active)){
         hci_stack->le_scanning_active = true;
-        hci_send_cmd(&hci_le_set_scan_enable, 1, 0);
+        hci_send_le_scan_enable(1);
         return true;
     }
 #endif
 
+#ifdef ENABLE_LE_EXTENDED_ADVERTISING
+#ifdef ENABLE_LE_CENTRAL
+    if (hci_run_le_periodic_sync()) return true;
+#endif
+#endif
+
 #ifdef ENABLE_LE_CENTRAL
     // re-start connecting
     if ( (hci_stack->le_connecting_state == LE_CONNECTING_IDLE) && (hci_stack->le_connecting_request == LE_CONNECTING_WHITELIST)){
         bd_addr_t null_addr;
         memset(null_addr, 0, 6);
-        hci_send_cmd(&hci_le_create_connection,
-                     hci_stack->le_connection_scan_interval,    // scan interval: 60 ms
-                     hci_stack->le_connection_scan_window,    // scan interval: 30 ms
-                     1,         // use whitelist
-                     0,         // peer address type
-                     null_addr, // peer bd addr
-                     hci_stack->le_own_addr_type, // our addr type:
-                     hci_stack->le_connection_interval_min,    // conn interval min
-                     hci_stack->le_connection_interval_max,    // conn interval max
-                     hci_stack->le_connection_latency,         // conn latency
-                     hci_stack->le_supervision_timeout,        // conn latency
-                     hci_stack->le_minimum_ce_length,          // min ce length
-                     hci_stack->le_maximum_ce_length           // max ce length
-        );
+        hci_send_le_create_connection(1, BD_ADDR_TYPE_LE_PUBLIC, null_addr);
         return true;
     }
 #endif
@@ -3950,7 +5392,17 @@ static bool hci_run_general_gap_le(void){
     if (hci_stack->le_advertisements_enabled_for_current_roles && !hci_stack->le_advertisements_active){
         // check if advertisements should be enabled given
         hci_stack->le_advertisements_active = true;
-        hci_send_cmd(&hci_le_set_advertise_enable, 1);
+        if (hci_le_extended_advertising_supported()){
+            hci_send_cmd(&hci_le_set_extended_advertising_enable, 1, 1, 0, 0, 0);
+        } else {
+            hci_send_cmd(&hci_le_set_advertise_enable, 1);
+        }
+        return true;
+    }
+#endif
+
+#if defined(ENABLE_LE_PERIPHERAL) && defined(ENABLE_LE_EXTENDED_ADVERTISING)
+    if (hci_le_extended_advertising_supported() && hci_run_le_advertising_sets_start()){
         return true;
     }
 #endif
@@ -3977,20 +5429,7 @@ static bool hci_run_general_pending_commands(void){
 #ifdef ENABLE_BLE
 #ifdef ENABLE_LE_CENTRAL
                         log_info("sending hci_le_create_connection");
-                        hci_send_cmd(&hci_le_create_connection,
-                                     hci_stack->le_connection_scan_interval,    // conn scan interval
-                                     hci_stack->le_connection_scan_window,      // conn scan windows
-                                     0,         // don't use whitelist
-                                     connection->address_type, // peer address type
-                                     connection->address,      // peer bd addr
-                                     hci_stack->le_own_addr_type, // our addr type:
-                                     hci_stack->le_connection_interval_min,    // conn interval min
-                                     hci_stack->le_connection_interval_max,    // conn interval max
-                                     hci_stack->le_connection_latency,         // conn latency
-                                     hci_stack->le_supervision_timeout,        // conn latency
-                                     hci_stack->le_minimum_ce_length,          // min ce length
-                                     hci_stack->le_maximum_ce_length          // max ce length
-                        );
+                        hci_send_le_create_connection(0, connection->address_type, connection->address);
                         connection->state = SENT_CREATE_CONNECTION;
 #endif
 #endif
@@ -4417,6 +5856,7 @@ int hci_send_cmd_packet(uint8_t *packet, int size){
 #endif
 #ifdef ENABLE_LE_CENTRAL
     uint8_t initiator_filter_policy;
+    uint8_t peer_address_offset;
 #endif
 
     uint16_t opcode = little_endian_read_16(packet, 0);
@@ -4513,6 +5953,11 @@ int hci_send_cmd_packet(uint8_t *packet, int size){
         case HCI_OPCODE_HCI_LE_SET_RANDOM_ADDRESS:
             hci_stack->le_random_address_set = 1;
             reverse_bd_addr(&packet[3], hci_stack->le_random_address);
+#ifdef ENABLE_LE_PERIPHERAL
+#ifdef ENABLE_LE_EXTENDED_ADVERTISING
+            hci_le_advertising_sets_update_random_address();
+#endif
+#endif
             break;
 #ifdef ENABLE_LE_PERIPHERAL
         case HCI_OPCODE_HCI_LE_SET_ADVERTISE_ENABLE:
@@ -4521,8 +5966,11 @@ int hci_send_cmd_packet(uint8_t *packet, int size){
 #endif
 #ifdef ENABLE_LE_CENTRAL
         case HCI_OPCODE_HCI_LE_CREATE_CONNECTION:
+        case HCI_OPCODE_HCI_LE_EXTENDED_CREATE_CONNECTION:
+            // peer address type and address follow initiator filter policy in extended command
+            peer_address_offset = (opcode == HCI_OPCODE_HCI_LE_CREATE_CONNECTION) ? 8 : 5;
             // white list used?
-            initiator_filter_policy = packet[7];
+            initiator_filter_policy = (opcode == HCI_OPCODE_HCI_LE_CREATE_CONNECTION) ? packet[7] : packet[3];
             switch (initiator_filter_policy) {
                 case 0:
                     // whitelist not used
@@ -4536,8 +5984,8 @@ int hci_send_cmd_packet(uint8_t *packet, int size){
                     break;
             }
             // track outgoing connection
-            hci_stack->outgoing_addr_type = (bd_addr_type_t) packet[8]; // peer addres type
-            reverse_bd_addr( &packet[9], hci_stack->outgoing_addr); // peer address
+            hci_stack->outgoing_addr_type = (bd_addr_type_t) packet[peer_address_offset]; // peer addres type
+            reverse_bd_addr( &packet[peer_address_offset + 1], hci_stack->outgoing_addr); // peer address
             break;
         case HCI_OPCODE_HCI_LE_CREATE_CONNECTION_CANCEL:
             hci_stack->le_connecting_state = LE_CONNECTING_CANCEL;
@@ -4550,6 +5998,7 @@ int hci_send_cmd_packet(uint8_t *packet, int size){
 
     hci_stack->num_cmd_packets--;
 
+    BTSTACK_STATS_INCREMENT(HCI_COMMANDS_SENT);
     hci_dump_packet(HCI_COMMAND_DATA_PACKET, 0, packet, size);
     return hci_stack->hci_transport->send_packet(HCI_COMMAND_DATA_PACKET, packet, size);
 }
@@ -4639,8 +6088,18 @@ static void hci_emit_event(uint8_t * event, uint16_t size, int dump){
         hci_dump_packet( HCI_EVENT_PACKET, 0, event, size);
     } 
 
-    // dispatch to all event handlers
     btstack_linked_list_iterator_t it;
+
+#ifdef ENABLE_HCI_MULTIPLE_CONTROLLERS
+    // dispatch to stack layers that serve all controllers first
+    btstack_linked_list_iterator_init(&it, &hci_shared_event_handlers);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        btstack_packet_callback_registration_t * entry = (btstack_packet_callback_registration_t*) btstack_linked_list_iterator_next(&it);
+        entry->callback(HCI_EVENT_PACKET, 0, event, size);
+    }
+#endif
+
+    // dispatch to all event handlers
     btstack_linked_list_iterator_init(&it, &hci_stack->event_handlers);
     while (btstack_linked_list_iterator_has_next(&it)){
         btstack_packet_callback_registration_t * entry = (btstack_packet_callback_registration_t*) btstack_linked_list_iterator_next(&it);
@@ -5088,6 +6547,40 @@ void gap_set_local_name(const char * local_name){
 #ifdef ENABLE_BLE
 
 #ifdef ENABLE_LE_CENTRAL
+#ifdef ENABLE_LE_SCAN_FILTER
+void gap_le_scan_filter_add(gap_le_scan_filter_t * filter){
+    filter->num_matches = 0;
+    btstack_linked_list_add_tail(&hci_stack->le_scan_filters, (btstack_linked_item_t *) filter);
+}
+
+void gap_le_scan_filter_remove(gap_le_scan_filter_t * filter){
+    btstack_linked_list_remove(&hci_stack->le_scan_filters, (btstack_linked_item_t *) filter);
+}
+
+void gap_le_scan_filter_set_duplicate_window(uint32_t window_ms){
+    hci_stack->le_scan_filter_duplicate_window_ms = window_ms;
+    memset(hci_stack->le_scan_filter_duplicates, 0, sizeof(hci_stack->le_scan_filter_duplicates));
+}
+
+void gap_le_scan_filter_get_counters(uint32_t * num_reports, uint32_t * num_dropped, uint32_t * num_duplicates){
+    *num_reports    = hci_stack->le_scan_filter_num_reports;
+    *num_dropped    = hci_stack->le_scan_filter_num_dropped;
+    *num_duplicates = hci_stack->le_scan_filter_num_duplicates;
+}
+
+void gap_le_scan_filter_reset_counters(void){
+    hci_stack->le_scan_filter_num_reports    = 0;
+    hci_stack->le_scan_filter_num_dropped    = 0;
+    hci_stack->le_scan_filter_num_duplicates = 0;
+    btstack_linked_list_iterator_t it;
+    btstack_linked_list_iterator_init(&it, &hci_stack->le_scan_filters);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        gap_le_scan_filter_t * filter = (gap_le_scan_filter_t *) btstack_linked_list_iterator_next(&it);
+        filter->num_matches = 0;
+    }
+}
+#endif
+
 void gap_start_scan(void){
     hci_stack->le_scanning_enabled = true;
     hci_run();
@@ -5111,6 +6604,52 @@ void gap_set_scan_parameters(uint8_t scan_type, uint16_t scan_interval, uint16_t
     gap_set_scan_params(scan_type, scan_interval, scan_window, 0);
 }
 
+#ifdef ENABLE_LE_EXTENDED_ADVERTISING
+void gap_set_scan_phys(uint8_t phys){
+    // only LE 1M and LE Coded PHY can be used for scanning
+    hci_stack->le_scan_phys = phys & 0x05u;
+    hci_stack->le_scanning_param_update = true;
+    hci_run();
+}
+
+uint8_t gap_periodic_advertising_create_sync(uint8_t options, uint8_t advertising_sid, bd_addr_type_t advertiser_address_type,
+                                             const bd_addr_t advertiser_address, uint16_t skip, uint16_t sync_timeout){
+    if (hci_stack->le_periodic_sync_request != LE_PERIODIC_SYNC_REQUEST_IDLE) return ERROR_CODE_COMMAND_DISALLOWED;
+    hci_stack->le_periodic_sync_options = options;
+    hci_stack->le_periodic_sync_advertising_sid = advertising_sid;
+    hci_stack->le_periodic_sync_advertiser_address_type = advertiser_address_type;
+    (void)memcpy(hci_stack->le_periodic_sync_advertiser_address, advertiser_address, 6);
+    hci_stack->le_periodic_sync_skip = skip;
+    hci_stack->le_periodic_sync_timeout = sync_timeout;
+    hci_stack->le_periodic_sync_request = LE_PERIODIC_SYNC_REQUEST_CREATE;
+    hci_run();
+    return ERROR_CODE_SUCCESS;
+}
+
+uint8_t gap_periodic_advertising_create_sync_cancel(void){
+    switch (hci_stack->le_periodic_sync_request){
+        case LE_PERIODIC_SYNC_REQUEST_CREATE:
+            // not sent yet
+            hci_stack->le_periodic_sync_request = LE_PERIODIC_SYNC_REQUEST_IDLE;
+            return ERROR_CODE_SUCCESS;
+        case LE_PERIODIC_SYNC_REQUEST_IDLE:
+            hci_stack->le_periodic_sync_request = LE_PERIODIC_SYNC_REQUEST_CANCEL;
+            hci_run();
+            return ERROR_CODE_SUCCESS;
+        default:
+            return ERROR_CODE_COMMAND_DISALLOWED;
+    }
+}
+
+uint8_t gap_periodic_advertising_terminate_sync(uint16_t sync_handle){
+    if (hci_stack->le_periodic_sync_request != LE_PERIODIC_SYNC_REQUEST_IDLE) return ERROR_CODE_COMMAND_DISALLOWED;
+    hci_stack->le_periodic_sync_handle = sync_handle;
+    hci_stack->le_periodic_sync_request = LE_PERIODIC_SYNC_REQUEST_TERMINATE;
+    hci_run();
+    return ERROR_CODE_SUCCESS;
+}
+#endif
+
 uint8_t gap_connect(const bd_addr_t addr, bd_addr_type_t addr_type){
     hci_connection_t * conn = hci_connection_for_bd_addr_and_type(addr, addr_type);
     if (!conn){
@@ -5341,6 +6880,127 @@ void gap_advertisements_enable(int enabled){
     hci_run();
 }
 
+#ifdef ENABLE_LE_EXTENDED_ADVERTISING
+uint8_t gap_extended_advertising_setup(le_advertising_set_t * storage, const le_extended_advertising_parameters_t * advertising_parameters, uint8_t * out_advertising_handle){
+    if ((hci_stack->state == HCI_STATE_WORKING) && !hci_le_extended_advertising_supported()){
+        return ERROR_CODE_UNSUPPORTED_FEATURE_OR_PARAMETER_VALUE;
+    }
+    // find free advertising handle, 0 is used for legacy advertising
+    uint8_t advertising_handle;
+    for (advertising_handle = 1; advertising_handle <= LE_EXTENDED_ADVERTISING_MAX_HANDLE; advertising_handle++){
+        if (hci_advertising_set_for_handle(advertising_handle) == NULL) break;
+    }
+    if (advertising_handle > LE_EXTENDED_ADVERTISING_MAX_HANDLE){
+        return ERROR_CODE_MEMORY_CAPACITY_EXCEEDED;
+    }
+    memset(storage, 0, sizeof(le_advertising_set_t));
+    storage->advertising_handle = advertising_handle;
+    (void)memcpy(&storage->extended_params, advertising_parameters, sizeof(le_extended_advertising_parameters_t));
+    storage->tasks = LE_ADVERTISEMENT_TASKS_SET_PARAMS;
+    btstack_linked_list_add_tail(&hci_stack->le_advertising_sets, (btstack_linked_item_t *) storage);
+    *out_advertising_handle = advertising_handle;
+    hci_run();
+    return ERROR_CODE_SUCCESS;
+}
+
+uint8_t gap_extended_advertising_set_params(uint8_t advertising_handle, const le_extended_advertising_parameters_t * advertising_parameters){
+    le_advertising_set_t * advertising_set = hci_advertising_set_for_handle(advertising_handle);
+    if (advertising_set == NULL) return ERROR_CODE_UNKNOWN_ADVERTISING_IDENTIFIER;
+    (void)memcpy(&advertising_set->extended_params, advertising_parameters, sizeof(le_extended_advertising_parameters_t));
+    advertising_set->tasks |= LE_ADVERTISEMENT_TASKS_SET_PARAMS;
+    hci_run();
+    return ERROR_CODE_SUCCESS;
+}
+
+uint8_t gap_extended_advertising_set_adv_data(uint8_t advertising_handle, uint16_t advertising_data_length, const uint8_t * advertising_data){
+    le_advertising_set_t * advertising_set = hci_advertising_set_for_handle(advertising_handle);
+    if (advertising_set == NULL) return ERROR_CODE_UNKNOWN_ADVERTISING_IDENTIFIER;
+    if (advertising_data_length > LE_EXTENDED_ADVERTISING_MAX_DATA_LEN) return ERROR_CODE_INVALID_HCI_COMMAND_PARAMETERS;
+    advertising_set->adv_data = advertising_data;
+    advertising_set->adv_data_len = advertising_data_length;
+    advertising_set->adv_data_pos = 0;
+    advertising_set->tasks |= LE_ADVERTISEMENT_TASKS_SET_ADV_DATA;
+    hci_run();
+    return ERROR_CODE_SUCCESS;
+}
+
+uint8_t gap_extended_advertising_set_scan_response_data(uint8_t advertising_handle, uint16_t scan_response_data_length, const uint8_t * scan_response_data){
+    le_advertising_set_t * advertising_set = hci_advertising_set_for_handle(advertising_handle);
+    if (advertising_set == NULL) return ERROR_CODE_UNKNOWN_ADVERTISING_IDENTIFIER;
+    if (scan_response_data_length > LE_EXTENDED_ADVERTISING_MAX_DATA_LEN) return ERROR_CODE_INVALID_HCI_COMMAND_PARAMETERS;
+    advertising_set->scan_data = scan_response_data;
+    advertising_set->scan_data_len = scan_response_data_length;
+    advertising_set->scan_data_pos = 0;
+    advertising_set->tasks |= LE_ADVERTISEMENT_TASKS_SET_SCAN_DATA;
+    hci_run();
+    return ERROR_CODE_SUCCESS;
+}
+
+uint8_t gap_extended_advertising_start(uint8_t advertising_handle, uint16_t timeout, uint8_t num_extended_advertising_events){
+    le_advertising_set_t * advertising_set = hci_advertising_set_for_handle(advertising_handle);
+    if (advertising_set == NULL) return ERROR_CODE_UNKNOWN_ADVERTISING_IDENTIFIER;
+    advertising_set->enable_timeout = timeout;
+    advertising_set->enable_max_events = num_extended_advertising_events;
+    advertising_set->state |= LE_ADVERTISEMENT_STATE_ENABLED;
+    hci_run();
+    return ERROR_CODE_SUCCESS;
+}
+
+uint8_t gap_extended_advertising_stop(uint8_t advertising_handle){
+    le_advertising_set_t * advertising_set = hci_advertising_set_for_handle(advertising_handle);
+    if (advertising_set == NULL) return ERROR_CODE_UNKNOWN_ADVERTISING_IDENTIFIER;
+    advertising_set->state &= ~LE_ADVERTISEMENT_STATE_ENABLED;
+    hci_run();
+    return ERROR_CODE_SUCCESS;
+}
+
+uint8_t gap_extended_advertising_remove(uint8_t advertising_handle){
+    le_advertising_set_t * advertising_set = hci_advertising_set_for_handle(advertising_handle);
+    if (advertising_set == NULL) return ERROR_CODE_UNKNOWN_ADVERTISING_IDENTIFIER;
+    advertising_set->state &= ~(LE_ADVERTISEMENT_STATE_ENABLED | LE_ADVERTISEMENT_STATE_PERIODIC_ENABLED);
+    advertising_set->tasks = LE_ADVERTISEMENT_TASKS_REMOVE_SET;
+    hci_run();
+    return ERROR_CODE_SUCCESS;
+}
+
+uint8_t gap_periodic_advertising_set_params(uint8_t advertising_handle, const le_periodic_advertising_parameters_t * periodic_advertising_parameters){
+    le_advertising_set_t * advertising_set = hci_advertising_set_for_handle(advertising_handle);
+    if (advertising_set == NULL) return ERROR_CODE_UNKNOWN_ADVERTISING_IDENTIFIER;
+    (void)memcpy(&advertising_set->periodic_params, periodic_advertising_parameters, sizeof(le_periodic_advertising_parameters_t));
+    advertising_set->tasks |= LE_ADVERTISEMENT_TASKS_SET_PERIODIC_PARAMS;
+    hci_run();
+    return ERROR_CODE_SUCCESS;
+}
+
+uint8_t gap_periodic_advertising_set_data(uint8_t advertising_handle, uint16_t periodic_data_length, const uint8_t * periodic_data){
+    le_advertising_set_t * advertising_set = hci_advertising_set_for_handle(advertising_handle);
+    if (advertising_set == NULL) return ERROR_CODE_UNKNOWN_ADVERTISING_IDENTIFIER;
+    if (periodic_data_length > LE_EXTENDED_ADVERTISING_MAX_DATA_LEN) return ERROR_CODE_INVALID_HCI_COMMAND_PARAMETERS;
+    advertising_set->periodic_data = periodic_data;
+    advertising_set->periodic_data_len = periodic_data_length;
+    advertising_set->periodic_data_pos = 0;
+    advertising_set->tasks |= LE_ADVERTISEMENT_TASKS_SET_PERIODIC_DATA;
+    hci_run();
+    return ERROR_CODE_SUCCESS;
+}
+
+uint8_t gap_periodic_advertising_start(uint8_t advertising_handle){
+    le_advertising_set_t * advertising_set = hci_advertising_set_for_handle(advertising_handle);
+    if (advertising_set == NULL) return ERROR_CODE_UNKNOWN_ADVERTISING_IDENTIFIER;
+    advertising_set->state |= LE_ADVERTISEMENT_STATE_PERIODIC_ENABLED;
+    hci_run();
+    return ERROR_CODE_SUCCESS;
+}
+
+uint8_t gap_periodic_advertising_stop(uint8_t advertising_handle){
+    le_advertising_set_t * advertising_set = hci_advertising_set_for_handle(advertising_handle);
+    if (advertising_set == NULL) return ERROR_CODE_UNKNOWN_ADVERTISING_IDENTIFIER;
+    advertising_set->state &= ~LE_ADVERTISEMENT_STATE_PERIODIC_ENABLED;
+    hci_run();
+    return ERROR_CODE_SUCCESS;
+}
+#endif
+
 #endif
 
 void hci_le_set_own_address_type(uint8_t own_address_type){
@@ -5875,6 +7535,11 @@ uint16_t hci_get_manufacturer(void){
     return hci_stack->manufacturer;
 }
 
+uint32_t hci_get_init_phase_duration_ms(hci_init_phase_t phase){
+    if (phase >= HCI_INIT_PHASE_NUM) return 0;
+    return hci_stack->init_phase_duration_ms[phase];
+}
+
 #ifdef ENABLE_BLE
 
 static sm_connection_t * sm_get_connection_for_handle(hci_con_handle_t con_handle){
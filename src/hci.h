@@ -56,6 +56,7 @@
 #include "gap.h"
 #include "hci_transport.h"
 #include "btstack_run_loop.h"
+#include "btstack_stats.h"
 
 #ifdef ENABLE_BLE
 #include "ble/att_db.h"
@@ -451,6 +452,9 @@ typedef struct {
     btstack_linked_list_t   notification_requests;
     btstack_linked_list_t   indication_requests;
 
+    // written by client to GATT Client Supported Features characteristic
+    uint8_t                 client_supported_features;
+
 #ifdef ENABLE_GATT_OVER_CLASSIC
     uint16_t                l2cap_cid;
 #endif
@@ -591,6 +595,10 @@ typedef struct {
     l2cap_state_t l2cap_state;
 #endif
 
+#ifdef ENABLE_BTSTACK_STATS
+    btstack_stats_traffic_t stats;
+#endif
+
 } hci_connection_t;
 
 
@@ -712,10 +720,51 @@ typedef enum hci_init_state{
 
 } hci_substate_t;
 
+// phases of the HCI initialization, see hci_get_init_phase_duration_ms
+typedef enum {
+    HCI_INIT_PHASE_RESET = 0,       // HCI Reset
+    HCI_INIT_PHASE_CHIPSET,         // local version/name, baud rate change, init script, supported commands
+    HCI_INIT_PHASE_CAPABILITIES,    // BD_ADDR, buffer sizes, supported features
+    HCI_INIT_PHASE_CONFIGURATION,   // event masks, Classic and LE settings
+    HCI_INIT_PHASE_NUM
+} hci_init_phase_t;
+
+#ifdef ENABLE_HCI_INIT_PIPELINING
+#ifndef HCI_INIT_PIPELINE_DEPTH
+#define HCI_INIT_PIPELINE_DEPTH 4
+#endif
+#endif
+
+#ifdef ENABLE_HCI_CAPABILITIES_CACHE
+// Command Complete return parameters of Read Buffer Size, Read Local Supported Features,
+// LE Read Buffer Size, LE Read Maximum Data Length and LE Read White List Size, each as opcode (2), len (1), params
+#define HCI_CAPABILITIES_CACHE_DATA_LEN 48
+
+typedef struct {
+    // key: hci version, hci revision, lmp version, manufacturer, lmp subversion + bd addr
+    uint8_t   local_version_information[8];
+    bd_addr_t local_bd_addr;
+    uint8_t   data_len;
+    uint8_t   data[HCI_CAPABILITIES_CACHE_DATA_LEN];
+} hci_capabilities_cache_t;
+#endif
+
+enum {
+    LE_ADVERTISEMENT_TASKS_SET_ADV_DATA         = 1 << 0,
+    LE_ADVERTISEMENT_TASKS_SET_SCAN_DATA        = 1 << 1,
+    LE_ADVERTISEMENT_TASKS_SET_PARAMS           = 1 << 2,
+    LE_ADVERTISEMENT_TASKS_SET_ADDRESS          = 1 << 3,
+    LE_ADVERTISEMENT_TASKS_SET_PERIODIC_PARAMS  = 1 << 4,
+    LE_ADVERTISEMENT_TASKS_SET_PERIODIC_DATA    = 1 << 5,
+    LE_ADVERTISEMENT_TASKS_REMOVE_SET           = 1 << 6,
+};
+
+// state of LE Extended Advertising Set
 enum {
-    LE_ADVERTISEMENT_TASKS_SET_ADV_DATA  = 1 << 0,
-    LE_ADVERTISEMENT_TASKS_SET_SCAN_DATA = 1 << 1,
-    LE_ADVERTISEMENT_TASKS_SET_PARAMS    = 1 << 2,
+    LE_ADVERTISEMENT_STATE_ACTIVE               = 1 << 0,
+    LE_ADVERTISEMENT_STATE_ENABLED              = 1 << 1,
+    LE_ADVERTISEMENT_STATE_PERIODIC_ACTIVE      = 1 << 2,
+    LE_ADVERTISEMENT_STATE_PERIODIC_ENABLED     = 1 << 3,
 };
 
 enum {
@@ -731,6 +780,53 @@ typedef struct {
     uint8_t        state;   
 } whitelist_entry_t;
 
+#ifdef ENABLE_LE_SCAN_FILTER
+#ifndef LE_SCAN_FILTER_DUPLICATE_ENTRIES
+#define LE_SCAN_FILTER_DUPLICATE_ENTRIES 16
+#endif
+
+// recently forwarded advertising report, used for duplicate suppression
+typedef struct {
+    bd_addr_t address;
+    uint8_t   address_type;
+    uint8_t   event_type;
+    uint32_t  data_hash;
+    uint32_t  timestamp_ms;
+} le_scan_filter_duplicate_t;
+#endif
+
+#ifdef ENABLE_LE_EXTENDED_ADVERTISING
+#ifndef LE_EXTENDED_ADVERTISING_MAX_DATA_LEN
+#define LE_EXTENDED_ADVERTISING_MAX_DATA_LEN 1650
+#endif
+// highest advertising handle, handle 0 is used for legacy advertising
+#define LE_EXTENDED_ADVERTISING_MAX_HANDLE 0xEF
+
+#ifndef LE_EXTENDED_ADVERTISING_REASSEMBLY_BUFFERS
+#define LE_EXTENDED_ADVERTISING_REASSEMBLY_BUFFERS 2
+#endif
+
+// type (1), len (1), fixed fields of GAP_EVENT_EXTENDED_ADVERTISING_REPORT (23), data length (2)
+#define LE_EXTENDED_ADVERTISING_REPORT_HEADER_SIZE 27
+
+// max data per GAP_EVENT_EXTENDED_ADVERTISING_REPORT with 8 bit event length field
+#define LE_EXTENDED_ADVERTISING_REPORT_MAX_FRAGMENT_LEN (255u + 2u - LE_EXTENDED_ADVERTISING_REPORT_HEADER_SIZE)
+
+// chained LE Extended Advertising Reports are collected as GAP_EVENT_EXTENDED_ADVERTISING_REPORT
+typedef struct {
+    bool      active;
+    uint32_t  sequence_nr;
+    uint8_t   event[LE_EXTENDED_ADVERTISING_REPORT_HEADER_SIZE + LE_EXTENDED_ADVERTISING_MAX_DATA_LEN];
+} le_extended_advertising_reassembly_t;
+
+typedef enum {
+    LE_PERIODIC_SYNC_REQUEST_IDLE,
+    LE_PERIODIC_SYNC_REQUEST_CREATE,
+    LE_PERIODIC_SYNC_REQUEST_CANCEL,
+    LE_PERIODIC_SYNC_REQUEST_TERMINATE,
+} le_periodic_sync_request_t;
+#endif
+
 #define MAX_NUM_RESOLVING_LIST_ENTRIES 64
 typedef enum {
     LE_RESOLVING_LIST_SEND_ENABLE_ADDRESS_RESOLUTION,
@@ -802,6 +898,11 @@ typedef struct {
     uint8_t   * hci_packet_buffer;
     uint8_t   hci_packet_buffer_data[HCI_OUTGOING_PRE_BUFFER_SIZE + HCI_OUTGOING_PACKET_BUFFER_SIZE];
     uint8_t   hci_packet_buffer_reserved;
+#ifdef ENABLE_BTSTACK_STATS
+    // ACL credit stall and packet buffer contention are counted once until credits or buffer become available again
+    uint8_t   stats_acl_credit_stall;
+    uint8_t   stats_packet_buffer_contention;
+#endif
     uint16_t  acl_fragmentation_pos;
     uint16_t  acl_fragmentation_total_size;
     uint8_t   acl_fragmentation_tx_active;
@@ -854,6 +955,27 @@ typedef struct {
 
     uint16_t  last_cmd_opcode;
 
+#ifdef ENABLE_HCI_INIT_PIPELINING
+    // opcodes of init commands sent but not completed yet
+    uint16_t  init_pipeline_opcodes[HCI_INIT_PIPELINE_DEPTH];
+    uint8_t   init_pipeline_outstanding;
+    // chipset result kept until outstanding init script commands are complete
+    bool      init_script_result_pending;
+#endif
+
+#ifdef ENABLE_HCI_CAPABILITIES_CACHE
+    hci_capabilities_cache_t capabilities_cache;
+    bool      capabilities_cache_hit;
+#endif
+
+    // init timing
+    hci_init_phase_t init_phase;
+    uint32_t  init_phase_start_ms;
+    uint32_t  init_phase_duration_ms[HCI_INIT_PHASE_NUM];
+    uint32_t  init_script_start_ms;
+    uint32_t  init_script_num_bytes;
+    uint16_t  init_script_num_commands;
+
     uint8_t   cmds_ready;
 
     /* buffer for scan enable cmd - 0xff no change */
@@ -914,6 +1036,31 @@ typedef struct {
     uint16_t le_scan_interval;
     uint16_t le_scan_window;
 
+#ifdef ENABLE_LE_SCAN_FILTER
+    btstack_linked_list_t le_scan_filters;
+    uint32_t le_scan_filter_duplicate_window_ms;
+    le_scan_filter_duplicate_t le_scan_filter_duplicates[LE_SCAN_FILTER_DUPLICATE_ENTRIES];
+    uint32_t le_scan_filter_num_reports;
+    uint32_t le_scan_filter_num_dropped;
+    uint32_t le_scan_filter_num_duplicates;
+#endif
+
+#ifdef ENABLE_LE_EXTENDED_ADVERTISING
+    uint8_t  le_scan_phys;
+    le_extended_advertising_reassembly_t le_extended_advertising_reassembly[LE_EXTENDED_ADVERTISING_REASSEMBLY_BUFFERS];
+    uint32_t le_extended_advertising_reassembly_sequence_nr;
+
+    // Periodic Advertising Sync
+    le_periodic_sync_request_t le_periodic_sync_request;
+    uint8_t   le_periodic_sync_options;
+    uint8_t   le_periodic_sync_advertising_sid;
+    bd_addr_type_t le_periodic_sync_advertiser_address_type;
+    bd_addr_t le_periodic_sync_advertiser_address;
+    uint16_t  le_periodic_sync_skip;
+    uint16_t  le_periodic_sync_timeout;
+    uint16_t  le_periodic_sync_handle;
+#endif
+
     // Connection parameters
     uint16_t le_connection_interval_min;
     uint16_t le_connection_interval_max;
@@ -948,6 +1095,11 @@ typedef struct {
     bd_addr_t le_advertisements_direct_address;
 
     uint8_t le_max_number_peripheral_connections;
+
+#ifdef ENABLE_LE_EXTENDED_ADVERTISING
+    btstack_linked_list_t le_advertising_sets;
+    bool le_advertisements_legacy_set_configured;
+#endif
 #endif
 
 #ifdef ENABLE_LE_DATA_LENGTH_EXTENSION
@@ -1042,6 +1194,50 @@ int  hci_power_control(HCI_POWER_MODE mode);
  */
 void hci_close(void);
 
+#ifdef ENABLE_HCI_MULTIPLE_CONTROLLERS
+/**
+ * @brief Add secondary Controller with its own HCI state. Needs to be called after hci_init.
+ * @note L2CAP channels use the Controller of their connection. Fixed channels (ATT, SM, Connectionless)
+ *       and all higher layers only use the primary Controller 0 set up by hci_init,
+ *       ATT requests and SM pairing received on other Controllers are rejected
+ * @param transport for this Controller, must not be used by another Controller
+ * @param config for transport
+ * @return controller index or -1 if MAX_NR_HCI_CONTROLLERS already added
+ */
+int hci_add_controller(const hci_transport_t *transport, const void *config);
+
+/**
+ * @brief Get number of Controllers
+ * @return num controllers
+ */
+uint8_t hci_get_num_controllers(void);
+
+/**
+ * @brief Select Controller used by all following HCI and GAP calls, e.g. hci_power_control, hci_add_event_handler or gap_connect
+ * @note Events are delivered with the Controller that received them selected. Select the primary Controller again after configuring another one
+ * @param controller_index
+ */
+void hci_select_controller(uint8_t controller_index);
+
+/**
+ * @brief Get selected Controller
+ * @return controller index
+ */
+uint8_t hci_get_selected_controller(void);
+
+/**
+ * @brief Get working Controller with the fewest connections, e.g. to spread outgoing LE connections
+ * @return controller index
+ */
+uint8_t hci_get_controller_with_fewest_connections(void);
+
+/**
+ * @brief Add event packet handler that receives the events of all Controllers. Used by L2CAP
+ * @note Events are delivered with the Controller that received them selected
+ */
+void hci_add_shared_event_handler(btstack_packet_callback_registration_t * callback_handler);
+#endif
+
 
 // Callback registration
 
@@ -1052,7 +1248,7 @@ void hci_close(void);
 void hci_add_event_handler(btstack_packet_callback_registration_t * callback_handler);
 
 /**
- * @brief Registers a packet handler for ACL data. Used by L2CAP
+ * @brief Registers a packet handler for ACL data of all Controllers. Used by L2CAP
  */
 void hci_register_acl_packet_handler(btstack_packet_handler_t handler);
 
@@ -1284,6 +1480,13 @@ void hci_remove_le_device_db_entry_from_resolving_list(uint16_t le_device_db_ind
  */
 uint16_t hci_get_manufacturer(void);
 
+/**
+ * @brief Get duration of HCI initialization phase of last power on
+ * @param phase
+ * @return duration in ms
+ */
+uint32_t hci_get_init_phase_duration_ms(hci_init_phase_t phase);
+
 /**
  * Defer halt. Used by btstack_crypto to allow current HCI operation to complete
  */
@@ -52,6 +52,9 @@
 
 #include <string.h>
 
+// max number of fields in array format '[...]'
+#define HCI_CMD_MAX_ARRAY_FIELDS 8
+
 // calculate combined ogf/ocf value
 #define OPCODE(ogf, ocf) ((ocf) | ((ogf) << 10))
 
@@ -69,6 +72,10 @@
  *   A: 31 bytes advertising data
  *   S: Service Record (Data Element Sequence)
  *   Q: 32 byte data block, e.g. for X and Y coordinates of P-256 public key
+ *   J: 8 bit length of following variable-length data block 'V'
+ *   V: variable-length data block, length given by preceding 'J'
+ *   b: 8 bit bitmask, number of set bits gives number of entries in following array
+ *   [...]: array of entries, each field passed as pointer to array of uint8_t ('1') or uint16_t ('2')
  */
 uint16_t hci_cmd_create_from_template(uint8_t *hci_cmd_buffer, const hci_cmd_t *cmd, va_list argptr){
     
@@ -80,6 +87,10 @@ uint16_t hci_cmd_create_from_template(uint8_t *hci_cmd_buffer, const hci_cmd_t *
     uint16_t word;
     uint32_t longword;
     uint8_t * ptr;
+#ifdef ENABLE_BLE
+    uint8_t var_len_arg = 0;
+    uint8_t array_size = 0;
+#endif
     while (*format) {
         switch(*format) {
             case '1': //  8 bit value
@@ -150,6 +161,44 @@ uint16_t hci_cmd_create_from_template(uint8_t *hci_cmd_buffer, const hci_cmd_t *
                 (void)memcpy(&hci_cmd_buffer[pos], ptr, 31);
                 pos += 31;
                 break;
+            case 'J': // 8 bit length of variable-length data
+                word = va_arg(argptr, int);
+                var_len_arg = word & 0xffu;
+                hci_cmd_buffer[pos++] = var_len_arg;
+                break;
+            case 'V': // variable-length data
+                ptr = va_arg(argptr, uint8_t *);
+                (void)memcpy(&hci_cmd_buffer[pos], ptr, var_len_arg);
+                pos += var_len_arg;
+                break;
+            case 'b': // bitmask, one array entry per set bit
+                word = va_arg(argptr, int);
+                hci_cmd_buffer[pos++] = word & 0xffu;
+                array_size = (uint8_t) count_set_bits_uint32(word & 0xffu);
+                break;
+            case '[': { // array, fields are passed as pointers to arrays
+                const void * array_fields[HCI_CMD_MAX_ARRAY_FIELDS];
+                const char * array_format = format + 1;
+                uint8_t num_fields = 0;
+                while ((array_format[num_fields] != ']') && (num_fields < HCI_CMD_MAX_ARRAY_FIELDS)){
+                    array_fields[num_fields++] = va_arg(argptr, const void *);
+                }
+                uint8_t i;
+                uint8_t j;
+                for (i = 0; i < array_size; i++){
+                    for (j = 0; j < num_fields; j++){
+                        if (array_format[j] == '2'){
+                            little_endian_store_16(hci_cmd_buffer, pos, ((const uint16_t *) array_fields[j])[i]);
+                            pos += 2;
+                        } else {
+                            hci_cmd_buffer[pos++] = ((const uint8_t *) array_fields[j])[i];
+                        }
+                    }
+                }
+                // continue after closing bracket
+                format += num_fields + 1u;
+                break;
+            }
 #endif
 #ifdef ENABLE_SDP
             case 'S': { // Service Record (Data Element Sequence)
@@ -1371,6 +1420,207 @@ const hci_cmd_t hci_le_set_phy = {
 // LE PHY Update Complete is generated on completion
 };
 
+/**
+ * @param advertising_handle
+ * @param random_address
+ */
+const hci_cmd_t hci_le_set_advertising_set_random_address = {
+    HCI_OPCODE_HCI_LE_SET_ADVERTISING_SET_RANDOM_ADDRESS, "1B"
+    // return: status
+};
+
+/**
+ * @param advertising_handle
+ * @param advertising_event_properties
+ * @param primary_advertising_interval_min in 0.625 ms, range: 0x000020..0xffffff
+ * @param primary_advertising_interval_max in 0.625 ms, range: 0x000020..0xffffff
+ * @param primary_advertising_channel_map
+ * @param own_address_type
+ * @param peer_address_type
+ * @param peer_address
+ * @param advertising_filter_policy
+ * @param advertising_tx_power
+ * @param primary_advertising_phy
+ * @param secondary_advertising_max_skip
+ * @param secondary_advertising_phy
+ * @param advertising_sid
+ * @param scan_request_notification_enable
+ */
+const hci_cmd_t hci_le_set_extended_advertising_parameters = {
+    HCI_OPCODE_HCI_LE_SET_EXTENDED_ADVERTISING_PARAMETERS, "1233111B1111111"
+    // return: status, selected tx power
+};
+
+/**
+ * @param advertising_handle
+ * @param operation
+ * @param fragment_preference
+ * @param advertising_data_length
+ * @param advertising_data
+ */
+const hci_cmd_t hci_le_set_extended_advertising_data = {
+    HCI_OPCODE_HCI_LE_SET_EXTENDED_ADVERTISING_DATA, "111JV"
+    // return: status
+};
+
+/**
+ * @param advertising_handle
+ * @param operation
+ * @param fragment_preference
+ * @param scan_response_data_length
+ * @param scan_response_data
+ */
+const hci_cmd_t hci_le_set_extended_scan_response_data = {
+    HCI_OPCODE_HCI_LE_SET_EXTENDED_SCAN_RESPONSE_DATA, "111JV"
+    // return: status
+};
+
+/**
+ * @param enable
+ * @param number_of_sets, only 0 (disable all) or 1 supported
+ * @param advertising_handle
+ * @param duration in 10 ms, 0 = no timeout
+ * @param max_extended_advertising_events, 0 = no maximum
+ */
+const hci_cmd_t hci_le_set_extended_advertising_enable = {
+    HCI_OPCODE_HCI_LE_SET_EXTENDED_ADVERTISING_ENABLE, "11121"
+    // return: status
+};
+
+/**
+ */
+const hci_cmd_t hci_le_read_maximum_advertising_data_length = {
+    HCI_OPCODE_HCI_LE_READ_MAXIMUM_ADVERTISING_DATA_LENGTH, ""
+    // return: status, max advertising data length
+};
+
+/**
+ */
+const hci_cmd_t hci_le_read_number_of_supported_advertising_sets = {
+    HCI_OPCODE_HCI_LE_READ_NUMBER_OF_SUPPORTED_ADVERTISING_SETS, ""
+    // return: status, number of supported advertising sets
+};
+
+/**
+ * @param advertising_handle
+ */
+const hci_cmd_t hci_le_remove_advertising_set = {
+    HCI_OPCODE_HCI_LE_REMOVE_ADVERTISING_SET, "1"
+    // return: status
+};
+
+/**
+ */
+const hci_cmd_t hci_le_clear_advertising_sets = {
+    HCI_OPCODE_HCI_LE_CLEAR_ADVERTISING_SETS, ""
+    // return: status
+};
+
+/**
+ * @param advertising_handle
+ * @param periodic_advertising_interval_min in 1.25 ms, range: 0x0006..0xffff
+ * @param periodic_advertising_interval_max in 1.25 ms, range: 0x0006..0xffff
+ * @param periodic_advertising_properties
+ */
+const hci_cmd_t hci_le_set_periodic_advertising_parameters = {
+    HCI_OPCODE_HCI_LE_SET_PERIODIC_ADVERTISING_PARAMETERS, "1222"
+    // return: status
+};
+
+/**
+ * @param advertising_handle
+ * @param operation
+ * @param advertising_data_length
+ * @param advertising_data
+ */
+const hci_cmd_t hci_le_set_periodic_advertising_data = {
+    HCI_OPCODE_HCI_LE_SET_PERIODIC_ADVERTISING_DATA, "11JV"
+    // return: status
+};
+
+/**
+ * @param enable
+ * @param advertising_handle
+ */
+const hci_cmd_t hci_le_set_periodic_advertising_enable = {
+    HCI_OPCODE_HCI_LE_SET_PERIODIC_ADVERTISING_ENABLE, "11"
+    // return: status
+};
+
+/**
+ * @param own_address_type
+ * @param scanning_filter_policy
+ * @param scanning_phys with bit 0 = LE 1M PHY, bit 2 = LE Coded PHY
+ * @param scan_type array, one entry per scanning PHY
+ * @param scan_interval array in 0.625 ms, range: 0x0004..0xffff
+ * @param scan_window array in 0.625 ms, range: 0x0004..0xffff
+ */
+const hci_cmd_t hci_le_set_extended_scan_parameters = {
+    HCI_OPCODE_HCI_LE_SET_EXTENDED_SCAN_PARAMETERS, "11b[122]"
+    // return: status
+};
+
+/**
+ * @param enable
+ * @param filter_duplicates
+ * @param duration 0 = Scan continuously until explicitly disable, 10 ms
+ * @param period 0 = Scan continuously, 1.28 s
+ */
+const hci_cmd_t hci_le_set_extended_scan_enable = {
+    HCI_OPCODE_HCI_LE_SET_EXTENDED_SCAN_ENABLE, "1122"
+    // return: status
+};
+
+/**
+ * @param initiator_filter_policy
+ * @param own_address_type
+ * @param peer_address_type
+ * @param peer_address
+ * @param initiating_phys with bit 0 = LE 1M PHY, bit 1 = LE 2M PHY, bit 2 = LE Coded PHY
+ * @param scan_interval array in 0.625 ms, one entry per initiating PHY
+ * @param scan_window array in 0.625 ms
+ * @param connection_interval_min array in 1.25 ms
+ * @param connection_interval_max array in 1.25 ms
+ * @param connection_latency array
+ * @param supervision_timeout array in 10 ms
+ * @param min_ce_length array in 0.625 ms
+ * @param max_ce_length array in 0.625 ms
+ */
+const hci_cmd_t hci_le_extended_create_connection = {
+    HCI_OPCODE_HCI_LE_EXTENDED_CREATE_CONNECTION, "111Bb[22222222]"
+    // return: none -> le create connection complete event
+};
+
+/**
+ * @param options
+ * @param advertising_sid
+ * @param advertiser_address_type
+ * @param advertiser_address
+ * @param skip
+ * @param sync_timeout in 10 ms
+ * @param sync_cte_type
+ */
+const hci_cmd_t hci_le_periodic_advertising_create_sync = {
+    HCI_OPCODE_HCI_LE_PERIODIC_ADVERTISING_CREATE_SYNC, "111B221"
+    // return: none -> le periodic advertising sync established event
+};
+
+/**
+ */
+const hci_cmd_t hci_le_periodic_advertising_create_sync_cancel = {
+    HCI_OPCODE_HCI_LE_PERIODIC_ADVERTISING_CREATE_SYNC_CANCEL, ""
+    // return: status
+};
+
+/**
+ * @param sync_handle
+ */
+const hci_cmd_t hci_le_periodic_advertising_terminate_sync = {
+    HCI_OPCODE_HCI_LE_PERIODIC_ADVERTISING_TERMINATE_SYNC, "H"
+    // return: status
+};
+
+
 
 #endif
 
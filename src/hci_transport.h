@@ -172,6 +172,37 @@ const hci_transport_t * hci_transport_usb_instance(void);
  */
 void hci_transport_usb_set_path(int len, uint8_t * port_numbers);
 
+/*
+ * @brief Setup Linux HCI User Channel instance
+ */
+const hci_transport_t * hci_transport_linux_instance(void);
+
+/**
+ * @brief Specify Linux HCI device index, default: 0 for hci0
+ */
+void hci_transport_linux_set_hci_index(uint16_t hci_index);
+
+/**
+ * @brief Use connected socket instead of opening HCI User Channel on next open, e.g. socketpair for tests
+ * @note socket needs to preserve message boundaries (e.g. SOCK_SEQPACKET) and is closed by transport
+ */
+void hci_transport_linux_set_socket(int socket_fd);
+
+/*
+ * @brief Setup additional Linux HCI User Channel instance for HCI device index, e.g. for hci_add_controller
+ * @note up to HCI_TRANSPORT_LINUX_MAX_INSTANCES (default: 4) instances including the one from hci_transport_linux_instance
+ * @param hci_index
+ * @return transport or NULL if no free instance
+ */
+const hci_transport_t * hci_transport_linux_instance_for_hci_index(uint16_t hci_index);
+
+/**
+ * @brief Use connected socket instead of opening HCI User Channel for HCI device index on next open
+ * @param hci_index
+ * @param socket_fd
+ */
+void hci_transport_linux_set_socket_for_hci_index(uint16_t hci_index, int socket_fd);
+
 /* API_END */
     
 #if defined __cplusplus
@@ -68,15 +68,24 @@ typedef enum {
     HCI_TRANSPORT_LINK_SEND_SLEEP                 = 1 <<  5,
     HCI_TRANSPORT_LINK_SEND_WOKEN                 = 1 <<  6,
     HCI_TRANSPORT_LINK_SEND_WAKEUP                = 1 <<  7,
-    HCI_TRANSPORT_LINK_SEND_QUEUED_PACKET         = 1 <<  8,
-    HCI_TRANSPORT_LINK_SEND_ACK_PACKET            = 1 <<  9,
-    HCI_TRANSPORT_LINK_ENTER_SLEEP                = 1 << 10,
+    HCI_TRANSPORT_LINK_SEND_ACK_PACKET            = 1 <<  8,
+    HCI_TRANSPORT_LINK_ENTER_SLEEP                = 1 <<  9,
 
 } hci_transport_link_actions_t;
 
-// Configuration Field. No packet buffers -> sliding window = 1, no OOF flow control, support data integrity check
-#define LINK_CONFIG_SLIDING_WINDOW_SIZE 1
+// Configuration Field. Sliding window up to 7 and OOF flow control can be configured, support data integrity check
+#ifndef HCI_TRANSPORT_H5_SLIDING_WINDOW_SIZE
+#define HCI_TRANSPORT_H5_SLIDING_WINDOW_SIZE 1
+#endif
+#if (HCI_TRANSPORT_H5_SLIDING_WINDOW_SIZE < 1) || (HCI_TRANSPORT_H5_SLIDING_WINDOW_SIZE > 7)
+#error "HCI_TRANSPORT_H5_SLIDING_WINDOW_SIZE must be between 1 and 7"
+#endif
+#define LINK_CONFIG_SLIDING_WINDOW_SIZE HCI_TRANSPORT_H5_SLIDING_WINDOW_SIZE
+#ifdef ENABLE_H5_OOF_FLOW_CONTROL
+#define LINK_CONFIG_OOF_FLOW_CONTROL 1
+#else
 #define LINK_CONFIG_OOF_FLOW_CONTROL 0
+#endif
 #define LINK_CONFIG_DATA_INTEGRITY_CHECK 1
 #define LINK_CONFIG_VERSION_NR 0
 #define LINK_CONFIG_FIELD (LINK_CONFIG_SLIDING_WINDOW_SIZE | (LINK_CONFIG_OOF_FLOW_CONTROL << 3) | (LINK_CONFIG_DATA_INTEGRITY_CHECK << 4) | (LINK_CONFIG_VERSION_NR << 5))
@@ -87,6 +96,9 @@ typedef enum {
 // resend wakeup
 #define LINK_WAKEUP_MS 50
 
+// max delay for ack if no reliable packet is sent
+#define LINK_ACK_DELAY_MS 10
+
 // additional packet types
 #define LINK_ACKNOWLEDGEMENT_TYPE 0x00
 #define LINK_CONTROL_PACKET_TYPE 0x0f
@@ -94,6 +106,9 @@ typedef enum {
 // max size of write requests
 #define LINK_SLIP_TX_CHUNK_LEN 64
 
+// max size of read requests
+#define LINK_SLIP_RX_CHUNK_LEN 64
+
 // ---
 static const uint8_t link_control_sync[] =   { 0x01, 0x7e};
 static const uint8_t link_control_sync_response[] = { 0x02, 0x7d};
@@ -114,6 +129,7 @@ static uint8_t   slip_outgoing_buffer[LINK_SLIP_TX_CHUNK_LEN+4+1];
 static uint16_t  slip_outgoing_dic;
 static uint16_t  slip_outgoing_dic_present;
 static int       slip_write_active;
+static int       slip_write_paused;
 
 // H5 Link State
 static hci_transport_link_state_t link_state;
@@ -123,15 +139,37 @@ static uint8_t  link_ack_nr;
 static uint16_t link_resend_timeout_ms;
 static uint8_t  link_peer_asleep;
 static uint8_t  link_peer_supports_data_integrity_check;
+static uint8_t  link_sliding_window_size;
+static uint8_t  link_oof_flow_control;
+static uint8_t  link_peer_xoff;
+
+// delayed ack for received reliable packets
+static btstack_timer_source_t link_ack_timer;
+static uint8_t  link_rx_unacked;
 
 // auto sleep-mode
 static btstack_timer_source_t inactivity_timer;
 static uint16_t link_inactivity_timeout_ms; // auto-sleep if set
 
-// Outgoing packet
-static uint8_t   hci_packet_type;
-static uint16_t  hci_packet_size;
-static uint8_t * hci_packet;
+// Outgoing reliable packets, oldest one has sequence number link_seq_nr
+typedef struct {
+    uint8_t   packet_type;
+    uint16_t  packet_size;
+    uint8_t * packet;
+} hci_transport_link_tx_packet_t;
+
+static hci_transport_link_tx_packet_t link_tx_queue[LINK_CONFIG_SLIDING_WINDOW_SIZE];
+static uint8_t   link_tx_queue_head;
+static uint8_t   link_tx_queue_len;
+// number of queued packets sent since last (re)transmission started
+static uint8_t   link_tx_queue_sent;
+// upper stack waits for HCI_EVENT_TRANSPORT_PACKET_SENT
+static uint8_t   link_tx_packet_sent_pending;
+
+#if LINK_CONFIG_SLIDING_WINDOW_SIZE > 1
+// HCI re-uses its packet buffer after HCI_EVENT_TRANSPORT_PACKET_SENT, keep a copy until acknowledged
+static uint8_t   link_tx_storage[LINK_CONFIG_SLIDING_WINDOW_SIZE][HCI_OUTGOING_PACKET_BUFFER_SIZE];
+#endif
 
 // hci packet handler
 static  void (*packet_handler)(uint8_t packet_type, uint8_t *packet, uint16_t size);
@@ -147,7 +185,6 @@ static int hci_transport_bcsp_mode;
 // Prototypes
 static void hci_transport_h5_process_frame(uint16_t frame_size);
 static int  hci_transport_link_have_outgoing_packet(void);
-static void hci_transport_link_send_queued_packet(void);
 static void hci_transport_link_set_timer(uint16_t timeout_ms);
 static void hci_transport_link_timeout_handler(btstack_timer_source_t * timer);
 static void hci_transport_link_run(void);
@@ -155,7 +192,55 @@ static void hci_transport_slip_init(void);
 
 // -----------------------------
 // CRC16-CCITT Calculation - compromise: use 32 byte table - 512 byte table would be faster, but that's too large
+// With ENABLE_H5_CRC_SLICE_BY_8, 8 x 256 entry tables (4 kB RAM) are generated on init and 8 bytes are processed per step
+
+#ifdef ENABLE_H5_CRC_SLICE_BY_8
+
+#define CRC16_CCITT_POLY_REFLECTED 0x8408u
+
+static uint16_t crc16_ccitt_table[8][256];
+
+static void crc16_ccitt_init(void){
+    uint16_t i;
+    for (i = 0; i < 256u; i++){
+        uint16_t crc = i;
+        int bit;
+        for (bit = 0; bit < 8; bit++){
+            crc = (crc & 1u) ? ((crc >> 1u) ^ CRC16_CCITT_POLY_REFLECTED) : (crc >> 1u);
+        }
+        crc16_ccitt_table[0][i] = crc;
+    }
+    for (i = 0; i < 256u; i++){
+        int slice;
+        for (slice = 1; slice < 8; slice++){
+            uint16_t crc = crc16_ccitt_table[slice - 1][i];
+            crc16_ccitt_table[slice][i] = (crc >> 8u) ^ crc16_ccitt_table[0][crc & 0xffu];
+        }
+    }
+}
 
+static inline uint16_t crc16_ccitt_update (uint16_t crc, uint8_t ch){
+    return (crc >> 8u) ^ crc16_ccitt_table[0][(crc ^ ch) & 0xffu];
+}
+
+static uint16_t crc16_ccitt_update_block(uint16_t crc, const uint8_t * data, uint16_t len){
+    while (len >= 8u){
+        crc ^= data[0] | (data[1] << 8u);
+        crc = crc16_ccitt_table[7][crc & 0xffu] ^ crc16_ccitt_table[6][crc >> 8u] ^
+              crc16_ccitt_table[5][data[2]]     ^ crc16_ccitt_table[4][data[3]] ^
+              crc16_ccitt_table[3][data[4]]     ^ crc16_ccitt_table[2][data[5]] ^
+              crc16_ccitt_table[1][data[6]]     ^ crc16_ccitt_table[0][data[7]];
+        data += 8;
+        len  -= 8u;
+    }
+    while (len > 0u){
+        crc = crc16_ccitt_update(crc, *data++);
+        len--;
+    }
+    return crc;
+}
+
+#else
 
 static uint16_t crc16_ccitt_update (uint16_t crc, uint8_t ch){
 
@@ -171,6 +256,16 @@ static uint16_t crc16_ccitt_update (uint16_t crc, uint8_t ch){
     return crc;
 }
 
+static uint16_t crc16_ccitt_update_block(uint16_t crc, const uint8_t * data, uint16_t len){
+    uint16_t i;
+    for (i=0 ; i < len ; i++){
+        crc = crc16_ccitt_update(crc, data[i]);
+    }
+    return crc;
+}
+
+#endif
+
 static uint16_t btstack_reverse_bits_16(uint16_t value){
     int reverse = 0;
     int i;
@@ -183,14 +278,9 @@ static uint16_t btstack_reverse_bits_16(uint16_t value){
 }
 
 static uint16_t crc16_calc_for_slip_frame(const uint8_t * header, const uint8_t * payload, uint16_t len){
-    int i;
     uint16_t crc = 0xffff;
-    for (i=0 ; i < 4 ; i++){
-        crc = crc16_ccitt_update(crc, header[i]);
-    }
-    for (i=0 ; i < len ; i++){
-        crc = crc16_ccitt_update(crc, payload[i]);
-    }
+    crc = crc16_ccitt_update_block(crc, header, 4);
+    crc = crc16_ccitt_update_block(crc, payload, len);
     return btstack_reverse_bits_16(crc);
 }
 
@@ -220,8 +310,8 @@ static void hci_transport_inactivity_timer_set(void){
 
 // Fill chunk and write
 static void hci_transport_slip_encode_chunk_and_send(int pos){
-    while (btstack_slip_encoder_has_data() & (pos < LINK_SLIP_TX_CHUNK_LEN)) {
-        slip_outgoing_buffer[pos++] = btstack_slip_encoder_get_byte();
+    if (pos < LINK_SLIP_TX_CHUNK_LEN){
+        pos += btstack_slip_encoder_get_bytes(&slip_outgoing_buffer[pos], LINK_SLIP_TX_CHUNK_LEN - pos);
     }
 
     if (!btstack_slip_encoder_has_data()){
@@ -231,9 +321,7 @@ static void hci_transport_slip_encode_chunk_and_send(int pos){
             uint8_t dic_buffer[2];
             big_endian_store_16(dic_buffer, 0, slip_outgoing_dic);
             btstack_slip_encoder_start(dic_buffer, 2);
-            while (btstack_slip_encoder_has_data()){
-                slip_outgoing_buffer[pos++] = btstack_slip_encoder_get_byte();
-            } 
+            pos += btstack_slip_encoder_get_bytes(&slip_outgoing_buffer[pos], 4);
         }
         // Start of Frame
         slip_outgoing_buffer[pos++] = BTSTACK_SLIP_SOF;
@@ -262,9 +350,7 @@ static void hci_transport_slip_send_frame(const uint8_t * header, const uint8_t
 
     // Header
     btstack_slip_encoder_start(header, 4);
-    while (btstack_slip_encoder_has_data()){
-        slip_outgoing_buffer[pos++] = btstack_slip_encoder_get_byte();
-    }
+    pos += btstack_slip_encoder_get_bytes(&slip_outgoing_buffer[pos], 8);
 
     // Packet
     btstack_slip_encoder_start(packet, packet_size);
@@ -348,19 +434,38 @@ static void hci_transport_link_send_sleep(void){
     hci_transport_link_send_control(link_control_sleep, sizeof(link_control_sleep));
 }
 
+static void hci_transport_link_ack_sent(void){
+    // ack for all received packets is sent
+    link_rx_unacked = 0;
+    hci_transport_link_actions &= ~HCI_TRANSPORT_LINK_SEND_ACK_PACKET;
+    btstack_run_loop_remove_timer(&link_ack_timer);
+}
+
 static void hci_transport_link_send_queued_packet(void){
 
+    hci_transport_link_tx_packet_t * tx_packet = &link_tx_queue[(link_tx_queue_head + link_tx_queue_sent) % LINK_CONFIG_SLIDING_WINDOW_SIZE];
+    uint8_t seq_nr = (link_seq_nr + link_tx_queue_sent) & 0x07u;
+
+    // start resend timer with oldest packet
+    if (link_tx_queue_sent == 0u){
+        hci_transport_link_set_timer(link_resend_timeout_ms);
+    }
+    link_tx_queue_sent++;
+
+    // packet already contains ack, no need to send addtitional one
+    hci_transport_link_ack_sent();
+
     uint8_t header[4];
-    hci_transport_link_calc_header(header, link_seq_nr, link_ack_nr, link_peer_supports_data_integrity_check, 1, hci_packet_type, hci_packet_size);
+    hci_transport_link_calc_header(header, seq_nr, link_ack_nr, link_peer_supports_data_integrity_check, 1, tx_packet->packet_type, tx_packet->packet_size);
 
     uint16_t data_integrity_check = 0;
     if (link_peer_supports_data_integrity_check){
-        data_integrity_check = crc16_calc_for_slip_frame(header, hci_packet, hci_packet_size);
+        data_integrity_check = crc16_calc_for_slip_frame(header, tx_packet->packet, tx_packet->packet_size);
     }
-    log_debug("hci_transport_link_send_queued_packet: seq %u, ack %u, size %u. Append dic %u, dic = 0x%04x", link_seq_nr, link_ack_nr, hci_packet_size, link_peer_supports_data_integrity_check, data_integrity_check);
-    log_debug_hexdump(hci_packet, hci_packet_size);
+    log_debug("hci_transport_link_send_queued_packet: seq %u, ack %u, size %u. Append dic %u, dic = 0x%04x", seq_nr, link_ack_nr, tx_packet->packet_size, link_peer_supports_data_integrity_check, data_integrity_check);
+    log_debug_hexdump(tx_packet->packet, tx_packet->packet_size);
 
-    hci_transport_slip_send_frame(header, hci_packet, hci_packet_size, data_integrity_check);
+    hci_transport_slip_send_frame(header, tx_packet->packet, tx_packet->packet_size, data_integrity_check);
 
     // reset inactvitiy timer
     hci_transport_inactivity_timer_set();
@@ -369,15 +474,25 @@ static void hci_transport_link_send_queued_packet(void){
 static void hci_transport_link_send_ack_packet(void){
     // Pure ACK package is without DIC as there is no payload either
     log_debug("send ack %u", link_ack_nr);
+    hci_transport_link_ack_sent();
     uint8_t header[4];
     hci_transport_link_calc_header(header, 0, link_ack_nr, 0, 0, LINK_ACKNOWLEDGEMENT_TYPE, 0);
     hci_transport_slip_send_frame(header, NULL, 0, 0);
 }
 
+static int hci_transport_link_can_send_queued_packet(void){
+    if (link_state != LINK_ACTIVE) return 0;
+    if (link_peer_asleep) return 0;
+    return link_tx_queue_sent < link_tx_queue_len;
+}
+
 static void hci_transport_link_run(void){
     // exit if outgoing active
     if (slip_write_active) return;
 
+    // exit if peer requested to stop sending
+    if (link_peer_xoff) return;
+
     // process queued requests
     if (hci_transport_link_actions & HCI_TRANSPORT_LINK_SEND_SYNC){
         hci_transport_link_actions &= ~HCI_TRANSPORT_LINK_SEND_SYNC;
@@ -414,15 +529,11 @@ static void hci_transport_link_run(void){
         hci_transport_link_send_wakeup();
         return;
     }
-    if (hci_transport_link_actions & HCI_TRANSPORT_LINK_SEND_QUEUED_PACKET){
-        hci_transport_link_actions &= ~HCI_TRANSPORT_LINK_SEND_QUEUED_PACKET;
-        // packet already contains ack, no need to send addtitional one
-        hci_transport_link_actions &= ~HCI_TRANSPORT_LINK_SEND_ACK_PACKET;
+    if (hci_transport_link_can_send_queued_packet()){
         hci_transport_link_send_queued_packet();
         return;
     }
     if (hci_transport_link_actions & HCI_TRANSPORT_LINK_SEND_ACK_PACKET){
-        hci_transport_link_actions &= ~HCI_TRANSPORT_LINK_SEND_ACK_PACKET;
         hci_transport_link_send_ack_packet();
         return;
     }
@@ -436,6 +547,7 @@ static void hci_transport_link_run(void){
 }
 
 static void hci_transport_link_set_timer(uint16_t timeout_ms){
+    btstack_run_loop_remove_timer(&link_timer);
     btstack_run_loop_set_timer(&link_timer, timeout_ms);
     btstack_run_loop_add_timer(&link_timer);
 }
@@ -461,8 +573,9 @@ static void hci_transport_link_timeout_handler(btstack_timer_source_t * ts){
                 hci_transport_link_set_timer(LINK_WAKEUP_MS);
                 return;
             }
-            // resend packet
-            hci_transport_link_actions |= HCI_TRANSPORT_LINK_SEND_QUEUED_PACKET;
+            // resend all unacknowledged packets
+            log_info("resend %u packets starting with seq %u", link_tx_queue_len, link_seq_nr);
+            link_tx_queue_sent = 0;
             hci_transport_link_set_timer(link_resend_timeout_ms);
             break;
         default:
@@ -472,10 +585,23 @@ static void hci_transport_link_timeout_handler(btstack_timer_source_t * ts){
     hci_transport_link_run();
 }
 
+static void hci_transport_link_ack_timeout_handler(btstack_timer_source_t * ts){
+    UNUSED(ts);
+    hci_transport_link_actions |= HCI_TRANSPORT_LINK_SEND_ACK_PACKET;
+    hci_transport_link_run();
+}
+
 static void hci_transport_link_init(void){
     link_state = LINK_UNINITIALIZED;
     link_peer_asleep = 0;
     link_peer_supports_data_integrity_check = 0;
+    link_sliding_window_size = 1;
+    link_oof_flow_control = 0;
+    link_peer_xoff = 0;
+    link_rx_unacked = 0;
+    slip_write_paused = 0;
+    btstack_slip_encoder_set_oof_flow_control(0);
+    btstack_run_loop_set_timer_handler(&link_ack_timer, &hci_transport_link_ack_timeout_handler);
  
     // get started
     hci_transport_link_actions |= HCI_TRANSPORT_LINK_SEND_SYNC;
@@ -489,18 +615,76 @@ static int hci_transport_link_inc_seq_nr(int seq_nr){
 }
 
 static int hci_transport_link_have_outgoing_packet(void){
-    return hci_packet != NULL;
+    return link_tx_queue_len > 0u;
 }
 
 static void hci_transport_link_clear_queue(void){
     btstack_run_loop_remove_timer(&link_timer);
-    hci_packet = NULL;
+    btstack_run_loop_remove_timer(&link_ack_timer);
+    link_tx_queue_head = 0;
+    link_tx_queue_len = 0;
+    link_tx_queue_sent = 0;
+    link_tx_packet_sent_pending = 0;
 }
 
 static void hci_transport_h5_queue_packet(uint8_t packet_type, uint8_t *packet, int size){
-    hci_packet = packet;
-    hci_packet_type = packet_type;
-    hci_packet_size = size;
+    uint8_t index = (link_tx_queue_head + link_tx_queue_len) % LINK_CONFIG_SLIDING_WINDOW_SIZE;
+    hci_transport_link_tx_packet_t * tx_packet = &link_tx_queue[index];
+    tx_packet->packet_type = packet_type;
+    tx_packet->packet_size = size;
+#if LINK_CONFIG_SLIDING_WINDOW_SIZE > 1
+    (void)memcpy(link_tx_storage[index], packet, size);
+    tx_packet->packet = link_tx_storage[index];
+#else
+    tx_packet->packet = packet;
+#endif
+    link_tx_queue_len++;
+}
+
+// upper stack can send next packet if there's room in the sliding window
+static void hci_transport_link_notify_packet_sent_if_ready(void){
+    if (link_tx_packet_sent_pending == 0u) return;
+    if (link_tx_queue_len >= link_sliding_window_size) return;
+    link_tx_packet_sent_pending = 0;
+    uint8_t event[] = { HCI_EVENT_TRANSPORT_PACKET_SENT, 0};
+    packet_handler(HCI_EVENT_PACKET, &event[0], sizeof(event));
+}
+
+static void hci_transport_link_process_ack(uint8_t ack_nr){
+    // peer expects ack_nr next: all packets before are acknowledged
+    uint8_t num_acked = (ack_nr - link_seq_nr) & 0x07u;
+    if (num_acked == 0u) return;
+    if (num_acked > link_tx_queue_len){
+        log_info("ack nr %u outside of window, seq nr %u, %u packets queued", ack_nr, link_seq_nr, link_tx_queue_len);
+        return;
+    }
+    log_debug("%u outgoing packets up to seq %u ack'ed", num_acked, (ack_nr - 1u) & 0x07u);
+    link_seq_nr = ack_nr;
+    link_tx_queue_head = (link_tx_queue_head + num_acked) % LINK_CONFIG_SLIDING_WINDOW_SIZE;
+    link_tx_queue_len -= num_acked;
+    link_tx_queue_sent = (link_tx_queue_sent > num_acked) ? (link_tx_queue_sent - num_acked) : 0;
+
+    // restart resend timer for oldest unacknowledged packet
+    btstack_run_loop_remove_timer(&link_timer);
+    if (link_tx_queue_sent > 0u){
+        hci_transport_link_set_timer(link_resend_timeout_ms);
+    }
+
+    hci_transport_link_notify_packet_sent_if_ready();
+}
+
+static void hci_transport_link_schedule_ack(void){
+    link_rx_unacked++;
+    // ack right away if half of the sliding window is used
+    if (link_rx_unacked >= ((link_sliding_window_size + 1u) / 2u)){
+        hci_transport_link_actions |= HCI_TRANSPORT_LINK_SEND_ACK_PACKET;
+        return;
+    }
+    // otherwise, wait for outgoing reliable packet
+    if (link_rx_unacked == 1u){
+        btstack_run_loop_set_timer(&link_ack_timer, LINK_ACK_DELAY_MS);
+        btstack_run_loop_add_timer(&link_ack_timer);
+    }
 }
 
 static void hci_transport_h5_emit_sleep_state(int sleep_active){
@@ -609,9 +793,17 @@ static void hci_transport_h5_process_frame(uint16_t frame_size){
                 break;
             }
             if (memcmp(slip_payload, link_control_config_response, link_control_config_response_prefix_len) == 0){
-                uint8_t config = slip_payload[2];
+                // no config field: sliding window 1, no OOF flow control, no data integrity check
+                uint8_t config = 0x01;
+                if (link_payload_len > link_control_config_response_prefix_len){
+                    config = slip_payload[2];
+                }
                 link_peer_supports_data_integrity_check = (config & 0x10u) != 0u;
-                log_info("link received config response 0x%02x, data integrity check supported %u", config, link_peer_supports_data_integrity_check);
+                link_sliding_window_size = btstack_max(1, btstack_min(config & 0x07u, LINK_CONFIG_SLIDING_WINDOW_SIZE));
+                link_oof_flow_control = (LINK_CONFIG_OOF_FLOW_CONTROL != 0) && ((config & 0x08u) != 0u);
+                btstack_slip_encoder_set_oof_flow_control(link_oof_flow_control);
+                log_info("link received config response 0x%02x, data integrity check supported %u, sliding window %u, OOF flow control %u",
+                         config, link_peer_supports_data_integrity_check, link_sliding_window_size, link_oof_flow_control);
                 link_state = LINK_ACTIVE;
                 btstack_run_loop_remove_timer(&link_timer);
                 log_info("link activated");
@@ -631,27 +823,20 @@ static void hci_transport_h5_process_frame(uint16_t frame_size){
                 if (seq_nr != link_ack_nr){
                     log_info("expected seq nr %u, but received %u", link_ack_nr, seq_nr);
                     hci_transport_link_actions |= HCI_TRANSPORT_LINK_SEND_ACK_PACKET;
+                    // ack nr is valid nevertheless
+                    hci_transport_link_process_ack(ack_nr);
                     break;
                 }
-                // ack packet right away
+
+                // ack packet directly or together with next reliable packet
                 link_ack_nr = hci_transport_link_inc_seq_nr(link_ack_nr);
-                hci_transport_link_actions |= HCI_TRANSPORT_LINK_SEND_ACK_PACKET;
+                hci_transport_link_schedule_ack();
             }
 
             // Process ACKs in reliable packet and explicit ack packets
             if (reliable_packet || (link_packet_type == LINK_ACKNOWLEDGEMENT_TYPE)){
-                // our packet is good if the remote expects our seq nr + 1
-                int next_seq_nr = hci_transport_link_inc_seq_nr(link_seq_nr);
-                if (hci_transport_link_have_outgoing_packet() && (next_seq_nr == ack_nr)){
-                    log_debug("outoing packet with seq %u ack'ed", link_seq_nr);
-                    link_seq_nr = next_seq_nr;
-                    hci_transport_link_clear_queue();
-
-                    // notify upper stack that it can send again
-                    uint8_t event[] = { HCI_EVENT_TRANSPORT_PACKET_SENT, 0};
-                    packet_handler(HCI_EVENT_PACKET, &event[0], sizeof(event));
-                }
-            } 
+                hci_transport_link_process_ack(ack_nr);
+            }
 
             switch (link_packet_type){
                 case LINK_CONTROL_PACKET_TYPE:
@@ -732,38 +917,97 @@ static void hci_transport_link_update_resend_timeout(uint32_t baudrate){
 
 /// H5 Interface
 
-static uint8_t hci_transport_link_read_byte;
+static uint8_t  hci_transport_link_read_buffer[LINK_SLIP_RX_CHUNK_LEN];
+static uint16_t hci_transport_link_read_len;
 static int hci_transport_h5_active;
 
-static void hci_transport_h5_read_next_byte(void){
-    btstack_uart->receive_block(&hci_transport_link_read_byte, 1);    
+// Once a valid header has been decoded, the remaining payload, DIC and final SOF take at least one byte each on the wire.
+// Reading that many bytes at once never waits for data beyond the current frame
+static uint16_t hci_transport_h5_min_bytes_until_frame_end(void){
+    uint16_t bytes_decoded = btstack_slip_decoder_bytes_decoded();
+    if (bytes_decoded < 4u) return 1;
+    const uint8_t * slip_header = &hci_packet_with_pre_buffer[HCI_INCOMING_PRE_BUFFER_SIZE];
+    uint8_t header_checksum = slip_header[0] + slip_header[1] + slip_header[2] + slip_header[3];
+    if (header_checksum != 0xffu) return 1;
+    uint16_t frame_len = 4u + ((slip_header[1] >> 4) | (slip_header[2] << 4));
+    if ((slip_header[0u] & 0x40u) != 0u){
+        frame_len += 2u;
+    }
+    if (bytes_decoded >= frame_len) return 1;
+    return frame_len - bytes_decoded + 1u;
+}
+
+static void hci_transport_h5_read_next_block(void){
+    hci_transport_link_read_len = btstack_min(hci_transport_h5_min_bytes_until_frame_end(), LINK_SLIP_RX_CHUNK_LEN);
+    btstack_uart->receive_block(hci_transport_link_read_buffer, hci_transport_link_read_len);
 }
 
 // track time receiving SLIP frame
 static uint32_t hci_transport_h5_receive_start;
+static void hci_transport_h5_process_flow_control(uint8_t xon_xoff){
+    if (xon_xoff == BTSTACK_SLIP_XOFF){
+        log_debug("link: received XOFF");
+        link_peer_xoff = 1;
+        return;
+    }
+    log_debug("link: received XON");
+    link_peer_xoff = 0;
+    if (slip_write_paused){
+        slip_write_paused = 0;
+        hci_transport_slip_send_next_chunk();
+        return;
+    }
+    hci_transport_link_run();
+}
+
 static void hci_transport_h5_block_received(void){
     if (hci_transport_h5_active == 0) return;
 
-    // track start time when receiving first byte // a bit hackish
-    if ((hci_transport_h5_receive_start == 0u) && (hci_transport_link_read_byte != BTSTACK_SLIP_SOF)){
-        hci_transport_h5_receive_start = btstack_run_loop_get_time_ms();
-    }
-    btstack_slip_decoder_process(hci_transport_link_read_byte);
-    uint16_t frame_size = btstack_slip_decoder_frame_size();
-    if (frame_size) {
-        // track time
-        uint32_t packet_receive_time = btstack_run_loop_get_time_ms() - hci_transport_h5_receive_start;
-        uint32_t nominal_time = (frame_size + 6u) * 10u * 1000u / uart_config.baudrate;
-        UNUSED(nominal_time);
-        UNUSED(packet_receive_time);
-        log_info("slip frame time %u ms for %u decoded bytes. nomimal time %u ms", (int) packet_receive_time, frame_size, (int) nominal_time);
-        // reset state
-        hci_transport_h5_receive_start = 0;
-        // 
-        hci_transport_h5_process_frame(frame_size);
-        hci_transport_slip_init();
+    uint16_t pos = 0;
+    while (pos < hci_transport_link_read_len){
+        uint8_t input = hci_transport_link_read_buffer[pos];
+        uint16_t block_len = hci_transport_link_read_len - pos;
+
+        if (link_oof_flow_control){
+            // XON/XOFF are only sent escaped within SLIP frames
+            if ((input == BTSTACK_SLIP_XON) || (input == BTSTACK_SLIP_XOFF)){
+                hci_transport_h5_process_flow_control(input);
+                pos++;
+                continue;
+            }
+            // decode up to next XON/XOFF
+            const uint8_t * block = &hci_transport_link_read_buffer[pos];
+            const uint8_t * flow_control = (const uint8_t *) memchr(block, BTSTACK_SLIP_XON, block_len);
+            if (flow_control != NULL){
+                block_len = (uint16_t) (flow_control - block);
+            }
+            flow_control = (const uint8_t *) memchr(block, BTSTACK_SLIP_XOFF, block_len);
+            if (flow_control != NULL){
+                block_len = (uint16_t) (flow_control - block);
+            }
+        }
+
+        // track start time when receiving first byte // a bit hackish
+        if ((hci_transport_h5_receive_start == 0u) && (input != BTSTACK_SLIP_SOF)){
+            hci_transport_h5_receive_start = btstack_run_loop_get_time_ms();
+        }
+        pos += btstack_slip_decoder_process_block(&hci_transport_link_read_buffer[pos], block_len);
+        uint16_t frame_size = btstack_slip_decoder_frame_size();
+        if (frame_size) {
+            // track time
+            uint32_t packet_receive_time = btstack_run_loop_get_time_ms() - hci_transport_h5_receive_start;
+            uint32_t nominal_time = (frame_size + 6u) * 10u * 1000u / uart_config.baudrate;
+            UNUSED(nominal_time);
+            UNUSED(packet_receive_time);
+            log_info("slip frame time %u ms for %u decoded bytes. nomimal time %u ms", (int) packet_receive_time, frame_size, (int) nominal_time);
+            // reset state
+            hci_transport_h5_receive_start = 0;
+            // 
+            hci_transport_h5_process_frame(frame_size);
+            hci_transport_slip_init();
+        }
     }
-    hci_transport_h5_read_next_byte();
+    hci_transport_h5_read_next_block();
 }
 
 static void hci_transport_h5_block_sent(void){
@@ -771,6 +1015,10 @@ static void hci_transport_h5_block_sent(void){
 
     // check if more data to send
     if (btstack_slip_encoder_has_data()){
+        if (link_peer_xoff){
+            slip_write_paused = 1;
+            return;
+        }
         hci_transport_slip_send_next_chunk();
         return;
     }
@@ -790,6 +1038,8 @@ static void hci_transport_h5_block_sent(void){
         hci_transport_h5_emit_sleep_state(1);
     }
 
+    hci_transport_link_notify_packet_sent_if_ready();
+
     hci_transport_link_run();
 }
 
@@ -806,6 +1056,10 @@ static void hci_transport_h5_init(const void * transport_config){
 
     hci_transport_h5_active = 0;
 
+#ifdef ENABLE_H5_CRC_SLICE_BY_8
+    crc16_ccitt_init();
+#endif
+
     // extract UART config from transport config
     hci_transport_config_uart_t * hci_transport_config_uart = (hci_transport_config_uart_t*) transport_config;
     uart_config.baudrate    = hci_transport_config_uart->baudrate_init;
@@ -848,19 +1102,22 @@ static int hci_transport_h5_open(void){
 
     // init slip parser state machine
     hci_transport_slip_init();
+    slip_write_active = 0;
 
     // init link management - already starts syncing
     hci_transport_link_init();
 
     // start receiving
     hci_transport_h5_active = 1;
-    hci_transport_h5_read_next_byte();
+    hci_transport_h5_read_next_block();
 
     return 0;
 }
 
 static int hci_transport_h5_close(void){
     hci_transport_h5_active = 0;
+    hci_transport_link_clear_queue();
+    btstack_run_loop_remove_timer(&inactivity_timer);
     return btstack_uart->close();
 }
 
@@ -869,7 +1126,9 @@ static void hci_transport_h5_register_packet_handler(void (*handler)(uint8_t pac
 }
 
 static int hci_transport_h5_can_send_packet_now(uint8_t packet_type){
-    int res = !hci_transport_link_have_outgoing_packet() && (link_state == LINK_ACTIVE);
+    if (link_state != LINK_ACTIVE) return 0;
+    if (link_tx_packet_sent_pending) return 0;
+    int res = link_tx_queue_len < link_sliding_window_size;
     // log_info("can_send_packet_now: %u", res);
     return res;
 }
@@ -879,9 +1138,16 @@ static int hci_transport_h5_send_packet(uint8_t packet_type, uint8_t *packet, in
         log_error("hci_transport_h5_send_packet called but in state %d", link_state);
         return -1;
     }
+#if LINK_CONFIG_SLIDING_WINDOW_SIZE > 1
+    if (size > HCI_OUTGOING_PACKET_BUFFER_SIZE){
+        log_error("hci_transport_h5_send_packet packet too large %u", size);
+        return -1;
+    }
+#endif
 
     // store request
     hci_transport_h5_queue_packet(packet_type, packet, size);
+    link_tx_packet_sent_pending = 1;
 
     // send wakeup first
     if (link_peer_asleep){
@@ -892,9 +1158,6 @@ static int hci_transport_h5_send_packet(uint8_t packet_type, uint8_t *packet, in
         }
         hci_transport_link_actions |= HCI_TRANSPORT_LINK_SEND_WAKEUP;
         hci_transport_link_set_timer(LINK_WAKEUP_MS);
-    } else {
-        hci_transport_link_actions |= HCI_TRANSPORT_LINK_SEND_QUEUED_PACKET;
-        hci_transport_link_set_timer(link_resend_timeout_ms);
     }
     hci_transport_link_run();
     return 0;
@@ -55,6 +55,10 @@
 #include "btstack_event.h"
 #include "btstack_memory.h"
 
+#if defined(ENABLE_BLE) && defined(ENABLE_HCI_MULTIPLE_CONTROLLERS)
+#include "ble/att_db.h"
+#endif
+
 #include <stdarg.h>
 #include <string.h>
 
@@ -119,6 +123,9 @@ typedef enum {
 // used to cache l2cap rejects, echo, and informational requests
 #define NR_PENDING_SIGNALING_RESPONSES 3
 
+// used to cache ATT and SM rejects for fixed channels on secondary Controllers
+#define NR_PENDING_FIXED_CHANNEL_REJECTS 3
+
 // nr of credits provided to remote if credits fall below watermark
 #define L2CAP_LE_DATA_CHANNELS_AUTOMATIC_CREDITS_WATERMARK 5
 #define L2CAP_LE_DATA_CHANNELS_AUTOMATIC_CREDITS_INCREMENT 5
@@ -159,6 +166,13 @@ static void l2cap_le_notify_channel_can_send(l2cap_channel_t *channel);
 static void l2cap_le_finialize_channel_close(l2cap_channel_t *channel);
 static void l2cap_le_send_pdu(l2cap_channel_t *channel);
 static inline l2cap_service_t * l2cap_le_get_service(uint16_t psm);
+static void l2cap_le_release_queued_sdus(l2cap_channel_t * channel);
+static void l2cap_le_start_next_queued_sdu(l2cap_channel_t * channel);
+#endif
+#ifdef ENABLE_L2CAP_ENHANCED_CREDIT_BASED_FLOW_CONTROL_MODE
+static bool l2cap_run_ecbm_channel(l2cap_channel_t * channel);
+static int  l2cap_ecbm_signaling_handler_dispatch(hci_con_handle_t handle, uint8_t * command, uint8_t sig_id);
+static void l2cap_ecbm_handle_command_reject(l2cap_channel_t * channel);
 #endif
 #ifdef L2CAP_USES_CHANNELS
 static uint16_t l2cap_next_local_cid(void);
@@ -169,6 +183,16 @@ static l2cap_channel_t * l2cap_get_channel_for_local_cid(uint16_t local_cid);
 static l2cap_channel_t * l2cap_create_channel_entry(btstack_packet_handler_t packet_handler, l2cap_channel_type_t channel_type, bd_addr_t address, bd_addr_type_t address_type, 
         uint16_t psm, uint16_t local_mtu, gap_security_level_t security_level);
 static void l2cap_free_channel_entry(l2cap_channel_t * channel);
+static int  l2cap_is_dynamic_channel_type(l2cap_channel_type_t channel_type);
+static bool l2cap_channel_uses_connection(const l2cap_channel_t * channel, hci_con_handle_t con_handle);
+#ifdef ENABLE_HCI_MULTIPLE_CONTROLLERS
+static uint8_t l2cap_select_controller_for_channel(const l2cap_channel_t * channel);
+#endif
+#endif
+static bool l2cap_fixed_channels_on_selected_controller(void);
+static bool l2cap_channel_on_selected_controller(const l2cap_channel_t * channel);
+#ifdef ENABLE_HCI_MULTIPLE_CONTROLLERS
+static void l2cap_for_each_controller(void (*function)(void));
 #endif
 #ifdef ENABLE_L2CAP_ENHANCED_RETRANSMISSION_MODE
 static void l2cap_ertm_notify_channel_can_send(l2cap_channel_t * channel);
@@ -195,6 +219,10 @@ static bd_addr_t l2cap_outgoing_classic_addr;
 static btstack_linked_list_t l2cap_le_services;
 #endif
 
+#ifdef ENABLE_L2CAP_ENHANCED_CREDIT_BASED_FLOW_CONTROL_MODE
+static btstack_linked_list_t l2cap_ecbm_services;
+#endif
+
 // single list of channels for Classic Channels, LE Data Channels, Classic Connectionless, ATT, and SM
 static btstack_linked_list_t l2cap_channels;
 #ifdef L2CAP_USES_CHANNELS
@@ -207,8 +235,38 @@ static uint8_t   sig_seq_nr  = 0xff;
 // used to cache l2cap rejects, echo, and informational requests
 static l2cap_signaling_response_t signaling_responses[NR_PENDING_SIGNALING_RESPONSES];
 static int signaling_responses_pending;
+
+#if defined(ENABLE_BLE) && defined(ENABLE_HCI_MULTIPLE_CONTROLLERS)
+typedef struct {
+    hci_con_handle_t handle;
+    uint8_t  controller_index;
+    uint16_t cid;
+    uint8_t  opcode;    // ATT request opcode, unused for SM
+} l2cap_fixed_channel_reject_t;
+
+// used to cache ATT Error Responses and SM Pairing Failed for fixed channels on secondary Controllers
+static l2cap_fixed_channel_reject_t fixed_channel_rejects[NR_PENDING_FIXED_CHANNEL_REJECTS];
+static int fixed_channel_rejects_pending;
+#endif
 static btstack_packet_callback_registration_t hci_event_callback_registration;
 
+#if defined(ENABLE_BTSTACK_STATS) && defined(L2CAP_USES_CHANNELS)
+static void l2cap_stats_for_each_traffic(btstack_stats_traffic_handler_t handler, void * context){
+    btstack_linked_list_iterator_t it;
+    btstack_linked_list_iterator_init(&it, &l2cap_channels);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        l2cap_channel_t * channel = (l2cap_channel_t *) btstack_linked_list_iterator_next(&it);
+        if (!l2cap_is_dynamic_channel_type(channel->channel_type)) continue;
+        (*handler)(context, "l2cap_channel", channel->local_cid, &channel->stats);
+    }
+}
+
+static btstack_stats_source_t l2cap_stats_source = {
+    { NULL },
+    &l2cap_stats_for_each_traffic
+};
+#endif
+
 #ifdef ENABLE_BLE
 // only used for connection parameter update events
 static btstack_packet_handler_t l2cap_event_packet_handler;
@@ -258,8 +316,96 @@ static inline uint16_t l2cap_encanced_control_field_for_supevisor_frame(l2cap_su
     return (req_seq << 8) | (final << 7) | (poll << 4) | (((int) supervisory_function) << 2) | 1; 
 }
 
-static int l2cap_next_ertm_seq_nr(int seq_nr){
-    return (seq_nr + 1) & 0x3f;
+static inline uint32_t l2cap_extended_control_field_for_information_frame(uint16_t tx_seq, int final, uint16_t req_seq, l2cap_segmentation_and_reassembly_t sar){
+    return (((uint32_t) tx_seq) << 18) | (((uint32_t) sar) << 16) | (((uint32_t) req_seq) << 2) | (final << 1) | 0;
+}
+
+static inline uint32_t l2cap_extended_control_field_for_supevisor_frame(l2cap_supervisory_function_t supervisory_function, int poll, int final, uint16_t req_seq){
+    return (((uint32_t) poll) << 18) | (((uint32_t) supervisory_function) << 16) | (((uint32_t) req_seq) << 2) | (final << 1) | 1;
+}
+
+// Streaming Mode uses the same I-Frames, buffers and FCS handling as Enhanced Retransmission Mode
+static inline bool l2cap_ertm_or_streaming_mode(const l2cap_channel_t * channel){
+    return (channel->mode == L2CAP_CHANNEL_MODE_ENHANCED_RETRANSMISSION) || (channel->mode == L2CAP_CHANNEL_MODE_STREAMING_MODE);
+}
+
+// bit in extended feature mask required for channel mode
+static inline uint16_t l2cap_ertm_feature_for_mode(l2cap_channel_mode_t mode){
+    return (mode == L2CAP_CHANNEL_MODE_STREAMING_MODE) ? 0x10 : 0x08;
+}
+
+// Extended Control Field uses 14-bit sequence numbers, Standard Control Field 6-bit ones
+static inline uint16_t l2cap_ertm_seq_mask(const l2cap_channel_t * channel){
+    return channel->extended_control ? 0x3fff : 0x3f;
+}
+
+static inline uint16_t l2cap_ertm_control_size(const l2cap_channel_t * channel){
+    return channel->extended_control ? 4 : 2;
+}
+
+// receive window announced to remote: num rx buffers, limited to 63 without Extended Window Size option
+static uint16_t l2cap_ertm_rx_window(const l2cap_channel_t * channel){
+    if (channel->extended_control) return channel->num_rx_buffers;
+    return btstack_min(channel->num_rx_buffers, 63);
+}
+
+static void l2cap_ertm_store_control_field(const l2cap_channel_t * channel, uint8_t * buffer, uint32_t control){
+    if (channel->extended_control){
+        little_endian_store_32(buffer, 0, control);
+    } else {
+        little_endian_store_16(buffer, 0, (uint16_t) control);
+    }
+}
+
+static uint16_t l2cap_next_ertm_seq_nr(const l2cap_channel_t * channel, uint16_t seq_nr){
+    return (seq_nr + 1) & l2cap_ertm_seq_mask(channel);
+}
+
+// offset of tx_seq relative to expected tx_seq
+static uint16_t l2cap_ertm_rx_offset(const l2cap_channel_t * channel, uint16_t tx_seq){
+    return (tx_seq - channel->expected_tx_seq) & l2cap_ertm_seq_mask(channel);
+}
+
+// rx buffer index for frame with offset relative to expected tx_seq, rx_store_index is used for offset = 1
+static uint16_t l2cap_ertm_rx_index(const l2cap_channel_t * channel, uint16_t offset){
+    return (channel->rx_store_index + offset + channel->num_rx_buffers - 1) % channel->num_rx_buffers;
+}
+
+static bool l2cap_ertm_rx_frame_stored(const l2cap_channel_t * channel, uint16_t tx_seq){
+    uint16_t offset = l2cap_ertm_rx_offset(channel, tx_seq);
+    if (offset == 0) return false;
+    if (offset >= channel->num_rx_buffers) return false;
+    return channel->rx_packets_state[l2cap_ertm_rx_index(channel, offset)].valid != 0;
+}
+
+static void l2cap_ertm_next_expected_tx_seq(l2cap_channel_t * channel){
+    uint16_t next_tx_seq = l2cap_next_ertm_seq_nr(channel, channel->expected_tx_seq);
+    // rx buffers are indexed relative to expected tx_seq
+    channel->rx_store_index++;
+    if (channel->rx_store_index >= channel->num_rx_buffers){
+        channel->rx_store_index = 0;
+    }
+    // frames received in sequence are removed from the SREJ list
+    if (channel->srej_request_seq == channel->expected_tx_seq){
+        channel->srej_request_seq = next_tx_seq;
+    }
+    if (channel->srej_request_end == channel->expected_tx_seq){
+        channel->srej_request_end = next_tx_seq;
+    }
+    channel->expected_tx_seq = next_tx_seq;
+    channel->req_seq         = next_tx_seq;
+}
+
+// add all missing frames before tx_seq to SREJ list
+static void l2cap_ertm_srej_list_add(l2cap_channel_t * channel, uint16_t tx_seq){
+    uint16_t offset = l2cap_ertm_rx_offset(channel, tx_seq);
+    if (offset < l2cap_ertm_rx_offset(channel, channel->srej_request_end)) return;
+    channel->srej_request_end = l2cap_next_ertm_seq_nr(channel, tx_seq);
+}
+
+static void l2cap_ertm_srej_list_clear(l2cap_channel_t * channel){
+    channel->srej_request_seq = channel->expected_tx_seq;
+    channel->srej_request_end = channel->expected_tx_seq;
 }
 
 static int l2cap_ertm_can_store_packet_now(l2cap_channel_t * channel){
@@ -373,16 +519,24 @@ static int l2cap_ertm_send_information_frame(l2cap_channel_t * channel, int inde
     l2cap_ertm_tx_packet_state_t * tx_state = &channel->tx_packets_state[index];
     hci_reserve_packet_buffer();
     uint8_t *acl_buffer = hci_get_outgoing_packet_buffer();
-    uint16_t control = l2cap_encanced_control_field_for_information_frame(tx_state->tx_seq, final, channel->req_seq, tx_state->sar);
-    log_info("I-Frame: control 0x%04x", control);
-    little_endian_store_16(acl_buffer, 8, control);
-    (void)memcpy(&acl_buffer[8 + 2],
+    uint32_t control;
+    if (channel->extended_control){
+        control = l2cap_extended_control_field_for_information_frame(tx_state->tx_seq, final, channel->req_seq, tx_state->sar);
+    } else {
+        control = l2cap_encanced_control_field_for_information_frame(tx_state->tx_seq, final, channel->req_seq, tx_state->sar);
+    }
+    log_info("I-Frame: control 0x%04x", (unsigned int) control);
+    l2cap_ertm_store_control_field(channel, &acl_buffer[8], control);
+    uint16_t control_size = l2cap_ertm_control_size(channel);
+    (void)memcpy(&acl_buffer[8 + control_size],
                  &channel->tx_packets_data[index * channel->local_mps],
                  tx_state->len);
     // (re-)start retransmission timer on 
-    l2cap_ertm_start_retransmission_timer(channel);
+    if (channel->mode == L2CAP_CHANNEL_MODE_ENHANCED_RETRANSMISSION){
+        l2cap_ertm_start_retransmission_timer(channel);
+    }
     // send
-    return l2cap_send_prepared(channel->local_cid, 2 + tx_state->len);
+    return l2cap_send_prepared(channel->local_cid, control_size + tx_state->len);
 }
 
 static void l2cap_ertm_store_fragment(l2cap_channel_t * channel, l2cap_segmentation_and_reassembly_t sar, uint16_t sdu_length, uint8_t * data, uint16_t len){
@@ -393,6 +547,7 @@ static void l2cap_ertm_store_fragment(l2cap_channel_t * channel, l2cap_segmentat
     tx_state->tx_seq = channel->next_tx_seq;
     tx_state->sar = sar;
     tx_state->retry_count = 0;
+    tx_state->retransmission_requested = 0;
 
     uint8_t * tx_packet = &channel->tx_packets_data[index * channel->local_mps];
     log_debug("index %u, local mps %u, remote mps %u, packet tx %p, len %u", index, channel->local_mps, channel->remote_mps, tx_packet, len);
@@ -406,7 +561,7 @@ static void l2cap_ertm_store_fragment(l2cap_channel_t * channel, l2cap_segmentat
 
     // update
     channel->num_stored_tx_frames++;
-    channel->next_tx_seq = l2cap_next_ertm_seq_nr(channel->next_tx_seq);
+    channel->next_tx_seq = l2cap_next_ertm_seq_nr(channel, channel->next_tx_seq);
     l2cap_ertm_next_tx_write_index(channel);
 
     log_info("l2cap_ertm_store_fragment: tx_read_index %u, tx_write_index %u, num stored %u", channel->tx_read_index, channel->tx_write_index, channel->num_stored_tx_frames);
@@ -463,18 +618,37 @@ static int l2cap_ertm_send(l2cap_channel_t * channel, uint8_t * data, uint16_t l
 
 static uint16_t l2cap_setup_options_ertm_request(l2cap_channel_t * channel, uint8_t * config_options){
     int pos = 0;
+    // use Extended Window Size option for windows larger than 63 frames, if supported by remote
+    hci_connection_t * connection = hci_connection_for_handle(channel->con_handle);
+    if ((channel->mode == L2CAP_CHANNEL_MODE_ENHANCED_RETRANSMISSION) && (channel->num_rx_buffers > 63) && (connection != NULL)
+    && ((connection->l2cap_state.extended_feature_mask & 0x100) != 0)){
+        channel->extended_control = 1;
+    }
     config_options[pos++] = L2CAP_CONFIG_OPTION_TYPE_RETRANSMISSION_AND_FLOW_CONTROL;
     config_options[pos++] = 9;      // length
     config_options[pos++] = (uint8_t) channel->mode;
-    config_options[pos++] = channel->num_rx_buffers;    // == TxWindows size
-    config_options[pos++] = channel->local_max_transmit;
-    little_endian_store_16( config_options, pos, channel->local_retransmission_timeout_ms);
-    pos += 2;
-    little_endian_store_16( config_options, pos, channel->local_monitor_timeout_ms);
-    pos += 2;
+    if (channel->mode == L2CAP_CHANNEL_MODE_STREAMING_MODE){
+        // TxWindow, MaxTransmit, Retransmission and Monitor time-out are not used in Streaming Mode
+        memset(&config_options[pos], 0, 6);
+        pos += 6;
+    } else {
+        config_options[pos++] = (uint8_t) btstack_min(channel->num_rx_buffers, 63);    // == TxWindows size
+        config_options[pos++] = channel->local_max_transmit;
+        little_endian_store_16( config_options, pos, channel->local_retransmission_timeout_ms);
+        pos += 2;
+        little_endian_store_16( config_options, pos, channel->local_monitor_timeout_ms);
+        pos += 2;
+    }
     little_endian_store_16( config_options, pos, channel->local_mps);
     pos += 2;
     //
+    if (channel->extended_control){
+        config_options[pos++] = L2CAP_CONFIG_OPTION_TYPE_EXTENDED_WINDOW_SIZE;
+        config_options[pos++] = 2;     // length
+        little_endian_store_16(config_options, pos, channel->num_rx_buffers);
+        pos += 2;
+    }
+    //
     config_options[pos++] = L2CAP_CONFIG_OPTION_TYPE_MAX_TRANSMISSION_UNIT;
     config_options[pos++] = 2;     // length
     little_endian_store_16(config_options, pos, channel->local_mtu);
@@ -485,7 +659,7 @@ static uint16_t l2cap_setup_options_ertm_request(l2cap_channel_t * channel, uint
     config_options[pos++] = L2CAP_CONFIG_OPTION_TYPE_FRAME_CHECK_SEQUENCE;
     config_options[pos++] = 1;     // length
     config_options[pos++] = channel->fcs_option;
-    return pos; // 11+4+3=18
+    return pos; // 11+4+4+3=22
 }
 
 static uint16_t l2cap_setup_options_ertm_response(l2cap_channel_t * channel, uint8_t * config_options){
@@ -493,18 +667,24 @@ static uint16_t l2cap_setup_options_ertm_response(l2cap_channel_t * channel, uin
     config_options[pos++] = L2CAP_CONFIG_OPTION_TYPE_RETRANSMISSION_AND_FLOW_CONTROL;
     config_options[pos++] = 9;      // length
     config_options[pos++] = (uint8_t) channel->mode;
-    // less or equal to remote tx window size
-    config_options[pos++] = btstack_min(channel->num_tx_buffers, channel->remote_tx_window_size);
-    // max transmit in response shall be ignored -> use sender values
-    config_options[pos++] = channel->remote_max_transmit;
-    // A value for the Retransmission time-out shall be sent in a positive Configuration Response
-    // and indicates the value that will be used by the sender of the Configuration Response -> use our value
-    little_endian_store_16( config_options, pos, channel->local_retransmission_timeout_ms);
-    pos += 2;
-    // A value for the Monitor time-out shall be sent in a positive Configuration Response
-    // and indicates the value that will be used by the sender of the Configuration Response -> use our value
-    little_endian_store_16( config_options, pos, channel->local_monitor_timeout_ms);
-    pos += 2;
+    if (channel->mode == L2CAP_CHANNEL_MODE_STREAMING_MODE){
+        // TxWindow, MaxTransmit, Retransmission and Monitor time-out are not used in Streaming Mode
+        memset(&config_options[pos], 0, 6);
+        pos += 6;
+    } else {
+        // less or equal to remote tx window size, window > 63 is indicated by Extended Window Size option
+        config_options[pos++] = (uint8_t) btstack_min(btstack_min(channel->num_tx_buffers, channel->remote_tx_window_size), 63);
+        // max transmit in response shall be ignored -> use sender values
+        config_options[pos++] = channel->remote_max_transmit;
+        // A value for the Retransmission time-out shall be sent in a positive Configuration Response
+        // and indicates the value that will be used by the sender of the Configuration Response -> use our value
+        little_endian_store_16( config_options, pos, channel->local_retransmission_timeout_ms);
+        pos += 2;
+        // A value for the Monitor time-out shall be sent in a positive Configuration Response
+        // and indicates the value that will be used by the sender of the Configuration Response -> use our value
+        little_endian_store_16( config_options, pos, channel->local_monitor_timeout_ms);
+        pos += 2;
+    }
     // less or equal to remote mps
     uint16_t effective_mps = btstack_min(channel->remote_mps, channel->local_mps);
     little_endian_store_16( config_options, pos, effective_mps);
@@ -523,35 +703,48 @@ static uint16_t l2cap_setup_options_ertm_response(l2cap_channel_t * channel, uin
     return pos; // 11+4=15
 }
 
-static int l2cap_ertm_send_supervisor_frame(l2cap_channel_t * channel, uint16_t control){
+static int l2cap_ertm_send_supervisor_frame(l2cap_channel_t * channel, l2cap_supervisory_function_t supervisory_function, int poll, int final, uint16_t req_seq){
     hci_reserve_packet_buffer();
     uint8_t *acl_buffer = hci_get_outgoing_packet_buffer();
-    log_info("S-Frame: control 0x%04x", control);
-    little_endian_store_16(acl_buffer, 8, control);
-    return l2cap_send_prepared(channel->local_cid, 2);
+    uint32_t control;
+    if (channel->extended_control){
+        control = l2cap_extended_control_field_for_supevisor_frame(supervisory_function, poll, final, req_seq);
+    } else {
+        control = l2cap_encanced_control_field_for_supevisor_frame(supervisory_function, poll, final, (uint8_t) req_seq);
+    }
+    log_info("S-Frame: control 0x%04x", (unsigned int) control);
+    l2cap_ertm_store_control_field(channel, &acl_buffer[8], control);
+    return l2cap_send_prepared(channel->local_cid, l2cap_ertm_control_size(channel));
 }
 
 static uint8_t l2cap_ertm_validate_local_config(l2cap_ertm_config_t * ertm_config){
     
     uint8_t result = ERROR_CODE_SUCCESS;
-    if (ertm_config->max_transmit < 1){
-        log_error("max_transmit must be >= 1");
-        result = ERROR_CODE_INVALID_HCI_COMMAND_PARAMETERS;
-    }
-    if (ertm_config->retransmission_timeout_ms < 2000){
-        log_error("retransmission_timeout_ms must be >= 2000 ms");
-        result = ERROR_CODE_INVALID_HCI_COMMAND_PARAMETERS;
-    }
-    if (ertm_config->monitor_timeout_ms < 12000){
-        log_error("monitor_timeout_ms must be >= 12000 ms");
-        result = ERROR_CODE_INVALID_HCI_COMMAND_PARAMETERS;
+    // Streaming Mode doesn't retransmit and doesn't store out-of-order frames
+    if (ertm_config->streaming_mode == 0){
+        if (ertm_config->max_transmit < 1){
+            log_error("max_transmit must be >= 1");
+            result = ERROR_CODE_INVALID_HCI_COMMAND_PARAMETERS;
+        }
+        if (ertm_config->retransmission_timeout_ms < 2000){
+            log_error("retransmission_timeout_ms must be >= 2000 ms");
+            result = ERROR_CODE_INVALID_HCI_COMMAND_PARAMETERS;
+        }
+        if (ertm_config->monitor_timeout_ms < 12000){
+            log_error("monitor_timeout_ms must be >= 12000 ms");
+            result = ERROR_CODE_INVALID_HCI_COMMAND_PARAMETERS;
+        }
+        if (ertm_config->num_rx_buffers < 1){
+            log_error("num_rx_buffers must be >= 1");
+            result = ERROR_CODE_INVALID_HCI_COMMAND_PARAMETERS;
+        }
     }
     if (ertm_config->local_mtu < 48){
         log_error("local_mtu must be >= 48");
         result = ERROR_CODE_INVALID_HCI_COMMAND_PARAMETERS;
     }
-    if (ertm_config->num_rx_buffers < 1){
-        log_error("num_rx_buffers must be >= 1");
+    if (ertm_config->num_rx_buffers > 0x3fff){
+        log_error("num_rx_buffers must be <= 0x3fff");
         result = ERROR_CODE_INVALID_HCI_COMMAND_PARAMETERS;
     }
     if (ertm_config->num_tx_buffers < 1){
@@ -563,7 +756,7 @@ static uint8_t l2cap_ertm_validate_local_config(l2cap_ertm_config_t * ertm_confi
 
 static void l2cap_ertm_configure_channel(l2cap_channel_t * channel, l2cap_ertm_config_t * ertm_config, uint8_t * buffer, uint32_t size){
 
-    channel->mode  = L2CAP_CHANNEL_MODE_ENHANCED_RETRANSMISSION;
+    channel->mode  = ertm_config->streaming_mode ? L2CAP_CHANNEL_MODE_STREAMING_MODE : L2CAP_CHANNEL_MODE_ENHANCED_RETRANSMISSION;
     channel->ertm_mandatory = ertm_config->ertm_mandatory;
     channel->local_max_transmit = ertm_config->max_transmit;
     channel->local_retransmission_timeout_ms = ertm_config->retransmission_timeout_ms;
@@ -584,6 +777,9 @@ static void l2cap_ertm_configure_channel(l2cap_channel_t * channel, l2cap_ertm_c
     channel->tx_packets_state = (l2cap_ertm_tx_packet_state_t *) (void *) &buffer[pos];
     pos += ertm_config->num_tx_buffers * sizeof(l2cap_ertm_tx_packet_state_t);
 
+    // buffer might be reused from previous channel
+    memset(buffer, 0, pos);
+
     // setup reassembly buffer
     channel->reassembly_buffer = &buffer[pos];
     pos += ertm_config->local_mtu;
@@ -669,7 +865,7 @@ uint8_t l2cap_accept_ertm_connection(uint16_t local_cid, l2cap_ertm_config_t * e
     hci_connection_t * connection = hci_connection_for_handle(channel->con_handle);
     if (connection == NULL) return ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER;
 
-    if ((channel->mode == L2CAP_CHANNEL_MODE_ENHANCED_RETRANSMISSION) && ((connection->l2cap_state.extended_feature_mask & 0x08) == 0)){
+    if ((connection->l2cap_state.extended_feature_mask & l2cap_ertm_feature_for_mode(channel->mode)) == 0){
         // ERTM not possible, select basic mode and release buffer
         channel->mode = L2CAP_CHANNEL_MODE_BASIC;
         l2cap_emit_simple_event_with_cid(channel, L2CAP_EVENT_ERTM_BUFFER_RELEASED);
@@ -720,7 +916,7 @@ uint8_t l2cap_ertm_set_ready(uint16_t local_cid){
 }
 
 // Process-ReqSeq
-static void l2cap_ertm_process_req_seq(l2cap_channel_t * l2cap_channel, uint8_t req_seq){
+static void l2cap_ertm_process_req_seq(l2cap_channel_t * l2cap_channel, uint16_t req_seq){
     int num_buffers_acked = 0;
     l2cap_ertm_tx_packet_state_t * tx_state;
     log_info("l2cap_ertm_process_req_seq: tx_read_index %u, tx_write_index %u, req_seq %u", l2cap_channel->tx_read_index, l2cap_channel->tx_write_index, req_seq);
@@ -735,7 +931,7 @@ static void l2cap_ertm_process_req_seq(l2cap_channel_t * l2cap_channel, uint8_t
 
         tx_state = &l2cap_channel->tx_packets_state[l2cap_channel->tx_read_index];
         // calc delta
-        int delta = (req_seq - tx_state->tx_seq) & 0x03f;
+        int delta = (req_seq - tx_state->tx_seq) & l2cap_ertm_seq_mask(l2cap_channel);
         if (delta == 0) break;  // all packets acknowledged
         if (delta > l2cap_channel->remote_tx_window_size) break;   
 
@@ -745,7 +941,7 @@ static void l2cap_ertm_process_req_seq(l2cap_channel_t * l2cap_channel, uint8_t
         log_info("RR seq %u => packet with tx_seq %u done", req_seq, tx_state->tx_seq);
 
         l2cap_channel->tx_read_index++;
-        if (l2cap_channel->tx_read_index >= l2cap_channel->num_rx_buffers){
+        if (l2cap_channel->tx_read_index >= l2cap_channel->num_tx_buffers){
             l2cap_channel->tx_read_index = 0;
         }
     }
@@ -755,11 +951,17 @@ static void l2cap_ertm_process_req_seq(l2cap_channel_t * l2cap_channel, uint8_t
 }     
 }     
 
-static l2cap_ertm_tx_packet_state_t * l2cap_ertm_get_tx_state(l2cap_channel_t * l2cap_channel, uint8_t tx_seq){
-    int i;
-    for (i=0;i<l2cap_channel->num_tx_buffers;i++){
-        l2cap_ertm_tx_packet_state_t * tx_state = &l2cap_channel->tx_packets_state[i];
+static l2cap_ertm_tx_packet_state_t * l2cap_ertm_get_tx_state(l2cap_channel_t * l2cap_channel, uint16_t tx_seq){
+    // only stored frames can be retransmitted
+    uint16_t index = l2cap_channel->tx_read_index;
+    uint16_t i;
+    for (i=0;i<l2cap_channel->num_stored_tx_frames;i++){
+        l2cap_ertm_tx_packet_state_t * tx_state = &l2cap_channel->tx_packets_state[index];
         if (tx_state->tx_seq == tx_seq) return tx_state;
+        index++;
+        if (index >= l2cap_channel->num_tx_buffers){
+            index = 0;
+        }
     }
     return NULL;
 }
@@ -769,10 +971,7 @@ static l2cap_ertm_tx_packet_state_t * l2cap_ertm_get_tx_state(l2cap_channel_t *
 static void l2cap_ertm_handle_out_of_sequence_sdu(l2cap_channel_t * l2cap_channel, l2cap_segmentation_and_reassembly_t sar, int delta, const uint8_t * payload, uint16_t size){
     log_info("Store SDU with delta %u", delta);
     // get rx state for packet to store
-    int index = l2cap_channel->rx_store_index + delta - 1;
-    if (index > l2cap_channel->num_rx_buffers){
-        index -= l2cap_channel->num_rx_buffers;
-    }
+    int index = l2cap_ertm_rx_index(l2cap_channel, delta);
     log_info("Index of packet to store %u", index);
     l2cap_ertm_rx_packet_state_t * rx_state = &l2cap_channel->rx_packets_state[index];
     // check if buffer is free
@@ -783,7 +982,7 @@ static void l2cap_ertm_handle_out_of_sequence_sdu(l2cap_channel_t * l2cap_channe
     rx_state->valid = 1;
     rx_state->sar = sar;
     rx_state->len = size;
-    uint8_t * rx_buffer = &l2cap_channel->rx_packets_data[index];
+    uint8_t * rx_buffer = &l2cap_channel->rx_packets_data[index * l2cap_channel->local_mps];
     (void)memcpy(rx_buffer, payload, size);
 }
 
@@ -803,13 +1002,18 @@ static void l2cap_ertm_handle_in_sequence_sdu(l2cap_channel_t * l2cap_channel, l
             payload += 2;
             size    -= 2;
             // assert reassembled size <= our mtu
-            if (reassembly_sdu_length > l2cap_channel->local_mtu) break;
+            if (reassembly_sdu_length > l2cap_channel->local_mtu){
+                l2cap_channel->reassembly_sdu_length = 0;
+                break;
+            }
             // store start segment
             l2cap_channel->reassembly_sdu_length = reassembly_sdu_length;
             (void)memcpy(&l2cap_channel->reassembly_buffer[0], payload, size);
             l2cap_channel->reassembly_pos = size;
             break;
         case L2CAP_SEGMENTATION_AND_REASSEMBLY_CONTINUATION_OF_L2CAP_SDU:
+            // assert start segment was received
+            if (l2cap_channel->reassembly_sdu_length == 0) break;
             // assert size of reassembled data <= our mtu
             if (l2cap_channel->reassembly_pos + size > l2cap_channel->local_mtu) break;
             // store continuation segment
@@ -818,6 +1022,8 @@ static void l2cap_ertm_handle_in_sequence_sdu(l2cap_channel_t * l2cap_channel, l
             l2cap_channel->reassembly_pos += size;
             break;
         case L2CAP_SEGMENTATION_AND_REASSEMBLY_END_OF_L2CAP_SDU:
+            // assert start segment was received
+            if (l2cap_channel->reassembly_sdu_length == 0) break;
             // assert size of reassembled data <= our mtu
             if (l2cap_channel->reassembly_pos + size > l2cap_channel->local_mtu) break;
             // store continuation segment
@@ -829,17 +1035,28 @@ static void l2cap_ertm_handle_in_sequence_sdu(l2cap_channel_t * l2cap_channel, l
             // packet complete -> disapatch
             l2cap_dispatch_to_channel(l2cap_channel, L2CAP_DATA_PACKET, l2cap_channel->reassembly_buffer, l2cap_channel->reassembly_pos);
             l2cap_channel->reassembly_pos = 0;    
+            l2cap_channel->reassembly_sdu_length = 0;
             break; 
     }
 }
 
 static void l2cap_ertm_channel_send_information_frame(l2cap_channel_t * channel){
-    channel->unacked_frames++;
     int index = channel->tx_send_index;
     channel->tx_send_index++;
     if (channel->tx_send_index >= channel->num_tx_buffers){
         channel->tx_send_index = 0;
     }
+    if (channel->mode == L2CAP_CHANNEL_MODE_STREAMING_MODE){
+        l2cap_ertm_send_information_frame(channel, index, 0);   // final = 0
+        // frames are not acknowledged in Streaming Mode -> release buffer
+        channel->num_stored_tx_frames--;
+        channel->tx_read_index = channel->tx_send_index;
+        if (channel->waiting_for_can_send_now){
+            l2cap_ertm_notify_channel_can_send(channel);
+        }
+        return;
+    }
+    channel->unacked_frames++;
     l2cap_ertm_send_information_frame(channel, index, 0);   // final = 0
 }
 
@@ -869,6 +1086,9 @@ static uint8_t l2cap_next_sig_id(void){
 
 void l2cap_init(void){
     signaling_responses_pending = 0;
+#if defined(ENABLE_BLE) && defined(ENABLE_HCI_MULTIPLE_CONTROLLERS)
+    fixed_channel_rejects_pending = 0;
+#endif
     
     l2cap_channels = NULL;
 
@@ -886,6 +1106,10 @@ void l2cap_init(void){
     l2cap_le_services = NULL;
 #endif
 
+#ifdef ENABLE_L2CAP_ENHANCED_CREDIT_BASED_FLOW_CONTROL_MODE
+    l2cap_ecbm_services = NULL;
+#endif
+
 #ifdef ENABLE_BLE
     l2cap_event_packet_handler = NULL;
     l2cap_le_custom_max_mtu = 0;
@@ -905,10 +1129,18 @@ void l2cap_init(void){
     // register callback with HCI
     //
     hci_event_callback_registration.callback = &l2cap_hci_event_handler;
+#ifdef ENABLE_HCI_MULTIPLE_CONTROLLERS
+    hci_add_shared_event_handler(&hci_event_callback_registration);
+#else
     hci_add_event_handler(&hci_event_callback_registration);
+#endif
 
     hci_register_acl_packet_handler(&l2cap_acl_handler);
 
+#if defined(ENABLE_BTSTACK_STATS) && defined(L2CAP_USES_CHANNELS)
+    btstack_stats_add_source(&l2cap_stats_source);
+#endif
+
 #ifdef ENABLE_CLASSIC
     gap_connectable_control(0); // no services yet
 #endif
@@ -1011,7 +1243,16 @@ static void l2cap_emit_can_send_now(btstack_packet_handler_t packet_handler, uin
 
 #ifdef L2CAP_USES_CHANNELS
 static void l2cap_dispatch_to_channel(l2cap_channel_t *channel, uint8_t type, uint8_t * data, uint16_t size){
-    (* (channel->packet_handler))(type, channel->local_cid, data, size);
+    if (type != L2CAP_DATA_PACKET){
+        (* (channel->packet_handler))(type, channel->local_cid, data, size);
+        return;
+    }
+    // channel might get freed in packet handler
+    uint16_t local_cid = channel->local_cid;
+    BTSTACK_STATS_TRAFFIC_IN(&channel->stats, size);
+    BTSTACK_STATS_TRACE_BEGIN(L2CAP_CHANNEL, local_cid);
+    (* (channel->packet_handler))(type, local_cid, data, size);
+    BTSTACK_STATS_TRACE_END(L2CAP_CHANNEL, local_cid);
 }
 
 static void l2cap_emit_simple_event_with_cid(l2cap_channel_t * channel, uint8_t event_code){
@@ -1078,7 +1319,7 @@ static void l2cap_emit_incoming_connection(l2cap_channel_t *channel) {
 static void l2cap_handle_channel_open_failed(l2cap_channel_t * channel, uint8_t status){
 #ifdef ENABLE_L2CAP_ENHANCED_RETRANSMISSION_MODE
     // emit ertm buffer released, as it's not needed. if in basic mode, it was either not allocated or already released
-    if (channel->mode == L2CAP_CHANNEL_MODE_ENHANCED_RETRANSMISSION){
+    if (l2cap_ertm_or_streaming_mode(channel)){
         l2cap_emit_simple_event_with_cid(channel, L2CAP_EVENT_ERTM_BUFFER_RELEASED);
     }
 #endif
@@ -1088,7 +1329,7 @@ static void l2cap_handle_channel_open_failed(l2cap_channel_t * channel, uint8_t
 static void l2cap_handle_channel_closed(l2cap_channel_t * channel){
 #ifdef ENABLE_L2CAP_ENHANCED_RETRANSMISSION_MODE
     // emit ertm buffer released, as it's not needed anymore. if in basic mode, it was either not allocated or already released
-    if (channel->mode == L2CAP_CHANNEL_MODE_ENHANCED_RETRANSMISSION){
+    if (l2cap_ertm_or_streaming_mode(channel)){
         l2cap_emit_simple_event_with_cid(channel, L2CAP_EVENT_ERTM_BUFFER_RELEASED);
     }
 #endif
@@ -1121,12 +1362,27 @@ static l2cap_channel_t * l2cap_get_channel_for_local_cid(uint16_t local_cid){
     return (l2cap_channel_t*) l2cap_channel_item_by_cid(local_cid);
 }
 
+#ifdef ENABLE_LE_DATA_CHANNELS
+static l2cap_channel_t * l2cap_get_channel_for_remote_handle_and_cid(hci_con_handle_t con_handle, uint16_t remote_cid){
+    btstack_linked_list_iterator_t it;
+    btstack_linked_list_iterator_init(&it, &l2cap_channels);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        l2cap_channel_t * channel = (l2cap_channel_t *) btstack_linked_list_iterator_next(&it);
+        if (!l2cap_is_dynamic_channel_type(channel->channel_type)) continue;
+        if (!l2cap_channel_uses_connection(channel, con_handle)) continue;
+        if (channel->remote_cid != remote_cid) continue;
+        return channel;
+    }
+    return NULL;
+}
+#endif
+
 void l2cap_request_can_send_now_event(uint16_t local_cid){
     l2cap_channel_t *channel = l2cap_get_channel_for_local_cid(local_cid);
     if (!channel) return;
     channel->waiting_for_can_send_now = 1;
 #ifdef ENABLE_L2CAP_ENHANCED_RETRANSMISSION_MODE
-    if (channel->mode == L2CAP_CHANNEL_MODE_ENHANCED_RETRANSMISSION){
+    if (l2cap_ertm_or_streaming_mode(channel)){
         l2cap_ertm_notify_channel_can_send(channel);
         return;
     }
@@ -1138,22 +1394,36 @@ int  l2cap_can_send_packet_now(uint16_t local_cid){
     l2cap_channel_t *channel = l2cap_get_channel_for_local_cid(local_cid);
     if (!channel) return 0;
 #ifdef ENABLE_L2CAP_ENHANCED_RETRANSMISSION_MODE
-    if (channel->mode == L2CAP_CHANNEL_MODE_ENHANCED_RETRANSMISSION){
+    if (l2cap_ertm_or_streaming_mode(channel)){
         return l2cap_ertm_can_store_packet_now(channel);
     }
 #endif    
+#ifdef ENABLE_HCI_MULTIPLE_CONTROLLERS
+    uint8_t selected_controller = l2cap_select_controller_for_channel(channel);
+    int can_send = hci_can_send_acl_packet_now(channel->con_handle);
+    hci_select_controller(selected_controller);
+    return can_send;
+#else
     return hci_can_send_acl_packet_now(channel->con_handle);
+#endif
 }
 
 int  l2cap_can_send_prepared_packet_now(uint16_t local_cid){
     l2cap_channel_t *channel = l2cap_get_channel_for_local_cid(local_cid);
     if (!channel) return 0;
 #ifdef ENABLE_L2CAP_ENHANCED_RETRANSMISSION_MODE
-    if (channel->mode == L2CAP_CHANNEL_MODE_ENHANCED_RETRANSMISSION){
+    if (l2cap_ertm_or_streaming_mode(channel)){
         return 0;
     }
 #endif
+#ifdef ENABLE_HCI_MULTIPLE_CONTROLLERS
+    uint8_t selected_controller = l2cap_select_controller_for_channel(channel);
+    int can_send = hci_can_send_prepared_acl_packet_now(channel->con_handle);
+    hci_select_controller(selected_controller);
+    return can_send;
+#else
     return hci_can_send_prepared_acl_packet_now(channel->con_handle);
+#endif
 }
 
 uint16_t l2cap_get_remote_mtu_for_local_cid(uint16_t local_cid){
@@ -1170,6 +1440,7 @@ static int l2cap_is_dynamic_channel_type(l2cap_channel_type_t channel_type){
     switch (channel_type){
         case L2CAP_CHANNEL_TYPE_CLASSIC:
         case L2CAP_CHANNEL_TYPE_LE_DATA_CHANNEL:
+        case L2CAP_CHANNEL_TYPE_LE_ECBM:
             return 1;
         default:
             return 0;
@@ -1177,6 +1448,72 @@ static int l2cap_is_dynamic_channel_type(l2cap_channel_type_t channel_type){
 }
 #endif
 
+// fixed channels (ATT, SM, Connectionless) are only provided on the primary Controller,
+// ATT requests and SM pairing on secondary Controllers get rejected, see l2cap_register_fixed_channel_reject
+static bool l2cap_fixed_channels_on_selected_controller(void){
+#ifdef ENABLE_HCI_MULTIPLE_CONTROLLERS
+    return hci_get_selected_controller() == 0u;
+#else
+    return true;
+#endif
+}
+
+// dynamic channels use the Controller of their connection
+static bool l2cap_channel_on_selected_controller(const l2cap_channel_t * channel){
+#if defined(ENABLE_HCI_MULTIPLE_CONTROLLERS) && defined(L2CAP_USES_CHANNELS)
+    if (l2cap_is_dynamic_channel_type(channel->channel_type)){
+        return channel->controller_index == hci_get_selected_controller();
+    }
+#else
+    UNUSED(channel);
+#endif
+    return l2cap_fixed_channels_on_selected_controller();
+}
+
+#ifdef L2CAP_USES_CHANNELS
+// channel uses connection with con_handle on the selected Controller
+static bool l2cap_channel_uses_connection(const l2cap_channel_t * channel, hci_con_handle_t con_handle){
+    if (channel->con_handle != con_handle) return false;
+    return l2cap_channel_on_selected_controller(channel);
+}
+
+#ifdef ENABLE_L2CAP_ENHANCED_CREDIT_BASED_FLOW_CONTROL_MODE
+// both channels use the same connection
+static bool l2cap_channels_share_connection(const l2cap_channel_t * channel, const l2cap_channel_t * other_channel){
+    if (channel->con_handle != other_channel->con_handle) return false;
+#ifdef ENABLE_HCI_MULTIPLE_CONTROLLERS
+    if (channel->controller_index != other_channel->controller_index) return false;
+#endif
+    return true;
+}
+#endif
+
+#ifdef ENABLE_HCI_MULTIPLE_CONTROLLERS
+// select Controller of channel, returns previously selected Controller
+static uint8_t l2cap_select_controller_for_channel(const l2cap_channel_t * channel){
+    uint8_t selected_controller = hci_get_selected_controller();
+    hci_select_controller(channel->controller_index);
+    return selected_controller;
+}
+#endif
+#endif
+
+#ifdef ENABLE_HCI_MULTIPLE_CONTROLLERS
+// call function with each Controller selected
+static void l2cap_for_each_controller(void (*function)(void)){
+    if (hci_get_num_controllers() == 0u) return;
+    uint8_t selected_controller = hci_get_selected_controller();
+    uint8_t controller_index;
+    for (controller_index = 0; controller_index < hci_get_num_controllers(); controller_index++){
+        hci_select_controller(controller_index);
+        (*function)();
+    }
+    // hci_close might have been called
+    if (selected_controller >= hci_get_num_controllers()) return;
+    hci_select_controller(selected_controller);
+}
+#endif
+
 #ifdef ENABLE_CLASSIC
 // RTX Timer only exist for dynamic channels
 static l2cap_channel_t * l2cap_channel_for_rtx_timer(btstack_timer_source_t * ts){
@@ -1262,30 +1599,24 @@ static int l2cap_send_signaling_packet(hci_con_handle_t handle, L2CAP_SIGNALING_
 
 // assumption - only on Classic connections
 // cannot be used for L2CAP ERTM
-int l2cap_send_prepared(uint16_t local_cid, uint16_t len){
-    
+static int l2cap_classic_send_prepared(l2cap_channel_t * channel, uint16_t len){
+
     if (!hci_is_packet_buffer_reserved()){
         log_error("l2cap_send_prepared called without reserving packet first");
         return BTSTACK_ACL_BUFFERS_FULL;
     }
 
-    l2cap_channel_t * channel = l2cap_get_channel_for_local_cid(local_cid);
-    if (!channel) {
-        log_error("l2cap_send_prepared no channel for cid 0x%02x", local_cid);
-        return -1;   // TODO: define error
-    }
-
     if (!hci_can_send_prepared_acl_packet_now(channel->con_handle)){
-        log_info("l2cap_send_prepared cid 0x%02x, cannot send", local_cid);
+        log_info("l2cap_send_prepared cid 0x%02x, cannot send", channel->local_cid);
         return BTSTACK_ACL_BUFFERS_FULL;
     }
     
-    log_debug("l2cap_send_prepared cid 0x%02x, handle %u, 1 credit used", local_cid, channel->con_handle);
+    log_debug("l2cap_send_prepared cid 0x%02x, handle %u, 1 credit used", channel->local_cid, channel->con_handle);
     
     int fcs_size = 0;
 
 #ifdef ENABLE_L2CAP_ENHANCED_RETRANSMISSION_MODE
-    if (channel->mode == L2CAP_CHANNEL_MODE_ENHANCED_RETRANSMISSION && channel->fcs_option){
+    if (l2cap_ertm_or_streaming_mode(channel) && channel->fcs_option){
         fcs_size = 2;
     }
 #endif
@@ -1305,38 +1636,67 @@ int l2cap_send_prepared(uint16_t local_cid, uint16_t len){
 #endif
 
     // send
+    BTSTACK_STATS_TRAFFIC_OUT(&channel->stats, len + fcs_size);
     return hci_send_acl_packet_buffer(len+8+fcs_size);
 }
 
-// assumption - only on Classic connections
-int l2cap_send(uint16_t local_cid, uint8_t *data, uint16_t len){
+int l2cap_send_prepared(uint16_t local_cid, uint16_t len){
     l2cap_channel_t * channel = l2cap_get_channel_for_local_cid(local_cid);
     if (!channel) {
-        log_error("l2cap_send no channel for cid 0x%02x", local_cid);
+        log_error("l2cap_send_prepared no channel for cid 0x%02x", local_cid);
         return -1;   // TODO: define error
     }
-
-#ifdef ENABLE_L2CAP_ENHANCED_RETRANSMISSION_MODE
-    // send in ERTM
-    if (channel->mode == L2CAP_CHANNEL_MODE_ENHANCED_RETRANSMISSION){
-        return l2cap_ertm_send(channel, data, len);
-    }
+#ifdef ENABLE_HCI_MULTIPLE_CONTROLLERS
+    uint8_t selected_controller = l2cap_select_controller_for_channel(channel);
+    int status = l2cap_classic_send_prepared(channel, len);
+    hci_select_controller(selected_controller);
+    return status;
+#else
+    return l2cap_classic_send_prepared(channel, len);
 #endif
+}
+
+// assumption - only on Classic connections
+static int l2cap_classic_send(l2cap_channel_t * channel, uint8_t *data, uint16_t len){
 
     if (len > channel->remote_mtu){
-        log_error("l2cap_send cid 0x%02x, data length exceeds remote MTU.", local_cid);
+        log_error("l2cap_send cid 0x%02x, data length exceeds remote MTU.", channel->local_cid);
         return L2CAP_DATA_LEN_EXCEEDS_REMOTE_MTU;
     }
 
     if (!hci_can_send_acl_packet_now(channel->con_handle)){
-        log_info("l2cap_send cid 0x%02x, cannot send", local_cid);
+        log_info("l2cap_send cid 0x%02x, cannot send", channel->local_cid);
         return BTSTACK_ACL_BUFFERS_FULL;
     }
 
     hci_reserve_packet_buffer();
     uint8_t *acl_buffer = hci_get_outgoing_packet_buffer();
     (void)memcpy(&acl_buffer[8], data, len);
-    return l2cap_send_prepared(local_cid, len);
+    return l2cap_classic_send_prepared(channel, len);
+}
+
+int l2cap_send(uint16_t local_cid, uint8_t *data, uint16_t len){
+    l2cap_channel_t * channel = l2cap_get_channel_for_local_cid(local_cid);
+    if (!channel) {
+        log_error("l2cap_send no channel for cid 0x%02x", local_cid);
+        return -1;   // TODO: define error
+    }
+
+#ifdef ENABLE_L2CAP_ENHANCED_RETRANSMISSION_MODE
+    // send in ERTM
+    if (l2cap_ertm_or_streaming_mode(channel)){
+        return l2cap_ertm_send(channel, data, len);
+    }
+#endif
+
+#ifdef ENABLE_HCI_MULTIPLE_CONTROLLERS
+    uint8_t selected_controller = l2cap_select_controller_for_channel(channel);
+    int status = l2cap_classic_send(channel, data, len);
+    hci_select_controller(selected_controller);
+    return status;
+#else
+    return l2cap_classic_send(channel, data, len);
+#endif
 }
 
 int l2cap_send_echo_request(hci_con_handle_t con_handle, uint8_t *data, uint16_t len){
@@ -1403,14 +1763,14 @@ static uint16_t l2cap_setup_options_mtu(uint8_t * config_options, uint16_t mtu){
 static int l2cap_ertm_mode(l2cap_channel_t * channel){
     hci_connection_t * connection = hci_connection_for_handle(channel->con_handle);
     return ((connection->l2cap_state.information_state == L2CAP_INFORMATION_STATE_DONE) 
-        &&  (connection->l2cap_state.extended_feature_mask & 0x08));
+        &&  (connection->l2cap_state.extended_feature_mask & l2cap_ertm_feature_for_mode(channel->mode)));
 }
 #endif
 
 static uint16_t l2cap_setup_options_request(l2cap_channel_t * channel, uint8_t * config_options){
 #ifdef ENABLE_L2CAP_ENHANCED_RETRANSMISSION_MODE
     // use ERTM options if supported by remote and channel ready to use it
-    if (l2cap_ertm_mode(channel) && channel->mode == L2CAP_CHANNEL_MODE_ENHANCED_RETRANSMISSION){
+    if (l2cap_ertm_or_streaming_mode(channel) && l2cap_ertm_mode(channel)){
         return l2cap_setup_options_ertm_request(channel, config_options);
     }
 #endif
@@ -1427,7 +1787,8 @@ static uint32_t l2cap_extended_features_mask(void){
     // extended features request supported, features: fixed channels, unicast connectionless data reception
     uint32_t features = 0x280;
 #ifdef ENABLE_L2CAP_ENHANCED_RETRANSMISSION_MODE
-    features |= 0x0028;
+    // enhanced retransmission mode, fcs option, streaming mode, extended window size
+    features |= 0x01b8;
 #endif
     return features;
 }
@@ -1494,8 +1855,8 @@ static bool l2cap_run_for_classic_channel(l2cap_channel_t * channel){
         case L2CAP_STATE_CONFIG:
             if (!hci_can_send_acl_packet_now(channel->con_handle)) return false;
 #ifdef ENABLE_L2CAP_ENHANCED_RETRANSMISSION_MODE
-            // fallback to basic mode if ERTM requested but not not supported by remote
-            if (channel->mode == L2CAP_CHANNEL_MODE_ENHANCED_RETRANSMISSION){
+            // fallback to basic mode if ERTM or Streaming Mode requested but not not supported by remote
+            if (l2cap_ertm_or_streaming_mode(channel)){
                 if (!l2cap_ertm_mode(channel)){
                     l2cap_emit_simple_event_with_cid(channel, L2CAP_EVENT_ERTM_BUFFER_RELEASED);
                     channel->mode = L2CAP_CHANNEL_MODE_BASIC;
@@ -1584,38 +1945,45 @@ static void l2cap_run_for_classic_channel_ertm(l2cap_channel_t * channel){
     if (channel->send_supervisor_frame_receiver_ready){
         channel->send_supervisor_frame_receiver_ready = 0;
         log_info("Send S-Frame: RR %u, final %u", channel->req_seq, channel->set_final_bit_after_packet_with_poll_bit_set);
-        uint16_t control = l2cap_encanced_control_field_for_supevisor_frame( L2CAP_SUPERVISORY_FUNCTION_RR_RECEIVER_READY, 0,  channel->set_final_bit_after_packet_with_poll_bit_set, channel->req_seq);
+        int final = channel->set_final_bit_after_packet_with_poll_bit_set;
         channel->set_final_bit_after_packet_with_poll_bit_set = 0;
-        l2cap_ertm_send_supervisor_frame(channel, control);
+        l2cap_ertm_send_supervisor_frame(channel, L2CAP_SUPERVISORY_FUNCTION_RR_RECEIVER_READY, 0, final, channel->req_seq);
         return;
     }
     if (channel->send_supervisor_frame_receiver_ready_poll){
         channel->send_supervisor_frame_receiver_ready_poll = 0;
         log_info("Send S-Frame: RR %u with poll=1 ", channel->req_seq);
-        uint16_t control = l2cap_encanced_control_field_for_supevisor_frame( L2CAP_SUPERVISORY_FUNCTION_RR_RECEIVER_READY, 1, 0, channel->req_seq);
-        l2cap_ertm_send_supervisor_frame(channel, control);
+        l2cap_ertm_send_supervisor_frame(channel, L2CAP_SUPERVISORY_FUNCTION_RR_RECEIVER_READY, 1, 0, channel->req_seq);
         return;
     }
     if (channel->send_supervisor_frame_receiver_not_ready){
         channel->send_supervisor_frame_receiver_not_ready = 0;
         log_info("Send S-Frame: RNR %u", channel->req_seq);
-        uint16_t control = l2cap_encanced_control_field_for_supevisor_frame( L2CAP_SUPERVISORY_FUNCTION_RNR_RECEIVER_NOT_READY, 0, 0, channel->req_seq);
-        l2cap_ertm_send_supervisor_frame(channel, control);
+        l2cap_ertm_send_supervisor_frame(channel, L2CAP_SUPERVISORY_FUNCTION_RNR_RECEIVER_NOT_READY, 0, 0, channel->req_seq);
         return;
     }
     if (channel->send_supervisor_frame_reject){
         channel->send_supervisor_frame_reject = 0;
         log_info("Send S-Frame: REJ %u", channel->req_seq);
-        uint16_t control = l2cap_encanced_control_field_for_supevisor_frame( L2CAP_SUPERVISORY_FUNCTION_REJ_REJECT, 0, 0, channel->req_seq);
-        l2cap_ertm_send_supervisor_frame(channel, control);
+        l2cap_ertm_send_supervisor_frame(channel, L2CAP_SUPERVISORY_FUNCTION_REJ_REJECT, 0, 0, channel->req_seq);
         return;
     }
     if (channel->send_supervisor_frame_selective_reject){
         channel->send_supervisor_frame_selective_reject = 0;
         log_info("Send S-Frame: SREJ %u", channel->expected_tx_seq);
-        uint16_t control = l2cap_encanced_control_field_for_supevisor_frame( L2CAP_SUPERVISORY_FUNCTION_SREJ_SELECTIVE_REJECT, 0, channel->set_final_bit_after_packet_with_poll_bit_set, channel->expected_tx_seq);
+        int final = channel->set_final_bit_after_packet_with_poll_bit_set;
         channel->set_final_bit_after_packet_with_poll_bit_set = 0;
-        l2cap_ertm_send_supervisor_frame(channel, control);
+        l2cap_ertm_send_supervisor_frame(channel, L2CAP_SUPERVISORY_FUNCTION_SREJ_SELECTIVE_REJECT, 0, final, channel->expected_tx_seq);
+        return;
+    }
+
+    // request all missing frames in SREJ list
+    while (channel->srej_request_seq != channel->srej_request_end){
+        uint16_t tx_seq = channel->srej_request_seq;
+        channel->srej_request_seq = l2cap_next_ertm_seq_nr(channel, tx_seq);
+        if (l2cap_ertm_rx_frame_stored(channel, tx_seq)) continue;
+        log_info("Send S-Frame: SREJ %u", tx_seq);
+        l2cap_ertm_send_supervisor_frame(channel, L2CAP_SUPERVISORY_FUNCTION_SREJ_SELECTIVE_REJECT, 0, 0, tx_seq);
         return;
     }
 
@@ -1643,6 +2011,79 @@ static void l2cap_run_for_classic_channel_ertm(l2cap_channel_t * channel){
 #endif /* ERTM */
 #endif /* Classic */
 
+#if defined(ENABLE_BLE) && defined(ENABLE_HCI_MULTIPLE_CONTROLLERS)
+static void l2cap_run_fixed_channel_rejects(void){
+
+    while (fixed_channel_rejects_pending){
+
+        hci_con_handle_t handle = fixed_channel_rejects[0].handle;
+
+        // rejects are sent in order, wait for Controller of the oldest one
+        if (fixed_channel_rejects[0].controller_index != hci_get_selected_controller()) break;
+
+        bool connected = hci_connection_for_handle(handle) != NULL;
+        if (connected && !hci_can_send_acl_packet_now(handle)) break;
+
+        uint16_t cid    = fixed_channel_rejects[0].cid;
+        uint8_t  opcode = fixed_channel_rejects[0].opcode;
+
+        // remove first item before sending
+        fixed_channel_rejects_pending--;
+        int i;
+        for (i=0; i < fixed_channel_rejects_pending; i++){
+            (void)memcpy(&fixed_channel_rejects[i],
+                         &fixed_channel_rejects[i + 1],
+                         sizeof(l2cap_fixed_channel_reject_t));
+        }
+
+        // connection closed in the meantime
+        if (!connected) continue;
+
+        if (cid == L2CAP_CID_ATTRIBUTE_PROTOCOL){
+            uint8_t error_response[5];
+            error_response[0] = ATT_ERROR_RESPONSE;
+            error_response[1] = opcode;
+            little_endian_store_16(error_response, 2, 0);
+            error_response[4] = ATT_ERROR_REQUEST_NOT_SUPPORTED;
+            (void) l2cap_send_connectionless(handle, cid, error_response, sizeof(error_response));
+        } else {
+            uint8_t pairing_failed[2];
+            pairing_failed[0] = SM_CODE_PAIRING_FAILED;
+            pairing_failed[1] = SM_REASON_PAIRING_NOT_SUPPORTED;
+            (void) l2cap_send_connectionless(handle, cid, pairing_failed, sizeof(pairing_failed));
+        }
+    }
+}
+
+// ATT requests expect a response, SM Pairing and Security Request would otherwise run into the SMP timeout
+static void l2cap_register_fixed_channel_reject(hci_con_handle_t handle, uint16_t cid, const uint8_t * pdu, uint16_t size){
+    if (size == 0u) return;
+    uint8_t opcode = pdu[0];
+    switch (cid){
+        case L2CAP_CID_ATTRIBUTE_PROTOCOL:
+            // commands and responses, notifications, indications don't get a response
+            if ((opcode & 0x41u) != 0u) return;
+            if (opcode == ATT_HANDLE_VALUE_CONFIRMATION) return;
+            break;
+        case L2CAP_CID_SECURITY_MANAGER_PROTOCOL:
+            if ((opcode != SM_CODE_PAIRING_REQUEST) && (opcode != SM_CODE_SECURITY_REQUEST)) return;
+            break;
+        default:
+            return;
+    }
+    if (fixed_channel_rejects_pending >= NR_PENDING_FIXED_CHANNEL_REJECTS){
+        log_error("l2cap_register_fixed_channel_reject, queue full, dropping opcode 0x%02x on cid 0x%04x", opcode, cid);
+        return;
+    }
+    fixed_channel_rejects[fixed_channel_rejects_pending].handle           = handle;
+    fixed_channel_rejects[fixed_channel_rejects_pending].controller_index = hci_get_selected_controller();
+    fixed_channel_rejects[fixed_channel_rejects_pending].cid              = cid;
+    fixed_channel_rejects[fixed_channel_rejects_pending].opcode           = opcode;
+    fixed_channel_rejects_pending++;
+    l2cap_run();
+}
+#endif
+
 static void l2cap_run_signaling_response(void) {
 
     // check pending signaling responses
@@ -1650,6 +2091,10 @@ static void l2cap_run_signaling_response(void) {
 
         hci_con_handle_t handle = signaling_responses[0].handle;
 
+#ifdef ENABLE_HCI_MULTIPLE_CONTROLLERS
+        // responses are sent in order, wait for Controller of the oldest one
+        if (signaling_responses[0].controller_index != hci_get_selected_controller()) break;
+#endif
         if (!hci_can_send_acl_packet_now(handle)) break;
 
         uint8_t  sig_id        = signaling_responses[0].sig_id;
@@ -1659,6 +2104,10 @@ static void l2cap_run_signaling_response(void) {
         uint16_t info_type     = signaling_responses[0].data;  // INFORMATION_REQUEST
         uint16_t source_cid    = signaling_responses[0].cid;   // CONNECTION_REQUEST
 #endif
+#ifdef ENABLE_L2CAP_ENHANCED_CREDIT_BASED_FLOW_CONTROL_MODE
+        uint16_t num_cids      = signaling_responses[0].cid;   // CREDIT_BASED_CONNECTION_REQUEST
+        uint8_t  destination_cids[L2CAP_ECBM_MAX_CID_ARRAY_SIZE * 2];
+#endif
 
         // remove first item before sending (to avoid sending response mutliple times)
         signaling_responses_pending--;
@@ -1717,6 +2166,16 @@ static void l2cap_run_signaling_response(void) {
             case COMMAND_REJECT_LE:
                 l2cap_send_le_signaling_packet(handle, COMMAND_REJECT, sig_id, result, 0, NULL);
                 break;
+#endif
+#ifdef ENABLE_L2CAP_ENHANCED_CREDIT_BASED_FLOW_CONTROL_MODE
+            case CREDIT_BASED_CONNECTION_REQUEST:
+                // all connections refused: mtu, mps, initial credits, result, destination cids
+                memset(destination_cids, 0, sizeof(destination_cids));
+                l2cap_send_le_signaling_packet(handle, CREDIT_BASED_CONNECTION_RESPONSE, sig_id, 0, 0, 0, result, num_cids * 2u, destination_cids);
+                break;
+            case CREDIT_BASED_RECONFIGURE_REQUEST:
+                l2cap_send_le_signaling_packet(handle, CREDIT_BASED_RECONFIGURE_RESPONSE, sig_id, result);
+                break;
 #endif
             default:
                 // should not happen
@@ -1752,8 +2211,18 @@ static void l2cap_run_le_data_channels(void){
     while (btstack_linked_list_iterator_has_next(&it)){
         uint16_t mps;
         l2cap_channel_t * channel = (l2cap_channel_t *) btstack_linked_list_iterator_next(&it);
-
-        if (channel->channel_type != L2CAP_CHANNEL_TYPE_LE_DATA_CHANNEL) continue;
+        if (!l2cap_channel_on_selected_controller(channel)) continue;
+
+        bool credit_based_channel = channel->channel_type == L2CAP_CHANNEL_TYPE_LE_DATA_CHANNEL;
+#ifdef ENABLE_L2CAP_ENHANCED_CREDIT_BASED_FLOW_CONTROL_MODE
+        if (channel->channel_type == L2CAP_CHANNEL_TYPE_LE_ECBM){
+            // multi-channel requests and responses may free channels, stop iterating
+            if (l2cap_run_ecbm_channel(channel)) return;
+            // credits and disconnect are handled as for LE Data Channels
+            credit_based_channel = true;
+        }
+#endif
+        if (!credit_based_channel) continue;
 
         // log_info("l2cap_run: channel %p, state %u, var 0x%02x", channel, channel->state, channel->state_var);
         switch (channel->state){
@@ -1820,11 +2289,14 @@ static void l2cap_run_le_data_channels(void){
 #endif
 
 // MARK: L2CAP_RUN
-// process outstanding signaling tasks
-static void l2cap_run(void){
+// process outstanding signaling tasks for connections of the selected Controller
+static void l2cap_run_for_selected_controller(void){
     
     // log_info("l2cap_run: entered");
     l2cap_run_signaling_response();
+#if defined(ENABLE_BLE) && defined(ENABLE_HCI_MULTIPLE_CONTROLLERS)
+    l2cap_run_fixed_channel_rejects();
+#endif
     
 #ifdef ENABLE_L2CAP_ENHANCED_RETRANSMISSION_MODE
     bool done = l2ap_run_ertm();
@@ -1842,6 +2314,7 @@ static void l2cap_run(void){
         l2cap_channel_t * channel = (l2cap_channel_t *) btstack_linked_list_iterator_next(&it);
 
         if (channel->channel_type != L2CAP_CHANNEL_TYPE_CLASSIC) continue;
+        if (!l2cap_channel_on_selected_controller(channel)) continue;
 
         // log_info("l2cap_run: channel %p, state %u, var 0x%02x", channel, channel->state, channel->state_var);
         bool finalized = l2cap_run_for_classic_channel(channel);
@@ -1888,6 +2361,14 @@ static void l2cap_run(void){
     // log_info("l2cap_run: exit");
 }
 
+static void l2cap_run(void){
+#ifdef ENABLE_HCI_MULTIPLE_CONTROLLERS
+    l2cap_for_each_controller(&l2cap_run_for_selected_controller);
+#else
+    l2cap_run_for_selected_controller();
+#endif
+}
+
 #ifdef ENABLE_CLASSIC
 static void l2cap_handle_connection_complete(hci_con_handle_t con_handle, l2cap_channel_t * channel){
     if ((channel->state == L2CAP_STATE_WAIT_CONNECTION_COMPLETE) || (channel->state == L2CAP_STATE_WILL_SEND_CREATE_CONNECTION)) {
@@ -1954,6 +2435,9 @@ static l2cap_channel_t * l2cap_create_channel_entry(btstack_packet_handler_t pac
     // 
     channel->local_cid = l2cap_next_local_cid();
     channel->con_handle = HCI_CON_HANDLE_INVALID;
+#ifdef ENABLE_HCI_MULTIPLE_CONTROLLERS
+    channel->controller_index = hci_get_selected_controller();
+#endif
 
     // set initial state
     channel->state = L2CAP_STATE_WILL_SEND_CREATE_CONNECTION;
@@ -1961,6 +2445,10 @@ static l2cap_channel_t * l2cap_create_channel_entry(btstack_packet_handler_t pac
     channel->remote_sig_id = L2CAP_SIG_ID_INVALID;
     channel->local_sig_id = L2CAP_SIG_ID_INVALID;
 
+#ifdef ENABLE_LE_DATA_CHANNELS
+    channel->statistics.start_ms = btstack_run_loop_get_time_ms();
+#endif
+
     log_info("create channel %p, local_cid 0x%04x", channel, channel->local_cid);
 
     return channel;
@@ -1973,6 +2461,10 @@ static void l2cap_free_channel_entry(l2cap_channel_t * channel){
 #ifdef ENABLE_L2CAP_ENHANCED_RETRANSMISSION_MODE
     l2cap_ertm_stop_retransmission_timer(channel);
     l2cap_ertm_stop_monitor_timer(channel);
+#endif
+#ifdef ENABLE_LE_DATA_CHANNELS
+    // return queued SDUs to their owners
+    l2cap_le_release_queued_sdus(channel);
 #endif
     // free  memory
     btstack_memory_l2cap_channel_free(channel);
@@ -2047,6 +2539,7 @@ static void l2cap_handle_connection_failed_for_addr(bd_addr_t address, uint8_t s
     while (btstack_linked_list_iterator_has_next(&it)){
         l2cap_channel_t * channel = (l2cap_channel_t *) btstack_linked_list_iterator_next(&it);
         if (!l2cap_is_dynamic_channel_type(channel->channel_type)) continue;
+        if (!l2cap_channel_on_selected_controller(channel)) continue;
         if (bd_addr_cmp( channel->address, address) != 0) continue;
         // channel for this address found
         switch (channel->state){
@@ -2086,6 +2579,7 @@ static void l2cap_handle_connection_success_for_addr(bd_addr_t address, hci_con_
     while (btstack_linked_list_iterator_has_next(&it)){
         l2cap_channel_t * channel = (l2cap_channel_t *) btstack_linked_list_iterator_next(&it);
         if (!l2cap_is_dynamic_channel_type(channel->channel_type)) continue;
+        if (!l2cap_channel_on_selected_controller(channel)) continue;
         if ( ! bd_addr_cmp( channel->address, address) ){
             l2cap_handle_connection_complete(handle, channel);
         }
@@ -2100,6 +2594,11 @@ static bool l2cap_channel_ready_to_send(l2cap_channel_t * channel){
 #ifdef ENABLE_CLASSIC
         case L2CAP_CHANNEL_TYPE_CLASSIC:
 #ifdef ENABLE_L2CAP_ENHANCED_RETRANSMISSION_MODE
+            // send if we have more data, frames are released after sending in Streaming Mode
+            if (channel->mode == L2CAP_CHANNEL_MODE_STREAMING_MODE) {
+                if (channel->num_stored_tx_frames == 0) return false;
+                return hci_can_send_acl_classic_packet_now() != 0;
+            }
             // send if we have more data and remote windows isn't full yet
             if (channel->mode == L2CAP_CHANNEL_MODE_ENHANCED_RETRANSMISSION) {
                 if (channel->unacked_frames >= btstack_min(channel->num_stored_tx_frames, channel->remote_tx_window_size)) return false;
@@ -2118,6 +2617,9 @@ static bool l2cap_channel_ready_to_send(l2cap_channel_t * channel){
             return hci_can_send_acl_le_packet_now() != 0;
 #ifdef ENABLE_LE_DATA_CHANNELS
         case L2CAP_CHANNEL_TYPE_LE_DATA_CHANNEL:
+#ifdef ENABLE_L2CAP_ENHANCED_CREDIT_BASED_FLOW_CONTROL_MODE
+        case L2CAP_CHANNEL_TYPE_LE_ECBM:
+#endif
             if (channel->send_sdu_buffer == NULL) return false;
             if (channel->credits_outgoing == 0u) return false;
             return hci_can_send_acl_le_packet_now() != 0;
@@ -2133,7 +2635,7 @@ static void l2cap_channel_trigger_send(l2cap_channel_t * channel){
 #ifdef ENABLE_CLASSIC
         case L2CAP_CHANNEL_TYPE_CLASSIC:
 #ifdef ENABLE_L2CAP_ENHANCED_RETRANSMISSION_MODE
-            if (channel->mode == L2CAP_CHANNEL_MODE_ENHANCED_RETRANSMISSION) {
+            if (l2cap_ertm_or_streaming_mode(channel)) {
                 l2cap_ertm_channel_send_information_frame(channel);
                 return;
             }
@@ -2153,6 +2655,9 @@ static void l2cap_channel_trigger_send(l2cap_channel_t * channel){
             break;
 #ifdef ENABLE_LE_DATA_CHANNELS
         case L2CAP_CHANNEL_TYPE_LE_DATA_CHANNEL:
+#ifdef ENABLE_L2CAP_ENHANCED_CREDIT_BASED_FLOW_CONTROL_MODE
+        case L2CAP_CHANNEL_TYPE_LE_ECBM:
+#endif
             l2cap_le_send_pdu(channel);
             break;
 #endif
@@ -2162,7 +2667,7 @@ static void l2cap_channel_trigger_send(l2cap_channel_t * channel){
     }
 }
 
-static void l2cap_notify_channel_can_send(void){
+static void l2cap_notify_channel_can_send_for_selected_controller(void){
     bool done = false;
     while (!done){
         done = true;
@@ -2170,6 +2675,7 @@ static void l2cap_notify_channel_can_send(void){
         btstack_linked_list_iterator_init(&it, &l2cap_channels);
         while (btstack_linked_list_iterator_has_next(&it)){
             l2cap_channel_t * channel = (l2cap_channel_t *) btstack_linked_list_iterator_next(&it);
+            if (!l2cap_channel_on_selected_controller(channel)) continue;
             bool ready = l2cap_channel_ready_to_send(channel);
             if (!ready) continue;
 
@@ -2187,6 +2693,14 @@ static void l2cap_notify_channel_can_send(void){
     }
 }
 
+static void l2cap_notify_channel_can_send(void){
+#ifdef ENABLE_HCI_MULTIPLE_CONTROLLERS
+    l2cap_for_each_controller(&l2cap_notify_channel_can_send_for_selected_controller);
+#else
+    l2cap_notify_channel_can_send_for_selected_controller();
+#endif
+}
+
 #ifdef L2CAP_USES_CHANNELS
 
 static int l2cap_send_open_failed_on_hci_disconnect(l2cap_channel_t * channel){
@@ -2206,6 +2720,8 @@ static int l2cap_send_open_failed_on_hci_disconnect(l2cap_channel_t * channel){
         case L2CAP_STATE_WILL_SEND_CONNECTION_REQUEST:
         case L2CAP_STATE_WILL_SEND_LE_CONNECTION_REQUEST:
         case L2CAP_STATE_WAIT_LE_CONNECTION_RESPONSE:
+        case L2CAP_STATE_WILL_SEND_ECBM_CONNECTION_REQUEST:
+        case L2CAP_STATE_WAIT_ECBM_CONNECTION_RESPONSE:
         case L2CAP_STATE_EMIT_OPEN_FAILED_AND_DISCARD:
             return 1;
 
@@ -2220,6 +2736,7 @@ static int l2cap_send_open_failed_on_hci_disconnect(l2cap_channel_t * channel){
         case L2CAP_STATE_WILL_SEND_DISCONNECT_RESPONSE:
         case L2CAP_STATE_WILL_SEND_LE_CONNECTION_RESPONSE_DECLINE:
         case L2CAP_STATE_WILL_SEND_LE_CONNECTION_RESPONSE_ACCEPT:
+        case L2CAP_STATE_WILL_SEND_ECBM_CONNECTION_RESPONSE:
         case L2CAP_STATE_INVALID:
         case L2CAP_STATE_WAIT_INCOMING_SECURITY_LEVEL_UPDATE:
             return 0;
@@ -2329,7 +2846,7 @@ static void l2cap_hci_event_handler(uint8_t packet_type, uint16_t cid, uint8_t *
             while (btstack_linked_list_iterator_has_next(&it)){
                 l2cap_channel_t * channel = (l2cap_channel_t *) btstack_linked_list_iterator_next(&it);
                 if (!l2cap_is_dynamic_channel_type(channel->channel_type)) continue;
-                if (channel->con_handle != handle) continue;
+                if (!l2cap_channel_uses_connection(channel, handle)) continue;
                 btstack_linked_list_iterator_remove(&it);
                 switch(channel->channel_type){
 #ifdef ENABLE_CLASSIC
@@ -2339,6 +2856,9 @@ static void l2cap_hci_event_handler(uint8_t packet_type, uint16_t cid, uint8_t *
 #endif
 #ifdef ENABLE_LE_DATA_CHANNELS
                     case L2CAP_CHANNEL_TYPE_LE_DATA_CHANNEL:
+#ifdef ENABLE_L2CAP_ENHANCED_CREDIT_BASED_FLOW_CONTROL_MODE
+                    case L2CAP_CHANNEL_TYPE_LE_ECBM:
+#endif
                         l2cap_handle_hci_le_disconnect_event(channel);
                         break;
 #endif
@@ -2361,7 +2881,7 @@ static void l2cap_hci_event_handler(uint8_t packet_type, uint16_t cid, uint8_t *
             while (btstack_linked_list_iterator_has_next(&it)){
                 l2cap_channel_t * channel = (l2cap_channel_t *) btstack_linked_list_iterator_next(&it);
                 if (!l2cap_is_dynamic_channel_type(channel->channel_type)) continue;
-                if (channel->con_handle != handle) continue;
+                if (!l2cap_channel_uses_connection(channel, handle)) continue;
                 hci_con_used = 1;
                 break;
             }
@@ -2380,7 +2900,7 @@ static void l2cap_hci_event_handler(uint8_t packet_type, uint16_t cid, uint8_t *
             while (btstack_linked_list_iterator_has_next(&it)){
                 l2cap_channel_t * channel = (l2cap_channel_t *) btstack_linked_list_iterator_next(&it);
                 if (!l2cap_is_dynamic_channel_type(channel->channel_type)) continue;
-                if (channel->con_handle != handle) continue;
+                if (!l2cap_channel_uses_connection(channel, handle)) continue;
                 log_info("remote supported features, channel %p, cid %04x - state %u", channel, channel->local_cid, channel->state);
                 l2cap_handle_remote_supported_features_received(channel);
             }
@@ -2393,7 +2913,7 @@ static void l2cap_hci_event_handler(uint8_t packet_type, uint16_t cid, uint8_t *
             while (btstack_linked_list_iterator_has_next(&it)){
                 l2cap_channel_t * channel = (l2cap_channel_t *) btstack_linked_list_iterator_next(&it);
                 if (!l2cap_is_dynamic_channel_type(channel->channel_type)) continue;
-                if (channel->con_handle != handle) continue;
+                if (!l2cap_channel_uses_connection(channel, handle)) continue;
 
                 gap_security_level_t actual_level = (gap_security_level_t) packet[4];
                 gap_security_level_t required_level = channel->required_security_level;
@@ -2447,6 +2967,9 @@ static void l2cap_register_signaling_response(hci_con_handle_t handle, uint8_t c
     // Vol 3, Part A, 4.3: "The DCID and SCID fields shall be ignored when the result field indi- cates the connection was refused."
     if (signaling_responses_pending < NR_PENDING_SIGNALING_RESPONSES) {
         signaling_responses[signaling_responses_pending].handle = handle;
+#ifdef ENABLE_HCI_MULTIPLE_CONTROLLERS
+        signaling_responses[signaling_responses_pending].controller_index = hci_get_selected_controller();
+#endif
         signaling_responses[signaling_responses_pending].code = code;
         signaling_responses[signaling_responses_pending].sig_id = sig_id;
         signaling_responses[signaling_responses_pending].cid = cid;
@@ -2546,6 +3069,7 @@ static void l2cap_signaling_handle_configure_request(l2cap_channel_t *channel, u
 
 #ifdef ENABLE_L2CAP_ENHANCED_RETRANSMISSION_MODE
     uint8_t use_fcs = 1;
+    uint16_t extended_window_size = 0;
 #endif
 
     channel->remote_sig_id = command[L2CAP_SIGNALING_COMMAND_SIGID_OFFSET];
@@ -2605,9 +3129,25 @@ static void l2cap_signaling_handle_configure_request(l2cap_channel_t *channel, u
                         channelStateVarSetFlag(channel, L2CAP_CHANNEL_STATE_VAR_SEND_CONF_RSP_ERTM);
                     }
                     break;
+                case L2CAP_CHANNEL_MODE_STREAMING_MODE:
+                    if (mode == L2CAP_CHANNEL_MODE_STREAMING_MODE){
+                        // only MPS is used in Streaming Mode
+                        channel->remote_mps = little_endian_read_16(command, pos + 7);
+                        log_info("Streaming Mode config: mps %u", channel->remote_mps);
+                        channelStateVarSetFlag(channel, L2CAP_CHANNEL_STATE_VAR_SEND_CONF_RSP_ERTM);
+                        break;
+                    }
+                    // remote asks for different mode. disconnect if mandatory or if this happens a second time
+                    if (channel->ertm_mandatory || (channel->state_var & L2CAP_CHANNEL_STATE_VAR_BASIC_FALLBACK_TRIED)){
+                        channel->state = L2CAP_STATE_WILL_SEND_DISCONNECT_REQUEST;
+                    }
+                    channelStateVarSetFlag(channel, L2CAP_CHANNEL_STATE_VAR_BASIC_FALLBACK_TRIED);
+                    channelStateVarSetFlag(channel, L2CAP_CHANNEL_STATE_VAR_SEND_CONF_RSP_REJECTED);
+                    break;
                 case L2CAP_CHANNEL_MODE_BASIC:
                     switch (mode){
                         case L2CAP_CHANNEL_MODE_ENHANCED_RETRANSMISSION:
+                        case L2CAP_CHANNEL_MODE_STREAMING_MODE:
                             // remote asks for ERTM, but we want basic mode. disconnect if this happens a second time
                             if (channel->state_var & L2CAP_CHANNEL_STATE_VAR_BASIC_FALLBACK_TRIED){
                                 channel->state = L2CAP_STATE_WILL_SEND_DISCONNECT_REQUEST;
@@ -2628,6 +3168,10 @@ static void l2cap_signaling_handle_configure_request(l2cap_channel_t *channel, u
         if (option_type == L2CAP_CONFIG_OPTION_TYPE_FRAME_CHECK_SEQUENCE && length == 1){
             use_fcs = command[pos];
         }        
+        // Extended Window Size { type(8): 7, len(8): 2, Max Window Size(16) }
+        if (option_type == L2CAP_CONFIG_OPTION_TYPE_EXTENDED_WINDOW_SIZE && length == 2){
+            extended_window_size = little_endian_read_16(command, pos) & 0x3fff;
+        }
 #endif        
         // check for unknown options
         if ((option_hint == 0) && ((option_type < L2CAP_CONFIG_OPTION_TYPE_MAX_TRANSMISSION_UNIT) || (option_type > L2CAP_CONFIG_OPTION_TYPE_EXTENDED_WINDOW_SIZE))){
@@ -2642,6 +3186,14 @@ static void l2cap_signaling_handle_configure_request(l2cap_channel_t *channel, u
         uint8_t update = channel->fcs_option || use_fcs;
         log_info("local fcs: %u, remote fcs: %u -> %u", channel->fcs_option, use_fcs, update);
         channel->fcs_option = update;
+        // Extended Window Size option replaces TxWindow and selects Extended Control Field
+        if (extended_window_size && l2cap_ertm_or_streaming_mode(channel)){
+            log_info("Extended Window Size %u", extended_window_size);
+            channel->extended_control = 1;
+            if (channel->mode == L2CAP_CHANNEL_MODE_ENHANCED_RETRANSMISSION){
+                channel->remote_tx_window_size = extended_window_size;
+            }
+        }
         // If ERTM mandatory, but remote didn't send Retransmission and Flowcontrol options -> disconnect
         if (((channel->state_var & L2CAP_CHANNEL_STATE_VAR_SEND_CONF_RSP_ERTM) == 0) & (channel->ertm_mandatory)){
             channel->state = L2CAP_STATE_WILL_SEND_DISCONNECT_REQUEST;
@@ -2666,6 +3218,7 @@ static void l2cap_signaling_handle_configure_response(l2cap_channel_t *channel,
         if (option_type == L2CAP_CONFIG_OPTION_TYPE_RETRANSMISSION_AND_FLOW_CONTROL && length == 9){
             switch (channel->mode){
                 case L2CAP_CHANNEL_MODE_ENHANCED_RETRANSMISSION:
+                case L2CAP_CHANNEL_MODE_STREAMING_MODE:
                     if (channel->ertm_mandatory){
                         // ??
                     } else {
@@ -2820,7 +3373,7 @@ static void l2cap_signaling_handler_channel(l2cap_channel_t *channel, uint8_t *c
                             break;
                         default:
 #ifdef ENABLE_L2CAP_ENHANCED_RETRANSMISSION_MODE
-                            if (channel->mode == L2CAP_CHANNEL_MODE_ENHANCED_RETRANSMISSION && channel->ertm_mandatory){
+                            if (l2cap_ertm_or_streaming_mode(channel) && channel->ertm_mandatory){
                                 // remote does not offer ertm but it's required
                                 channel->state = L2CAP_STATE_WILL_SEND_DISCONNECT_REQUEST;
                                 break;
@@ -2838,7 +3391,7 @@ static void l2cap_signaling_handler_channel(l2cap_channel_t *channel, uint8_t *c
 
 #ifdef ENABLE_L2CAP_ENHANCED_RETRANSMISSION_MODE
                 // assert that packet can be stored in fragment buffers in ertm
-                if (channel->mode == L2CAP_CHANNEL_MODE_ENHANCED_RETRANSMISSION){
+                if (l2cap_ertm_or_streaming_mode(channel)){
                     uint16_t effective_mps = btstack_min(channel->remote_mps, channel->local_mps);
                     uint16_t usable_mtu = channel->num_tx_buffers == 1 ? effective_mps : channel->num_tx_buffers * effective_mps - 2;
                     if (usable_mtu < channel->remote_mtu){
@@ -2943,7 +3496,7 @@ static void l2cap_signaling_handler_dispatch(hci_con_handle_t handle, uint8_t *
             while (btstack_linked_list_iterator_has_next(&it)){
                 l2cap_channel_t * channel = (l2cap_channel_t *) btstack_linked_list_iterator_next(&it);
                 if (!l2cap_is_dynamic_channel_type(channel->channel_type)) continue;
-                if (channel->con_handle != handle) continue;
+                if (!l2cap_channel_uses_connection(channel, handle)) continue;
 
                 // incoming connection: ask user for channel configuration, esp. if ertm will be mandatory
                 if (channel->state == L2CAP_STATE_WAIT_INCOMING_EXTENDED_FEATURES){
@@ -2956,7 +3509,7 @@ static void l2cap_signaling_handler_dispatch(hci_con_handle_t handle, uint8_t *
                 if (channel->state == L2CAP_STATE_WAIT_OUTGOING_EXTENDED_FEATURES){
 
                     // if ERTM was requested, but is not listed in extended feature mask:
-                    if ((channel->mode == L2CAP_CHANNEL_MODE_ENHANCED_RETRANSMISSION) && ((connection->l2cap_state.extended_feature_mask & 0x08) == 0)){
+                    if (l2cap_ertm_or_streaming_mode(channel) && ((connection->l2cap_state.extended_feature_mask & l2cap_ertm_feature_for_mode(channel->mode)) == 0)){
 
                         if (channel->ertm_mandatory){
                             // bail if ERTM is mandatory
@@ -2996,7 +3549,7 @@ static void l2cap_signaling_handler_dispatch(hci_con_handle_t handle, uint8_t *
     while (btstack_linked_list_iterator_has_next(&it)){
         l2cap_channel_t * channel = (l2cap_channel_t *) btstack_linked_list_iterator_next(&it);
         if (!l2cap_is_dynamic_channel_type(channel->channel_type)) continue;
-        if (channel->con_handle != handle) continue;
+        if (!l2cap_channel_uses_connection(channel, handle)) continue;
         if (code & 1) {
             // match odd commands (responses) by previous signaling identifier 
             if (channel->local_sig_id == sig_id) {
@@ -3042,6 +3595,7 @@ static int l2cap_le_signaling_handler_dispatch(hci_con_handle_t handle, uint8_t
     uint16_t credits_before;
     l2cap_service_t * service;
     uint16_t source_cid;
+    uint16_t remote_cid;
 #endif
 
     uint8_t code   = command[L2CAP_SIGNALING_COMMAND_CODE_OFFSET];
@@ -3106,13 +3660,20 @@ static int l2cap_le_signaling_handler_dispatch(hci_con_handle_t handle, uint8_t
             while (btstack_linked_list_iterator_has_next(&it)){
                 l2cap_channel_t * a_channel = (l2cap_channel_t *) btstack_linked_list_iterator_next(&it);
                 if (!l2cap_is_dynamic_channel_type(a_channel->channel_type)) continue;
-                if (a_channel->con_handle   != handle) continue;
+                if (!l2cap_channel_uses_connection(a_channel, handle)) continue;
                 if (a_channel->local_sig_id != sig_id) continue;
                 channel = a_channel;
                 break; 
             }
             if (!channel) break;
 
+#ifdef ENABLE_L2CAP_ENHANCED_CREDIT_BASED_FLOW_CONTROL_MODE
+            if (channel->channel_type == L2CAP_CHANNEL_TYPE_LE_ECBM){
+                l2cap_ecbm_handle_command_reject(channel);
+                break;
+            }
+#endif
+
             // if received while waiting for le connection response, assume legacy device
             if (channel->state == L2CAP_STATE_WAIT_LE_CONNECTION_RESPONSE){
                 channel->state = L2CAP_STATE_CLOSED;
@@ -3151,7 +3712,7 @@ static int l2cap_le_signaling_handler_dispatch(hci_con_handle_t handle, uint8_t
                 while (btstack_linked_list_iterator_has_next(&it)){
                     l2cap_channel_t * a_channel = (l2cap_channel_t *) btstack_linked_list_iterator_next(&it);
                     if (!l2cap_is_dynamic_channel_type(a_channel->channel_type)) continue;
-                    if (a_channel->con_handle != handle) continue;
+                    if (!l2cap_channel_uses_connection(a_channel, handle)) continue;
                     if (a_channel->remote_cid != source_cid) continue;
                     // 0x000a Connection refused - Source CID already allocated
                     l2cap_register_signaling_response(handle, LE_CREDIT_BASED_CONNECTION_REQUEST, sig_id, source_cid, 0x000a);
@@ -3209,7 +3770,7 @@ static int l2cap_le_signaling_handler_dispatch(hci_con_handle_t handle, uint8_t
 
                 // set initial state
                 channel->state      = L2CAP_STATE_WAIT_CLIENT_ACCEPT_OR_REJECT;
-                channel->state_var |= L2CAP_CHANNEL_STATE_VAR_INCOMING;
+                channel->state_var  = (L2CAP_CHANNEL_STATE_VAR) (channel->state_var | L2CAP_CHANNEL_STATE_VAR_INCOMING);
 
                 // add to connections list
                 btstack_linked_list_add_tail(&l2cap_channels, (btstack_linked_item_t *) channel);
@@ -3233,7 +3794,7 @@ static int l2cap_le_signaling_handler_dispatch(hci_con_handle_t handle, uint8_t
             while (btstack_linked_list_iterator_has_next(&it)){
                 l2cap_channel_t * a_channel = (l2cap_channel_t *) btstack_linked_list_iterator_next(&it);
                 if (!l2cap_is_dynamic_channel_type(a_channel->channel_type)) continue;
-                if (a_channel->con_handle   != handle) continue;
+                if (!l2cap_channel_uses_connection(a_channel, handle)) continue;
                 if (a_channel->local_sig_id != sig_id) continue;
                 channel = a_channel;
                 break; 
@@ -3266,13 +3827,14 @@ static int l2cap_le_signaling_handler_dispatch(hci_con_handle_t handle, uint8_t
             // check size
             if (len < 4u) return 0u;
 
-            // find channel
-            local_cid = little_endian_read_16(command, L2CAP_SIGNALING_COMMAND_DATA_OFFSET + 0);
-            channel = l2cap_get_channel_for_local_cid(local_cid);
+            // find channel, CID is the Source CID of the sender
+            remote_cid = little_endian_read_16(command, L2CAP_SIGNALING_COMMAND_DATA_OFFSET + 0);
+            channel = l2cap_get_channel_for_remote_handle_and_cid(handle, remote_cid);
             if (!channel) {
-                log_error("l2cap: no channel for cid 0x%02x", local_cid);
+                log_error("l2cap: no channel for remote cid 0x%02x", remote_cid);
                 break;
             }
+            local_cid = channel->local_cid;
             new_credits = little_endian_read_16(command, L2CAP_SIGNALING_COMMAND_DATA_OFFSET + 2);
             credits_before = channel->credits_outgoing;
             channel->credits_outgoing += new_credits;
@@ -3283,6 +3845,8 @@ static int l2cap_le_signaling_handler_dispatch(hci_con_handle_t handle, uint8_t
                 break;
             }            
             log_info("l2cap: %u credits for 0x%02x, now %u", new_credits, local_cid, channel->credits_outgoing);
+            // continue pending SDU
+            l2cap_notify_channel_can_send();
             break;
 
         case DISCONNECTION_REQUEST:
@@ -3303,7 +3867,26 @@ static int l2cap_le_signaling_handler_dispatch(hci_con_handle_t handle, uint8_t
 
 #endif
 
+#ifdef ENABLE_L2CAP_ENHANCED_CREDIT_BASED_FLOW_CONTROL_MODE
+        case CREDIT_BASED_CONNECTION_REQUEST:
+        case CREDIT_BASED_CONNECTION_RESPONSE:
+        case CREDIT_BASED_RECONFIGURE_REQUEST:
+        case CREDIT_BASED_RECONFIGURE_RESPONSE:
+            return l2cap_ecbm_signaling_handler_dispatch(handle, command, sig_id);
+#endif
+
         case DISCONNECTION_RESPONSE:
+#ifdef ENABLE_LE_DATA_CHANNELS
+            // check size
+            if (len < 4u) return 0u;
+
+            // find channel
+            local_cid = little_endian_read_16(command, L2CAP_SIGNALING_COMMAND_DATA_OFFSET + 2);
+            channel = l2cap_get_channel_for_local_cid(local_cid);
+            if (!channel) break;
+            if (channel->state != L2CAP_STATE_WAIT_DISCONNECT) break;
+            l2cap_le_finialize_channel_close(channel);
+#endif
             break;
 
         default:
@@ -3317,12 +3900,13 @@ static int l2cap_le_signaling_handler_dispatch(hci_con_handle_t handle, uint8_t
 #ifdef ENABLE_CLASSIC
 static void l2cap_acl_classic_handler_for_channel(l2cap_channel_t * l2cap_channel, uint8_t * packet, uint16_t size){
 #ifdef ENABLE_L2CAP_ENHANCED_RETRANSMISSION_MODE
-    if (l2cap_channel->mode == L2CAP_CHANNEL_MODE_ENHANCED_RETRANSMISSION){
+    if (l2cap_ertm_or_streaming_mode(l2cap_channel)){
 
         int fcs_size = l2cap_channel->fcs_option ? 2 : 0;
+        int control_size = l2cap_ertm_control_size(l2cap_channel);
 
         // assert control + FCS fields are inside
-        if (size < COMPLETE_L2CAP_HEADER+2+fcs_size) return;
+        if (size < COMPLETE_L2CAP_HEADER+control_size+fcs_size) return;
 
         if (l2cap_channel->fcs_option){
             // verify FCS (required if one side requested it)
@@ -3349,14 +3933,31 @@ static void l2cap_acl_classic_handler_for_channel(l2cap_channel_t * l2cap_channe
         }
 
         // switch on packet type
-        uint16_t control = little_endian_read_16(packet, COMPLETE_L2CAP_HEADER);
-        uint8_t  req_seq = (control >> 8) & 0x3f;
-        int final = (control >> 7) & 0x01;
+        uint32_t control;
+        uint16_t req_seq;
+        int final;
+        if (l2cap_channel->extended_control){
+            control = little_endian_read_32(packet, COMPLETE_L2CAP_HEADER);
+            req_seq = (control >> 2) & 0x3fff;
+            final   = (control >> 1) & 0x01;
+        } else {
+            control = little_endian_read_16(packet, COMPLETE_L2CAP_HEADER);
+            req_seq = (control >> 8) & 0x3f;
+            final   = (control >> 7) & 0x01;
+        }
         if (control & 1){
-            // S-Frame
-            int poll  = (control >> 4) & 0x01;
-            l2cap_supervisory_function_t s = (l2cap_supervisory_function_t) ((control >> 2) & 0x03);
-            log_info("Control: 0x%04x => Supervisory function %u, ReqSeq %02u", control, (int) s, req_seq);
+            // S-Frame, not used in Streaming Mode
+            if (l2cap_channel->mode == L2CAP_CHANNEL_MODE_STREAMING_MODE) return;
+            int poll;
+            l2cap_supervisory_function_t s;
+            if (l2cap_channel->extended_control){
+                poll = (control >> 18) & 0x01;
+                s    = (l2cap_supervisory_function_t) ((control >> 16) & 0x03);
+            } else {
+                poll = (control >> 4) & 0x01;
+                s    = (l2cap_supervisory_function_t) ((control >> 2) & 0x03);
+            }
+            log_info("Control: 0x%04x => Supervisory function %u, ReqSeq %02u", (unsigned int) control, (int) s, req_seq);
             l2cap_ertm_tx_packet_state_t * tx_state;
             switch (s){
                 case L2CAP_SUPERVISORY_FUNCTION_RR_RECEIVER_READY:
@@ -3427,20 +4028,29 @@ static void l2cap_acl_classic_handler_for_channel(l2cap_channel_t * l2cap_channe
         } else {
             // I-Frame
             // get control
-            l2cap_segmentation_and_reassembly_t sar = (l2cap_segmentation_and_reassembly_t) (control >> 14);
-            uint8_t tx_seq = (control >> 1) & 0x3f;
-            log_info("Control: 0x%04x => SAR %u, ReqSeq %02u, R?, TxSeq %02u", control, (int) sar, req_seq, tx_seq);
+            l2cap_segmentation_and_reassembly_t sar;
+            uint16_t tx_seq;
+            if (l2cap_channel->extended_control){
+                sar    = (l2cap_segmentation_and_reassembly_t) ((control >> 16) & 0x03);
+                tx_seq = (control >> 18) & 0x3fff;
+            } else {
+                sar    = (l2cap_segmentation_and_reassembly_t) ((control >> 14) & 0x03);
+                tx_seq = (control >> 1) & 0x3f;
+            }
+            log_info("Control: 0x%04x => SAR %u, ReqSeq %02u, R?, TxSeq %02u", (unsigned int) control, (int) sar, req_seq, tx_seq);
             log_info("SAR: pos %u", l2cap_channel->reassembly_pos);
             log_info("State: expected_tx_seq %02u, req_seq %02u", l2cap_channel->expected_tx_seq, l2cap_channel->req_seq);
-            l2cap_ertm_process_req_seq(l2cap_channel, req_seq);
-            if (final){
-                // final bit set <- response to RR with poll bit set. All not acknowledged packets need to be retransmitted
-                l2cap_ertm_retransmit_unacknowleded_frames(l2cap_channel);
+            if (l2cap_channel->mode == L2CAP_CHANNEL_MODE_ENHANCED_RETRANSMISSION){
+                l2cap_ertm_process_req_seq(l2cap_channel, req_seq);
+                if (final){
+                    // final bit set <- response to RR with poll bit set. All not acknowledged packets need to be retransmitted
+                    l2cap_ertm_retransmit_unacknowleded_frames(l2cap_channel);
+                }
             }
 
             // get SDU
-            const uint8_t * payload_data = &packet[COMPLETE_L2CAP_HEADER+2];
-            uint16_t        payload_len  = size-(COMPLETE_L2CAP_HEADER+2+fcs_size);
+            const uint8_t * payload_data = &packet[COMPLETE_L2CAP_HEADER+control_size];
+            uint16_t        payload_len  = size-(COMPLETE_L2CAP_HEADER+control_size+fcs_size);
 
             // assert SDU size is smaller or equal to our buffers
             uint16_t max_payload_size = 0;
@@ -3460,50 +4070,60 @@ static void l2cap_acl_classic_handler_for_channel(l2cap_channel_t * l2cap_channe
                 return;
             }
 
+            // Streaming Mode: missing frames are not retransmitted, drop partially reassembled SDU
+            if (l2cap_channel->mode == L2CAP_CHANNEL_MODE_STREAMING_MODE){
+                if (l2cap_channel->expected_tx_seq != tx_seq){
+                    log_info("Received unexpected frame TxSeq %u but expected %u -> drop SDU", tx_seq, l2cap_channel->expected_tx_seq);
+                    l2cap_channel->reassembly_pos = 0;
+                    l2cap_channel->reassembly_sdu_length = 0;
+                }
+                l2cap_channel->expected_tx_seq = l2cap_next_ertm_seq_nr(l2cap_channel, tx_seq);
+                l2cap_ertm_handle_in_sequence_sdu(l2cap_channel, sar, payload_data, payload_len);
+                return;
+            }
+
             // check ordering
             if (l2cap_channel->expected_tx_seq == tx_seq){
                 log_info("Received expected frame with TxSeq == ExpectedTxSeq == %02u", tx_seq);
-                l2cap_channel->expected_tx_seq = l2cap_next_ertm_seq_nr(l2cap_channel->expected_tx_seq);
-                l2cap_channel->req_seq         = l2cap_channel->expected_tx_seq;
+                l2cap_ertm_next_expected_tx_seq(l2cap_channel);
 
                 // process SDU
                 l2cap_ertm_handle_in_sequence_sdu(l2cap_channel, sar, payload_data, payload_len);
 
                 // process stored segments
                 while (true){
-                    int index = l2cap_channel->rx_store_index;
+                    int index = l2cap_ertm_rx_index(l2cap_channel, 0);
                     l2cap_ertm_rx_packet_state_t * rx_state = &l2cap_channel->rx_packets_state[index];
                     if (!rx_state->valid) break;
 
                     log_info("Processing stored frame with TxSeq == ExpectedTxSeq == %02u", l2cap_channel->expected_tx_seq);
-                    l2cap_channel->expected_tx_seq = l2cap_next_ertm_seq_nr(l2cap_channel->expected_tx_seq);
-                    l2cap_channel->req_seq         = l2cap_channel->expected_tx_seq;
+                    l2cap_ertm_next_expected_tx_seq(l2cap_channel);
 
                     rx_state->valid = 0;
-                    l2cap_ertm_handle_in_sequence_sdu(l2cap_channel, rx_state->sar, &l2cap_channel->rx_packets_data[index], rx_state->len);
-
-                    // update rx store index
-                    index++;
-                    if (index >= l2cap_channel->num_rx_buffers){
-                        index = 0;
-                    }
-                    l2cap_channel->rx_store_index = index;
+                    l2cap_ertm_handle_in_sequence_sdu(l2cap_channel, rx_state->sar, &l2cap_channel->rx_packets_data[index * l2cap_channel->local_mps], rx_state->len);
                 }
 
                 //
                 l2cap_channel->send_supervisor_frame_receiver_ready = 1;
 
             } else {
-                int delta = (tx_seq - l2cap_channel->expected_tx_seq) & 0x3f;
-                if (delta < 2){
+                uint16_t seq_mask  = l2cap_ertm_seq_mask(l2cap_channel);
+                uint16_t rx_window = l2cap_ertm_rx_window(l2cap_channel);
+                int delta = (tx_seq - l2cap_channel->expected_tx_seq) & seq_mask;
+                if (delta < rx_window){
                     // store segment
                     l2cap_ertm_handle_out_of_sequence_sdu(l2cap_channel, sar, delta, payload_data, payload_len);
 
-                    log_info("Received unexpected frame TxSeq %u but expected %u -> send S-SREJ", tx_seq, l2cap_channel->expected_tx_seq);
-                    l2cap_channel->send_supervisor_frame_selective_reject = 1;
+                    // request all missing frames up to this one
+                    log_info("Received unexpected frame TxSeq %u but expected %u -> add to SREJ list", tx_seq, l2cap_channel->expected_tx_seq);
+                    l2cap_ertm_srej_list_add(l2cap_channel, tx_seq);
+                } else if (((l2cap_channel->expected_tx_seq - tx_seq) & seq_mask) <= rx_window){
+                    log_info("Received duplicate frame TxSeq %u, expected %u -> drop", tx_seq, l2cap_channel->expected_tx_seq);
                 } else {
                     log_info("Received unexpected frame TxSeq %u but expected %u -> send S-REJ", tx_seq, l2cap_channel->expected_tx_seq);
                     l2cap_channel->send_supervisor_frame_reject = 1;
+                    // all frames starting with expected tx_seq will be retransmitted
+                    l2cap_ertm_srej_list_clear(l2cap_channel);
                 }
             }
         }
@@ -3541,16 +4161,22 @@ static void l2cap_acl_classic_handler(hci_con_handle_t handle, uint8_t *packet,
             break;
         }
         case L2CAP_CID_CONNECTIONLESS_CHANNEL:
+            if (!l2cap_fixed_channels_on_selected_controller()){
+                log_info("connectionless data on secondary Controller dropped");
+                break;
+            }
             l2cap_fixed_channel = l2cap_fixed_channel_for_channel_id(L2CAP_CID_CONNECTIONLESS_CHANNEL);
             if (!l2cap_fixed_channel) break;
             if (!l2cap_fixed_channel->packet_handler) break;
+            BTSTACK_STATS_TRACE_BEGIN(L2CAP_FIXED_CHANNEL, L2CAP_CID_CONNECTIONLESS_CHANNEL);
             (*l2cap_fixed_channel->packet_handler)(UCD_DATA_PACKET, handle, &packet[COMPLETE_L2CAP_HEADER], size-COMPLETE_L2CAP_HEADER);
+            BTSTACK_STATS_TRACE_END(L2CAP_FIXED_CHANNEL, L2CAP_CID_CONNECTIONLESS_CHANNEL);
             break;
 
         default: 
             // Find channel for this channel_id and connection handle
             l2cap_channel = l2cap_get_channel_for_local_cid(channel_id);
-            if (l2cap_channel) {
+            if (l2cap_channel && l2cap_channel_uses_connection(l2cap_channel, handle)) {
                 l2cap_acl_classic_handler_for_channel(l2cap_channel, packet, size);
             }
             break;
@@ -3585,24 +4211,40 @@ static void l2cap_acl_le_handler(hci_con_handle_t handle, uint8_t *packet, uint1
         }
 
         case L2CAP_CID_ATTRIBUTE_PROTOCOL:
+            if (!l2cap_fixed_channels_on_selected_controller()){
+#ifdef ENABLE_HCI_MULTIPLE_CONTROLLERS
+                l2cap_register_fixed_channel_reject(handle, L2CAP_CID_ATTRIBUTE_PROTOCOL, &packet[COMPLETE_L2CAP_HEADER], size-COMPLETE_L2CAP_HEADER);
+#endif
+                break;
+            }
             l2cap_fixed_channel = l2cap_fixed_channel_for_channel_id(L2CAP_CID_ATTRIBUTE_PROTOCOL);
             if (!l2cap_fixed_channel) break;
             if (!l2cap_fixed_channel->packet_handler) break;
+            BTSTACK_STATS_TRACE_BEGIN(L2CAP_FIXED_CHANNEL, L2CAP_CID_ATTRIBUTE_PROTOCOL);
             (*l2cap_fixed_channel->packet_handler)(ATT_DATA_PACKET, handle, &packet[COMPLETE_L2CAP_HEADER], size-COMPLETE_L2CAP_HEADER);
+            BTSTACK_STATS_TRACE_END(L2CAP_FIXED_CHANNEL, L2CAP_CID_ATTRIBUTE_PROTOCOL);
             break;
 
         case L2CAP_CID_SECURITY_MANAGER_PROTOCOL:
+            if (!l2cap_fixed_channels_on_selected_controller()){
+#ifdef ENABLE_HCI_MULTIPLE_CONTROLLERS
+                l2cap_register_fixed_channel_reject(handle, L2CAP_CID_SECURITY_MANAGER_PROTOCOL, &packet[COMPLETE_L2CAP_HEADER], size-COMPLETE_L2CAP_HEADER);
+#endif
+                break;
+            }
             l2cap_fixed_channel = l2cap_fixed_channel_for_channel_id(L2CAP_CID_SECURITY_MANAGER_PROTOCOL);
             if (!l2cap_fixed_channel) break;
             if (!l2cap_fixed_channel->packet_handler) break;
+            BTSTACK_STATS_TRACE_BEGIN(L2CAP_FIXED_CHANNEL, L2CAP_CID_SECURITY_MANAGER_PROTOCOL);
             (*l2cap_fixed_channel->packet_handler)(SM_DATA_PACKET, handle, &packet[COMPLETE_L2CAP_HEADER], size-COMPLETE_L2CAP_HEADER);
+            BTSTACK_STATS_TRACE_END(L2CAP_FIXED_CHANNEL, L2CAP_CID_SECURITY_MANAGER_PROTOCOL);
             break;
 
         default:
 
 #ifdef ENABLE_LE_DATA_CHANNELS
             l2cap_channel = l2cap_get_channel_for_local_cid(channel_id);
-            if (l2cap_channel) {
+            if (l2cap_channel && l2cap_channel_uses_connection(l2cap_channel, handle)) {
                 // credit counting
                 if (l2cap_channel->credits_incoming == 0u){
                     log_error("LE Data Channel packet received but no incoming credits");
@@ -3610,6 +4252,7 @@ static void l2cap_acl_le_handler(hci_con_handle_t handle, uint8_t *packet, uint1
                     break;
                 }
                 l2cap_channel->credits_incoming--;
+                l2cap_channel->statistics.rx_pdus++;
 
                 // automatic credits
                 if ((l2cap_channel->credits_incoming < L2CAP_LE_DATA_CHANNELS_AUTOMATIC_CREDITS_WATERMARK) && l2cap_channel->automatic_credits){
@@ -3636,6 +4279,8 @@ static void l2cap_acl_le_handler(hci_con_handle_t handle, uint8_t *packet, uint1
                 // done?
                 log_debug("le packet pos %u, len %u", l2cap_channel->receive_sdu_pos, l2cap_channel->receive_sdu_len);
                 if (l2cap_channel->receive_sdu_pos >= l2cap_channel->receive_sdu_len){
+                    l2cap_channel->statistics.rx_sdus++;
+                    l2cap_channel->statistics.rx_bytes += l2cap_channel->receive_sdu_len;
                     l2cap_dispatch_to_channel(l2cap_channel, L2CAP_DATA_PACKET, l2cap_channel->receive_sdu_buffer, l2cap_channel->receive_sdu_len);
                     l2cap_channel->receive_sdu_len = 0;
                 }
@@ -3663,11 +4308,13 @@ static void l2cap_acl_handler(uint8_t packet_type, uint16_t channel, uint8_t *pa
     hci_con_handle_t handle = READ_ACL_CONNECTION_HANDLE(packet);
     hci_connection_t *conn = hci_connection_for_handle(handle);
     if (!conn) return;
+    BTSTACK_STATS_TRACE_BEGIN(L2CAP, handle);
     if (conn->address_type == BD_ADDR_TYPE_ACL){
         l2cap_acl_classic_handler(handle, packet, size);
     } else {
         l2cap_acl_le_handler(handle, packet, size);
     }
+    BTSTACK_STATS_TRACE_END(L2CAP, handle);
 
     l2cap_run();
 }
@@ -3794,6 +4441,11 @@ static void l2cap_emit_le_channel_opened(l2cap_channel_t *channel, uint8_t statu
              channel->local_cid, channel->remote_cid, channel->local_mtu, channel->remote_mtu);
     uint8_t event[23];
     event[0] = L2CAP_EVENT_LE_CHANNEL_OPENED;
+#ifdef ENABLE_L2CAP_ENHANCED_CREDIT_BASED_FLOW_CONTROL_MODE
+    if (channel->channel_type == L2CAP_CHANNEL_TYPE_LE_ECBM){
+        event[0] = L2CAP_EVENT_ECBM_CHANNEL_OPENED;
+    }
+#endif
     event[1] = sizeof(event) - 2u;
     event[2] = status;
     event[3] = channel->address_type;
@@ -3836,7 +4488,7 @@ static void l2cap_le_send_pdu(l2cap_channel_t *channel){
         pos += 2u;
     }
     uint16_t payload_size = btstack_min(channel->send_sdu_len + 2u - channel->send_sdu_pos, channel->remote_mps - pos);
-    log_info("len %u, pos %u => payload %u, credits %u", channel->send_sdu_len, channel->send_sdu_pos, payload_size, channel->credits_outgoing);
+    log_debug("len %u, pos %u => payload %u, credits %u", channel->send_sdu_len, channel->send_sdu_pos, payload_size, channel->credits_outgoing);
     (void)memcpy(&l2cap_payload[pos],
                  &channel->send_sdu_buffer[channel->send_sdu_pos - 2u],
                  payload_size); // -2 for virtual SDU len
@@ -3845,22 +4497,75 @@ static void l2cap_le_send_pdu(l2cap_channel_t *channel){
     l2cap_setup_header(acl_buffer, channel->con_handle, 0, channel->remote_cid, pos);
 
     channel->credits_outgoing--;
+    channel->statistics.tx_pdus++;
+    BTSTACK_STATS_TRAFFIC_OUT(&channel->stats, pos);
+
+    bool sdu_complete = channel->send_sdu_pos >= (channel->send_sdu_len + 2u);
+    // SDU in progress from queue is still the head of the queue
+    btstack_linked_item_t * next_queued_sdu = channel->send_sdu_queue;
+    if (channel->send_sdu_from_queue && (next_queued_sdu != NULL)){
+        next_queued_sdu = next_queued_sdu->next;
+    }
+    if ((channel->credits_outgoing == 0u) && (!sdu_complete || (next_queued_sdu != NULL))){
+        channel->statistics.tx_credit_stalls++;
+    }
+
+    // update SDU state before sending, as synchronous transports report packet sent during hci_send_acl_packet_buffer
+    l2cap_le_sdu_t * sent_sdu = NULL;
+    if (sdu_complete){
+        channel->statistics.tx_sdus++;
+        channel->statistics.tx_bytes += channel->send_sdu_len;
+        channel->send_sdu_buffer = NULL;
+
+        if (channel->send_sdu_from_queue){
+            sent_sdu = (l2cap_le_sdu_t *) btstack_linked_list_pop(&channel->send_sdu_queue);
+        }
+    }
 
     hci_send_acl_packet_buffer(8u + pos);
 
-    if (channel->send_sdu_pos >= (channel->send_sdu_len + 2u)){
-        channel->send_sdu_buffer = NULL;
-        // send done event
-        l2cap_emit_simple_event_with_cid(channel, L2CAP_EVENT_LE_PACKET_SENT);
+    if (sdu_complete){
+        // continue with next queued SDU, K-frames are sent back-to-back by l2cap_notify_channel_can_send
+        l2cap_le_start_next_queued_sdu(channel);
+
+        if (sent_sdu != NULL){
+            // release caller-owned SDU
+            if (sent_sdu->release != NULL){
+                (*sent_sdu->release)(sent_sdu, ERROR_CODE_SUCCESS);
+            }
+        } else {
+            // send done event
+            l2cap_emit_simple_event_with_cid(channel, L2CAP_EVENT_LE_PACKET_SENT);
+        }
         // inform about can send now
         l2cap_le_notify_channel_can_send(channel);
     }
 }
 
+static void l2cap_le_start_next_queued_sdu(l2cap_channel_t * channel){
+    channel->send_sdu_from_queue = 0;
+    l2cap_le_sdu_t * sdu = (l2cap_le_sdu_t *) channel->send_sdu_queue;
+    if (sdu == NULL) return;
+    channel->send_sdu_buffer     = sdu->data;
+    channel->send_sdu_len        = sdu->len;
+    channel->send_sdu_pos        = 0;
+    channel->send_sdu_from_queue = 1;
+}
+
+static void l2cap_le_release_queued_sdus(l2cap_channel_t * channel){
+    while (true){
+        l2cap_le_sdu_t * sdu = (l2cap_le_sdu_t *) btstack_linked_list_pop(&channel->send_sdu_queue);
+        if (sdu == NULL) break;
+        if (sdu->release != NULL){
+            (*sdu->release)(sdu, L2CAP_LOCAL_CID_DOES_NOT_EXIST);
+        }
+    }
+}
+
 // finalize closed channel - l2cap_handle_disconnect_request & DISCONNECTION_RESPONSE
 void l2cap_le_finialize_channel_close(l2cap_channel_t * channel){
     channel->state = L2CAP_STATE_CLOSED;
-    l2cap_emit_simple_event_with_cid(channel, L2CAP_EVENT_CHANNEL_CLOSED);
+    l2cap_emit_le_channel_closed(channel);
     // discard channel
     btstack_linked_list_remove(&l2cap_channels, (btstack_linked_item_t *) channel);
     l2cap_free_channel_entry(channel);
@@ -4046,7 +4751,7 @@ int l2cap_le_can_send_now(uint16_t local_cid){
     if (channel->state != L2CAP_STATE_OPEN) return 0;
 
     // check queue
-    if (channel->send_sdu_buffer) return 0;    
+    if (channel->send_sdu_buffer) return 0;
 
     // fine, go ahead
     return 1;
@@ -4102,6 +4807,66 @@ uint8_t l2cap_le_send_data(uint16_t local_cid, uint8_t * data, uint16_t len){
     return ERROR_CODE_SUCCESS;
 }
 
+/**
+ * @brief Queue SDU for transmission via LE Data Channel
+ * @param local_cid             L2CAP LE Data Channel Identifier
+ * @param sdu                   SDU with data, len, and release callback
+ */
+uint8_t l2cap_le_queue_sdu(uint16_t local_cid, l2cap_le_sdu_t * sdu){
+
+    l2cap_channel_t * channel = l2cap_get_channel_for_local_cid(local_cid);
+    if (!channel) {
+        log_error("l2cap_le_queue_sdu no channel for cid 0x%02x", local_cid);
+        return L2CAP_LOCAL_CID_DOES_NOT_EXIST;
+    }
+
+    if (channel->state != L2CAP_STATE_OPEN){
+        return ERROR_CODE_COMMAND_DISALLOWED;
+    }
+
+    if (sdu->len > channel->remote_mtu){
+        log_error("l2cap_le_queue_sdu cid 0x%02x, data length exceeds remote MTU.", local_cid);
+        return L2CAP_DATA_LEN_EXCEEDS_REMOTE_MTU;
+    }
+
+    btstack_linked_list_add_tail(&channel->send_sdu_queue, (btstack_linked_item_t *) sdu);
+
+    // start right away if idle
+    if (channel->send_sdu_buffer == NULL){
+        l2cap_le_start_next_queued_sdu(channel);
+        l2cap_notify_channel_can_send();
+    }
+    return ERROR_CODE_SUCCESS;
+}
+
+/**
+ * @brief Get throughput counters of LE Data Channel
+ * @param local_cid             L2CAP LE Data Channel Identifier
+ * @param statistics            storage for counters
+ */
+uint8_t l2cap_le_get_channel_statistics(uint16_t local_cid, l2cap_le_channel_statistics_t * statistics){
+    l2cap_channel_t * channel = l2cap_get_channel_for_local_cid(local_cid);
+    if (!channel) {
+        return L2CAP_LOCAL_CID_DOES_NOT_EXIST;
+    }
+    *statistics = channel->statistics;
+    return ERROR_CODE_SUCCESS;
+}
+
+/**
+ * @brief Reset throughput counters of LE Data Channel
+ * @param local_cid             L2CAP LE Data Channel Identifier
+ */
+uint8_t l2cap_le_reset_channel_statistics(uint16_t local_cid){
+    l2cap_channel_t * channel = l2cap_get_channel_for_local_cid(local_cid);
+    if (!channel) {
+        return L2CAP_LOCAL_CID_DOES_NOT_EXIST;
+    }
+    memset(&channel->statistics, 0, sizeof(l2cap_le_channel_statistics_t));
+    channel->statistics.start_ms = btstack_run_loop_get_time_ms();
+    return ERROR_CODE_SUCCESS;
+}
+
 /**
  * @brief Disconnect from LE Data Channel
  * @param local_cid             L2CAP LE Data Channel Identifier
@@ -4120,3 +4885,668 @@ uint8_t l2cap_le_disconnect(uint16_t local_cid)
 }
 
 #endif
+
+#ifdef ENABLE_L2CAP_ENHANCED_CREDIT_BASED_FLOW_CONTROL_MODE
+
+static inline l2cap_service_t * l2cap_ecbm_get_service(uint16_t spsm){
+    return l2cap_get_service_internal(&l2cap_ecbm_services, spsm);
+}
+
+// 1BH2122
+static void l2cap_ecbm_emit_incoming_connection(l2cap_channel_t *channel, uint8_t num_channels) {
+    log_info("L2CAP_EVENT_ECBM_INCOMING_CONNECTION addr_type %u, addr %s handle 0x%x psm 0x%x num_channels %u local_cid 0x%x remote_mtu %u",
+             channel->address_type, bd_addr_to_str(channel->address), channel->con_handle, channel->psm, num_channels, channel->local_cid, channel->remote_mtu);
+    uint8_t event[18];
+    event[0] = L2CAP_EVENT_ECBM_INCOMING_CONNECTION;
+    event[1] = sizeof(event) - 2u;
+    event[2] = channel->address_type;
+    reverse_bd_addr(channel->address, &event[3]);
+    little_endian_store_16(event,  9, channel->con_handle);
+    little_endian_store_16(event, 11, channel->psm);
+    event[13] = num_channels;
+    little_endian_store_16(event, 14, channel->local_cid);
+    little_endian_store_16(event, 16, channel->remote_mtu);
+    hci_dump_packet( HCI_EVENT_PACKET, 0, event, sizeof(event));
+    l2cap_dispatch_to_channel(channel, HCI_EVENT_PACKET, event, sizeof(event));
+}
+
+// 222
+static void l2cap_ecbm_emit_reconfigured(l2cap_channel_t * channel){
+    log_info("L2CAP_EVENT_ECBM_RECONFIGURED local_cid 0x%x remote_mtu %u remote_mps %u", channel->local_cid, channel->remote_mtu, channel->remote_mps);
+    uint8_t event[8];
+    event[0] = L2CAP_EVENT_ECBM_RECONFIGURED;
+    event[1] = sizeof(event) - 2u;
+    little_endian_store_16(event, 2, channel->local_cid);
+    little_endian_store_16(event, 4, channel->remote_mtu);
+    little_endian_store_16(event, 6, channel->remote_mps);
+    hci_dump_packet( HCI_EVENT_PACKET, 0, event, sizeof(event));
+    l2cap_dispatch_to_channel(channel, HCI_EVENT_PACKET, event, sizeof(event));
+}
+
+// 22
+static void l2cap_ecbm_emit_reconfiguration_complete(l2cap_channel_t * channel, uint16_t result){
+    log_info("L2CAP_EVENT_ECBM_RECONFIGURATION_COMPLETE local_cid 0x%x result 0x%04x", channel->local_cid, result);
+    uint8_t event[6];
+    event[0] = L2CAP_EVENT_ECBM_RECONFIGURATION_COMPLETE;
+    event[1] = sizeof(event) - 2u;
+    little_endian_store_16(event, 2, channel->local_cid);
+    little_endian_store_16(event, 4, result);
+    hci_dump_packet( HCI_EVENT_PACKET, 0, event, sizeof(event));
+    l2cap_dispatch_to_channel(channel, HCI_EVENT_PACKET, event, sizeof(event));
+}
+
+// collect all channels of a multi-channel connection request that are in the same state as the given one
+static uint8_t l2cap_ecbm_get_group(l2cap_channel_t * channel, l2cap_channel_t ** group){
+    bool incoming = (channel->state_var & L2CAP_CHANNEL_STATE_VAR_INCOMING) != 0;
+    uint8_t num_channels = 0;
+    btstack_linked_list_iterator_t it;
+    btstack_linked_list_iterator_init(&it, &l2cap_channels);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        l2cap_channel_t * a_channel = (l2cap_channel_t *) btstack_linked_list_iterator_next(&it);
+        if (a_channel->channel_type != L2CAP_CHANNEL_TYPE_LE_ECBM) continue;
+        if (!l2cap_channels_share_connection(a_channel, channel)) continue;
+        if (a_channel->state != channel->state) continue;
+        if (incoming){
+            if (a_channel->remote_sig_id != channel->remote_sig_id) continue;
+        } else {
+            if (a_channel->local_sig_id != channel->local_sig_id) continue;
+        }
+        if (num_channels == L2CAP_ECBM_MAX_CID_ARRAY_SIZE) break;
+        group[num_channels++] = a_channel;
+    }
+    return num_channels;
+}
+
+static void l2cap_ecbm_send_connection_response(l2cap_channel_t * channel){
+    l2cap_channel_t * group[L2CAP_ECBM_MAX_CID_ARRAY_SIZE];
+    uint8_t destination_cids[L2CAP_ECBM_MAX_CID_ARRAY_SIZE * 2];
+    uint8_t num_channels = l2cap_ecbm_get_group(channel, group);
+    memset(destination_cids, 0, sizeof(destination_cids));
+
+    // channels without receive buffer have been declined
+    l2cap_channel_t * accepted_channel = NULL;
+    uint8_t  num_accepted = 0;
+    uint16_t result = 0;
+    uint8_t i;
+    for (i=0;i<num_channels;i++){
+        if ((result == 0u) && (group[i]->reason != 0u)){
+            result = group[i]->reason;
+        }
+        if (group[i]->receive_sdu_buffer == NULL) continue;
+        little_endian_store_16(destination_cids, 2u * group[i]->cid_index, group[i]->local_cid);
+        accepted_channel = group[i];
+        num_accepted++;
+    }
+    if ((result == 0u) && (num_accepted < channel->num_cids)){
+        // 0x0004 Some connections refused – insufficient resources available
+        result = 0x0004;
+    }
+
+    // mtu, mps, initial credits, result, destination cids
+    uint16_t mtu = 0;
+    uint16_t mps = 0;
+    uint16_t initial_credits = 0;
+    if (accepted_channel != NULL){
+        mtu = accepted_channel->local_mtu;
+        mps = btstack_min(l2cap_max_le_mtu(), mtu);
+        initial_credits = accepted_channel->new_credits_incoming;
+    }
+    l2cap_send_le_signaling_packet(channel->con_handle, CREDIT_BASED_CONNECTION_RESPONSE, channel->remote_sig_id,
+                                   mtu, mps, initial_credits, result, channel->num_cids * 2u, destination_cids);
+
+    for (i=0;i<num_channels;i++){
+        l2cap_channel_t * a_channel = group[i];
+        if (a_channel->receive_sdu_buffer == NULL){
+            // discard channel without event, see l2cap_le_decline_connection
+            btstack_linked_list_remove(&l2cap_channels, (btstack_linked_item_t *) a_channel);
+            l2cap_free_channel_entry(a_channel);
+            continue;
+        }
+        a_channel->state = L2CAP_STATE_OPEN;
+        a_channel->credits_incoming = a_channel->new_credits_incoming;
+        a_channel->new_credits_incoming = 0;
+        l2cap_emit_le_channel_opened(a_channel, 0);
+    }
+}
+
+// @returns true if a multi-channel packet was sent and the channel list might have changed
+static bool l2cap_run_ecbm_channel(l2cap_channel_t * channel){
+    l2cap_channel_t * group[L2CAP_ECBM_MAX_CID_ARRAY_SIZE];
+    uint8_t  cids[L2CAP_ECBM_MAX_CID_ARRAY_SIZE * 2];
+    uint8_t  num_channels;
+    uint8_t  i;
+    uint8_t  sig_id;
+    uint16_t mps;
+    btstack_linked_list_iterator_t it;
+
+    if (!hci_can_send_acl_packet_now(channel->con_handle)) return false;
+
+    switch (channel->state){
+        case L2CAP_STATE_WILL_SEND_ECBM_CONNECTION_REQUEST:
+            num_channels = l2cap_ecbm_get_group(channel, group);
+            for (i=0;i<num_channels;i++){
+                group[i]->state = L2CAP_STATE_WAIT_ECBM_CONNECTION_RESPONSE;
+                group[i]->credits_incoming = group[i]->new_credits_incoming;
+                group[i]->new_credits_incoming = 0;
+                little_endian_store_16(cids, 2u * group[i]->cid_index, group[i]->local_cid);
+            }
+            // spsm, mtu, mps, initial credits, source cids
+            mps = btstack_min(l2cap_max_le_mtu(), channel->local_mtu);
+            l2cap_send_le_signaling_packet(channel->con_handle, CREDIT_BASED_CONNECTION_REQUEST, channel->local_sig_id,
+                                           channel->psm, channel->local_mtu, mps, channel->credits_incoming, num_channels * 2u, cids);
+            return true;
+        case L2CAP_STATE_WILL_SEND_ECBM_CONNECTION_RESPONSE:
+            l2cap_ecbm_send_connection_response(channel);
+            return true;
+        case L2CAP_STATE_OPEN:
+            if ((channel->state_var & L2CAP_CHANNEL_STATE_VAR_SEND_ECBM_RECONF_REQ) == 0) break;
+            // all channels of this connection with pending reconfiguration
+            num_channels = 0;
+            sig_id = l2cap_next_sig_id();
+            btstack_linked_list_iterator_init(&it, &l2cap_channels);
+            while (btstack_linked_list_iterator_has_next(&it)){
+                l2cap_channel_t * a_channel = (l2cap_channel_t *) btstack_linked_list_iterator_next(&it);
+                if (a_channel->channel_type != L2CAP_CHANNEL_TYPE_LE_ECBM) continue;
+                if (!l2cap_channels_share_connection(a_channel, channel)) continue;
+                if ((a_channel->state_var & L2CAP_CHANNEL_STATE_VAR_SEND_ECBM_RECONF_REQ) == 0) continue;
+                if (num_channels == L2CAP_ECBM_MAX_CID_ARRAY_SIZE) break;
+                a_channel->state_var = (L2CAP_CHANNEL_STATE_VAR) (a_channel->state_var & ~L2CAP_CHANNEL_STATE_VAR_SEND_ECBM_RECONF_REQ);
+                a_channel->state_var = (L2CAP_CHANNEL_STATE_VAR) (a_channel->state_var | L2CAP_CHANNEL_STATE_VAR_WAIT_ECBM_RECONF_RSP);
+                a_channel->local_sig_id = sig_id;
+                little_endian_store_16(cids, 2u * num_channels, a_channel->remote_cid);
+                num_channels++;
+            }
+            // mtu, mps, destination cids
+            mps = btstack_min(l2cap_max_le_mtu(), channel->local_mtu);
+            l2cap_send_le_signaling_packet(channel->con_handle, CREDIT_BASED_RECONFIGURE_REQUEST, sig_id,
+                                           channel->local_mtu, mps, num_channels * 2u, cids);
+            return true;
+        default:
+            break;
+    }
+    return false;
+}
+
+static uint16_t l2cap_ecbm_security_check(hci_con_handle_t handle, gap_security_level_t required_security_level){
+    // security: check encryption
+    if (required_security_level >= LEVEL_2){
+        if (gap_encryption_key_size(handle) == 0){
+            // 0x0008 All connections refused - insufficient encryption
+            return 0x0008;
+        }
+        // anything less than 16 byte key size is insufficient
+        if (gap_encryption_key_size(handle) < 16){
+            // 0x0007 All connections refused – insufficient encryption key size
+            return 0x0007;
+        }
+    }
+    // security: check authentication
+    if (required_security_level >= LEVEL_3){
+        if (!gap_authenticated(handle)){
+            // 0x0005 All connections refused – insufficient authentication
+            return 0x0005;
+        }
+    }
+    // security: check authorization
+    if (required_security_level >= LEVEL_4){
+        if (gap_authorization_state(handle) != AUTHORIZATION_GRANTED){
+            // 0x0006 All connections refused – insufficient authorization
+            return 0x0006;
+        }
+    }
+    return 0;
+}
+
+static int l2cap_ecbm_handle_connection_request(hci_con_handle_t handle, uint8_t sig_id, uint8_t * command, uint16_t len){
+    // spsm, mtu, mps, initial credits, at least one source cid
+    if (len < 10u) return 0;
+
+    // get hci connection, bail if not found (must not happen)
+    hci_connection_t * connection = hci_connection_for_handle(handle);
+    if (!connection) return 0;
+
+    uint16_t num_cids = (len - 8u) / 2u;
+    if (num_cids > L2CAP_ECBM_MAX_CID_ARRAY_SIZE){
+        // 0x000c All connections refused – invalid parameters
+        l2cap_register_signaling_response(handle, CREDIT_BASED_CONNECTION_REQUEST, sig_id, L2CAP_ECBM_MAX_CID_ARRAY_SIZE, 0x000c);
+        return 1;
+    }
+
+    uint16_t spsm            = little_endian_read_16(command, L2CAP_SIGNALING_COMMAND_DATA_OFFSET + 0);
+    uint16_t remote_mtu      = little_endian_read_16(command, L2CAP_SIGNALING_COMMAND_DATA_OFFSET + 2);
+    uint16_t remote_mps      = little_endian_read_16(command, L2CAP_SIGNALING_COMMAND_DATA_OFFSET + 4);
+    uint16_t initial_credits = little_endian_read_16(command, L2CAP_SIGNALING_COMMAND_DATA_OFFSET + 6);
+
+    uint16_t result;
+    l2cap_service_t * service = l2cap_ecbm_get_service(spsm);
+    if (!service){
+        // 0x0002 All connections refused – SPSM not supported
+        result = 0x0002;
+    } else if ((remote_mtu < L2CAP_ECBM_MIN_MTU) || (remote_mps < L2CAP_ECBM_MIN_MTU)){
+        // 0x000c All connections refused – invalid parameters
+        result = 0x000c;
+    } else {
+        result = l2cap_ecbm_security_check(handle, service->required_security_level);
+    }
+    if (result != 0u){
+        l2cap_register_signaling_response(handle, CREDIT_BASED_CONNECTION_REQUEST, sig_id, num_cids, result);
+        return 1;
+    }
+
+    // allocate channels, remember first reason for refused ones
+    l2cap_channel_t * channels[L2CAP_ECBM_MAX_CID_ARRAY_SIZE];
+    uint8_t num_channels = 0;
+    uint8_t i;
+    for (i=0;i<num_cids;i++){
+        uint16_t source_cid = little_endian_read_16(command, L2CAP_SIGNALING_COMMAND_DATA_OFFSET + 8 + (2 * i));
+        if (source_cid < 0x40u){
+            // 0x0009 Some connections refused – invalid Source CID
+            if (result == 0u) result = 0x0009;
+            continue;
+        }
+        bool allocated = false;
+        btstack_linked_list_iterator_t it;
+        btstack_linked_list_iterator_init(&it, &l2cap_channels);
+        while (btstack_linked_list_iterator_has_next(&it)){
+            l2cap_channel_t * a_channel = (l2cap_channel_t *) btstack_linked_list_iterator_next(&it);
+            if (!l2cap_is_dynamic_channel_type(a_channel->channel_type)) continue;
+            if (!l2cap_channel_uses_connection(a_channel, handle)) continue;
+            if (a_channel->remote_cid != source_cid) continue;
+            allocated = true;
+            break;
+        }
+        if (allocated){
+            // 0x000a Some connections refused – Source CID already allocated
+            if (result == 0u) result = 0x000a;
+            continue;
+        }
+        l2cap_channel_t * channel = l2cap_create_channel_entry(service->packet_handler, L2CAP_CHANNEL_TYPE_LE_ECBM, connection->address,
+            connection->address_type, spsm, 0, service->required_security_level);
+        if (!channel){
+            // 0x0004 Some connections refused – insufficient resources available
+            if (result == 0u) result = 0x0004;
+            continue;
+        }
+        channel->con_handle       = handle;
+        channel->remote_cid       = source_cid;
+        channel->remote_sig_id    = sig_id;
+        channel->remote_mtu       = remote_mtu;
+        channel->remote_mps       = remote_mps;
+        channel->credits_outgoing = initial_credits;
+        channel->cid_index        = i;
+        channel->num_cids         = (uint8_t) num_cids;
+        channel->state            = L2CAP_STATE_WAIT_CLIENT_ACCEPT_OR_REJECT;
+        channel->state_var        = (L2CAP_CHANNEL_STATE_VAR) (channel->state_var | L2CAP_CHANNEL_STATE_VAR_INCOMING);
+        channels[num_channels++]  = channel;
+    }
+
+    if (num_channels == 0u){
+        l2cap_register_signaling_response(handle, CREDIT_BASED_CONNECTION_REQUEST, sig_id, num_cids, result);
+        return 1;
+    }
+
+    // add to channel list, result is reported in connection response
+    for (i=0;i<num_channels;i++){
+        channels[i]->reason = result;
+        btstack_linked_list_add_tail(&l2cap_channels, (btstack_linked_item_t *) channels[i]);
+    }
+
+    // post connection request event
+    l2cap_ecbm_emit_incoming_connection(channels[0], num_channels);
+    return 1;
+}
+
+static int l2cap_ecbm_handle_connection_response(hci_con_handle_t handle, uint8_t sig_id, uint8_t * command, uint16_t len){
+    // mtu, mps, initial credits, result
+    if (len < 8u) return 0;
+
+    uint16_t remote_mtu      = little_endian_read_16(command, L2CAP_SIGNALING_COMMAND_DATA_OFFSET + 0);
+    uint16_t remote_mps      = little_endian_read_16(command, L2CAP_SIGNALING_COMMAND_DATA_OFFSET + 2);
+    uint16_t initial_credits = little_endian_read_16(command, L2CAP_SIGNALING_COMMAND_DATA_OFFSET + 4);
+    uint16_t result          = little_endian_read_16(command, L2CAP_SIGNALING_COMMAND_DATA_OFFSET + 6);
+    uint16_t num_cids        = (len - 8u) / 2u;
+
+    btstack_linked_list_iterator_t it;
+    btstack_linked_list_iterator_init(&it, &l2cap_channels);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        l2cap_channel_t * channel = (l2cap_channel_t *) btstack_linked_list_iterator_next(&it);
+        if (channel->channel_type != L2CAP_CHANNEL_TYPE_LE_ECBM) continue;
+        if (!l2cap_channel_uses_connection(channel, handle)) continue;
+        if (channel->local_sig_id != sig_id) continue;
+        if (channel->state != L2CAP_STATE_WAIT_ECBM_CONNECTION_RESPONSE) continue;
+
+        uint16_t remote_cid = 0;
+        if (channel->cid_index < num_cids){
+            remote_cid = little_endian_read_16(command, L2CAP_SIGNALING_COMMAND_DATA_OFFSET + 8 + (2 * channel->cid_index));
+        }
+
+        if (remote_cid == 0u){
+            // refused, report result or 0x0004 Some connections refused – insufficient resources available
+            channel->state = L2CAP_STATE_CLOSED;
+            l2cap_emit_le_channel_opened(channel, (result != 0u) ? result : 0x0004);
+            btstack_linked_list_iterator_remove(&it);
+            l2cap_free_channel_entry(channel);
+            continue;
+        }
+
+        channel->remote_cid = remote_cid;
+        channel->remote_mtu = remote_mtu;
+        channel->remote_mps = remote_mps;
+        channel->credits_outgoing = initial_credits;
+        channel->state = L2CAP_STATE_OPEN;
+        l2cap_emit_le_channel_opened(channel, 0);
+    }
+    return 1;
+}
+
+static int l2cap_ecbm_handle_reconfigure_request(hci_con_handle_t handle, uint8_t sig_id, uint8_t * command, uint16_t len){
+    // mtu, mps, at least one destination cid
+    if (len < 6u) return 0;
+
+    uint16_t remote_mtu = little_endian_read_16(command, L2CAP_SIGNALING_COMMAND_DATA_OFFSET + 0);
+    uint16_t remote_mps = little_endian_read_16(command, L2CAP_SIGNALING_COMMAND_DATA_OFFSET + 2);
+    uint16_t num_cids   = (len - 4u) / 2u;
+
+    l2cap_channel_t * channels[L2CAP_ECBM_MAX_CID_ARRAY_SIZE];
+    uint16_t result = 0;
+    uint8_t i;
+    if ((num_cids > L2CAP_ECBM_MAX_CID_ARRAY_SIZE) || (remote_mtu < L2CAP_ECBM_MIN_MTU) || (remote_mps < L2CAP_ECBM_MIN_MTU)){
+        // 0x0004 Reconfiguration failed - other unacceptable parameters
+        result = 0x0004;
+    } else {
+        for (i=0;i<num_cids;i++){
+            uint16_t local_cid = little_endian_read_16(command, L2CAP_SIGNALING_COMMAND_DATA_OFFSET + 4 + (2 * i));
+            l2cap_channel_t * channel = l2cap_get_channel_for_local_cid(local_cid);
+            if ((channel == NULL) || (channel->channel_type != L2CAP_CHANNEL_TYPE_LE_ECBM) || !l2cap_channel_uses_connection(channel, handle)){
+                // 0x0003 Reconfiguration failed - one or more Destination CIDs invalid
+                result = 0x0003;
+                break;
+            }
+            if (remote_mtu < channel->remote_mtu){
+                // 0x0001 Reconfiguration failed - reduction in size of MTU not allowed
+                result = 0x0001;
+                break;
+            }
+            if ((num_cids > 1u) && (remote_mps < channel->remote_mps)){
+                // 0x0002 Reconfiguration failed - reduction in size of MPS not allowed for more than one channel at a time
+                result = 0x0002;
+                break;
+            }
+            channels[i] = channel;
+        }
+    }
+
+    if (result == 0u){
+        for (i=0;i<num_cids;i++){
+            channels[i]->remote_mtu = remote_mtu;
+            channels[i]->remote_mps = remote_mps;
+            l2cap_ecbm_emit_reconfigured(channels[i]);
+        }
+    }
+
+    l2cap_register_signaling_response(handle, CREDIT_BASED_RECONFIGURE_REQUEST, sig_id, 0, result);
+    return 1;
+}
+
+static void l2cap_ecbm_complete_reconfiguration(hci_con_handle_t handle, uint16_t result){
+    btstack_linked_list_iterator_t it;
+    btstack_linked_list_iterator_init(&it, &l2cap_channels);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        l2cap_channel_t * channel = (l2cap_channel_t *) btstack_linked_list_iterator_next(&it);
+        if (channel->channel_type != L2CAP_CHANNEL_TYPE_LE_ECBM) continue;
+        if (!l2cap_channel_uses_connection(channel, handle)) continue;
+        if ((channel->state_var & L2CAP_CHANNEL_STATE_VAR_WAIT_ECBM_RECONF_RSP) == 0) continue;
+        channel->state_var = (L2CAP_CHANNEL_STATE_VAR) (channel->state_var & ~L2CAP_CHANNEL_STATE_VAR_WAIT_ECBM_RECONF_RSP);
+        l2cap_ecbm_emit_reconfiguration_complete(channel, result);
+    }
+}
+
+static void l2cap_ecbm_handle_command_reject(l2cap_channel_t * channel){
+    hci_con_handle_t handle = channel->con_handle;
+
+    // reconfigure request rejected, report as 0x0004 Reconfiguration failed - other unacceptable parameters
+    if ((channel->state_var & L2CAP_CHANNEL_STATE_VAR_WAIT_ECBM_RECONF_RSP) != 0){
+        l2cap_ecbm_complete_reconfiguration(handle, 0x0004);
+        return;
+    }
+
+    if (channel->state != L2CAP_STATE_WAIT_ECBM_CONNECTION_RESPONSE) return;
+
+    // connection request rejected, assume remote does not support ECBM
+    uint8_t sig_id = channel->local_sig_id;
+    btstack_linked_list_iterator_t it;
+    btstack_linked_list_iterator_init(&it, &l2cap_channels);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        l2cap_channel_t * a_channel = (l2cap_channel_t *) btstack_linked_list_iterator_next(&it);
+        if (a_channel->channel_type != L2CAP_CHANNEL_TYPE_LE_ECBM) continue;
+        if (!l2cap_channel_uses_connection(a_channel, handle)) continue;
+        if (a_channel->local_sig_id != sig_id) continue;
+        if (a_channel->state != L2CAP_STATE_WAIT_ECBM_CONNECTION_RESPONSE) continue;
+        a_channel->state = L2CAP_STATE_CLOSED;
+        // no official value for this, use: All connections refused – SPSM not supported - 0x0002
+        l2cap_emit_le_channel_opened(a_channel, 0x0002);
+        btstack_linked_list_iterator_remove(&it);
+        l2cap_free_channel_entry(a_channel);
+    }
+}
+
+// @returns valid
+static int l2cap_ecbm_signaling_handler_dispatch(hci_con_handle_t handle, uint8_t * command, uint8_t sig_id){
+    uint8_t  code = command[L2CAP_SIGNALING_COMMAND_CODE_OFFSET];
+    uint16_t len  = little_endian_read_16(command, L2CAP_SIGNALING_COMMAND_LENGTH_OFFSET);
+    switch (code){
+        case CREDIT_BASED_CONNECTION_REQUEST:
+            return l2cap_ecbm_handle_connection_request(handle, sig_id, command, len);
+        case CREDIT_BASED_CONNECTION_RESPONSE:
+            return l2cap_ecbm_handle_connection_response(handle, sig_id, command, len);
+        case CREDIT_BASED_RECONFIGURE_REQUEST:
+            return l2cap_ecbm_handle_reconfigure_request(handle, sig_id, command, len);
+        case CREDIT_BASED_RECONFIGURE_RESPONSE:
+            if (len < 2u) return 0;
+            l2cap_ecbm_complete_reconfiguration(handle, little_endian_read_16(command, L2CAP_SIGNALING_COMMAND_DATA_OFFSET));
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+uint8_t l2cap_ecbm_register_service(btstack_packet_handler_t packet_handler, uint16_t psm, gap_security_level_t security_level){
+
+    log_info("L2CAP_ECBM_REGISTER_SERVICE psm 0x%x", psm);
+
+    // check for alread registered psm
+    l2cap_service_t *service = l2cap_ecbm_get_service(psm);
+    if (service) {
+        return L2CAP_SERVICE_ALREADY_REGISTERED;
+    }
+
+    // alloc structure
+    service = btstack_memory_l2cap_service_get();
+    if (!service) {
+        log_error("l2cap_ecbm_register_service: no memory for l2cap_service_t");
+        return BTSTACK_MEMORY_ALLOC_FAILED;
+    }
+
+    // fill in
+    service->psm = psm;
+    service->mtu = 0;
+    service->packet_handler = packet_handler;
+    service->required_security_level = security_level;
+
+    // add to services list
+    btstack_linked_list_add(&l2cap_ecbm_services, (btstack_linked_item_t *) service);
+
+    // done
+    return ERROR_CODE_SUCCESS;
+}
+
+uint8_t l2cap_ecbm_unregister_service(uint16_t psm) {
+    log_info("L2CAP_ECBM_UNREGISTER_SERVICE psm 0x%x", psm);
+    l2cap_service_t *service = l2cap_ecbm_get_service(psm);
+    if (!service) return L2CAP_SERVICE_DOES_NOT_EXIST;
+
+    btstack_linked_list_remove(&l2cap_ecbm_services, (btstack_linked_item_t *) service);
+    btstack_memory_l2cap_service_free(service);
+    return ERROR_CODE_SUCCESS;
+}
+
+uint8_t l2cap_ecbm_create_channels(btstack_packet_handler_t packet_handler, hci_con_handle_t con_handle,
+    gap_security_level_t security_level, uint16_t psm, uint8_t num_channels, uint16_t initial_credits,
+    uint16_t receive_buffer_size, uint8_t ** receive_buffers, uint16_t * out_local_cids){
+
+    log_info("L2CAP_ECBM_CREATE_CHANNELS handle 0x%04x psm 0x%x num_channels %u mtu %u", con_handle, psm, num_channels, receive_buffer_size);
+
+    if ((num_channels == 0u) || (num_channels > L2CAP_ECBM_MAX_CID_ARRAY_SIZE)) return ERROR_CODE_INVALID_HCI_COMMAND_PARAMETERS;
+    if (receive_buffer_size < L2CAP_ECBM_MIN_MTU) return ERROR_CODE_INVALID_HCI_COMMAND_PARAMETERS;
+
+    hci_connection_t * connection = hci_connection_for_handle(con_handle);
+    if (!connection) {
+        log_error("no hci_connection for handle 0x%04x", con_handle);
+        return ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER;
+    }
+
+    // allocate all channels first
+    l2cap_channel_t * channels[L2CAP_ECBM_MAX_CID_ARRAY_SIZE];
+    uint8_t i;
+    for (i=0;i<num_channels;i++){
+        channels[i] = l2cap_create_channel_entry(packet_handler, L2CAP_CHANNEL_TYPE_LE_ECBM, connection->address, connection->address_type,
+            psm, receive_buffer_size, security_level);
+        if (channels[i] == NULL){
+            while (i > 0u){
+                i--;
+                l2cap_free_channel_entry(channels[i]);
+            }
+            return BTSTACK_MEMORY_ALLOC_FAILED;
+        }
+    }
+
+    // all channels share the signaling identifier of the connection request
+    uint8_t sig_id = l2cap_next_sig_id();
+    for (i=0;i<num_channels;i++){
+        l2cap_channel_t * channel = channels[i];
+        channel->con_handle = con_handle;
+        channel->receive_sdu_buffer = receive_buffers[i];
+        channel->local_sig_id = sig_id;
+        channel->cid_index = i;
+        channel->num_cids = num_channels;
+        channel->state = L2CAP_STATE_WILL_SEND_ECBM_CONNECTION_REQUEST;
+        channel->new_credits_incoming = initial_credits;
+        channel->automatic_credits    = initial_credits == L2CAP_LE_AUTOMATIC_CREDITS;
+        if (out_local_cids){
+            out_local_cids[i] = channel->local_cid;
+        }
+        btstack_linked_list_add_tail(&l2cap_channels, (btstack_linked_item_t *) channel);
+    }
+
+    // go
+    l2cap_run();
+    return ERROR_CODE_SUCCESS;
+}
+
+uint8_t l2cap_ecbm_accept_channels(uint16_t local_cid, uint8_t num_channels, uint16_t initial_credits,
+    uint16_t receive_buffer_size, uint8_t ** receive_buffers, uint16_t * out_local_cids){
+
+    l2cap_channel_t * channel = l2cap_get_channel_for_local_cid(local_cid);
+    if (!channel) return L2CAP_LOCAL_CID_DOES_NOT_EXIST;
+
+    // validate state
+    if (channel->channel_type != L2CAP_CHANNEL_TYPE_LE_ECBM) return ERROR_CODE_COMMAND_DISALLOWED;
+    if (channel->state != L2CAP_STATE_WAIT_CLIENT_ACCEPT_OR_REJECT) return ERROR_CODE_COMMAND_DISALLOWED;
+    if (receive_buffer_size < L2CAP_ECBM_MIN_MTU) return ERROR_CODE_INVALID_HCI_COMMAND_PARAMETERS;
+
+    // accept first num_channels, decline others
+    l2cap_channel_t * group[L2CAP_ECBM_MAX_CID_ARRAY_SIZE];
+    uint8_t num_group = l2cap_ecbm_get_group(channel, group);
+    uint8_t i;
+    for (i=0;i<num_group;i++){
+        l2cap_channel_t * a_channel = group[i];
+        a_channel->state = L2CAP_STATE_WILL_SEND_ECBM_CONNECTION_RESPONSE;
+        if (i >= num_channels) continue;
+        a_channel->receive_sdu_buffer = receive_buffers[i];
+        a_channel->local_mtu = receive_buffer_size;
+        a_channel->new_credits_incoming = initial_credits;
+        a_channel->automatic_credits  = initial_credits == L2CAP_LE_AUTOMATIC_CREDITS;
+        if (out_local_cids){
+            out_local_cids[i] = a_channel->local_cid;
+        }
+    }
+
+    // go
+    l2cap_run();
+    return ERROR_CODE_SUCCESS;
+}
+
+uint8_t l2cap_ecbm_decline_channels(uint16_t local_cid, uint16_t result){
+    l2cap_channel_t * channel = l2cap_get_channel_for_local_cid(local_cid);
+    if (!channel) return L2CAP_LOCAL_CID_DOES_NOT_EXIST;
+
+    // validate state
+    if (channel->channel_type != L2CAP_CHANNEL_TYPE_LE_ECBM) return ERROR_CODE_COMMAND_DISALLOWED;
+    if (channel->state != L2CAP_STATE_WAIT_CLIENT_ACCEPT_OR_REJECT) return ERROR_CODE_COMMAND_DISALLOWED;
+
+    // 0x0004 All connections refused – insufficient resources available
+    if (result == 0u){
+        result = 0x0004;
+    }
+
+    l2cap_channel_t * group[L2CAP_ECBM_MAX_CID_ARRAY_SIZE];
+    uint8_t num_group = l2cap_ecbm_get_group(channel, group);
+    uint8_t i;
+    for (i=0;i<num_group;i++){
+        group[i]->state  = L2CAP_STATE_WILL_SEND_ECBM_CONNECTION_RESPONSE;
+        group[i]->reason = result;
+    }
+
+    // go
+    l2cap_run();
+    return ERROR_CODE_SUCCESS;
+}
+
+uint8_t l2cap_ecbm_reconfigure_channels(uint8_t num_cids, uint16_t * local_cids, uint16_t receive_buffer_size, uint8_t ** receive_buffers){
+    if ((num_cids == 0u) || (num_cids > L2CAP_ECBM_MAX_CID_ARRAY_SIZE)) return ERROR_CODE_INVALID_HCI_COMMAND_PARAMETERS;
+
+    // validate channels: open, same connection, MTU not reduced
+    l2cap_channel_t * first_channel = NULL;
+    uint8_t i;
+    for (i=0;i<num_cids;i++){
+        l2cap_channel_t * channel = l2cap_get_channel_for_local_cid(local_cids[i]);
+        if (!channel) return L2CAP_LOCAL_CID_DOES_NOT_EXIST;
+        if (channel->channel_type != L2CAP_CHANNEL_TYPE_LE_ECBM) return ERROR_CODE_COMMAND_DISALLOWED;
+        if (channel->state != L2CAP_STATE_OPEN) return ERROR_CODE_COMMAND_DISALLOWED;
+        if (i == 0u){
+            first_channel = channel;
+        } else if (!l2cap_channels_share_connection(channel, first_channel)){
+            return ERROR_CODE_INVALID_HCI_COMMAND_PARAMETERS;
+        }
+        if (receive_buffer_size < channel->local_mtu) return ERROR_CODE_INVALID_HCI_COMMAND_PARAMETERS;
+    }
+
+    // only one reconfiguration per connection
+    btstack_linked_list_iterator_t it;
+    btstack_linked_list_iterator_init(&it, &l2cap_channels);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        l2cap_channel_t * channel = (l2cap_channel_t *) btstack_linked_list_iterator_next(&it);
+        if (channel->channel_type != L2CAP_CHANNEL_TYPE_LE_ECBM) continue;
+        if (!l2cap_channels_share_connection(channel, first_channel)) continue;
+        if ((channel->state_var & (L2CAP_CHANNEL_STATE_VAR_SEND_ECBM_RECONF_REQ | L2CAP_CHANNEL_STATE_VAR_WAIT_ECBM_RECONF_RSP)) != 0){
+            return ERROR_CODE_COMMAND_DISALLOWED;
+        }
+    }
+
+    // switch to larger receive buffers, keeping partially received SDU
+    for (i=0;i<num_cids;i++){
+        l2cap_channel_t * channel = l2cap_get_channel_for_local_cid(local_cids[i]);
+        if (channel->receive_sdu_len > 0u){
+            (void)memcpy(receive_buffers[i], channel->receive_sdu_buffer, channel->receive_sdu_pos);
+        }
+        channel->receive_sdu_buffer = receive_buffers[i];
+        channel->local_mtu = receive_buffer_size;
+        channel->state_var = (L2CAP_CHANNEL_STATE_VAR) (channel->state_var | L2CAP_CHANNEL_STATE_VAR_SEND_ECBM_RECONF_REQ);
+    }
+
+    // go
+    l2cap_run();
+    return ERROR_CODE_SUCCESS;
+}
+
+#endif
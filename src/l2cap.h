@@ -67,8 +67,24 @@ extern "C" {
 #endif
 #endif
 
+// EATT bearers use Enhanced Credit-Based Flow Control Mode
+#if defined(ENABLE_GATT_OVER_EATT) && !defined(ENABLE_L2CAP_ENHANCED_CREDIT_BASED_FLOW_CONTROL_MODE)
+#error "ENABLE_GATT_OVER_EATT requires ENABLE_L2CAP_ENHANCED_CREDIT_BASED_FLOW_CONTROL_MODE. Please update btstack_config.h"
+#endif
+
+// Enhanced Credit-Based Flow Control Mode reuses the LE Data Channel data path
+#if defined(ENABLE_L2CAP_ENHANCED_CREDIT_BASED_FLOW_CONTROL_MODE) && !defined(ENABLE_LE_DATA_CHANNELS)
+#error "ENABLE_L2CAP_ENHANCED_CREDIT_BASED_FLOW_CONTROL_MODE requires ENABLE_LE_DATA_CHANNELS. Please update btstack_config.h"
+#endif
+
 #define L2CAP_LE_AUTOMATIC_CREDITS 0xffff
 
+// Enhanced Credit-Based Flow Control Mode: max number of channels per connection or reconfigure request
+#define L2CAP_ECBM_MAX_CID_ARRAY_SIZE 5
+
+// Enhanced Credit-Based Flow Control Mode: minimal MTU and MPS
+#define L2CAP_ECBM_MIN_MTU 64
+
 // private structs
 typedef enum {
     L2CAP_STATE_CLOSED = 1,           // no baseband
@@ -94,6 +110,9 @@ typedef enum {
     L2CAP_STATE_WILL_SEND_LE_CONNECTION_RESPONSE_DECLINE,
     L2CAP_STATE_WILL_SEND_LE_CONNECTION_RESPONSE_ACCEPT,
     L2CAP_STATE_WAIT_LE_CONNECTION_RESPONSE,
+    L2CAP_STATE_WILL_SEND_ECBM_CONNECTION_REQUEST,
+    L2CAP_STATE_WAIT_ECBM_CONNECTION_RESPONSE,
+    L2CAP_STATE_WILL_SEND_ECBM_CONNECTION_RESPONSE,
     L2CAP_STATE_EMIT_OPEN_FAILED_AND_DISCARD,
     L2CAP_STATE_INVALID,
 } L2CAP_STATE;
@@ -114,7 +133,9 @@ typedef enum {
     L2CAP_CHANNEL_STATE_VAR_BASIC_FALLBACK_TRIED   = 1 << 11,  // set when ERTM was requested but we want only Basic mode (ERM)
     L2CAP_CHANNEL_STATE_VAR_SEND_CMD_REJ_UNKNOWN   = 1 << 12,  // send CMD_REJ with reason unknown
     L2CAP_CHANNEL_STATE_VAR_SEND_CONN_RESP_PEND    = 1 << 13,  // send Connection Respond with pending
+    L2CAP_CHANNEL_STATE_VAR_SEND_ECBM_RECONF_REQ   = 1 << 14,  // send Credit Based Reconfigure Request (ECBM)
     L2CAP_CHANNEL_STATE_VAR_INCOMING               = 1 << 15,  // channel is incoming
+    L2CAP_CHANNEL_STATE_VAR_WAIT_ECBM_RECONF_RSP   = 1 << 16,  // wait for Credit Based Reconfigure Response (ECBM)
 } L2CAP_CHANNEL_STATE_VAR;
 
 typedef enum {
@@ -122,6 +143,7 @@ typedef enum {
     L2CAP_CHANNEL_TYPE_CONNECTIONLESS,  // Classic Connectionless
     L2CAP_CHANNEL_TYPE_LE_DATA_CHANNEL, // LE
     L2CAP_CHANNEL_TYPE_LE_FIXED,        // LE ATT + SM
+    L2CAP_CHANNEL_TYPE_LE_ECBM,         // LE Enhanced Credit-Based Flow Control Mode
 } l2cap_channel_type_t;
 
 
@@ -144,7 +166,7 @@ typedef struct {
 typedef struct {
     l2cap_segmentation_and_reassembly_t sar;
     uint16_t len;
-    uint8_t tx_seq;
+    uint16_t tx_seq;
     uint8_t retry_count;
     uint8_t retransmission_requested;
 } l2cap_ertm_tx_packet_state_t;
@@ -166,16 +188,55 @@ typedef struct {
     uint16_t local_mtu;
 
     // Number of buffers for outgoing data
-    uint8_t num_tx_buffers;
+    uint16_t num_tx_buffers;
 
     // Number of packets that can be received out of order (-> our tx_window size)
-    uint8_t num_rx_buffers;
+    // Values > 63 use the Extended Window Size option if supported by remote, max 0x3fff
+    uint16_t num_rx_buffers;
 
     // Frame Check Sequence (FCS) Option
     uint8_t fcs_option;
 
+    // Use Streaming Mode instead of Enhanced Retransmission Mode: no acknowledgements, no retransmissions
+    uint8_t streaming_mode;
+
 } l2cap_ertm_config_t;
 
+// outgoing SDU for LE Data Channels, provided by caller and released by callback
+typedef struct l2cap_le_sdu {
+    // linked list - assert: first field
+    btstack_linked_item_t item;
+
+    // SDU data, owned by caller until release is called
+    uint8_t * data;
+    uint16_t  len;
+
+    // called after SDU was sent (status ERROR_CODE_SUCCESS) or when channel was closed (status L2CAP_LOCAL_CID_DOES_NOT_EXIST)
+    void (*release)(struct l2cap_le_sdu * sdu, uint8_t status);
+
+    // user data
+    void * context;
+} l2cap_le_sdu_t;
+
+// throughput counters for LE Data Channels
+typedef struct {
+    // time of channel creation or last reset
+    uint32_t start_ms;
+
+    // outgoing SDUs, SDU payload bytes and K-frames
+    uint32_t tx_sdus;
+    uint32_t tx_bytes;
+    uint32_t tx_pdus;
+
+    // K-frames sent that used the last outgoing credit while more data was pending
+    uint32_t tx_credit_stalls;
+
+    // incoming SDUs, SDU payload bytes and K-frames
+    uint32_t rx_sdus;
+    uint32_t rx_bytes;
+    uint32_t rx_pdus;
+} l2cap_le_channel_statistics_t;
+
 // info regarding an actual channel
 // note: l2cap_fixed_channel and l2cap_channel_t share commmon fields
 
@@ -226,6 +287,11 @@ typedef struct {
     // info
     hci_con_handle_t con_handle;
 
+#ifdef ENABLE_HCI_MULTIPLE_CONTROLLERS
+    // Controller of the connection
+    uint8_t controller_index;
+#endif
+
     bd_addr_t address;
     bd_addr_type_t address_type;
     
@@ -272,10 +338,32 @@ typedef struct {
     // automatic credits incoming
     uint16_t automatic_credits;
 
+#ifdef ENABLE_LE_DATA_CHANNELS
+
+    // queued outgoing SDUs, head is being sent if send_sdu_from_queue is set
+    btstack_linked_list_t send_sdu_queue;
+    uint8_t send_sdu_from_queue;
+
+    // throughput counters
+    l2cap_le_channel_statistics_t statistics;
+#endif
+
+#ifdef ENABLE_L2CAP_ENHANCED_CREDIT_BASED_FLOW_CONTROL_MODE
+
+    // position in multi-channel connection request / response
+    uint8_t  cid_index;
+
+    // number of channels in incoming connection request
+    uint8_t  num_cids;
+#endif
+
 #ifdef ENABLE_L2CAP_ENHANCED_RETRANSMISSION_MODE
 
-    // l2cap channel mode: basic or enhanced retransmission mode
+    // l2cap channel mode: basic, enhanced retransmission mode or streaming mode
     l2cap_channel_mode_t mode;
+
+    // use 32-bit Extended Control Field with 14-bit sequence numbers - set if Extended Window Size option was used
+    uint8_t extended_control;
     
     // local mps = size of rx/tx buffers
     uint16_t local_mps;
@@ -293,7 +381,7 @@ typedef struct {
     uint16_t remote_retransmission_timeout_ms;
     uint16_t remote_monitor_timeout_ms;
 
-    uint8_t remote_tx_window_size;
+    uint16_t remote_tx_window_size;
 
     uint8_t local_max_transmit;
     uint8_t remote_max_transmit;
@@ -305,41 +393,47 @@ typedef struct {
     uint8_t fcs_option;
 
     // sender: max num of stored outgoing frames
-    uint8_t num_tx_buffers;
+    uint16_t num_tx_buffers;
 
     // sender: num stored outgoing frames
-    uint8_t num_stored_tx_frames;
+    uint16_t num_stored_tx_frames;
 
     // sender: number of unacknowledeged I-Frames - frames have been sent, but not acknowledged yet
-    uint8_t unacked_frames;
+    uint16_t unacked_frames;
 
     // sender: buffer index of oldest packet
-    uint8_t tx_read_index;
+    uint16_t tx_read_index;
 
     // sender: buffer index to store next tx packet
-    uint8_t tx_write_index;
+    uint16_t tx_write_index;
 
     // sender: buffer index of packet to send next
-    uint8_t tx_send_index;
+    uint16_t tx_send_index;
 
     // sender: next seq nr used for sending
-    uint8_t next_tx_seq;
+    uint16_t next_tx_seq;
 
     // sender: selective retransmission requested
     uint8_t srej_active;
 
 
     // receiver: max num out-of-order packets // tx_window
-    uint8_t num_rx_buffers;
+    uint16_t num_rx_buffers;
 
     // receiver: buffer index of to store packet with delta = 1
-    uint8_t rx_store_index;
+    uint16_t rx_store_index;
 
     // receiver: value of tx_seq in next expected i-frame
-    uint8_t expected_tx_seq;
+    uint16_t expected_tx_seq;
 
     // receiver: request transmission with tx_seq = req_seq and ack up to and including req_seq
-    uint8_t req_seq;
+    uint16_t req_seq;
+
+    // receiver: SREJ list - next missing tx_seq to request with SREJ
+    uint16_t srej_request_seq;
+
+    // receiver: SREJ list - tx_seq after newest stored out-of-order frame
+    uint16_t srej_request_end;
 
     // receiver: local busy condition
     uint8_t local_busy;
@@ -384,6 +478,11 @@ typedef struct {
     uint8_t * tx_packets_data;
 
 #endif    
+
+#ifdef ENABLE_BTSTACK_STATS
+    // traffic of this channel
+    btstack_stats_traffic_t stats;
+#endif
 } l2cap_channel_t;
 
 // info regarding potential connections
@@ -408,6 +507,9 @@ typedef struct {
 
 typedef struct l2cap_signaling_response {
     hci_con_handle_t handle;
+#ifdef ENABLE_HCI_MULTIPLE_CONTROLLERS
+    uint8_t  controller_index;
+#endif
     uint8_t  sig_id;
     uint8_t  code;
     uint16_t cid;  // source cid for CONNECTION REQUEST
@@ -441,6 +543,7 @@ int  l2cap_can_send_prepared_packet_now(uint16_t local_cid);
 #define PSM_HID_INTERRUPT 0x13
 #define PSM_ATT           0x1f
 #define PSM_IPSP          0x23
+#define PSM_EATT          0x27
 
 /** 
  * @brief Set up L2CAP and register L2CAP with HCI layer.
@@ -659,12 +762,106 @@ uint8_t l2cap_le_request_can_send_now_event(uint16_t cid);
  */
 uint8_t l2cap_le_send_data(uint16_t cid, uint8_t * data, uint16_t size);
 
+/**
+ * @brief Queue SDU for transmission via LE Data Channel
+ * @note SDUs are sent in order after a pending l2cap_le_send_data SDU, K-frames are sent back-to-back while
+ *       credits and ACL buffers are available. sdu->release is called when the SDU was sent or the channel was closed,
+ *       no L2CAP_EVENT_LE_PACKET_SENT is emitted for queued SDUs
+ * @param local_cid             L2CAP LE Data Channel Identifier
+ * @param sdu                   SDU with data, len, and release callback, owned by caller until released
+ */
+uint8_t l2cap_le_queue_sdu(uint16_t cid, l2cap_le_sdu_t * sdu);
+
+/**
+ * @brief Get throughput counters of LE Data Channel
+ * @param local_cid             L2CAP LE Data Channel Identifier
+ * @param statistics            storage for counters
+ */
+uint8_t l2cap_le_get_channel_statistics(uint16_t cid, l2cap_le_channel_statistics_t * statistics);
+
+/**
+ * @brief Reset throughput counters of LE Data Channel
+ * @param local_cid             L2CAP LE Data Channel Identifier
+ */
+uint8_t l2cap_le_reset_channel_statistics(uint16_t cid);
+
 /**
  * @brief Disconnect from LE Data Channel
  * @param local_cid             L2CAP LE Data Channel Identifier
  */
 uint8_t l2cap_le_disconnect(uint16_t cid);
 
+
+//
+// LE Connection Oriented Channels with the Enhanced Credit Based Flow Control Mode (ECBM)
+//
+// Channels are opened in groups of up to L2CAP_ECBM_MAX_CID_ARRAY_SIZE with a single request.
+// Once open, data is sent and credits are provided with the l2cap_le_* functions above, including l2cap_le_queue_sdu.
+// L2CAP_EVENT_LE_CHANNEL_CLOSED is emitted when a channel is closed.
+//
+
+/**
+ * @brief Register L2CAP Enhanced Credit Based Flow Control Mode service
+ * @note MTU and initial credits are specified in l2cap_ecbm_accept_channels(..) call
+ * @param packet_handler
+ * @param psm
+ * @param security_level
+ */
+uint8_t l2cap_ecbm_register_service(btstack_packet_handler_t packet_handler, uint16_t psm, gap_security_level_t security_level);
+
+/**
+ * @brief Unregister L2CAP Enhanced Credit Based Flow Control Mode service
+ * @param psm
+ */
+uint8_t l2cap_ecbm_unregister_service(uint16_t psm);
+
+/**
+ * @brief Create up to L2CAP_ECBM_MAX_CID_ARRAY_SIZE channels with a single connection request
+ * @note L2CAP_EVENT_ECBM_CHANNEL_OPENED is emitted for each channel
+ * @param packet_handler        Packet handler for the channels
+ * @param con_handle            ACL-LE HCI Connction Handle
+ * @param security_level        Minimum required security level
+ * @param psm                   Service PSM to connect to
+ * @param num_channels          Number of channels to create
+ * @param initial_credits       Number of initial credits provided to peer per channel or L2CAP_LE_AUTOMATIC_CREDITS to enable automatic credits
+ * @param receive_buffer_size   Size of each receive buffer, equals MTU, at least L2CAP_ECBM_MIN_MTU
+ * @param receive_buffers       Array of num_channels receive buffers
+ * @param out_local_cids        Array of num_channels L2CAP Channel Identifiers is stored here
+ */
+uint8_t l2cap_ecbm_create_channels(btstack_packet_handler_t packet_handler, hci_con_handle_t con_handle,
+    gap_security_level_t security_level, uint16_t psm, uint8_t num_channels, uint16_t initial_credits,
+    uint16_t receive_buffer_size, uint8_t ** receive_buffers, uint16_t * out_local_cids);
+
+/**
+ * @brief Accept incoming channels reported by L2CAP_EVENT_ECBM_INCOMING_CONNECTION
+ * @note Channels beyond num_channels are declined
+ * @param local_cid             L2CAP Channel Identifier from L2CAP_EVENT_ECBM_INCOMING_CONNECTION
+ * @param num_channels          Number of channels to accept
+ * @param initial_credits       Number of initial credits provided to peer per channel or L2CAP_LE_AUTOMATIC_CREDITS to enable automatic credits
+ * @param receive_buffer_size   Size of each receive buffer, equals MTU, at least L2CAP_ECBM_MIN_MTU
+ * @param receive_buffers       Array of num_channels receive buffers
+ * @param out_local_cids        Array of num_channels L2CAP Channel Identifiers is stored here
+ */
+uint8_t l2cap_ecbm_accept_channels(uint16_t local_cid, uint8_t num_channels, uint16_t initial_credits,
+    uint16_t receive_buffer_size, uint8_t ** receive_buffers, uint16_t * out_local_cids);
+
+/**
+ * @brief Decline all incoming channels reported by L2CAP_EVENT_ECBM_INCOMING_CONNECTION
+ * @param local_cid             L2CAP Channel Identifier from L2CAP_EVENT_ECBM_INCOMING_CONNECTION
+ * @param result                L2CAP result code, e.g. 0x0004 - insufficient resources available
+ */
+uint8_t l2cap_ecbm_decline_channels(uint16_t local_cid, uint16_t result);
+
+/**
+ * @brief Increase MTU of channels on the same connection by providing larger receive buffers
+ * @note L2CAP_EVENT_ECBM_RECONFIGURATION_COMPLETE is emitted for each channel, only one reconfiguration per connection at a time
+ * @param num_cids              Number of channels
+ * @param local_cids            Array of num_cids L2CAP Channel Identifiers
+ * @param receive_buffer_size   Size of each new receive buffer, equals new MTU, must not be smaller than current MTU
+ * @param receive_buffers       Array of num_cids receive buffers
+ */
+uint8_t l2cap_ecbm_reconfigure_channels(uint8_t num_cids, uint16_t * local_cids, uint16_t receive_buffer_size, uint8_t ** receive_buffers);
+
 /* API_END */
 
 /**
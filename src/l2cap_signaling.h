@@ -71,6 +71,10 @@ typedef enum {
     LE_CREDIT_BASED_CONNECTION_REQUEST,
     LE_CREDIT_BASED_CONNECTION_RESPONSE,
     LE_FLOW_CONTROL_CREDIT,
+    CREDIT_BASED_CONNECTION_REQUEST,
+    CREDIT_BASED_CONNECTION_RESPONSE,
+    CREDIT_BASED_RECONFIGURE_REQUEST,
+    CREDIT_BASED_RECONFIGURE_RESPONSE,
     COMMAND_REJECT_LE = 0x1F  // internal to BTstack
 } L2CAP_SIGNALING_COMMANDS;
 
@@ -186,6 +186,40 @@ TEST(AttDb, MtuExchange){
 }
 
 
+TEST(AttDb, handle_read_multiple_variable_request){
+	uint16_t value_handles[2];
+	uint16_t num_value_handles;
+
+	// less then two values
+	num_value_handles = 1;
+	value_handles[0] = 0x03;
+	{
+		att_request_len = att_read_multiple_request(num_value_handles, value_handles);
+		att_request[0] = ATT_READ_MULTIPLE_VARIABLE_REQUEST;
+		att_response_len = att_handle_request(&att_connection, (uint8_t *) att_request, att_request_len, att_response);
+		const uint8_t expected_response[] = {ATT_ERROR_RESPONSE, ATT_READ_MULTIPLE_VARIABLE_REQUEST, 0, 0, ATT_ERROR_INVALID_PDU};
+		CHECK_EQUAL(sizeof(expected_response), att_response_len);
+		MEMCMP_EQUAL(expected_response, att_response, att_response_len);
+	}
+
+	// static read, values prefixed with length
+	num_value_handles = 2;
+	value_handles[0] = 0x03;
+	value_handles[1] = 0x05;
+	{
+		read_callback_mode = READ_CALLBACK_MODE_RETURN_ONE_BYTE;
+
+		att_request_len = att_read_multiple_request(num_value_handles, value_handles);
+		att_request[0] = ATT_READ_MULTIPLE_VARIABLE_REQUEST;
+		att_response_len = att_handle_request(&att_connection, (uint8_t *) att_request, att_request_len, att_response);
+		const uint8_t expected_response[] = {ATT_READ_MULTIPLE_VARIABLE_RESPONSE, 0x01, 0x00, 0x64, 0x05, 0x00, 0x10, 0x06, 0x00, 0x1B, 0x2A};
+		CHECK_EQUAL(sizeof(expected_response), att_response_len);
+		MEMCMP_EQUAL(expected_response, att_response, att_response_len);
+
+		read_callback_mode = READ_CALLBACK_MODE_RETURN_DEFAULT;
+	}
+}
+
 TEST(AttDb, handle_read_multiple_request){
 	uint16_t value_handles[2];
 	uint16_t num_value_handles;
@@ -666,6 +700,29 @@ TEST(AttDb, handle_write_command){
 	}
 }
 
+TEST(AttDb, att_prepare_handle_value_multiple_notification){
+	const uint16_t attribute_handles[] = {0x0003, 0x0005, 0x0007};
+	const uint8_t value_a[] = {0x01, 0x02};
+	const uint8_t value_b[] = {0x03};
+	const uint8_t value_c[] = {0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F};
+	const uint8_t * values_data[] = {value_a, value_b, value_c};
+	const uint16_t values_len[] = {sizeof(value_a), sizeof(value_b), sizeof(value_c)};
+
+	// all tuples fit
+	{
+		att_response_len = att_prepare_handle_value_multiple_notification(&att_connection, 2, attribute_handles, values_data, values_len, att_response);
+		const uint8_t expected_response[] = {ATT_MULTIPLE_HANDLE_VALUE_NOTIFICATION, 0x03, 0x00, 0x02, 0x00, 0x01, 0x02, 0x05, 0x00, 0x01, 0x00, 0x03};
+		CHECK_EQUAL(sizeof(expected_response), att_response_len);
+		MEMCMP_EQUAL(expected_response, att_response, att_response_len);
+	}
+
+	// last tuple exceeds MTU and is not truncated
+	{
+		att_response_len = att_prepare_handle_value_multiple_notification(&att_connection, 3, attribute_handles, values_data, values_len, att_response);
+		CHECK_EQUAL(12, att_response_len);
+	}
+}
+
 TEST(AttDb, att_read_callback_handle_blob){
 	{
 		const uint8_t blob[] = {0x44, 0x55};
@@ -19,6 +19,8 @@
 #define ENABLE_LE_SIGNED_WRITE
 #define ENABLE_LE_PERIPHERAL
 #define ENABLE_LE_CENTRAL
+#define ENABLE_LE_SCAN_FILTER
+#define ENABLE_LE_EXTENDED_ADVERTISING
 #define ENABLE_SOFTWARE_AES128
 
 // BTstack configuration. buffers, sizes, ...
@@ -0,0 +1,279 @@
+// *****************************************************************************
+//
+// LE Extended Advertising Report reassembly and extended command tests
+//
+// *****************************************************************************
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/CommandLineTestRunner.h"
+
+#include "btstack_event.h"
+#include "btstack_run_loop.h"
+#include "btstack_run_loop_posix.h"
+#include "btstack_util.h"
+#include "gap.h"
+#include "hci.h"
+#include "hci_cmd.h"
+
+void le_handle_extended_advertisement_report(uint8_t * packet, uint16_t size);
+
+// event type bits
+#define EVENT_TYPE_CONNECTABLE  0x0001
+#define EVENT_TYPE_LEGACY       0x0010
+#define DATA_STATUS_INCOMPLETE  (1 << 5)
+#define DATA_STATUS_TRUNCATED   (2 << 5)
+
+static const bd_addr_t addr_a = { 0x11, 0x22, 0x33, 0x44, 0x55, 0x66 };
+static const bd_addr_t addr_b = { 0xC0, 0x01, 0x02, 0x03, 0x04, 0x05 };
+static const bd_addr_t addr_c = { 0xC0, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E };
+
+static uint8_t  adv_data[LE_EXTENDED_ADVERTISING_MAX_DATA_LEN];
+
+static int      num_legacy_reports;
+static int      num_extended_reports;
+static uint8_t  last_event[LE_EXTENDED_ADVERTISING_REPORT_HEADER_SIZE + LE_EXTENDED_ADVERTISING_MAX_DATA_LEN];
+static uint16_t last_event_size;
+// data of all GAP_EVENT_EXTENDED_ADVERTISING_REPORTs
+static uint8_t  collected_data[LE_EXTENDED_ADVERTISING_MAX_DATA_LEN];
+static uint16_t collected_data_len;
+static uint16_t first_event_type;
+
+static btstack_packet_callback_registration_t hci_event_callback_registration;
+
+static int dummy_callback(void){
+    return 0;
+}
+
+static hci_transport_t dummy_transport = {
+  /*  .transport.name                          = */  "DUMMY",
+  /*  .transport.init                          = */  NULL,
+  /*  .transport.open                          = */  NULL,
+  /*  .transport.close                         = */  NULL,
+  /*  .transport.register_packet_handler       = */  (void (*)(void (*)(uint8_t, uint8_t *, uint16_t))) dummy_callback,
+  /*  .transport.can_send_packet_now           = */  NULL,
+  /*  .transport.send_packet                   = */  NULL,
+  /*  .transport.set_baudrate                  = */  NULL,
+};
+
+static void packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
+    UNUSED(channel);
+    if (packet_type != HCI_EVENT_PACKET) return;
+    switch (hci_event_packet_get_type(packet)){
+        case GAP_EVENT_ADVERTISING_REPORT:
+            num_legacy_reports++;
+            break;
+        case GAP_EVENT_EXTENDED_ADVERTISING_REPORT:
+            num_extended_reports++;
+            if (num_extended_reports == 1){
+                first_event_type = gap_event_extended_advertising_report_get_advertising_event_type(packet);
+            }
+            memcpy(last_event, packet, size);
+            last_event_size = size;
+            CHECK_EQUAL(size - 2, packet[1]);
+            memcpy(&collected_data[collected_data_len], gap_event_extended_advertising_report_get_data(packet),
+                   gap_event_extended_advertising_report_get_data_length(packet));
+            collected_data_len += gap_event_extended_advertising_report_get_data_length(packet);
+            break;
+        default:
+            break;
+    }
+}
+
+static void send_report(uint16_t event_type, const uint8_t * addr, uint8_t sid, int8_t rssi, const uint8_t * data, uint8_t data_len){
+    uint8_t packet[4 + 24 + 255];
+    uint16_t pos = 0;
+    packet[pos++] = HCI_EVENT_LE_META;
+    packet[pos++] = 0;
+    packet[pos++] = HCI_SUBEVENT_LE_EXTENDED_ADVERTISING_REPORT;
+    packet[pos++] = 1;
+    little_endian_store_16(packet, pos, event_type);
+    pos += 2;
+    packet[pos++] = BD_ADDR_TYPE_LE_PUBLIC;
+    reverse_bd_addr(addr, &packet[pos]);
+    pos += 6;
+    packet[pos++] = 1;      // primary phy: LE 1M
+    packet[pos++] = 2;      // secondary phy: LE 2M
+    packet[pos++] = sid;
+    packet[pos++] = 0x7f;   // tx power not available
+    packet[pos++] = (uint8_t) rssi;
+    little_endian_store_16(packet, pos, 0);
+    pos += 2;
+    packet[pos++] = 0;
+    memset(&packet[pos], 0, 6);
+    pos += 6;
+    packet[pos++] = data_len;
+    memcpy(&packet[pos], data, data_len);
+    pos += data_len;
+    packet[1] = (uint8_t) (pos - 2);
+    le_handle_extended_advertisement_report(packet, pos);
+}
+
+static uint16_t create_command(uint8_t * buffer, const hci_cmd_t * cmd, ...){
+    va_list argptr;
+    va_start(argptr, cmd);
+    uint16_t size = hci_cmd_create_from_template(buffer, cmd, argptr);
+    va_end(argptr);
+    return size;
+}
+
+TEST_GROUP(LEExtendedAdvertisingReport){
+    void setup(void){
+        hci_init(&dummy_transport, NULL);
+        hci_event_callback_registration.callback = &packet_handler;
+        hci_add_event_handler(&hci_event_callback_registration);
+        num_legacy_reports = 0;
+        num_extended_reports = 0;
+        last_event_size = 0;
+        collected_data_len = 0;
+        uint16_t i;
+        for (i = 0; i < sizeof(adv_data); i++){
+            adv_data[i] = (uint8_t) i;
+        }
+    }
+    void teardown(void){
+        hci_close();
+    }
+};
+
+TEST(LEExtendedAdvertisingReport, LegacyPDU){
+    send_report(EVENT_TYPE_LEGACY | 0x03, addr_a, 0xff, -50, adv_data, 10);
+    CHECK_EQUAL(1, num_legacy_reports);
+    CHECK_EQUAL(0, num_extended_reports);
+}
+
+TEST(LEExtendedAdvertisingReport, Complete){
+    send_report(EVENT_TYPE_CONNECTABLE, addr_a, 3, -40, adv_data, 31);
+    CHECK_EQUAL(1, num_extended_reports);
+    CHECK_EQUAL(EVENT_TYPE_CONNECTABLE, gap_event_extended_advertising_report_get_advertising_event_type(last_event));
+    bd_addr_t addr;
+    gap_event_extended_advertising_report_get_address(last_event, addr);
+    MEMCMP_EQUAL(addr_a, addr, 6);
+    CHECK_EQUAL(2, gap_event_extended_advertising_report_get_secondary_phy(last_event));
+    CHECK_EQUAL(3, gap_event_extended_advertising_report_get_advertising_sid(last_event));
+    CHECK_EQUAL(-40, (int8_t) gap_event_extended_advertising_report_get_rssi(last_event));
+    CHECK_EQUAL(31, gap_event_extended_advertising_report_get_data_length(last_event));
+    MEMCMP_EQUAL(adv_data, gap_event_extended_advertising_report_get_data(last_event), 31);
+}
+
+TEST(LEExtendedAdvertisingReport, Chained){
+    send_report(EVENT_TYPE_CONNECTABLE | DATA_STATUS_INCOMPLETE, addr_a, 1, -40, &adv_data[0], 100);
+    send_report(EVENT_TYPE_CONNECTABLE | DATA_STATUS_INCOMPLETE, addr_a, 1, -41, &adv_data[100], 100);
+    CHECK_EQUAL(0, num_extended_reports);
+    send_report(EVENT_TYPE_CONNECTABLE, addr_a, 1, -42, &adv_data[200], 20);
+    CHECK_EQUAL(1, num_extended_reports);
+    CHECK_EQUAL(EVENT_TYPE_CONNECTABLE, gap_event_extended_advertising_report_get_advertising_event_type(last_event));
+    CHECK_EQUAL(-42, (int8_t) gap_event_extended_advertising_report_get_rssi(last_event));
+    CHECK_EQUAL(220, gap_event_extended_advertising_report_get_data_length(last_event));
+    CHECK_EQUAL(LE_EXTENDED_ADVERTISING_REPORT_HEADER_SIZE + 220, last_event_size);
+    MEMCMP_EQUAL(adv_data, gap_event_extended_advertising_report_get_data(last_event), 220);
+}
+
+TEST(LEExtendedAdvertisingReport, ChainedSplitIntoFragments){
+    send_report(EVENT_TYPE_CONNECTABLE | DATA_STATUS_INCOMPLETE, addr_a, 1, -40, &adv_data[0], 200);
+    send_report(EVENT_TYPE_CONNECTABLE | DATA_STATUS_INCOMPLETE, addr_a, 1, -41, &adv_data[200], 200);
+    CHECK_EQUAL(0, num_extended_reports);
+    send_report(EVENT_TYPE_CONNECTABLE, addr_a, 1, -42, &adv_data[400], 100);
+    // 230 + 230 + 40 bytes, event length field matches packet size
+    CHECK_EQUAL(3, num_extended_reports);
+    CHECK_EQUAL(EVENT_TYPE_CONNECTABLE | DATA_STATUS_INCOMPLETE, first_event_type);
+    CHECK_EQUAL(EVENT_TYPE_CONNECTABLE, gap_event_extended_advertising_report_get_advertising_event_type(last_event));
+    CHECK_EQUAL(-42, (int8_t) gap_event_extended_advertising_report_get_rssi(last_event));
+    bd_addr_t addr;
+    gap_event_extended_advertising_report_get_address(last_event, addr);
+    MEMCMP_EQUAL(addr_a, addr, 6);
+    CHECK_EQUAL(40, gap_event_extended_advertising_report_get_data_length(last_event));
+    CHECK_EQUAL(LE_EXTENDED_ADVERTISING_REPORT_HEADER_SIZE + 40, last_event_size);
+    CHECK_EQUAL(500, collected_data_len);
+    MEMCMP_EQUAL(adv_data, collected_data, 500);
+}
+
+TEST(LEExtendedAdvertisingReport, FragmentsMarkedIncomplete){
+    send_report(EVENT_TYPE_CONNECTABLE | DATA_STATUS_INCOMPLETE, addr_a, 1, -40, &adv_data[0], 200);
+    send_report(EVENT_TYPE_CONNECTABLE | DATA_STATUS_INCOMPLETE, addr_a, 1, -40, &adv_data[200], 200);
+    // truncated chain: all fragments but the last report more data
+    send_report(EVENT_TYPE_CONNECTABLE | DATA_STATUS_TRUNCATED, addr_a, 1, -40, adv_data, 0);
+    CHECK_EQUAL(2, num_extended_reports);
+    CHECK_EQUAL(EVENT_TYPE_CONNECTABLE | DATA_STATUS_INCOMPLETE, first_event_type);
+    CHECK_EQUAL(EVENT_TYPE_CONNECTABLE | DATA_STATUS_TRUNCATED, gap_event_extended_advertising_report_get_advertising_event_type(last_event));
+    CHECK_EQUAL(170, gap_event_extended_advertising_report_get_data_length(last_event));
+    CHECK_EQUAL(400, collected_data_len);
+    MEMCMP_EQUAL(adv_data, collected_data, 400);
+}
+
+TEST(LEExtendedAdvertisingReport, Interleaved){
+    send_report(EVENT_TYPE_CONNECTABLE | DATA_STATUS_INCOMPLETE, addr_a, 1, -40, &adv_data[0], 100);
+    send_report(EVENT_TYPE_CONNECTABLE | DATA_STATUS_INCOMPLETE, addr_b, 1, -40, &adv_data[0], 50);
+    send_report(EVENT_TYPE_CONNECTABLE, addr_a, 1, -40, &adv_data[100], 100);
+    CHECK_EQUAL(1, num_extended_reports);
+    CHECK_EQUAL(200, gap_event_extended_advertising_report_get_data_length(last_event));
+    send_report(EVENT_TYPE_CONNECTABLE, addr_b, 1, -40, &adv_data[50], 50);
+    CHECK_EQUAL(2, num_extended_reports);
+    bd_addr_t addr;
+    gap_event_extended_advertising_report_get_address(last_event, addr);
+    MEMCMP_EQUAL(addr_b, addr, 6);
+    CHECK_EQUAL(100, gap_event_extended_advertising_report_get_data_length(last_event));
+    MEMCMP_EQUAL(adv_data, gap_event_extended_advertising_report_get_data(last_event), 100);
+}
+
+TEST(LEExtendedAdvertisingReport, Truncated){
+    send_report(EVENT_TYPE_CONNECTABLE | DATA_STATUS_INCOMPLETE, addr_a, 1, -40, adv_data, 100);
+    send_report(EVENT_TYPE_CONNECTABLE | DATA_STATUS_TRUNCATED, addr_a, 1, -40, adv_data, 0);
+    CHECK_EQUAL(1, num_extended_reports);
+    CHECK_EQUAL(EVENT_TYPE_CONNECTABLE | DATA_STATUS_TRUNCATED, gap_event_extended_advertising_report_get_advertising_event_type(last_event));
+    CHECK_EQUAL(100, gap_event_extended_advertising_report_get_data_length(last_event));
+}
+
+TEST(LEExtendedAdvertisingReport, ReassemblyBuffersExhausted){
+    send_report(EVENT_TYPE_CONNECTABLE | DATA_STATUS_INCOMPLETE, addr_a, 1, -40, adv_data, 10);
+    send_report(EVENT_TYPE_CONNECTABLE | DATA_STATUS_INCOMPLETE, addr_b, 1, -40, adv_data, 20);
+    // oldest chain is forwarded as truncated
+    send_report(EVENT_TYPE_CONNECTABLE | DATA_STATUS_INCOMPLETE, addr_c, 1, -40, adv_data, 30);
+    CHECK_EQUAL(1, num_extended_reports);
+    bd_addr_t addr;
+    gap_event_extended_advertising_report_get_address(last_event, addr);
+    MEMCMP_EQUAL(addr_a, addr, 6);
+    CHECK_EQUAL(EVENT_TYPE_CONNECTABLE | DATA_STATUS_TRUNCATED, gap_event_extended_advertising_report_get_advertising_event_type(last_event));
+    CHECK_EQUAL(10, gap_event_extended_advertising_report_get_data_length(last_event));
+    send_report(EVENT_TYPE_CONNECTABLE, addr_c, 1, -40, adv_data, 5);
+    CHECK_EQUAL(2, num_extended_reports);
+    CHECK_EQUAL(35, gap_event_extended_advertising_report_get_data_length(last_event));
+}
+
+TEST_GROUP(LEExtendedCommands){
+};
+
+TEST(LEExtendedCommands, ScanParametersArrays){
+    uint8_t  scan_types[]     = { 0x01, 0x00 };
+    uint16_t scan_intervals[] = { 0x0030, 0x0060 };
+    uint16_t scan_windows[]   = { 0x0010, 0x0020 };
+    uint8_t  buffer[64];
+    // LE 1M and LE Coded PHY
+    uint16_t size = create_command(buffer, &hci_le_set_extended_scan_parameters, 0, 0, 0x05, scan_types, scan_intervals, scan_windows);
+    const uint8_t expected[] = {
+        0x41, 0x20, 13, 0x00, 0x00, 0x05,
+        0x01, 0x30, 0x00, 0x10, 0x00,
+        0x00, 0x60, 0x00, 0x20, 0x00,
+    };
+    CHECK_EQUAL(sizeof(expected), size);
+    MEMCMP_EQUAL(expected, buffer, sizeof(expected));
+}
+
+TEST(LEExtendedCommands, AdvertisingDataVariableLength){
+    const uint8_t data[] = { 0x02, 0x01, 0x06 };
+    uint8_t buffer[64];
+    uint16_t size = create_command(buffer, &hci_le_set_extended_advertising_data, 1, 3, 1, sizeof(data), data);
+    const uint8_t expected[] = { 0x37, 0x20, 7, 0x01, 0x03, 0x01, 0x03, 0x02, 0x01, 0x06 };
+    CHECK_EQUAL(sizeof(expected), size);
+    MEMCMP_EQUAL(expected, buffer, sizeof(expected));
+}
+
+int main (int argc, const char * argv[]){
+    btstack_run_loop_init(btstack_run_loop_posix_get_instance());
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
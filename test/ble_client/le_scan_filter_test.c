@@ -0,0 +1,203 @@
+// *****************************************************************************
+//
+// LE Scan Filter tests
+//
+// *****************************************************************************
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/CommandLineTestRunner.h"
+
+#include "bluetooth_company_id.h"
+#include "bluetooth_data_types.h"
+#include "btstack_event.h"
+#include "btstack_run_loop.h"
+#include "btstack_run_loop_posix.h"
+#include "gap.h"
+#include "hci.h"
+
+void le_handle_advertisement_report(uint8_t *packet, uint16_t size);
+
+static const bd_addr_t beacon_addr = { 0x11, 0x22, 0x33, 0x44, 0x55, 0x66 };
+static const bd_addr_t sensor_addr = { 0xC0, 0x01, 0x02, 0x03, 0x04, 0x05 };
+
+// Flags, Complete List of 16-bit UUIDs: 0x180D
+static const uint8_t sensor_adv_data[] = { 0x02, 0x01, 0x06, 0x03, 0x03, 0x0D, 0x18 };
+// Manufacturer Specific Data: Apple, iBeacon prefix 0x02 0x15
+static const uint8_t beacon_adv_data[] = { 0x02, 0x01, 0x06, 0x07, 0xFF, 0x4C, 0x00, 0x02, 0x15, 0xAA, 0xBB };
+
+static int num_advertising_reports;
+static btstack_packet_callback_registration_t hci_event_callback_registration;
+
+static int dummy_callback(void){
+    return 0;
+}
+
+static hci_transport_t dummy_transport = {
+  /*  .transport.name                          = */  "DUMMY",
+  /*  .transport.init                          = */  NULL,
+  /*  .transport.open                          = */  NULL,
+  /*  .transport.close                         = */  NULL,
+  /*  .transport.register_packet_handler       = */  (void (*)(void (*)(uint8_t, uint8_t *, uint16_t))) dummy_callback,
+  /*  .transport.can_send_packet_now           = */  NULL,
+  /*  .transport.send_packet                   = */  NULL,
+  /*  .transport.set_baudrate                  = */  NULL,
+};
+
+static void packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
+    UNUSED(channel);
+    UNUSED(size);
+    if (packet_type != HCI_EVENT_PACKET) return;
+    if (hci_event_packet_get_type(packet) != GAP_EVENT_ADVERTISING_REPORT) return;
+    num_advertising_reports++;
+}
+
+static void send_report(uint8_t event_type, const uint8_t * addr, int8_t rssi, const uint8_t * data, uint8_t data_len){
+    uint8_t packet[60];
+    uint16_t pos = 0;
+    packet[pos++] = HCI_EVENT_LE_META;
+    packet[pos++] = 0;
+    packet[pos++] = HCI_SUBEVENT_LE_ADVERTISING_REPORT;
+    packet[pos++] = 1;
+    packet[pos++] = event_type;
+    packet[pos++] = BD_ADDR_TYPE_LE_PUBLIC;
+    memcpy(&packet[pos], addr, 6);
+    pos += 6;
+    packet[pos++] = data_len;
+    memcpy(&packet[pos], data, data_len);
+    pos += data_len;
+    packet[pos++] = (uint8_t) rssi;
+    packet[1] = pos - 2;
+    le_handle_advertisement_report(packet, pos);
+}
+
+static void send_sensor_report(int8_t rssi){
+    send_report(0, sensor_addr, rssi, sensor_adv_data, sizeof(sensor_adv_data));
+}
+
+static void send_beacon_report(int8_t rssi){
+    send_report(3, beacon_addr, rssi, beacon_adv_data, sizeof(beacon_adv_data));
+}
+
+TEST_GROUP(LEScanFilter){
+    gap_le_scan_filter_t filter;
+    gap_le_scan_filter_t other_filter;
+    void setup(void){
+        hci_init(&dummy_transport, NULL);
+        hci_event_callback_registration.callback = &packet_handler;
+        hci_add_event_handler(&hci_event_callback_registration);
+        num_advertising_reports = 0;
+        memset(&filter, 0, sizeof(filter));
+        memset(&other_filter, 0, sizeof(other_filter));
+    }
+    void teardown(void){
+        hci_close();
+    }
+};
+
+TEST(LEScanFilter, NoFilters){
+    send_sensor_report(-50);
+    send_beacon_report(-50);
+    send_beacon_report(-50);
+    CHECK_EQUAL(3, num_advertising_reports);
+    uint32_t num_reports, num_dropped, num_duplicates;
+    gap_le_scan_filter_get_counters(&num_reports, &num_dropped, &num_duplicates);
+    CHECK_EQUAL(3, num_reports);
+    CHECK_EQUAL(0, num_dropped);
+    CHECK_EQUAL(0, num_duplicates);
+}
+
+TEST(LEScanFilter, Address){
+    filter.criteria = GAP_LE_SCAN_FILTER_ADDRESS;
+    filter.address_type = BD_ADDR_TYPE_LE_PUBLIC;
+    memcpy(filter.address, sensor_addr, 6);
+    gap_le_scan_filter_add(&filter);
+    send_sensor_report(-50);
+    send_beacon_report(-50);
+    CHECK_EQUAL(1, num_advertising_reports);
+    CHECK_EQUAL(1, filter.num_matches);
+}
+
+TEST(LEScanFilter, ServiceUUID16AndRSSI){
+    filter.criteria = GAP_LE_SCAN_FILTER_SERVICE_UUID16 | GAP_LE_SCAN_FILTER_RSSI;
+    filter.service_uuid16 = 0x180D;
+    filter.rssi_threshold = -70;
+    gap_le_scan_filter_add(&filter);
+    send_sensor_report(-50);
+    send_sensor_report(-80);
+    send_beacon_report(-50);
+    CHECK_EQUAL(1, num_advertising_reports);
+    CHECK_EQUAL(1, filter.num_matches);
+    uint32_t num_reports, num_dropped, num_duplicates;
+    gap_le_scan_filter_get_counters(&num_reports, &num_dropped, &num_duplicates);
+    CHECK_EQUAL(3, num_reports);
+    CHECK_EQUAL(2, num_dropped);
+}
+
+TEST(LEScanFilter, ManufacturerDataPrefix){
+    const uint8_t ibeacon_prefix[] = { 0x02, 0x15 };
+    const uint8_t other_prefix[]   = { 0x02, 0x16 };
+    const uint8_t mask[]           = { 0xff, 0xf0 };
+    filter.criteria = GAP_LE_SCAN_FILTER_MANUFACTURER_DATA;
+    filter.manufacturer_id = BLUETOOTH_COMPANY_ID_APPLE_INC;
+    filter.manufacturer_data_prefix = ibeacon_prefix;
+    filter.manufacturer_data_prefix_len = sizeof(ibeacon_prefix);
+    gap_le_scan_filter_add(&filter);
+    // masked prefix matches as well
+    other_filter.criteria = GAP_LE_SCAN_FILTER_MANUFACTURER_DATA;
+    other_filter.manufacturer_id = BLUETOOTH_COMPANY_ID_APPLE_INC;
+    other_filter.manufacturer_data_prefix = other_prefix;
+    other_filter.manufacturer_data_mask = mask;
+    other_filter.manufacturer_data_prefix_len = sizeof(other_prefix);
+    gap_le_scan_filter_add(&other_filter);
+    send_beacon_report(-50);
+    send_sensor_report(-50);
+    CHECK_EQUAL(1, num_advertising_reports);
+    CHECK_EQUAL(1, filter.num_matches);
+    CHECK_EQUAL(1, other_filter.num_matches);
+
+    // no match with different prefix without mask
+    other_filter.manufacturer_data_mask = NULL;
+    gap_le_scan_filter_remove(&filter);
+    send_beacon_report(-50);
+    CHECK_EQUAL(1, num_advertising_reports);
+    CHECK_EQUAL(1, other_filter.num_matches);
+
+    gap_le_scan_filter_reset_counters();
+    CHECK_EQUAL(0, other_filter.num_matches);
+}
+
+TEST(LEScanFilter, DuplicateWindow){
+    gap_le_scan_filter_set_duplicate_window(20);
+    send_beacon_report(-50);
+    send_beacon_report(-60);
+    send_sensor_report(-50);
+    send_sensor_report(-50);
+    CHECK_EQUAL(2, num_advertising_reports);
+    uint32_t num_reports, num_dropped, num_duplicates;
+    gap_le_scan_filter_get_counters(&num_reports, &num_dropped, &num_duplicates);
+    CHECK_EQUAL(2, num_duplicates);
+
+    // forwarded again after window
+    usleep(30000);
+    send_beacon_report(-50);
+    CHECK_EQUAL(3, num_advertising_reports);
+
+    // different event type is not a duplicate
+    send_report(0, beacon_addr, -50, beacon_adv_data, sizeof(beacon_adv_data));
+    CHECK_EQUAL(4, num_advertising_reports);
+
+    gap_le_scan_filter_set_duplicate_window(0);
+    send_beacon_report(-50);
+    CHECK_EQUAL(5, num_advertising_reports);
+}
+
+int main (int argc, const char * argv[]){
+    btstack_run_loop_init(btstack_run_loop_posix_get_instance());
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
@@ -0,0 +1,128 @@
+#include <stdint.h>
+#include <string.h>
+
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/CommandLineTestRunner.h"
+
+#include "btstack_util.h"
+#include "btstack_memory_slab.h"
+
+typedef struct {
+    btstack_linked_item_t item;
+    uint8_t data[37];
+} test_object_t;
+
+static btstack_memory_slab_t slab;
+static btstack_memory_slab_t other_slab;
+
+static int num_slabs_visited;
+
+static void count_slabs(const btstack_memory_slab_t * visited_slab, void * context){
+    UNUSED(context);
+    if (visited_slab == &slab){
+        num_slabs_visited++;
+    }
+    if (visited_slab == &other_slab){
+        num_slabs_visited++;
+    }
+}
+
+TEST_GROUP(MemorySlab){
+    void setup(void){
+        btstack_memory_slab_create(&slab, "test_object_t", sizeof(test_object_t));
+        num_slabs_visited = 0;
+    }
+    void teardown(void){
+        btstack_memory_slab_deinit(&slab);
+    }
+};
+
+TEST(MemorySlab, ObjectSize){
+    CHECK_EQUAL(0, slab.object_size % BTSTACK_MEMORY_SLAB_ALIGNMENT);
+    CHECK(slab.object_size >= sizeof(test_object_t));
+}
+
+TEST(MemorySlab, GetIsAlignedAndZeroed){
+    test_object_t * object = (test_object_t *) btstack_memory_slab_get(&slab);
+    CHECK(object != NULL);
+    CHECK_EQUAL(0, ((uintptr_t) object) % BTSTACK_MEMORY_SLAB_ALIGNMENT);
+    CHECK_EQUAL(BTSTACK_MEMORY_SLAB_OBJECTS, slab.num_objects);
+    memset(object, 0x55, sizeof(test_object_t));
+    btstack_memory_slab_free(&slab, object);
+
+    object = (test_object_t *) btstack_memory_slab_get(&slab);
+    uint8_t zeros[sizeof(test_object_t)];
+    memset(zeros, 0, sizeof(zeros));
+    MEMCMP_EQUAL(zeros, object, sizeof(test_object_t));
+    btstack_memory_slab_free(&slab, object);
+}
+
+TEST(MemorySlab, FreedObjectIsReused){
+    void * object = btstack_memory_slab_get(&slab);
+    btstack_memory_slab_free(&slab, object);
+    POINTERS_EQUAL(object, btstack_memory_slab_get(&slab));
+    btstack_memory_slab_free(&slab, object);
+    CHECK_EQUAL(BTSTACK_MEMORY_SLAB_OBJECTS, slab.num_objects);
+}
+
+TEST(MemorySlab, Grow){
+    const int num_objects = (2 * BTSTACK_MEMORY_SLAB_OBJECTS) + 1;
+    void * objects[num_objects];
+    int i;
+    for (i = 0; i < num_objects; i++){
+        objects[i] = btstack_memory_slab_get(&slab);
+        CHECK(objects[i] != NULL);
+        CHECK_EQUAL(0, ((uintptr_t) objects[i]) % BTSTACK_MEMORY_SLAB_ALIGNMENT);
+    }
+    CHECK_EQUAL(3 * BTSTACK_MEMORY_SLAB_OBJECTS, slab.num_objects);
+    // objects don't overlap
+    for (i = 0; i < num_objects; i++){
+        memset(objects[i], i, sizeof(test_object_t));
+    }
+    for (i = 0; i < num_objects; i++){
+        CHECK_EQUAL(i, ((uint8_t *) objects[i])[sizeof(test_object_t) - 1]);
+    }
+    for (i = 0; i < num_objects; i++){
+        btstack_memory_slab_free(&slab, objects[i]);
+    }
+}
+
+TEST(MemorySlab, Statistics){
+    void * a = btstack_memory_slab_get(&slab);
+    void * b = btstack_memory_slab_get(&slab);
+    btstack_memory_slab_free(&slab, a);
+    void * c = btstack_memory_slab_get(&slab);
+    CHECK_EQUAL(3, slab.num_allocations);
+    CHECK_EQUAL(2, slab.num_outstanding);
+    CHECK_EQUAL(2, slab.num_outstanding_max);
+    btstack_memory_slab_free(&slab, b);
+    btstack_memory_slab_free(&slab, c);
+    CHECK_EQUAL(0, slab.num_outstanding);
+    CHECK_EQUAL(2, slab.num_outstanding_max);
+    btstack_memory_slab_dump();
+}
+
+TEST(MemorySlab, LeakReport){
+    btstack_memory_slab_get(&slab);
+    void * object = btstack_memory_slab_get(&slab);
+    btstack_memory_slab_get(&slab);
+    btstack_memory_slab_free(&slab, object);
+    CHECK_EQUAL(2, btstack_memory_slab_deinit(&slab));
+    CHECK_EQUAL(0, slab.num_objects);
+    CHECK_EQUAL(0, btstack_memory_slab_deinit(&slab));
+}
+
+TEST(MemorySlab, ForEach){
+    btstack_memory_slab_create(&other_slab, "other_t", 4);
+    btstack_memory_slab_for_each(&count_slabs, NULL);
+    CHECK_EQUAL(2, num_slabs_visited);
+
+    btstack_memory_slab_deinit(&other_slab);
+    num_slabs_visited = 0;
+    btstack_memory_slab_for_each(&count_slabs, NULL);
+    CHECK_EQUAL(1, num_slabs_visited);
+}
+
+int main (int argc, const char * argv[]){
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
@@ -0,0 +1,22 @@
+//
+// btstack_config.h for btstack_stats test
+//
+
+#ifndef __BTSTACK_CONFIG
+#define __BTSTACK_CONFIG
+
+// Port related features
+#define HAVE_ASSERT
+#define HAVE_POSIX_TIME
+
+// BTstack features that can be enabled
+#define ENABLE_BTSTACK_STATS
+#define ENABLE_BTSTACK_STATS_TRACE
+#define ENABLE_LOG_ERROR
+#define ENABLE_LOG_INFO
+
+// BTstack configuration. buffers, sizes, ...
+#define BTSTACK_STATS_TRACE_SIZE 8
+#define HCI_ACL_PAYLOAD_SIZE 1024
+
+#endif
@@ -0,0 +1,219 @@
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/CommandLineTestRunner.h"
+
+#include <string.h>
+
+#include "btstack_stats.h"
+#include "btstack_util.h"
+
+static uint32_t test_time_us;
+
+static uint32_t test_get_time_us(void){
+    return test_time_us;
+}
+
+static btstack_stats_traffic_t test_traffic[2];
+
+static void test_for_each_traffic(btstack_stats_traffic_handler_t handler, void * context){
+    (*handler)(context, "test", 0x41, &test_traffic[0]);
+    (*handler)(context, "test", 0x42, &test_traffic[1]);
+}
+
+static btstack_stats_source_t test_source = {
+    { NULL },
+    &test_for_each_traffic
+};
+
+static int      traffic_handler_calls;
+static uint32_t traffic_handler_bytes_out;
+
+static void test_traffic_handler(void * context, const char * source, uint16_t id, const btstack_stats_traffic_t * traffic){
+    UNUSED(context);
+    STRCMP_EQUAL("test", source);
+    CHECK_EQUAL(0x41 + traffic_handler_calls, id);
+    traffic_handler_calls++;
+    traffic_handler_bytes_out += traffic->bytes_out;
+}
+
+static char output[4096];
+
+TEST_GROUP(BTstackStats){
+    void setup(void){
+        btstack_stats_reset();
+        btstack_stats_trace_clear();
+        btstack_stats_set_time_source(&test_get_time_us);
+        memset(test_traffic, 0, sizeof(test_traffic));
+        traffic_handler_calls = 0;
+        traffic_handler_bytes_out = 0;
+        test_time_us = 0;
+    }
+    void teardown(void){
+        btstack_stats_remove_source(&test_source);
+    }
+};
+
+TEST(BTstackStats, Counters){
+    BTSTACK_STATS_INCREMENT(HCI_COMMANDS_SENT);
+    BTSTACK_STATS_INCREMENT(HCI_COMMANDS_SENT);
+    BTSTACK_STATS_INCREMENT(HCI_ACL_CREDIT_STALLS);
+    const btstack_stats_t * stats = btstack_stats_get();
+    CHECK_EQUAL(2, stats->counters[BTSTACK_STATS_HCI_COMMANDS_SENT]);
+    CHECK_EQUAL(1, stats->counters[BTSTACK_STATS_HCI_ACL_CREDIT_STALLS]);
+    CHECK_EQUAL(0, stats->counters[BTSTACK_STATS_HCI_EVENTS_RECEIVED]);
+    btstack_stats_reset();
+    CHECK_EQUAL(0, stats->counters[BTSTACK_STATS_HCI_COMMANDS_SENT]);
+}
+
+TEST(BTstackStats, HciAcl){
+    BTSTACK_STATS_HCI_ACL_IN(27);
+    BTSTACK_STATS_HCI_ACL_OUT(10);
+    BTSTACK_STATS_HCI_ACL_OUT(5);
+    const btstack_stats_t * stats = btstack_stats_get();
+    CHECK_EQUAL(1,  stats->hci_acl.packets_in);
+    CHECK_EQUAL(27, stats->hci_acl.bytes_in);
+    CHECK_EQUAL(2,  stats->hci_acl.packets_out);
+    CHECK_EQUAL(15, stats->hci_acl.bytes_out);
+}
+
+TEST(BTstackStats, CryptoQueueDepth){
+    BTSTACK_STATS_CRYPTO_QUEUE_DEPTH(3);
+    BTSTACK_STATS_CRYPTO_QUEUE_DEPTH(1);
+    const btstack_stats_t * stats = btstack_stats_get();
+    CHECK_EQUAL(1, stats->crypto_queue_depth);
+    CHECK_EQUAL(3, stats->crypto_queue_depth_max);
+}
+
+TEST(BTstackStats, TimerLatency){
+    BTSTACK_STATS_TIMER_PROCESSED(2);
+    BTSTACK_STATS_TIMER_PROCESSED(7);
+    BTSTACK_STATS_TIMER_PROCESSED(0);
+    const btstack_stats_t * stats = btstack_stats_get();
+    CHECK_EQUAL(3, stats->counters[BTSTACK_STATS_RUN_LOOP_TIMERS]);
+    CHECK_EQUAL(9, stats->run_loop_timer_latency_sum_ms);
+    CHECK_EQUAL(7, stats->run_loop_timer_latency_max_ms);
+}
+
+TEST(BTstackStats, Sources){
+    BTSTACK_STATS_TRAFFIC_OUT(&test_traffic[0], 10);
+    BTSTACK_STATS_TRAFFIC_OUT(&test_traffic[1], 20);
+    BTSTACK_STATS_TRAFFIC_IN(&test_traffic[1], 5);
+    CHECK_EQUAL(1, test_traffic[1].packets_in);
+    CHECK_EQUAL(5, test_traffic[1].bytes_in);
+
+    btstack_stats_add_source(&test_source);
+    // adding twice is ignored
+    btstack_stats_add_source(&test_source);
+    btstack_stats_for_each_traffic(&test_traffic_handler, NULL);
+    CHECK_EQUAL(2, traffic_handler_calls);
+    CHECK_EQUAL(30, traffic_handler_bytes_out);
+
+    btstack_stats_remove_source(&test_source);
+    traffic_handler_calls = 0;
+    btstack_stats_for_each_traffic(&test_traffic_handler, NULL);
+    CHECK_EQUAL(0, traffic_handler_calls);
+}
+
+TEST(BTstackStats, Prometheus){
+    BTSTACK_STATS_INCREMENT(HCI_EVENTS_RECEIVED);
+    BTSTACK_STATS_HCI_ACL_IN(27);
+    BTSTACK_STATS_TRAFFIC_IN(&test_traffic[0], 3);
+    BTSTACK_STATS_TRAFFIC_IN(&test_traffic[0], 4);
+    btstack_stats_add_source(&test_source);
+
+    uint32_t len = btstack_stats_export_prometheus(output, sizeof(output));
+    CHECK_EQUAL(strlen(output), len);
+    CHECK(strstr(output, "# TYPE btstack_hci_events_received_total counter\n") != NULL);
+    CHECK(strstr(output, "\nbtstack_hci_events_received_total 1\n") != NULL);
+    CHECK(strstr(output, "\nbtstack_crypto_queue_depth 0\n") != NULL);
+    CHECK(strstr(output, "\nbtstack_bytes_in_total{source=\"hci_acl\",id=\"0\"} 27\n") != NULL);
+    CHECK(strstr(output, "\nbtstack_packets_in_total{source=\"test\",id=\"65\"} 2\n") != NULL);
+    CHECK(strstr(output, "\nbtstack_bytes_in_total{source=\"test\",id=\"65\"} 7\n") != NULL);
+    CHECK(strstr(output, "\nbtstack_bytes_in_total{source=\"test\",id=\"66\"} 0\n") != NULL);
+    // all samples of a metric follow its TYPE line
+    const char * type_bytes_in = strstr(output, "# TYPE btstack_bytes_in_total");
+    const char * type_packets_out = strstr(output, "# TYPE btstack_packets_out_total");
+    CHECK(type_bytes_in != NULL);
+    CHECK(type_packets_out > type_bytes_in);
+    CHECK(strstr(output, "btstack_bytes_in_total{source=\"test\",id=\"66\"}") < type_packets_out);
+}
+
+TEST(BTstackStats, PrometheusTruncated){
+    char small[32];
+    memset(small, 'x', sizeof(small));
+    uint32_t len = btstack_stats_export_prometheus(small, sizeof(small));
+    CHECK_EQUAL(sizeof(small) - 1, len);
+    CHECK_EQUAL(0, small[sizeof(small) - 1]);
+    CHECK_EQUAL(0, strncmp(small, "# HELP btstack_hci_commands_sent", len));
+
+    CHECK_EQUAL(0, btstack_stats_export_prometheus(small, 0));
+}
+
+TEST(BTstackStats, Trace){
+    test_time_us = 100;
+    BTSTACK_STATS_TRACE_BEGIN(L2CAP, 0x40);
+    test_time_us = 150;
+    BTSTACK_STATS_TRACE_BEGIN(L2CAP_CHANNEL, 0x41);
+    test_time_us = 170;
+    BTSTACK_STATS_TRACE_END(L2CAP_CHANNEL, 0x41);
+    BTSTACK_STATS_TRACE_END(L2CAP, 0x40);
+
+    CHECK_EQUAL(4, btstack_stats_trace_get_num_entries());
+    const btstack_stats_trace_entry_t * entry = btstack_stats_trace_get_entry(1);
+    CHECK(entry != NULL);
+    CHECK_EQUAL(150, entry->timestamp_us);
+    CHECK_EQUAL(0x41, entry->id);
+    CHECK_EQUAL(BTSTACK_STATS_TRACE_L2CAP_CHANNEL, entry->point);
+    CHECK_EQUAL(1, entry->begin);
+    entry = btstack_stats_trace_get_entry(3);
+    CHECK_EQUAL(BTSTACK_STATS_TRACE_L2CAP, entry->point);
+    CHECK_EQUAL(0, entry->begin);
+    CHECK(btstack_stats_trace_get_entry(4) == NULL);
+
+    btstack_stats_trace_clear();
+    CHECK_EQUAL(0, btstack_stats_trace_get_num_entries());
+}
+
+TEST(BTstackStats, TraceWrapAround){
+    uint16_t i;
+    for (i = 0; i < 10; i++){
+        test_time_us = i;
+        BTSTACK_STATS_TRACE_BEGIN(HCI_ACL, i);
+        BTSTACK_STATS_TRACE_END(HCI_ACL, i);
+    }
+    CHECK_EQUAL(BTSTACK_STATS_TRACE_SIZE, btstack_stats_trace_get_num_entries());
+    // oldest entries have been overwritten
+    CHECK_EQUAL(6, btstack_stats_trace_get_entry(0)->id);
+    CHECK_EQUAL(9, btstack_stats_trace_get_entry(BTSTACK_STATS_TRACE_SIZE - 1)->id);
+}
+
+TEST(BTstackStats, ChromeTrace){
+    test_time_us = 1000;
+    BTSTACK_STATS_TRACE_BEGIN(RFCOMM_CHANNEL, 3);
+    test_time_us = 1020;
+    BTSTACK_STATS_TRACE_END(RFCOMM_CHANNEL, 3);
+
+    uint32_t len = btstack_stats_export_chrome_trace(output, sizeof(output));
+    CHECK_EQUAL(strlen(output), len);
+    STRCMP_EQUAL("{\"traceEvents\":[\n"
+                 "{\"name\":\"RFCOMM Channel\",\"cat\":\"btstack\",\"ph\":\"B\",\"ts\":1000,\"pid\":1,\"tid\":1,\"args\":{\"id\":3}},\n"
+                 "{\"name\":\"RFCOMM Channel\",\"cat\":\"btstack\",\"ph\":\"E\",\"ts\":1020,\"pid\":1,\"tid\":1,\"args\":{\"id\":3}}\n"
+                 "],\"displayTimeUnit\":\"ms\"}\n", output);
+}
+
+TEST(BTstackStats, ChromeTraceSkipsUnmatchedEnd){
+    // end of overwritten begin entry
+    BTSTACK_STATS_TRACE_END(L2CAP, 0x40);
+    BTSTACK_STATS_TRACE_BEGIN(L2CAP, 0x40);
+    BTSTACK_STATS_TRACE_END(L2CAP, 0x40);
+
+    btstack_stats_export_chrome_trace(output, sizeof(output));
+    const char * first_event = strstr(output, "\"ph\":");
+    CHECK(first_event != NULL);
+    CHECK_EQUAL(0, strncmp(first_event, "\"ph\":\"B\"", 8));
+    CHECK(strstr(first_event + 1, "\"ph\":\"E\"") != NULL);
+    CHECK(strstr(strstr(first_event + 1, "\"ph\":\"E\"") + 1, "\"ph\":") == NULL);
+}
+
+int main (int argc, const char * argv[]){
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
@@ -21,6 +21,8 @@
 #include "hci_dump.h"
 #include "ble/gatt_client.h"
 #include "ble/att_db.h"
+#include "ble/le_device_db.h"
+#include "btstack_tlv.h"
 #include "profile.h"
 #include "expected_results.h"
 
@@ -64,6 +66,7 @@ uint16_t characteristic_uuid16 = 0xF000;
 
 static int result_index;
 static uint8_t result_counter;
+static int request_complete_counter;
 
 static gatt_client_service_t services[50];
 static gatt_client_service_t included_services[50];
@@ -73,6 +76,10 @@ static gatt_client_characteristic_descriptor_t descriptors[50];
 
 void mock_simulate_discover_primary_services_response(void);
 void mock_simulate_att_exchange_mtu_response(void);
+void mock_simulate_att_pdu(uint8_t * packet, uint16_t size);
+void mock_set_le_device_index(int index);
+int  mock_get_num_requests(void);
+void mock_execute_zero_timeout_timers(void);
 
 void CHECK_EQUAL_ARRAY(const uint8_t * expected, uint8_t * actual, int size){
 	for (int i=0; i<size; i++){
@@ -156,6 +163,14 @@ static void handle_ble_client_event(uint8_t packet_type, uint16_t channel, uint8
                 printf("GATT_EVENT_QUERY_COMPLETE failed with status 0x%02X\n", status);
             }
             break;
+		case GATT_EVENT_REQUEST_COMPLETE:
+			status = packet[6];
+			if (status){
+				printf("GATT_EVENT_REQUEST_COMPLETE failed with status 0x%02X\n", status);
+				break;
+			}
+			request_complete_counter++;
+			break;
 		case GATT_EVENT_SERVICE_QUERY_RESULT:
 			service.start_group_handle = little_endian_read_16(packet, 4);
 			service.end_group_handle   = little_endian_read_16(packet, 6);
@@ -700,6 +715,218 @@ TEST(GATTClient, TestWriteReliableLongCharacteristicValue){
 }
 
 
+TEST(GATTClient, TestRequestQueue){
+	test = READ_CHARACTERISTIC_VALUE;
+	reset_query_state();
+	status = gatt_client_discover_primary_services_by_uuid16(handle_ble_client_event, gatt_client_handle, service_uuid16);
+	CHECK_EQUAL(status, 0);
+	CHECK_EQUAL(gatt_query_complete, 1);
+
+	reset_query_state();
+	status = gatt_client_discover_characteristics_for_service_by_uuid16(handle_ble_client_event, gatt_client_handle, &services[0], 0xF100);
+	CHECK_EQUAL(status, 0);
+	CHECK_EQUAL(gatt_query_complete, 1);
+	CHECK_EQUAL(result_counter, 1);
+
+	gatt_client_request_t requests[3];
+	gatt_client_request_init_read_value(&requests[0], characteristics[0].value_handle);
+	gatt_client_request_init_read_value(&requests[1], characteristics[0].value_handle);
+	gatt_client_request_init_write_value(&requests[2], characteristics[0].value_handle, short_value_length, (const uint8_t*)short_value);
+
+	// both reads are combined into a single Read Multiple Variable Length Request
+	reset_query_state();
+	request_complete_counter = 0;
+	int num_requests = mock_get_num_requests();
+	status = gatt_client_request_queue_add(handle_ble_client_event, gatt_client_handle, requests, 3);
+	CHECK_EQUAL(status, 0);
+	CHECK_EQUAL(3, request_complete_counter);
+	CHECK_EQUAL(num_requests + 2, mock_get_num_requests());
+	// two value events, att_read_callback is called twice per read
+	CHECK_EQUAL(6, result_counter);
+	CHECK_EQUAL(1, gatt_client_is_ready(gatt_client_handle));
+}
+
+static int notification_counter;
+static uint16_t notification_value_handle;
+static uint16_t notification_value_length;
+
+static void handle_notification_event(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
+	if (packet[0] != GATT_EVENT_NOTIFICATION) return;
+	notification_counter++;
+	notification_value_handle = little_endian_read_16(packet, 4);
+	notification_value_length = little_endian_read_16(packet, 6);
+}
+
+TEST(GATTClient, TestMultipleHandleValueNotification){
+	gatt_client_notification_t notification;
+	gatt_client_listen_for_characteristic_value_updates(&notification, handle_notification_event, gatt_client_handle, NULL);
+	notification_counter = 0;
+
+	// two complete tuples and a truncated one
+	uint8_t packet[] = {ATT_MULTIPLE_HANDLE_VALUE_NOTIFICATION,
+		0x03, 0x00, 0x02, 0x00, 0x01, 0x02,
+		0x05, 0x00, 0x01, 0x00, 0x03,
+		0x07, 0x00, 0x05, 0x00, 0x04};
+	mock_simulate_att_pdu(packet, sizeof(packet));
+	CHECK_EQUAL(2, notification_counter);
+	CHECK_EQUAL(0x05, notification_value_handle);
+	CHECK_EQUAL(1, notification_value_length);
+
+	gatt_client_stop_listening_for_characteristic_value_updates(&notification);
+}
+
+// single entry TLV for GATT Client Cache
+static uint32_t test_tlv_tag;
+static uint32_t test_tlv_len;
+static uint8_t  test_tlv_value[1200];
+
+static int test_tlv_get_tag(void * context, uint32_t tag, uint8_t * buffer, uint32_t buffer_size){
+	if ((test_tlv_len == 0) || (tag != test_tlv_tag)) return 0;
+	uint32_t len = test_tlv_len < buffer_size ? test_tlv_len : buffer_size;
+	memcpy(buffer, test_tlv_value, len);
+	return len;
+}
+
+static int test_tlv_store_tag(void * context, uint32_t tag, const uint8_t * data, uint32_t data_size){
+	if (data_size > sizeof(test_tlv_value)) return 1;
+	test_tlv_tag = tag;
+	test_tlv_len = data_size;
+	memcpy(test_tlv_value, data, data_size);
+	return 0;
+}
+
+static void test_tlv_delete_tag(void * context, uint32_t tag){
+	if (tag != test_tlv_tag) return;
+	test_tlv_len = 0;
+}
+
+static const btstack_tlv_t test_tlv = {
+	&test_tlv_get_tag,
+	&test_tlv_store_tag,
+	&test_tlv_delete_tag,
+};
+
+TEST_GROUP(GATTClientCache){
+	int le_device_index;
+	uint8_t status;
+
+	void setup(void){
+		bd_addr_t addr = { 0x00, 0x1b, 0xdc, 0x07, 0x32, 0xef };
+		sm_key_t irk;
+		memset(irk, 0, sizeof(irk));
+		test_tlv_len = 0;
+		btstack_tlv_set_instance(&test_tlv, NULL);
+		le_device_db_init();
+		le_device_index = le_device_db_add(0, addr, irk);
+		mock_set_le_device_index(le_device_index);
+		gatt_client_cache_delete(le_device_index);
+		test = IDLE;
+	}
+
+	void teardown(void){
+		gatt_client_cache_delete(le_device_index);
+		mock_set_le_device_index(-1);
+		btstack_tlv_set_instance(NULL, NULL);
+	}
+
+	void reset_query_state(void){
+		gatt_query_complete = 0;
+		result_counter = 0;
+		result_index = 0;
+	}
+};
+
+TEST(GATTClientCache, TestDiscoverPrimaryServicesFromCache){
+	test = DISCOVER_PRIMARY_SERVICES;
+	reset_query_state();
+	status = gatt_client_discover_primary_services(handle_ble_client_event, gatt_client_handle);
+	CHECK_EQUAL(status, 0);
+	CHECK_EQUAL(gatt_query_complete, 1);
+	verify_primary_services();
+	CHECK(test_tlv_len > 0);
+
+	// second discovery is answered from cache without requests, results are reported from the run loop
+	int num_requests = mock_get_num_requests();
+	reset_query_state();
+	status = gatt_client_discover_primary_services(handle_ble_client_event, gatt_client_handle);
+	CHECK_EQUAL(status, 0);
+	CHECK_EQUAL(gatt_query_complete, 0);
+	CHECK_EQUAL(0, result_counter);
+	mock_execute_zero_timeout_timers();
+	CHECK_EQUAL(gatt_query_complete, 1);
+	verify_primary_services();
+	CHECK_EQUAL(num_requests, mock_get_num_requests());
+}
+
+TEST(GATTClientCache, TestDiscoverCharacteristicsFromCache){
+	test = DISCOVER_CHARACTERISTICS_FOR_SERVICE_WITH_UUID16;
+	reset_query_state();
+	status = gatt_client_discover_primary_services_by_uuid16(handle_ble_client_event, gatt_client_handle, service_uuid16);
+	CHECK_EQUAL(status, 0);
+	CHECK_EQUAL(gatt_query_complete, 1);
+
+	int num_requests = mock_get_num_requests();
+	reset_query_state();
+	status = gatt_client_discover_characteristics_for_service(handle_ble_client_event, gatt_client_handle, &services[0]);
+	CHECK_EQUAL(status, 0);
+	CHECK_EQUAL(gatt_query_complete, 1);
+	CHECK(mock_get_num_requests() > num_requests);
+	int num_characteristics = result_index;
+	CHECK(num_characteristics > 0);
+	gatt_client_characteristic_t first_characteristic = characteristics[0];
+
+	num_requests = mock_get_num_requests();
+	reset_query_state();
+	status = gatt_client_discover_characteristics_for_service(handle_ble_client_event, gatt_client_handle, &services[0]);
+	CHECK_EQUAL(status, 0);
+	CHECK_EQUAL(gatt_query_complete, 0);
+	mock_execute_zero_timeout_timers();
+	CHECK_EQUAL(gatt_query_complete, 1);
+	CHECK_EQUAL(num_requests, mock_get_num_requests());
+	CHECK_EQUAL(num_characteristics, result_index);
+	CHECK_EQUAL(first_characteristic.value_handle, characteristics[0].value_handle);
+	CHECK_EQUAL(first_characteristic.end_handle, characteristics[0].end_handle);
+}
+
+TEST(GATTClientCache, TestCacheDeleted){
+	test = DISCOVER_PRIMARY_SERVICES;
+	reset_query_state();
+	status = gatt_client_discover_primary_services(handle_ble_client_event, gatt_client_handle);
+	CHECK_EQUAL(status, 0);
+	CHECK_EQUAL(gatt_query_complete, 1);
+
+	gatt_client_cache_delete(le_device_index);
+	CHECK_EQUAL(0, test_tlv_len);
+
+	int num_requests = mock_get_num_requests();
+	reset_query_state();
+	status = gatt_client_discover_primary_services(handle_ble_client_event, gatt_client_handle);
+	CHECK_EQUAL(status, 0);
+	CHECK_EQUAL(gatt_query_complete, 1);
+	verify_primary_services();
+	CHECK(mock_get_num_requests() > num_requests + 1);
+}
+
+TEST(GATTClientCache, TestCacheDeletedBeforeReport){
+	test = DISCOVER_PRIMARY_SERVICES;
+	reset_query_state();
+	status = gatt_client_discover_primary_services(handle_ble_client_event, gatt_client_handle);
+	CHECK_EQUAL(status, 0);
+	CHECK_EQUAL(gatt_query_complete, 1);
+
+	// report is pending when cache gets deleted, query is sent over the air instead
+	int num_requests = mock_get_num_requests();
+	reset_query_state();
+	status = gatt_client_discover_primary_services(handle_ble_client_event, gatt_client_handle);
+	CHECK_EQUAL(status, 0);
+	CHECK_EQUAL(gatt_query_complete, 0);
+	gatt_client_cache_delete(le_device_index);
+	mock_execute_zero_timeout_timers();
+	CHECK_EQUAL(gatt_query_complete, 1);
+	verify_primary_services();
+	CHECK(mock_get_num_requests() > num_requests + 1);
+}
+
 int main (int argc, const char * argv[]){
 	att_set_db(profile_data);
 	att_set_write_callback(&att_write_callback);
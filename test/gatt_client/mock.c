@@ -18,10 +18,21 @@ static btstack_packet_handler_t att_packet_handler;
 static void (*registered_hci_event_handler) (uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size) = NULL;
 
 static btstack_linked_list_t     connections;
+static btstack_linked_list_t     timers;
 static const uint16_t max_mtu = 23;
 static uint8_t  l2cap_stack_buffer[PREBUFFER_SIZE + max_mtu];	// pre buffer + HCI Header + L2CAP header
 static uint16_t gatt_client_handle = 0x40;
 static hci_connection_t hci_connection;
+static int le_device_index = -1;
+static int num_requests;
+
+void mock_set_le_device_index(int index){
+	le_device_index = index;
+}
+
+int mock_get_num_requests(void){
+	return num_requests;
+}
 
 uint16_t get_gatt_client_handle(void){
 	return gatt_client_handle;
@@ -115,7 +126,12 @@ void l2cap_request_can_send_fix_channel_now_event(uint16_t handle, uint16_t chan
 	att_packet_handler(HCI_EVENT_PACKET, 0, (uint8_t*)event, sizeof(event));
 }
 
+void mock_simulate_att_pdu(uint8_t * packet, uint16_t size){
+	att_packet_handler(ATT_DATA_PACKET, gatt_client_handle, packet, size);
+}
+
 int l2cap_send_prepared_connectionless(uint16_t handle, uint16_t cid, uint16_t len){
+	num_requests++;
 	att_connection_t att_connection;
 	att_init_connection(&att_connection);
 	uint8_t response_buffer[PREBUFFER_SIZE + max_mtu];
@@ -137,7 +153,7 @@ void sm_cmac_signed_write_start(const sm_key_t key, uint8_t opcode, uint16_t att
 	//sm_notify_client(SM_EVENT_IDENTITY_RESOLVING_SUCCEEDED, sm_central_device_addr_type, sm_central_device_address, 0, sm_central_device_matched);      
 }
 int sm_le_device_index(uint16_t handle ){
-	return -1;
+	return le_device_index;
 }
 void sm_send_security_request(hci_con_handle_t con_handle){
 }
@@ -146,20 +162,38 @@ irk_lookup_state_t sm_identity_resolving_state(hci_con_handle_t con_handle){
 	return IRK_LOOKUP_SUCCEEDED;
 }
 void btstack_run_loop_set_timer(btstack_timer_source_t *a, uint32_t timeout_in_ms){
+	a->timeout = timeout_in_ms;
 }
 
 // Set callback that will be executed when timer expires.
 void btstack_run_loop_set_timer_handler(btstack_timer_source_t *ts, void (*process)(btstack_timer_source_t *_ts)){
+	ts->process = process;
 }
 
 // Add/Remove timer source.
 void btstack_run_loop_add_timer(btstack_timer_source_t *timer){
+	btstack_linked_list_add_tail(&timers, (btstack_linked_item_t *) timer);
 }
 
 int  btstack_run_loop_remove_timer(btstack_timer_source_t *timer){
+	btstack_linked_list_remove(&timers, (btstack_linked_item_t *) timer);
 	return 1;
 }
 
+// execute timers with zero timeout, e.g. deferred callbacks
+void mock_execute_zero_timeout_timers(void){
+	btstack_linked_list_iterator_t it;
+	btstack_linked_list_iterator_init(&it, &timers);
+	while (btstack_linked_list_iterator_has_next(&it)){
+		btstack_timer_source_t * timer = (btstack_timer_source_t *) btstack_linked_list_iterator_next(&it);
+		if (timer->timeout != 0) continue;
+		btstack_linked_list_iterator_remove(&it);
+		(*timer->process)(timer);
+		// timer list might have changed
+		btstack_linked_list_iterator_init(&it, &timers);
+	}
+}
+
 // todo:
 hci_connection_t * hci_connection_for_bd_addr_and_type(bd_addr_t addr, bd_addr_type_t addr_type){
 	printf("hci_connection_for_bd_addr_and_type not implemented in mock backend\n");
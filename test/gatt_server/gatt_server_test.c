@@ -168,6 +168,23 @@ TEST(ATT_SERVER, att_server_notify){
     CHECK_EQUAL(ERROR_CODE_SUCCESS, status);
 }
 
+TEST(ATT_SERVER, att_server_multiple_notify){
+    static uint8_t value[] = {0x55};
+    uint16_t attribute_handles[1];
+    const uint8_t * values_data[1] = { &value[0] };
+    uint16_t values_len[1] = { 1 };
+    attribute_handles[0] = gatt_server_get_value_handle_for_characteristic_with_uuid16(0, 0xffff, ORG_BLUETOOTH_CHARACTERISTIC_BATTERY_LEVEL);
+    uint8_t status;
+
+    // invalid conneciton handle
+    status = att_server_multiple_notify(0x50, 1, attribute_handles, values_data, values_len);
+    CHECK_EQUAL(ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER, status);
+
+    // client did not set Multiple Handle Value Notifications bit in Client Supported Features
+    status = att_server_multiple_notify(att_con_handle, 1, attribute_handles, values_data, values_len);
+    CHECK_EQUAL(ERROR_CODE_COMMAND_DISALLOWED, status);
+}
+
 TEST(ATT_SERVER, att_server_get_mtu){
     // invalid conneciton handle
     uint8_t mtu = att_server_get_mtu(0x50);
@@ -0,0 +1,280 @@
+// HCI ACL fragmentation over a fake asynchronous transport
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/CommandLineTestRunner.h"
+
+#include "btstack_debug.h"
+#include "btstack_event.h"
+#include "btstack_run_loop.h"
+#include "btstack_run_loop_posix.h"
+#include "btstack_util.h"
+#include "hci.h"
+#include "hci_cmd.h"
+#include "hci_transport.h"
+
+#define CONTROLLER_ACL_DATA_PACKET_LENGTH 27
+#define CONTROLLER_ACL_PACKETS_TOTAL_NUM  8
+#define MAX_ACL_PACKETS                  16
+
+static const hci_con_handle_t con_handle = 0x0040;
+
+static void (*transport_packet_handler)(uint8_t packet_type, uint8_t *packet, uint16_t size);
+static uint8_t  controller_events[2000];
+static uint16_t controller_events_len;
+
+// ACL packets received by fake controller
+static uint8_t  acl_packets[MAX_ACL_PACKETS][4 + CONTROLLER_ACL_DATA_PACKET_LENGTH];
+static uint16_t acl_packet_sizes[MAX_ACL_PACKETS];
+static uint16_t num_acl_packets;
+static uint16_t num_bogus_acl_packets;
+
+// emit HCI_EVENT_TRANSPORT_PACKET_SENT within send_packet or from fake_controller_process
+static bool     packet_sent_synchronous;
+static uint16_t num_packet_sent_pending;
+
+static uint8_t return_parameters_len_for_opcode(uint16_t opcode){
+    switch (opcode){
+        case HCI_OPCODE_HCI_READ_LOCAL_VERSION_INFORMATION:
+            return 9;
+        case HCI_OPCODE_HCI_READ_LOCAL_NAME:
+            return 249;
+        case HCI_OPCODE_HCI_READ_LOCAL_SUPPORTED_COMMANDS:
+            return 65;
+        case HCI_OPCODE_HCI_READ_BD_ADDR:
+            return 7;
+        case HCI_OPCODE_HCI_READ_BUFFER_SIZE:
+            return 8;
+        case HCI_OPCODE_HCI_READ_LOCAL_SUPPORTED_FEATURES:
+            return 9;
+        case HCI_OPCODE_HCI_LE_READ_BUFFER_SIZE:
+            return 4;
+        case HCI_OPCODE_HCI_LE_READ_WHITE_LIST_SIZE:
+            return 2;
+        default:
+            return 1;
+    }
+}
+
+static void fake_controller_queue_event(const uint8_t * event, uint16_t size){
+    btstack_assert((controller_events_len + size) <= sizeof(controller_events));
+    memcpy(&controller_events[controller_events_len], event, size);
+    controller_events_len += size;
+}
+
+static void fake_controller_handle_command(uint8_t * packet){
+    uint16_t opcode = little_endian_read_16(packet, 0);
+    uint8_t params_len = return_parameters_len_for_opcode(opcode);
+    uint8_t event[260];
+    memset(event, 0, sizeof(event));
+    event[0] = HCI_EVENT_COMMAND_COMPLETE;
+    event[1] = 3 + params_len;
+    event[2] = 1;
+    little_endian_store_16(event, 3, opcode);
+    switch (opcode){
+        case HCI_OPCODE_HCI_READ_LOCAL_SUPPORTED_FEATURES:
+            // LE Supported (Controller)
+            event[5 + 1 + 4] = 0x40;
+            break;
+        case HCI_OPCODE_HCI_LE_READ_BUFFER_SIZE:
+            little_endian_store_16(event, 6, CONTROLLER_ACL_DATA_PACKET_LENGTH);
+            event[8] = CONTROLLER_ACL_PACKETS_TOTAL_NUM;
+            break;
+        default:
+            break;
+    }
+    fake_controller_queue_event(event, 5 + params_len);
+}
+
+static void fake_controller_handle_acl(uint8_t * packet, int size){
+    // packet must be a valid ACL packet that fits into controller buffer
+    if ((size < 4) || (size > (4 + CONTROLLER_ACL_DATA_PACKET_LENGTH)) || (little_endian_read_16(packet, 2) != (size - 4))){
+        num_bogus_acl_packets++;
+        return;
+    }
+    btstack_assert(num_acl_packets < MAX_ACL_PACKETS);
+    memcpy(acl_packets[num_acl_packets], packet, size);
+    acl_packet_sizes[num_acl_packets] = size;
+    num_acl_packets++;
+}
+
+static void fake_controller_queue_le_connection_complete(void){
+    uint8_t event[21];
+    memset(event, 0, sizeof(event));
+    event[0] = HCI_EVENT_LE_META;
+    event[1] = 19;
+    event[2] = HCI_SUBEVENT_LE_CONNECTION_COMPLETE;
+    little_endian_store_16(event, 4, con_handle);
+    event[6] = HCI_ROLE_SLAVE;
+    event[7] = BD_ADDR_TYPE_LE_PUBLIC;
+    fake_controller_queue_event(event, sizeof(event));
+}
+
+static void fake_controller_queue_number_of_completed_packets(uint16_t num_packets){
+    uint8_t event[7];
+    event[0] = HCI_EVENT_NUMBER_OF_COMPLETED_PACKETS;
+    event[1] = 5;
+    event[2] = 1;
+    little_endian_store_16(event, 3, con_handle);
+    little_endian_store_16(event, 5, num_packets);
+    fake_controller_queue_event(event, sizeof(event));
+}
+
+static void fake_transport_emit_packet_sent(void){
+    uint8_t event[] = { HCI_EVENT_TRANSPORT_PACKET_SENT, 0};
+    (*transport_packet_handler)(HCI_EVENT_PACKET, event, sizeof(event));
+}
+
+static void fake_controller_process(void){
+    while ((controller_events_len > 0) || (num_packet_sent_pending > 0)){
+        if (num_packet_sent_pending > 0){
+            num_packet_sent_pending--;
+            fake_transport_emit_packet_sent();
+            continue;
+        }
+        uint8_t event[260];
+        uint16_t event_size = 2 + controller_events[1];
+        memcpy(event, controller_events, event_size);
+        controller_events_len -= event_size;
+        memmove(controller_events, &controller_events[event_size], controller_events_len);
+        (*transport_packet_handler)(HCI_EVENT_PACKET, event, event_size);
+    }
+}
+
+static void fake_transport_init(const void * transport_config){
+    UNUSED(transport_config);
+}
+
+static int fake_transport_open(void){
+    return 0;
+}
+
+static int fake_transport_close(void){
+    return 0;
+}
+
+static void fake_transport_register_packet_handler(void (*handler)(uint8_t packet_type, uint8_t *packet, uint16_t size)){
+    transport_packet_handler = handler;
+}
+
+static int fake_transport_can_send_packet_now(uint8_t packet_type){
+    UNUSED(packet_type);
+    return 1;
+}
+
+static int fake_transport_send_packet(uint8_t packet_type, uint8_t *packet, int size){
+    switch (packet_type){
+        case HCI_COMMAND_DATA_PACKET:
+            fake_controller_handle_command(packet);
+            break;
+        case HCI_ACL_DATA_PACKET:
+            fake_controller_handle_acl(packet, size);
+            break;
+        default:
+            break;
+    }
+    if (packet_sent_synchronous){
+        fake_transport_emit_packet_sent();
+    } else {
+        num_packet_sent_pending++;
+    }
+    return 0;
+}
+
+// asynchronous transport: provides can_send_packet_now and emits HCI_EVENT_TRANSPORT_PACKET_SENT
+static const hci_transport_t fake_transport = {
+    "FAKE-ASYNC", &fake_transport_init, &fake_transport_open, &fake_transport_close,
+    &fake_transport_register_packet_handler, &fake_transport_can_send_packet_now, &fake_transport_send_packet, NULL, NULL, NULL
+};
+
+static void send_l2cap_pdu(uint16_t payload_len){
+    CHECK_EQUAL(1, hci_reserve_packet_buffer());
+    uint8_t * acl_buffer = hci_get_outgoing_packet_buffer();
+    // first automatically flushable packet
+    little_endian_store_16(acl_buffer, 0, con_handle | (2u << 12));
+    little_endian_store_16(acl_buffer, 2, payload_len);
+    uint16_t i;
+    for (i = 0; i < payload_len; i++){
+        acl_buffer[4 + i] = (uint8_t) i;
+    }
+    hci_send_acl_packet_buffer(4 + payload_len);
+}
+
+static void check_fragments(uint16_t payload_len){
+    CHECK_EQUAL(0, num_bogus_acl_packets);
+    uint16_t num_expected = (payload_len + CONTROLLER_ACL_DATA_PACKET_LENGTH - 1) / CONTROLLER_ACL_DATA_PACKET_LENGTH;
+    CHECK_EQUAL(num_expected, num_acl_packets);
+    uint16_t offset = 0;
+    uint16_t i;
+    for (i = 0; i < num_acl_packets; i++){
+        uint16_t handle_and_flags = little_endian_read_16(acl_packets[i], 0);
+        CHECK_EQUAL(con_handle, handle_and_flags & 0x0fff);
+        // packet boundary flag: first, then continuing fragments
+        CHECK_EQUAL(i == 0 ? 2 : 1, (handle_and_flags >> 12) & 0x03);
+        uint16_t fragment_len = btstack_min(CONTROLLER_ACL_DATA_PACKET_LENGTH, payload_len - offset);
+        CHECK_EQUAL(4 + fragment_len, acl_packet_sizes[i]);
+        uint16_t j;
+        for (j = 0; j < fragment_len; j++){
+            CHECK_EQUAL((uint8_t) (offset + j), acl_packets[i][4 + j]);
+        }
+        offset += fragment_len;
+    }
+}
+
+TEST_GROUP(HCI_ACL_FRAGMENTATION){
+    void setup(void){
+        controller_events_len = 0;
+        num_acl_packets = 0;
+        num_bogus_acl_packets = 0;
+        num_packet_sent_pending = 0;
+        packet_sent_synchronous = false;
+        hci_init(&fake_transport, NULL);
+        hci_power_control(HCI_POWER_ON);
+        fake_controller_process();
+        CHECK_EQUAL(HCI_STATE_WORKING, hci_get_state());
+        fake_controller_queue_le_connection_complete();
+        fake_controller_process();
+        CHECK(hci_connection_for_handle(con_handle) != NULL);
+    }
+    void teardown(void){
+        hci_close();
+    }
+};
+
+TEST(HCI_ACL_FRAGMENTATION, PacketSentFromRunLoop){
+    send_l2cap_pdu(100);
+    fake_controller_process();
+    check_fragments(100);
+    CHECK_EQUAL(0, hci_is_packet_buffer_reserved());
+}
+
+TEST(HCI_ACL_FRAGMENTATION, PacketSentWithinSendPacket){
+    packet_sent_synchronous = true;
+    send_l2cap_pdu(100);
+    fake_controller_process();
+    check_fragments(100);
+    CHECK_EQUAL(0, hci_is_packet_buffer_reserved());
+}
+
+TEST(HCI_ACL_FRAGMENTATION, PacketSentWithinSendPacketOutOfBuffers){
+    packet_sent_synchronous = true;
+    // 10 fragments, but controller only has 8 buffers
+    uint16_t payload_len = 10 * CONTROLLER_ACL_DATA_PACKET_LENGTH;
+    send_l2cap_pdu(payload_len);
+    fake_controller_process();
+    CHECK_EQUAL(CONTROLLER_ACL_PACKETS_TOTAL_NUM, num_acl_packets);
+    CHECK_EQUAL(1, hci_is_packet_buffer_reserved());
+    fake_controller_queue_number_of_completed_packets(CONTROLLER_ACL_PACKETS_TOTAL_NUM);
+    fake_controller_process();
+    check_fragments(payload_len);
+    CHECK_EQUAL(0, hci_is_packet_buffer_reserved());
+}
+
+int main (int argc, const char * argv[]){
+    btstack_run_loop_init(btstack_run_loop_posix_get_instance());
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
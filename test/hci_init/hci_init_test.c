@@ -0,0 +1,380 @@
+// HCI init with chipset init script over H4 and a fake UART
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/CommandLineTestRunner.h"
+
+#include "btstack_chipset.h"
+#include "btstack_debug.h"
+#include "btstack_run_loop.h"
+#include "btstack_run_loop_posix.h"
+#include "btstack_uart_block.h"
+#include "btstack_util.h"
+#include "hci.h"
+#include "hci_cmd.h"
+#include "hci_dump.h"
+#include "hci_transport.h"
+
+#define INIT_BAUDRATE  115200
+#define MAIN_BAUDRATE  921600
+
+#define SCRIPT_NUM_COMMANDS 10
+#define SCRIPT_OPCODE_BASE  0xfc40
+#define BAUDRATE_OPCODE     0xfc18
+
+#define MAX_SENT_COMMANDS   100
+
+// fake UART
+
+static void (*uart_block_received)(void);
+static void (*uart_block_sent)(void);
+static uint8_t * uart_rx_buffer;
+static uint16_t  uart_rx_len;
+static int       uart_tx_pending;
+static uint32_t  uart_baudrate;
+
+// bytes sent from controller to host
+static uint8_t   uart_rx_data[10000];
+static uint16_t  uart_rx_data_len;
+static uint16_t  uart_rx_data_pos;
+
+// fake controller
+typedef struct {
+    uint16_t opcode;
+    uint32_t baudrate;
+} sent_command_t;
+
+static sent_command_t sent_commands[MAX_SENT_COMMANDS];
+static uint16_t num_sent_commands;
+static uint16_t num_completed_commands;
+static uint16_t max_commands_in_flight;
+static uint16_t max_script_commands_in_flight;
+static uint16_t script_commands_in_flight;
+// number of command buffers in controller
+static uint8_t  controller_num_cmd_packets;
+
+// commands wait for Command Complete
+static uint16_t pending_opcodes[MAX_SENT_COMMANDS];
+static uint16_t num_pending_opcodes;
+
+static int fake_uart_init(const btstack_uart_config_t * config){
+    uart_baudrate = config->baudrate;
+    return 0;
+}
+
+static int fake_uart_open(void){
+    return 0;
+}
+
+static int fake_uart_close(void){
+    return 0;
+}
+
+static void fake_uart_set_block_received(void (*handler)(void)){
+    uart_block_received = handler;
+}
+
+static void fake_uart_set_block_sent(void (*handler)(void)){
+    uart_block_sent = handler;
+}
+
+static int fake_uart_set_baudrate(uint32_t baudrate){
+    uart_baudrate = baudrate;
+    return 0;
+}
+
+static int fake_uart_set_parity(int parity){
+    UNUSED(parity);
+    return 0;
+}
+
+static int fake_uart_set_flowcontrol(int flowcontrol){
+    UNUSED(flowcontrol);
+    return 0;
+}
+
+static void fake_uart_receive_block(uint8_t * buffer, uint16_t len){
+    uart_rx_buffer = buffer;
+    uart_rx_len = len;
+}
+
+static void fake_uart_send_block(const uint8_t * data, uint16_t size){
+    btstack_assert(data[0] == HCI_COMMAND_DATA_PACKET);
+    btstack_assert(size >= 4);
+    btstack_assert(num_sent_commands < MAX_SENT_COMMANDS);
+    uint16_t opcode = little_endian_read_16(data, 1);
+    sent_commands[num_sent_commands].opcode = opcode;
+    sent_commands[num_sent_commands].baudrate = uart_baudrate;
+    num_sent_commands++;
+    pending_opcodes[num_pending_opcodes++] = opcode;
+
+    uint16_t in_flight = num_sent_commands - num_completed_commands;
+    max_commands_in_flight = btstack_max(max_commands_in_flight, in_flight);
+    if ((opcode & 0xfff0) == SCRIPT_OPCODE_BASE){
+        script_commands_in_flight++;
+        max_script_commands_in_flight = btstack_max(max_script_commands_in_flight, script_commands_in_flight);
+    }
+    uart_tx_pending = 1;
+}
+
+static int fake_uart_get_supported_sleep_modes(void){
+    return 0;
+}
+
+static void fake_uart_set_sleep(btstack_uart_sleep_mode_t sleep_mode){
+    UNUSED(sleep_mode);
+}
+
+static void fake_uart_set_wakeup_handler(void (*handler)(void)){
+    UNUSED(handler);
+}
+
+static const btstack_uart_block_t fake_uart = {
+    /* int  (*init)(hci_transport_config_uart_t * config); */         &fake_uart_init,
+    /* int  (*open)(void); */                                         &fake_uart_open,
+    /* int  (*close)(void); */                                        &fake_uart_close,
+    /* void (*set_block_received)(void (*handler)(void)); */          &fake_uart_set_block_received,
+    /* void (*set_block_sent)(void (*handler)(void)); */              &fake_uart_set_block_sent,
+    /* int  (*set_baudrate)(uint32_t baudrate); */                    &fake_uart_set_baudrate,
+    /* int  (*set_parity)(int parity); */                             &fake_uart_set_parity,
+    /* int  (*set_flowcontrol)(int flowcontrol); */                   &fake_uart_set_flowcontrol,
+    /* void (*receive_block)(uint8_t *buffer, uint16_t len); */       &fake_uart_receive_block,
+    /* void (*send_block)(const uint8_t *buffer, uint16_t length); */ &fake_uart_send_block,
+    /* int (*get_supported_sleep_modes); */                           &fake_uart_get_supported_sleep_modes,
+    /* void (*set_sleep)(btstack_uart_sleep_mode_t sleep_mode); */    &fake_uart_set_sleep,
+    /* void (*set_wakeup_handler)(void (*handler)(void)); */          &fake_uart_set_wakeup_handler,
+};
+
+static uint8_t return_parameters_len_for_opcode(uint16_t opcode){
+    switch (opcode){
+        case HCI_OPCODE_HCI_READ_LOCAL_VERSION_INFORMATION:
+            return 9;
+        case HCI_OPCODE_HCI_READ_LOCAL_NAME:
+            return 249;
+        case HCI_OPCODE_HCI_READ_LOCAL_SUPPORTED_COMMANDS:
+            return 65;
+        case HCI_OPCODE_HCI_READ_BD_ADDR:
+            return 7;
+        case HCI_OPCODE_HCI_READ_BUFFER_SIZE:
+            return 8;
+        case HCI_OPCODE_HCI_READ_LOCAL_SUPPORTED_FEATURES:
+            return 9;
+        case HCI_OPCODE_HCI_LE_READ_BUFFER_SIZE:
+            return 4;
+        case HCI_OPCODE_HCI_LE_READ_WHITE_LIST_SIZE:
+            return 2;
+        default:
+            return 1;
+    }
+}
+
+// queue Command Complete for oldest pending command
+static void fake_controller_complete_command(void){
+    uint16_t opcode = pending_opcodes[0];
+    num_pending_opcodes--;
+    memmove(&pending_opcodes[0], &pending_opcodes[1], num_pending_opcodes * sizeof(uint16_t));
+
+    uint8_t params_len = return_parameters_len_for_opcode(opcode);
+    uint8_t * event = &uart_rx_data[uart_rx_data_len];
+    memset(event, 0, 6 + params_len);
+    event[0] = HCI_EVENT_PACKET;
+    event[1] = HCI_EVENT_COMMAND_COMPLETE;
+    event[2] = 3 + params_len;
+    // free command buffers after this command
+    event[3] = controller_num_cmd_packets - (num_sent_commands - num_completed_commands - 1);
+    little_endian_store_16(event, 4, opcode);
+    // status = 0
+    switch (opcode){
+        case HCI_OPCODE_HCI_READ_LOCAL_SUPPORTED_FEATURES:
+            // LE Supported (Controller)
+            event[6 + 1 + 4] = 0x40;
+            break;
+        case HCI_OPCODE_HCI_READ_BUFFER_SIZE:
+            little_endian_store_16(event, 7, 1021);
+            event[11] = 4;
+            break;
+        default:
+            break;
+    }
+    uart_rx_data_len += 6 + params_len;
+
+    num_completed_commands++;
+    if ((opcode & 0xfff0) == SCRIPT_OPCODE_BASE){
+        script_commands_in_flight--;
+    }
+}
+
+// deliver sent notifications first, then complete one command at a time
+static void fake_uart_process(void){
+    int iterations = 0;
+    while (iterations++ < 10000){
+        if (uart_tx_pending){
+            uart_tx_pending = 0;
+            (*uart_block_sent)();
+            continue;
+        }
+        if ((uart_rx_len > 0) && ((uart_rx_data_len - uart_rx_data_pos) >= uart_rx_len)){
+            uint16_t len = uart_rx_len;
+            uart_rx_len = 0;
+            memcpy(uart_rx_buffer, &uart_rx_data[uart_rx_data_pos], len);
+            uart_rx_data_pos += len;
+            (*uart_block_received)();
+            continue;
+        }
+        if (num_pending_opcodes > 0){
+            fake_controller_complete_command();
+            continue;
+        }
+        break;
+    }
+}
+
+// fake chipset
+
+static uint16_t script_pos;
+
+static void fake_chipset_init(const void * config){
+    UNUSED(config);
+    script_pos = 0;
+}
+
+static btstack_chipset_result_t fake_chipset_next_command(uint8_t * hci_cmd_buffer){
+    if (script_pos >= SCRIPT_NUM_COMMANDS) return BTSTACK_CHIPSET_DONE;
+    little_endian_store_16(hci_cmd_buffer, 0, SCRIPT_OPCODE_BASE + (script_pos & 0x0f));
+    hci_cmd_buffer[2] = 4;
+    little_endian_store_32(hci_cmd_buffer, 3, script_pos);
+    script_pos++;
+    return BTSTACK_CHIPSET_VALID_COMMAND;
+}
+
+static void fake_chipset_set_baudrate_command(uint32_t baudrate, uint8_t * hci_cmd_buffer){
+    little_endian_store_16(hci_cmd_buffer, 0, BAUDRATE_OPCODE);
+    hci_cmd_buffer[2] = 4;
+    little_endian_store_32(hci_cmd_buffer, 3, baudrate);
+}
+
+static btstack_chipset_t fake_chipset = {
+    "FAKE",
+    fake_chipset_init,
+    fake_chipset_next_command,
+    fake_chipset_set_baudrate_command,
+    NULL,
+    0,
+};
+
+static const hci_transport_config_uart_t config = {
+    HCI_TRANSPORT_CONFIG_UART,
+    INIT_BAUDRATE,
+    MAIN_BAUDRATE,
+    1,
+    NULL,
+};
+
+static int index_of_opcode(uint16_t opcode){
+    int i;
+    for (i=0;i<num_sent_commands;i++){
+        if (sent_commands[i].opcode == opcode) return i;
+    }
+    return -1;
+}
+
+static int count_script_commands(void){
+    int count = 0;
+    int i;
+    for (i=0;i<num_sent_commands;i++){
+        if ((sent_commands[i].opcode & 0xfff0) == SCRIPT_OPCODE_BASE) count++;
+    }
+    return count;
+}
+
+TEST_GROUP(HCI_INIT){
+    void setup(void){
+        uart_rx_len = 0;
+        uart_tx_pending = 0;
+        uart_rx_data_len = 0;
+        uart_rx_data_pos = 0;
+        num_sent_commands = 0;
+        num_completed_commands = 0;
+        num_pending_opcodes = 0;
+        max_commands_in_flight = 0;
+        max_script_commands_in_flight = 0;
+        script_commands_in_flight = 0;
+        controller_num_cmd_packets = 4;
+        fake_chipset.init_script_pipeline_depth = 0;
+        hci_init(hci_transport_h4_instance(&fake_uart), &config);
+        hci_set_chipset(&fake_chipset);
+    }
+    void power_on(void){
+        hci_power_control(HCI_POWER_ON);
+        fake_uart_process();
+    }
+    void check_init_script_after_baudrate_change(void){
+        int baudrate_index = index_of_opcode(BAUDRATE_OPCODE);
+        int script_index = index_of_opcode(SCRIPT_OPCODE_BASE);
+        CHECK(baudrate_index >= 0);
+        CHECK(script_index > baudrate_index);
+        CHECK_EQUAL(INIT_BAUDRATE, sent_commands[baudrate_index].baudrate);
+        int i;
+        for (i=script_index; i<num_sent_commands; i++){
+            CHECK_EQUAL(MAIN_BAUDRATE, sent_commands[i].baudrate);
+        }
+    }
+};
+
+TEST(HCI_INIT, InitScriptSequential){
+    power_on();
+    CHECK_EQUAL(HCI_STATE_WORKING, hci_get_state());
+    CHECK_EQUAL(SCRIPT_NUM_COMMANDS, count_script_commands());
+    CHECK_EQUAL(1, max_script_commands_in_flight);
+    check_init_script_after_baudrate_change();
+}
+
+TEST(HCI_INIT, InitScriptPipelined){
+    fake_chipset.init_script_pipeline_depth = 4;
+    power_on();
+    CHECK_EQUAL(HCI_STATE_WORKING, hci_get_state());
+    CHECK_EQUAL(SCRIPT_NUM_COMMANDS, count_script_commands());
+    CHECK_EQUAL(4, max_script_commands_in_flight);
+    check_init_script_after_baudrate_change();
+    // script completed before next init command
+    int last_script_index = index_of_opcode(SCRIPT_OPCODE_BASE + SCRIPT_NUM_COMMANDS - 1);
+    CHECK_EQUAL(last_script_index + 1, index_of_opcode(HCI_OPCODE_HCI_READ_LOCAL_SUPPORTED_COMMANDS));
+}
+
+TEST(HCI_INIT, InitScriptPipelinedLimitedByCredits){
+    fake_chipset.init_script_pipeline_depth = 4;
+    controller_num_cmd_packets = 2;
+    power_on();
+    CHECK_EQUAL(HCI_STATE_WORKING, hci_get_state());
+    CHECK_EQUAL(SCRIPT_NUM_COMMANDS, count_script_commands());
+    CHECK_EQUAL(2, max_script_commands_in_flight);
+}
+
+TEST(HCI_INIT, InitScriptPipelinedSingleCredit){
+    fake_chipset.init_script_pipeline_depth = 4;
+    controller_num_cmd_packets = 1;
+    power_on();
+    CHECK_EQUAL(HCI_STATE_WORKING, hci_get_state());
+    CHECK_EQUAL(SCRIPT_NUM_COMMANDS, count_script_commands());
+    CHECK_EQUAL(1, max_script_commands_in_flight);
+}
+
+TEST(HCI_INIT, ConfigurationPipelined){
+    power_on();
+    CHECK_EQUAL(HCI_STATE_WORKING, hci_get_state());
+    CHECK(max_commands_in_flight > 1);
+    // all commands completed
+    CHECK_EQUAL(num_sent_commands, num_completed_commands);
+    // event mask sent after features have been read
+    CHECK(index_of_opcode(HCI_OPCODE_HCI_SET_EVENT_MASK) > index_of_opcode(HCI_OPCODE_HCI_READ_LOCAL_SUPPORTED_FEATURES));
+    CHECK(index_of_opcode(HCI_OPCODE_HCI_LE_SET_SCAN_PARAMETERS) >= 0);
+}
+
+int main (int argc, const char * argv[]){
+    btstack_run_loop_init(btstack_run_loop_posix_get_instance());
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
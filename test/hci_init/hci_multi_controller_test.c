@@ -0,0 +1,493 @@
+// HCI with multiple Controllers using fake synchronous transports
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/CommandLineTestRunner.h"
+
+#include "btstack_debug.h"
+#include "btstack_event.h"
+#include "btstack_run_loop.h"
+#include "btstack_run_loop_posix.h"
+#include "btstack_util.h"
+#include "ble/att_db.h"
+#include "gap.h"
+#include "hci.h"
+#include "hci_cmd.h"
+#include "hci_transport.h"
+#include "l2cap.h"
+
+#define NUM_CONTROLLERS 2
+
+// fake controller
+typedef struct {
+    void (*packet_handler)(uint8_t packet_type, uint8_t *packet, uint16_t size);
+    uint8_t  events[2000];
+    uint16_t events_len;
+    uint16_t num_commands;
+    // ACL packets sent by host
+    uint16_t num_acl_packets;
+    uint8_t  acl_packet[100];
+    uint16_t acl_packet_len;
+    // events received by application
+    uint16_t num_working_events;
+    uint16_t num_events_with_other_controller_selected;
+} fake_controller_t;
+
+static fake_controller_t fake_controllers[NUM_CONTROLLERS];
+
+static uint8_t return_parameters_len_for_opcode(uint16_t opcode){
+    switch (opcode){
+        case HCI_OPCODE_HCI_READ_LOCAL_VERSION_INFORMATION:
+            return 9;
+        case HCI_OPCODE_HCI_READ_LOCAL_NAME:
+            return 249;
+        case HCI_OPCODE_HCI_READ_LOCAL_SUPPORTED_COMMANDS:
+            return 65;
+        case HCI_OPCODE_HCI_READ_BD_ADDR:
+            return 7;
+        case HCI_OPCODE_HCI_READ_BUFFER_SIZE:
+            return 8;
+        case HCI_OPCODE_HCI_READ_LOCAL_SUPPORTED_FEATURES:
+            return 9;
+        case HCI_OPCODE_HCI_LE_READ_BUFFER_SIZE:
+            return 4;
+        case HCI_OPCODE_HCI_LE_READ_WHITE_LIST_SIZE:
+            return 2;
+        default:
+            return 1;
+    }
+}
+
+static void fake_controller_queue_event(fake_controller_t * controller, const uint8_t * event, uint16_t size){
+    btstack_assert((controller->events_len + size) <= sizeof(controller->events));
+    memcpy(&controller->events[controller->events_len], event, size);
+    controller->events_len += size;
+}
+
+static void fake_controller_send_packet(uint8_t controller_index, uint8_t packet_type, uint8_t * packet, int size){
+    UNUSED(size);
+    fake_controller_t * controller = &fake_controllers[controller_index];
+    if (packet_type == HCI_ACL_DATA_PACKET){
+        controller->num_acl_packets++;
+        controller->acl_packet_len = btstack_min(size, sizeof(controller->acl_packet));
+        memcpy(controller->acl_packet, packet, controller->acl_packet_len);
+        // Number Of Completed Packets
+        uint8_t event[7];
+        event[0] = HCI_EVENT_NUMBER_OF_COMPLETED_PACKETS;
+        event[1] = 5;
+        event[2] = 1;
+        little_endian_store_16(event, 3, little_endian_read_16(packet, 0) & 0x0fff);
+        little_endian_store_16(event, 5, 1);
+        fake_controller_queue_event(controller, event, sizeof(event));
+        return;
+    }
+    if (packet_type != HCI_COMMAND_DATA_PACKET) return;
+    controller->num_commands++;
+
+    uint16_t opcode = little_endian_read_16(packet, 0);
+    uint8_t params_len = return_parameters_len_for_opcode(opcode);
+    uint8_t event[260];
+    memset(event, 0, sizeof(event));
+    event[0] = HCI_EVENT_COMMAND_COMPLETE;
+    event[1] = 3 + params_len;
+    event[2] = 1;
+    little_endian_store_16(event, 3, opcode);
+    switch (opcode){
+        case HCI_OPCODE_HCI_READ_BD_ADDR:
+            // BD_ADDR 00:00:00:00:00:<controller index + 1>
+            event[6] = controller_index + 1;
+            break;
+        case HCI_OPCODE_HCI_READ_LOCAL_SUPPORTED_FEATURES:
+            // LE Supported (Controller)
+            event[5 + 1 + 4] = 0x40;
+            break;
+        case HCI_OPCODE_HCI_READ_BUFFER_SIZE:
+            little_endian_store_16(event, 6, 1021);
+            event[9] = 4;
+            break;
+        case HCI_OPCODE_HCI_LE_READ_BUFFER_SIZE:
+            little_endian_store_16(event, 6, 251);
+            event[8] = 4;
+            break;
+        default:
+            break;
+    }
+    fake_controller_queue_event(controller, event, 5 + params_len);
+}
+
+static void fake_controller_queue_le_connection_complete(uint8_t controller_index, hci_con_handle_t con_handle){
+    uint8_t event[21];
+    memset(event, 0, sizeof(event));
+    event[0] = HCI_EVENT_LE_META;
+    event[1] = 19;
+    event[2] = HCI_SUBEVENT_LE_CONNECTION_COMPLETE;
+    little_endian_store_16(event, 4, con_handle);
+    event[6] = HCI_ROLE_SLAVE;
+    event[7] = BD_ADDR_TYPE_LE_PUBLIC;
+    event[8] = (uint8_t) con_handle;
+    fake_controller_queue_event(&fake_controllers[controller_index], event, sizeof(event));
+}
+
+static void fake_controller_queue_disconnection_complete(uint8_t controller_index, hci_con_handle_t con_handle){
+    uint8_t event[6];
+    event[0] = HCI_EVENT_DISCONNECTION_COMPLETE;
+    event[1] = 4;
+    event[2] = ERROR_CODE_SUCCESS;
+    little_endian_store_16(event, 3, con_handle);
+    event[5] = ERROR_CODE_REMOTE_USER_TERMINATED_CONNECTION;
+    fake_controller_queue_event(&fake_controllers[controller_index], event, sizeof(event));
+}
+
+// deliver L2CAP PDU from remote directly
+static void fake_controller_receive_l2cap_pdu(uint8_t controller_index, hci_con_handle_t con_handle, uint16_t cid, const uint8_t * payload, uint16_t len){
+    uint8_t buffer[HCI_INCOMING_PRE_BUFFER_SIZE + 100];
+    uint8_t * packet = &buffer[HCI_INCOMING_PRE_BUFFER_SIZE];
+    btstack_assert((8 + len) <= 100);
+    little_endian_store_16(packet, 0, con_handle | 0x2000);
+    little_endian_store_16(packet, 2, 4 + len);
+    little_endian_store_16(packet, 4, len);
+    little_endian_store_16(packet, 6, cid);
+    memcpy(&packet[8], payload, len);
+    (*fake_controllers[controller_index].packet_handler)(HCI_ACL_DATA_PACKET, packet, 8 + len);
+}
+
+// deliver one event per controller at a time
+static void fake_controllers_process(void){
+    bool delivered = true;
+    while (delivered){
+        delivered = false;
+        uint8_t i;
+        for (i = 0; i < NUM_CONTROLLERS; i++){
+            fake_controller_t * controller = &fake_controllers[i];
+            if (controller->events_len == 0) continue;
+            uint8_t event[260];
+            uint16_t event_size = 2 + controller->events[1];
+            memcpy(event, controller->events, event_size);
+            controller->events_len -= event_size;
+            memmove(controller->events, &controller->events[event_size], controller->events_len);
+            (*controller->packet_handler)(HCI_EVENT_PACKET, event, event_size);
+            delivered = true;
+        }
+    }
+}
+
+static void fake_transport_init(const void * transport_config){
+    UNUSED(transport_config);
+}
+
+static int fake_transport_open(void){
+    return 0;
+}
+
+static int fake_transport_close(void){
+    return 0;
+}
+
+static void fake_transport_0_register_packet_handler(void (*handler)(uint8_t packet_type, uint8_t *packet, uint16_t size)){
+    fake_controllers[0].packet_handler = handler;
+}
+
+static void fake_transport_1_register_packet_handler(void (*handler)(uint8_t packet_type, uint8_t *packet, uint16_t size)){
+    fake_controllers[1].packet_handler = handler;
+}
+
+static int fake_transport_0_send_packet(uint8_t packet_type, uint8_t *packet, int size){
+    fake_controller_send_packet(0, packet_type, packet, size);
+    return 0;
+}
+
+static int fake_transport_1_send_packet(uint8_t packet_type, uint8_t *packet, int size){
+    fake_controller_send_packet(1, packet_type, packet, size);
+    return 0;
+}
+
+// synchronous transports: no can_send_packet_now
+static const hci_transport_t fake_transports[NUM_CONTROLLERS] = {
+    {
+        "FAKE-0", &fake_transport_init, &fake_transport_open, &fake_transport_close,
+        &fake_transport_0_register_packet_handler, NULL, &fake_transport_0_send_packet, NULL, NULL, NULL
+    },
+    {
+        "FAKE-1", &fake_transport_init, &fake_transport_open, &fake_transport_close,
+        &fake_transport_1_register_packet_handler, NULL, &fake_transport_1_send_packet, NULL, NULL, NULL
+    },
+};
+
+static btstack_packet_callback_registration_t event_callback_registrations[NUM_CONTROLLERS];
+
+static void handle_event(uint8_t controller_index, uint8_t * packet){
+    fake_controller_t * controller = &fake_controllers[controller_index];
+    if (hci_get_selected_controller() != controller_index){
+        controller->num_events_with_other_controller_selected++;
+    }
+    if (hci_event_packet_get_type(packet) != BTSTACK_EVENT_STATE) return;
+    if (btstack_event_state_get_state(packet) != HCI_STATE_WORKING) return;
+    controller->num_working_events++;
+}
+
+static void packet_handler_0(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
+    UNUSED(channel);
+    UNUSED(size);
+    if (packet_type != HCI_EVENT_PACKET) return;
+    handle_event(0, packet);
+}
+
+static void packet_handler_1(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
+    UNUSED(channel);
+    UNUSED(size);
+    if (packet_type != HCI_EVENT_PACKET) return;
+    handle_event(1, packet);
+}
+
+TEST_GROUP(HCI_MULTIPLE_CONTROLLERS){
+    void setup(void){
+        memset(fake_controllers, 0, sizeof(fake_controllers));
+        hci_init(&fake_transports[0], NULL);
+        CHECK_EQUAL(1, hci_add_controller(&fake_transports[1], NULL));
+        // primary stays selected
+        CHECK_EQUAL(0, hci_get_selected_controller());
+
+        event_callback_registrations[0].callback = &packet_handler_0;
+        hci_add_event_handler(&event_callback_registrations[0]);
+        hci_select_controller(1);
+        event_callback_registrations[1].callback = &packet_handler_1;
+        hci_add_event_handler(&event_callback_registrations[1]);
+        hci_select_controller(0);
+    }
+    void teardown(void){
+        hci_close();
+    }
+    void power_on_all(void){
+        uint8_t i;
+        for (i = 0; i < NUM_CONTROLLERS; i++){
+            hci_select_controller(i);
+            hci_power_control(HCI_POWER_ON);
+        }
+        hci_select_controller(0);
+        fake_controllers_process();
+    }
+};
+
+TEST(HCI_MULTIPLE_CONTROLLERS, AddControllerLimit){
+    CHECK_EQUAL(NUM_CONTROLLERS, hci_get_num_controllers());
+    CHECK_EQUAL(-1, hci_add_controller(&fake_transports[1], NULL));
+}
+
+TEST(HCI_MULTIPLE_CONTROLLERS, PowerOnAll){
+    power_on_all();
+    // selection is restored after processing events
+    CHECK_EQUAL(0, hci_get_selected_controller());
+    uint8_t i;
+    for (i = 0; i < NUM_CONTROLLERS; i++){
+        hci_select_controller(i);
+        CHECK_EQUAL(HCI_STATE_WORKING, hci_get_state());
+        CHECK_EQUAL(1, fake_controllers[i].num_working_events);
+        CHECK_EQUAL(0, fake_controllers[i].num_events_with_other_controller_selected);
+        bd_addr_t addr;
+        gap_local_bd_addr(addr);
+        CHECK_EQUAL(i + 1, addr[5]);
+    }
+    hci_select_controller(0);
+    CHECK(fake_controllers[0].num_commands > 0);
+    CHECK_EQUAL(fake_controllers[0].num_commands, fake_controllers[1].num_commands);
+}
+
+TEST(HCI_MULTIPLE_CONTROLLERS, FewestConnections){
+    power_on_all();
+    CHECK_EQUAL(0, hci_get_controller_with_fewest_connections());
+
+    fake_controller_queue_le_connection_complete(0, 0x0040);
+    fake_controllers_process();
+    CHECK_EQUAL(1, hci_get_controller_with_fewest_connections());
+
+    // same handle on other controller is a different connection
+    fake_controller_queue_le_connection_complete(1, 0x0040);
+    fake_controller_queue_le_connection_complete(1, 0x0041);
+    fake_controllers_process();
+    CHECK_EQUAL(0, hci_get_controller_with_fewest_connections());
+
+    hci_select_controller(1);
+    CHECK(hci_connection_for_handle(0x0041) != NULL);
+    hci_select_controller(0);
+    CHECK(hci_connection_for_handle(0x0041) == NULL);
+}
+
+TEST(HCI_MULTIPLE_CONTROLLERS, OnlyWorkingControllers){
+    hci_select_controller(1);
+    hci_power_control(HCI_POWER_ON);
+    hci_select_controller(0);
+    fake_controllers_process();
+    CHECK_EQUAL(1, hci_get_controller_with_fewest_connections());
+}
+
+#define TEST_PSM        0x0080
+#define TEST_CON_HANDLE 0x0040
+#define TEST_REMOTE_CID 0x0050
+
+static uint16_t l2cap_local_cid;
+static uint8_t  l2cap_receive_buffer[100];
+static uint16_t l2cap_num_channels_opened;
+static uint16_t l2cap_num_channels_closed;
+static uint8_t  l2cap_incoming_controller_index;
+
+static void l2cap_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
+    UNUSED(channel);
+    UNUSED(size);
+    if (packet_type != HCI_EVENT_PACKET) return;
+    switch (hci_event_packet_get_type(packet)){
+        case L2CAP_EVENT_LE_INCOMING_CONNECTION:
+            l2cap_incoming_controller_index = hci_get_selected_controller();
+            l2cap_local_cid = l2cap_event_le_incoming_connection_get_local_cid(packet);
+            l2cap_le_accept_connection(l2cap_local_cid, l2cap_receive_buffer, sizeof(l2cap_receive_buffer), 1);
+            break;
+        case L2CAP_EVENT_LE_CHANNEL_OPENED:
+            l2cap_num_channels_opened++;
+            break;
+        case L2CAP_EVENT_LE_CHANNEL_CLOSED:
+            l2cap_num_channels_closed++;
+            break;
+        default:
+            break;
+    }
+}
+
+TEST_GROUP(HCI_MULTIPLE_CONTROLLERS_L2CAP){
+    void setup(void){
+        memset(fake_controllers, 0, sizeof(fake_controllers));
+        l2cap_local_cid = 0;
+        l2cap_num_channels_opened = 0;
+        l2cap_num_channels_closed = 0;
+        l2cap_incoming_controller_index = 0xff;
+        // L2CAP is set up before the secondary controller is added
+        hci_init(&fake_transports[0], NULL);
+        l2cap_init();
+        l2cap_le_register_service(&l2cap_packet_handler, TEST_PSM, LEVEL_0);
+        CHECK_EQUAL(1, hci_add_controller(&fake_transports[1], NULL));
+        uint8_t i;
+        for (i = 0; i < NUM_CONTROLLERS; i++){
+            hci_select_controller(i);
+            hci_power_control(HCI_POWER_ON);
+        }
+        hci_select_controller(0);
+        fake_controllers_process();
+        // same connection handle on both controllers
+        fake_controller_queue_le_connection_complete(0, TEST_CON_HANDLE);
+        fake_controller_queue_le_connection_complete(1, TEST_CON_HANDLE);
+        fake_controllers_process();
+    }
+    void teardown(void){
+        hci_close();
+    }
+    void open_channel_on_controller_1(void){
+        // LE Credit Based Connection Request: le psm, source cid, mtu, mps, initial credits
+        uint8_t request[14];
+        request[0] = LE_CREDIT_BASED_CONNECTION_REQUEST;
+        request[1] = 1;
+        little_endian_store_16(request, 2, 10);
+        little_endian_store_16(request, 4, TEST_PSM);
+        little_endian_store_16(request, 6, TEST_REMOTE_CID);
+        little_endian_store_16(request, 8, 100);
+        little_endian_store_16(request, 10, 100);
+        little_endian_store_16(request, 12, 5);
+        fake_controller_receive_l2cap_pdu(1, TEST_CON_HANDLE, L2CAP_CID_SIGNALING_LE, request, sizeof(request));
+        fake_controllers_process();
+    }
+};
+
+TEST(HCI_MULTIPLE_CONTROLLERS_L2CAP, AclFromSecondaryControllerReachesL2CAP){
+    open_channel_on_controller_1();
+    CHECK_EQUAL(1, l2cap_incoming_controller_index);
+    CHECK_EQUAL(1, l2cap_num_channels_opened);
+    // selection is restored after processing
+    CHECK_EQUAL(0, hci_get_selected_controller());
+    // response sent via controller that received the request
+    CHECK_EQUAL(0, fake_controllers[0].num_acl_packets);
+    CHECK_EQUAL(1, fake_controllers[1].num_acl_packets);
+    CHECK_EQUAL(L2CAP_CID_SIGNALING_LE, little_endian_read_16(fake_controllers[1].acl_packet, 6));
+    CHECK_EQUAL(LE_CREDIT_BASED_CONNECTION_RESPONSE, fake_controllers[1].acl_packet[8]);
+}
+
+TEST(HCI_MULTIPLE_CONTROLLERS_L2CAP, SendUsesControllerOfChannel){
+    open_channel_on_controller_1();
+    CHECK_EQUAL(1, l2cap_num_channels_opened);
+    uint8_t data[] = { 1, 2, 3, 4 };
+    CHECK_EQUAL(0, hci_get_selected_controller());
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, l2cap_le_send_data(l2cap_local_cid, data, sizeof(data)));
+    fake_controllers_process();
+    CHECK_EQUAL(0, fake_controllers[0].num_acl_packets);
+    CHECK_EQUAL(2, fake_controllers[1].num_acl_packets);
+    CHECK_EQUAL(TEST_REMOTE_CID, little_endian_read_16(fake_controllers[1].acl_packet, 6));
+    // SDU length + data
+    CHECK_EQUAL(sizeof(data), little_endian_read_16(fake_controllers[1].acl_packet, 8));
+    MEMCMP_EQUAL(data, &fake_controllers[1].acl_packet[10], sizeof(data));
+    CHECK_EQUAL(0, hci_get_selected_controller());
+}
+
+TEST(HCI_MULTIPLE_CONTROLLERS_L2CAP, DisconnectOnlyClosesChannelsOfController){
+    open_channel_on_controller_1();
+    CHECK_EQUAL(1, l2cap_num_channels_opened);
+
+    // same handle on primary controller
+    fake_controller_queue_disconnection_complete(0, TEST_CON_HANDLE);
+    fake_controllers_process();
+    CHECK_EQUAL(0, l2cap_num_channels_closed);
+
+    fake_controller_queue_disconnection_complete(1, TEST_CON_HANDLE);
+    fake_controllers_process();
+    CHECK_EQUAL(1, l2cap_num_channels_closed);
+}
+
+TEST(HCI_MULTIPLE_CONTROLLERS_L2CAP, DataForChannelOnOtherControllerIgnored){
+    open_channel_on_controller_1();
+    CHECK_EQUAL(1, l2cap_num_channels_opened);
+    // remote on primary controller uses our local cid
+    uint8_t pdu[] = { 4, 0, 1, 2, 3, 4 };
+    fake_controller_receive_l2cap_pdu(0, TEST_CON_HANDLE, l2cap_local_cid, pdu, sizeof(pdu));
+    l2cap_le_channel_statistics_t statistics;
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, l2cap_le_get_channel_statistics(l2cap_local_cid, &statistics));
+    CHECK_EQUAL(0, statistics.rx_pdus);
+}
+
+TEST(HCI_MULTIPLE_CONTROLLERS_L2CAP, AttRequestOnSecondaryControllerRejected){
+    // ATT Read Request for handle 0x0001
+    uint8_t request[] = { ATT_READ_REQUEST, 0x01, 0x00 };
+    fake_controller_receive_l2cap_pdu(1, TEST_CON_HANDLE, L2CAP_CID_ATTRIBUTE_PROTOCOL, request, sizeof(request));
+    fake_controllers_process();
+    CHECK_EQUAL(0, fake_controllers[0].num_acl_packets);
+    CHECK_EQUAL(1, fake_controllers[1].num_acl_packets);
+    CHECK_EQUAL(L2CAP_CID_ATTRIBUTE_PROTOCOL, little_endian_read_16(fake_controllers[1].acl_packet, 6));
+    uint8_t expected[] = { ATT_ERROR_RESPONSE, ATT_READ_REQUEST, 0x00, 0x00, ATT_ERROR_REQUEST_NOT_SUPPORTED };
+    CHECK_EQUAL(sizeof(expected), little_endian_read_16(fake_controllers[1].acl_packet, 4));
+    MEMCMP_EQUAL(expected, &fake_controllers[1].acl_packet[8], sizeof(expected));
+    CHECK_EQUAL(0, hci_get_selected_controller());
+}
+
+TEST(HCI_MULTIPLE_CONTROLLERS_L2CAP, AttCommandOnSecondaryControllerIgnored){
+    uint8_t command[] = { ATT_WRITE_COMMAND, 0x01, 0x00, 0x55 };
+    fake_controller_receive_l2cap_pdu(1, TEST_CON_HANDLE, L2CAP_CID_ATTRIBUTE_PROTOCOL, command, sizeof(command));
+    fake_controllers_process();
+    CHECK_EQUAL(0, fake_controllers[0].num_acl_packets);
+    CHECK_EQUAL(0, fake_controllers[1].num_acl_packets);
+}
+
+TEST(HCI_MULTIPLE_CONTROLLERS_L2CAP, PairingOnSecondaryControllerRejected){
+    // Pairing Request: io capability, oob, auth req, max key size, initiator / responder key distribution
+    uint8_t request[] = { SM_CODE_PAIRING_REQUEST, 0x03, 0x00, 0x01, 0x10, 0x07, 0x07 };
+    fake_controller_receive_l2cap_pdu(1, TEST_CON_HANDLE, L2CAP_CID_SECURITY_MANAGER_PROTOCOL, request, sizeof(request));
+    fake_controllers_process();
+    CHECK_EQUAL(0, fake_controllers[0].num_acl_packets);
+    CHECK_EQUAL(1, fake_controllers[1].num_acl_packets);
+    CHECK_EQUAL(L2CAP_CID_SECURITY_MANAGER_PROTOCOL, little_endian_read_16(fake_controllers[1].acl_packet, 6));
+    uint8_t expected[] = { SM_CODE_PAIRING_FAILED, SM_REASON_PAIRING_NOT_SUPPORTED };
+    CHECK_EQUAL(sizeof(expected), little_endian_read_16(fake_controllers[1].acl_packet, 4));
+    MEMCMP_EQUAL(expected, &fake_controllers[1].acl_packet[8], sizeof(expected));
+}
+
+int main (int argc, const char * argv[]){
+    btstack_run_loop_init(btstack_run_loop_posix_get_instance());
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
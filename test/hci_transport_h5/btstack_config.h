@@ -0,0 +1,24 @@
+//
+// btstack_config.h for H5 transport tests
+//
+
+#ifndef __BTSTACK_CONFIG
+#define __BTSTACK_CONFIG
+
+// Port related features
+#define HAVE_MALLOC
+#define HAVE_ASSERT
+#define HAVE_POSIX_TIME
+
+// BTstack features that can be enabled
+#define ENABLE_LOG_ERROR
+#define ENABLE_LOG_INFO
+#define ENABLE_H5_CRC_SLICE_BY_8
+#define ENABLE_H5_OOF_FLOW_CONTROL
+
+// BTstack configuration. buffers, sizes, ...
+#define HCI_ACL_PAYLOAD_SIZE 1024
+#define HCI_INCOMING_PRE_BUFFER_SIZE 6
+#define HCI_TRANSPORT_H5_SLIDING_WINDOW_SIZE 4
+
+#endif
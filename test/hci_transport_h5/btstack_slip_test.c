@@ -0,0 +1,141 @@
+// SLIP encoder/decoder: block functions against byte-wise reference
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/CommandLineTestRunner.h"
+
+#include "btstack_slip.h"
+#include "btstack_util.h"
+
+#define DATA_LEN 300
+
+static uint8_t data[DATA_LEN];
+static uint8_t encoded_reference[2 * DATA_LEN];
+static uint8_t encoded[2 * DATA_LEN];
+static uint8_t decoded[DATA_LEN];
+
+static void fill_data(void){
+    uint16_t i;
+    for (i = 0; i < DATA_LEN; i++){
+        switch (rand() % 6){
+            case 0:
+                data[i] = BTSTACK_SLIP_SOF;
+                break;
+            case 1:
+                data[i] = 0xdb;
+                break;
+            case 2:
+                data[i] = (rand() & 1) ? BTSTACK_SLIP_XON : BTSTACK_SLIP_XOFF;
+                break;
+            default:
+                data[i] = (uint8_t) rand();
+                break;
+        }
+    }
+}
+
+static uint16_t encode_reference(void){
+    uint16_t len = 0;
+    btstack_slip_encoder_start(data, DATA_LEN);
+    while (btstack_slip_encoder_has_data()){
+        encoded_reference[len++] = btstack_slip_encoder_get_byte();
+    }
+    return len;
+}
+
+static uint16_t encode_in_chunks(uint16_t chunk_len){
+    uint16_t len = 0;
+    btstack_slip_encoder_start(data, DATA_LEN);
+    while (btstack_slip_encoder_has_data()){
+        uint16_t bytes_encoded = btstack_slip_encoder_get_bytes(&encoded[len], chunk_len);
+        CHECK(bytes_encoded > 0);
+        CHECK(bytes_encoded <= chunk_len);
+        len += bytes_encoded;
+    }
+    return len;
+}
+
+static void check_encoder(int oof_flow_control){
+    btstack_slip_encoder_set_oof_flow_control(oof_flow_control);
+    uint16_t reference_len = encode_reference();
+    uint16_t chunk_len;
+    for (chunk_len = 1; chunk_len <= 70; chunk_len++){
+        uint16_t len = encode_in_chunks(chunk_len);
+        CHECK_EQUAL(reference_len, len);
+        MEMCMP_EQUAL(encoded_reference, encoded, len);
+    }
+    btstack_slip_encoder_set_oof_flow_control(0);
+}
+
+static uint16_t decode_in_blocks(const uint8_t * frame, uint16_t frame_len, uint16_t block_len){
+    btstack_slip_decoder_init(decoded, sizeof(decoded));
+    uint16_t pos = 0;
+    while (pos < frame_len){
+        uint16_t bytes_to_process = btstack_min(block_len, frame_len - pos);
+        pos += btstack_slip_decoder_process_block(&frame[pos], bytes_to_process);
+        if (btstack_slip_decoder_frame_size() > 0) break;
+    }
+    // stops after final SOF
+    CHECK_EQUAL(frame_len, pos);
+    return btstack_slip_decoder_frame_size();
+}
+
+TEST_GROUP(SLIP){
+    void setup(void){
+        srand(0);
+        fill_data();
+    }
+};
+
+TEST(SLIP, EncoderBlock){
+    check_encoder(0);
+}
+
+TEST(SLIP, EncoderBlockOOFFlowControl){
+    check_encoder(1);
+}
+
+TEST(SLIP, DecoderBlock){
+    btstack_slip_encoder_set_oof_flow_control(1);
+    uint8_t frame[2 * DATA_LEN + 2];
+    uint16_t frame_len = 0;
+    frame[frame_len++] = BTSTACK_SLIP_SOF;
+    btstack_slip_encoder_start(data, DATA_LEN);
+    frame_len += btstack_slip_encoder_get_bytes(&frame[frame_len], 2 * DATA_LEN);
+    frame[frame_len++] = BTSTACK_SLIP_SOF;
+    btstack_slip_encoder_set_oof_flow_control(0);
+
+    uint16_t block_len;
+    for (block_len = 1; block_len <= 70; block_len++){
+        memset(decoded, 0, sizeof(decoded));
+        CHECK_EQUAL(DATA_LEN, decode_in_blocks(frame, frame_len, block_len));
+        MEMCMP_EQUAL(data, decoded, DATA_LEN);
+    }
+}
+
+TEST(SLIP, DecoderBlockStopsAfterFrame){
+    const uint8_t frames[] = { BTSTACK_SLIP_SOF, 0x01, 0xdb, 0xdc, 0x02, BTSTACK_SLIP_SOF, 0x03, 0x04, BTSTACK_SLIP_SOF };
+    btstack_slip_decoder_init(decoded, sizeof(decoded));
+    CHECK_EQUAL(6, btstack_slip_decoder_process_block(frames, sizeof(frames)));
+    CHECK_EQUAL(3, btstack_slip_decoder_frame_size());
+    const uint8_t first[] = { 0x01, BTSTACK_SLIP_SOF, 0x02 };
+    MEMCMP_EQUAL(first, decoded, sizeof(first));
+
+    // decoder waits for SOF after re-init
+    btstack_slip_decoder_init(decoded, sizeof(decoded));
+    CHECK_EQUAL(0, btstack_slip_decoder_bytes_decoded());
+    CHECK_EQUAL(1, btstack_slip_decoder_process_block(&frames[5], 1));
+    CHECK_EQUAL(2, btstack_slip_decoder_process_block(&frames[6], 2));
+    CHECK_EQUAL(2, btstack_slip_decoder_bytes_decoded());
+    CHECK_EQUAL(0, btstack_slip_decoder_frame_size());
+    CHECK_EQUAL(1, btstack_slip_decoder_process_block(&frames[8], 1));
+    CHECK_EQUAL(2, btstack_slip_decoder_frame_size());
+}
+
+int main (int argc, const char * argv[]){
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
@@ -0,0 +1,544 @@
+// H5 Transport with simulated Controller H5 endpoint on a pty
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/CommandLineTestRunner.h"
+
+#include "btstack_debug.h"
+#include "btstack_defines.h"
+#include "btstack_run_loop.h"
+#include "btstack_run_loop_posix.h"
+#include "btstack_uart_block.h"
+#include "btstack_util.h"
+#include "hci_transport.h"
+
+#define TEST_TIMEOUT_MS        5000
+#define NUM_PACKETS            32
+#define PACKET_SIZE            20
+#define PEER_SLIDING_WINDOW    4
+#define PEER_DATA_INTEGRITY_CHECK 0x10
+#define LARGE_EVENT_PARAMS_LEN 60
+
+#define PEER_MAX_FRAME_SIZE    100
+
+#define LINK_ACKNOWLEDGEMENT_TYPE 0x00
+#define LINK_CONTROL_PACKET_TYPE  0x0f
+
+#define SLIP_SOF  0xc0
+#define SLIP_XON  0x11
+#define SLIP_XOFF 0x13
+
+const btstack_uart_block_t * btstack_uart_block_posix_instance(void);
+
+// simulated Controller
+typedef struct {
+    int      fd;
+    btstack_data_source_t data_source;
+    // config field of config response
+    uint8_t  config;
+    // slip decoder
+    uint8_t  frame[PEER_MAX_FRAME_SIZE];
+    uint16_t frame_len;
+    bool     frame_active;
+    bool     frame_escape;
+    bool     raw_xon_xoff_in_frame;
+    // reliable packets from host
+    uint8_t  expected_seq_nr;
+    uint8_t  ack_every;
+    uint8_t  unacked;
+    uint8_t  max_unacked;
+    int      drop_seq_nr;
+    uint16_t num_received;
+    uint16_t num_discarded;
+    bool     out_of_order;
+    // reliable packets to host
+    uint8_t  seq_nr;
+    uint8_t  host_ack_nr;
+    uint16_t num_ack_frames;
+    // data integrity check
+    bool     send_dic;
+    uint16_t num_dic_frames;
+    bool     dic_error;
+    // out-of-frame flow control
+    uint16_t xoff_after;
+    uint16_t num_received_xoff;
+    bool     received_during_xoff;
+} peer_t;
+
+static peer_t peer;
+
+static char device_name[64];
+static hci_transport_config_uart_t transport_config = {
+    HCI_TRANSPORT_CONFIG_UART, 115200, 0, 0, device_name
+};
+static const hci_transport_t * transport;
+
+static uint8_t  hci_packet_buffer[PACKET_SIZE];
+static uint16_t num_packets_to_send;
+static uint16_t num_packets_sent;
+static uint16_t num_events_received;
+static bool     events_in_order;
+static bool     events_params_ok;
+static bool     timeout_reached;
+
+static btstack_timer_source_t timeout_timer;
+static btstack_timer_source_t xoff_snapshot_timer;
+static btstack_timer_source_t xon_timer;
+
+static void peer_write(const uint8_t * data, uint16_t size){
+    while (size > 0){
+        ssize_t res = write(peer.fd, data, size);
+        if (res <= 0) continue;
+        data += res;
+        size -= res;
+    }
+}
+
+static uint16_t peer_slip_encode(uint8_t * buffer, const uint8_t * data, uint16_t size){
+    uint16_t pos = 0;
+    uint16_t i;
+    for (i = 0; i < size; i++){
+        switch (data[i]){
+            case SLIP_SOF:
+                buffer[pos++] = 0xdb;
+                buffer[pos++] = 0xdc;
+                break;
+            case 0xdb:
+                buffer[pos++] = 0xdb;
+                buffer[pos++] = 0xdd;
+                break;
+            case SLIP_XON:
+                buffer[pos++] = 0xdb;
+                buffer[pos++] = 0xde;
+                break;
+            case SLIP_XOFF:
+                buffer[pos++] = 0xdb;
+                buffer[pos++] = 0xdf;
+                break;
+            default:
+                buffer[pos++] = data[i];
+                break;
+        }
+    }
+    return pos;
+}
+
+// bitwise CRC-CCITT as reference for the table-driven implementation
+static uint16_t peer_calc_dic(const uint8_t * data, uint16_t size){
+    uint16_t crc = 0xffff;
+    uint16_t i;
+    for (i = 0; i < size; i++){
+        crc ^= data[i];
+        int bit;
+        for (bit = 0; bit < 8; bit++){
+            crc = (crc & 1) ? ((crc >> 1) ^ 0x8408) : (crc >> 1);
+        }
+    }
+    // DIC is sent with bit order reversed
+    uint16_t dic = 0;
+    for (i = 0; i < 16; i++){
+        dic = (dic << 1) | (crc & 1);
+        crc >>= 1;
+    }
+    return dic;
+}
+
+static uint8_t event_param(uint8_t index){
+    // include bytes that need to be escaped
+    switch (index % 3){
+        case 0:
+            return SLIP_SOF;
+        case 1:
+            return 0xdb;
+        default:
+            return index;
+    }
+}
+
+static void peer_send_frame(uint8_t seq_nr, uint8_t reliable, uint8_t packet_type, const uint8_t * payload, uint16_t payload_len){
+    uint8_t frame[4 + PEER_MAX_FRAME_SIZE + 2];
+    frame[0] = seq_nr | (peer.expected_seq_nr << 3) | (reliable << 7);
+    if (peer.send_dic){
+        frame[0] |= 0x40;
+    }
+    frame[1] = packet_type | ((payload_len & 0x0f) << 4);
+    frame[2] = payload_len >> 4;
+    frame[3] = 0xff - (frame[0] + frame[1] + frame[2]);
+    memcpy(&frame[4], payload, payload_len);
+    uint16_t frame_len = 4 + payload_len;
+    if (peer.send_dic){
+        big_endian_store_16(frame, frame_len, peer_calc_dic(frame, frame_len));
+        frame_len += 2;
+    }
+    uint8_t buffer[2 * sizeof(frame) + 2];
+    uint16_t pos = 0;
+    buffer[pos++] = SLIP_SOF;
+    pos += peer_slip_encode(&buffer[pos], frame, frame_len);
+    buffer[pos++] = SLIP_SOF;
+    peer_write(buffer, pos);
+}
+
+static void peer_send_control(const uint8_t * message, uint16_t message_len){
+    peer_send_frame(0, 0, LINK_CONTROL_PACKET_TYPE, message, message_len);
+}
+
+static void peer_send_ack(void){
+    peer.unacked = 0;
+    peer_send_frame(0, 0, LINK_ACKNOWLEDGEMENT_TYPE, NULL, 0);
+}
+
+static void peer_send_event_with_params_len(uint8_t event_nr, uint8_t params_len){
+    uint8_t event[2 + LARGE_EVENT_PARAMS_LEN];
+    event[0] = 0xff;
+    event[1] = params_len;
+    event[2] = event_nr;
+    uint8_t i;
+    for (i = 1; i < params_len; i++){
+        event[2 + i] = event_param(i);
+    }
+    peer_send_frame(peer.seq_nr, 1, HCI_EVENT_PACKET, event, 2 + params_len);
+    peer.seq_nr = (peer.seq_nr + 1) & 0x07;
+}
+
+static void peer_send_event(uint8_t event_nr){
+    peer_send_event_with_params_len(event_nr, 1);
+}
+
+static void xoff_snapshot_handler(btstack_timer_source_t * ts){
+    UNUSED(ts);
+    // frames already handed to UART before XOFF was received may still arrive
+    peer.num_received_xoff = peer.num_received;
+}
+
+static void xon_handler(btstack_timer_source_t * ts){
+    UNUSED(ts);
+    if (peer.num_received != peer.num_received_xoff){
+        peer.received_during_xoff = true;
+    }
+    const uint8_t xon = SLIP_XON;
+    peer_write(&xon, 1);
+}
+
+static void peer_send_xoff(void){
+    const uint8_t xoff = SLIP_XOFF;
+    peer_write(&xoff, 1);
+    btstack_run_loop_set_timer_handler(&xoff_snapshot_timer, &xoff_snapshot_handler);
+    btstack_run_loop_set_timer(&xoff_snapshot_timer, 50);
+    btstack_run_loop_add_timer(&xoff_snapshot_timer);
+    btstack_run_loop_set_timer_handler(&xon_timer, &xon_handler);
+    btstack_run_loop_set_timer(&xon_timer, 300);
+    btstack_run_loop_add_timer(&xon_timer);
+}
+
+static void peer_process_reliable_packet(uint8_t seq_nr, const uint8_t * payload){
+    if (seq_nr != peer.expected_seq_nr){
+        // discard and ack expected seq nr
+        peer.num_discarded++;
+        peer_send_ack();
+        return;
+    }
+    if ((peer.drop_seq_nr >= 0) && (seq_nr == peer.drop_seq_nr)){
+        // simulate lost packet once
+        peer.drop_seq_nr = -1;
+        peer.num_discarded++;
+        return;
+    }
+    if (payload[0] != (uint8_t) peer.num_received){
+        peer.out_of_order = true;
+    }
+    peer.expected_seq_nr = (peer.expected_seq_nr + 1) & 0x07;
+    peer.num_received++;
+    peer.unacked++;
+    peer.max_unacked = btstack_max(peer.max_unacked, peer.unacked);
+    if ((peer.unacked >= peer.ack_every) || (peer.num_received == NUM_PACKETS)){
+        peer_send_ack();
+    }
+    if (peer.num_received == peer.xoff_after){
+        peer_send_xoff();
+    }
+    if (peer.num_received == NUM_PACKETS){
+        btstack_run_loop_posix_trigger_exit();
+    }
+}
+
+static void peer_process_frame(void){
+    if (peer.frame_len < 4) return;
+    const uint8_t * header = peer.frame;
+    CHECK_EQUAL(0xff, (uint8_t) (header[0] + header[1] + header[2] + header[3]));
+    uint8_t  seq_nr      = header[0] & 0x07;
+    uint8_t  ack_nr      = (header[0] >> 3) & 0x07;
+    bool     dic_present = (header[0] & 0x40) != 0;
+    bool     reliable    = (header[0] & 0x80) != 0;
+    uint8_t  packet_type = header[1] & 0x0f;
+    uint16_t payload_len = (header[1] >> 4) | (header[2] << 4);
+    const uint8_t * payload = &header[4];
+    if (dic_present){
+        CHECK_EQUAL(peer.frame_len - 6, payload_len);
+        if (big_endian_read_16(peer.frame, peer.frame_len - 2) != peer_calc_dic(peer.frame, peer.frame_len - 2)){
+            peer.dic_error = true;
+        }
+        peer.num_dic_frames++;
+    } else {
+        CHECK_EQUAL(peer.frame_len - 4, payload_len);
+    }
+
+    if (packet_type == LINK_CONTROL_PACKET_TYPE){
+        static const uint8_t sync[]            = { 0x01, 0x7e };
+        static const uint8_t sync_response[]   = { 0x02, 0x7d };
+        static const uint8_t config[]          = { 0x03, 0xfc };
+        if (memcmp(payload, sync, sizeof(sync)) == 0){
+            peer_send_control(sync_response, sizeof(sync_response));
+        } else if (memcmp(payload, config, sizeof(config)) == 0){
+            const uint8_t config_response[] = { 0x04, 0x7b, peer.config };
+            peer_send_control(config_response, sizeof(config_response));
+        }
+        return;
+    }
+
+    peer.host_ack_nr = ack_nr;
+    if (packet_type == LINK_ACKNOWLEDGEMENT_TYPE){
+        peer.num_ack_frames++;
+        return;
+    }
+    if (reliable){
+        peer_process_reliable_packet(seq_nr, payload);
+    }
+}
+
+static void peer_process_byte(uint8_t data){
+    if (data == SLIP_SOF){
+        if (peer.frame_active && (peer.frame_len > 0)){
+            peer_process_frame();
+        }
+        peer.frame_active = true;
+        peer.frame_len = 0;
+        peer.frame_escape = false;
+        return;
+    }
+    if (!peer.frame_active) return;
+    if ((data == SLIP_XON) || (data == SLIP_XOFF)){
+        peer.raw_xon_xoff_in_frame = true;
+    }
+    if (peer.frame_escape){
+        peer.frame_escape = false;
+        switch (data){
+            case 0xdc:
+                data = SLIP_SOF;
+                break;
+            case 0xdd:
+                data = 0xdb;
+                break;
+            case 0xde:
+                data = SLIP_XON;
+                break;
+            case 0xdf:
+                data = SLIP_XOFF;
+                break;
+            default:
+                break;
+        }
+    } else if (data == 0xdb){
+        peer.frame_escape = true;
+        return;
+    }
+    if (peer.frame_len < sizeof(peer.frame)){
+        peer.frame[peer.frame_len++] = data;
+    }
+}
+
+static void peer_process(btstack_data_source_t * ds, btstack_data_source_callback_type_t callback_type){
+    UNUSED(callback_type);
+    uint8_t buffer[256];
+    ssize_t bytes_read = read(ds->source.fd, buffer, sizeof(buffer));
+    ssize_t i;
+    for (i = 0; i < bytes_read; i++){
+        peer_process_byte(buffer[i]);
+    }
+}
+
+static void host_send_packets(void){
+    while ((num_packets_sent < num_packets_to_send) && transport->can_send_packet_now(HCI_ACL_DATA_PACKET)){
+        // re-use single buffer like HCI does
+        memset(hci_packet_buffer, 0, sizeof(hci_packet_buffer));
+        hci_packet_buffer[0] = (uint8_t) num_packets_sent;
+        hci_packet_buffer[1] = SLIP_XON;
+        hci_packet_buffer[2] = SLIP_XOFF;
+        hci_packet_buffer[3] = SLIP_SOF;
+        hci_packet_buffer[4] = 0xdb;
+        CHECK_EQUAL(0, transport->send_packet(HCI_ACL_DATA_PACKET, hci_packet_buffer, sizeof(hci_packet_buffer)));
+        num_packets_sent++;
+    }
+}
+
+static void host_packet_handler(uint8_t packet_type, uint8_t *packet, uint16_t size){
+    UNUSED(size);
+    uint8_t i;
+    if (packet_type != HCI_EVENT_PACKET) return;
+    switch (packet[0]){
+        case HCI_EVENT_TRANSPORT_PACKET_SENT:
+            host_send_packets();
+            break;
+        case 0xff:
+            if (packet[2] != num_events_received){
+                events_in_order = false;
+            }
+            for (i = 1; i < packet[1]; i++){
+                if (packet[2 + i] != event_param(i)){
+                    events_params_ok = false;
+                }
+            }
+            num_events_received++;
+            break;
+        default:
+            break;
+    }
+}
+
+static void timeout_handler(btstack_timer_source_t * ts){
+    UNUSED(ts);
+    timeout_reached = true;
+    btstack_run_loop_posix_trigger_exit();
+}
+
+static void run_loop_execute_with_timeout(uint32_t timeout_ms){
+    btstack_run_loop_set_timer_handler(&timeout_timer, &timeout_handler);
+    btstack_run_loop_set_timer(&timeout_timer, timeout_ms);
+    btstack_run_loop_add_timer(&timeout_timer);
+    btstack_run_loop_execute();
+    btstack_run_loop_remove_timer(&timeout_timer);
+}
+
+TEST_GROUP(HCI_TRANSPORT_H5){
+    void setup(void){
+        memset(&peer, 0, sizeof(peer));
+        peer.config = PEER_SLIDING_WINDOW | 0x08;
+        peer.ack_every = 1;
+        peer.drop_seq_nr = -1;
+        num_packets_to_send = NUM_PACKETS;
+        num_packets_sent = 0;
+        num_events_received = 0;
+        events_in_order = true;
+        events_params_ok = true;
+        timeout_reached = false;
+
+        peer.fd = posix_openpt(O_RDWR | O_NOCTTY);
+        CHECK(peer.fd >= 0);
+        CHECK_EQUAL(0, grantpt(peer.fd));
+        CHECK_EQUAL(0, unlockpt(peer.fd));
+        strcpy(device_name, ptsname(peer.fd));
+        struct termios toptions;
+        tcgetattr(peer.fd, &toptions);
+        cfmakeraw(&toptions);
+        tcsetattr(peer.fd, TCSANOW, &toptions);
+        fcntl(peer.fd, F_SETFL, fcntl(peer.fd, F_GETFL) | O_NONBLOCK);
+        btstack_run_loop_set_data_source_fd(&peer.data_source, peer.fd);
+        btstack_run_loop_set_data_source_handler(&peer.data_source, &peer_process);
+        btstack_run_loop_enable_data_source_callbacks(&peer.data_source, DATA_SOURCE_CALLBACK_READ);
+        btstack_run_loop_add_data_source(&peer.data_source);
+
+        transport = hci_transport_h5_instance(btstack_uart_block_posix_instance());
+        transport->init(&transport_config);
+        transport->register_packet_handler(&host_packet_handler);
+    }
+    void teardown(void){
+        transport->close();
+        btstack_run_loop_remove_data_source(&peer.data_source);
+        btstack_run_loop_remove_timer(&xoff_snapshot_timer);
+        btstack_run_loop_remove_timer(&xon_timer);
+        close(peer.fd);
+    }
+};
+
+TEST(HCI_TRANSPORT_H5, SlidingWindow){
+    peer.ack_every = PEER_SLIDING_WINDOW;
+    CHECK_EQUAL(0, transport->open());
+    run_loop_execute_with_timeout(TEST_TIMEOUT_MS);
+    CHECK(!timeout_reached);
+    CHECK_EQUAL(NUM_PACKETS, peer.num_received);
+    CHECK(!peer.out_of_order);
+    // host fills the sliding window before waiting for ack
+    CHECK_EQUAL(PEER_SLIDING_WINDOW, peer.max_unacked);
+    // XON/XOFF are escaped within frames
+    CHECK(!peer.raw_xon_xoff_in_frame);
+}
+
+TEST(HCI_TRANSPORT_H5, NegotiateSmallerWindow){
+    peer.config = 2;
+    peer.ack_every = PEER_SLIDING_WINDOW;
+    CHECK_EQUAL(0, transport->open());
+    run_loop_execute_with_timeout(TEST_TIMEOUT_MS);
+    CHECK(!timeout_reached);
+    CHECK_EQUAL(NUM_PACKETS, peer.num_received);
+    CHECK(!peer.out_of_order);
+    CHECK_EQUAL(2, peer.max_unacked);
+}
+
+TEST(HCI_TRANSPORT_H5, Retransmission){
+    peer.drop_seq_nr = 2;
+    CHECK_EQUAL(0, transport->open());
+    run_loop_execute_with_timeout(TEST_TIMEOUT_MS);
+    CHECK(!timeout_reached);
+    CHECK_EQUAL(NUM_PACKETS, peer.num_received);
+    CHECK(!peer.out_of_order);
+    CHECK(peer.num_discarded > 0);
+}
+
+TEST(HCI_TRANSPORT_H5, OutOfFrameFlowControl){
+    peer.xoff_after = 8;
+    CHECK_EQUAL(0, transport->open());
+    run_loop_execute_with_timeout(TEST_TIMEOUT_MS);
+    CHECK(!timeout_reached);
+    CHECK_EQUAL(NUM_PACKETS, peer.num_received);
+    CHECK(!peer.out_of_order);
+    CHECK(!peer.received_during_xoff);
+    CHECK(!peer.raw_xon_xoff_in_frame);
+}
+
+TEST(HCI_TRANSPORT_H5, DelayedAck){
+    num_packets_to_send = 0;
+    CHECK_EQUAL(0, transport->open());
+    // wait for link to become active
+    run_loop_execute_with_timeout(500);
+    peer_send_event(0);
+    peer_send_event(1);
+    peer_send_event(2);
+    run_loop_execute_with_timeout(200);
+    CHECK_EQUAL(3, num_events_received);
+    CHECK(events_in_order);
+    CHECK_EQUAL(3, peer.host_ack_nr);
+    // acks are combined
+    CHECK(peer.num_ack_frames < 3);
+}
+
+TEST(HCI_TRANSPORT_H5, DataIntegrityCheck){
+    peer.config = PEER_SLIDING_WINDOW | 0x08 | PEER_DATA_INTEGRITY_CHECK;
+    peer.send_dic = true;
+    CHECK_EQUAL(0, transport->open());
+    run_loop_execute_with_timeout(TEST_TIMEOUT_MS);
+    CHECK(!timeout_reached);
+    CHECK_EQUAL(NUM_PACKETS, peer.num_received);
+    CHECK(!peer.out_of_order);
+    CHECK(peer.num_dic_frames >= NUM_PACKETS);
+    CHECK(!peer.dic_error);
+
+    // large events with escaped bytes are received in blocks
+    peer_send_event_with_params_len(0, LARGE_EVENT_PARAMS_LEN);
+    peer_send_event(1);
+    peer_send_event_with_params_len(2, LARGE_EVENT_PARAMS_LEN);
+    run_loop_execute_with_timeout(200);
+    CHECK_EQUAL(3, num_events_received);
+    CHECK(events_in_order);
+    CHECK(events_params_ok);
+}
+
+int main (int argc, const char * argv[]){
+    btstack_run_loop_init(btstack_run_loop_posix_get_instance());
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
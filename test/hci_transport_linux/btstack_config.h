@@ -0,0 +1,23 @@
+//
+// btstack_config.h for Linux HCI User Channel transport tests
+//
+
+#ifndef __BTSTACK_CONFIG
+#define __BTSTACK_CONFIG
+
+// Port related features
+#define HAVE_MALLOC
+#define HAVE_ASSERT
+#define HAVE_POSIX_TIME
+
+// BTstack features that can be enabled
+#define ENABLE_LOG_ERROR
+#define ENABLE_LOG_INFO
+
+// BTstack configuration. buffers, sizes, ...
+#define HCI_ACL_PAYLOAD_SIZE 1024
+#define HCI_INCOMING_PRE_BUFFER_SIZE 6
+#define HCI_TRANSPORT_LINUX_RX_BATCH_SIZE 4
+#define HCI_TRANSPORT_LINUX_MAX_INSTANCES 3
+
+#endif
@@ -0,0 +1,253 @@
+// Linux HCI User Channel transport with socketpair as stand-in for the HCI socket
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/CommandLineTestRunner.h"
+
+#include "btstack_debug.h"
+#include "btstack_defines.h"
+#include "btstack_run_loop.h"
+#include "btstack_run_loop_posix.h"
+#include "btstack_util.h"
+#include "hci.h"
+#include "hci_transport.h"
+
+#define TEST_TIMEOUT_MS 1000
+#define MAX_PACKETS     10
+
+typedef struct {
+    uint8_t  packet_type;
+    uint16_t size;
+    uint8_t  data[HCI_ACL_BUFFER_SIZE];
+    bool     pre_buffer_writable;
+} received_packet_t;
+
+static int peer_fd;
+static const hci_transport_t * transport;
+static received_packet_t received_packets[MAX_PACKETS];
+static uint16_t num_packets_received;
+static uint16_t num_packets_expected;
+static bool     timeout_reached;
+static btstack_timer_source_t timeout_timer;
+
+static void peer_send(uint8_t packet_type, const uint8_t * packet, uint16_t size){
+    uint8_t buffer[1 + HCI_ACL_BUFFER_SIZE];
+    buffer[0] = packet_type;
+    memcpy(&buffer[1], packet, size);
+    CHECK_EQUAL(1 + size, write(peer_fd, buffer, 1 + size));
+}
+
+static void host_packet_handler(uint8_t packet_type, uint8_t *packet, uint16_t size){
+    if (num_packets_received < MAX_PACKETS){
+        received_packet_t * received_packet = &received_packets[num_packets_received];
+        received_packet->packet_type = packet_type;
+        received_packet->size = size;
+        memcpy(received_packet->data, packet, size);
+        // HCI may write into pre-buffer
+        memset(packet - HCI_INCOMING_PRE_BUFFER_SIZE, 0x55, HCI_INCOMING_PRE_BUFFER_SIZE);
+        received_packet->pre_buffer_writable = true;
+    }
+    num_packets_received++;
+    if (num_packets_received == num_packets_expected){
+        btstack_run_loop_posix_trigger_exit();
+    }
+}
+
+static void timeout_handler(btstack_timer_source_t * ts){
+    UNUSED(ts);
+    timeout_reached = true;
+    btstack_run_loop_posix_trigger_exit();
+}
+
+static void run_loop_execute_with_timeout(uint32_t timeout_ms){
+    btstack_run_loop_set_timer_handler(&timeout_timer, &timeout_handler);
+    btstack_run_loop_set_timer(&timeout_timer, timeout_ms);
+    btstack_run_loop_add_timer(&timeout_timer);
+    btstack_run_loop_execute();
+    btstack_run_loop_remove_timer(&timeout_timer);
+}
+
+TEST_GROUP(HCI_TRANSPORT_LINUX){
+    void setup(void){
+        int fds[2];
+        CHECK_EQUAL(0, socketpair(AF_UNIX, SOCK_SEQPACKET, 0, fds));
+        peer_fd = fds[1];
+        memset(received_packets, 0, sizeof(received_packets));
+        num_packets_received = 0;
+        num_packets_expected = 0;
+        timeout_reached = false;
+
+        transport = hci_transport_linux_instance();
+        transport->register_packet_handler(&host_packet_handler);
+        hci_transport_linux_set_socket(fds[0]);
+        CHECK_EQUAL(0, transport->open());
+    }
+    void teardown(void){
+        transport->close();
+        if (peer_fd >= 0){
+            close(peer_fd);
+        }
+    }
+};
+
+TEST(HCI_TRANSPORT_LINUX, SynchronousTransport){
+    POINTERS_EQUAL(NULL, transport->can_send_packet_now);
+}
+
+TEST(HCI_TRANSPORT_LINUX, SendPackets){
+    const uint8_t reset_command[] = { 0x03, 0x0c, 0x00 };
+    uint8_t acl_packet[100];
+    memset(acl_packet, 0xaa, sizeof(acl_packet));
+    little_endian_store_16(acl_packet, 0, 0x0040);
+    little_endian_store_16(acl_packet, 2, sizeof(acl_packet) - 4);
+    CHECK_EQUAL(0, transport->send_packet(HCI_COMMAND_DATA_PACKET, (uint8_t *) reset_command, sizeof(reset_command)));
+    CHECK_EQUAL(0, transport->send_packet(HCI_ACL_DATA_PACKET, acl_packet, sizeof(acl_packet)));
+
+    // one message per packet with H4 packet type
+    uint8_t buffer[200];
+    CHECK_EQUAL(1 + sizeof(reset_command), read(peer_fd, buffer, sizeof(buffer)));
+    CHECK_EQUAL(HCI_COMMAND_DATA_PACKET, buffer[0]);
+    MEMCMP_EQUAL(reset_command, &buffer[1], sizeof(reset_command));
+    CHECK_EQUAL(1 + sizeof(acl_packet), read(peer_fd, buffer, sizeof(buffer)));
+    CHECK_EQUAL(HCI_ACL_DATA_PACKET, buffer[0]);
+    MEMCMP_EQUAL(acl_packet, &buffer[1], sizeof(acl_packet));
+}
+
+TEST(HCI_TRANSPORT_LINUX, ReceivePacketsInBatches){
+    // more packets than read per wakeup
+    uint8_t i;
+    num_packets_expected = 7;
+    for (i = 0; i < num_packets_expected; i++){
+        if (i & 1){
+            uint8_t acl_packet[HCI_ACL_BUFFER_SIZE];
+            memset(acl_packet, i, sizeof(acl_packet));
+            little_endian_store_16(acl_packet, 0, 0x0040);
+            little_endian_store_16(acl_packet, 2, HCI_ACL_PAYLOAD_SIZE);
+            peer_send(HCI_ACL_DATA_PACKET, acl_packet, sizeof(acl_packet));
+        } else {
+            const uint8_t event[] = { 0xff, 0x01, i };
+            peer_send(HCI_EVENT_PACKET, event, sizeof(event));
+        }
+    }
+    run_loop_execute_with_timeout(TEST_TIMEOUT_MS);
+    CHECK(!timeout_reached);
+    CHECK_EQUAL(num_packets_expected, num_packets_received);
+    for (i = 0; i < num_packets_expected; i++){
+        received_packet_t * received_packet = &received_packets[i];
+        CHECK(received_packet->pre_buffer_writable);
+        if (i & 1){
+            CHECK_EQUAL(HCI_ACL_DATA_PACKET, received_packet->packet_type);
+            CHECK_EQUAL(HCI_ACL_BUFFER_SIZE, received_packet->size);
+            CHECK_EQUAL(i, received_packet->data[HCI_ACL_BUFFER_SIZE - 1]);
+        } else {
+            CHECK_EQUAL(HCI_EVENT_PACKET, received_packet->packet_type);
+            CHECK_EQUAL(3, received_packet->size);
+            CHECK_EQUAL(i, received_packet->data[2]);
+        }
+    }
+}
+
+TEST(HCI_TRANSPORT_LINUX, PeerClosed){
+    const uint8_t event[] = { 0xff, 0x01, 0x00 };
+    peer_send(HCI_EVENT_PACKET, event, sizeof(event));
+    close(peer_fd);
+    peer_fd = -1;
+    num_packets_expected = 2;
+    // packet before close is delivered, closed socket is not reported as packet
+    run_loop_execute_with_timeout(100);
+    CHECK(timeout_reached);
+    CHECK_EQUAL(1, num_packets_received);
+}
+
+TEST(HCI_TRANSPORT_LINUX, SendAfterClose){
+    transport->close();
+    const uint8_t reset_command[] = { 0x03, 0x0c, 0x00 };
+    CHECK_EQUAL(-1, transport->send_packet(HCI_COMMAND_DATA_PACKET, (uint8_t *) reset_command, sizeof(reset_command)));
+}
+
+static uint8_t second_instance_packets_received;
+static uint8_t second_instance_last_event;
+
+static void second_instance_packet_handler(uint8_t packet_type, uint8_t *packet, uint16_t size){
+    UNUSED(size);
+    CHECK_EQUAL(HCI_EVENT_PACKET, packet_type);
+    second_instance_packets_received++;
+    second_instance_last_event = packet[2];
+    if (second_instance_packets_received == 1u){
+        btstack_run_loop_posix_trigger_exit();
+    }
+}
+
+TEST_GROUP(HCI_TRANSPORT_LINUX_MULTIPLE_INSTANCES){
+    const hci_transport_t * transports[2];
+    int peer_fds[2];
+    void setup(void){
+        num_packets_received = 0;
+        num_packets_expected = 1;
+        second_instance_packets_received = 0;
+        second_instance_last_event = 0;
+        timeout_reached = false;
+        uint8_t i;
+        for (i = 0; i < 2; i++){
+            int fds[2];
+            CHECK_EQUAL(0, socketpair(AF_UNIX, SOCK_SEQPACKET, 0, fds));
+            peer_fds[i] = fds[1];
+            transports[i] = hci_transport_linux_instance_for_hci_index(1 + i);
+            CHECK(transports[i] != NULL);
+            hci_transport_linux_set_socket_for_hci_index(1 + i, fds[0]);
+        }
+        transports[0]->register_packet_handler(&host_packet_handler);
+        transports[1]->register_packet_handler(&second_instance_packet_handler);
+        CHECK_EQUAL(0, transports[0]->open());
+        CHECK_EQUAL(0, transports[1]->open());
+    }
+    void teardown(void){
+        uint8_t i;
+        for (i = 0; i < 2; i++){
+            transports[i]->close();
+            close(peer_fds[i]);
+        }
+    }
+};
+
+TEST(HCI_TRANSPORT_LINUX_MULTIPLE_INSTANCES, SeparateInstances){
+    // default instance and instances for other HCI devices differ
+    CHECK(transports[0] != transports[1]);
+    CHECK(transports[0] != hci_transport_linux_instance());
+    CHECK(transports[1] != hci_transport_linux_instance());
+    POINTERS_EQUAL(transports[0], hci_transport_linux_instance_for_hci_index(1));
+    // no more instances than configured
+    POINTERS_EQUAL(NULL, hci_transport_linux_instance_for_hci_index(3));
+}
+
+TEST(HCI_TRANSPORT_LINUX_MULTIPLE_INSTANCES, SendUsesSocketOfInstance){
+    const uint8_t reset_command[] = { 0x03, 0x0c, 0x00 };
+    CHECK_EQUAL(0, transports[1]->send_packet(HCI_COMMAND_DATA_PACKET, (uint8_t *) reset_command, sizeof(reset_command)));
+    uint8_t buffer[10];
+    CHECK_EQUAL(1 + sizeof(reset_command), read(peer_fds[1], buffer, sizeof(buffer)));
+    CHECK_EQUAL(-1, recv(peer_fds[0], buffer, sizeof(buffer), MSG_DONTWAIT));
+}
+
+TEST(HCI_TRANSPORT_LINUX_MULTIPLE_INSTANCES, ReceiveUsesHandlerOfInstance){
+    const uint8_t event[] = { 0xff, 0x01, 0x22 };
+    uint8_t buffer[4];
+    buffer[0] = HCI_EVENT_PACKET;
+    memcpy(&buffer[1], event, sizeof(event));
+    CHECK_EQUAL(sizeof(buffer), write(peer_fds[1], buffer, sizeof(buffer)));
+    run_loop_execute_with_timeout(TEST_TIMEOUT_MS);
+    CHECK(!timeout_reached);
+    CHECK_EQUAL(0, num_packets_received);
+    CHECK_EQUAL(1, second_instance_packets_received);
+    CHECK_EQUAL(0x22, second_instance_last_event);
+}
+
+int main (int argc, const char * argv[]){
+    btstack_run_loop_init(btstack_run_loop_posix_get_instance());
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
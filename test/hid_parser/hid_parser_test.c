@@ -14,6 +14,7 @@
 #include "CppUTest/TestHarness.h"
 #include "CppUTest/CommandLineTestRunner.h"
 
+#include "bluetooth.h"
 #include "btstack_hid_parser.h"
 
 const uint8_t mouse_descriptor_without_report_id[] = {
@@ -344,6 +345,143 @@ TEST(HID, GetReportSize){
 }
 
 
+// compiled report layout
+
+static btstack_hid_report_layout_t hid_layout;
+static btstack_hid_report_t hid_layout_reports[8];
+static btstack_hid_field_t  hid_layout_fields[16];
+
+static void compile_layout(const uint8_t * hid_descriptor, uint16_t hid_descriptor_len){
+    btstack_hid_report_layout_init(&hid_layout, hid_layout_reports, 8, hid_layout_fields, 16);
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, btstack_hid_report_layout_compile(&hid_layout, hid_descriptor_len, hid_descriptor));
+}
+
+// compiled layout must report the same fields as the single-pass parser
+static void expect_same_fields(const uint8_t * hid_descriptor, uint16_t hid_descriptor_len, const uint8_t * report, uint16_t report_len){
+    static btstack_hid_parser_t hid_parser;
+    btstack_hid_report_iterator_t iterator;
+    compile_layout(hid_descriptor, hid_descriptor_len);
+    btstack_hid_parser_init(&hid_parser, hid_descriptor, hid_descriptor_len, HID_REPORT_TYPE_INPUT, report, report_len);
+    btstack_hid_report_iterator_init(&iterator, &hid_layout, HID_REPORT_TYPE_INPUT, report, report_len);
+    int num_fields = 0;
+    while (btstack_hid_parser_has_more(&hid_parser)){
+        uint16_t usage_page;
+        uint16_t usage;
+        int32_t value;
+        btstack_hid_parser_get_field(&hid_parser, &usage_page, &usage, &value);
+        CHECK_EQUAL(1, btstack_hid_report_iterator_has_more(&iterator));
+        uint16_t compiled_usage_page;
+        uint16_t compiled_usage;
+        int32_t compiled_value;
+        btstack_hid_report_iterator_get_field(&iterator, &compiled_usage_page, &compiled_usage, &compiled_value);
+        CHECK_EQUAL(usage_page, compiled_usage_page);
+        CHECK_EQUAL(usage, compiled_usage);
+        CHECK_EQUAL(value, compiled_value);
+        num_fields++;
+    }
+    CHECK(num_fields > 0);
+    CHECK_EQUAL(0, btstack_hid_report_iterator_has_more(&iterator));
+}
+
+TEST(HID, LayoutSameFieldsAsParser){
+    expect_same_fields(mouse_descriptor_without_report_id, sizeof(mouse_descriptor_without_report_id), mouse_report_without_id_positive_xy, sizeof(mouse_report_without_id_positive_xy));
+    expect_same_fields(mouse_descriptor_without_report_id, sizeof(mouse_descriptor_without_report_id), mouse_report_without_id_negative_xy, sizeof(mouse_report_without_id_negative_xy));
+    expect_same_fields(mouse_descriptor_with_report_id, sizeof(mouse_descriptor_with_report_id), mouse_report_with_id_1, sizeof(mouse_report_with_id_1));
+    expect_same_fields(hid_descriptor_keyboard_boot_mode, sizeof(hid_descriptor_keyboard_boot_mode), keyboard_report1, sizeof(keyboard_report1));
+    expect_same_fields(combo_descriptor_with_report_ids, sizeof(combo_descriptor_with_report_ids), combo_report1, sizeof(combo_report1));
+    expect_same_fields(combo_descriptor_with_report_ids, sizeof(combo_descriptor_with_report_ids), combo_report2, sizeof(combo_report2));
+}
+
+TEST(HID, LayoutMouse){
+    compile_layout(mouse_descriptor_without_report_id, sizeof(mouse_descriptor_without_report_id));
+    CHECK_EQUAL(1, hid_layout.num_reports);
+    // buttons and X/Y merged into single fields, padding skipped
+    CHECK_EQUAL(2, hid_layout.num_fields);
+    const btstack_hid_field_t * xy = &hid_layout_fields[1];
+    CHECK_EQUAL(8, xy->bit_offset);
+    CHECK_EQUAL(8, xy->report_size);
+    CHECK_EQUAL(2, xy->report_count);
+    CHECK_EQUAL(-127, xy->logical_minimum);
+    CHECK_EQUAL(127, xy->logical_maximum);
+    CHECK_EQUAL(0x10030, xy->usage_minimum);
+    CHECK_EQUAL(0x10031, xy->usage_maximum);
+}
+
+TEST(HID, LayoutGetReportSize){
+    compile_layout(combo_descriptor_with_report_ids, sizeof(combo_descriptor_with_report_ids));
+    CHECK_EQUAL(3, btstack_hid_report_layout_get_report_size(&hid_layout, 1, HID_REPORT_TYPE_INPUT));
+    CHECK_EQUAL(0, btstack_hid_report_layout_get_report_size(&hid_layout, 3, HID_REPORT_TYPE_INPUT));
+    CHECK_EQUAL(1, btstack_hid_report_layout_report_id_declared(&hid_layout));
+    CHECK_EQUAL(HID_REPORT_ID_VALID,   btstack_hid_report_layout_id_valid(&hid_layout, 2));
+    CHECK_EQUAL(HID_REPORT_ID_INVALID, btstack_hid_report_layout_id_valid(&hid_layout, 3));
+
+    compile_layout(hid_descriptor_keyboard_boot_mode, sizeof(hid_descriptor_keyboard_boot_mode));
+    CHECK_EQUAL(1, btstack_hid_report_layout_get_report_size(&hid_layout, 0, HID_REPORT_TYPE_OUTPUT));
+    CHECK_EQUAL(8, btstack_hid_report_layout_get_report_size(&hid_layout, 0, HID_REPORT_TYPE_INPUT));
+    CHECK_EQUAL(0, btstack_hid_report_layout_report_id_declared(&hid_layout));
+    CHECK_EQUAL(HID_REPORT_ID_UNDECLARED, btstack_hid_report_layout_id_valid(&hid_layout, 0));
+}
+
+TEST(HID, LayoutWithoutFields){
+    btstack_hid_report_layout_init(&hid_layout, hid_layout_reports, 8, NULL, 0);
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, btstack_hid_report_layout_compile(&hid_layout, sizeof(combo_descriptor_with_report_ids), combo_descriptor_with_report_ids));
+    CHECK_EQUAL(0, hid_layout.num_fields);
+    CHECK_EQUAL(3, btstack_hid_report_layout_get_report_size(&hid_layout, 1, HID_REPORT_TYPE_INPUT));
+}
+
+TEST(HID, LayoutTooSmall){
+    btstack_hid_report_layout_init(&hid_layout, hid_layout_reports, 1, hid_layout_fields, 16);
+    CHECK_EQUAL(ERROR_CODE_MEMORY_CAPACITY_EXCEEDED, btstack_hid_report_layout_compile(&hid_layout, sizeof(combo_descriptor_with_report_ids), combo_descriptor_with_report_ids));
+    btstack_hid_report_layout_init(&hid_layout, hid_layout_reports, 8, hid_layout_fields, 1);
+    CHECK_EQUAL(ERROR_CODE_MEMORY_CAPACITY_EXCEEDED, btstack_hid_report_layout_compile(&hid_layout, sizeof(mouse_descriptor_without_report_id), mouse_descriptor_without_report_id));
+}
+
+TEST(HID, LayoutFindUsageAndEncode){
+    compile_layout(mouse_descriptor_with_report_id, sizeof(mouse_descriptor_with_report_id));
+    const btstack_hid_report_t * report = btstack_hid_report_layout_get_report(&hid_layout, HID_REPORT_TYPE_INPUT, 1);
+    CHECK(report != NULL);
+    uint8_t report_data[3];
+    memset(report_data, 0, sizeof(report_data));
+
+    uint16_t element;
+    const btstack_hid_field_t * field = btstack_hid_report_layout_find_usage(&hid_layout, report, 1, 0x31, &element);
+    CHECK(field != NULL);
+    CHECK_EQUAL(1, element);
+    btstack_hid_field_set_value(field, element, -3, report_data, sizeof(report_data));
+    btstack_hid_field_set_value(field, 0, 2, report_data, sizeof(report_data));
+
+    field = btstack_hid_report_layout_find_usage(&hid_layout, report, 9, 2, &element);
+    CHECK(field != NULL);
+    btstack_hid_field_set_value(field, element, 1, report_data, sizeof(report_data));
+    CHECK_EQUAL(1, btstack_hid_field_get_value(field, element, report_data, sizeof(report_data)));
+    CHECK_EQUAL(0, btstack_hid_field_get_value(field, 0, report_data, sizeof(report_data)));
+
+    const uint8_t expected_report_data[] = { 0x02, 0x02, 0xfd };
+    MEMCMP_EQUAL(expected_report_data, report_data, sizeof(report_data));
+
+    CHECK(btstack_hid_report_layout_find_usage(&hid_layout, report, 1, 0x38, &element) == NULL);
+}
+
+TEST(HID, LayoutValueAcrossBytes){
+    btstack_hid_field_t field;
+    memset(&field, 0, sizeof(field));
+    field.bit_offset   = 4;
+    field.report_size  = 12;
+    field.report_count = 2;
+    field.logical_minimum = -2048;
+    uint8_t report_data[4];
+    memset(report_data, 0xff, sizeof(report_data));
+    btstack_hid_field_set_value(&field, 0, 0x123, report_data, sizeof(report_data));
+    btstack_hid_field_set_value(&field, 1, -2, report_data, sizeof(report_data));
+    const uint8_t expected_report_data[] = { 0x3f, 0x12, 0xfe, 0xff };
+    MEMCMP_EQUAL(expected_report_data, report_data, sizeof(report_data));
+    CHECK_EQUAL(0x123, btstack_hid_field_get_value(&field, 0, report_data, sizeof(report_data)));
+    CHECK_EQUAL(-2, btstack_hid_field_get_value(&field, 1, report_data, sizeof(report_data)));
+    // bits past report end read as 0
+    CHECK_EQUAL(0xfe, btstack_hid_field_get_value(&field, 1, report_data, 3));
+}
+
+
 int main (int argc, const char * argv[]){
     // hci_dump_open("hci_dump.pklg", HCI_DUMP_PACKETLOGGER);
     return CommandLineTestRunner::RunAllTests(argc, argv);
@@ -0,0 +1,343 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/CommandLineTestRunner.h"
+#include "bluetooth.h"
+#include "btstack_jitter_buffer.h"
+
+#define SAMPLE_RATE        44100
+#define NUM_SLOTS          32
+#define MAX_PAYLOAD_LEN    64
+#define FRAMES_PER_PACKET  4
+#define FRAME_LEN          10
+#define SAMPLES_PER_FRAME  128
+#define SAMPLES_PER_PACKET (FRAMES_PER_PACKET * SAMPLES_PER_FRAME)
+
+static btstack_jitter_buffer_t      jitter_buffer;
+static btstack_jitter_buffer_slot_t slots[NUM_SLOTS];
+static uint8_t                      payload_storage[NUM_SLOTS * MAX_PAYLOAD_LEN];
+
+// packet duration in us
+static const uint32_t packet_duration_us = (SAMPLES_PER_PACKET * 1000000u) / SAMPLE_RATE;
+
+// frame content: sequence number and frame index
+static void add_packet_with_timestamp(uint16_t sequence_number, uint32_t timestamp, uint32_t arrival_time_ms){
+    uint8_t payload[FRAMES_PER_PACKET * FRAME_LEN];
+    int i;
+    for (i = 0; i < FRAMES_PER_PACKET; i++){
+        memset(&payload[i * FRAME_LEN], 0, FRAME_LEN);
+        payload[i * FRAME_LEN]     = (uint8_t) sequence_number;
+        payload[i * FRAME_LEN + 1] = (uint8_t) i;
+    }
+    int status = btstack_jitter_buffer_add_packet(&jitter_buffer, sequence_number, timestamp,
+                                                  arrival_time_ms, payload, sizeof(payload), FRAMES_PER_PACKET, SAMPLES_PER_PACKET);
+    CHECK_EQUAL(0, status);
+}
+
+static void add_packet(uint16_t sequence_number, uint32_t arrival_time_ms){
+    add_packet_with_timestamp(sequence_number, (uint32_t) sequence_number * SAMPLES_PER_PACKET, arrival_time_ms);
+}
+
+static uint32_t nominal_arrival_time_ms(uint16_t sequence_number){
+    return (uint32_t) (((uint64_t) sequence_number * packet_duration_us) / 1000u);
+}
+
+// add packets with nominal arrival time
+static void add_packets(uint16_t first_sequence_number, int num_packets){
+    int i;
+    for (i = 0; i < num_packets; i++){
+        uint16_t sequence_number = first_sequence_number + i;
+        add_packet(sequence_number, nominal_arrival_time_ms(sequence_number));
+    }
+}
+
+static void check_packet(uint16_t sequence_number){
+    int i;
+    for (i = 0; i < FRAMES_PER_PACKET; i++){
+        uint16_t frame_len = 0;
+        const uint8_t * frame = btstack_jitter_buffer_get_frame(&jitter_buffer, &frame_len);
+        CHECK(frame != NULL);
+        CHECK_EQUAL(FRAME_LEN, frame_len);
+        CHECK_EQUAL((uint8_t) sequence_number, frame[0]);
+        CHECK_EQUAL(i, frame[1]);
+    }
+}
+
+TEST_GROUP(JitterBuffer){
+    const btstack_jitter_buffer_statistics_t * statistics;
+
+    void setup(void){
+        btstack_jitter_buffer_init(&jitter_buffer, slots, payload_storage, NUM_SLOTS, MAX_PAYLOAD_LEN, SAMPLE_RATE);
+        statistics = btstack_jitter_buffer_get_statistics(&jitter_buffer);
+    }
+};
+
+TEST(JitterBuffer, BufferToTargetLatency){
+    uint16_t frame_len;
+    CHECK_EQUAL(40, statistics->target_latency_ms);
+    // 4 packets of 11.6 ms needed for 40 ms
+    add_packets(0, 3);
+    CHECK_FALSE(btstack_jitter_buffer_is_playing(&jitter_buffer));
+    CHECK(btstack_jitter_buffer_get_frame(&jitter_buffer, &frame_len) == NULL);
+    CHECK_EQUAL(0, statistics->underruns);
+    add_packets(3, 1);
+    CHECK_TRUE(btstack_jitter_buffer_is_playing(&jitter_buffer));
+    CHECK_EQUAL(46, statistics->latency_ms);
+    check_packet(0);
+    CHECK_EQUAL(34, statistics->latency_ms);
+}
+
+TEST(JitterBuffer, TargetLatencyRange){
+    btstack_jitter_buffer_set_target_latency_range(&jitter_buffer, 100, 50);
+    CHECK_EQUAL(100, jitter_buffer.target_samples * 1000 / SAMPLE_RATE);
+    add_packets(0, 8);
+    CHECK_FALSE(btstack_jitter_buffer_is_playing(&jitter_buffer));
+    add_packets(8, 1);
+    CHECK_TRUE(btstack_jitter_buffer_is_playing(&jitter_buffer));
+}
+
+TEST(JitterBuffer, Reorder){
+    add_packet(10, nominal_arrival_time_ms(10));
+    add_packet(12, nominal_arrival_time_ms(12));
+    add_packet(11, nominal_arrival_time_ms(12));
+    add_packet(13, nominal_arrival_time_ms(13));
+    add_packet(14, nominal_arrival_time_ms(14));
+    check_packet(10);
+    check_packet(11);
+    check_packet(12);
+    check_packet(13);
+    check_packet(14);
+    CHECK_EQUAL(0, statistics->packets_lost);
+}
+
+TEST(JitterBuffer, Duplicate){
+    add_packets(0, 4);
+    add_packets(2, 1);
+    CHECK_EQUAL(1, statistics->packets_duplicate);
+    CHECK_EQUAL(5, statistics->packets_received);
+    check_packet(0);
+    check_packet(1);
+    check_packet(2);
+    check_packet(3);
+}
+
+TEST(JitterBuffer, Late){
+    add_packets(5, 4);
+    check_packet(5);
+    add_packets(4, 1);
+    add_packets(5, 1);
+    CHECK_EQUAL(2, statistics->packets_late);
+    check_packet(6);
+}
+
+TEST(JitterBuffer, LostPacketIsSkipped){
+    add_packets(0, 2);
+    add_packets(3, 3);
+    check_packet(0);
+    check_packet(1);
+    check_packet(3);
+    CHECK_EQUAL(1, statistics->packets_lost);
+    check_packet(4);
+}
+
+TEST(JitterBuffer, UnderrunRebuffers){
+    uint16_t frame_len;
+    add_packets(0, 4);
+    int i;
+    for (i = 0; i < 4; i++){
+        check_packet(i);
+    }
+    CHECK(btstack_jitter_buffer_get_frame(&jitter_buffer, &frame_len) == NULL);
+    CHECK_EQUAL(1, statistics->underruns);
+    CHECK_FALSE(btstack_jitter_buffer_is_playing(&jitter_buffer));
+    add_packets(4, 3);
+    CHECK_FALSE(btstack_jitter_buffer_is_playing(&jitter_buffer));
+    add_packets(7, 1);
+    check_packet(4);
+    CHECK_EQUAL(1, statistics->underruns);
+}
+
+TEST(JitterBuffer, Overflow){
+    add_packets(0, NUM_SLOTS + 2);
+    CHECK_EQUAL(2, statistics->packets_dropped_overflow);
+    check_packet(2);
+}
+
+TEST(JitterBuffer, Resync){
+    add_packets(0, 4);
+    add_packets(5000, 2);
+    CHECK_EQUAL(1, statistics->resyncs);
+    CHECK_FALSE(btstack_jitter_buffer_is_playing(&jitter_buffer));
+    add_packets(5002, 2);
+    check_packet(5000);
+}
+
+TEST(JitterBuffer, PayloadTooLarge){
+    uint8_t payload[MAX_PAYLOAD_LEN + 1];
+    memset(payload, 0, sizeof(payload));
+    CHECK_EQUAL(ERROR_CODE_MEMORY_CAPACITY_EXCEEDED,
+                btstack_jitter_buffer_add_packet(&jitter_buffer, 0, 0, 0, payload, sizeof(payload), 1, SAMPLES_PER_FRAME));
+    CHECK_EQUAL(0, statistics->packets_received);
+}
+
+TEST(JitterBuffer, RegularStreamKeepsMinTarget){
+    add_packets(0, 200);
+    CHECK(statistics->jitter_us < 1000);
+    CHECK_EQUAL(40, statistics->target_latency_ms);
+}
+
+TEST(JitterBuffer, BurstsIncreaseTarget){
+    // 8 packets (93 ms) in a burst
+    uint16_t sequence_number;
+    for (sequence_number = 0; sequence_number < 200; sequence_number++){
+        uint32_t burst_time_ms = (uint32_t) ((((uint64_t) (sequence_number & ~7u) + 8u) * packet_duration_us) / 1000u);
+        add_packet(sequence_number, burst_time_ms);
+        uint16_t frame_len;
+        while (btstack_jitter_buffer_get_frame(&jitter_buffer, &frame_len) != NULL) {
+            if (jitter_buffer.buffered_samples <= jitter_buffer.target_samples) break;
+        }
+    }
+    CHECK(statistics->jitter_us > 20000);
+    CHECK(statistics->target_latency_ms > 93);
+    CHECK(statistics->target_latency_ms <= 300);
+    CHECK(statistics->latency_max_ms >= statistics->target_latency_ms);
+}
+
+TEST(JitterBuffer, TargetLimitedBySlots){
+    btstack_jitter_buffer_init(&jitter_buffer, slots, payload_storage, 8, MAX_PAYLOAD_LEN, SAMPLE_RATE);
+    uint16_t sequence_number;
+    for (sequence_number = 0; sequence_number < 100; sequence_number++){
+        add_packet(sequence_number, (sequence_number & 1) ? 0 : (uint32_t) sequence_number * 100u);
+        btstack_jitter_buffer_reset(&jitter_buffer);
+    }
+    add_packet(0, 0);
+    add_packet(1, 200);
+    CHECK_EQUAL((4 * SAMPLES_PER_PACKET * 1000) / SAMPLE_RATE, statistics->target_latency_ms);
+}
+
+static void simulate_drift(int32_t drift_ppm, uint32_t max_delay_ms){
+    srand(1);
+    // sender clock is (1 + drift) times faster
+    uint64_t packet_duration_ns = ((uint64_t) SAMPLES_PER_PACKET * 1000000000u * 1000000u) / ((uint64_t) SAMPLE_RATE * (uint64_t) (1000000 + drift_ppm));
+    uint16_t sequence_number;
+    int num_packets = (60 * 1000000) / packet_duration_us;
+    int i;
+    for (i = 0; i < num_packets; i++){
+        sequence_number = (uint16_t) i;
+        uint32_t delay_ms = (max_delay_ms == 0u) ? 0u : ((uint32_t) rand() % max_delay_ms);
+        uint32_t arrival_time_ms = (uint32_t) ((i * packet_duration_ns) / 1000000u) + delay_ms;
+        add_packet(sequence_number, arrival_time_ms);
+        uint16_t frame_len;
+        while (jitter_buffer.buffered_samples > jitter_buffer.target_samples){
+            btstack_jitter_buffer_get_frame(&jitter_buffer, &frame_len);
+        }
+    }
+}
+
+TEST(JitterBuffer, DriftSenderFaster){
+    simulate_drift(100, 0);
+    CHECK(statistics->drift_ppm > 70);
+    CHECK(statistics->drift_ppm < 130);
+    // drift plus deviation from target latency
+    int32_t level = ((int32_t) jitter_buffer.buffered_samples - (int32_t) jitter_buffer.target_samples) * 0x100 / (int32_t) jitter_buffer.target_samples;
+    CHECK_EQUAL((uint32_t) (0x10000 + ((statistics->drift_ppm * 0x10000) / 1000000) + level), btstack_jitter_buffer_get_resampling_factor(&jitter_buffer));
+}
+
+TEST(JitterBuffer, DriftSenderSlowerWithJitter){
+    simulate_drift(-200, 20);
+    CHECK(statistics->drift_ppm < -150);
+    CHECK(statistics->drift_ppm > -250);
+}
+
+TEST(JitterBuffer, ResamplingFactor){
+    CHECK_EQUAL(0x10000, btstack_jitter_buffer_get_resampling_factor(&jitter_buffer));
+    add_packets(0, 8);
+    // twice the target: max compensation
+    CHECK_TRUE(btstack_jitter_buffer_is_playing(&jitter_buffer));
+    CHECK(jitter_buffer.buffered_samples >= 2 * jitter_buffer.target_samples);
+    CHECK_EQUAL(0x10100, btstack_jitter_buffer_get_resampling_factor(&jitter_buffer));
+    int i;
+    for (i = 0; i < 6; i++){
+        check_packet(i);
+    }
+    CHECK(btstack_jitter_buffer_get_resampling_factor(&jitter_buffer) < 0x10000);
+}
+
+// sequence numbers wrap from 65535 to 0, slots are not a power of two
+#define NUM_SLOTS_WRAP 10
+
+static void add_packets_wrapping(uint16_t first_sequence_number, uint32_t first_index, int num_packets){
+    int i;
+    for (i = 0; i < num_packets; i++){
+        uint32_t index = first_index + i;
+        add_packet_with_timestamp((uint16_t) (first_sequence_number + i), index * SAMPLES_PER_PACKET,
+                                  (uint32_t) (((uint64_t) index * packet_duration_us) / 1000u));
+    }
+}
+
+TEST_GROUP(JitterBufferSequenceWrap){
+    const btstack_jitter_buffer_statistics_t * statistics;
+
+    void setup(void){
+        btstack_jitter_buffer_init(&jitter_buffer, slots, payload_storage, NUM_SLOTS_WRAP, MAX_PAYLOAD_LEN, SAMPLE_RATE);
+        statistics = btstack_jitter_buffer_get_statistics(&jitter_buffer);
+    }
+};
+
+TEST(JitterBufferSequenceWrap, AllSlotsUsed){
+    // 65530..65535, 0..3
+    add_packets_wrapping(65530, 0, NUM_SLOTS_WRAP);
+    CHECK_EQUAL(NUM_SLOTS_WRAP, jitter_buffer.num_packets);
+    CHECK_EQUAL(NUM_SLOTS_WRAP * SAMPLES_PER_PACKET, jitter_buffer.buffered_samples);
+    CHECK_EQUAL(0, statistics->packets_dropped_overflow);
+    CHECK_EQUAL(0, statistics->packets_duplicate);
+    int i;
+    for (i = 0; i < NUM_SLOTS_WRAP; i++){
+        check_packet((uint16_t) (65530 + i));
+    }
+    CHECK_EQUAL(0, statistics->packets_lost);
+    CHECK_EQUAL(0, jitter_buffer.num_packets);
+    CHECK_EQUAL(0, jitter_buffer.buffered_samples);
+}
+
+TEST(JitterBufferSequenceWrap, OverflowDropsOldest){
+    // 65533..65535, 0..9: first three packets are dropped
+    add_packets_wrapping(65533, 0, NUM_SLOTS_WRAP + 3);
+    CHECK_EQUAL(3, statistics->packets_dropped_overflow);
+    CHECK_EQUAL(NUM_SLOTS_WRAP, jitter_buffer.num_packets);
+    CHECK_EQUAL(NUM_SLOTS_WRAP * SAMPLES_PER_PACKET, jitter_buffer.buffered_samples);
+    int i;
+    for (i = 0; i < NUM_SLOTS_WRAP; i++){
+        check_packet((uint16_t) i);
+    }
+    CHECK_EQUAL(0, statistics->packets_lost);
+}
+
+TEST(JitterBufferSequenceWrap, DuplicateAfterWrap){
+    add_packets_wrapping(65534, 0, 4);
+    add_packets_wrapping(1, 3, 1);
+    CHECK_EQUAL(1, statistics->packets_duplicate);
+    CHECK_EQUAL(4, jitter_buffer.num_packets);
+    check_packet(65534);
+    check_packet(65535);
+    check_packet(0);
+    check_packet(1);
+}
+
+TEST(JitterBufferSequenceWrap, ContinuousPlayout){
+    // play one packet per packet received over several wraps of the slot index
+    add_packets_wrapping(65500, 0, 5);
+    uint32_t index;
+    for (index = 5; index < 100; index++){
+        check_packet((uint16_t) (65500 + index - 5));
+        add_packets_wrapping((uint16_t) (65500 + index), index, 1);
+        CHECK_EQUAL(5, jitter_buffer.num_packets);
+    }
+    CHECK_EQUAL(0, statistics->packets_lost);
+    CHECK_EQUAL(0, statistics->packets_dropped_overflow);
+}
+
+int main (int argc, const char * argv[]){
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
@@ -0,0 +1,507 @@
+// L2CAP LE Enhanced Credit-Based Flow Control Mode: multi-channel connect, reconfigure and credits
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/CommandLineTestRunner.h"
+
+#include "btstack_debug.h"
+#include "btstack_event.h"
+#include "btstack_memory.h"
+#include "btstack_run_loop.h"
+#include "btstack_run_loop_posix.h"
+#include "btstack_util.h"
+#include "hci.h"
+#include "l2cap.h"
+#include "l2cap_signaling.h"
+#include "mock_hci_transport.h"
+
+#define TEST_SPSM           0x0080
+#define TEST_UNKNOWN_SPSM   0x0082
+#define TEST_REMOTE_MTU     300
+#define TEST_REMOTE_MPS     100
+#define TEST_LOCAL_MTU      200
+#define TEST_MAX_CHANNELS   L2CAP_ECBM_MAX_CID_ARRAY_SIZE
+
+static const hci_con_handle_t con_handle = 0x0040;
+static bd_addr_t remote_addr = { 0x11, 0x22, 0x33, 0x44, 0x55, 0x66 };
+
+static uint8_t  receive_buffers[TEST_MAX_CHANNELS][1000];
+static uint8_t  remote_sig_id;
+
+// incoming connection
+static uint16_t incoming_local_cid;
+static uint8_t  incoming_num_channels;
+
+// channel opened events
+static uint16_t opened_local_cids[TEST_MAX_CHANNELS];
+static uint8_t  opened_status[TEST_MAX_CHANNELS];
+static uint16_t opened_remote_mtus[TEST_MAX_CHANNELS];
+static uint8_t  num_opened;
+
+// reconfiguration events
+static uint8_t  num_reconfigured;
+static uint16_t reconfigured_remote_mtu;
+static uint8_t  num_reconfiguration_complete;
+static uint16_t reconfiguration_result;
+
+static uint8_t  num_sdus;
+static uint16_t last_sdu_cid;
+static uint16_t last_sdu_len;
+static uint8_t  num_packets_sent;
+
+static void l2cap_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
+    switch (packet_type){
+        case L2CAP_DATA_PACKET:
+            num_sdus++;
+            last_sdu_cid = channel;
+            last_sdu_len = size;
+            break;
+        case HCI_EVENT_PACKET:
+            switch (hci_event_packet_get_type(packet)){
+                case L2CAP_EVENT_ECBM_INCOMING_CONNECTION:
+                    incoming_local_cid = l2cap_event_ecbm_incoming_connection_get_local_cid(packet);
+                    incoming_num_channels = l2cap_event_ecbm_incoming_connection_get_num_channels(packet);
+                    CHECK_EQUAL(TEST_SPSM, l2cap_event_ecbm_incoming_connection_get_psm(packet));
+                    break;
+                case L2CAP_EVENT_ECBM_CHANNEL_OPENED:
+                    if (num_opened < TEST_MAX_CHANNELS){
+                        opened_local_cids[num_opened]  = l2cap_event_ecbm_channel_opened_get_local_cid(packet);
+                        opened_status[num_opened]      = l2cap_event_ecbm_channel_opened_get_status(packet);
+                        opened_remote_mtus[num_opened] = l2cap_event_ecbm_channel_opened_get_remote_mtu(packet);
+                    }
+                    num_opened++;
+                    break;
+                case L2CAP_EVENT_ECBM_RECONFIGURED:
+                    num_reconfigured++;
+                    reconfigured_remote_mtu = l2cap_event_ecbm_reconfigured_get_remote_mtu(packet);
+                    break;
+                case L2CAP_EVENT_ECBM_RECONFIGURATION_COMPLETE:
+                    num_reconfiguration_complete++;
+                    reconfiguration_result = little_endian_read_16(packet, 4);
+                    break;
+                case L2CAP_EVENT_LE_PACKET_SENT:
+                    num_packets_sent++;
+                    break;
+                default:
+                    break;
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+static void receive_signaling_with_identifier(uint8_t code, uint8_t identifier, const uint8_t * data, uint16_t len){
+    uint8_t packet[100];
+    packet[0] = code;
+    packet[1] = identifier;
+    little_endian_store_16(packet, 2, len);
+    (void)memcpy(&packet[4], data, len);
+    mock_hci_transport_receive_l2cap_packet(con_handle, L2CAP_CID_SIGNALING_LE, packet, 4 + len);
+    mock_hci_transport_process();
+}
+
+static void receive_signaling(uint8_t code, const uint8_t * data, uint16_t len){
+    receive_signaling_with_identifier(code, ++remote_sig_id, data, len);
+}
+
+// @return last signaling command with code sent by BTstack or NULL
+static const uint8_t * find_signaling(uint8_t code){
+    uint16_t num_packets = mock_hci_transport_num_l2cap_packets();
+    while (num_packets > 0){
+        num_packets--;
+        uint16_t len;
+        const uint8_t * packet = mock_hci_transport_get_l2cap_packet(num_packets, &len);
+        if (little_endian_read_16(packet, 2) != L2CAP_CID_SIGNALING_LE) continue;
+        if (packet[4] != code) continue;
+        return &packet[4];
+    }
+    return NULL;
+}
+
+static uint16_t num_data_packets_for_cid(uint16_t cid){
+    uint16_t num_data_packets = 0;
+    uint16_t i;
+    for (i = 0; i < mock_hci_transport_num_l2cap_packets(); i++){
+        uint16_t len;
+        const uint8_t * packet = mock_hci_transport_get_l2cap_packet(i, &len);
+        if (little_endian_read_16(packet, 2) == cid){
+            num_data_packets++;
+        }
+    }
+    return num_data_packets;
+}
+
+static void receive_connection_request(uint16_t spsm, const uint16_t * source_cids, uint8_t num_cids, uint16_t initial_credits){
+    uint8_t data[8 + 2 * 6];
+    little_endian_store_16(data, 0, spsm);
+    little_endian_store_16(data, 2, TEST_REMOTE_MTU);
+    little_endian_store_16(data, 4, TEST_REMOTE_MPS);
+    little_endian_store_16(data, 6, initial_credits);
+    uint8_t i;
+    for (i = 0; i < num_cids; i++){
+        little_endian_store_16(data, 8 + 2 * i, source_cids[i]);
+    }
+    receive_signaling(CREDIT_BASED_CONNECTION_REQUEST, data, 8 + 2 * num_cids);
+}
+
+static void accept_channels(uint8_t num_channels, uint16_t initial_credits, uint16_t * out_local_cids){
+    uint8_t * buffers[TEST_MAX_CHANNELS];
+    uint8_t i;
+    for (i = 0; i < TEST_MAX_CHANNELS; i++){
+        buffers[i] = receive_buffers[i];
+    }
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, l2cap_ecbm_accept_channels(incoming_local_cid, num_channels, initial_credits, TEST_LOCAL_MTU, buffers, out_local_cids));
+    mock_hci_transport_process();
+}
+
+// open incoming channels with given remote cids and initial credits from remote
+static void open_incoming_channels(const uint16_t * source_cids, uint8_t num_cids, uint16_t remote_credits, uint16_t * out_local_cids){
+    receive_connection_request(TEST_SPSM, source_cids, num_cids, remote_credits);
+    CHECK_EQUAL(num_cids, incoming_num_channels);
+    accept_channels(num_cids, 10, out_local_cids);
+    CHECK_EQUAL(num_cids, num_opened);
+    mock_hci_transport_clear_l2cap_packets();
+}
+
+static void receive_le_frame(uint16_t cid, const uint8_t * data, uint16_t len){
+    mock_hci_transport_receive_l2cap_packet(con_handle, cid, data, len);
+    mock_hci_transport_process();
+}
+
+TEST_GROUP(L2CAP_ECBM){
+    void setup(void){
+        remote_sig_id = 0;
+        incoming_local_cid = 0;
+        incoming_num_channels = 0;
+        num_opened = 0;
+        num_reconfigured = 0;
+        reconfigured_remote_mtu = 0;
+        num_reconfiguration_complete = 0;
+        reconfiguration_result = 0xffff;
+        num_sdus = 0;
+        last_sdu_cid = 0;
+        last_sdu_len = 0;
+        num_packets_sent = 0;
+        btstack_memory_init();
+        hci_init(mock_hci_transport_instance(), NULL);
+        l2cap_init();
+        l2cap_ecbm_register_service(&l2cap_packet_handler, TEST_SPSM, LEVEL_0);
+        hci_power_control(HCI_POWER_ON);
+        mock_hci_transport_process();
+        CHECK_EQUAL(HCI_STATE_WORKING, hci_get_state());
+        mock_hci_transport_queue_le_connection_complete(con_handle, remote_addr);
+        mock_hci_transport_process();
+        mock_hci_transport_clear_l2cap_packets();
+    }
+    void teardown(void){
+        l2cap_ecbm_unregister_service(TEST_SPSM);
+        hci_close();
+    }
+};
+
+TEST(L2CAP_ECBM, IncomingAcceptAll){
+    const uint16_t source_cids[] = { 0x0041, 0x0042, 0x0043 };
+    receive_connection_request(TEST_SPSM, source_cids, 3, 5);
+    CHECK_EQUAL(3, incoming_num_channels);
+    CHECK_EQUAL(0, num_opened);
+
+    uint16_t local_cids[3];
+    accept_channels(3, 10, local_cids);
+
+    // single response with destination cids in order of source cids
+    const uint8_t * response = find_signaling(CREDIT_BASED_CONNECTION_RESPONSE);
+    CHECK(response != NULL);
+    CHECK_EQUAL(remote_sig_id, response[1]);
+    CHECK_EQUAL(8 + 3 * 2, little_endian_read_16(response, 2));
+    CHECK_EQUAL(TEST_LOCAL_MTU, little_endian_read_16(response, 4));
+    CHECK_EQUAL(10, little_endian_read_16(response, 8));
+    CHECK_EQUAL(0, little_endian_read_16(response, 10));
+    uint8_t i;
+    for (i = 0; i < 3; i++){
+        CHECK_EQUAL(local_cids[i], little_endian_read_16(response, 12 + 2 * i));
+    }
+
+    CHECK_EQUAL(3, num_opened);
+    for (i = 0; i < 3; i++){
+        CHECK_EQUAL(ERROR_CODE_SUCCESS, opened_status[i]);
+        CHECK_EQUAL(local_cids[i], opened_local_cids[i]);
+        CHECK_EQUAL(TEST_REMOTE_MTU, opened_remote_mtus[i]);
+    }
+}
+
+TEST(L2CAP_ECBM, IncomingAcceptSome){
+    const uint16_t source_cids[] = { 0x0041, 0x0042, 0x0043 };
+    receive_connection_request(TEST_SPSM, source_cids, 3, 5);
+
+    uint16_t local_cids[2];
+    accept_channels(2, 10, local_cids);
+
+    // 0x0004 Some connections refused – insufficient resources available, declined channel has cid 0
+    const uint8_t * response = find_signaling(CREDIT_BASED_CONNECTION_RESPONSE);
+    CHECK(response != NULL);
+    CHECK_EQUAL(0x0004, little_endian_read_16(response, 10));
+    CHECK_EQUAL(local_cids[0], little_endian_read_16(response, 12));
+    CHECK_EQUAL(local_cids[1], little_endian_read_16(response, 14));
+    CHECK_EQUAL(0, little_endian_read_16(response, 16));
+    CHECK_EQUAL(2, num_opened);
+}
+
+TEST(L2CAP_ECBM, IncomingDecline){
+    const uint16_t source_cids[] = { 0x0041, 0x0042 };
+    receive_connection_request(TEST_SPSM, source_cids, 2, 5);
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, l2cap_ecbm_decline_channels(incoming_local_cid, 0x0006));
+    mock_hci_transport_process();
+
+    const uint8_t * response = find_signaling(CREDIT_BASED_CONNECTION_RESPONSE);
+    CHECK(response != NULL);
+    CHECK_EQUAL(0x0006, little_endian_read_16(response, 10));
+    CHECK_EQUAL(0, little_endian_read_16(response, 12));
+    CHECK_EQUAL(0, little_endian_read_16(response, 14));
+    CHECK_EQUAL(0, num_opened);
+    // channels are gone
+    CHECK_EQUAL(L2CAP_LOCAL_CID_DOES_NOT_EXIST, l2cap_ecbm_decline_channels(incoming_local_cid, 0));
+}
+
+TEST(L2CAP_ECBM, IncomingUnknownSpsm){
+    const uint16_t source_cids[] = { 0x0041 };
+    receive_connection_request(TEST_UNKNOWN_SPSM, source_cids, 1, 5);
+    CHECK_EQUAL(0, incoming_num_channels);
+    // 0x0002 All connections refused – SPSM not supported
+    const uint8_t * response = find_signaling(CREDIT_BASED_CONNECTION_RESPONSE);
+    CHECK(response != NULL);
+    CHECK_EQUAL(0x0002, little_endian_read_16(response, 10));
+    CHECK_EQUAL(0, little_endian_read_16(response, 12));
+}
+
+TEST(L2CAP_ECBM, IncomingSourceCidAlreadyAllocated){
+    const uint16_t first_cids[] = { 0x0041 };
+    uint16_t local_cids[1];
+    open_incoming_channels(first_cids, 1, 5, local_cids);
+
+    // 0x0041 is in use, 0x0030 is invalid, only 0x0044 can be accepted
+    const uint16_t source_cids[] = { 0x0041, 0x0030, 0x0044 };
+    incoming_num_channels = 0;
+    receive_connection_request(TEST_SPSM, source_cids, 3, 5);
+    CHECK_EQUAL(1, incoming_num_channels);
+    uint16_t new_local_cids[1];
+    accept_channels(1, 10, new_local_cids);
+
+    // first refusal reason is reported: 0x000a Some connections refused – Source CID already allocated
+    const uint8_t * response = find_signaling(CREDIT_BASED_CONNECTION_RESPONSE);
+    CHECK(response != NULL);
+    CHECK_EQUAL(0x000a, little_endian_read_16(response, 10));
+    CHECK_EQUAL(0, little_endian_read_16(response, 12));
+    CHECK_EQUAL(0, little_endian_read_16(response, 14));
+    CHECK_EQUAL(new_local_cids[0], little_endian_read_16(response, 16));
+}
+
+TEST(L2CAP_ECBM, IncomingTooManyCids){
+    const uint16_t source_cids[] = { 0x0041, 0x0042, 0x0043, 0x0044, 0x0045, 0x0046 };
+    receive_connection_request(TEST_SPSM, source_cids, 6, 5);
+    CHECK_EQUAL(0, incoming_num_channels);
+    // 0x000c All connections refused – invalid parameters
+    const uint8_t * response = find_signaling(CREDIT_BASED_CONNECTION_RESPONSE);
+    CHECK(response != NULL);
+    CHECK_EQUAL(0x000c, little_endian_read_16(response, 10));
+}
+
+TEST(L2CAP_ECBM, OutgoingCreateChannels){
+    uint8_t * buffers[2] = { receive_buffers[0], receive_buffers[1] };
+    uint16_t local_cids[2];
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, l2cap_ecbm_create_channels(&l2cap_packet_handler, con_handle, LEVEL_0, TEST_SPSM, 2, 7,
+                                                               TEST_LOCAL_MTU, buffers, local_cids));
+    mock_hci_transport_process();
+
+    // spsm, mtu, mps, initial credits, source cids
+    const uint8_t * request = find_signaling(CREDIT_BASED_CONNECTION_REQUEST);
+    CHECK(request != NULL);
+    CHECK_EQUAL(8 + 2 * 2, little_endian_read_16(request, 2));
+    CHECK_EQUAL(TEST_SPSM, little_endian_read_16(request, 4));
+    CHECK_EQUAL(TEST_LOCAL_MTU, little_endian_read_16(request, 6));
+    CHECK_EQUAL(7, little_endian_read_16(request, 10));
+    CHECK_EQUAL(local_cids[0], little_endian_read_16(request, 12));
+    CHECK_EQUAL(local_cids[1], little_endian_read_16(request, 14));
+
+    // remote accepts first channel only
+    uint8_t data[12];
+    little_endian_store_16(data, 0, TEST_REMOTE_MTU);
+    little_endian_store_16(data, 2, TEST_REMOTE_MPS);
+    little_endian_store_16(data, 4, 3);
+    little_endian_store_16(data, 6, 0x0004);
+    little_endian_store_16(data, 8, 0x0050);
+    little_endian_store_16(data, 10, 0);
+    receive_signaling_with_identifier(CREDIT_BASED_CONNECTION_RESPONSE, request[1], data, sizeof(data));
+
+    CHECK_EQUAL(2, num_opened);
+    CHECK_EQUAL(local_cids[0], opened_local_cids[0]);
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, opened_status[0]);
+    CHECK_EQUAL(TEST_REMOTE_MTU, opened_remote_mtus[0]);
+    CHECK_EQUAL(local_cids[1], opened_local_cids[1]);
+    CHECK_EQUAL(0x0004, opened_status[1]);
+
+    // open channel uses remote cid from response
+    uint8_t sdu[10];
+    memset(sdu, 0x11, sizeof(sdu));
+    mock_hci_transport_clear_l2cap_packets();
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, l2cap_le_send_data(local_cids[0], sdu, sizeof(sdu)));
+    mock_hci_transport_process();
+    CHECK_EQUAL(1, num_data_packets_for_cid(0x0050));
+    CHECK_EQUAL(L2CAP_LOCAL_CID_DOES_NOT_EXIST, l2cap_le_send_data(local_cids[1], sdu, sizeof(sdu)));
+}
+
+TEST(L2CAP_ECBM, OutgoingInvalidParameters){
+    uint8_t * buffers[TEST_MAX_CHANNELS + 1];
+    uint16_t local_cids[TEST_MAX_CHANNELS + 1];
+    uint8_t i;
+    for (i = 0; i <= TEST_MAX_CHANNELS; i++){
+        buffers[i] = receive_buffers[0];
+    }
+    CHECK_EQUAL(ERROR_CODE_INVALID_HCI_COMMAND_PARAMETERS, l2cap_ecbm_create_channels(&l2cap_packet_handler, con_handle, LEVEL_0,
+        TEST_SPSM, TEST_MAX_CHANNELS + 1, 7, TEST_LOCAL_MTU, buffers, local_cids));
+    CHECK_EQUAL(ERROR_CODE_INVALID_HCI_COMMAND_PARAMETERS, l2cap_ecbm_create_channels(&l2cap_packet_handler, con_handle, LEVEL_0,
+        TEST_SPSM, 1, 7, L2CAP_ECBM_MIN_MTU - 1, buffers, local_cids));
+    CHECK_EQUAL(ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER, l2cap_ecbm_create_channels(&l2cap_packet_handler, con_handle + 1, LEVEL_0,
+        TEST_SPSM, 1, 7, TEST_LOCAL_MTU, buffers, local_cids));
+}
+
+TEST(L2CAP_ECBM, LocalReconfigure){
+    const uint16_t source_cids[] = { 0x0041, 0x0042 };
+    uint16_t local_cids[2];
+    open_incoming_channels(source_cids, 2, 5, local_cids);
+
+    uint8_t * buffers[2] = { receive_buffers[2], receive_buffers[3] };
+    // MTU must not be reduced
+    CHECK_EQUAL(ERROR_CODE_INVALID_HCI_COMMAND_PARAMETERS, l2cap_ecbm_reconfigure_channels(2, local_cids, TEST_LOCAL_MTU - 1, buffers));
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, l2cap_ecbm_reconfigure_channels(2, local_cids, 400, buffers));
+    mock_hci_transport_process();
+    // only one reconfiguration at a time
+    CHECK_EQUAL(ERROR_CODE_COMMAND_DISALLOWED, l2cap_ecbm_reconfigure_channels(2, local_cids, 500, buffers));
+
+    // mtu, mps, destination cids = remote cids
+    const uint8_t * request = find_signaling(CREDIT_BASED_RECONFIGURE_REQUEST);
+    CHECK(request != NULL);
+    CHECK_EQUAL(4 + 2 * 2, little_endian_read_16(request, 2));
+    CHECK_EQUAL(400, little_endian_read_16(request, 4));
+    CHECK_EQUAL(0x0041, little_endian_read_16(request, 8));
+    CHECK_EQUAL(0x0042, little_endian_read_16(request, 10));
+
+    uint8_t data[2];
+    little_endian_store_16(data, 0, 0);
+    receive_signaling_with_identifier(CREDIT_BASED_RECONFIGURE_RESPONSE, request[1], data, sizeof(data));
+    CHECK_EQUAL(2, num_reconfiguration_complete);
+    CHECK_EQUAL(0, reconfiguration_result);
+
+    // next reconfiguration allowed
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, l2cap_ecbm_reconfigure_channels(2, local_cids, 500, buffers));
+}
+
+TEST(L2CAP_ECBM, RemoteReconfigure){
+    const uint16_t source_cids[] = { 0x0041, 0x0042 };
+    uint16_t local_cids[2];
+    open_incoming_channels(source_cids, 2, 5, local_cids);
+
+    // larger MTU for both channels
+    uint8_t data[8];
+    little_endian_store_16(data, 0, 400);
+    little_endian_store_16(data, 2, TEST_REMOTE_MPS);
+    little_endian_store_16(data, 4, local_cids[0]);
+    little_endian_store_16(data, 6, local_cids[1]);
+    receive_signaling(CREDIT_BASED_RECONFIGURE_REQUEST, data, sizeof(data));
+    CHECK_EQUAL(2, num_reconfigured);
+    CHECK_EQUAL(400, reconfigured_remote_mtu);
+    const uint8_t * response = find_signaling(CREDIT_BASED_RECONFIGURE_RESPONSE);
+    CHECK(response != NULL);
+    CHECK_EQUAL(remote_sig_id, response[1]);
+    CHECK_EQUAL(0, little_endian_read_16(response, 4));
+
+    // 0x0001 Reconfiguration failed - reduction in size of MTU not allowed
+    mock_hci_transport_clear_l2cap_packets();
+    little_endian_store_16(data, 0, 200);
+    receive_signaling(CREDIT_BASED_RECONFIGURE_REQUEST, data, sizeof(data));
+    CHECK_EQUAL(2, num_reconfigured);
+    response = find_signaling(CREDIT_BASED_RECONFIGURE_RESPONSE);
+    CHECK(response != NULL);
+    CHECK_EQUAL(0x0001, little_endian_read_16(response, 4));
+
+    // 0x0002 Reconfiguration failed - reduction in size of MPS not allowed for more than one channel at a time
+    mock_hci_transport_clear_l2cap_packets();
+    little_endian_store_16(data, 0, 400);
+    little_endian_store_16(data, 2, TEST_REMOTE_MPS - 10);
+    receive_signaling(CREDIT_BASED_RECONFIGURE_REQUEST, data, sizeof(data));
+    response = find_signaling(CREDIT_BASED_RECONFIGURE_RESPONSE);
+    CHECK(response != NULL);
+    CHECK_EQUAL(0x0002, little_endian_read_16(response, 4));
+
+    // 0x0003 Reconfiguration failed - one or more Destination CIDs invalid
+    mock_hci_transport_clear_l2cap_packets();
+    little_endian_store_16(data, 2, TEST_REMOTE_MPS);
+    little_endian_store_16(data, 6, 0x0077);
+    receive_signaling(CREDIT_BASED_RECONFIGURE_REQUEST, data, sizeof(data));
+    response = find_signaling(CREDIT_BASED_RECONFIGURE_RESPONSE);
+    CHECK(response != NULL);
+    CHECK_EQUAL(0x0003, little_endian_read_16(response, 4));
+    CHECK_EQUAL(2, num_reconfigured);
+}
+
+TEST(L2CAP_ECBM, OutgoingCredits){
+    const uint16_t source_cids[] = { 0x0041 };
+    uint16_t local_cids[1];
+    // remote provides 2 credits
+    open_incoming_channels(source_cids, 1, 2, local_cids);
+
+    // SDU of 250 bytes + 2 bytes SDU length needs 3 PDUs with remote MPS 100
+    uint8_t sdu[250];
+    memset(sdu, 0x22, sizeof(sdu));
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, l2cap_le_send_data(local_cids[0], sdu, sizeof(sdu)));
+    mock_hci_transport_process();
+    CHECK_EQUAL(2, num_data_packets_for_cid(0x0041));
+    CHECK_EQUAL(0, num_packets_sent);
+
+    // more credits from remote, CID is the Source CID of the remote
+    uint8_t data[4];
+    little_endian_store_16(data, 0, 0x0041);
+    little_endian_store_16(data, 2, 5);
+    receive_signaling(LE_FLOW_CONTROL_CREDIT, data, sizeof(data));
+    CHECK_EQUAL(3, num_data_packets_for_cid(0x0041));
+    CHECK_EQUAL(1, num_packets_sent);
+
+    l2cap_le_channel_statistics_t statistics;
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, l2cap_le_get_channel_statistics(local_cids[0], &statistics));
+    CHECK_EQUAL(3, statistics.tx_pdus);
+    CHECK_EQUAL(1, statistics.tx_credit_stalls);
+}
+
+TEST(L2CAP_ECBM, IncomingCredits){
+    const uint16_t source_cids[] = { 0x0041, 0x0042 };
+    uint16_t local_cids[2];
+    // 10 initial credits per channel
+    open_incoming_channels(source_cids, 2, 5, local_cids);
+
+    // complete SDUs on second channel
+    uint8_t pdu[12];
+    little_endian_store_16(pdu, 0, 10);
+    memset(&pdu[2], 0x33, 10);
+    receive_le_frame(local_cids[1], pdu, sizeof(pdu));
+    receive_le_frame(local_cids[1], pdu, sizeof(pdu));
+    CHECK_EQUAL(2, num_sdus);
+    CHECK_EQUAL(local_cids[1], last_sdu_cid);
+    CHECK_EQUAL(10, last_sdu_len);
+
+    // credits are returned for the channel only
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, l2cap_le_provide_credits(local_cids[1], 2));
+    mock_hci_transport_process();
+    const uint8_t * credit = find_signaling(LE_FLOW_CONTROL_CREDIT);
+    CHECK(credit != NULL);
+    CHECK_EQUAL(local_cids[1], little_endian_read_16(credit, 4));
+    CHECK_EQUAL(2, little_endian_read_16(credit, 6));
+}
+
+int main (int argc, const char * argv[]){
+    btstack_run_loop_init(btstack_run_loop_posix_get_instance());
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
@@ -0,0 +1,520 @@
+// L2CAP Enhanced Retransmission Mode: Extended Control Field, SREJ list and Streaming Mode
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/CommandLineTestRunner.h"
+
+#include "btstack_debug.h"
+#include "btstack_event.h"
+#include "btstack_memory.h"
+#include "btstack_run_loop.h"
+#include "btstack_run_loop_posix.h"
+#include "btstack_util.h"
+#include "hci.h"
+#include "l2cap.h"
+#include "l2cap_signaling.h"
+#include "mock_hci_transport.h"
+
+#define TEST_PSM          0x1001
+#define TEST_REMOTE_CID   0x0041
+#define TEST_REMOTE_MPS   200
+#define TEST_MAX_SDUS     16
+
+// extended features
+#define FEATURE_ERTM            0x0008
+#define FEATURE_STREAMING       0x0010
+#define FEATURE_FCS             0x0020
+#define FEATURE_FIXED_CHANNELS  0x0080
+#define FEATURE_EXTENDED_WINDOW 0x0100
+
+// signaling constants, private in l2cap.c
+#define INFO_TYPE_EXTENDED_FEATURES_SUPPORTED         0x0002
+#define CONFIG_OPTION_RETRANSMISSION_AND_FLOW_CONTROL 0x04
+#define CONFIG_OPTION_FRAME_CHECK_SEQUENCE            0x05
+#define CONFIG_OPTION_EXTENDED_WINDOW_SIZE            0x07
+#define CONFIG_RESULT_SUCCESS                         0x0000
+
+// supervisory functions
+#define S_RR   0
+#define S_REJ  1
+#define S_SREJ 3
+
+static const hci_con_handle_t con_handle = 0x0001;
+static bd_addr_t remote_addr = { 0x11, 0x22, 0x33, 0x44, 0x55, 0x66 };
+
+static uint8_t  ertm_buffer[20000];
+static uint16_t local_cid;
+static uint8_t  channel_opened_status;
+static bool     channel_opened;
+static bool     ertm_buffer_released;
+static uint8_t  remote_sig_id;
+
+static uint8_t  sdus[TEST_MAX_SDUS][1000];
+static uint16_t sdu_lens[TEST_MAX_SDUS];
+static uint16_t num_sdus;
+
+static void l2cap_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
+    switch (packet_type){
+        case L2CAP_DATA_PACKET:
+            CHECK_EQUAL(local_cid, channel);
+            if (num_sdus < TEST_MAX_SDUS){
+                (void)memcpy(sdus[num_sdus], packet, size);
+                sdu_lens[num_sdus] = size;
+            }
+            num_sdus++;
+            break;
+        case HCI_EVENT_PACKET:
+            switch (hci_event_packet_get_type(packet)){
+                case L2CAP_EVENT_INCOMING_CONNECTION:
+                    local_cid = l2cap_event_incoming_connection_get_local_cid(packet);
+                    break;
+                case L2CAP_EVENT_CHANNEL_OPENED:
+                    channel_opened = true;
+                    channel_opened_status = l2cap_event_channel_opened_get_status(packet);
+                    break;
+                case L2CAP_EVENT_ERTM_BUFFER_RELEASED:
+                    ertm_buffer_released = true;
+                    break;
+                default:
+                    break;
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+static void receive_signaling_with_identifier(uint8_t code, uint8_t identifier, const uint8_t * data, uint16_t len){
+    uint8_t packet[100];
+    packet[0] = code;
+    packet[1] = identifier;
+    little_endian_store_16(packet, 2, len);
+    (void)memcpy(&packet[4], data, len);
+    mock_hci_transport_receive_l2cap_packet(con_handle, L2CAP_CID_SIGNALING, packet, 4 + len);
+    mock_hci_transport_process();
+}
+
+static void receive_signaling(uint8_t code, const uint8_t * data, uint16_t len){
+    receive_signaling_with_identifier(code, ++remote_sig_id, data, len);
+}
+
+// @return last signaling command with code sent by BTstack or NULL
+static const uint8_t * find_signaling(uint8_t code){
+    uint16_t num_packets = mock_hci_transport_num_l2cap_packets();
+    while (num_packets > 0){
+        num_packets--;
+        uint16_t len;
+        const uint8_t * packet = mock_hci_transport_get_l2cap_packet(num_packets, &len);
+        if (little_endian_read_16(packet, 2) != L2CAP_CID_SIGNALING) continue;
+        if (packet[4] != code) continue;
+        return &packet[4];
+    }
+    return NULL;
+}
+
+// @return pointer to option in Configuration Request sent by BTstack or NULL
+static const uint8_t * find_config_option(uint8_t type){
+    const uint8_t * command = find_signaling(CONFIGURE_REQUEST);
+    if (command == NULL) return NULL;
+    uint16_t end_pos = 4 + little_endian_read_16(command, 2);
+    uint16_t pos = 8;
+    while (pos < end_pos){
+        if ((command[pos] & 0x7f) == type) return &command[pos + 2];
+        pos += 2 + command[pos + 1];
+    }
+    return NULL;
+}
+
+static void receive_information_response(uint16_t extended_features){
+    uint8_t data[8];
+    little_endian_store_16(data, 0, INFO_TYPE_EXTENDED_FEATURES_SUPPORTED);
+    little_endian_store_16(data, 2, 0);
+    little_endian_store_32(data, 4, extended_features);
+    receive_signaling(INFORMATION_RESPONSE, data, sizeof(data));
+}
+
+static void receive_connection_request(void){
+    uint8_t data[4];
+    little_endian_store_16(data, 0, TEST_PSM);
+    little_endian_store_16(data, 2, TEST_REMOTE_CID);
+    receive_signaling(CONNECTION_REQUEST, data, sizeof(data));
+}
+
+static void receive_configure_request(l2cap_channel_mode_t mode, uint16_t extended_window_size){
+    uint8_t data[40];
+    uint16_t pos = 0;
+    little_endian_store_16(data, pos, local_cid);
+    pos += 2;
+    little_endian_store_16(data, pos, 0);
+    pos += 2;
+    data[pos++] = CONFIG_OPTION_RETRANSMISSION_AND_FLOW_CONTROL;
+    data[pos++] = 9;
+    data[pos++] = (uint8_t) mode;
+    if (mode == L2CAP_CHANNEL_MODE_STREAMING_MODE){
+        memset(&data[pos], 0, 6);
+    } else {
+        data[pos]     = 63;     // tx window
+        data[pos + 1] = 3;      // max transmit
+        little_endian_store_16(data, pos + 2, 2000);
+        little_endian_store_16(data, pos + 4, 12000);
+    }
+    pos += 6;
+    little_endian_store_16(data, pos, TEST_REMOTE_MPS);
+    pos += 2;
+    if (extended_window_size){
+        data[pos++] = CONFIG_OPTION_EXTENDED_WINDOW_SIZE;
+        data[pos++] = 2;
+        little_endian_store_16(data, pos, extended_window_size);
+        pos += 2;
+    }
+    // no FCS
+    data[pos++] = CONFIG_OPTION_FRAME_CHECK_SEQUENCE;
+    data[pos++] = 1;
+    data[pos++] = 0;
+    receive_signaling(CONFIGURE_REQUEST, data, pos);
+}
+
+static void receive_configure_response(void){
+    // responses are matched by identifier of request
+    const uint8_t * request = find_signaling(CONFIGURE_REQUEST);
+    CHECK(request != NULL);
+    uint8_t data[6];
+    little_endian_store_16(data, 0, local_cid);
+    little_endian_store_16(data, 2, 0);
+    little_endian_store_16(data, 4, CONFIG_RESULT_SUCCESS);
+    receive_signaling_with_identifier(CONFIGURE_RESPONSE, request[1], data, sizeof(data));
+}
+
+// incoming connection until client accepts
+static void setup_incoming_connection(uint16_t extended_features){
+    receive_connection_request();
+    // BTstack needs remote extended features before it asks the client
+    CHECK(find_signaling(INFORMATION_REQUEST) != NULL);
+    CHECK_EQUAL(0, local_cid);
+    receive_information_response(extended_features);
+    CHECK(local_cid != 0);
+}
+
+static void accept_ertm(uint16_t num_rx_buffers, uint8_t streaming_mode){
+    l2cap_ertm_config_t ertm_config;
+    memset(&ertm_config, 0, sizeof(ertm_config));
+    ertm_config.max_transmit = 3;
+    ertm_config.retransmission_timeout_ms = 2000;
+    ertm_config.monitor_timeout_ms = 12000;
+    ertm_config.local_mtu = 1000;
+    ertm_config.num_tx_buffers = 4;
+    ertm_config.num_rx_buffers = num_rx_buffers;
+    ertm_config.fcs_option = 0;
+    ertm_config.streaming_mode = streaming_mode;
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, l2cap_accept_ertm_connection(local_cid, &ertm_config, ertm_buffer, sizeof(ertm_buffer)));
+    mock_hci_transport_process();
+}
+
+static void open_channel(uint16_t extended_features, uint16_t num_rx_buffers, uint8_t streaming_mode, uint16_t remote_extended_window_size){
+    setup_incoming_connection(extended_features);
+    accept_ertm(num_rx_buffers, streaming_mode);
+    CHECK(find_signaling(CONFIGURE_REQUEST) != NULL);
+    receive_configure_request(streaming_mode ? L2CAP_CHANNEL_MODE_STREAMING_MODE : L2CAP_CHANNEL_MODE_ENHANCED_RETRANSMISSION, remote_extended_window_size);
+    receive_configure_response();
+    CHECK_TRUE(channel_opened);
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, channel_opened_status);
+    mock_hci_transport_clear_l2cap_packets();
+}
+
+static void receive_i_frame_standard(uint8_t tx_seq, l2cap_segmentation_and_reassembly_t sar, const uint8_t * data, uint16_t len){
+    uint8_t packet[300];
+    little_endian_store_16(packet, 0, (uint16_t) ((sar << 14) | (tx_seq << 1)));
+    (void)memcpy(&packet[2], data, len);
+    mock_hci_transport_receive_l2cap_packet(con_handle, local_cid, packet, 2 + len);
+    mock_hci_transport_process();
+}
+
+static void receive_i_frame_extended(uint16_t tx_seq, const uint8_t * data, uint16_t len){
+    uint8_t packet[300];
+    little_endian_store_32(packet, 0, ((uint32_t) tx_seq) << 18);
+    (void)memcpy(&packet[4], data, len);
+    mock_hci_transport_receive_l2cap_packet(con_handle, local_cid, packet, 4 + len);
+    mock_hci_transport_process();
+}
+
+// @return number of outgoing S-Frames with standard control field and given supervisory function, stores req_seq of each
+static uint16_t get_s_frames_standard(uint8_t supervisory_function, uint8_t * req_seqs, uint16_t max_frames){
+    uint16_t num_frames = 0;
+    uint16_t i;
+    for (i = 0; i < mock_hci_transport_num_l2cap_packets(); i++){
+        uint16_t len;
+        const uint8_t * packet = mock_hci_transport_get_l2cap_packet(i, &len);
+        if (little_endian_read_16(packet, 2) != TEST_REMOTE_CID) continue;
+        uint16_t control = little_endian_read_16(packet, 4);
+        if ((control & 1) == 0) continue;
+        if (((control >> 2) & 0x03) != supervisory_function) continue;
+        if (num_frames < max_frames){
+            req_seqs[num_frames] = (control >> 8) & 0x3f;
+        }
+        num_frames++;
+    }
+    return num_frames;
+}
+
+static void check_sdu(uint16_t index, uint8_t value, uint16_t len){
+    CHECK(index < num_sdus);
+    CHECK(index < TEST_MAX_SDUS);
+    CHECK_EQUAL(len, sdu_lens[index]);
+    uint16_t i;
+    for (i = 0; i < len; i++){
+        CHECK_EQUAL(value, sdus[index][i]);
+    }
+}
+
+TEST_GROUP(L2CAP_ERTM){
+    void setup(void){
+        local_cid = 0;
+        channel_opened = false;
+        channel_opened_status = 0xff;
+        ertm_buffer_released = false;
+        remote_sig_id = 0;
+        num_sdus = 0;
+        btstack_memory_init();
+        hci_init(mock_hci_transport_instance(), NULL);
+        l2cap_init();
+        l2cap_register_service(&l2cap_packet_handler, TEST_PSM, 1000, LEVEL_0);
+        hci_power_control(HCI_POWER_ON);
+        mock_hci_transport_process();
+        CHECK_EQUAL(HCI_STATE_WORKING, hci_get_state());
+        mock_hci_transport_queue_connection_complete(con_handle, remote_addr);
+        mock_hci_transport_process();
+        mock_hci_transport_clear_l2cap_packets();
+    }
+    void teardown(void){
+        l2cap_unregister_service(TEST_PSM);
+        hci_close();
+    }
+};
+
+TEST(L2CAP_ERTM, ExtendedFeaturesMask){
+    uint8_t data[2];
+    little_endian_store_16(data, 0, INFO_TYPE_EXTENDED_FEATURES_SUPPORTED);
+    receive_signaling(INFORMATION_REQUEST, data, sizeof(data));
+    const uint8_t * response = find_signaling(INFORMATION_RESPONSE);
+    CHECK(response != NULL);
+    uint32_t features = little_endian_read_32(response, 8);
+    CHECK_EQUAL(FEATURE_ERTM, features & FEATURE_ERTM);
+    CHECK_EQUAL(FEATURE_STREAMING, features & FEATURE_STREAMING);
+    CHECK_EQUAL(FEATURE_FCS, features & FEATURE_FCS);
+    CHECK_EQUAL(FEATURE_FIXED_CHANNELS, features & FEATURE_FIXED_CHANNELS);
+    CHECK_EQUAL(FEATURE_EXTENDED_WINDOW, features & FEATURE_EXTENDED_WINDOW);
+}
+
+TEST(L2CAP_ERTM, StreamingModeNotSupportedByRemote){
+    // Fixed Channels bit doesn't indicate Streaming Mode
+    setup_incoming_connection(FEATURE_ERTM | FEATURE_FCS | FEATURE_FIXED_CHANNELS);
+    accept_ertm(4, 1);
+    CHECK_TRUE(ertm_buffer_released);
+    CHECK(find_config_option(CONFIG_OPTION_RETRANSMISSION_AND_FLOW_CONTROL) == NULL);
+}
+
+TEST(L2CAP_ERTM, StreamingModeConfig){
+    setup_incoming_connection(FEATURE_STREAMING | FEATURE_FCS);
+    accept_ertm(4, 1);
+    CHECK_FALSE(ertm_buffer_released);
+    const uint8_t * option = find_config_option(CONFIG_OPTION_RETRANSMISSION_AND_FLOW_CONTROL);
+    CHECK(option != NULL);
+    CHECK_EQUAL(L2CAP_CHANNEL_MODE_STREAMING_MODE, option[0]);
+    // TxWindow, MaxTransmit, timeouts are not used
+    uint8_t zeros[6] = { 0 };
+    MEMCMP_EQUAL(zeros, &option[1], 6);
+}
+
+TEST(L2CAP_ERTM, StreamingModeReceive){
+    open_channel(FEATURE_STREAMING | FEATURE_FCS, 4, 1, 0);
+
+    uint8_t data[50];
+    memset(data, 1, sizeof(data));
+    receive_i_frame_standard(0, L2CAP_SEGMENTATION_AND_REASSEMBLY_UNSEGMENTED_L2CAP_SDU, data, 10);
+    CHECK_EQUAL(1, num_sdus);
+    check_sdu(0, 1, 10);
+
+    // segmented SDU with missing continuation is dropped
+    memset(data, 2, sizeof(data));
+    little_endian_store_16(data, 0, 30);
+    receive_i_frame_standard(1, L2CAP_SEGMENTATION_AND_REASSEMBLY_START_OF_L2CAP_SDU, data, 12);
+    receive_i_frame_standard(3, L2CAP_SEGMENTATION_AND_REASSEMBLY_END_OF_L2CAP_SDU, data, 10);
+    CHECK_EQUAL(1, num_sdus);
+
+    // next SDU is delivered
+    memset(data, 3, sizeof(data));
+    receive_i_frame_standard(4, L2CAP_SEGMENTATION_AND_REASSEMBLY_UNSEGMENTED_L2CAP_SDU, data, 20);
+    CHECK_EQUAL(2, num_sdus);
+    check_sdu(1, 3, 20);
+
+    // no acknowledgements
+    uint8_t req_seqs[4];
+    CHECK_EQUAL(0, get_s_frames_standard(S_RR, req_seqs, 4));
+    CHECK_EQUAL(0, get_s_frames_standard(S_SREJ, req_seqs, 4));
+    CHECK_EQUAL(0, get_s_frames_standard(S_REJ, req_seqs, 4));
+}
+
+TEST(L2CAP_ERTM, StreamingModeSendReleasesBuffers){
+    open_channel(FEATURE_STREAMING | FEATURE_FCS, 4, 1, 0);
+    uint8_t data[20];
+    memset(data, 0x55, sizeof(data));
+    // more SDUs than tx buffers can be sent as frames are not acknowledged
+    uint16_t i;
+    for (i = 0; i < 8; i++){
+        CHECK_EQUAL(ERROR_CODE_SUCCESS, l2cap_send(local_cid, data, sizeof(data)));
+        mock_hci_transport_process();
+    }
+    CHECK_EQUAL(8, mock_hci_transport_num_l2cap_packets());
+    for (i = 0; i < 8; i++){
+        uint16_t len;
+        const uint8_t * packet = mock_hci_transport_get_l2cap_packet(i, &len);
+        CHECK_EQUAL(4 + 2 + sizeof(data), len);
+        uint16_t control = little_endian_read_16(packet, 4);
+        // I-Frame with tx_seq i
+        CHECK_EQUAL(0, control & 1);
+        CHECK_EQUAL(i, (control >> 1) & 0x3f);
+    }
+}
+
+TEST(L2CAP_ERTM, SrejList){
+    open_channel(FEATURE_ERTM | FEATURE_FCS, 8, 0, 0);
+
+    uint8_t data[10];
+    memset(data, 0, sizeof(data));
+    receive_i_frame_standard(0, L2CAP_SEGMENTATION_AND_REASSEMBLY_UNSEGMENTED_L2CAP_SDU, data, sizeof(data));
+    CHECK_EQUAL(1, num_sdus);
+
+    // frames 1 and 2 are missing
+    memset(data, 3, sizeof(data));
+    receive_i_frame_standard(3, L2CAP_SEGMENTATION_AND_REASSEMBLY_UNSEGMENTED_L2CAP_SDU, data, sizeof(data));
+    CHECK_EQUAL(1, num_sdus);
+
+    // both missing frames are requested with SREJ
+    uint8_t req_seqs[4];
+    CHECK_EQUAL(2, get_s_frames_standard(S_SREJ, req_seqs, 4));
+    CHECK_EQUAL(1, req_seqs[0]);
+    CHECK_EQUAL(2, req_seqs[1]);
+    CHECK_EQUAL(0, get_s_frames_standard(S_REJ, req_seqs, 4));
+
+    // missing frames complete the sequence
+    memset(data, 1, sizeof(data));
+    receive_i_frame_standard(1, L2CAP_SEGMENTATION_AND_REASSEMBLY_UNSEGMENTED_L2CAP_SDU, data, sizeof(data));
+    CHECK_EQUAL(2, num_sdus);
+    memset(data, 2, sizeof(data));
+    receive_i_frame_standard(2, L2CAP_SEGMENTATION_AND_REASSEMBLY_UNSEGMENTED_L2CAP_SDU, data, sizeof(data));
+    CHECK_EQUAL(4, num_sdus);
+    check_sdu(1, 1, sizeof(data));
+    check_sdu(2, 2, sizeof(data));
+    check_sdu(3, 3, sizeof(data));
+
+    // duplicate is dropped
+    receive_i_frame_standard(2, L2CAP_SEGMENTATION_AND_REASSEMBLY_UNSEGMENTED_L2CAP_SDU, data, sizeof(data));
+    CHECK_EQUAL(4, num_sdus);
+
+    // all frames acknowledged
+    uint16_t num_rr = get_s_frames_standard(S_RR, req_seqs, 4);
+    CHECK(num_rr > 0);
+    CHECK_EQUAL(4, req_seqs[btstack_min(num_rr, 4) - 1]);
+}
+
+TEST(L2CAP_ERTM, SrejListOnlyRequestsMissingFrames){
+    open_channel(FEATURE_ERTM | FEATURE_FCS, 8, 0, 0);
+
+    uint8_t data[10];
+    memset(data, 0, sizeof(data));
+    // frame 0 and 2 are missing, 1 and 3 received
+    receive_i_frame_standard(1, L2CAP_SEGMENTATION_AND_REASSEMBLY_UNSEGMENTED_L2CAP_SDU, data, sizeof(data));
+    receive_i_frame_standard(3, L2CAP_SEGMENTATION_AND_REASSEMBLY_UNSEGMENTED_L2CAP_SDU, data, sizeof(data));
+    CHECK_EQUAL(0, num_sdus);
+
+    uint8_t req_seqs[4];
+    CHECK_EQUAL(2, get_s_frames_standard(S_SREJ, req_seqs, 4));
+    CHECK_EQUAL(0, req_seqs[0]);
+    CHECK_EQUAL(2, req_seqs[1]);
+}
+
+TEST(L2CAP_ERTM, ExtendedControlFieldConfig){
+    setup_incoming_connection(FEATURE_ERTM | FEATURE_FCS | FEATURE_EXTENDED_WINDOW);
+    accept_ertm(100, 0);
+    const uint8_t * option = find_config_option(CONFIG_OPTION_RETRANSMISSION_AND_FLOW_CONTROL);
+    CHECK(option != NULL);
+    CHECK_EQUAL(L2CAP_CHANNEL_MODE_ENHANCED_RETRANSMISSION, option[0]);
+    // TxWindow limited to 63, actual window in Extended Window Size option
+    CHECK_EQUAL(63, option[1]);
+    option = find_config_option(CONFIG_OPTION_EXTENDED_WINDOW_SIZE);
+    CHECK(option != NULL);
+    CHECK_EQUAL(100, little_endian_read_16(option, 0));
+}
+
+TEST(L2CAP_ERTM, ExtendedWindowSizeNotSupportedByRemote){
+    setup_incoming_connection(FEATURE_ERTM | FEATURE_FCS);
+    accept_ertm(100, 0);
+    CHECK(find_config_option(CONFIG_OPTION_RETRANSMISSION_AND_FLOW_CONTROL) != NULL);
+    CHECK(find_config_option(CONFIG_OPTION_EXTENDED_WINDOW_SIZE) == NULL);
+}
+
+TEST(L2CAP_ERTM, ExtendedControlField){
+    open_channel(FEATURE_ERTM | FEATURE_FCS | FEATURE_EXTENDED_WINDOW, 100, 0, 200);
+
+    // receive I-Frame with 32-bit control field
+    uint8_t data[10];
+    memset(data, 7, sizeof(data));
+    receive_i_frame_extended(0, data, sizeof(data));
+    CHECK_EQUAL(1, num_sdus);
+    check_sdu(0, 7, sizeof(data));
+
+    // acknowledged with RR in 32-bit control field
+    uint16_t len;
+    const uint8_t * packet = mock_hci_transport_get_last_l2cap_packet_for_cid(TEST_REMOTE_CID, &len);
+    CHECK(packet != NULL);
+    CHECK_EQUAL(4 + 4, len);
+    uint32_t control = little_endian_read_32(packet, 4);
+    CHECK_EQUAL(1, control & 1);
+    CHECK_EQUAL(S_RR, (control >> 16) & 0x03);
+    CHECK_EQUAL(1, (control >> 2) & 0x3fff);
+
+    // send I-Frame with 32-bit control field
+    mock_hci_transport_clear_l2cap_packets();
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, l2cap_send(local_cid, data, sizeof(data)));
+    mock_hci_transport_process();
+    packet = mock_hci_transport_get_last_l2cap_packet_for_cid(TEST_REMOTE_CID, &len);
+    CHECK(packet != NULL);
+    CHECK_EQUAL(4 + 4 + sizeof(data), len);
+    control = little_endian_read_32(packet, 4);
+    CHECK_EQUAL(0, control & 1);
+    // tx_seq 0, req_seq 1, unsegmented
+    CHECK_EQUAL(0, control >> 18);
+    CHECK_EQUAL(1, (control >> 2) & 0x3fff);
+    CHECK_EQUAL(L2CAP_SEGMENTATION_AND_REASSEMBLY_UNSEGMENTED_L2CAP_SDU, (control >> 16) & 0x03);
+    MEMCMP_EQUAL(data, &packet[8], sizeof(data));
+}
+
+TEST(L2CAP_ERTM, ExtendedControlFieldSequenceNumbersAbove63){
+    open_channel(FEATURE_ERTM | FEATURE_FCS | FEATURE_EXTENDED_WINDOW, 100, 0, 200);
+
+    uint8_t data[4];
+    uint16_t tx_seq;
+    for (tx_seq = 0; tx_seq < 70; tx_seq++){
+        // only last acknowledgement is of interest
+        mock_hci_transport_clear_l2cap_packets();
+        little_endian_store_16(data, 0, tx_seq);
+        receive_i_frame_extended(tx_seq, data, sizeof(data));
+    }
+    CHECK_EQUAL(70, num_sdus);
+
+    // 14-bit sequence numbers: req_seq 70 doesn't wrap at 64
+    uint16_t len;
+    const uint8_t * packet = mock_hci_transport_get_last_l2cap_packet_for_cid(TEST_REMOTE_CID, &len);
+    CHECK(packet != NULL);
+    uint32_t control = little_endian_read_32(packet, 4);
+    CHECK_EQUAL(70, (control >> 2) & 0x3fff);
+}
+
+int main (int argc, const char * argv[]){
+    btstack_run_loop_init(btstack_run_loop_posix_get_instance());
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
@@ -0,0 +1,422 @@
+// L2CAP LE Data Channels: queued caller-owned SDUs, release callbacks and channel statistics
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/CommandLineTestRunner.h"
+
+#include "btstack_debug.h"
+#include "btstack_event.h"
+#include "btstack_memory.h"
+#include "btstack_run_loop.h"
+#include "btstack_run_loop_posix.h"
+#include "btstack_stats.h"
+#include "btstack_util.h"
+#include "hci.h"
+#include "l2cap.h"
+#include "l2cap_signaling.h"
+#include "mock_hci_transport.h"
+
+#define TEST_PSM          0x0080
+#define TEST_REMOTE_CID   0x0041
+#define TEST_REMOTE_MTU   200
+#define TEST_REMOTE_MPS   50
+#define TEST_LOCAL_MTU    200
+#define TEST_MAX_SDUS     8
+
+static const hci_con_handle_t con_handle = 0x0040;
+static bd_addr_t remote_addr = { 0x11, 0x22, 0x33, 0x44, 0x55, 0x66 };
+
+static uint8_t  receive_buffer[TEST_LOCAL_MTU];
+static uint8_t  remote_sig_id;
+static uint16_t local_cid;
+static bool     channel_opened;
+static bool     channel_closed;
+static uint8_t  num_packets_sent;
+static uint8_t  num_sdus_received;
+
+// caller-owned SDUs and release order
+static l2cap_le_sdu_t sdus[TEST_MAX_SDUS];
+static uint8_t  sdu_data[TEST_MAX_SDUS][TEST_REMOTE_MTU];
+static uint8_t  released_indices[TEST_MAX_SDUS];
+static uint8_t  released_status[TEST_MAX_SDUS];
+static uint8_t  num_released;
+static bool     closed_before_release;
+
+static void l2cap_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
+    UNUSED(channel);
+    UNUSED(size);
+    switch (packet_type){
+        case L2CAP_DATA_PACKET:
+            num_sdus_received++;
+            break;
+        case HCI_EVENT_PACKET:
+            switch (hci_event_packet_get_type(packet)){
+                case L2CAP_EVENT_LE_INCOMING_CONNECTION:
+                    local_cid = l2cap_event_le_incoming_connection_get_local_cid(packet);
+                    break;
+                case L2CAP_EVENT_LE_CHANNEL_OPENED:
+                    channel_opened = l2cap_event_le_channel_opened_get_status(packet) == ERROR_CODE_SUCCESS;
+                    break;
+                case L2CAP_EVENT_LE_CHANNEL_CLOSED:
+                    channel_closed = true;
+                    if (num_released == 0){
+                        closed_before_release = true;
+                    }
+                    break;
+                case L2CAP_EVENT_LE_PACKET_SENT:
+                    num_packets_sent++;
+                    break;
+                default:
+                    break;
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+static void sdu_release(l2cap_le_sdu_t * sdu, uint8_t status){
+    if (num_released < TEST_MAX_SDUS){
+        released_indices[num_released] = (uint8_t) (uintptr_t) sdu->context;
+        released_status[num_released]  = status;
+    }
+    num_released++;
+}
+
+static l2cap_le_sdu_t * setup_sdu(uint8_t index, uint16_t len){
+    l2cap_le_sdu_t * sdu = &sdus[index];
+    memset(sdu, 0, sizeof(l2cap_le_sdu_t));
+    memset(sdu_data[index], index, len);
+    sdu->data    = sdu_data[index];
+    sdu->len     = len;
+    sdu->release = &sdu_release;
+    sdu->context = (void *) (uintptr_t) index;
+    return sdu;
+}
+
+static void receive_signaling_with_identifier(uint8_t code, uint8_t identifier, const uint8_t * data, uint16_t len){
+    uint8_t packet[100];
+    packet[0] = code;
+    packet[1] = identifier;
+    little_endian_store_16(packet, 2, len);
+    (void)memcpy(&packet[4], data, len);
+    mock_hci_transport_receive_l2cap_packet(con_handle, L2CAP_CID_SIGNALING_LE, packet, 4 + len);
+    mock_hci_transport_process();
+}
+
+static void receive_signaling(uint8_t code, const uint8_t * data, uint16_t len){
+    receive_signaling_with_identifier(code, ++remote_sig_id, data, len);
+}
+
+// @return last signaling command with code sent by BTstack or NULL
+static const uint8_t * find_signaling(uint8_t code){
+    uint16_t num_packets = mock_hci_transport_num_l2cap_packets();
+    while (num_packets > 0){
+        num_packets--;
+        uint16_t len;
+        const uint8_t * packet = mock_hci_transport_get_l2cap_packet(num_packets, &len);
+        if (little_endian_read_16(packet, 2) != L2CAP_CID_SIGNALING_LE) continue;
+        if (packet[4] != code) continue;
+        return &packet[4];
+    }
+    return NULL;
+}
+
+static uint16_t num_k_frames(void){
+    uint16_t num_frames = 0;
+    uint16_t i;
+    for (i = 0; i < mock_hci_transport_num_l2cap_packets(); i++){
+        uint16_t len;
+        const uint8_t * packet = mock_hci_transport_get_l2cap_packet(i, &len);
+        if (little_endian_read_16(packet, 2) == TEST_REMOTE_CID){
+            num_frames++;
+        }
+    }
+    return num_frames;
+}
+
+static void receive_credits(uint16_t credits){
+    uint8_t data[4];
+    little_endian_store_16(data, 0, TEST_REMOTE_CID);
+    little_endian_store_16(data, 2, credits);
+    receive_signaling(LE_FLOW_CONTROL_CREDIT, data, sizeof(data));
+}
+
+// open incoming channel, remote provides initial credits
+static void open_channel(uint16_t remote_credits){
+    uint8_t data[10];
+    little_endian_store_16(data, 0, TEST_PSM);
+    little_endian_store_16(data, 2, TEST_REMOTE_CID);
+    little_endian_store_16(data, 4, TEST_REMOTE_MTU);
+    little_endian_store_16(data, 6, TEST_REMOTE_MPS);
+    little_endian_store_16(data, 8, remote_credits);
+    receive_signaling(LE_CREDIT_BASED_CONNECTION_REQUEST, data, sizeof(data));
+    CHECK(local_cid != 0);
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, l2cap_le_accept_connection(local_cid, receive_buffer, sizeof(receive_buffer), 10));
+    mock_hci_transport_process();
+    CHECK_TRUE(channel_opened);
+    mock_hci_transport_clear_l2cap_packets();
+}
+
+static void check_released(uint8_t num_sdus, uint8_t status){
+    CHECK_EQUAL(num_sdus, num_released);
+    uint8_t i;
+    for (i = 0; i < num_sdus; i++){
+        CHECK_EQUAL(i, released_indices[i]);
+        CHECK_EQUAL(status, released_status[i]);
+    }
+}
+
+TEST_GROUP(L2CAP_LE_SDU_QUEUE){
+    void setup(void){
+        remote_sig_id = 0;
+        local_cid = 0;
+        channel_opened = false;
+        channel_closed = false;
+        num_packets_sent = 0;
+        num_sdus_received = 0;
+        num_released = 0;
+        closed_before_release = false;
+        btstack_memory_init();
+        hci_init(mock_hci_transport_instance(), NULL);
+        l2cap_init();
+        l2cap_le_register_service(&l2cap_packet_handler, TEST_PSM, LEVEL_0);
+        hci_power_control(HCI_POWER_ON);
+        mock_hci_transport_process();
+        CHECK_EQUAL(HCI_STATE_WORKING, hci_get_state());
+        mock_hci_transport_queue_le_connection_complete(con_handle, remote_addr);
+        mock_hci_transport_process();
+        mock_hci_transport_clear_l2cap_packets();
+    }
+    void teardown(void){
+        l2cap_le_unregister_service(TEST_PSM);
+        hci_close();
+    }
+};
+
+TEST(L2CAP_LE_SDU_QUEUE, InvalidParameters){
+    open_channel(10);
+    CHECK_EQUAL(L2CAP_LOCAL_CID_DOES_NOT_EXIST, l2cap_le_queue_sdu(local_cid + 1, setup_sdu(0, 10)));
+    CHECK_EQUAL(L2CAP_DATA_LEN_EXCEEDS_REMOTE_MTU, l2cap_le_queue_sdu(local_cid, setup_sdu(0, TEST_REMOTE_MTU + 1)));
+    CHECK_EQUAL(0, num_released);
+}
+
+TEST(L2CAP_LE_SDU_QUEUE, ReleasedInOrder){
+    open_channel(20);
+    uint8_t i;
+    for (i = 0; i < 4; i++){
+        CHECK_EQUAL(ERROR_CODE_SUCCESS, l2cap_le_queue_sdu(local_cid, setup_sdu(i, 30 + i)));
+    }
+    mock_hci_transport_process();
+    check_released(4, ERROR_CODE_SUCCESS);
+    // no LE Packet Sent for queued SDUs
+    CHECK_EQUAL(0, num_packets_sent);
+    // single K-frame per SDU with SDU length and data
+    CHECK_EQUAL(4, num_k_frames());
+    for (i = 0; i < 4; i++){
+        uint16_t len;
+        const uint8_t * packet = mock_hci_transport_get_l2cap_packet(i, &len);
+        CHECK_EQUAL(4 + 2 + 30 + i, len);
+        CHECK_EQUAL(30 + i, little_endian_read_16(packet, 4));
+        MEMCMP_EQUAL(sdu_data[i], &packet[6], 30 + i);
+    }
+}
+
+TEST(L2CAP_LE_SDU_QUEUE, SegmentedSdusWaitForCredits){
+    // 3 K-frames per SDU with MPS 50
+    open_channel(4);
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, l2cap_le_queue_sdu(local_cid, setup_sdu(0, 120)));
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, l2cap_le_queue_sdu(local_cid, setup_sdu(1, 120)));
+    mock_hci_transport_process();
+    CHECK_EQUAL(4, num_k_frames());
+    check_released(1, ERROR_CODE_SUCCESS);
+
+    receive_credits(2);
+    CHECK_EQUAL(6, num_k_frames());
+    check_released(2, ERROR_CODE_SUCCESS);
+
+    // reassemble second SDU from K-frames 4..6
+    uint8_t sdu[120];
+    uint16_t pos = 0;
+    uint16_t i;
+    for (i = 3; i < 6; i++){
+        uint16_t len;
+        const uint8_t * packet = mock_hci_transport_get_l2cap_packet(i, &len);
+        uint16_t offset = (i == 3) ? 6 : 4;
+        memcpy(&sdu[pos], &packet[offset], len - offset);
+        pos += len - offset;
+    }
+    CHECK_EQUAL(120, pos);
+    MEMCMP_EQUAL(sdu_data[1], sdu, sizeof(sdu));
+}
+
+TEST(L2CAP_LE_SDU_QUEUE, QueuedAfterSendData){
+    open_channel(0);
+    uint8_t data[20];
+    memset(data, 0x55, sizeof(data));
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, l2cap_le_send_data(local_cid, data, sizeof(data)));
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, l2cap_le_queue_sdu(local_cid, setup_sdu(0, 10)));
+    // pending SDU blocks l2cap_le_send_data
+    CHECK_EQUAL(BTSTACK_ACL_BUFFERS_FULL, l2cap_le_send_data(local_cid, data, sizeof(data)));
+
+    receive_credits(1);
+    CHECK_EQUAL(1, num_packets_sent);
+    CHECK_EQUAL(0, num_released);
+
+    receive_credits(1);
+    CHECK_EQUAL(1, num_packets_sent);
+    check_released(1, ERROR_CODE_SUCCESS);
+    uint16_t len;
+    const uint8_t * packet = mock_hci_transport_get_l2cap_packet(1, &len);
+    CHECK_EQUAL(4 + 2 + 10, len);
+    CHECK_EQUAL(TEST_REMOTE_CID, little_endian_read_16(packet, 2));
+    CHECK_EQUAL(10, little_endian_read_16(packet, 4));
+    MEMCMP_EQUAL(sdu_data[0], &packet[6], 10);
+}
+
+TEST(L2CAP_LE_SDU_QUEUE, HciDisconnectReleasesQueuedSdus){
+    // partially sent first SDU
+    open_channel(1);
+    uint8_t i;
+    for (i = 0; i < 3; i++){
+        CHECK_EQUAL(ERROR_CODE_SUCCESS, l2cap_le_queue_sdu(local_cid, setup_sdu(i, 120)));
+    }
+    mock_hci_transport_process();
+    CHECK_EQUAL(1, num_k_frames());
+    CHECK_EQUAL(0, num_released);
+
+    mock_hci_transport_queue_disconnection_complete(con_handle);
+    mock_hci_transport_process();
+    check_released(3, L2CAP_LOCAL_CID_DOES_NOT_EXIST);
+    CHECK_TRUE(channel_closed);
+    // SDUs are released after L2CAP_EVENT_LE_CHANNEL_CLOSED
+    CHECK_TRUE(closed_before_release);
+    CHECK_EQUAL(L2CAP_LOCAL_CID_DOES_NOT_EXIST, l2cap_le_queue_sdu(local_cid, setup_sdu(0, 10)));
+}
+
+TEST(L2CAP_LE_SDU_QUEUE, LocalDisconnectReleasesQueuedSdus){
+    open_channel(0);
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, l2cap_le_queue_sdu(local_cid, setup_sdu(0, 10)));
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, l2cap_le_queue_sdu(local_cid, setup_sdu(1, 10)));
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, l2cap_le_disconnect(local_cid));
+    mock_hci_transport_process();
+    // SDUs stay queued until channel is closed
+    CHECK_EQUAL(0, num_released);
+    CHECK_EQUAL(ERROR_CODE_COMMAND_DISALLOWED, l2cap_le_queue_sdu(local_cid, setup_sdu(2, 10)));
+
+    const uint8_t * request = find_signaling(DISCONNECTION_REQUEST);
+    CHECK(request != NULL);
+    uint8_t data[4];
+    little_endian_store_16(data, 0, TEST_REMOTE_CID);
+    little_endian_store_16(data, 2, local_cid);
+    receive_signaling_with_identifier(DISCONNECTION_RESPONSE, request[1], data, sizeof(data));
+    check_released(2, L2CAP_LOCAL_CID_DOES_NOT_EXIST);
+    CHECK_TRUE(channel_closed);
+}
+
+TEST(L2CAP_LE_SDU_QUEUE, TxStatistics){
+    open_channel(4);
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, l2cap_le_queue_sdu(local_cid, setup_sdu(0, 120)));
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, l2cap_le_queue_sdu(local_cid, setup_sdu(1, 20)));
+    mock_hci_transport_process();
+
+    // 3 K-frames for first SDU, last credit used for first K-frame of second SDU
+    l2cap_le_channel_statistics_t statistics;
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, l2cap_le_get_channel_statistics(local_cid, &statistics));
+    CHECK_EQUAL(2, statistics.tx_sdus);
+    CHECK_EQUAL(140, statistics.tx_bytes);
+    CHECK_EQUAL(4, statistics.tx_pdus);
+    CHECK_EQUAL(0, statistics.tx_credit_stalls);
+
+    // stall: last credit used while SDU is incomplete
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, l2cap_le_queue_sdu(local_cid, setup_sdu(2, 120)));
+    receive_credits(1);
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, l2cap_le_get_channel_statistics(local_cid, &statistics));
+    CHECK_EQUAL(5, statistics.tx_pdus);
+    CHECK_EQUAL(1, statistics.tx_credit_stalls);
+    CHECK_EQUAL(2, statistics.tx_sdus);
+
+    CHECK_EQUAL(L2CAP_LOCAL_CID_DOES_NOT_EXIST, l2cap_le_get_channel_statistics(local_cid + 1, &statistics));
+}
+
+TEST(L2CAP_LE_SDU_QUEUE, RxStatisticsAndReset){
+    open_channel(4);
+    // SDU of 60 bytes in two K-frames
+    uint8_t pdu[50];
+    little_endian_store_16(pdu, 0, 60);
+    memset(&pdu[2], 0x11, 48);
+    mock_hci_transport_receive_l2cap_packet(con_handle, local_cid, pdu, 50);
+    mock_hci_transport_receive_l2cap_packet(con_handle, local_cid, pdu, 12);
+    mock_hci_transport_process();
+    CHECK_EQUAL(1, num_sdus_received);
+
+    l2cap_le_channel_statistics_t statistics;
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, l2cap_le_get_channel_statistics(local_cid, &statistics));
+    CHECK_EQUAL(1, statistics.rx_sdus);
+    CHECK_EQUAL(60, statistics.rx_bytes);
+    CHECK_EQUAL(2, statistics.rx_pdus);
+
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, l2cap_le_reset_channel_statistics(local_cid));
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, l2cap_le_get_channel_statistics(local_cid, &statistics));
+    CHECK_EQUAL(0, statistics.rx_sdus);
+    CHECK_EQUAL(0, statistics.rx_bytes);
+    CHECK_EQUAL(0, statistics.rx_pdus);
+    CHECK_EQUAL(0, statistics.tx_pdus);
+    CHECK_EQUAL(btstack_run_loop_get_time_ms(), statistics.start_ms);
+    CHECK_EQUAL(L2CAP_LOCAL_CID_DOES_NOT_EXIST, l2cap_le_reset_channel_statistics(local_cid + 1));
+}
+
+TEST(L2CAP_LE_SDU_QUEUE, HciAclCreditStallCountedOnce){
+    open_channel(30);
+    mock_hci_transport_set_complete_acl_packets(0);
+    btstack_stats_reset();
+
+    // 12 K-frames, 8 Controller ACL buffers
+    uint8_t i;
+    for (i = 0; i < 4; i++){
+        CHECK_EQUAL(ERROR_CODE_SUCCESS, l2cap_le_queue_sdu(local_cid, setup_sdu(i, 120)));
+    }
+    mock_hci_transport_process();
+    CHECK_EQUAL(8, num_k_frames());
+    CHECK_EQUAL(0, hci_can_send_acl_le_packet_now());
+    CHECK_EQUAL(0, hci_can_send_acl_le_packet_now());
+    CHECK_EQUAL(1, btstack_stats_get()->counters[BTSTACK_STATS_HCI_ACL_CREDIT_STALLS]);
+
+    // buffers available again
+    mock_hci_transport_queue_number_of_completed_packets(con_handle, 8);
+    mock_hci_transport_process();
+    CHECK_EQUAL(12, num_k_frames());
+    check_released(4, ERROR_CODE_SUCCESS);
+    CHECK_EQUAL(1, btstack_stats_get()->counters[BTSTACK_STATS_HCI_ACL_CREDIT_STALLS]);
+
+    // next stall
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, l2cap_le_queue_sdu(local_cid, setup_sdu(4, 120)));
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, l2cap_le_queue_sdu(local_cid, setup_sdu(5, 120)));
+    mock_hci_transport_process();
+    CHECK_EQUAL(16, num_k_frames());
+    CHECK_EQUAL(2, btstack_stats_get()->counters[BTSTACK_STATS_HCI_ACL_CREDIT_STALLS]);
+}
+
+TEST(L2CAP_LE_SDU_QUEUE, HciPacketBufferContentionCountedOnce){
+    btstack_stats_reset();
+    CHECK_EQUAL(1, hci_reserve_packet_buffer());
+    CHECK_EQUAL(0, hci_can_send_acl_le_packet_now());
+    CHECK_EQUAL(0, hci_can_send_acl_le_packet_now());
+    CHECK_EQUAL(0, hci_reserve_packet_buffer());
+    CHECK_EQUAL(1, btstack_stats_get()->counters[BTSTACK_STATS_HCI_PACKET_BUFFER_CONTENTION]);
+    hci_release_packet_buffer();
+
+    CHECK_EQUAL(1, hci_reserve_packet_buffer());
+    CHECK_EQUAL(0, hci_can_send_acl_le_packet_now());
+    CHECK_EQUAL(2, btstack_stats_get()->counters[BTSTACK_STATS_HCI_PACKET_BUFFER_CONTENTION]);
+    hci_release_packet_buffer();
+}
+
+int main (int argc, const char * argv[]){
+    btstack_run_loop_init(btstack_run_loop_posix_get_instance());
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
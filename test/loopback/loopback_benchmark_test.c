@@ -0,0 +1,602 @@
+// Loopback benchmarks: two BTstack processes connected by virtual Controllers over a socketpair
+//
+// For each benchmark, an initiator and an acceptor process are forked. The sender adds sequence
+// number and send time to each packet, the receiver measures throughput and one-way latency and
+// reports the result to the test via a pipe. Thresholds are relative to the modeled link.
+
+#include <poll.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/CommandLineTestRunner.h"
+
+#include "ble/att_server.h"
+#include "ble/gatt_client.h"
+#include "ble/sm.h"
+#include "bluetooth_data_types.h"
+#include "bluetooth_psm.h"
+#include "btstack_debug.h"
+#include "btstack_event.h"
+#include "btstack_memory.h"
+#include "btstack_run_loop.h"
+#include "btstack_run_loop_posix.h"
+#include "btstack_util.h"
+#include "classic/rfcomm.h"
+#include "gap.h"
+#include "hci.h"
+#include "l2cap.h"
+
+#include "profile.h"
+#include "virtual_controller.h"
+
+#define BENCHMARK_L2CAP_PSM                 0x1001
+#define BENCHMARK_LE_PSM                    0x0080
+#define BENCHMARK_RFCOMM_CHANNEL            1
+#define BENCHMARK_MTU                       1000
+#define BENCHMARK_ATT_MTU                   247
+#define BENCHMARK_VALUE_HANDLE              ATT_CHARACTERISTIC_0000FF11_0000_1000_8000_00805F9B34FB_01_VALUE_HANDLE
+
+// link: 2 Mbit/s ACL payload, Controller buffers
+#define BENCHMARK_BANDWIDTH                 250000
+#define BENCHMARK_RETRANSMISSION_DELAY_MS   2
+#define BENCHMARK_NUM_ACL_PACKETS           8
+
+// node gives up if benchmark does not complete in time, test waits a bit longer
+#define BENCHMARK_NODE_TIMEOUT_MS           8000
+#define BENCHMARK_TEST_TIMEOUT_MS           10000
+#define BENCHMARK_EXIT_TIMEOUT_MS           1000
+
+// packet: sequence number, send time in us, filler
+#define BENCHMARK_HEADER_SIZE               12
+
+typedef enum {
+    BENCHMARK_L2CAP = 0,
+    BENCHMARK_RFCOMM,
+    BENCHMARK_LE_COC,
+    BENCHMARK_ATT_NOTIFY,
+    BENCHMARK_ATT_WRITE,
+    BENCHMARK_A2DP_MEDIA,
+} benchmark_channel_t;
+
+typedef enum {
+    BENCHMARK_STATUS_OK = 0,
+    BENCHMARK_STATUS_CHANNEL_FAILED,
+    BENCHMARK_STATUS_TIMEOUT,
+    BENCHMARK_STATUS_NO_RESULT,
+} benchmark_status_t;
+
+typedef struct {
+    const char *        name;
+    benchmark_channel_t channel;
+    uint16_t            packet_size;
+    uint16_t            num_packets;
+    // 0 = send as fast as possible
+    uint16_t            packet_interval_ms;
+    uint16_t            latency_ms;
+    uint8_t             loss_percent;
+    // thresholds, 0 = not checked
+    uint8_t             min_throughput_percent;
+    uint16_t            max_avg_latency_ms;
+} benchmark_t;
+
+typedef struct {
+    uint8_t  status;
+    uint32_t num_packets;
+    uint32_t num_bytes;
+    uint32_t duration_us;
+    uint32_t throughput;
+    uint32_t avg_latency_us;
+    uint32_t max_latency_us;
+} benchmark_result_t;
+
+// node state, one node per process
+static const benchmark_t *         benchmark;
+static bool                        node_is_initiator;
+static bool                        node_is_sender;
+static bool                        node_completed;
+static int                         node_result_fd;
+static bd_addr_t                   node_peer_addr;
+static virtual_controller_config_t node_controller_config;
+static btstack_packet_callback_registration_t node_hci_event_callback_registration;
+static gatt_client_notification_t  node_notification_listener;
+static btstack_timer_source_t      node_timeout_timer;
+static btstack_timer_source_t      node_pacing_timer;
+
+static hci_con_handle_t node_con_handle;
+static uint16_t         node_cid;
+static uint16_t         node_max_payload;
+static uint16_t         node_num_packets_sent;
+static uint64_t         node_first_send_us;
+static uint8_t          node_tx_buffer[BENCHMARK_MTU];
+static uint8_t          node_rx_buffer[BENCHMARK_MTU];
+
+static benchmark_result_t node_result;
+static uint16_t           node_first_packet_size;
+static uint64_t           node_first_rx_us;
+static uint64_t           node_last_rx_us;
+static uint64_t           node_latency_sum_us;
+
+static const bd_addr_t initiator_addr = { 0x00, 0x1B, 0xDC, 0x00, 0x00, 0x01 };
+static const bd_addr_t acceptor_addr  = { 0x00, 0x1B, 0xDC, 0x00, 0x00, 0x02 };
+
+static const uint8_t adv_data[] = { 0x02, BLUETOOTH_DATA_TYPE_FLAGS, 0x06 };
+
+static void benchmark_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size);
+
+static void benchmark_complete(uint8_t status){
+    if (node_completed) return;
+    node_completed = true;
+
+    node_result.status = status;
+    node_result.duration_us = (uint32_t) (node_last_rx_us - node_first_rx_us);
+    if (node_result.duration_us > 0u){
+        uint64_t bytes = node_result.num_bytes - node_first_packet_size;
+        node_result.throughput = (uint32_t) ((bytes * 1000000u) / node_result.duration_us);
+    }
+    if (node_result.num_packets > 0u){
+        node_result.avg_latency_us = (uint32_t) (node_latency_sum_us / node_result.num_packets);
+    }
+    ssize_t res = write(node_result_fd, &node_result, sizeof(node_result));
+    UNUSED(res);
+
+    if ((status == BENCHMARK_STATUS_OK) && (node_con_handle != HCI_CON_HANDLE_INVALID)){
+        gap_disconnect(node_con_handle);
+    } else {
+        btstack_run_loop_posix_trigger_exit();
+    }
+}
+
+static void benchmark_receive_packet(const uint8_t * packet, uint16_t size){
+    if (size < BENCHMARK_HEADER_SIZE) return;
+    if (node_completed) return;
+    uint64_t now = virtual_controller_time_us();
+    uint64_t sent_us = ((uint64_t) little_endian_read_32(packet, 8) << 32) | little_endian_read_32(packet, 4);
+    uint32_t latency_us = (uint32_t) (now - sent_us);
+    node_latency_sum_us += latency_us;
+    node_result.max_latency_us = btstack_max(node_result.max_latency_us, latency_us);
+    if (node_result.num_packets == 0u){
+        node_first_rx_us = now;
+        node_first_packet_size = size;
+    }
+    node_last_rx_us = now;
+    node_result.num_packets++;
+    node_result.num_bytes += size;
+    if (node_result.num_packets == benchmark->num_packets){
+        benchmark_complete(BENCHMARK_STATUS_OK);
+    }
+}
+
+static void benchmark_request_can_send_now(void){
+    switch (benchmark->channel){
+        case BENCHMARK_L2CAP:
+        case BENCHMARK_A2DP_MEDIA:
+            l2cap_request_can_send_now_event(node_cid);
+            break;
+        case BENCHMARK_RFCOMM:
+            rfcomm_request_can_send_now_event(node_cid);
+            break;
+        case BENCHMARK_LE_COC:
+            l2cap_le_request_can_send_now_event(node_cid);
+            break;
+        case BENCHMARK_ATT_NOTIFY:
+            att_server_request_can_send_now_event(node_con_handle);
+            break;
+        case BENCHMARK_ATT_WRITE:
+            gatt_client_request_can_write_without_response_event(&benchmark_packet_handler, node_con_handle);
+            break;
+        default:
+            btstack_assert(false);
+            break;
+    }
+}
+
+static void benchmark_pacing_timeout(btstack_timer_source_t * ts){
+    UNUSED(ts);
+    benchmark_request_can_send_now();
+}
+
+static void benchmark_send_packet(void){
+    if (node_num_packets_sent >= benchmark->num_packets) return;
+
+    uint16_t size = btstack_min(benchmark->packet_size, node_max_payload);
+    uint64_t now = virtual_controller_time_us();
+    little_endian_store_32(node_tx_buffer, 0, node_num_packets_sent);
+    little_endian_store_32(node_tx_buffer, 4, (uint32_t) now);
+    little_endian_store_32(node_tx_buffer, 8, (uint32_t) (now >> 32));
+    switch (benchmark->channel){
+        case BENCHMARK_L2CAP:
+        case BENCHMARK_A2DP_MEDIA:
+            l2cap_send(node_cid, node_tx_buffer, size);
+            break;
+        case BENCHMARK_RFCOMM:
+            rfcomm_send(node_cid, node_tx_buffer, size);
+            break;
+        case BENCHMARK_LE_COC:
+            // buffer stays valid until next can send now event
+            l2cap_le_send_data(node_cid, node_tx_buffer, size);
+            break;
+        case BENCHMARK_ATT_NOTIFY:
+            att_server_notify(node_con_handle, BENCHMARK_VALUE_HANDLE, node_tx_buffer, size);
+            break;
+        case BENCHMARK_ATT_WRITE:
+            gatt_client_write_value_of_characteristic_without_response(node_con_handle, BENCHMARK_VALUE_HANDLE, size, node_tx_buffer);
+            break;
+        default:
+            btstack_assert(false);
+            break;
+    }
+    node_num_packets_sent++;
+    if (node_num_packets_sent == benchmark->num_packets) return;
+
+    if (benchmark->packet_interval_ms == 0u){
+        benchmark_request_can_send_now();
+        return;
+    }
+
+    // paced stream, e.g. media packets
+    uint64_t next_send_us = node_first_send_us + ((uint64_t) node_num_packets_sent * benchmark->packet_interval_ms * 1000u);
+    uint32_t timeout_ms = 0;
+    if (next_send_us > now){
+        timeout_ms = (uint32_t) ((next_send_us - now) / 1000u);
+    }
+    btstack_run_loop_set_timer_handler(&node_pacing_timer, &benchmark_pacing_timeout);
+    btstack_run_loop_set_timer(&node_pacing_timer, timeout_ms);
+    btstack_run_loop_add_timer(&node_pacing_timer);
+}
+
+static void benchmark_channel_ready(uint16_t max_payload){
+    node_max_payload = btstack_min(max_payload, sizeof(node_tx_buffer));
+    if (!node_is_sender) return;
+    node_first_send_us = virtual_controller_time_us();
+    benchmark_request_can_send_now();
+}
+
+static void benchmark_channel_failed(uint8_t status){
+    printf("%s: channel failed, status 0x%02x\n", benchmark->name, status);
+    if (node_is_sender){
+        btstack_run_loop_posix_trigger_exit();
+    } else {
+        benchmark_complete(BENCHMARK_STATUS_CHANNEL_FAILED);
+    }
+}
+
+static void benchmark_node_start(void){
+    if (node_is_initiator){
+        switch (benchmark->channel){
+            case BENCHMARK_L2CAP:
+                l2cap_create_channel(&benchmark_packet_handler, node_peer_addr, BENCHMARK_L2CAP_PSM, BENCHMARK_MTU, &node_cid);
+                break;
+            case BENCHMARK_A2DP_MEDIA:
+                l2cap_create_channel(&benchmark_packet_handler, node_peer_addr, BLUETOOTH_PSM_AVDTP, BENCHMARK_MTU, &node_cid);
+                break;
+            case BENCHMARK_RFCOMM:
+                rfcomm_create_channel(&benchmark_packet_handler, node_peer_addr, BENCHMARK_RFCOMM_CHANNEL, &node_cid);
+                break;
+            default:
+                gap_connect(node_peer_addr, BD_ADDR_TYPE_LE_PUBLIC);
+                break;
+        }
+    } else {
+        switch (benchmark->channel){
+            case BENCHMARK_L2CAP:
+            case BENCHMARK_A2DP_MEDIA:
+            case BENCHMARK_RFCOMM:
+                gap_connectable_control(1);
+                break;
+            default:
+                gap_advertisements_enable(1);
+                break;
+        }
+    }
+}
+
+static void benchmark_handle_le_connection_complete(const uint8_t * packet){
+    if (hci_subevent_le_connection_complete_get_status(packet) != ERROR_CODE_SUCCESS) return;
+    // also received via ATT Server packet handler
+    if (node_con_handle != HCI_CON_HANDLE_INVALID) return;
+    node_con_handle = hci_subevent_le_connection_complete_get_connection_handle(packet);
+    if (!node_is_initiator) return;
+    if (benchmark->channel == BENCHMARK_LE_COC){
+        l2cap_le_create_channel(&benchmark_packet_handler, node_con_handle, BENCHMARK_LE_PSM, node_rx_buffer,
+                                sizeof(node_rx_buffer), L2CAP_LE_AUTOMATIC_CREDITS, LEVEL_0, &node_cid);
+    } else {
+        gatt_client_listen_for_characteristic_value_updates(&node_notification_listener, &benchmark_packet_handler, node_con_handle, NULL);
+        gatt_client_send_mtu_negotiation(&benchmark_packet_handler, node_con_handle);
+    }
+}
+
+static void benchmark_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
+    UNUSED(channel);
+    switch (packet_type){
+        case L2CAP_DATA_PACKET:
+        case RFCOMM_DATA_PACKET:
+            benchmark_receive_packet(packet, size);
+            return;
+        case HCI_EVENT_PACKET:
+            break;
+        default:
+            return;
+    }
+
+    uint8_t status;
+    switch (hci_event_packet_get_type(packet)){
+        case BTSTACK_EVENT_STATE:
+            if (btstack_event_state_get_state(packet) != HCI_STATE_WORKING) break;
+            benchmark_node_start();
+            break;
+        case HCI_EVENT_LE_META:
+            if (hci_event_le_meta_get_subevent_code(packet) != HCI_SUBEVENT_LE_CONNECTION_COMPLETE) break;
+            benchmark_handle_le_connection_complete(packet);
+            break;
+        case HCI_EVENT_DISCONNECTION_COMPLETE:
+            btstack_run_loop_posix_trigger_exit();
+            break;
+
+        // Classic
+        case L2CAP_EVENT_INCOMING_CONNECTION:
+            l2cap_accept_connection(l2cap_event_incoming_connection_get_local_cid(packet));
+            break;
+        case L2CAP_EVENT_CHANNEL_OPENED:
+            status = l2cap_event_channel_opened_get_status(packet);
+            if (status != ERROR_CODE_SUCCESS){
+                benchmark_channel_failed(status);
+                break;
+            }
+            node_cid = l2cap_event_channel_opened_get_local_cid(packet);
+            node_con_handle = l2cap_event_channel_opened_get_handle(packet);
+            benchmark_channel_ready(l2cap_event_channel_opened_get_remote_mtu(packet));
+            break;
+        case RFCOMM_EVENT_INCOMING_CONNECTION:
+            rfcomm_accept_connection(rfcomm_event_incoming_connection_get_rfcomm_cid(packet));
+            break;
+        case RFCOMM_EVENT_CHANNEL_OPENED:
+            status = rfcomm_event_channel_opened_get_status(packet);
+            if (status != ERROR_CODE_SUCCESS){
+                benchmark_channel_failed(status);
+                break;
+            }
+            node_cid = rfcomm_event_channel_opened_get_rfcomm_cid(packet);
+            node_con_handle = rfcomm_event_channel_opened_get_con_handle(packet);
+            benchmark_channel_ready(rfcomm_event_channel_opened_get_max_frame_size(packet));
+            break;
+
+        // LE
+        case L2CAP_EVENT_LE_INCOMING_CONNECTION:
+            l2cap_le_accept_connection(l2cap_event_le_incoming_connection_get_local_cid(packet), node_rx_buffer,
+                                       sizeof(node_rx_buffer), L2CAP_LE_AUTOMATIC_CREDITS);
+            break;
+        case L2CAP_EVENT_LE_CHANNEL_OPENED:
+            status = l2cap_event_le_channel_opened_get_status(packet);
+            if (status != ERROR_CODE_SUCCESS){
+                benchmark_channel_failed(status);
+                break;
+            }
+            node_cid = l2cap_event_le_channel_opened_get_local_cid(packet);
+            benchmark_channel_ready(l2cap_event_le_channel_opened_get_remote_mtu(packet));
+            break;
+        case GATT_EVENT_MTU:
+            benchmark_channel_ready(gatt_event_mtu_get_MTU(packet) - 3u);
+            break;
+        case ATT_EVENT_MTU_EXCHANGE_COMPLETE:
+            benchmark_channel_ready(att_event_mtu_exchange_complete_get_MTU(packet) - 3u);
+            break;
+        case GATT_EVENT_NOTIFICATION:
+            benchmark_receive_packet(gatt_event_notification_get_value(packet), gatt_event_notification_get_value_length(packet));
+            break;
+
+        case L2CAP_EVENT_CAN_SEND_NOW:
+        case RFCOMM_EVENT_CAN_SEND_NOW:
+        case L2CAP_EVENT_LE_CAN_SEND_NOW:
+        case ATT_EVENT_CAN_SEND_NOW:
+        case GATT_EVENT_CAN_WRITE_WITHOUT_RESPONSE:
+            benchmark_send_packet();
+            break;
+        default:
+            break;
+    }
+}
+
+static int benchmark_att_write_callback(hci_con_handle_t con_handle, uint16_t attribute_handle, uint16_t transaction_mode,
+                                        uint16_t offset, uint8_t *buffer, uint16_t buffer_size){
+    UNUSED(con_handle);
+    UNUSED(transaction_mode);
+    UNUSED(offset);
+    if (attribute_handle == BENCHMARK_VALUE_HANDLE){
+        benchmark_receive_packet(buffer, buffer_size);
+    }
+    return 0;
+}
+
+static void benchmark_node_timeout(btstack_timer_source_t * ts){
+    UNUSED(ts);
+    if (node_is_sender){
+        btstack_run_loop_posix_trigger_exit();
+    } else {
+        benchmark_complete(BENCHMARK_STATUS_TIMEOUT);
+    }
+}
+
+// runs in forked process
+static void benchmark_node_run(const benchmark_t * the_benchmark, bool is_initiator, int air_fd, int result_fd){
+    benchmark = the_benchmark;
+    node_is_initiator = is_initiator;
+    node_is_sender = (benchmark->channel == BENCHMARK_ATT_NOTIFY) ? !is_initiator : is_initiator;
+    node_result_fd = result_fd;
+    node_con_handle = HCI_CON_HANDLE_INVALID;
+    bd_addr_copy(node_peer_addr, is_initiator ? acceptor_addr : initiator_addr);
+
+    memset(&node_controller_config, 0, sizeof(node_controller_config));
+    node_controller_config.air_fd = air_fd;
+    bd_addr_copy(node_controller_config.bd_addr, is_initiator ? initiator_addr : acceptor_addr);
+    node_controller_config.acl_packet_length = 1021;
+    node_controller_config.num_acl_packets = BENCHMARK_NUM_ACL_PACKETS;
+    node_controller_config.le_acl_packet_length = 251;
+    node_controller_config.num_le_acl_packets = BENCHMARK_NUM_ACL_PACKETS;
+    node_controller_config.bandwidth = BENCHMARK_BANDWIDTH;
+    node_controller_config.latency_ms = benchmark->latency_ms;
+    node_controller_config.loss_percent = benchmark->loss_percent;
+    node_controller_config.retransmission_delay_ms = BENCHMARK_RETRANSMISSION_DELAY_MS;
+    node_controller_config.random_seed = is_initiator ? 1 : 2;
+
+    btstack_memory_init();
+    btstack_run_loop_init(btstack_run_loop_posix_get_instance());
+    hci_init(virtual_controller_instance(), &node_controller_config);
+
+    l2cap_init();
+    l2cap_set_max_le_mtu(BENCHMARK_ATT_MTU);
+    rfcomm_init();
+    sm_init();
+    att_server_init(profile_data, NULL, &benchmark_att_write_callback);
+    gatt_client_init();
+    // explicit MTU exchange reports GATT_EVENT_MTU to benchmark
+    gatt_client_mtu_enable_auto_negotiation(0);
+
+    gap_set_security_level(LEVEL_0);
+    rfcomm_set_required_security_level(LEVEL_0);
+
+    l2cap_register_service(&benchmark_packet_handler, BENCHMARK_L2CAP_PSM, BENCHMARK_MTU, LEVEL_0);
+    l2cap_register_service(&benchmark_packet_handler, BLUETOOTH_PSM_AVDTP, BENCHMARK_MTU, LEVEL_0);
+    rfcomm_register_service(&benchmark_packet_handler, BENCHMARK_RFCOMM_CHANNEL, BENCHMARK_MTU);
+    l2cap_le_register_service(&benchmark_packet_handler, BENCHMARK_LE_PSM, LEVEL_0);
+
+    bd_addr_t null_addr;
+    memset(null_addr, 0, sizeof(null_addr));
+    gap_advertisements_set_params(0x0030, 0x0030, 0, 0, null_addr, 0x07, 0x00);
+    gap_advertisements_set_data(sizeof(adv_data), (uint8_t *) adv_data);
+
+    node_hci_event_callback_registration.callback = &benchmark_packet_handler;
+    hci_add_event_handler(&node_hci_event_callback_registration);
+    att_server_register_packet_handler(&benchmark_packet_handler);
+
+    btstack_run_loop_set_timer_handler(&node_timeout_timer, &benchmark_node_timeout);
+    btstack_run_loop_set_timer(&node_timeout_timer, BENCHMARK_NODE_TIMEOUT_MS);
+    btstack_run_loop_add_timer(&node_timeout_timer);
+
+    hci_power_control(HCI_POWER_ON);
+    btstack_run_loop_execute();
+}
+
+static void benchmark_wait_for_exit(pid_t pid){
+    uint32_t waited_ms;
+    for (waited_ms = 0; waited_ms < BENCHMARK_EXIT_TIMEOUT_MS; waited_ms += 10){
+        if (waitpid(pid, NULL, WNOHANG) == pid) return;
+        usleep(10000);
+    }
+    kill(pid, SIGKILL);
+    waitpid(pid, NULL, 0);
+}
+
+static void benchmark_run(const benchmark_t * the_benchmark, benchmark_result_t * result){
+    int air_fds[2];
+    int result_fds[2];
+    CHECK_EQUAL(0, socketpair(AF_UNIX, SOCK_SEQPACKET, 0, air_fds));
+    CHECK_EQUAL(0, pipe(result_fds));
+    fflush(stdout);
+
+    pid_t pids[2];
+    int node;
+    for (node = 0; node < 2; node++){
+        pids[node] = fork();
+        CHECK(pids[node] >= 0);
+        if (pids[node] == 0){
+            close(air_fds[1 - node]);
+            close(result_fds[0]);
+            benchmark_node_run(the_benchmark, node == 0, air_fds[node], result_fds[1]);
+            fflush(stdout);
+            _exit(0);
+        }
+    }
+    close(air_fds[0]);
+    close(air_fds[1]);
+    close(result_fds[1]);
+
+    memset(result, 0, sizeof(benchmark_result_t));
+    result->status = BENCHMARK_STATUS_NO_RESULT;
+    struct pollfd poll_fd;
+    poll_fd.fd = result_fds[0];
+    poll_fd.events = POLLIN;
+    poll_fd.revents = 0;
+    if (poll(&poll_fd, 1, BENCHMARK_TEST_TIMEOUT_MS) > 0){
+        if (read(result_fds[0], result, sizeof(benchmark_result_t)) != (ssize_t) sizeof(benchmark_result_t)){
+            result->status = BENCHMARK_STATUS_NO_RESULT;
+        }
+    }
+    close(result_fds[0]);
+
+    for (node = 0; node < 2; node++){
+        benchmark_wait_for_exit(pids[node]);
+    }
+}
+
+static void benchmark_check(const benchmark_t * the_benchmark){
+    benchmark_result_t result;
+    benchmark_run(the_benchmark, &result);
+    printf("%-28s %6u bytes in %4u ms: %7u bytes/s, latency avg %6u us, max %6u us\n", the_benchmark->name,
+           result.num_bytes, result.duration_us / 1000u, result.throughput, result.avg_latency_us, result.max_latency_us);
+
+    CHECK_EQUAL(BENCHMARK_STATUS_OK, result.status);
+    CHECK_EQUAL(the_benchmark->num_packets, result.num_packets);
+    if (the_benchmark->min_throughput_percent > 0u){
+        CHECK((result.throughput * 100u) >= ((uint32_t) the_benchmark->min_throughput_percent * BENCHMARK_BANDWIDTH));
+    }
+    if (the_benchmark->max_avg_latency_ms > 0u){
+        CHECK(result.avg_latency_us <= ((uint32_t) the_benchmark->max_avg_latency_ms * 1000u));
+    }
+}
+
+//                                          name,                      channel,              size, packets, interval, latency, loss, min throughput %, max avg latency
+static const benchmark_t l2cap_throughput     = { "L2CAP",                     BENCHMARK_L2CAP,      1000,  250,  0,  5,  0, 80,  0 };
+static const benchmark_t rfcomm_throughput    = { "RFCOMM",                    BENCHMARK_RFCOMM,     1000,  250,  0,  5,  0, 70,  0 };
+static const benchmark_t le_coc_throughput    = { "LE CoC",                    BENCHMARK_LE_COC,     1000,  250,  0,  5,  0, 70,  0 };
+static const benchmark_t att_notify_throughput= { "ATT Notify",                BENCHMARK_ATT_NOTIFY,  244, 1000,  0,  5,  0, 70,  0 };
+static const benchmark_t att_write_throughput = { "ATT Write Without Response", BENCHMARK_ATT_WRITE,  244, 1000,  0,  5,  0, 70,  0 };
+static const benchmark_t le_coc_lossy         = { "LE CoC with 10% loss",      BENCHMARK_LE_COC,     1000,  200,  0,  5, 10, 40,  0 };
+// SBC high quality stream ~ 345 kbit/s
+static const benchmark_t a2dp_media           = { "A2DP Media",                BENCHMARK_A2DP_MEDIA,  650,  100, 15, 20,  0,  0, 30 };
+static const benchmark_t l2cap_latency        = { "L2CAP Latency",             BENCHMARK_L2CAP,        64,  100,  5, 10,  0,  0, 15 };
+
+TEST_GROUP(LoopbackBenchmark){
+};
+
+TEST(LoopbackBenchmark, L2CAP){
+    benchmark_check(&l2cap_throughput);
+}
+
+TEST(LoopbackBenchmark, RFCOMM){
+    benchmark_check(&rfcomm_throughput);
+}
+
+TEST(LoopbackBenchmark, LECoC){
+    benchmark_check(&le_coc_throughput);
+}
+
+TEST(LoopbackBenchmark, ATTNotify){
+    benchmark_check(&att_notify_throughput);
+}
+
+TEST(LoopbackBenchmark, ATTWrite){
+    benchmark_check(&att_write_throughput);
+}
+
+TEST(LoopbackBenchmark, LECoCLossy){
+    benchmark_check(&le_coc_lossy);
+}
+
+TEST(LoopbackBenchmark, A2DPMedia){
+    benchmark_check(&a2dp_media);
+}
+
+TEST(LoopbackBenchmark, L2CAPLatency){
+    benchmark_check(&l2cap_latency);
+}
+
+int main (int argc, const char * argv[]){
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
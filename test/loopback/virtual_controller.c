@@ -0,0 +1,873 @@
+/*
+ * Copyright (C) 2019 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+#define BTSTACK_FILE__ "virtual_controller.c"
+
+/*
+ *  virtual_controller.c
+ *
+ *  Air messages consist of message type, delivery time and payload. The sender computes when an
+ *  ACL packet has been transmitted according to the link model and writes it to the socket at that
+ *  time, the receiver keeps it in the socket until its delivery time. As both processes use the
+ *  same monotonic clock, the one-way latency is independent of the run loop of the receiver.
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "btstack_config.h"
+
+#include "virtual_controller.h"
+
+#include "bluetooth_company_id.h"
+#include "btstack_debug.h"
+#include "btstack_run_loop.h"
+#include "btstack_util.h"
+#include "hci.h"
+#include "hci_cmd.h"
+
+// air message: message type, delivery time in us, payload
+#define AIR_HEADER_SIZE       9
+#define AIR_MAX_MESSAGE_SIZE  (AIR_HEADER_SIZE + 1 + VIRTUAL_CONTROLLER_MAX_ACL_PACKET_LENGTH)
+
+// max number of air messages handled per run loop wakeup
+#define AIR_RX_BATCH_SIZE     16
+
+// queued packets to host: packet type, size, packet
+#define TO_HOST_QUEUE_SIZE    16384
+#define TO_HOST_HEADER_SIZE   3
+
+#define MAX_LOSS_PERCENT      90
+
+typedef enum {
+    AIR_CONNECT_REQUEST = 1,    // bd_addr
+    AIR_CONNECT_RESPONSE,       // status
+    AIR_LE_CONNECT_REQUEST,     // addr type, bd_addr
+    AIR_LE_CONNECT_CANCEL,
+    AIR_LE_CONNECT_RESPONSE,    // status, addr type, bd_addr
+    AIR_ACL,                    // packet boundary and broadcast flags, data
+    AIR_DISCONNECT,             // reason
+} air_message_type_t;
+
+typedef enum {
+    LINK_IDLE = 0,
+    LINK_W4_CONNECT_RESPONSE,
+    LINK_W4_ACCEPT,
+    LINK_CONNECTED,
+} link_state_t;
+
+typedef struct {
+    uint64_t tx_done_us;
+    uint16_t size;
+    uint8_t  packet[HCI_ACL_HEADER_SIZE + VIRTUAL_CONTROLLER_MAX_ACL_PACKET_LENGTH];
+} acl_buffer_t;
+
+// LE Supported (Controller)
+static const uint8_t virtual_controller_features[8] = { 0x00, 0x00, 0x00, 0x00, 0x40, 0x00, 0x00, 0x00 };
+
+static void dummy_handler(uint8_t packet_type, uint8_t *packet, uint16_t size);
+
+static void (*packet_handler)(uint8_t packet_type, uint8_t *packet, uint16_t size) = dummy_handler;
+
+static const virtual_controller_config_t * virtual_controller_config;
+static virtual_controller_statistics_t     virtual_controller_statistics;
+static uint32_t                            virtual_controller_random_state;
+
+static btstack_data_source_t  air_data_source;
+static btstack_timer_source_t air_rx_timer;
+static btstack_timer_source_t air_tx_timer;
+static btstack_timer_source_t to_host_timer;
+
+// link
+static link_state_t link_state;
+static bool         link_is_le;
+static bd_addr_t    link_peer_addr;
+static bool         page_scan_enabled;
+static bool         advertising_enabled;
+
+// connect request from peer that cannot be handled yet
+static uint8_t      pending_request;
+static bd_addr_t    pending_request_addr;
+
+// ACL packets from host until sent over the air
+static acl_buffer_t acl_buffers[VIRTUAL_CONTROLLER_MAX_ACL_BUFFERS];
+static uint16_t     acl_buffers_head;
+static uint16_t     acl_buffers_count;
+static uint64_t     air_busy_until_us;
+
+// air message received but not delivered yet
+static uint8_t      air_rx_message[AIR_MAX_MESSAGE_SIZE];
+static uint16_t     air_rx_len;
+static bool         air_rx_pending;
+static bool         air_rx_blocked;
+
+// packets to host are delivered from the run loop
+static uint8_t      to_host_queue[TO_HOST_QUEUE_SIZE];
+static uint16_t     to_host_pos;
+static uint16_t     to_host_len;
+static bool         packet_sent_pending;
+static uint8_t      to_host_packet[HCI_INCOMING_PRE_BUFFER_SIZE + HCI_ACL_HEADER_SIZE + VIRTUAL_CONTROLLER_MAX_ACL_PACKET_LENGTH];
+
+static void dummy_handler(uint8_t packet_type, uint8_t *packet, uint16_t size){
+    UNUSED(packet_type);
+    UNUSED(packet);
+    UNUSED(size);
+}
+
+uint64_t virtual_controller_time_us(void){
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t) now.tv_sec * 1000000u) + ((uint64_t) now.tv_nsec / 1000u);
+}
+
+const virtual_controller_statistics_t * virtual_controller_get_statistics(void){
+    return &virtual_controller_statistics;
+}
+
+// xorshift32
+static uint32_t virtual_controller_random(void){
+    uint32_t x = virtual_controller_random_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    virtual_controller_random_state = x;
+    return x;
+}
+
+static void virtual_controller_timer_start_at(btstack_timer_source_t * timer, uint64_t time_us){
+    uint64_t now = virtual_controller_time_us();
+    uint32_t timeout_ms = 0;
+    if (time_us > now){
+        timeout_ms = (uint32_t) ((time_us - now + 999u) / 1000u);
+    }
+    btstack_run_loop_remove_timer(timer);
+    btstack_run_loop_set_timer(timer, timeout_ms);
+    btstack_run_loop_add_timer(timer);
+}
+
+// packets to host
+
+static uint8_t * virtual_controller_to_host_reserve(uint8_t packet_type, uint16_t size){
+    uint16_t required = TO_HOST_HEADER_SIZE + size;
+    if ((to_host_len + required) > TO_HOST_QUEUE_SIZE){
+        memmove(to_host_queue, &to_host_queue[to_host_pos], to_host_len - to_host_pos);
+        to_host_len -= to_host_pos;
+        to_host_pos = 0;
+    }
+    if ((to_host_len + required) > TO_HOST_QUEUE_SIZE){
+        log_error("queue to host full, drop packet type %u, size %u", packet_type, size);
+        return NULL;
+    }
+    uint8_t * header = &to_host_queue[to_host_len];
+    header[0] = packet_type;
+    little_endian_store_16(header, 1, size);
+    to_host_len += required;
+    virtual_controller_timer_start_at(&to_host_timer, 0);
+    return &header[TO_HOST_HEADER_SIZE];
+}
+
+static bool virtual_controller_to_host_has_space(uint16_t size){
+    return ((to_host_len - to_host_pos) + TO_HOST_HEADER_SIZE + size) <= TO_HOST_QUEUE_SIZE;
+}
+
+static void virtual_controller_emit_event(const uint8_t * event, uint16_t size){
+    uint8_t * packet = virtual_controller_to_host_reserve(HCI_EVENT_PACKET, size);
+    if (packet == NULL) return;
+    (void) memcpy(packet, event, size);
+}
+
+static void virtual_controller_emit_command_complete(uint16_t opcode, const uint8_t * return_params, uint8_t return_params_len){
+    uint8_t event[260];
+    event[0] = HCI_EVENT_COMMAND_COMPLETE;
+    event[1] = 3 + return_params_len;
+    event[2] = 1;
+    little_endian_store_16(event, 3, opcode);
+    (void) memcpy(&event[5], return_params, return_params_len);
+    virtual_controller_emit_event(event, 5 + return_params_len);
+}
+
+static void virtual_controller_emit_command_status(uint16_t opcode, uint8_t status){
+    uint8_t event[6];
+    event[0] = HCI_EVENT_COMMAND_STATUS;
+    event[1] = 4;
+    event[2] = status;
+    event[3] = 1;
+    little_endian_store_16(event, 4, opcode);
+    virtual_controller_emit_event(event, sizeof(event));
+}
+
+static void virtual_controller_emit_connection_request(void){
+    uint8_t event[12];
+    memset(event, 0, sizeof(event));
+    event[0] = HCI_EVENT_CONNECTION_REQUEST;
+    event[1] = 10;
+    reverse_bd_addr(link_peer_addr, &event[2]);
+    // link type ACL
+    event[11] = 1;
+    virtual_controller_emit_event(event, sizeof(event));
+}
+
+static void virtual_controller_emit_connection_complete(uint8_t status){
+    uint8_t event[13];
+    memset(event, 0, sizeof(event));
+    event[0] = HCI_EVENT_CONNECTION_COMPLETE;
+    event[1] = 11;
+    event[2] = status;
+    little_endian_store_16(event, 3, VIRTUAL_CONTROLLER_CON_HANDLE);
+    reverse_bd_addr(link_peer_addr, &event[5]);
+    // link type ACL
+    event[11] = 1;
+    virtual_controller_emit_event(event, sizeof(event));
+}
+
+static void virtual_controller_emit_le_connection_complete(uint8_t status, uint8_t role){
+    uint8_t event[21];
+    memset(event, 0, sizeof(event));
+    event[0] = HCI_EVENT_LE_META;
+    event[1] = 19;
+    event[2] = HCI_SUBEVENT_LE_CONNECTION_COMPLETE;
+    event[3] = status;
+    little_endian_store_16(event, 4, VIRTUAL_CONTROLLER_CON_HANDLE);
+    event[6] = role;
+    event[7] = BD_ADDR_TYPE_LE_PUBLIC;
+    reverse_bd_addr(link_peer_addr, &event[8]);
+    // connection interval 7.5 ms, no slave latency, supervision timeout 5 s
+    little_endian_store_16(event, 14, 6);
+    little_endian_store_16(event, 16, 0);
+    little_endian_store_16(event, 18, 500);
+    virtual_controller_emit_event(event, sizeof(event));
+}
+
+static void virtual_controller_emit_disconnection_complete(uint8_t reason){
+    uint8_t event[6];
+    event[0] = HCI_EVENT_DISCONNECTION_COMPLETE;
+    event[1] = 4;
+    event[2] = ERROR_CODE_SUCCESS;
+    little_endian_store_16(event, 3, VIRTUAL_CONTROLLER_CON_HANDLE);
+    event[5] = reason;
+    virtual_controller_emit_event(event, sizeof(event));
+}
+
+static void virtual_controller_emit_number_of_completed_packets(uint16_t num_packets){
+    uint8_t event[7];
+    event[0] = HCI_EVENT_NUMBER_OF_COMPLETED_PACKETS;
+    event[1] = 5;
+    event[2] = 1;
+    little_endian_store_16(event, 3, VIRTUAL_CONTROLLER_CON_HANDLE);
+    little_endian_store_16(event, 5, num_packets);
+    virtual_controller_emit_event(event, sizeof(event));
+}
+
+static void virtual_controller_to_host_process(btstack_timer_source_t * ts){
+    UNUSED(ts);
+    while (to_host_pos < to_host_len){
+        uint8_t  packet_type = to_host_queue[to_host_pos];
+        uint16_t size = little_endian_read_16(to_host_queue, to_host_pos + 1);
+        uint8_t * packet = &to_host_packet[HCI_INCOMING_PRE_BUFFER_SIZE];
+        (void) memcpy(packet, &to_host_queue[to_host_pos + TO_HOST_HEADER_SIZE], size);
+        to_host_pos += TO_HOST_HEADER_SIZE + size;
+        if (to_host_pos == to_host_len){
+            to_host_pos = 0;
+            to_host_len = 0;
+        }
+        if ((packet_type == HCI_EVENT_PACKET) && (packet[0] == HCI_EVENT_TRANSPORT_PACKET_SENT)){
+            packet_sent_pending = false;
+        }
+        // may queue further packets
+        (*packet_handler)(packet_type, packet, size);
+    }
+    if (air_rx_blocked){
+        air_rx_blocked = false;
+        btstack_run_loop_enable_data_source_callbacks(&air_data_source, DATA_SOURCE_CALLBACK_READ);
+    }
+}
+
+// air
+
+static void virtual_controller_air_send(uint8_t message_type, uint64_t deliver_at_us, const uint8_t * params, uint16_t params_len,
+                                        const uint8_t * data, uint16_t data_len){
+    uint8_t header[AIR_HEADER_SIZE];
+    header[0] = message_type;
+    little_endian_store_32(header, 1, (uint32_t) deliver_at_us);
+    little_endian_store_32(header, 5, (uint32_t) (deliver_at_us >> 32));
+    struct iovec iov[3];
+    iov[0].iov_base = header;
+    iov[0].iov_len  = sizeof(header);
+    iov[1].iov_base = (void *) params;
+    iov[1].iov_len  = params_len;
+    iov[2].iov_base = (void *) data;
+    iov[2].iov_len  = data_len;
+    ssize_t res = writev(virtual_controller_config->air_fd, iov, 3);
+    if (res < 0){
+        log_error("air send failed, errno %d", errno);
+    }
+}
+
+static void virtual_controller_air_send_control(uint8_t message_type, const uint8_t * params, uint16_t params_len){
+    uint64_t deliver_at_us = virtual_controller_time_us() + ((uint64_t) virtual_controller_config->latency_ms * 1000u);
+    virtual_controller_air_send(message_type, deliver_at_us, params, params_len, NULL, 0);
+}
+
+static void virtual_controller_link_reset(void){
+    link_state = LINK_IDLE;
+    acl_buffers_head  = 0;
+    acl_buffers_count = 0;
+    btstack_run_loop_remove_timer(&air_tx_timer);
+}
+
+static void virtual_controller_process_pending_request(void){
+    if (link_state != LINK_IDLE) return;
+    uint8_t response[8];
+    switch (pending_request){
+        case AIR_CONNECT_REQUEST:
+            if (!page_scan_enabled) return;
+            pending_request = 0;
+            bd_addr_copy(link_peer_addr, pending_request_addr);
+            link_is_le = false;
+            link_state = LINK_W4_ACCEPT;
+            virtual_controller_emit_connection_request();
+            break;
+        case AIR_LE_CONNECT_REQUEST:
+            if (!advertising_enabled) return;
+            pending_request = 0;
+            bd_addr_copy(link_peer_addr, pending_request_addr);
+            link_is_le = true;
+            link_state = LINK_CONNECTED;
+            advertising_enabled = false;
+            virtual_controller_emit_le_connection_complete(ERROR_CODE_SUCCESS, HCI_ROLE_SLAVE);
+            response[0] = ERROR_CODE_SUCCESS;
+            response[1] = BD_ADDR_TYPE_LE_PUBLIC;
+            reverse_bd_addr(virtual_controller_config->bd_addr, &response[2]);
+            virtual_controller_air_send_control(AIR_LE_CONNECT_RESPONSE, response, sizeof(response));
+            break;
+        default:
+            break;
+    }
+}
+
+static void virtual_controller_handle_air_acl(const uint8_t * payload, uint16_t payload_len){
+    if (link_state != LINK_CONNECTED) return;
+    if (payload_len < 1) return;
+    uint16_t data_len = payload_len - 1;
+    uint8_t * packet = virtual_controller_to_host_reserve(HCI_ACL_DATA_PACKET, HCI_ACL_HEADER_SIZE + data_len);
+    if (packet == NULL) return;
+    // deliver first non-flushable packets from LE hosts as first automatically flushable
+    uint8_t flags = payload[0];
+    uint8_t packet_boundary = flags & 0x03u;
+    if (packet_boundary == 0u){
+        packet_boundary = 0x02;
+    }
+    uint16_t handle_and_flags = VIRTUAL_CONTROLLER_CON_HANDLE | (packet_boundary << 12) | ((flags & 0x0cu) << 12);
+    little_endian_store_16(packet, 0, handle_and_flags);
+    little_endian_store_16(packet, 2, data_len);
+    (void) memcpy(&packet[HCI_ACL_HEADER_SIZE], &payload[1], data_len);
+    virtual_controller_statistics.acl_packets_received++;
+}
+
+static void virtual_controller_handle_air_message(void){
+    uint8_t message_type = air_rx_message[0];
+    const uint8_t * payload = &air_rx_message[AIR_HEADER_SIZE];
+    uint16_t payload_len = air_rx_len - AIR_HEADER_SIZE;
+    switch (message_type){
+        case AIR_CONNECT_REQUEST:
+            if (payload_len < 6) break;
+            pending_request = AIR_CONNECT_REQUEST;
+            reverse_bd_addr(payload, pending_request_addr);
+            virtual_controller_process_pending_request();
+            break;
+        case AIR_LE_CONNECT_REQUEST:
+            if (payload_len < 7) break;
+            pending_request = AIR_LE_CONNECT_REQUEST;
+            reverse_bd_addr(&payload[1], pending_request_addr);
+            virtual_controller_process_pending_request();
+            break;
+        case AIR_LE_CONNECT_CANCEL:
+            if (pending_request == AIR_LE_CONNECT_REQUEST){
+                pending_request = 0;
+            }
+            break;
+        case AIR_CONNECT_RESPONSE:
+            if (payload_len < 1) break;
+            if ((link_state != LINK_W4_CONNECT_RESPONSE) || link_is_le) break;
+            link_state = (payload[0] == ERROR_CODE_SUCCESS) ? LINK_CONNECTED : LINK_IDLE;
+            virtual_controller_emit_connection_complete(payload[0]);
+            break;
+        case AIR_LE_CONNECT_RESPONSE:
+            if (payload_len < 1) break;
+            if ((link_state != LINK_W4_CONNECT_RESPONSE) || !link_is_le) break;
+            link_state = (payload[0] == ERROR_CODE_SUCCESS) ? LINK_CONNECTED : LINK_IDLE;
+            virtual_controller_emit_le_connection_complete(payload[0], HCI_ROLE_MASTER);
+            break;
+        case AIR_ACL:
+            virtual_controller_handle_air_acl(payload, payload_len);
+            break;
+        case AIR_DISCONNECT:
+            if (payload_len < 1) break;
+            if (link_state != LINK_CONNECTED) break;
+            virtual_controller_link_reset();
+            virtual_controller_emit_disconnection_complete(payload[0]);
+            virtual_controller_process_pending_request();
+            break;
+        default:
+            log_error("unknown air message type %u", message_type);
+            break;
+    }
+}
+
+static void virtual_controller_handle_peer_closed(void){
+    log_info("peer controller closed air socket");
+    btstack_run_loop_remove_data_source(&air_data_source);
+    switch (link_state){
+        case LINK_CONNECTED:
+            virtual_controller_link_reset();
+            virtual_controller_emit_disconnection_complete(ERROR_CODE_CONNECTION_TIMEOUT);
+            break;
+        case LINK_W4_CONNECT_RESPONSE:
+            virtual_controller_link_reset();
+            if (link_is_le){
+                virtual_controller_emit_le_connection_complete(ERROR_CODE_CONNECTION_FAILED_TO_BE_ESTABLISHED, HCI_ROLE_MASTER);
+            } else {
+                virtual_controller_emit_connection_complete(ERROR_CODE_PAGE_TIMEOUT);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+static void virtual_controller_air_receive(void){
+    uint16_t num_messages;
+    for (num_messages = 0; num_messages < AIR_RX_BATCH_SIZE; num_messages++){
+        if (!air_rx_pending){
+            ssize_t bytes_read = recv(virtual_controller_config->air_fd, air_rx_message, sizeof(air_rx_message), MSG_DONTWAIT);
+            if (bytes_read < 0){
+                if ((errno != EAGAIN) && (errno != EWOULDBLOCK)){
+                    log_error("air receive failed, errno %d", errno);
+                }
+                return;
+            }
+            if (bytes_read == 0){
+                virtual_controller_handle_peer_closed();
+                return;
+            }
+            if (bytes_read < AIR_HEADER_SIZE) continue;
+            air_rx_len = (uint16_t) bytes_read;
+            air_rx_pending = true;
+        }
+
+        // keep message until it is due and host can take it
+        uint64_t deliver_at_us = ((uint64_t) little_endian_read_32(air_rx_message, 5) << 32) | little_endian_read_32(air_rx_message, 1);
+        if (deliver_at_us > virtual_controller_time_us()){
+            btstack_run_loop_disable_data_source_callbacks(&air_data_source, DATA_SOURCE_CALLBACK_READ);
+            virtual_controller_timer_start_at(&air_rx_timer, deliver_at_us);
+            return;
+        }
+        if (!virtual_controller_to_host_has_space(HCI_ACL_HEADER_SIZE + air_rx_len)){
+            btstack_run_loop_disable_data_source_callbacks(&air_data_source, DATA_SOURCE_CALLBACK_READ);
+            air_rx_blocked = true;
+            return;
+        }
+        air_rx_pending = false;
+        virtual_controller_handle_air_message();
+    }
+}
+
+static void virtual_controller_air_process(btstack_data_source_t * ds, btstack_data_source_callback_type_t callback_type){
+    UNUSED(ds);
+    if (callback_type != DATA_SOURCE_CALLBACK_READ) return;
+    virtual_controller_air_receive();
+}
+
+static void virtual_controller_air_rx_timeout(btstack_timer_source_t * ts){
+    UNUSED(ts);
+    btstack_run_loop_enable_data_source_callbacks(&air_data_source, DATA_SOURCE_CALLBACK_READ);
+    virtual_controller_air_receive();
+}
+
+// ACL packets are sent over the air when their transmission is complete
+static void virtual_controller_air_tx_process(btstack_timer_source_t * ts){
+    UNUSED(ts);
+    uint64_t now = virtual_controller_time_us();
+    uint64_t latency_us = (uint64_t) virtual_controller_config->latency_ms * 1000u;
+    uint16_t num_completed = 0;
+    while (acl_buffers_count > 0u){
+        acl_buffer_t * acl_buffer = &acl_buffers[acl_buffers_head];
+        if (acl_buffer->tx_done_us > now) break;
+        uint8_t flags = acl_buffer->packet[1] >> 4;
+        uint16_t data_len = acl_buffer->size - HCI_ACL_HEADER_SIZE;
+        virtual_controller_air_send(AIR_ACL, acl_buffer->tx_done_us + latency_us, &flags, 1, &acl_buffer->packet[HCI_ACL_HEADER_SIZE], data_len);
+        virtual_controller_statistics.acl_packets_sent++;
+        virtual_controller_statistics.acl_bytes_sent += data_len;
+        acl_buffers_head = (acl_buffers_head + 1u) % VIRTUAL_CONTROLLER_MAX_ACL_BUFFERS;
+        acl_buffers_count--;
+        num_completed++;
+    }
+    if (num_completed > 0u){
+        virtual_controller_emit_number_of_completed_packets(num_completed);
+    }
+    if (acl_buffers_count > 0u){
+        virtual_controller_timer_start_at(&air_tx_timer, acl_buffers[acl_buffers_head].tx_done_us);
+    }
+}
+
+static void virtual_controller_handle_acl_packet(const uint8_t * packet, uint16_t size){
+    if (link_state != LINK_CONNECTED){
+        log_info("drop ACL packet, not connected");
+        return;
+    }
+    uint8_t num_buffers = link_is_le ? virtual_controller_config->num_le_acl_packets : virtual_controller_config->num_acl_packets;
+    num_buffers = btstack_min(num_buffers, VIRTUAL_CONTROLLER_MAX_ACL_BUFFERS);
+    if ((acl_buffers_count >= num_buffers) || (size > sizeof(acl_buffers[0].packet))){
+        log_error("ACL buffer overrun, drop packet of size %u", size);
+        return;
+    }
+
+    // transmission starts when previous packet is sent, failed attempts are repeated
+    uint64_t tx_start_us = virtual_controller_time_us();
+    if (air_busy_until_us > tx_start_us){
+        tx_start_us = air_busy_until_us;
+    }
+    uint64_t air_time_us = 0;
+    if (virtual_controller_config->bandwidth > 0u){
+        air_time_us = ((uint64_t) (size - HCI_ACL_HEADER_SIZE) * 1000000u) / virtual_controller_config->bandwidth;
+    }
+    uint32_t loss_percent = btstack_min(virtual_controller_config->loss_percent, MAX_LOSS_PERCENT);
+    while ((virtual_controller_random() % 100u) < loss_percent){
+        tx_start_us += air_time_us + ((uint64_t) virtual_controller_config->retransmission_delay_ms * 1000u);
+        virtual_controller_statistics.retransmissions++;
+    }
+    air_busy_until_us = tx_start_us + air_time_us;
+
+    uint16_t index = (acl_buffers_head + acl_buffers_count) % VIRTUAL_CONTROLLER_MAX_ACL_BUFFERS;
+    acl_buffer_t * acl_buffer = &acl_buffers[index];
+    acl_buffer->tx_done_us = air_busy_until_us;
+    acl_buffer->size = size;
+    (void) memcpy(acl_buffer->packet, packet, size);
+    acl_buffers_count++;
+    if (acl_buffers_count == 1u){
+        virtual_controller_timer_start_at(&air_tx_timer, acl_buffer->tx_done_us);
+    }
+}
+
+// HCI commands
+
+static void virtual_controller_reset(void){
+    virtual_controller_link_reset();
+    page_scan_enabled = false;
+    advertising_enabled = false;
+    pending_request = 0;
+    air_busy_until_us = 0;
+}
+
+static void virtual_controller_handle_create_connection(uint16_t opcode, const uint8_t * params){
+    if (link_state != LINK_IDLE){
+        virtual_controller_emit_command_status(opcode, ERROR_CODE_COMMAND_DISALLOWED);
+        return;
+    }
+    virtual_controller_emit_command_status(opcode, ERROR_CODE_SUCCESS);
+    uint8_t request[7];
+    link_state = LINK_W4_CONNECT_RESPONSE;
+    if (opcode == HCI_OPCODE_HCI_LE_CREATE_CONNECTION){
+        // scan interval, scan window, filter policy, peer address type, peer address
+        link_is_le = true;
+        reverse_bd_addr(&params[6], link_peer_addr);
+        request[0] = BD_ADDR_TYPE_LE_PUBLIC;
+        reverse_bd_addr(virtual_controller_config->bd_addr, &request[1]);
+        virtual_controller_air_send_control(AIR_LE_CONNECT_REQUEST, request, 7);
+    } else {
+        link_is_le = false;
+        reverse_bd_addr(params, link_peer_addr);
+        reverse_bd_addr(virtual_controller_config->bd_addr, request);
+        virtual_controller_air_send_control(AIR_CONNECT_REQUEST, request, 6);
+    }
+}
+
+static void virtual_controller_handle_connection_response(uint16_t opcode, const uint8_t * params){
+    if (link_state != LINK_W4_ACCEPT){
+        virtual_controller_emit_command_status(opcode, ERROR_CODE_COMMAND_DISALLOWED);
+        return;
+    }
+    virtual_controller_emit_command_status(opcode, ERROR_CODE_SUCCESS);
+    uint8_t status = ERROR_CODE_SUCCESS;
+    if (opcode == HCI_OPCODE_HCI_REJECT_CONNECTION_REQUEST){
+        status = params[6];
+    }
+    link_state = (status == ERROR_CODE_SUCCESS) ? LINK_CONNECTED : LINK_IDLE;
+    virtual_controller_emit_connection_complete(status);
+    virtual_controller_air_send_control(AIR_CONNECT_RESPONSE, &status, 1);
+}
+
+static void virtual_controller_handle_disconnect(uint16_t opcode, const uint8_t * params){
+    if ((link_state != LINK_CONNECTED) || (little_endian_read_16(params, 0) != VIRTUAL_CONTROLLER_CON_HANDLE)){
+        virtual_controller_emit_command_status(opcode, ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER);
+        return;
+    }
+    virtual_controller_emit_command_status(opcode, ERROR_CODE_SUCCESS);
+    virtual_controller_link_reset();
+    virtual_controller_emit_disconnection_complete(ERROR_CODE_CONNECTION_TERMINATED_BY_LOCAL_HOST);
+    virtual_controller_air_send_control(AIR_DISCONNECT, &params[2], 1);
+}
+
+static void virtual_controller_handle_read_remote_info(uint16_t opcode){
+    if (link_state != LINK_CONNECTED){
+        virtual_controller_emit_command_status(opcode, ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER);
+        return;
+    }
+    virtual_controller_emit_command_status(opcode, ERROR_CODE_SUCCESS);
+    // peer is another virtual controller
+    uint8_t event[14];
+    uint16_t pos = 0;
+    switch (opcode){
+        case HCI_OPCODE_HCI_READ_REMOTE_SUPPORTED_FEATURES_COMMAND:
+            event[pos++] = HCI_EVENT_READ_REMOTE_SUPPORTED_FEATURES_COMPLETE;
+            event[pos++] = 11;
+            break;
+        case HCI_OPCODE_HCI_LE_READ_REMOTE_USED_FEATURES:
+            event[pos++] = HCI_EVENT_LE_META;
+            event[pos++] = 12;
+            event[pos++] = HCI_SUBEVENT_LE_READ_REMOTE_USED_FEATURES_COMPLETE;
+            break;
+        default:
+            // HCI Version 5.0
+            event[pos++] = HCI_EVENT_READ_REMOTE_VERSION_INFORMATION_COMPLETE;
+            event[pos++] = 8;
+            event[pos++] = ERROR_CODE_SUCCESS;
+            little_endian_store_16(event, pos, VIRTUAL_CONTROLLER_CON_HANDLE);
+            pos += 2;
+            event[pos++] = 0x09;
+            little_endian_store_16(event, pos, BLUETOOTH_COMPANY_ID_BLUEKITCHEN_GMBH);
+            pos += 2;
+            little_endian_store_16(event, pos, 0);
+            pos += 2;
+            virtual_controller_emit_event(event, pos);
+            return;
+    }
+    event[pos++] = ERROR_CODE_SUCCESS;
+    little_endian_store_16(event, pos, VIRTUAL_CONTROLLER_CON_HANDLE);
+    pos += 2;
+    (void) memcpy(&event[pos], virtual_controller_features, sizeof(virtual_controller_features));
+    pos += sizeof(virtual_controller_features);
+    virtual_controller_emit_event(event, pos);
+}
+
+static void virtual_controller_handle_command(const uint8_t * packet, uint16_t size){
+    if (size < 3) return;
+    uint16_t opcode = little_endian_read_16(packet, 0);
+    const uint8_t * params = &packet[3];
+
+    uint8_t return_params[255];
+    uint8_t return_params_len = 1;
+    memset(return_params, 0, sizeof(return_params));
+    return_params[0] = ERROR_CODE_SUCCESS;
+
+    uint8_t i;
+    switch (opcode){
+        case HCI_OPCODE_HCI_RESET:
+            virtual_controller_reset();
+            break;
+        case HCI_OPCODE_HCI_READ_LOCAL_VERSION_INFORMATION:
+            // HCI/LMP Version 5.0
+            return_params[1] = 0x09;
+            return_params[4] = 0x09;
+            little_endian_store_16(return_params, 5, BLUETOOTH_COMPANY_ID_BLUEKITCHEN_GMBH);
+            return_params_len = 9;
+            break;
+        case HCI_OPCODE_HCI_READ_LOCAL_NAME:
+            return_params_len = 249;
+            break;
+        case HCI_OPCODE_HCI_READ_LOCAL_SUPPORTED_COMMANDS:
+            // Octet 14, bit 7 / Read Buffer Size
+            return_params[1 + 14] = 0x80;
+            return_params_len = 65;
+            break;
+        case HCI_OPCODE_HCI_READ_BD_ADDR:
+            reverse_bd_addr(virtual_controller_config->bd_addr, &return_params[1]);
+            return_params_len = 7;
+            break;
+        case HCI_OPCODE_HCI_READ_BUFFER_SIZE:
+            little_endian_store_16(return_params, 1, virtual_controller_config->acl_packet_length);
+            little_endian_store_16(return_params, 4, virtual_controller_config->num_acl_packets);
+            return_params_len = 8;
+            break;
+        case HCI_OPCODE_HCI_READ_LOCAL_SUPPORTED_FEATURES:
+            (void) memcpy(&return_params[1], virtual_controller_features, sizeof(virtual_controller_features));
+            return_params_len = 9;
+            break;
+        case HCI_OPCODE_HCI_LE_READ_BUFFER_SIZE:
+            little_endian_store_16(return_params, 1, virtual_controller_config->le_acl_packet_length);
+            return_params[3] = virtual_controller_config->num_le_acl_packets;
+            return_params_len = 4;
+            break;
+        case HCI_OPCODE_HCI_LE_READ_WHITE_LIST_SIZE:
+            return_params_len = 2;
+            break;
+        case HCI_OPCODE_HCI_LE_RAND:
+            for (i = 0; i < 8u; i++){
+                return_params[1u + i] = (uint8_t) virtual_controller_random();
+            }
+            return_params_len = 9;
+            break;
+        case HCI_OPCODE_HCI_WRITE_SCAN_ENABLE:
+            page_scan_enabled = (params[0] & 0x02u) != 0u;
+            virtual_controller_emit_command_complete(opcode, return_params, return_params_len);
+            virtual_controller_process_pending_request();
+            return;
+        case HCI_OPCODE_HCI_LE_SET_ADVERTISE_ENABLE:
+            advertising_enabled = params[0] != 0u;
+            virtual_controller_emit_command_complete(opcode, return_params, return_params_len);
+            virtual_controller_process_pending_request();
+            return;
+        case HCI_OPCODE_HCI_LE_CREATE_CONNECTION_CANCEL:
+            if ((link_state != LINK_W4_CONNECT_RESPONSE) || !link_is_le){
+                return_params[0] = ERROR_CODE_COMMAND_DISALLOWED;
+                break;
+            }
+            virtual_controller_emit_command_complete(opcode, return_params, return_params_len);
+            link_state = LINK_IDLE;
+            virtual_controller_air_send_control(AIR_LE_CONNECT_CANCEL, NULL, 0);
+            virtual_controller_emit_le_connection_complete(ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER, HCI_ROLE_MASTER);
+            return;
+        case HCI_OPCODE_HCI_CREATE_CONNECTION:
+        case HCI_OPCODE_HCI_LE_CREATE_CONNECTION:
+            virtual_controller_handle_create_connection(opcode, params);
+            return;
+        case HCI_OPCODE_HCI_ACCEPT_CONNECTION_REQUEST:
+        case HCI_OPCODE_HCI_REJECT_CONNECTION_REQUEST:
+            virtual_controller_handle_connection_response(opcode, params);
+            return;
+        case HCI_OPCODE_HCI_DISCONNECT:
+            virtual_controller_handle_disconnect(opcode, params);
+            return;
+        case HCI_OPCODE_HCI_READ_REMOTE_SUPPORTED_FEATURES_COMMAND:
+        case HCI_OPCODE_HCI_READ_REMOTE_VERSION_INFORMATION:
+        case HCI_OPCODE_HCI_LE_READ_REMOTE_USED_FEATURES:
+            virtual_controller_handle_read_remote_info(opcode);
+            return;
+        default:
+            // other link control commands would complete with an event
+            if ((opcode >> 10) == OGF_LINK_CONTROL){
+                virtual_controller_emit_command_status(opcode, ERROR_CODE_UNKNOWN_HCI_COMMAND);
+                return;
+            }
+            break;
+    }
+    virtual_controller_emit_command_complete(opcode, return_params, return_params_len);
+}
+
+// HCI Transport
+
+static void virtual_controller_init(const void * transport_config){
+    virtual_controller_config = (const virtual_controller_config_t *) transport_config;
+    virtual_controller_random_state = virtual_controller_config->random_seed;
+    if (virtual_controller_random_state == 0u){
+        virtual_controller_random_state = 1;
+    }
+    memset(&virtual_controller_statistics, 0, sizeof(virtual_controller_statistics));
+}
+
+static int virtual_controller_open(void){
+    virtual_controller_reset();
+    air_rx_pending = false;
+    air_rx_blocked = false;
+    to_host_pos = 0;
+    to_host_len = 0;
+    packet_sent_pending = false;
+    btstack_run_loop_set_timer_handler(&air_rx_timer, &virtual_controller_air_rx_timeout);
+    btstack_run_loop_set_timer_handler(&air_tx_timer, &virtual_controller_air_tx_process);
+    btstack_run_loop_set_timer_handler(&to_host_timer, &virtual_controller_to_host_process);
+    btstack_run_loop_set_data_source_fd(&air_data_source, virtual_controller_config->air_fd);
+    btstack_run_loop_set_data_source_handler(&air_data_source, &virtual_controller_air_process);
+    btstack_run_loop_enable_data_source_callbacks(&air_data_source, DATA_SOURCE_CALLBACK_READ);
+    btstack_run_loop_add_data_source(&air_data_source);
+    return 0;
+}
+
+static int virtual_controller_close(void){
+    btstack_run_loop_remove_data_source(&air_data_source);
+    btstack_run_loop_remove_timer(&air_rx_timer);
+    btstack_run_loop_remove_timer(&air_tx_timer);
+    btstack_run_loop_remove_timer(&to_host_timer);
+    return 0;
+}
+
+static void virtual_controller_register_packet_handler(void (*handler)(uint8_t packet_type, uint8_t *packet, uint16_t size)){
+    packet_handler = handler;
+}
+
+static int virtual_controller_can_send_packet_now(uint8_t packet_type){
+    UNUSED(packet_type);
+    return packet_sent_pending ? 0 : 1;
+}
+
+static int virtual_controller_send_packet(uint8_t packet_type, uint8_t * packet, int size){
+    // asynchronous transport: report packet sent before any response to it
+    static const uint8_t packet_sent_event[] = { HCI_EVENT_TRANSPORT_PACKET_SENT, 0};
+    packet_sent_pending = true;
+    virtual_controller_emit_event(packet_sent_event, sizeof(packet_sent_event));
+    switch (packet_type){
+        case HCI_COMMAND_DATA_PACKET:
+            virtual_controller_handle_command(packet, (uint16_t) size);
+            break;
+        case HCI_ACL_DATA_PACKET:
+            virtual_controller_handle_acl_packet(packet, (uint16_t) size);
+            break;
+        default:
+            break;
+    }
+    return 0;
+}
+
+static const hci_transport_t virtual_controller_transport = {
+    /* .transport.name                          = */  "VIRTUAL",
+    /* .transport.init                          = */  &virtual_controller_init,
+    /* .transport.open                          = */  &virtual_controller_open,
+    /* .transport.close                         = */  &virtual_controller_close,
+    /* .transport.register_packet_handler       = */  &virtual_controller_register_packet_handler,
+    /* .transport.can_send_packet_now           = */  &virtual_controller_can_send_packet_now,
+    /* .transport.send_packet                   = */  &virtual_controller_send_packet,
+    /* .transport.set_baudrate                  = */  NULL,
+    /* .transport.reset_link                    = */  NULL,
+    /* .transport.set_sco_config                = */  NULL,
+};
+
+const hci_transport_t * virtual_controller_instance(void){
+    return &virtual_controller_transport;
+}
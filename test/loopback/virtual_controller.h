@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2019 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+/*
+ *  virtual_controller.h
+ *
+ *  Software HCI Controller implemented as HCI Transport
+ *
+ *  Two virtual Controllers exchange link layer messages over a connected SOCK_SEQPACKET socket
+ *  (the 'air'), e.g. created with socketpair() before forking two BTstack processes. It implements
+ *  the HCI commands used during HCI init, LE advertising and connection setup, Classic page scan
+ *  and connection setup, disconnect, and ACL data flow control with Number Of Completed Packets.
+ *
+ *  The link is modeled by bandwidth, one-way latency and packet loss: ACL packets occupy a
+ *  Controller buffer until they have been sent over the air, a lost transmission is repeated after
+ *  the retransmission delay. Connection requests to a peer that is not connectable yet stay pending.
+ *  Only a single connection is supported.
+ */
+
+#ifndef VIRTUAL_CONTROLLER_H
+#define VIRTUAL_CONTROLLER_H
+
+#include <stdint.h>
+
+#include "bluetooth.h"
+#include "hci_transport.h"
+
+#if defined __cplusplus
+extern "C" {
+#endif
+
+#define VIRTUAL_CONTROLLER_MAX_ACL_PACKET_LENGTH 1021
+#define VIRTUAL_CONTROLLER_MAX_ACL_BUFFERS       16
+#define VIRTUAL_CONTROLLER_CON_HANDLE            0x0040
+
+typedef struct {
+    // connected SOCK_SEQPACKET socket to peer Controller
+    int       air_fd;
+    bd_addr_t bd_addr;
+    // Controller buffers for Classic and LE
+    uint16_t  acl_packet_length;
+    uint8_t   num_acl_packets;
+    uint16_t  le_acl_packet_length;
+    uint8_t   num_le_acl_packets;
+    // link model: ACL payload bytes per second (0 = unlimited), one-way latency
+    uint32_t  bandwidth;
+    uint16_t  latency_ms;
+    // probability that a transmission fails, max 90%, and delay until it is repeated
+    uint8_t   loss_percent;
+    uint16_t  retransmission_delay_ms;
+    uint32_t  random_seed;
+} virtual_controller_config_t;
+
+typedef struct {
+    uint32_t acl_packets_sent;
+    uint32_t acl_bytes_sent;
+    uint32_t acl_packets_received;
+    uint32_t retransmissions;
+} virtual_controller_statistics_t;
+
+/**
+ * @brief Get HCI Transport for virtual Controller, use virtual_controller_config_t as transport config in hci_init
+ * @return hci_transport
+ */
+const hci_transport_t * virtual_controller_instance(void);
+
+/**
+ * @brief Get link statistics
+ * @return statistics
+ */
+const virtual_controller_statistics_t * virtual_controller_get_statistics(void);
+
+/**
+ * @brief Get current time of the monotonic clock shared by all processes on the host
+ * @return time in us
+ */
+uint64_t virtual_controller_time_us(void);
+
+#if defined __cplusplus
+}
+#endif
+
+#endif // VIRTUAL_CONTROLLER_H
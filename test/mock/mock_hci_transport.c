@@ -0,0 +1,293 @@
+/*
+ * Copyright (C) 2019 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+#define BTSTACK_FILE__ "mock_hci_transport.c"
+
+/*
+ *  mock_hci_transport.c
+ */
+
+#include "mock_hci_transport.h"
+
+#include <string.h>
+
+#include "btstack_debug.h"
+#include "btstack_util.h"
+#include "hci.h"
+#include "hci_cmd.h"
+#include "l2cap.h"
+
+#define MOCK_HCI_TRANSPORT_ACL_PACKET_LENGTH 1021
+#define MOCK_HCI_TRANSPORT_NUM_ACL_PACKETS   8
+
+static void (*mock_packet_handler)(uint8_t packet_type, uint8_t *packet, uint16_t size);
+
+static uint8_t  mock_events[4000];
+static uint16_t mock_events_len;
+
+static uint8_t  mock_l2cap_packets[MOCK_HCI_TRANSPORT_MAX_PACKETS][MOCK_HCI_TRANSPORT_MAX_PACKET_SIZE];
+static uint16_t mock_l2cap_packet_lens[MOCK_HCI_TRANSPORT_MAX_PACKETS];
+static uint16_t mock_num_l2cap_packets;
+
+static int mock_complete_acl_packets;
+
+static void mock_hci_transport_queue_event(const uint8_t * event, uint16_t size){
+    btstack_assert((mock_events_len + size) <= sizeof(mock_events));
+    (void)memcpy(&mock_events[mock_events_len], event, size);
+    mock_events_len += size;
+}
+
+static uint8_t mock_hci_transport_return_parameters_len(uint16_t opcode){
+    switch (opcode){
+        case HCI_OPCODE_HCI_READ_LOCAL_VERSION_INFORMATION:
+            return 9;
+        case HCI_OPCODE_HCI_READ_LOCAL_NAME:
+            return 249;
+        case HCI_OPCODE_HCI_READ_LOCAL_SUPPORTED_COMMANDS:
+            return 65;
+        case HCI_OPCODE_HCI_READ_BD_ADDR:
+            return 7;
+        case HCI_OPCODE_HCI_READ_BUFFER_SIZE:
+            return 8;
+        case HCI_OPCODE_HCI_READ_LOCAL_SUPPORTED_FEATURES:
+            return 9;
+        case HCI_OPCODE_HCI_LE_READ_BUFFER_SIZE:
+            return 4;
+        case HCI_OPCODE_HCI_LE_READ_WHITE_LIST_SIZE:
+            return 2;
+        default:
+            return 1;
+    }
+}
+
+static void mock_hci_transport_handle_command(const uint8_t * packet){
+    uint16_t opcode = little_endian_read_16(packet, 0);
+    uint8_t params_len = mock_hci_transport_return_parameters_len(opcode);
+    uint8_t event[260];
+    memset(event, 0, sizeof(event));
+    event[0] = HCI_EVENT_COMMAND_COMPLETE;
+    event[1] = 3 + params_len;
+    event[2] = 1;
+    little_endian_store_16(event, 3, opcode);
+    switch (opcode){
+        case HCI_OPCODE_HCI_READ_LOCAL_SUPPORTED_COMMANDS:
+            // Octet 14, bit 7: Read Buffer Size
+            event[6 + 14] = 0x80;
+            break;
+        case HCI_OPCODE_HCI_READ_LOCAL_SUPPORTED_FEATURES:
+            // LE Supported (Controller), BR/EDR supported
+            event[5 + 1 + 4] = 0x40;
+            break;
+        case HCI_OPCODE_HCI_READ_BUFFER_SIZE:
+            little_endian_store_16(event, 6, MOCK_HCI_TRANSPORT_ACL_PACKET_LENGTH);
+            little_endian_store_16(event, 9, MOCK_HCI_TRANSPORT_NUM_ACL_PACKETS);
+            break;
+        default:
+            break;
+    }
+    mock_hci_transport_queue_event(event, 5 + params_len);
+}
+
+static void mock_hci_transport_handle_acl(const uint8_t * packet, int size){
+    btstack_assert(size <= (MOCK_HCI_TRANSPORT_MAX_PACKET_SIZE + 4));
+    btstack_assert(mock_num_l2cap_packets < MOCK_HCI_TRANSPORT_MAX_PACKETS);
+    // store without ACL header
+    (void)memcpy(mock_l2cap_packets[mock_num_l2cap_packets], &packet[4], size - 4);
+    mock_l2cap_packet_lens[mock_num_l2cap_packets] = size - 4;
+    mock_num_l2cap_packets++;
+
+    if (mock_complete_acl_packets == 0) return;
+    mock_hci_transport_queue_number_of_completed_packets(little_endian_read_16(packet, 0) & 0x0fff, 1);
+}
+
+static void mock_hci_transport_init(const void * transport_config){
+    UNUSED(transport_config);
+}
+
+static int mock_hci_transport_open(void){
+    return 0;
+}
+
+static int mock_hci_transport_close(void){
+    return 0;
+}
+
+static void mock_hci_transport_register_packet_handler(void (*handler)(uint8_t packet_type, uint8_t *packet, uint16_t size)){
+    mock_packet_handler = handler;
+}
+
+static int mock_hci_transport_can_send_packet_now(uint8_t packet_type){
+    UNUSED(packet_type);
+    return 1;
+}
+
+static int mock_hci_transport_send_packet(uint8_t packet_type, uint8_t *packet, int size){
+    // packet sent event before controller response, as with H4 transport
+    const uint8_t packet_sent[] = { HCI_EVENT_TRANSPORT_PACKET_SENT, 0};
+    mock_hci_transport_queue_event(packet_sent, sizeof(packet_sent));
+    switch (packet_type){
+        case HCI_COMMAND_DATA_PACKET:
+            mock_hci_transport_handle_command(packet);
+            break;
+        case HCI_ACL_DATA_PACKET:
+            mock_hci_transport_handle_acl(packet, size);
+            break;
+        default:
+            break;
+    }
+    return 0;
+}
+
+// asynchronous transport: HCI_EVENT_TRANSPORT_PACKET_SENT is emitted from mock_hci_transport_process
+static const hci_transport_t mock_hci_transport = {
+    "MOCK", &mock_hci_transport_init, &mock_hci_transport_open, &mock_hci_transport_close,
+    &mock_hci_transport_register_packet_handler, &mock_hci_transport_can_send_packet_now, &mock_hci_transport_send_packet, NULL, NULL, NULL
+};
+
+const hci_transport_t * mock_hci_transport_instance(void){
+    mock_events_len = 0;
+    mock_num_l2cap_packets = 0;
+    mock_complete_acl_packets = 1;
+    return &mock_hci_transport;
+}
+
+void mock_hci_transport_process(void){
+    while (mock_events_len > 0){
+        uint8_t event[260];
+        uint16_t event_size = 2 + mock_events[1];
+        (void)memcpy(event, mock_events, event_size);
+        mock_events_len -= event_size;
+        memmove(mock_events, &mock_events[event_size], mock_events_len);
+        (*mock_packet_handler)(HCI_EVENT_PACKET, event, event_size);
+    }
+}
+
+void mock_hci_transport_queue_connection_complete(hci_con_handle_t con_handle, const bd_addr_t address){
+    // incoming connection, accepted by HCI
+    uint8_t request[12];
+    memset(request, 0, sizeof(request));
+    request[0] = HCI_EVENT_CONNECTION_REQUEST;
+    request[1] = 10;
+    reverse_bd_addr(address, &request[2]);
+    request[11] = 1;  // ACL
+    mock_hci_transport_queue_event(request, sizeof(request));
+
+    uint8_t event[13];
+    event[0] = HCI_EVENT_CONNECTION_COMPLETE;
+    event[1] = 11;
+    event[2] = ERROR_CODE_SUCCESS;
+    little_endian_store_16(event, 3, con_handle);
+    reverse_bd_addr(address, &event[5]);
+    event[11] = 1;  // ACL
+    event[12] = 0;  // no encryption
+    mock_hci_transport_queue_event(event, sizeof(event));
+}
+
+void mock_hci_transport_queue_le_connection_complete(hci_con_handle_t con_handle, const bd_addr_t address){
+    uint8_t event[21];
+    memset(event, 0, sizeof(event));
+    event[0] = HCI_EVENT_LE_META;
+    event[1] = 19;
+    event[2] = HCI_SUBEVENT_LE_CONNECTION_COMPLETE;
+    event[3] = ERROR_CODE_SUCCESS;
+    little_endian_store_16(event, 4, con_handle);
+    event[6] = HCI_ROLE_SLAVE;
+    event[7] = BD_ADDR_TYPE_LE_PUBLIC;
+    reverse_bd_addr(address, &event[8]);
+    mock_hci_transport_queue_event(event, sizeof(event));
+}
+
+void mock_hci_transport_queue_disconnection_complete(hci_con_handle_t con_handle){
+    uint8_t event[6];
+    event[0] = HCI_EVENT_DISCONNECTION_COMPLETE;
+    event[1] = 4;
+    event[2] = ERROR_CODE_SUCCESS;
+    little_endian_store_16(event, 3, con_handle);
+    event[5] = ERROR_CODE_REMOTE_USER_TERMINATED_CONNECTION;
+    mock_hci_transport_queue_event(event, sizeof(event));
+}
+
+void mock_hci_transport_receive_l2cap_packet(hci_con_handle_t con_handle, uint16_t cid, const uint8_t * payload, uint16_t len){
+    uint8_t packet[4 + 4 + MOCK_HCI_TRANSPORT_MAX_PACKET_SIZE];
+    btstack_assert(len <= MOCK_HCI_TRANSPORT_MAX_PACKET_SIZE);
+    // first automatically flushable packet
+    little_endian_store_16(packet, 0, con_handle | 0x2000u);
+    little_endian_store_16(packet, 2, 4 + len);
+    little_endian_store_16(packet, 4, len);
+    little_endian_store_16(packet, 6, cid);
+    (void)memcpy(&packet[8], payload, len);
+    (*mock_packet_handler)(HCI_ACL_DATA_PACKET, packet, 8 + len);
+}
+
+uint16_t mock_hci_transport_num_l2cap_packets(void){
+    return mock_num_l2cap_packets;
+}
+
+const uint8_t * mock_hci_transport_get_l2cap_packet(uint16_t index, uint16_t * out_len){
+    if (index >= mock_num_l2cap_packets) return NULL;
+    *out_len = mock_l2cap_packet_lens[index];
+    return mock_l2cap_packets[index];
+}
+
+const uint8_t * mock_hci_transport_get_last_l2cap_packet_for_cid(uint16_t cid, uint16_t * out_len){
+    uint16_t index = mock_num_l2cap_packets;
+    while (index > 0){
+        index--;
+        if (little_endian_read_16(mock_l2cap_packets[index], 2) != cid) continue;
+        *out_len = mock_l2cap_packet_lens[index];
+        return mock_l2cap_packets[index];
+    }
+    return NULL;
+}
+
+void mock_hci_transport_clear_l2cap_packets(void){
+    mock_num_l2cap_packets = 0;
+}
+
+void mock_hci_transport_set_complete_acl_packets(int enabled){
+    mock_complete_acl_packets = enabled;
+}
+
+void mock_hci_transport_queue_number_of_completed_packets(hci_con_handle_t con_handle, uint16_t num_packets){
+    uint8_t event[7];
+    event[0] = HCI_EVENT_NUMBER_OF_COMPLETED_PACKETS;
+    event[1] = 5;
+    event[2] = 1;
+    little_endian_store_16(event, 3, con_handle);
+    little_endian_store_16(event, 5, num_packets);
+    mock_hci_transport_queue_event(event, sizeof(event));
+}
@@ -0,0 +1,146 @@
+/*
+ * Copyright (C) 2019 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+/*
+ *  mock_hci_transport.h
+ *
+ *  Fake Controller as HCI Transport for unit tests
+ *
+ *  HCI Commands are answered with Command Complete and outgoing ACL packets are completed with
+ *  Number Of Completed Packets. Events incl. HCI_EVENT_TRANSPORT_PACKET_SENT are delivered by
+ *  mock_hci_transport_process, outgoing L2CAP packets are stored for inspection.
+ */
+
+#ifndef MOCK_HCI_TRANSPORT_H
+#define MOCK_HCI_TRANSPORT_H
+
+#include <stdint.h>
+
+#include "bluetooth.h"
+#include "hci_transport.h"
+
+#if defined __cplusplus
+extern "C" {
+#endif
+
+#define MOCK_HCI_TRANSPORT_MAX_PACKETS     32
+#define MOCK_HCI_TRANSPORT_MAX_PACKET_SIZE 1100
+
+/**
+ * @brief Get HCI Transport for fake Controller, resets stored packets and pending events
+ * @return hci_transport
+ */
+const hci_transport_t * mock_hci_transport_instance(void);
+
+/**
+ * @brief Deliver pending events until none are left
+ */
+void mock_hci_transport_process(void);
+
+/**
+ * @brief Queue Connection Request and Connection Complete for incoming Classic ACL connection
+ * @param con_handle
+ * @param address
+ */
+void mock_hci_transport_queue_connection_complete(hci_con_handle_t con_handle, const bd_addr_t address);
+
+/**
+ * @brief Queue LE Connection Complete in peripheral role
+ * @param con_handle
+ * @param address
+ */
+void mock_hci_transport_queue_le_connection_complete(hci_con_handle_t con_handle, const bd_addr_t address);
+
+/**
+ * @brief Queue Disconnection Complete
+ * @param con_handle
+ */
+void mock_hci_transport_queue_disconnection_complete(hci_con_handle_t con_handle);
+
+/**
+ * @brief Receive L2CAP packet from remote, delivered immediately
+ * @param con_handle
+ * @param cid
+ * @param payload
+ * @param len
+ */
+void mock_hci_transport_receive_l2cap_packet(hci_con_handle_t con_handle, uint16_t cid, const uint8_t * payload, uint16_t len);
+
+/**
+ * @brief Get number of stored outgoing L2CAP packets
+ */
+uint16_t mock_hci_transport_num_l2cap_packets(void);
+
+/**
+ * @brief Get stored outgoing L2CAP packet without ACL header
+ * @param index
+ * @param out_len
+ * @return packet starting with L2CAP header
+ */
+const uint8_t * mock_hci_transport_get_l2cap_packet(uint16_t index, uint16_t * out_len);
+
+/**
+ * @brief Get most recent outgoing L2CAP packet for cid
+ * @param cid
+ * @param out_len
+ * @return packet starting with L2CAP header or NULL
+ */
+const uint8_t * mock_hci_transport_get_last_l2cap_packet_for_cid(uint16_t cid, uint16_t * out_len);
+
+/**
+ * @brief Discard stored outgoing L2CAP packets
+ */
+void mock_hci_transport_clear_l2cap_packets(void);
+
+/**
+ * @brief Enable/disable Number Of Completed Packets for outgoing ACL packets, default: enabled
+ * @param enabled
+ */
+void mock_hci_transport_set_complete_acl_packets(int enabled);
+
+/**
+ * @brief Queue Number Of Completed Packets event for outgoing ACL packets
+ * @param con_handle
+ * @param num_packets
+ */
+void mock_hci_transport_queue_number_of_completed_packets(hci_con_handle_t con_handle, uint16_t num_packets);
+
+#if defined __cplusplus
+}
+#endif
+
+#endif // MOCK_HCI_TRANSPORT_H
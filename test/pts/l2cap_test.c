@@ -71,7 +71,8 @@ static uint16_t local_cid;
 static int l2cap_ertm;
 
 static btstack_packet_callback_registration_t hci_event_callback_registration;
-static uint8_t ertm_buffer[10000];
+#define EXTENDED_WINDOW_SIZE 64
+static uint8_t ertm_buffer[20000];
 static l2cap_ertm_config_t ertm_config = {
     0,  // ertm mandatory
     2,  // max transmit, some tests require > 1
@@ -146,13 +147,15 @@ static void packet_handler (uint8_t packet_type, uint16_t channel, uint8_t *pack
 
 static void show_usage(void){
     printf("\n--- CLI for L2CAP TEST ---\n");
-    printf("L2CAP Channel Mode %s\n", l2cap_ertm ? "Enhanced Retransmission" : "Basic");
+    printf("L2CAP Channel Mode %s\n", l2cap_ertm ? (ertm_config.streaming_mode ? "Streaming" : "Enhanced Retransmission") : "Basic");
     printf("c      - create connection to SDP at addr %s\n", bd_addr_to_str(remote));
     printf("s      - send some data\n");
     printf("S      - send more data\n");
     printf("p      - send echo request\n");
     printf("e      - optional ERTM mode\n");
     printf("E      - mandatory ERTM mode\n");
+    printf("m      - mandatory Streaming mode\n");
+    printf("w      - use extended window size of %u frames (ERTM)\n", EXTENDED_WINDOW_SIZE);
     printf("b      - set channel as busy (ERTM)\n");
     printf("B      - set channel as ready (ERTM)\n");
     printf("d      - disconnect\n");
@@ -195,11 +198,24 @@ static void stdin_process(char buffer){
             printf("L2CAP Enhanced Retransmission Mode (ERTM) optional\n");
             l2cap_ertm = 1;
             ertm_config.ertm_mandatory = 0;
+            ertm_config.streaming_mode = 0;
             break;
         case 'E':
             printf("L2CAP Enhanced Retransmission Mode (ERTM) mandatory\n");
             l2cap_ertm = 1;
             ertm_config.ertm_mandatory = 1;
+            ertm_config.streaming_mode = 0;
+            break;
+        case 'm':
+            printf("L2CAP Streaming Mode mandatory\n");
+            l2cap_ertm = 1;
+            ertm_config.ertm_mandatory = 1;
+            ertm_config.streaming_mode = 1;
+            break;
+        case 'w':
+            printf("L2CAP ERTM with extended window size %u\n", EXTENDED_WINDOW_SIZE);
+            ertm_config.num_rx_buffers = EXTENDED_WINDOW_SIZE;
+            ertm_config.num_tx_buffers = EXTENDED_WINDOW_SIZE;
             break;
         case 'p':
             printf("Send L2CAP ECHO Request\n");
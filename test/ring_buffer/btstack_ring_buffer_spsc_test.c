@@ -0,0 +1,251 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/CommandLineTestRunner.h"
+#include "bluetooth.h"
+#include "btstack_ring_buffer.h"
+#include "btstack_ring_buffer_spsc.h"
+#include "btstack_util.h"
+
+#define STRESS_BYTES    (4 * 1024 * 1024)
+#define BENCHMARK_BYTES (64 * 1024 * 1024)
+#define BENCHMARK_CHUNK 512
+
+static uint8_t storage[20];
+
+uint32_t btstack_min(uint32_t a, uint32_t b){
+    return a < b ? a : b;
+}
+
+TEST_GROUP(RingBufferSPSC){
+    btstack_ring_buffer_spsc_t ring_buffer;
+
+    void setup(void){
+        memset(storage, 0, sizeof(storage));
+        btstack_ring_buffer_spsc_init(&ring_buffer, storage, sizeof(storage));
+    }
+};
+
+TEST(RingBufferSPSC, SizeIsPowerOfTwo){
+    CHECK_EQUAL(16u, ring_buffer.size);
+    CHECK_EQUAL(15u, ring_buffer.mask);
+    btstack_ring_buffer_spsc_init(&ring_buffer, storage, 16);
+    CHECK_EQUAL(16u, ring_buffer.size);
+    btstack_ring_buffer_spsc_init(&ring_buffer, storage, 15);
+    CHECK_EQUAL(8u, ring_buffer.size);
+    btstack_ring_buffer_spsc_init(&ring_buffer, storage, 0);
+    CHECK_EQUAL(0u, ring_buffer.size);
+    uint32_t span_len = 1;
+    btstack_ring_buffer_spsc_write_acquire(&ring_buffer, &span_len);
+    CHECK_EQUAL(0u, span_len);
+}
+
+TEST(RingBufferSPSC, IndicesOnSeparateCacheLines){
+    uintptr_t write_index = (uintptr_t) &ring_buffer.write_index;
+    uintptr_t read_index  = (uintptr_t) &ring_buffer.read_index;
+    uintptr_t config      = (uintptr_t) &ring_buffer.storage;
+    CHECK(read_index - write_index >= BTSTACK_RING_BUFFER_SPSC_CACHE_LINE_SIZE);
+    CHECK(write_index - config >= BTSTACK_RING_BUFFER_SPSC_CACHE_LINE_SIZE);
+}
+
+TEST(RingBufferSPSC, EmptyBuffer){
+    CHECK_EQUAL(0u,  btstack_ring_buffer_spsc_bytes_available(&ring_buffer));
+    CHECK_EQUAL(16u, btstack_ring_buffer_spsc_bytes_free(&ring_buffer));
+    uint32_t span_len = 1;
+    btstack_ring_buffer_spsc_read_acquire(&ring_buffer, &span_len);
+    CHECK_EQUAL(0u, span_len);
+}
+
+TEST(RingBufferSPSC, Spans){
+    uint32_t span_len;
+    uint8_t * write_span = btstack_ring_buffer_spsc_write_acquire(&ring_buffer, &span_len);
+    POINTERS_EQUAL(&storage[0], write_span);
+    CHECK_EQUAL(16u, span_len);
+    memset(write_span, 0x11, 12);
+    btstack_ring_buffer_spsc_write_commit(&ring_buffer, 12);
+    CHECK_EQUAL(12u, btstack_ring_buffer_spsc_bytes_available(&ring_buffer));
+
+    const uint8_t * read_span = btstack_ring_buffer_spsc_read_acquire(&ring_buffer, &span_len);
+    POINTERS_EQUAL(&storage[0], read_span);
+    CHECK_EQUAL(12u, span_len);
+    btstack_ring_buffer_spsc_read_commit(&ring_buffer, 10);
+
+    // write span ends at end of storage
+    write_span = btstack_ring_buffer_spsc_write_acquire(&ring_buffer, &span_len);
+    POINTERS_EQUAL(&storage[12], write_span);
+    CHECK_EQUAL(4u, span_len);
+    memset(write_span, 0x22, 4);
+    btstack_ring_buffer_spsc_write_commit(&ring_buffer, 4);
+
+    // then continues at start of storage, limited by read index
+    write_span = btstack_ring_buffer_spsc_write_acquire(&ring_buffer, &span_len);
+    POINTERS_EQUAL(&storage[0], write_span);
+    CHECK_EQUAL(10u, span_len);
+    btstack_ring_buffer_spsc_write_commit(&ring_buffer, 10);
+    CHECK_EQUAL(0u, btstack_ring_buffer_spsc_bytes_free(&ring_buffer));
+    btstack_ring_buffer_spsc_write_acquire(&ring_buffer, &span_len);
+    CHECK_EQUAL(0u, span_len);
+
+    read_span = btstack_ring_buffer_spsc_read_acquire(&ring_buffer, &span_len);
+    POINTERS_EQUAL(&storage[10], read_span);
+    CHECK_EQUAL(6u, span_len);
+    CHECK_EQUAL(0x11, read_span[0]);
+    CHECK_EQUAL(0x22, read_span[5]);
+    btstack_ring_buffer_spsc_read_commit(&ring_buffer, 6);
+    read_span = btstack_ring_buffer_spsc_read_acquire(&ring_buffer, &span_len);
+    POINTERS_EQUAL(&storage[0], read_span);
+    CHECK_EQUAL(10u, span_len);
+}
+
+TEST(RingBufferSPSC, WriteFullBuffer){
+    uint8_t test_write_data[17];
+    memset(test_write_data, 0x33, sizeof(test_write_data));
+    CHECK_EQUAL(ERROR_CODE_MEMORY_CAPACITY_EXCEEDED, btstack_ring_buffer_spsc_write(&ring_buffer, test_write_data, 17));
+    CHECK_EQUAL(0, btstack_ring_buffer_spsc_write(&ring_buffer, test_write_data, 16));
+    CHECK_EQUAL(ERROR_CODE_MEMORY_CAPACITY_EXCEEDED, btstack_ring_buffer_spsc_write(&ring_buffer, test_write_data, 1));
+    CHECK_EQUAL(16u, btstack_ring_buffer_spsc_bytes_available(&ring_buffer));
+}
+
+TEST(RingBufferSPSC, ReadWriteWrapAround){
+    uint8_t test_write_data[11];
+    uint8_t test_read_data[11];
+    uint32_t number_of_bytes_read;
+    int i;
+    for (i = 0; i < 10; i++){
+        memset(test_write_data, i, sizeof(test_write_data));
+        CHECK_EQUAL(0, btstack_ring_buffer_spsc_write(&ring_buffer, test_write_data, sizeof(test_write_data)));
+        memset(test_read_data, 0xff, sizeof(test_read_data));
+        btstack_ring_buffer_spsc_read(&ring_buffer, test_read_data, 20, &number_of_bytes_read);
+        CHECK_EQUAL(sizeof(test_write_data), number_of_bytes_read);
+        MEMCMP_EQUAL(test_write_data, test_read_data, sizeof(test_write_data));
+    }
+    CHECK_EQUAL(0u, btstack_ring_buffer_spsc_bytes_available(&ring_buffer));
+}
+
+TEST(RingBufferSPSC, IndexOverflow){
+    // free running indices wrap at 2^32
+    ring_buffer.write_index = ring_buffer.write_index_cached = 0xfffffffcu;
+    ring_buffer.read_index  = ring_buffer.read_index_cached  = 0xfffffffcu;
+    uint8_t test_write_data[] = { 1, 2, 3, 4, 5, 6, 7, 8};
+    uint8_t test_read_data[8];
+    uint32_t number_of_bytes_read;
+    CHECK_EQUAL(0, btstack_ring_buffer_spsc_write(&ring_buffer, test_write_data, sizeof(test_write_data)));
+    CHECK_EQUAL(4u, ring_buffer.write_index);
+    CHECK_EQUAL(8u, btstack_ring_buffer_spsc_bytes_available(&ring_buffer));
+    CHECK_EQUAL(8u, btstack_ring_buffer_spsc_bytes_free(&ring_buffer));
+    btstack_ring_buffer_spsc_read(&ring_buffer, test_read_data, sizeof(test_read_data), &number_of_bytes_read);
+    CHECK_EQUAL(8u, number_of_bytes_read);
+    MEMCMP_EQUAL(test_write_data, test_read_data, sizeof(test_write_data));
+}
+
+// producer and consumer threads, verify byte stream
+
+static uint8_t                    stress_storage[1024];
+static btstack_ring_buffer_spsc_t stress_ring_buffer;
+
+static void * stress_producer(void * context){
+    UNUSED(context);
+    uint32_t bytes_written = 0;
+    uint32_t chunk = 1;
+    while (bytes_written < STRESS_BYTES){
+        uint32_t span_len;
+        uint8_t * span = btstack_ring_buffer_spsc_write_acquire(&stress_ring_buffer, &span_len);
+        // vary chunk size
+        chunk = (chunk * 7u + 3u) % 97u + 1u;
+        uint32_t len = btstack_min(btstack_min(span_len, chunk), STRESS_BYTES - bytes_written);
+        uint32_t i;
+        for (i = 0; i < len; i++){
+            span[i] = (uint8_t) (bytes_written + i);
+        }
+        btstack_ring_buffer_spsc_write_commit(&stress_ring_buffer, len);
+        bytes_written += len;
+    }
+    return NULL;
+}
+
+TEST(RingBufferSPSC, ProducerConsumerThreads){
+    btstack_ring_buffer_spsc_init(&stress_ring_buffer, stress_storage, sizeof(stress_storage));
+    pthread_t producer;
+    pthread_create(&producer, NULL, &stress_producer, NULL);
+
+    uint32_t bytes_read = 0;
+    uint32_t errors = 0;
+    uint32_t chunk = 1;
+    while (bytes_read < STRESS_BYTES){
+        uint32_t span_len;
+        const uint8_t * span = btstack_ring_buffer_spsc_read_acquire(&stress_ring_buffer, &span_len);
+        chunk = (chunk * 5u + 1u) % 89u + 1u;
+        uint32_t len = btstack_min(span_len, chunk);
+        uint32_t i;
+        for (i = 0; i < len; i++){
+            if (span[i] != (uint8_t) (bytes_read + i)) errors++;
+        }
+        btstack_ring_buffer_spsc_read_commit(&stress_ring_buffer, len);
+        bytes_read += len;
+    }
+    pthread_join(producer, NULL);
+    CHECK_EQUAL(0u, errors);
+    CHECK_EQUAL(0u, btstack_ring_buffer_spsc_bytes_available(&stress_ring_buffer));
+}
+
+// single threaded throughput of copy API compared to btstack_ring_buffer
+
+static uint64_t benchmark_time_ns(void){
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t) now.tv_sec * 1000000000u) + (uint64_t) now.tv_nsec;
+}
+
+static uint32_t benchmark_mb_per_s(uint64_t duration_ns){
+    if (duration_ns == 0u) duration_ns = 1;
+    return (uint32_t) (((uint64_t) BENCHMARK_BYTES * 1000u) / duration_ns);
+}
+
+TEST(RingBufferSPSC, Benchmark){
+    static uint8_t benchmark_storage[4096];
+    uint8_t chunk[BENCHMARK_CHUNK];
+    uint32_t number_of_bytes_read;
+    uint32_t bytes;
+    memset(chunk, 0x55, sizeof(chunk));
+
+    btstack_ring_buffer_t ring_buffer_copy;
+    btstack_ring_buffer_init(&ring_buffer_copy, benchmark_storage, sizeof(benchmark_storage));
+    uint64_t start_ns = benchmark_time_ns();
+    for (bytes = 0; bytes < BENCHMARK_BYTES; bytes += BENCHMARK_CHUNK){
+        btstack_ring_buffer_write(&ring_buffer_copy, chunk, BENCHMARK_CHUNK);
+        btstack_ring_buffer_read(&ring_buffer_copy, chunk, BENCHMARK_CHUNK, &number_of_bytes_read);
+    }
+    uint32_t mb_per_s_ring_buffer = benchmark_mb_per_s(benchmark_time_ns() - start_ns);
+
+    btstack_ring_buffer_spsc_init(&ring_buffer, benchmark_storage, sizeof(benchmark_storage));
+    start_ns = benchmark_time_ns();
+    for (bytes = 0; bytes < BENCHMARK_BYTES; bytes += BENCHMARK_CHUNK){
+        btstack_ring_buffer_spsc_write(&ring_buffer, chunk, BENCHMARK_CHUNK);
+        btstack_ring_buffer_spsc_read(&ring_buffer, chunk, BENCHMARK_CHUNK, &number_of_bytes_read);
+    }
+    uint32_t mb_per_s_spsc = benchmark_mb_per_s(benchmark_time_ns() - start_ns);
+
+    // in place, no copy
+    start_ns = benchmark_time_ns();
+    for (bytes = 0; bytes < BENCHMARK_BYTES; bytes += BENCHMARK_CHUNK){
+        uint32_t span_len;
+        uint8_t * write_span = btstack_ring_buffer_spsc_write_acquire(&ring_buffer, &span_len);
+        write_span[0] = (uint8_t) bytes;
+        btstack_ring_buffer_spsc_write_commit(&ring_buffer, btstack_min(span_len, BENCHMARK_CHUNK));
+        const uint8_t * read_span = btstack_ring_buffer_spsc_read_acquire(&ring_buffer, &span_len);
+        chunk[0] = read_span[0];
+        btstack_ring_buffer_spsc_read_commit(&ring_buffer, span_len);
+    }
+    uint32_t mb_per_s_spans = benchmark_mb_per_s(benchmark_time_ns() - start_ns);
+
+    printf("\nbtstack_ring_buffer write/read:      %6u MB/s\n", mb_per_s_ring_buffer);
+    printf("btstack_ring_buffer_spsc write/read: %6u MB/s\n", mb_per_s_spsc);
+    printf("btstack_ring_buffer_spsc spans:      %6u MB/s\n", mb_per_s_spans);
+}
+
+int main (int argc, const char * argv[]){
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
@@ -0,0 +1,180 @@
+
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/CommandLineTestRunner.h"
+
+#include "btstack_run_loop.h"
+#include "btstack_run_loop_posix.h"
+#include "btstack_util.h"
+#include "btstack_debug.h"
+
+#include <pthread.h>
+#include <string.h>
+
+#define NUM_THREADS            4
+#define CALLBACKS_PER_THREAD   1000
+#define TEST_TIMEOUT_MS        5000
+
+typedef struct {
+    btstack_context_callback_registration_t registration;
+    uint16_t thread_index;
+    uint16_t sequence_nr;
+} test_callback_t;
+
+static test_callback_t test_callbacks[NUM_THREADS][CALLBACKS_PER_THREAD];
+static pthread_t threads[NUM_THREADS];
+
+static uint16_t executed_order[CALLBACKS_PER_THREAD];
+static uint32_t num_executed;
+static uint32_t num_expected;
+static uint16_t next_sequence_nr[NUM_THREADS];
+static bool     out_of_order;
+static bool     timeout_reached;
+
+static btstack_timer_source_t timeout_timer;
+static btstack_run_loop_posix_callback_stats_t stats_before;
+
+static void timeout_handler(btstack_timer_source_t * ts){
+    UNUSED(ts);
+    timeout_reached = true;
+    btstack_run_loop_posix_trigger_exit();
+}
+
+static void test_callback_handler(void * context){
+    test_callback_t * test_callback = (test_callback_t *) context;
+    if (num_executed < CALLBACKS_PER_THREAD){
+        executed_order[num_executed] = test_callback->sequence_nr;
+    }
+    // callbacks from one thread are executed in submission order
+    if (next_sequence_nr[test_callback->thread_index] != test_callback->sequence_nr){
+        out_of_order = true;
+    }
+    next_sequence_nr[test_callback->thread_index]++;
+    num_executed++;
+    if (num_executed == num_expected){
+        btstack_run_loop_posix_trigger_exit();
+    }
+}
+
+static void requeue_callback_handler(void * context){
+    test_callback_t * test_callback = (test_callback_t *) context;
+    num_executed++;
+    if (num_executed == num_expected){
+        btstack_run_loop_posix_trigger_exit();
+    } else {
+        btstack_run_loop_execute_on_main_thread(&test_callback->registration);
+    }
+}
+
+static void * producer_thread(void * arg){
+    uint16_t thread_index = (uint16_t) (uintptr_t) arg;
+    uint16_t i;
+    for (i = 0; i < CALLBACKS_PER_THREAD; i++){
+        btstack_run_loop_execute_on_main_thread(&test_callbacks[thread_index][i].registration);
+    }
+    return NULL;
+}
+
+static void init_callback(uint16_t thread_index, uint16_t sequence_nr, void (*handler)(void * context)){
+    test_callback_t * test_callback = &test_callbacks[thread_index][sequence_nr];
+    test_callback->thread_index = thread_index;
+    test_callback->sequence_nr = sequence_nr;
+    test_callback->registration.callback = handler;
+    test_callback->registration.context = test_callback;
+}
+
+static void run_loop_execute_with_timeout(void){
+    btstack_run_loop_set_timer_handler(&timeout_timer, &timeout_handler);
+    btstack_run_loop_set_timer(&timeout_timer, TEST_TIMEOUT_MS);
+    btstack_run_loop_add_timer(&timeout_timer);
+    btstack_run_loop_execute();
+    btstack_run_loop_remove_timer(&timeout_timer);
+}
+
+static uint32_t histogram_delta(void){
+    const btstack_run_loop_posix_callback_stats_t * stats = btstack_run_loop_posix_get_callback_stats();
+    uint32_t sum = 0;
+    uint16_t i;
+    for (i = 0; i < BTSTACK_RUN_LOOP_POSIX_LATENCY_BUCKETS; i++){
+        sum += stats->latency_histogram[i] - stats_before.latency_histogram[i];
+    }
+    return sum;
+}
+
+TEST_GROUP(RunLoopPosix){
+    void setup(void){
+        num_executed = 0;
+        num_expected = 0;
+        out_of_order = false;
+        timeout_reached = false;
+        memset(next_sequence_nr, 0, sizeof(next_sequence_nr));
+        memset(executed_order, 0, sizeof(executed_order));
+        memcpy(&stats_before, btstack_run_loop_posix_get_callback_stats(), sizeof(stats_before));
+    }
+};
+
+TEST(RunLoopPosix, QueueBeforeExecute){
+    uint16_t i;
+    num_expected = 3;
+    for (i = 0; i < num_expected; i++){
+        init_callback(0, i, &test_callback_handler);
+        btstack_run_loop_execute_on_main_thread(&test_callbacks[0][i].registration);
+    }
+    run_loop_execute_with_timeout();
+    CHECK(!timeout_reached);
+    CHECK_EQUAL(3, num_executed);
+    CHECK(!out_of_order);
+    for (i = 0; i < num_expected; i++){
+        CHECK_EQUAL(i, executed_order[i]);
+    }
+    // all callbacks are processed in a single batch
+    const btstack_run_loop_posix_callback_stats_t * stats = btstack_run_loop_posix_get_callback_stats();
+    CHECK_EQUAL(1, stats->num_batches - stats_before.num_batches);
+    CHECK_EQUAL(3, stats->num_callbacks - stats_before.num_callbacks);
+    CHECK(stats->max_batch_size >= 3);
+    CHECK_EQUAL(1, histogram_delta());
+}
+
+TEST(RunLoopPosix, RequeueFromCallback){
+    num_expected = 5;
+    init_callback(0, 0, &requeue_callback_handler);
+    btstack_run_loop_execute_on_main_thread(&test_callbacks[0][0].registration);
+    run_loop_execute_with_timeout();
+    CHECK(!timeout_reached);
+    CHECK_EQUAL(5, num_executed);
+    // callback queued again by itself is executed in next batch
+    const btstack_run_loop_posix_callback_stats_t * stats = btstack_run_loop_posix_get_callback_stats();
+    CHECK_EQUAL(5, stats->num_batches - stats_before.num_batches);
+}
+
+TEST(RunLoopPosix, MultipleThreads){
+    uint16_t thread_index;
+    uint16_t i;
+    num_expected = NUM_THREADS * CALLBACKS_PER_THREAD;
+    for (thread_index = 0; thread_index < NUM_THREADS; thread_index++){
+        for (i = 0; i < CALLBACKS_PER_THREAD; i++){
+            init_callback(thread_index, i, &test_callback_handler);
+        }
+    }
+    for (thread_index = 0; thread_index < NUM_THREADS; thread_index++){
+        pthread_create(&threads[thread_index], NULL, &producer_thread, (void *) (uintptr_t) thread_index);
+    }
+    run_loop_execute_with_timeout();
+    for (thread_index = 0; thread_index < NUM_THREADS; thread_index++){
+        pthread_join(threads[thread_index], NULL);
+    }
+    CHECK(!timeout_reached);
+    CHECK_EQUAL(num_expected, num_executed);
+    CHECK(!out_of_order);
+    const btstack_run_loop_posix_callback_stats_t * stats = btstack_run_loop_posix_get_callback_stats();
+    uint32_t num_batches = stats->num_batches - stats_before.num_batches;
+    CHECK_EQUAL(num_expected, stats->num_callbacks - stats_before.num_callbacks);
+    CHECK(num_batches >= 1);
+    CHECK(num_batches <= num_expected);
+    CHECK(histogram_delta() <= num_batches);
+    btstack_run_loop_posix_dump_callback_stats();
+}
+
+int main (int argc, const char * argv[]){
+    btstack_run_loop_init(btstack_run_loop_posix_get_instance());
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
@@ -0,0 +1,24 @@
+//
+// btstack_config.h for BTdaemon socket connection tests
+//
+
+#ifndef __BTSTACK_CONFIG
+#define __BTSTACK_CONFIG
+
+// Port related features
+#define HAVE_MALLOC
+#define HAVE_ASSERT
+#define HAVE_POSIX_TIME
+#define HAVE_UNIX_SOCKETS
+
+// BTstack features that can be enabled
+#define ENABLE_LOG_ERROR
+#define ENABLE_LOG_INFO
+
+// BTstack configuration. buffers, sizes, ...
+#define HCI_ACL_PAYLOAD_SIZE 1021
+
+// BTdaemon configuration
+#define BTSTACK_UNIX "/tmp/btstack_socket_connection_test"
+
+#endif
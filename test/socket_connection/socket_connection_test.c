@@ -0,0 +1,568 @@
+// BTdaemon socket connection: per-client output queue, overflow policies and shared memory transport,
+// tested with raw unix domain clients
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/CommandLineTestRunner.h"
+
+#include "btstack_debug.h"
+#include "btstack_defines.h"
+#include "btstack_run_loop.h"
+#include "btstack_run_loop_posix.h"
+#include "btstack_util.h"
+#include "bluetooth.h"
+#include "socket_connection.h"
+
+#define PACKET_HEADER_SIZE      6
+#define TEST_PAYLOAD_SIZE       1000
+#define TEST_NUM_PACKETS        1000
+#define TEST_OUTPUT_QUEUE_SIZE  8192
+#define MAX_CLIENTS             2
+// client is drained when nothing was received for this many run loop iterations
+#define IDLE_ITERATIONS         5
+
+// shared memory transport, see socket_connection.c
+#define SHM_SETUP_PACKET            0xf0
+#define SHM_SETUP_COMPLETE_PACKET   0xf1
+#define SHM_MAGIC                   0x52534242
+#define SHM_VERSION                 1
+#define SHM_RING_SIZE               2048
+
+typedef struct {
+    uint32_t head;
+    uint8_t  padding_head[60];
+    uint32_t tail;
+    uint8_t  padding_tail[60];
+    uint32_t consumer_waiting;
+    uint32_t producer_waiting;
+    uint8_t  padding_flags[56];
+} shm_ring_t;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t ring_size;
+    uint8_t  padding[52];
+    shm_ring_t rings[2];
+} shm_header_t;
+
+typedef struct {
+    int      fd;
+    connection_t * connection;
+    uint8_t  buffer[PACKET_HEADER_SIZE + TEST_PAYLOAD_SIZE];
+    uint16_t bytes_read;
+    uint32_t num_packets_received;
+    uint32_t last_sequence_nr;
+    bool     out_of_order;
+    bool     closed;
+    // shared memory transport
+    bool     shm_setup_complete;
+    uint8_t  shm_setup_status;
+    shm_header_t * shm_header;
+    uint32_t shm_size;
+    int      doorbell_daemon;
+    int      doorbell_client;
+} raw_client_t;
+
+static raw_client_t clients[MAX_CLIENTS];
+static uint16_t num_clients;
+
+static connection_t * opened_connections[MAX_CLIENTS];
+static uint16_t num_connections_opened;
+static uint16_t num_connections_closed;
+static uint32_t num_packets_from_clients;
+
+static btstack_timer_source_t exit_timer;
+
+static int packet_callback(connection_t *connection, uint16_t packet_type, uint16_t channel, uint8_t *data, uint16_t length){
+    UNUSED(channel);
+    UNUSED(length);
+    if (packet_type == DAEMON_EVENT_PACKET){
+        switch (data[0]){
+            case DAEMON_EVENT_CONNECTION_OPENED:
+                if (num_connections_opened < MAX_CLIENTS){
+                    opened_connections[num_connections_opened++] = connection;
+                }
+                break;
+            case DAEMON_EVENT_CONNECTION_CLOSED:
+                num_connections_closed++;
+                break;
+            default:
+                break;
+        }
+        return 0;
+    }
+    num_packets_from_clients++;
+    return 0;
+}
+
+static void exit_timer_handler(btstack_timer_source_t * ts){
+    UNUSED(ts);
+    btstack_run_loop_posix_trigger_exit();
+}
+
+static void run_loop_for_ms(uint32_t timeout_ms){
+    btstack_run_loop_set_timer_handler(&exit_timer, &exit_timer_handler);
+    btstack_run_loop_set_timer(&exit_timer, timeout_ms);
+    btstack_run_loop_add_timer(&exit_timer);
+    btstack_run_loop_execute();
+}
+
+static raw_client_t * raw_client_connect(void){
+    raw_client_t * client = &clients[num_clients++];
+    memset(client, 0, sizeof(raw_client_t));
+    client->fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    CHECK(client->fd >= 0);
+    struct sockaddr_un server;
+    memset(&server, 0, sizeof(server));
+    server.sun_family = AF_UNIX;
+    strcpy(server.sun_path, BTSTACK_UNIX);
+    CHECK_EQUAL(0, connect(client->fd, (struct sockaddr *) &server, sizeof(server)));
+    int flags = fcntl(client->fd, F_GETFL, 0);
+    fcntl(client->fd, F_SETFL, flags | O_NONBLOCK);
+    uint16_t num_expected = num_connections_opened + 1;
+    while (num_connections_opened < num_expected){
+        run_loop_for_ms(1);
+    }
+    client->connection = opened_connections[num_expected - 1];
+    return client;
+}
+
+static void raw_client_handle_packet(raw_client_t * client, uint16_t packet_type, const uint8_t * payload, uint16_t payload_len){
+    if (packet_type == SHM_SETUP_COMPLETE_PACKET){
+        CHECK_EQUAL(1, payload_len);
+        client->shm_setup_complete = true;
+        client->shm_setup_status = payload[0];
+        return;
+    }
+    CHECK_EQUAL(TEST_PAYLOAD_SIZE, payload_len);
+    uint32_t sequence_nr = little_endian_read_32(payload, 0);
+    if ((client->num_packets_received > 0) && (sequence_nr <= client->last_sequence_nr)){
+        client->out_of_order = true;
+    }
+    client->last_sequence_nr = sequence_nr;
+    client->num_packets_received++;
+}
+
+// reassemble packets from received bytes
+static void raw_client_receive(raw_client_t * client, const uint8_t * data, uint32_t len){
+    while (len > 0){
+        uint16_t bytes_to_read;
+        if (client->bytes_read < PACKET_HEADER_SIZE){
+            bytes_to_read = PACKET_HEADER_SIZE - client->bytes_read;
+        } else {
+            bytes_to_read = PACKET_HEADER_SIZE + little_endian_read_16(client->buffer, 4) - client->bytes_read;
+        }
+        uint16_t bytes_copied = (uint16_t) btstack_min(bytes_to_read, len);
+        memcpy(&client->buffer[client->bytes_read], data, bytes_copied);
+        client->bytes_read += bytes_copied;
+        data += bytes_copied;
+        len  -= bytes_copied;
+        if (client->bytes_read < PACKET_HEADER_SIZE) continue;
+        uint16_t payload_len = little_endian_read_16(client->buffer, 4);
+        CHECK(payload_len <= TEST_PAYLOAD_SIZE);
+        if (client->bytes_read < (PACKET_HEADER_SIZE + payload_len)) continue;
+        raw_client_handle_packet(client, little_endian_read_16(client->buffer, 0), &client->buffer[PACKET_HEADER_SIZE], payload_len);
+        client->bytes_read = 0;
+    }
+}
+
+// read available data from socket or ring, returns number of bytes read
+static uint32_t raw_client_read(raw_client_t * client){
+    uint8_t data[4096];
+    uint32_t bytes_total = 0;
+    if (client->shm_header != NULL){
+        // daemon -> client ring
+        shm_ring_t * ring = &client->shm_header->rings[1];
+        uint8_t * ring_data = ((uint8_t *) client->shm_header) + sizeof(shm_header_t) + SHM_RING_SIZE;
+        uint32_t tail = ring->tail;
+        uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+        while (tail != head){
+            data[bytes_total++] = ring_data[tail & (SHM_RING_SIZE - 1)];
+            tail++;
+            if (bytes_total == sizeof(data)) break;
+        }
+        __atomic_store_n(&ring->tail, tail, __ATOMIC_RELEASE);
+        // wake up daemon if it waits for space
+        if ((bytes_total > 0) && __atomic_exchange_n(&ring->producer_waiting, 0, __ATOMIC_SEQ_CST)){
+            uint64_t value = 1;
+            CHECK_EQUAL(8, write(client->doorbell_daemon, &value, sizeof(value)));
+        }
+        raw_client_receive(client, data, bytes_total);
+        return bytes_total;
+    }
+    while (!client->closed){
+        ssize_t res = read(client->fd, data, sizeof(data));
+        if ((res < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK))) break;
+        if (res <= 0){
+            client->closed = true;
+            break;
+        }
+        bytes_total += (uint32_t) res;
+        raw_client_receive(client, data, (uint32_t) res);
+    }
+    return bytes_total;
+}
+
+static void raw_client_send(raw_client_t * client, uint16_t packet_type){
+    uint8_t packet[PACKET_HEADER_SIZE + 4];
+    little_endian_store_16(packet, 0, packet_type);
+    little_endian_store_16(packet, 2, 0);
+    little_endian_store_16(packet, 4, 4);
+    little_endian_store_32(packet, 6, 0);
+    if (client->shm_header == NULL){
+        CHECK_EQUAL((int) sizeof(packet), (int) write(client->fd, packet, sizeof(packet)));
+        return;
+    }
+    // client -> daemon ring
+    shm_ring_t * ring = &client->shm_header->rings[0];
+    uint8_t * ring_data = ((uint8_t *) client->shm_header) + sizeof(shm_header_t);
+    uint32_t head = ring->head;
+    uint32_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+    CHECK((SHM_RING_SIZE - (head - tail)) >= sizeof(packet));
+    uint16_t i;
+    for (i = 0; i < sizeof(packet); i++){
+        ring_data[(head + i) & (SHM_RING_SIZE - 1)] = packet[i];
+    }
+    __atomic_store_n(&ring->head, head + sizeof(packet), __ATOMIC_RELEASE);
+    // wake up daemon if it waits for data
+    if (__atomic_exchange_n(&ring->consumer_waiting, 0, __ATOMIC_SEQ_CST)){
+        uint64_t value = 1;
+        CHECK_EQUAL(8, write(client->doorbell_daemon, &value, sizeof(value)));
+    }
+}
+
+// pass memfd with given seals and doorbells to daemon and wait for setup complete
+static void raw_client_setup_shared_memory(raw_client_t * client, int seals){
+    uint32_t shm_size = sizeof(shm_header_t) + 2 * SHM_RING_SIZE;
+    int memfd = memfd_create("socket_connection_test", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    CHECK(memfd >= 0);
+    CHECK_EQUAL(0, ftruncate(memfd, shm_size));
+    if (seals != 0){
+        CHECK_EQUAL(0, fcntl(memfd, F_ADD_SEALS, seals));
+    }
+    void * shm = mmap(NULL, shm_size, PROT_READ | PROT_WRITE, MAP_SHARED, memfd, 0);
+    CHECK(shm != MAP_FAILED);
+    shm_header_t * header = (shm_header_t *) shm;
+    memset(header, 0, sizeof(shm_header_t));
+    header->magic = SHM_MAGIC;
+    header->version = SHM_VERSION;
+    header->ring_size = SHM_RING_SIZE;
+    header->rings[0].consumer_waiting = 1;
+    header->rings[1].consumer_waiting = 1;
+    int doorbell_daemon = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    int doorbell_client = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    CHECK(doorbell_daemon >= 0);
+    CHECK(doorbell_client >= 0);
+
+    // setup packet with memfd, doorbell client -> daemon, doorbell daemon -> client
+    uint8_t packet[PACKET_HEADER_SIZE + 4];
+    little_endian_store_16(packet, 0, SHM_SETUP_PACKET);
+    little_endian_store_16(packet, 2, 0);
+    little_endian_store_16(packet, 4, 4);
+    little_endian_store_32(packet, 6, SHM_RING_SIZE);
+    int fds[3] = { memfd, doorbell_daemon, doorbell_client };
+    union {
+        struct cmsghdr header;
+        uint8_t buffer[CMSG_SPACE(sizeof(fds))];
+    } control;
+    memset(&control, 0, sizeof(control));
+    struct iovec iov;
+    iov.iov_base = packet;
+    iov.iov_len = sizeof(packet);
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buffer;
+    msg.msg_controllen = sizeof(control.buffer);
+    struct cmsghdr * cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(fds));
+    memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+    CHECK_EQUAL((int) sizeof(packet), (int) sendmsg(client->fd, &msg, 0));
+    close(memfd);
+
+    client->shm_setup_complete = false;
+    while (!client->shm_setup_complete){
+        run_loop_for_ms(0);
+        raw_client_read(client);
+        CHECK(!client->closed);
+    }
+    if (client->shm_setup_status == ERROR_CODE_SUCCESS){
+        client->shm_header = header;
+        client->shm_size = shm_size;
+        client->doorbell_daemon = doorbell_daemon;
+        client->doorbell_client = doorbell_client;
+    } else {
+        munmap(shm, shm_size);
+        close(doorbell_daemon);
+        close(doorbell_client);
+    }
+}
+
+// let run loop flush queues and read everything
+static void raw_client_drain(raw_client_t * client){
+    uint16_t idle_iterations = 0;
+    while ((idle_iterations < IDLE_ITERATIONS) && !client->closed){
+        run_loop_for_ms(0);
+        if (raw_client_read(client) > 0){
+            idle_iterations = 0;
+        } else {
+            idle_iterations++;
+        }
+    }
+}
+
+static void send_test_packet(connection_t * connection, uint32_t sequence_nr){
+    uint8_t payload[TEST_PAYLOAD_SIZE];
+    memset(payload, 0x55, sizeof(payload));
+    little_endian_store_32(payload, 0, sequence_nr);
+    if (connection == NULL){
+        socket_connection_send_packet_all(HCI_EVENT_PACKET, 0, payload, sizeof(payload));
+    } else {
+        socket_connection_send_packet(connection, HCI_EVENT_PACKET, 0, payload, sizeof(payload));
+    }
+}
+
+TEST_GROUP(SocketConnection){
+    void setup(void){
+        num_clients = 0;
+        num_connections_opened = 0;
+        num_connections_closed = 0;
+        num_packets_from_clients = 0;
+    }
+    void teardown(void){
+        uint16_t i;
+        for (i = 0; i < num_clients; i++){
+            close(clients[i].fd);
+            if (clients[i].shm_header != NULL){
+                munmap(clients[i].shm_header, clients[i].shm_size);
+                close(clients[i].doorbell_daemon);
+                close(clients[i].doorbell_client);
+            }
+        }
+        // let server free connections
+        while (num_connections_closed < num_connections_opened){
+            run_loop_for_ms(1);
+        }
+    }
+};
+
+TEST(SocketConnection, QueueSendsAllPacketsInOrder){
+    socket_connection_set_output_queue(TEST_OUTPUT_QUEUE_SIZE, SOCKET_CONNECTION_OVERFLOW_DROP);
+    raw_client_t * client = raw_client_connect();
+    uint32_t i;
+    for (i = 0; i < TEST_NUM_PACKETS; i++){
+        send_test_packet(client->connection, i);
+        // client keeps up
+        if ((i % 4) == 3){
+            raw_client_drain(client);
+        }
+    }
+    raw_client_drain(client);
+    CHECK_EQUAL(TEST_NUM_PACKETS, client->num_packets_received);
+    CHECK_EQUAL(TEST_NUM_PACKETS - 1, client->last_sequence_nr);
+    CHECK(!client->out_of_order);
+}
+
+TEST(SocketConnection, OverflowDrop){
+    socket_connection_set_output_queue(TEST_OUTPUT_QUEUE_SIZE, SOCKET_CONNECTION_OVERFLOW_DROP);
+    raw_client_t * client = raw_client_connect();
+    uint32_t i;
+    for (i = 0; i < TEST_NUM_PACKETS; i++){
+        send_test_packet(client->connection, i);
+    }
+    raw_client_drain(client);
+    // whole packets have been dropped, connection stays open
+    CHECK(!client->closed);
+    CHECK(client->num_packets_received > 0);
+    CHECK(client->num_packets_received < TEST_NUM_PACKETS);
+    CHECK(!client->out_of_order);
+    CHECK_EQUAL(0, num_connections_closed);
+    // packets are delivered again after client caught up
+    send_test_packet(client->connection, TEST_NUM_PACKETS);
+    raw_client_drain(client);
+    CHECK_EQUAL(TEST_NUM_PACKETS, client->last_sequence_nr);
+}
+
+TEST(SocketConnection, OverflowDisconnect){
+    socket_connection_set_output_queue(TEST_OUTPUT_QUEUE_SIZE, SOCKET_CONNECTION_OVERFLOW_DISCONNECT);
+    raw_client_t * client = raw_client_connect();
+    uint32_t i;
+    for (i = 0; i < TEST_NUM_PACKETS; i++){
+        send_test_packet(client->connection, i);
+    }
+    raw_client_drain(client);
+    // client received packets sent before overflow and then end of stream
+    CHECK(client->closed);
+    CHECK(client->num_packets_received < TEST_NUM_PACKETS);
+    CHECK(!client->out_of_order);
+    CHECK_EQUAL(client->num_packets_received - 1, client->last_sequence_nr);
+    CHECK_EQUAL(1, num_connections_closed);
+}
+
+TEST(SocketConnection, OverflowBackpressurePausesInput){
+    socket_connection_set_output_queue(TEST_OUTPUT_QUEUE_SIZE, SOCKET_CONNECTION_OVERFLOW_BACKPRESSURE);
+    raw_client_t * client = raw_client_connect();
+
+    // input is processed while queue is empty
+    raw_client_send(client, HCI_COMMAND_DATA_PACKET);
+    run_loop_for_ms(1);
+    CHECK_EQUAL(1, num_packets_from_clients);
+
+    // fill socket and output queue, send returns without waiting for client
+    uint32_t start_ms = btstack_run_loop_get_time_ms();
+    uint32_t i;
+    for (i = 0; i < TEST_NUM_PACKETS; i++){
+        send_test_packet(client->connection, i);
+    }
+    CHECK(btstack_time_delta(btstack_run_loop_get_time_ms(), start_ms) < 1000);
+
+    // client does not read, its commands are not processed
+    raw_client_send(client, HCI_COMMAND_DATA_PACKET);
+    run_loop_for_ms(10);
+    CHECK_EQUAL(1, num_packets_from_clients);
+
+    // client catches up, input is resumed
+    raw_client_drain(client);
+    CHECK(!client->closed);
+    CHECK(!client->out_of_order);
+    CHECK_EQUAL(2, num_packets_from_clients);
+    CHECK_EQUAL(0, num_connections_closed);
+}
+
+TEST(SocketConnection, SlowClientDoesNotAffectOthers){
+    socket_connection_set_output_queue(TEST_OUTPUT_QUEUE_SIZE, SOCKET_CONNECTION_OVERFLOW_DROP);
+    raw_client_t * slow_client = raw_client_connect();
+    raw_client_t * fast_client = raw_client_connect();
+    uint32_t i;
+    for (i = 0; i < TEST_NUM_PACKETS; i++){
+        send_test_packet(NULL, i);
+        if ((i % 4) == 3){
+            raw_client_drain(fast_client);
+        }
+    }
+    raw_client_drain(fast_client);
+    raw_client_drain(slow_client);
+    CHECK_EQUAL(TEST_NUM_PACKETS, fast_client->num_packets_received);
+    CHECK(!fast_client->out_of_order);
+    CHECK(slow_client->num_packets_received < TEST_NUM_PACKETS);
+    CHECK(!slow_client->out_of_order);
+}
+
+TEST(SocketConnection, SharedMemorySetupRequiresSealedMemfd){
+    socket_connection_set_output_queue(TEST_OUTPUT_QUEUE_SIZE, SOCKET_CONNECTION_OVERFLOW_DROP);
+    raw_client_t * client = raw_client_connect();
+
+    // memfd could be shrunk by client
+    raw_client_setup_shared_memory(client, 0);
+    CHECK_EQUAL(ERROR_CODE_INVALID_HCI_COMMAND_PARAMETERS, client->shm_setup_status);
+    raw_client_setup_shared_memory(client, F_SEAL_GROW);
+    CHECK_EQUAL(ERROR_CODE_INVALID_HCI_COMMAND_PARAMETERS, client->shm_setup_status);
+
+    // socket is still used
+    send_test_packet(client->connection, 0);
+    raw_client_drain(client);
+    CHECK_EQUAL(1, client->num_packets_received);
+
+    raw_client_setup_shared_memory(client, F_SEAL_SHRINK | F_SEAL_GROW);
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, client->shm_setup_status);
+}
+
+TEST(SocketConnection, SharedMemoryExchangesPackets){
+    socket_connection_set_output_queue(TEST_OUTPUT_QUEUE_SIZE, SOCKET_CONNECTION_OVERFLOW_DROP);
+    raw_client_t * client = raw_client_connect();
+    raw_client_setup_shared_memory(client, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL);
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, client->shm_setup_status);
+
+    uint32_t i;
+    for (i = 0; i < 10; i++){
+        send_test_packet(client->connection, i);
+        raw_client_drain(client);
+    }
+    CHECK_EQUAL(10, client->num_packets_received);
+    CHECK(!client->out_of_order);
+
+    raw_client_send(client, HCI_COMMAND_DATA_PACKET);
+    run_loop_for_ms(1);
+    CHECK_EQUAL(1, num_packets_from_clients);
+
+    // nothing was sent over socket after setup complete
+    uint8_t data;
+    CHECK_EQUAL(-1, (int) read(client->fd, &data, 1));
+    CHECK_EQUAL(EAGAIN, errno);
+}
+
+TEST(SocketConnection, SharedMemoryFullRingDoesNotBlock){
+    socket_connection_set_output_queue(TEST_OUTPUT_QUEUE_SIZE, SOCKET_CONNECTION_OVERFLOW_DROP);
+    raw_client_t * client = raw_client_connect();
+    raw_client_setup_shared_memory(client, F_SEAL_SHRINK | F_SEAL_GROW);
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, client->shm_setup_status);
+
+    // fill ring and output queue, client does not consume
+    uint32_t start_ms = btstack_run_loop_get_time_ms();
+    uint32_t i;
+    for (i = 0; i < TEST_NUM_PACKETS; i++){
+        send_test_packet(client->connection, i);
+    }
+    CHECK(btstack_time_delta(btstack_run_loop_get_time_ms(), start_ms) < 1000);
+
+    // queued data is sent when client consumed ring
+    raw_client_drain(client);
+    CHECK(client->num_packets_received > (SHM_RING_SIZE / (PACKET_HEADER_SIZE + TEST_PAYLOAD_SIZE)));
+    CHECK(client->num_packets_received < TEST_NUM_PACKETS);
+    CHECK(!client->out_of_order);
+
+    send_test_packet(client->connection, TEST_NUM_PACKETS);
+    raw_client_drain(client);
+    CHECK_EQUAL(TEST_NUM_PACKETS, client->last_sequence_nr);
+    CHECK_EQUAL(0, num_connections_closed);
+}
+
+TEST(SocketConnection, SharedMemoryBackpressurePausesInput){
+    socket_connection_set_output_queue(TEST_OUTPUT_QUEUE_SIZE, SOCKET_CONNECTION_OVERFLOW_BACKPRESSURE);
+    raw_client_t * client = raw_client_connect();
+    raw_client_setup_shared_memory(client, F_SEAL_SHRINK | F_SEAL_GROW);
+    CHECK_EQUAL(ERROR_CODE_SUCCESS, client->shm_setup_status);
+
+    uint32_t i;
+    for (i = 0; i < TEST_NUM_PACKETS; i++){
+        send_test_packet(client->connection, i);
+    }
+
+    // client does not consume, its commands are not processed
+    raw_client_send(client, HCI_COMMAND_DATA_PACKET);
+    run_loop_for_ms(10);
+    CHECK_EQUAL(0, num_packets_from_clients);
+
+    // client catches up, input is resumed
+    raw_client_drain(client);
+    CHECK(!client->out_of_order);
+    CHECK_EQUAL(1, num_packets_from_clients);
+}
+
+int main (int argc, const char * argv[]){
+    btstack_run_loop_init(btstack_run_loop_posix_get_instance());
+    socket_connection_init();
+    socket_connection_register_packet_callback(&packet_callback);
+    if (socket_connection_create_unix((char *) BTSTACK_UNIX) != 0){
+        printf("Failed to create unix socket at %s\n", BTSTACK_UNIX);
+        return 1;
+    }
+    int result = CommandLineTestRunner::RunAllTests(argc, argv);
+    unlink(BTSTACK_UNIX);
+    return result;
+}
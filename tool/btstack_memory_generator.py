@@ -95,6 +95,11 @@ extern "C" {
  */
 void btstack_memory_init(void);
 
+/**
+ * @brief Frees slab arenas and reports objects that have not been freed, see ENABLE_BTSTACK_MEMORY_SLAB
+ */
+void btstack_memory_deinit(void);
+
 /* API_END */
 """
 
@@ -122,9 +127,15 @@ cfile_header_begin = """
 
 #include "btstack_memory.h"
 #include "btstack_memory_pool.h"
+#include "btstack_memory_slab.h"
 
 #include <stdlib.h>
 
+// with ENABLE_BTSTACK_MEMORY_SLAB, types without MAX_NR_* use growable slabs instead of malloc per object
+#if defined(HAVE_MALLOC) && defined(ENABLE_BTSTACK_MEMORY_SLAB)
+#define BTSTACK_MEMORY_USE_SLAB
+#endif
+
 """
 
 header_template = """STRUCT_NAME_t * btstack_memory_STRUCT_NAME_get(void);
@@ -163,6 +174,14 @@ void btstack_memory_STRUCT_NAME_free(STRUCT_NAME_t *STRUCT_NAME){
     (void) STRUCT_NAME;
 };
 #endif
+#elif defined(BTSTACK_MEMORY_USE_SLAB)
+static btstack_memory_slab_t STRUCT_NAME_slab;
+STRUCT_NAME_t * btstack_memory_STRUCT_NAME_get(void){
+    return (STRUCT_NAME_t *) btstack_memory_slab_get(&STRUCT_NAME_slab);
+}
+void btstack_memory_STRUCT_NAME_free(STRUCT_NAME_t *STRUCT_NAME){
+    btstack_memory_slab_free(&STRUCT_NAME_slab, STRUCT_NAME);
+}
 #elif defined(HAVE_MALLOC)
 STRUCT_NAME_t * btstack_memory_STRUCT_NAME_get(void){
     void * buffer = malloc(sizeof(STRUCT_TYPE));
@@ -179,6 +198,12 @@ void btstack_memory_STRUCT_NAME_free(STRUCT_NAME_t *STRUCT_NAME){
 
 init_template = """#if POOL_COUNT > 0
     btstack_memory_pool_create(&STRUCT_NAME_pool, STRUCT_NAME_storage, POOL_COUNT, sizeof(STRUCT_TYPE));
+#elif !defined(POOL_COUNT) && defined(BTSTACK_MEMORY_USE_SLAB)
+    btstack_memory_slab_create(&STRUCT_NAME_slab, "STRUCT_TYPE", sizeof(STRUCT_TYPE));
+#endif"""
+
+deinit_template = """#if !defined(POOL_COUNT) && defined(BTSTACK_MEMORY_USE_SLAB)
+    btstack_memory_slab_deinit(&STRUCT_NAME_slab);
 #endif"""
 
 def writeln(f, data):
@@ -299,5 +324,28 @@ for struct_names in list_of_mesh_structs:
         writeln(f, replacePlaceholder(init_template, struct_name))
 writeln(f, "#endif")
 writeln(f, "}")
+
+writeln(f, "")
+writeln(f, "// deinit")
+writeln(f, "void btstack_memory_deinit(void){")
+for struct_names in list_of_structs:
+    for struct_name in struct_names:
+        writeln(f, replacePlaceholder(deinit_template, struct_name))
+writeln(f, "#ifdef ENABLE_CLASSIC")
+for struct_names in list_of_classic_structs:
+    for struct_name in struct_names:
+        writeln(f, replacePlaceholder(deinit_template, struct_name))
+writeln(f, "#endif")
+writeln(f, "#ifdef ENABLE_BLE")
+for struct_names in list_of_le_structs:
+    for struct_name in struct_names:
+        writeln(f, replacePlaceholder(deinit_template, struct_name))
+writeln(f, "#endif")
+writeln(f, "#ifdef ENABLE_MESH")
+for struct_names in list_of_mesh_structs:
+    for struct_name in struct_names:
+        writeln(f, replacePlaceholder(deinit_template, struct_name))
+writeln(f, "#endif")
+writeln(f, "}")
 f.close();
     